@@ -0,0 +1,857 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+#include <cutil/AsyncFileIO.h>
+#include <cutil/Closure.h>
+#include <cutil/Condition.h>
+#include <cutil/Mutex.h>
+#include <cutil/ThreadPool.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/poll.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#endif
+
+using cutil::AbstractClosure ;
+using cutil::AsyncFileIO ;
+using cutil::Condition ;
+using cutil::Exception ;
+using cutil::FilePath ;
+using cutil::Mutex ;
+using cutil::MutexLock ;
+using cutil::ThreadPool ;
+
+
+//-------------------------------------------------------------------------------//
+// Private Implementation
+
+/**
+ * A submitted request and its eventual result
+ *
+ */
+struct AsyncFileIO::Operation
+{
+	/** the request and its result */
+	Completion theCompletion ;
+
+	/** the opened file */
+	int theFd ;
+
+	/** the data region of the request */
+	struct iovec theIovec ;
+} ;
+
+/**
+ * The mechanism performing submitted operations
+ *
+ */
+class AsyncFileIO::Engine
+{
+	public:
+		virtual ~Engine() {}
+
+		/**
+		 * Starts the specified operation, or queues it to be started by the next flush
+		 *
+		 * @param op the operation to start
+		 * @throw Exception if the operation cannot be started
+		 */
+		virtual void submit(Operation* op) throw(Exception) = 0 ;
+
+		/**
+		 * Starts all queued operations
+		 *
+		 * @throw Exception if the operations cannot be started
+		 */
+		virtual void flush() throw(Exception) {}
+
+		/**
+		 * Waits for operations to complete, appending each to completed
+		 *
+		 * @param completed queue of completed operations
+		 * @param min_completions the minimum number of operations to wait for
+		 * @param usec the maximum time to wait in micro seconds, a negative value waits indefinitely
+		 * @return the number of operations appended
+		 * @throw Exception if an error occurs waiting for completions
+		 */
+		virtual size_t wait(std::deque<Operation*>& completed, size_t min_completions, long usec) throw(Exception) = 0 ;
+} ;
+
+namespace
+{
+	/**
+	 * Returns the remaining time until the deadline in milliseconds, at least 0
+	 *
+	 */
+	int
+	remainingMillis(const struct timespec& deadline)
+	{
+		struct timespec now ;
+		::clock_gettime(CLOCK_MONOTONIC, &now) ;
+
+		long remaining = (deadline.tv_sec - now.tv_sec) * 1000 + (deadline.tv_nsec - now.tv_nsec) / 1000000 ;
+		return(remaining > 0 ? static_cast<int>(remaining) : 0) ;
+	}
+
+	/**
+	 * Returns the monotonic time usec micro seconds from now
+	 *
+	 */
+	struct timespec
+	makeDeadline(long usec)
+	{
+		struct timespec deadline ;
+		::clock_gettime(CLOCK_MONOTONIC, &deadline) ;
+		if(usec > 0)
+		{
+			deadline.tv_sec += usec / 1000000 ;
+			deadline.tv_nsec += (usec % 1000000) * 1000 ;
+			if(deadline.tv_nsec >= 1000000000)
+			{
+				deadline.tv_sec++ ;
+				deadline.tv_nsec -= 1000000000 ;
+			}
+		}
+
+		return(deadline) ;
+	}
+}
+
+/**
+ * Engine performing each operation as a blocking call upon a pool of worker threads
+ *
+ */
+class AsyncFileIO::ThreadPoolEngine : public AsyncFileIO::Engine
+{
+	public:
+		/**
+		 * Creates a new ThreadPoolEngine with a worker for each operation which may be in flight
+		 *
+		 */
+		ThreadPoolEngine(size_t max_in_flight) throw(Exception) : thePool(max_in_flight) {}
+
+		virtual ~ThreadPoolEngine()
+		{
+			thePool.shutdown() ;
+		}
+
+		virtual void submit(Operation* op) throw(Exception)
+		{
+			thePool.execute(new Task(this, op)) ;
+		}
+
+		virtual size_t wait(std::deque<Operation*>& completed, size_t min_completions, long usec) throw(Exception)
+		{
+			MutexLock lock(theMutex) ;
+
+			if(usec < 0)
+			{
+				while(theCompleted.size() < min_completions)
+				{
+					theCondition.wait(theMutex) ;
+				}
+			}
+			else
+			{
+				struct timespec deadline = makeDeadline(usec) ;
+				while(theCompleted.size() < min_completions)
+				{
+					int remaining = remainingMillis(deadline) ;
+					if(remaining <= 0 || !theCondition.timedWait(theMutex, remaining * 1000L))
+					{
+						break ;
+					}
+				}
+			}
+
+			size_t count = theCompleted.size() ;
+			completed.insert(completed.end(), theCompleted.begin(), theCompleted.end()) ;
+			theCompleted.clear() ;
+
+			return(count) ;
+		}
+
+	private:
+		/**
+		 * Task performing a single operation upon a worker thread
+		 *
+		 */
+		class Task : public AbstractClosure<void>
+		{
+			public:
+				Task(ThreadPoolEngine* engine, Operation* op) : theEngine(engine), theOperation(op) {}
+
+				virtual void operator() () const
+				{
+					Completion& c = theOperation->theCompletion ;
+
+					ssize_t ret ;
+					do
+					{
+						if(c.theOperation == READ_ENUM)
+						{
+							ret = ::pread(theOperation->theFd, c.theBuffer, c.theLength, c.theOffset) ;
+						}
+						else
+						{
+							ret = ::pwrite(theOperation->theFd, theOperation->theIovec.iov_base, c.theLength, c.theOffset) ;
+						}
+					}
+					while(ret < 0 && errno == EINTR) ;
+
+					c.theResult = ret ;
+					c.theError = ret < 0 ? errno : 0 ;
+
+					MutexLock lock(theEngine->theMutex) ;
+					theEngine->theCompleted.push_back(theOperation) ;
+					theEngine->theCondition.signal() ;
+				}
+
+			private:
+				ThreadPoolEngine* theEngine ;
+				Operation* theOperation ;
+		} ;
+
+		/** the worker threads */
+		ThreadPool thePool ;
+
+		/** protects the completed queue */
+		Mutex theMutex ;
+
+		/** signalled as each operation completes */
+		Condition theCondition ;
+
+		/** operations completed by the workers */
+		std::deque<Operation*> theCompleted ;
+} ;
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+
+/**
+ * Engine submitting operations to the kernel through an io_uring instance.
+ * The rings are driven directly through the io_uring system calls.
+ *
+ */
+class AsyncFileIO::UringEngine : public AsyncFileIO::Engine
+{
+	public:
+		/**
+		 * Creates a new io_uring instance able to hold max_in_flight operations
+		 *
+		 * @throw Exception if io_uring is unavailable
+		 */
+		UringEngine(size_t max_in_flight) throw(Exception)
+		{
+			theFd = -1 ;
+			theSqRing = MAP_FAILED ;
+			theCqRing = MAP_FAILED ;
+			theSqes = MAP_FAILED ;
+			theSqPending = 0 ;
+
+			struct io_uring_params params ;
+			::memset(&params, 0, sizeof(params)) ;
+
+			theFd = ::syscall(__NR_io_uring_setup, static_cast<unsigned>(max_in_flight), &params) ;
+			if(theFd < 0)
+			{
+				throw(Exception(std::string("Exception in UringEngine [io_uring_setup]:").append(::strerror(errno)))) ;
+			}
+
+			theSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned) ;
+			theCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe) ;
+			theSingleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0 ;
+			if(theSingleMap && theCqRingSize > theSqRingSize)
+			{
+				theSqRingSize = theCqRingSize ;
+			}
+			theSqesSize = params.sq_entries * sizeof(struct io_uring_sqe) ;
+
+			theSqRing = ::mmap(0, theSqRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, theFd, IORING_OFF_SQ_RING) ;
+			if(theSqRing != MAP_FAILED)
+			{
+				theCqRing = theSingleMap ? theSqRing : ::mmap(0, theCqRingSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, theFd, IORING_OFF_CQ_RING) ;
+			}
+			if(theCqRing != MAP_FAILED)
+			{
+				theSqes = ::mmap(0, theSqesSize, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, theFd, IORING_OFF_SQES) ;
+			}
+			if(theSqes == MAP_FAILED)
+			{
+				int err = errno ;
+				release() ;
+				throw(Exception(std::string("Exception in UringEngine [mmap]:").append(::strerror(err)))) ;
+			}
+
+			char* sq = static_cast<char*>(theSqRing) ;
+			theSqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail) ;
+			theSqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask) ;
+			theSqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array) ;
+
+			char* cq = static_cast<char*>(theCqRing) ;
+			theCqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head) ;
+			theCqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail) ;
+			theCqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask) ;
+			theCqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes) ;
+		}
+
+		virtual ~UringEngine()
+		{
+			release() ;
+		}
+
+		virtual void submit(Operation* op) throw(Exception)
+		{
+			// the owning AsyncFileIO is the only producer, and bounds the operations in flight
+			// to the ring size, so a free entry is always available
+			unsigned tail = *theSqTail ;
+			unsigned index = tail & theSqMask ;
+
+			struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(theSqes) + index ;
+			::memset(sqe, 0, sizeof(*sqe)) ;
+			sqe->opcode = op->theCompletion.theOperation == READ_ENUM ? IORING_OP_READV : IORING_OP_WRITEV ;
+			sqe->fd = op->theFd ;
+			sqe->off = op->theCompletion.theOffset ;
+			sqe->addr = reinterpret_cast<unsigned long>(&op->theIovec) ;
+			sqe->len = 1 ;
+			sqe->user_data = reinterpret_cast<unsigned long>(op) ;
+
+			// queued only, the kernel is entered once for the batch by flush or wait
+			theSqArray[index] = index ;
+			__atomic_store_n(theSqTail, tail + 1, __ATOMIC_RELEASE) ;
+			theSqPending++ ;
+		}
+
+		virtual void flush() throw(Exception)
+		{
+			while(theSqPending > 0)
+			{
+				int ret = ::syscall(__NR_io_uring_enter, theFd, theSqPending, 0, 0, 0, 0) ;
+				if(ret < 0)
+				{
+					if(errno == EINTR)
+					{
+						continue ;
+					}
+					throw(Exception(std::string("Exception in flush [io_uring_enter]:").append(::strerror(errno)))) ;
+				}
+				if(ret == 0)
+				{
+					throw(Exception("Exception in flush [io_uring_enter]: no entries consumed")) ;
+				}
+
+				theSqPending -= ret ;
+			}
+		}
+
+		virtual size_t wait(std::deque<Operation*>& completed, size_t min_completions, long usec) throw(Exception)
+		{
+			size_t count = harvest(completed) ;
+			struct timespec deadline = makeDeadline(usec) ;
+
+			// a blocking wait submits the queued operations within the same system call
+			if(usec >= 0 || count >= min_completions)
+			{
+				flush() ;
+			}
+
+			while(count < min_completions)
+			{
+				if(usec < 0)
+				{
+					int ret = ::syscall(__NR_io_uring_enter, theFd, theSqPending, static_cast<unsigned>(min_completions - count), IORING_ENTER_GETEVENTS, 0, 0) ;
+					if(ret < 0 && errno != EINTR)
+					{
+						throw(Exception(std::string("Exception in wait [io_uring_enter]:").append(::strerror(errno)))) ;
+					}
+					if(ret > 0)
+					{
+						theSqPending -= ret ;
+					}
+				}
+				else
+				{
+					int remaining = remainingMillis(deadline) ;
+					if(remaining <= 0)
+					{
+						break ;
+					}
+
+					// the ring descriptor polls readable while completions are pending
+					::pollfd pfd[1] ;
+					pfd[0].fd = theFd ;
+					pfd[0].events = POLLIN ;
+
+					int ret = ::poll(pfd, 1, remaining) ;
+					if(ret < 0 && errno != EINTR)
+					{
+						throw(Exception(std::string("Exception in wait [poll]:").append(::strerror(errno)))) ;
+					}
+				}
+
+				count += harvest(completed) ;
+			}
+
+			return(count) ;
+		}
+
+	private:
+		/**
+		 * Moves all available completion entries to completed
+		 *
+		 */
+		size_t harvest(std::deque<Operation*>& completed)
+		{
+			size_t count = 0 ;
+
+			unsigned head = *theCqHead ;
+			unsigned tail = __atomic_load_n(theCqTail, __ATOMIC_ACQUIRE) ;
+
+			while(head != tail)
+			{
+				struct io_uring_cqe* cqe = theCqes + (head & theCqMask) ;
+
+				Operation* op = reinterpret_cast<Operation*>(cqe->user_data) ;
+				op->theCompletion.theResult = cqe->res < 0 ? -1 : cqe->res ;
+				op->theCompletion.theError = cqe->res < 0 ? -cqe->res : 0 ;
+
+				completed.push_back(op) ;
+				count++ ;
+				head++ ;
+			}
+
+			__atomic_store_n(theCqHead, head, __ATOMIC_RELEASE) ;
+
+			return(count) ;
+		}
+
+		/**
+		 * Unmaps the rings and closes the ring descriptor
+		 *
+		 */
+		void release()
+		{
+			if(theSqes != MAP_FAILED)
+			{
+				::munmap(theSqes, theSqesSize) ;
+			}
+			if(theCqRing != MAP_FAILED && !theSingleMap)
+			{
+				::munmap(theCqRing, theCqRingSize) ;
+			}
+			if(theSqRing != MAP_FAILED)
+			{
+				::munmap(theSqRing, theSqRingSize) ;
+			}
+			if(theFd >= 0)
+			{
+				::close(theFd) ;
+			}
+
+			theFd = -1 ;
+			theSqRing = theCqRing = theSqes = MAP_FAILED ;
+		}
+
+		int theFd ;
+		bool theSingleMap ;
+
+		void* theSqRing ;
+		size_t theSqRingSize ;
+		void* theCqRing ;
+		size_t theCqRingSize ;
+		void* theSqes ;
+		size_t theSqesSize ;
+
+		unsigned* theSqTail ;
+		unsigned theSqMask ;
+		unsigned* theSqArray ;
+
+		/** entries queued in the submission ring, not yet passed to the kernel */
+		unsigned theSqPending ;
+
+		unsigned* theCqHead ;
+		unsigned* theCqTail ;
+		unsigned theCqMask ;
+		struct io_uring_cqe* theCqes ;
+} ;
+
+#endif /* HAVE_LINUX_IO_URING_H */
+
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates a new AsyncFileIO
+ *
+ * @param max_in_flight the maximum number of requests in flight
+ * @param buffer_size the size of each pooled buffer, requests larger than this use a dedicated buffer
+ * @param backend the mechanism used to perform the I/O
+ * @throw Exception if the requested backend cannot be initialised
+ */
+AsyncFileIO::AsyncFileIO(size_t max_in_flight, size_t buffer_size, BackendEnum backend) throw(Exception) : theBufferPool(buffer_size)
+{
+	theEngine = 0 ;
+	theMaxInFlight = max_in_flight ? max_in_flight : 1 ;
+	theInFlight = 0 ;
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(__NR_io_uring_setup)
+	if(backend != BACKEND_THREAD_POOL_ENUM)
+	{
+		try
+		{
+			theEngine = new UringEngine(theMaxInFlight) ;
+			theBackend = BACKEND_URING_ENUM ;
+		}
+		catch(Exception& e)
+		{
+			// io_uring may be disabled, or blocked by a seccomp policy
+			if(backend == BACKEND_URING_ENUM)
+			{
+				throw ;
+			}
+		}
+	}
+#else
+	if(backend == BACKEND_URING_ENUM)
+	{
+		throw(Exception("io_uring support is not available")) ;
+	}
+#endif
+
+	if(!theEngine)
+	{
+		theEngine = new ThreadPoolEngine(theMaxInFlight) ;
+		theBackend = BACKEND_THREAD_POOL_ENUM ;
+	}
+}
+
+/**
+ * Destructor.
+ * Waits for all requests in flight to complete, completions not reaped are discarded
+ *
+ */
+AsyncFileIO::~AsyncFileIO()
+{
+	try
+	{
+		collect(theInFlight, -1) ;
+	}
+	catch(Exception& e)
+	{
+		// @note [todo] need to log this!
+	}
+
+	for(std::deque<Operation*>::iterator iter = theCompleted.begin(); iter != theCompleted.end(); ++iter)
+	{
+		theBufferPool.release((*iter)->theCompletion.theBuffer) ;
+		delete *iter ;
+	}
+
+	delete theEngine ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// AsyncFileIO Operations
+
+/**
+ * Submits a request to read length bytes from the specified file at offset.
+ * A file which cannot be opened results in a failed Completion rather than an Exception.
+ *
+ * @param path the file to read
+ * @param offset the file offset to read from
+ * @param length the number of bytes to read
+ * @param user_data caller data returned in the Completion
+ * @throw Exception if the request cannot be submitted
+ */
+void
+AsyncFileIO::submitRead(const FilePath& path, off_t offset, size_t length, void* user_data) throw(Exception)
+{
+	Operation* op = new Operation() ;
+	op->theCompletion.theOperation = READ_ENUM ;
+	op->theCompletion.thePath = path.getPath() ;
+	op->theCompletion.theOffset = offset ;
+	op->theCompletion.theLength = length ;
+	op->theCompletion.theResult = 0 ;
+	op->theCompletion.theError = 0 ;
+	op->theCompletion.theUserData = user_data ;
+	op->theFd = -1 ;
+
+	try
+	{
+		op->theCompletion.theBuffer = theBufferPool.acquire(length) ;
+	}
+	catch(Exception& e)
+	{
+		delete op ;
+		throw ;
+	}
+
+	op->theIovec.iov_base = op->theCompletion.theBuffer ;
+	op->theIovec.iov_len = length ;
+
+	submit(op, O_RDONLY) ;
+}
+
+/**
+ * Submits a request to write length bytes of data to the specified file at offset.
+ * The file is created if it does not exist. The data is copied, and may be reused once this
+ * method returns. A file which cannot be opened results in a failed Completion rather than an Exception.
+ *
+ * @param path the file to write
+ * @param offset the file offset to write at
+ * @param data the data to write
+ * @param length the number of bytes to write
+ * @param user_data caller data returned in the Completion
+ * @throw Exception if the request cannot be submitted
+ */
+void
+AsyncFileIO::submitWrite(const FilePath& path, off_t offset, const void* data, size_t length, void* user_data) throw(Exception)
+{
+	Operation* op = new Operation() ;
+	op->theCompletion.theOperation = WRITE_ENUM ;
+	op->theCompletion.thePath = path.getPath() ;
+	op->theCompletion.theOffset = offset ;
+	op->theCompletion.theLength = length ;
+	op->theCompletion.theBuffer = 0 ;
+	op->theCompletion.theResult = 0 ;
+	op->theCompletion.theError = 0 ;
+	op->theCompletion.theUserData = user_data ;
+	op->theFd = -1 ;
+
+	char* buffer ;
+	try
+	{
+		buffer = theBufferPool.acquire(length) ;
+	}
+	catch(Exception& e)
+	{
+		delete op ;
+		throw ;
+	}
+
+	::memcpy(buffer, data, length) ;
+	op->theIovec.iov_base = buffer ;
+	op->theIovec.iov_len = length ;
+
+	submit(op, O_WRONLY|O_CREAT) ;
+}
+
+/**
+ * Starts all submitted requests not yet started.
+ * With io_uring, submitted requests are queued, and passed to the kernel together by a single
+ * system call when flush or reap is called, or the bound on requests in flight is reached.
+ * flush need only be called to start queued requests before the next reap.
+ *
+ * @throw Exception if the requests cannot be started
+ */
+void
+AsyncFileIO::flush() throw(Exception)
+{
+	theEngine->flush() ;
+}
+
+/**
+ * Collects completed requests, appending them to completions.
+ * Submitted requests not yet started are started first.
+ * Waits until at least min_completions requests have completed, or usec micro seconds have
+ * elapsed. min_completions is limited to the number of outstanding requests.
+ *
+ * @param completions vector to append completed requests to
+ * @param min_completions the minimum number of completions to wait for
+ * @param usec the maximum time to wait in micro seconds, a negative value waits indefinitely
+ * @return the number of completions appended
+ * @throw Exception if an error occurs waiting for completions
+ */
+size_t
+AsyncFileIO::reap(std::vector<Completion>& completions, size_t min_completions, long usec) throw(Exception)
+{
+	if(min_completions > theCompleted.size())
+	{
+		size_t outstanding = theCompleted.size() + theInFlight ;
+		collect((min_completions < outstanding ? min_completions : outstanding) - theCompleted.size(), usec) ;
+	}
+	else if(theInFlight > 0)
+	{
+		// pick up anything already complete without waiting
+		collect(0, 0) ;
+	}
+
+	size_t count = theCompleted.size() ;
+	for(std::deque<Operation*>::iterator iter = theCompleted.begin(); iter != theCompleted.end(); ++iter)
+	{
+		completions.push_back((*iter)->theCompletion) ;
+		delete *iter ;
+	}
+	theCompleted.clear() ;
+
+	return(count) ;
+}
+
+/**
+ * Returns a read buffer from a Completion to the buffer pool
+ *
+ * @param buffer the buffer to return
+ */
+void
+AsyncFileIO::releaseBuffer(char* buffer)
+{
+	theBufferPool.release(buffer) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// General Accessors/Murators
+
+/**
+ * Returns the mechanism in use to perform the I/O, never BACKEND_AUTO_ENUM
+ *
+ * @return the backend in use
+ */
+AsyncFileIO::BackendEnum
+AsyncFileIO::getBackend() const
+{
+	return(theBackend) ;
+}
+
+/**
+ * Returns the number of submitted requests which have not yet been reaped
+ *
+ * @return the number of outstanding requests
+ */
+size_t
+AsyncFileIO::getOutstanding() const
+{
+	return(theInFlight + theCompleted.size()) ;
+}
+
+/**
+ * Returns the maximum number of requests in flight
+ *
+ * @return the maximum number of requests in flight
+ */
+size_t
+AsyncFileIO::getMaxInFlight() const
+{
+	return(theMaxInFlight) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// Private Operations
+
+/**
+ * Opens the file of the specified operation and submits it, waiting for an in flight request
+ * to complete if the bound is reached
+ *
+ * @param op the operation to submit
+ * @param flags the open flags of the file
+ * @throw Exception if the operation cannot be submitted
+ */
+void
+AsyncFileIO::submit(Operation* op, int flags) throw(Exception)
+{
+	op->theFd = ::open(op->theCompletion.thePath.c_str(), flags|O_CLOEXEC, 0666) ;
+	if(op->theFd < 0)
+	{
+		// reported through the completion, as any other I/O error
+		op->theCompletion.theResult = -1 ;
+		op->theCompletion.theError = errno ;
+		if(op->theCompletion.theOperation == WRITE_ENUM)
+		{
+			theBufferPool.release(static_cast<char*>(op->theIovec.iov_base)) ;
+		}
+		theCompleted.push_back(op) ;
+
+		return ;
+	}
+
+	if(theInFlight >= theMaxInFlight)
+	{
+		try
+		{
+			collect(1, -1) ;
+		}
+		catch(Exception& e)
+		{
+			::close(op->theFd) ;
+			theBufferPool.release(static_cast<char*>(op->theIovec.iov_base)) ;
+			delete op ;
+			throw ;
+		}
+	}
+
+	try
+	{
+		theEngine->submit(op) ;
+	}
+	catch(Exception& e)
+	{
+		::close(op->theFd) ;
+		theBufferPool.release(static_cast<char*>(op->theIovec.iov_base)) ;
+		delete op ;
+		throw ;
+	}
+
+	theInFlight++ ;
+}
+
+/**
+ * Waits for in flight requests to complete, queuing them for reaping
+ *
+ * @param min_completions the minimum number of requests to wait for
+ * @param usec the maximum time to wait in micro seconds, a negative value waits indefinitely
+ * @throw Exception if an error occurs waiting for completions
+ */
+void
+AsyncFileIO::collect(size_t min_completions, long usec) throw(Exception)
+{
+	size_t first = theCompleted.size() ;
+	size_t count = theEngine->wait(theCompleted, min_completions, usec) ;
+
+	theInFlight -= count ;
+
+	for(size_t i = first; i < theCompleted.size(); i++)
+	{
+		Operation* op = theCompleted[i] ;
+
+		::close(op->theFd) ;
+		op->theFd = -1 ;
+
+		if(op->theCompletion.theOperation == WRITE_ENUM)
+		{
+			theBufferPool.release(static_cast<char*>(op->theIovec.iov_base)) ;
+		}
+	}
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+#include <cutil/BufferPool.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using cutil::BufferPool ;
+using cutil::Exception ;
+using cutil::MutexLock ;
+
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates a new empty BufferPool
+ *
+ * @param buffer_size the size of each pooled buffer
+ * @param alignment the alignment of each buffer, a power of two
+ * @param max_free the maximum number of free buffers retained, 0 for no limit
+ */
+BufferPool::BufferPool(size_t buffer_size, size_t alignment, size_t max_free)
+{
+	theBufferSize = buffer_size ;
+	theAlignment = alignment ;
+	theMaxFree = max_free ;
+}
+
+/**
+ * Destructor.
+ * Frees all free buffers, buffers still acquired must not be used after the BufferPool is destroyed
+ *
+ */
+BufferPool::~BufferPool()
+{
+	for(std::vector<char*>::iterator iter = theFreeBuffers.begin(); iter != theFreeBuffers.end(); ++iter)
+	{
+		::free(*iter) ;
+	}
+}
+
+
+//-------------------------------------------------------------------------------//
+// BufferPool Operations
+
+/**
+ * Acquires a buffer of at least length bytes
+ *
+ * @param length the minimum required buffer length
+ * @return the acquired buffer
+ * @throw Exception if a buffer cannot be allocated
+ */
+char*
+BufferPool::acquire(size_t length) throw(Exception)
+{
+	if(length > theBufferSize)
+	{
+		char* buffer = allocate(length) ;
+
+		MutexLock lock(theMutex) ;
+		theOversizeBuffers.insert(buffer) ;
+
+		return(buffer) ;
+	}
+
+	{
+		MutexLock lock(theMutex) ;
+
+		if(!theFreeBuffers.empty())
+		{
+			char* buffer = theFreeBuffers.back() ;
+			theFreeBuffers.pop_back() ;
+
+			return(buffer) ;
+		}
+	}
+
+	return(allocate(theBufferSize)) ;
+}
+
+/**
+ * Returns a buffer previously acquired from this BufferPool
+ *
+ * @param buffer the buffer to return
+ */
+void
+BufferPool::release(char* buffer)
+{
+	if(buffer)
+	{
+		MutexLock lock(theMutex) ;
+
+		std::set<char*>::iterator iter = theOversizeBuffers.find(buffer) ;
+		if(iter != theOversizeBuffers.end())
+		{
+			theOversizeBuffers.erase(iter) ;
+			::free(buffer) ;
+		}
+		else if(theMaxFree == 0 || theFreeBuffers.size() < theMaxFree)
+		{
+			theFreeBuffers.push_back(buffer) ;
+		}
+		else
+		{
+			::free(buffer) ;
+		}
+	}
+}
+
+/**
+ * Returns the size of each pooled buffer
+ *
+ * @return the size of each pooled buffer
+ */
+size_t
+BufferPool::getBufferSize() const
+{
+	return(theBufferSize) ;
+}
+
+/**
+ * Returns the number of free buffers currently retained by this BufferPool
+ *
+ * @return the number of free buffers
+ */
+size_t
+BufferPool::getFreeCount() const
+{
+	MutexLock lock(theMutex) ;
+	return(theFreeBuffers.size()) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// Private Operations
+
+/**
+ * Allocates a new aligned buffer
+ *
+ * @param length the buffer length
+ * @return the allocated buffer
+ * @throw Exception if the buffer cannot be allocated
+ */
+char*
+BufferPool::allocate(size_t length) throw(Exception)
+{
+	void* buffer = 0 ;
+
+	int err = ::posix_memalign(&buffer, theAlignment, length ? length : 1) ;
+	if(err != 0)
+	{
+		throw(Exception(std::string("Exception in allocate [posix_memalign]:").append(::strerror(err)))) ;
+	}
+
+	return(static_cast<char*>(buffer)) ;
+}
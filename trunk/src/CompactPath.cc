@@ -0,0 +1,934 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#include <cutil/CompactPath.h>
+
+#include <string>
+
+#include <new>
+
+#include <cstdlib>
+#include <cstring>
+
+using cutil::CompactPath ;
+using cutil::FilePath ;
+
+/**
+ * Interned path buffer, the path bytes follow the structure within the same allocation
+ */
+struct CompactPath::Prefix
+{
+	/** number of CompactPath objects sharing this prefix */
+	int theRefCount ;
+
+	/** the length of the path */
+	size_t theLength ;
+
+	/**
+	 * Returns the path bytes of this prefix
+	 *
+	 * @return the path bytes
+	 */
+	const char* getData() const
+	{
+		return(reinterpret_cast<const char*>(this + 1)) ;
+	}
+
+	/**
+	 * Creates a new Prefix, with a single reference, from the concatenation of up to three byte ranges
+	 *
+	 * @return the new Prefix
+	 */
+	static Prefix* create(const char* a, size_t a_len, const char* b, size_t b_len, const char* c, size_t c_len)
+	{
+		Prefix* prefix = static_cast<Prefix*>(::malloc(sizeof(Prefix) + a_len + b_len + c_len + 1)) ;
+		if(prefix == NULL)
+		{
+			throw(std::bad_alloc()) ;
+		}
+
+		char* data = reinterpret_cast<char*>(prefix + 1) ;
+		::memcpy(data, a, a_len) ;
+		::memcpy(data + a_len, b, b_len) ;
+		::memcpy(data + a_len + b_len, c, c_len) ;
+		data[a_len + b_len + c_len] = '\0' ;
+
+		prefix->theRefCount = 1 ;
+		prefix->theLength = a_len + b_len + c_len ;
+		return(prefix) ;
+	}
+
+	/**
+	 * Adds a reference to the specified prefix
+	 */
+	static Prefix* acquire(Prefix* prefix)
+	{
+		if(prefix != NULL)
+		{
+			__sync_add_and_fetch(&prefix->theRefCount, 1) ;
+		}
+		return(prefix) ;
+	}
+
+	/**
+	 * Removes a reference from the specified prefix, freeing it with the last reference
+	 */
+	static void release(Prefix* prefix)
+	{
+		if(prefix != NULL && __sync_sub_and_fetch(&prefix->theRefCount, 1) == 0)
+		{
+			::free(prefix) ;
+		}
+	}
+} ;
+
+namespace
+{
+	/** the path separator */
+	const char SEPARATOR = FilePath::PATH_SEPARATOR ;
+
+	/**
+	 * Returns whether the specified character is whitespace trimmed from paths
+	 */
+	bool isSpace(char c)
+	{
+		return(c == ' ' || c == '\t' || c == '\n' || c == '\r') ;
+	}
+
+	/**
+	 * Copies a path into the specified buffer, trimming whitespace, trailing separators and repeated separators.
+	 * dest must have room for length bytes.
+	 *
+	 * @param src the path to clean
+	 * @param length the length of src
+	 * @param dest the buffer to copy the cleaned path to
+	 * @param relative set true to also remove leading separators, a lone root separator is otherwise kept
+	 * @return the length of the cleaned path
+	 */
+	size_t cleanPath(const char* src, size_t length, char* dest, bool relative)
+	{
+		const char* begin = src ;
+		const char* end = src + length ;
+
+		while(begin < end && isSpace(*begin))
+		{
+			++begin ;
+		}
+		while(end > begin && isSpace(*(end - 1)))
+		{
+			--end ;
+		}
+		if(relative)
+		{
+			while(begin < end && *begin == SEPARATOR)
+			{
+				++begin ;
+			}
+		}
+
+		size_t out = 0 ;
+		for(const char* pos = begin ; pos < end ; ++pos)
+		{
+			if(*pos != SEPARATOR || out == 0 || dest[out - 1] != SEPARATOR)
+			{
+				dest[out++] = *pos ;
+			}
+		}
+
+		while(out > 1 && dest[out - 1] == SEPARATOR)
+		{
+			--out ;
+		}
+
+		return(out) ;
+	}
+
+	/**
+	 * Walks the bytes of a path held as a prefix, an optional separator and a suffix
+	 */
+	class ByteCursor
+	{
+		public:
+			ByteCursor(const char* prefix, size_t prefix_len, bool join, const char* suffix, size_t suffix_len)
+			{
+				theSegments[0] = prefix ;
+				theLengths[0] = prefix_len ;
+				theSegments[1] = &SEPARATOR ;
+				theLengths[1] = join ? 1 : 0 ;
+				theSegments[2] = suffix ;
+				theLengths[2] = suffix_len ;
+				theSegment = 0 ;
+				theOffset = 0 ;
+				advance() ;
+			}
+
+			bool atEnd() const
+			{
+				return(theSegment == 3) ;
+			}
+
+			/**
+			 * Returns the contiguous bytes available at the cursor
+			 */
+			size_t available() const
+			{
+				return(theLengths[theSegment] - theOffset) ;
+			}
+
+			const char* data() const
+			{
+				return(theSegments[theSegment] + theOffset) ;
+			}
+
+			void consume(size_t count)
+			{
+				theOffset += count ;
+				advance() ;
+			}
+
+		private:
+			void advance()
+			{
+				while(theSegment < 3 && theOffset == theLengths[theSegment])
+				{
+					++theSegment ;
+					theOffset = 0 ;
+				}
+			}
+
+			const char* theSegments[3] ;
+			size_t theLengths[3] ;
+			size_t theSegment ;
+			size_t theOffset ;
+	} ;
+}
+
+//-------------------------------------------------------------------------------//
+// Component
+
+/**
+ * Returns whether the component is equal to the specified string
+ *
+ * @param str the string to compare to
+ * @return true if the component and str are equal
+ */
+bool
+CompactPath::Component::equals(const char* str) const
+{
+	return(::strncmp(theData, str, theLength) == 0 && str[theLength] == '\0') ;
+}
+
+/**
+ * Returns a copy of the component as a string
+ *
+ * @return the component as a string
+ */
+std::string
+CompactPath::Component::toString() const
+{
+	return(std::string(theData, theLength)) ;
+}
+
+//-------------------------------------------------------------------------------//
+// ComponentIterator
+
+/**
+ * Creates a new ComponentIterator over the components of the specified path.
+ * The path must remain unmodified for the lifetime of the iterator.
+ *
+ * @param path the path to iterate over
+ */
+CompactPath::ComponentIterator::ComponentIterator(const CompactPath& path)
+{
+	if(path.thePrefix != NULL)
+	{
+		theSegments[0] = path.thePrefix->getData() ;
+		theSegmentEnds[0] = theSegments[0] + path.thePrefix->theLength ;
+	}
+	else
+	{
+		theSegments[0] = theSegmentEnds[0] = path.theData ;
+	}
+	theSegments[1] = path.theData ;
+	theSegmentEnds[1] = path.theData + path.theLength ;
+
+	theSegment = 0 ;
+	thePosition = theSegments[0] ;
+	skipSeparators() ;
+}
+
+/**
+ * Returns whether a further component is available
+ *
+ * @return true if next will return a component
+ */
+bool
+CompactPath::ComponentIterator::hasNext() const
+{
+	return(theSegment < 2) ;
+}
+
+/**
+ * Returns the next component
+ *
+ * @return the next component, an empty component if !hasNext()
+ */
+CompactPath::Component
+CompactPath::ComponentIterator::next()
+{
+	Component component = { thePosition, 0 } ;
+
+	if(theSegment < 2)
+	{
+		const char* end = theSegmentEnds[theSegment] ;
+		const char* pos = thePosition ;
+		while(pos < end && *pos != SEPARATOR)
+		{
+			++pos ;
+		}
+
+		component.theLength = pos - thePosition ;
+		thePosition = pos ;
+		skipSeparators() ;
+	}
+
+	return(component) ;
+}
+
+/**
+ * Skips separators, advancing to the next segment as required
+ */
+void
+CompactPath::ComponentIterator::skipSeparators()
+{
+	while(theSegment < 2)
+	{
+		while(thePosition < theSegmentEnds[theSegment] && *thePosition == SEPARATOR)
+		{
+			++thePosition ;
+		}
+
+		if(thePosition < theSegmentEnds[theSegment])
+		{
+			break ;
+		}
+
+		++theSegment ;
+		if(theSegment < 2)
+		{
+			thePosition = theSegments[theSegment] ;
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates a new empty CompactPath
+ *
+ */
+CompactPath::CompactPath()
+	: thePrefix(NULL), theData(theInline), theLength(0), theCapacity(INLINE_CAPACITY)
+{
+	theInline[0] = '\0' ;
+}
+
+/**
+ * Creates a new CompactPath from the specified path
+ *
+ * @param path the path
+ */
+CompactPath::CompactPath(const char* path)
+	: thePrefix(NULL), theData(theInline), theLength(0), theCapacity(INLINE_CAPACITY)
+{
+	size_t length = ::strlen(path) ;
+	reserve(length) ;
+	theLength = cleanPath(path, length, theData, false) ;
+	theData[theLength] = '\0' ;
+}
+
+/**
+ * Creates a new CompactPath from the specified path
+ *
+ * @param path the path
+ */
+CompactPath::CompactPath(const std::string& path)
+	: thePrefix(NULL), theData(theInline), theLength(0), theCapacity(INLINE_CAPACITY)
+{
+	reserve(path.size()) ;
+	theLength = cleanPath(path.data(), path.size(), theData, false) ;
+	theData[theLength] = '\0' ;
+}
+
+/**
+ * Creates a new CompactPath from the specified FilePath
+ *
+ * @param path the FilePath
+ */
+CompactPath::CompactPath(const FilePath& path)
+	: thePrefix(NULL), theData(theInline), theLength(0), theCapacity(INLINE_CAPACITY)
+{
+	std::string str = path.getPath() ;
+	reserve(str.size()) ;
+	theLength = cleanPath(str.data(), str.size(), theData, false) ;
+	theData[theLength] = '\0' ;
+}
+
+/**
+ * Creates a new CompactPath from the specified parent path and child path.
+ * If parent is interned, the new path shares its buffer and holds only child.
+ *
+ * @param parent the parent directory path
+ * @param child the child path, relative to parent
+ */
+CompactPath::CompactPath(const CompactPath& parent, const char* child)
+	: thePrefix(Prefix::acquire(parent.thePrefix)), theData(theInline), theLength(0), theCapacity(INLINE_CAPACITY)
+{
+	assignSuffix(parent.theData, parent.theLength) ;
+	append(child) ;
+}
+
+/**
+ * Creates a new CompactPath from the specified parent path and child component.
+ * If parent is interned, the new path shares its buffer and holds only child.
+ *
+ * @param parent the parent directory path
+ * @param child the child component
+ */
+CompactPath::CompactPath(const CompactPath& parent, const Component& child)
+	: thePrefix(Prefix::acquire(parent.thePrefix)), theData(theInline), theLength(0), theCapacity(INLINE_CAPACITY)
+{
+	assignSuffix(parent.theData, parent.theLength) ;
+	append(child.theData, child.theLength) ;
+}
+
+/**
+ * Copy constructor.
+ * An interned buffer is shared rather than copied.
+ *
+ * @param path the CompactPath to copy
+ */
+CompactPath::CompactPath(const CompactPath& path)
+	: thePrefix(Prefix::acquire(path.thePrefix)), theData(theInline), theLength(0), theCapacity(INLINE_CAPACITY)
+{
+	assignSuffix(path.theData, path.theLength) ;
+}
+
+/**
+ * Destructor.
+ *
+ */
+CompactPath::~CompactPath()
+{
+	release() ;
+}
+
+/**
+ * Assignment operator.
+ * An interned buffer is shared rather than copied.
+ *
+ * @param path the CompactPath to assign from
+ * @return this CompactPath
+ */
+CompactPath&
+CompactPath::operator=(const CompactPath& path)
+{
+	if(this != &path)
+	{
+		Prefix* prefix = Prefix::acquire(path.thePrefix) ;
+		Prefix::release(thePrefix) ;
+		thePrefix = prefix ;
+
+		assignSuffix(path.theData, path.theLength) ;
+	}
+
+	return(*this) ;
+}
+
+//-------------------------------------------------------------------------------//
+// Path Operations
+
+/**
+ * Appends the specified path to this CompactPath
+ *
+ * @param path the path to append
+ */
+void
+CompactPath::append(const char* path)
+{
+	append(path, ::strlen(path)) ;
+}
+
+/**
+ * Appends the specified path to this CompactPath
+ *
+ * @param path the path to append
+ * @param length the length of path in bytes
+ */
+void
+CompactPath::append(const char* path, size_t length)
+{
+	// a suffix following a prefix is joined to it by needsJoin
+	bool separator = theLength > 0 && theData[theLength - 1] != SEPARATOR ;
+
+	reserve(theLength + 1 + length) ;
+
+	size_t start = theLength + (separator ? 1 : 0) ;
+	size_t added = cleanPath(path, length, theData + start, theLength > 0 || thePrefix != NULL) ;
+	if(added > 0)
+	{
+		if(separator)
+		{
+			theData[theLength] = SEPARATOR ;
+		}
+		theLength = start + added ;
+	}
+	theData[theLength] = '\0' ;
+}
+
+/**
+ * Interns this CompactPath, moving the whole path into a shared, reference counted, buffer.
+ * Subsequent copies of this path, and paths created with this path as their parent, share
+ * the buffer rather than copying it.
+ *
+ */
+void
+CompactPath::intern()
+{
+	if(thePrefix != NULL && theLength == 0)
+	{
+		return ;
+	}
+
+	Prefix* prefix = NULL ;
+	if(thePrefix != NULL)
+	{
+		prefix = Prefix::create(thePrefix->getData(), thePrefix->theLength, &SEPARATOR, needsJoin() ? 1 : 0, theData, theLength) ;
+	}
+	else
+	{
+		prefix = Prefix::create(theData, theLength, NULL, 0, NULL, 0) ;
+	}
+
+	release() ;
+	thePrefix = prefix ;
+	theLength = 0 ;
+	theData[0] = '\0' ;
+}
+
+/**
+ * Returns whether this CompactPath holds an interned prefix
+ *
+ * @return true if this path shares an interned prefix
+ */
+bool
+CompactPath::isInterned() const
+{
+	return(thePrefix != NULL) ;
+}
+
+//-------------------------------------------------------------------------------//
+// Path Accessors
+
+/**
+ * Returns whether this CompactPath is empty
+ *
+ * @return true if this path is empty
+ */
+bool
+CompactPath::isEmpty() const
+{
+	return(getLength() == 0) ;
+}
+
+/**
+ * Returns whether this CompactPath is an absolute path
+ *
+ * @return true if this path begins with a path separator
+ */
+bool
+CompactPath::isAbsolute() const
+{
+	if(thePrefix != NULL && thePrefix->theLength > 0)
+	{
+		return(thePrefix->getData()[0] == SEPARATOR) ;
+	}
+
+	return(theLength > 0 && theData[0] == SEPARATOR) ;
+}
+
+/**
+ * Returns the length of this path in bytes
+ *
+ * @return the length of this path
+ */
+size_t
+CompactPath::getLength() const
+{
+	size_t length = theLength ;
+	if(thePrefix != NULL)
+	{
+		length += thePrefix->theLength + (needsJoin() ? 1 : 0) ;
+	}
+
+	return(length) ;
+}
+
+/**
+ * Returns the number of components of this path
+ *
+ * @return the number of components
+ */
+size_t
+CompactPath::getComponentCount() const
+{
+	size_t count = 0 ;
+
+	ComponentIterator iter(*this) ;
+	while(iter.hasNext())
+	{
+		iter.next() ;
+		++count ;
+	}
+
+	return(count) ;
+}
+
+/**
+ * Returns the leaf, file or directory name, of this path without allocation
+ *
+ * @return the last component of this path, empty if there is none
+ */
+CompactPath::Component
+CompactPath::getLeaf() const
+{
+	const char* data = theData ;
+	size_t length = theLength ;
+	if(length == 0 && thePrefix != NULL)
+	{
+		data = thePrefix->getData() ;
+		length = thePrefix->theLength ;
+	}
+
+	const char* end = data + length ;
+	const char* begin = end ;
+	while(begin > data && *(begin - 1) != SEPARATOR)
+	{
+		--begin ;
+	}
+
+	Component leaf = { begin, static_cast<size_t>(end - begin) } ;
+	return(leaf) ;
+}
+
+/**
+ * Returns the parent of this path.
+ * The parent of a child of an interned path shares the interned buffer.
+ *
+ * @return the parent of this path, empty if this path has a single relative component
+ */
+CompactPath
+CompactPath::getParent() const
+{
+	CompactPath parent ;
+
+	if(theLength == 1 && thePrefix == NULL && theData[0] == SEPARATOR)
+	{
+		// the root has no parent
+	}
+	else if(theLength > 0)
+	{
+		const char* sep = static_cast<const char*>(::memrchr(theData, SEPARATOR, theLength)) ;
+
+		parent.thePrefix = Prefix::acquire(thePrefix) ;
+		if(sep != NULL)
+		{
+			// keep the root separator of an absolute suffix
+			size_t length = sep - theData ;
+			parent.assignSuffix(theData, (length == 0 && thePrefix == NULL) ? 1 : length) ;
+		}
+	}
+	else if(thePrefix != NULL)
+	{
+		const char* data = thePrefix->getData() ;
+		const char* sep = static_cast<const char*>(::memrchr(data, SEPARATOR, thePrefix->theLength)) ;
+		if(sep != NULL && thePrefix->theLength > 1)
+		{
+			size_t length = sep - data ;
+			parent.assignSuffix(data, (length == 0) ? 1 : length) ;
+		}
+	}
+
+	// copy on return
+	return(parent) ;
+}
+
+/**
+ * Returns this path as a string
+ *
+ * @return this path as a string
+ */
+std::string
+CompactPath::getPath() const
+{
+	std::string path ;
+	path.reserve(getLength()) ;
+	appendTo(path) ;
+
+	// copy on return
+	return(path) ;
+}
+
+/**
+ * Appends this path to the specified string
+ *
+ * @param str the string to append to
+ */
+void
+CompactPath::appendTo(std::string& str) const
+{
+	if(thePrefix != NULL)
+	{
+		str.append(thePrefix->getData(), thePrefix->theLength) ;
+		if(needsJoin())
+		{
+			str.append(1, SEPARATOR) ;
+		}
+	}
+	str.append(theData, theLength) ;
+}
+
+/**
+ * Copies this path, null terminated, into the specified buffer.
+ * Nothing is copied if the buffer is too small.
+ *
+ * @param buffer the buffer to copy to
+ * @param size the size of buffer in bytes
+ * @return the length of this path, the path has been copied if less than size
+ */
+size_t
+CompactPath::copyTo(char* buffer, size_t size) const
+{
+	size_t length = getLength() ;
+	if(length < size)
+	{
+		char* pos = buffer ;
+		if(thePrefix != NULL)
+		{
+			::memcpy(pos, thePrefix->getData(), thePrefix->theLength) ;
+			pos += thePrefix->theLength ;
+			if(needsJoin())
+			{
+				*pos++ = SEPARATOR ;
+			}
+		}
+		::memcpy(pos, theData, theLength) ;
+		pos[theLength] = '\0' ;
+	}
+
+	return(length) ;
+}
+
+/**
+ * Returns this path as a FilePath
+ *
+ * @return this path as a FilePath
+ */
+FilePath
+CompactPath::toFilePath() const
+{
+	return(FilePath(getPath())) ;
+}
+
+/**
+ * Returns a hash of this path, equal paths have equal hashes
+ *
+ * @return a hash of this path
+ */
+size_t
+CompactPath::hash() const
+{
+	// FNV-1a over the path bytes
+	size_t hash = static_cast<size_t>(2166136261UL) ;
+
+	ByteCursor cursor(thePrefix ? thePrefix->getData() : NULL, thePrefix ? thePrefix->theLength : 0, needsJoin(), theData, theLength) ;
+	while(!cursor.atEnd())
+	{
+		const char* data = cursor.data() ;
+		size_t count = cursor.available() ;
+		for(size_t i = 0 ; i < count ; ++i)
+		{
+			hash = (hash ^ static_cast<unsigned char>(data[i])) * static_cast<size_t>(16777619UL) ;
+		}
+		cursor.consume(count) ;
+	}
+
+	return(hash) ;
+}
+
+/**
+ * Compares this path to the specified path bytewise
+ *
+ * @param path the path to compare to
+ * @return less than, equal to, or greater than zero as this path orders before, equal to, or after path
+ */
+int
+CompactPath::compare(const CompactPath& path) const
+{
+	ByteCursor lhs(thePrefix ? thePrefix->getData() : NULL, thePrefix ? thePrefix->theLength : 0, needsJoin(), theData, theLength) ;
+	ByteCursor rhs(path.thePrefix ? path.thePrefix->getData() : NULL, path.thePrefix ? path.thePrefix->theLength : 0, path.needsJoin(), path.theData, path.theLength) ;
+
+	while(!lhs.atEnd() && !rhs.atEnd())
+	{
+		size_t count = lhs.available() < rhs.available() ? lhs.available() : rhs.available() ;
+		int result = ::memcmp(lhs.data(), rhs.data(), count) ;
+		if(result != 0)
+		{
+			return(result) ;
+		}
+		lhs.consume(count) ;
+		rhs.consume(count) ;
+	}
+
+	return(lhs.atEnd() ? (rhs.atEnd() ? 0 : -1) : 1) ;
+}
+
+/**
+ * Returns whether this path is equal to the specified path
+ *
+ * @param path the path to compare to
+ * @return true if the paths are equal
+ */
+bool
+CompactPath::operator==(const CompactPath& path) const
+{
+	if(thePrefix == path.thePrefix && theLength == path.theLength)
+	{
+		return(::memcmp(theData, path.theData, theLength) == 0) ;
+	}
+
+	return(getLength() == path.getLength() && compare(path) == 0) ;
+}
+
+/**
+ * Returns whether this path is not equal to the specified path
+ *
+ * @param path the path to compare to
+ * @return true if the paths are not equal
+ */
+bool
+CompactPath::operator!=(const CompactPath& path) const
+{
+	return(!(*this == path)) ;
+}
+
+/**
+ * Returns whether this path orders before the specified path
+ *
+ * @param path the path to compare to
+ * @return true if this path orders before path
+ */
+bool
+CompactPath::operator<(const CompactPath& path) const
+{
+	return(compare(path) < 0) ;
+}
+
+//-------------------------------------------------------------------------------//
+
+/**
+ * Returns whether a separator is required between the prefix and suffix
+ *
+ * @return true if the prefix and suffix are joined with a separator
+ */
+bool
+CompactPath::needsJoin() const
+{
+	return(thePrefix != NULL && theLength > 0 && thePrefix->theLength > 0 && thePrefix->getData()[thePrefix->theLength - 1] != SEPARATOR) ;
+}
+
+/**
+ * Ensures the suffix buffer can hold length bytes plus a terminator
+ *
+ * @param length the required suffix length
+ */
+void
+CompactPath::reserve(size_t length)
+{
+	if(length + 1 > theCapacity)
+	{
+		size_t capacity = theCapacity * 2 ;
+		if(capacity < length + 1)
+		{
+			capacity = length + 1 ;
+		}
+
+		char* data = static_cast<char*>(::malloc(capacity)) ;
+		if(data == NULL)
+		{
+			throw(std::bad_alloc()) ;
+		}
+		::memcpy(data, theData, theLength) ;
+
+		if(theData != theInline)
+		{
+			::free(theData) ;
+		}
+		theData = data ;
+		theCapacity = capacity ;
+	}
+}
+
+/**
+ * Replaces the suffix with the specified bytes
+ *
+ * @param data the new suffix
+ * @param length the length of data
+ */
+void
+CompactPath::assignSuffix(const char* data, size_t length)
+{
+	theLength = 0 ;
+	reserve(length) ;
+	::memmove(theData, data, length) ;
+	theLength = length ;
+	theData[theLength] = '\0' ;
+}
+
+/**
+ * Releases the interned prefix and any heap buffer
+ */
+void
+CompactPath::release()
+{
+	Prefix::release(thePrefix) ;
+	thePrefix = NULL ;
+
+	if(theData != theInline)
+	{
+		::free(theData) ;
+		theData = theInline ;
+		theCapacity = INLINE_CAPACITY ;
+	}
+	theLength = 0 ;
+}
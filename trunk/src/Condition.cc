@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+#include <cutil/Condition.h>
+#include <cutil/Mutex.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+using cutil::Condition ;
+using cutil::Exception ;
+using cutil::Mutex ;
+
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates a new Condition
+ *
+ * @throw Exception if the condition cannot be initialised
+ */
+Condition::Condition() throw(Exception)
+{
+	pthread_condattr_t attr ;
+	::pthread_condattr_init(&attr) ;
+	::pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) ;
+
+	int err = ::pthread_cond_init(&theCondition, &attr) ;
+	::pthread_condattr_destroy(&attr) ;
+
+	if(err != 0)
+	{
+		throw(Exception(std::string("Exception in Condition [pthread_cond_init]:").append(::strerror(err)))) ;
+	}
+}
+
+/**
+ * Destructor.
+ * No thread may be waiting upon the Condition when it is destroyed
+ *
+ */
+Condition::~Condition()
+{
+	::pthread_cond_destroy(&theCondition) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// Condition Operations
+
+/**
+ * Atomically releases the specified locked Mutex and waits for this Condition to be signalled.
+ * The Mutex is locked again before returning. As spurious wake ups may occur, the caller
+ * should recheck its predicate upon return.
+ *
+ * @param mutex the Mutex held by the calling thread
+ */
+void
+Condition::wait(Mutex& mutex)
+{
+	::pthread_cond_wait(&theCondition, &mutex.theMutex) ;
+}
+
+/**
+ * Atomically releases the specified locked Mutex and waits at most usec micro seconds
+ * for this Condition to be signalled. The Mutex is locked again before returning.
+ *
+ * @param mutex the Mutex held by the calling thread
+ * @param usec the maximum time to wait in micro seconds
+ * @return false if the wait timed out, true otherwise
+ */
+bool
+Condition::timedWait(Mutex& mutex, long usec)
+{
+	struct timespec deadline ;
+	::clock_gettime(CLOCK_MONOTONIC, &deadline) ;
+	deadline.tv_sec += usec / 1000000 ;
+	deadline.tv_nsec += (usec % 1000000) * 1000 ;
+	if(deadline.tv_nsec >= 1000000000)
+	{
+		deadline.tv_sec++ ;
+		deadline.tv_nsec -= 1000000000 ;
+	}
+
+	return(::pthread_cond_timedwait(&theCondition, &mutex.theMutex, &deadline) != ETIMEDOUT) ;
+}
+
+/**
+ * Wakes at least one thread waiting upon this Condition
+ *
+ */
+void
+Condition::signal()
+{
+	::pthread_cond_signal(&theCondition) ;
+}
+
+/**
+ * Wakes all threads waiting upon this Condition
+ *
+ */
+void
+Condition::broadcast()
+{
+	::pthread_cond_broadcast(&theCondition) ;
+}
@@ -0,0 +1,811 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+#include <cutil/DirectoryWalker.h>
+#include <cutil/Closure.h>
+#include <cutil/Condition.h>
+#include <cutil/Mutex.h>
+#include <cutil/ThreadPool.h>
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using cutil::AbstractClosure ;
+using cutil::Condition ;
+using cutil::DirectoryWalker ;
+using cutil::Exception ;
+using cutil::FilePath ;
+using cutil::Mutex ;
+using cutil::MutexLock ;
+using cutil::ThreadPool ;
+
+namespace
+{
+	/**
+	 * Directory entry record as returned by getdents64
+	 *
+	 */
+	struct linux_dirent64
+	{
+		ino64_t d_ino ;
+		off64_t d_off ;
+		unsigned short d_reclen ;
+		unsigned char d_type ;
+		char d_name[1] ;
+	} ;
+
+	/** size of the buffer each directory level reads entries into */
+	const size_t DIRENT_BUFFER_SIZE = 32768 ;
+
+	/**
+	 * Converts a d_type value to a FilePath::FileType
+	 *
+	 */
+	FilePath::FileType
+	toFileType(unsigned char d_type)
+	{
+		switch(d_type)
+		{
+			case DT_DIR: return(FilePath::DIRECTORY_ENUM) ;
+			case DT_REG: return(FilePath::REGULAR_FILE_ENUM) ;
+			case DT_FIFO: return(FilePath::FIFO_ENUM) ;
+			case DT_SOCK: return(FilePath::SOCKET_ENUM) ;
+			case DT_LNK: return(FilePath::SYM_LINK_ENUM) ;
+			case DT_CHR: return(FilePath::CHAR_DEV_ENUM) ;
+			case DT_BLK: return(FilePath::BLOCK_DEV_ENUM) ;
+			default: return(FilePath::UNKNOWN_TYPE_ENUM) ;
+		}
+	}
+
+	/**
+	 * Converts a stat mode to a FilePath::FileType
+	 *
+	 */
+	FilePath::FileType
+	toFileType(mode_t mode)
+	{
+		return(toFileType(static_cast<unsigned char>(IFTODT(mode)))) ;
+	}
+
+	/** dev/inode identity of a directory */
+	typedef std::pair<dev_t, ino_t> DirectoryId_t ;
+}
+
+
+/**
+ * Shared state of a traversal fanned out across a ThreadPool
+ *
+ */
+class DirectoryWalker::ParallelWalk
+{
+	public:
+		ParallelWalk(const DirectoryWalker& walker, Visitor& visitor, ThreadPool& pool, dev_t root_dev)
+			: theWalker(walker), theVisitor(visitor), thePool(pool), theRootDev(root_dev)
+		{
+			thePending = 0 ;
+			theStopFlag = false ;
+		}
+
+		/**
+		 * Queues the walk of the subdirectory at path, whose entries are at depth.
+		 * The subdirectory is opened by the task relative to a duplicate of dir_fd, the
+		 * descriptor of its parent, so it is checked exactly as a serial walk checks it.
+		 *
+		 */
+		void dispatch(int dir_fd, const std::string& path, size_t name_offset, size_t depth, const std::vector<DirectoryId_t>& stack) throw(Exception) ;
+
+		/**
+		 * Waits for all dispatched walks to complete
+		 *
+		 * @return false if the traversal was stopped
+		 * @throw Exception if any dispatched walk failed
+		 */
+		bool wait() throw(Exception)
+		{
+			MutexLock lock(theMutex) ;
+			while(thePending > 0)
+			{
+				theCondition.wait(theMutex) ;
+			}
+
+			if(!theError.empty())
+			{
+				throw(Exception(theError)) ;
+			}
+
+			return(!isStopped()) ;
+		}
+
+		bool isStopped() const
+		{
+			return(__atomic_load_n(&theStopFlag, __ATOMIC_RELAXED)) ;
+		}
+
+		void stop()
+		{
+			__atomic_store_n(&theStopFlag, true, __ATOMIC_RELAXED) ;
+		}
+
+		void fail(const std::string& message)
+		{
+			MutexLock lock(theMutex) ;
+			if(theError.empty())
+			{
+				theError = message ;
+			}
+			stop() ;
+		}
+
+		void finished()
+		{
+			MutexLock lock(theMutex) ;
+			if(--thePending == 0)
+			{
+				theCondition.broadcast() ;
+			}
+		}
+
+		const DirectoryWalker& theWalker ;
+		Visitor& theVisitor ;
+		ThreadPool& thePool ;
+		dev_t theRootDev ;
+
+	private:
+		class Task ;
+
+		Mutex theMutex ;
+		Condition theCondition ;
+		size_t thePending ;
+		bool theStopFlag ;
+		std::string theError ;
+} ;
+
+
+/**
+ * A single threaded traversal of a directory tree
+ *
+ */
+class DirectoryWalker::Walk
+{
+	public:
+		Walk(const DirectoryWalker& walker, Visitor& visitor, dev_t root_dev, ParallelWalk* parallel)
+			: theWalker(walker), theVisitor(visitor), theRootDev(root_dev), theParallel(parallel)
+		{}
+
+		/**
+		 * Visits the entries of the open directory dir_fd, whose path is held in thePath
+		 *
+		 * @return false if the traversal was stopped
+		 */
+		bool walkDirectory(int dir_fd, size_t depth) throw(Exception)
+		{
+			if(theBuffers.size() <= depth)
+			{
+				theBuffers.resize(depth + 1) ;
+			}
+			if(theBuffers[depth].empty())
+			{
+				theBuffers[depth].resize(DIRENT_BUFFER_SIZE) ;
+			}
+
+			size_t base = thePath.size() ;
+			if(base > 0 && thePath[base - 1] != FilePath::PATH_SEPARATOR)
+			{
+				thePath.push_back(FilePath::PATH_SEPARATOR) ;
+			}
+			size_t name_offset = thePath.size() ;
+
+			while(true)
+			{
+				char* buf = &theBuffers[depth][0] ;
+
+				long count = ::syscall(SYS_getdents64, dir_fd, buf, DIRENT_BUFFER_SIZE) ;
+				if(count < 0)
+				{
+					if(errno == EINTR)
+					{
+						continue ;
+					}
+					thePath.resize(base) ;
+					throw(Exception(std::string("Exception reading directory [getdents64]:").append(::strerror(errno)))) ;
+				}
+				if(count == 0)
+				{
+					break ;
+				}
+
+				for(long offset = 0; offset < count; )
+				{
+					const linux_dirent64* dirent = reinterpret_cast<const linux_dirent64*>(buf + offset) ;
+					offset += dirent->d_reclen ;
+
+					const char* name = dirent->d_name ;
+					if(name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+					{
+						continue ;
+					}
+					if(name[0] == '.' && !theWalker.theIncludeHiddenFlag)
+					{
+						continue ;
+					}
+
+					if(theParallel && theParallel->isStopped())
+					{
+						thePath.resize(base) ;
+						return(false) ;
+					}
+
+					thePath.resize(name_offset) ;
+					thePath.append(name) ;
+
+					FilePath::FileType type = toFileType(dirent->d_type) ;
+					if(type == FilePath::UNKNOWN_TYPE_ENUM || (type == FilePath::SYM_LINK_ENUM && theWalker.theFollowSymLinksFlag))
+					{
+						// the filesystem does not report types, or the link target type is required
+						struct stat statbuf ;
+						int flags = theWalker.theFollowSymLinksFlag ? 0 : AT_SYMLINK_NOFOLLOW ;
+						if(::fstatat(dir_fd, name, &statbuf, flags) == 0)
+						{
+							type = toFileType(statbuf.st_mode) ;
+						}
+					}
+
+					Entry entry ;
+					entry.thePath = thePath.c_str() ;
+					entry.thePathLength = thePath.size() ;
+					entry.theName = thePath.c_str() + name_offset ;
+					entry.theType = type ;
+					entry.theDepth = depth ;
+					entry.theDirFd = dir_fd ;
+
+					VisitResultEnum result = theVisitor.visit(entry) ;
+					if(result == STOP_ENUM)
+					{
+						if(theParallel)
+						{
+							theParallel->stop() ;
+						}
+						thePath.resize(base) ;
+						return(false) ;
+					}
+
+					if(type != FilePath::DIRECTORY_ENUM || result == PRUNE_ENUM || depth >= theWalker.theMaxDepth)
+					{
+						continue ;
+					}
+
+					if(theParallel && depth < theWalker.theParallelDepth)
+					{
+						theParallel->dispatch(dir_fd, thePath, name_offset, depth + 1, theStack) ;
+						continue ;
+					}
+
+					if(!descend(dir_fd, name_offset, depth))
+					{
+						thePath.resize(base) ;
+						return(false) ;
+					}
+				}
+			}
+
+			thePath.resize(base) ;
+			return(true) ;
+		}
+
+		/**
+		 * Opens the directory whose name starts at name_offset of thePath and walks it
+		 *
+		 * @return false if the traversal was stopped
+		 */
+		bool descend(int dir_fd, size_t name_offset, size_t depth) throw(Exception)
+		{
+			int fd ;
+			bool tracked ;
+			if(!openDirectory(dir_fd, name_offset, fd, tracked))
+			{
+				return(true) ;
+			}
+
+			bool cont ;
+			try
+			{
+				cont = walkDirectory(fd, depth + 1) ;
+			}
+			catch(...)
+			{
+				::close(fd) ;
+				throw ;
+			}
+
+			::close(fd) ;
+			if(tracked)
+			{
+				theStack.pop_back() ;
+			}
+
+			Entry entry ;
+			entry.thePath = thePath.c_str() ;
+			entry.thePathLength = thePath.size() ;
+			entry.theName = thePath.c_str() + name_offset ;
+			entry.theType = FilePath::DIRECTORY_ENUM ;
+			entry.theDepth = depth ;
+			entry.theDirFd = dir_fd ;
+
+			theVisitor.leave(entry) ;
+
+			return(cont) ;
+		}
+
+		/**
+		 * Opens the directory whose name starts at name_offset of thePath, relative to dir_fd.
+		 * A symbolic link is only opened when links are followed, a directory upon another
+		 * filesystem is skipped when the walk remains upon the root filesystem, and when links
+		 * are followed a directory already upon the current path is skipped, otherwise it is
+		 * pushed onto theStack.
+		 *
+		 * @param fd set to the descriptor of the opened directory
+		 * @param tracked set true if the directory was pushed onto theStack
+		 * @return false if the directory is not to be walked
+		 */
+		bool openDirectory(int dir_fd, size_t name_offset, int& fd, bool& tracked) throw(Exception)
+		{
+			int flags = O_RDONLY|O_DIRECTORY|O_CLOEXEC ;
+			if(!theWalker.theFollowSymLinksFlag)
+			{
+				flags |= O_NOFOLLOW ;
+			}
+
+			tracked = false ;
+			fd = ::openat(dir_fd, thePath.c_str() + name_offset, flags) ;
+			if(fd < 0)
+			{
+				// unreadable, or removed or replaced since being listed
+				if(errno == EACCES || errno == ENOENT || errno == ELOOP || errno == ENOTDIR)
+				{
+					return(false) ;
+				}
+				throw(Exception(std::string("Exception opening directory [openat]:").append(::strerror(errno)))) ;
+			}
+
+			if(theWalker.theSameFileSystemFlag || theWalker.theFollowSymLinksFlag)
+			{
+				struct stat statbuf ;
+				if(::fstat(fd, &statbuf) != 0)
+				{
+					int err = errno ;
+					::close(fd) ;
+					throw(Exception(std::string("Exception accessing directory [fstat]:").append(::strerror(err)))) ;
+				}
+
+				if(theWalker.theSameFileSystemFlag && statbuf.st_dev != theRootDev)
+				{
+					::close(fd) ;
+					return(false) ;
+				}
+
+				if(theWalker.theFollowSymLinksFlag)
+				{
+					DirectoryId_t id(statbuf.st_dev, statbuf.st_ino) ;
+					for(std::vector<DirectoryId_t>::const_iterator iter = theStack.begin(); iter != theStack.end(); ++iter)
+					{
+						if(*iter == id)
+						{
+							// a link back to a directory on the current path
+							::close(fd) ;
+							return(false) ;
+						}
+					}
+					theStack.push_back(id) ;
+					tracked = true ;
+				}
+			}
+
+			return(true) ;
+		}
+
+		/** path of the current entry */
+		std::string thePath ;
+
+		/** directories upon the current path, when following symbolic links */
+		std::vector<DirectoryId_t> theStack ;
+
+	private:
+		const DirectoryWalker& theWalker ;
+		Visitor& theVisitor ;
+		dev_t theRootDev ;
+		ParallelWalk* theParallel ;
+
+		/** getdents64 buffer for each directory level, a deque so deeper levels never relocate a buffer in use */
+		std::deque<std::vector<char> > theBuffers ;
+} ;
+
+/**
+ * Task walking a single subdirectory of a parallel traversal
+ *
+ */
+class DirectoryWalker::ParallelWalk::Task : public AbstractClosure<void>
+{
+	public:
+		/**
+		 * Creates a Task walking the subdirectory at path, taking ownership of dir_fd,
+		 * the descriptor of its parent
+		 *
+		 */
+		Task(ParallelWalk* parallel, int dir_fd, const std::string& path, size_t name_offset, size_t depth, const std::vector<DirectoryId_t>& stack)
+			: theParallel(parallel), theDirFd(dir_fd), thePath(path), theNameOffset(name_offset), theDepth(depth), theStack(stack)
+		{}
+
+		virtual ~Task()
+		{
+			::close(theDirFd) ;
+		}
+
+		virtual void operator() () const
+		{
+			try
+			{
+				if(!theParallel->isStopped())
+				{
+					run() ;
+				}
+			}
+			catch(Exception& e)
+			{
+				theParallel->fail(e.toString()) ;
+			}
+			catch(...)
+			{
+				theParallel->fail("Unknown exception walking directory") ;
+			}
+
+			theParallel->finished() ;
+		}
+
+	private:
+		void run() const
+		{
+			Walk walk(theParallel->theWalker, theParallel->theVisitor, theParallel->theRootDev, theParallel) ;
+			walk.thePath = thePath ;
+			walk.theStack = theStack ;
+
+			// opened relative to the parent as descend would, the path may have been replaced since listing
+			int fd ;
+			bool tracked ;
+			if(!walk.openDirectory(theDirFd, theNameOffset, fd, tracked))
+			{
+				return ;
+			}
+
+			try
+			{
+				walk.walkDirectory(fd, theDepth) ;
+			}
+			catch(...)
+			{
+				::close(fd) ;
+				throw ;
+			}
+			::close(fd) ;
+
+			// left even if the walk was stopped within it, as Walk::descend does
+			Entry entry ;
+			entry.thePath = thePath.c_str() ;
+			entry.thePathLength = thePath.size() ;
+			entry.theName = thePath.c_str() + theNameOffset ;
+			entry.theType = FilePath::DIRECTORY_ENUM ;
+			entry.theDepth = theDepth - 1 ;
+			entry.theDirFd = theDirFd ;
+
+			theParallel->theVisitor.leave(entry) ;
+		}
+
+		ParallelWalk* theParallel ;
+		int theDirFd ;
+		std::string thePath ;
+		size_t theNameOffset ;
+		size_t theDepth ;
+		std::vector<DirectoryId_t> theStack ;
+} ;
+
+void
+DirectoryWalker::ParallelWalk::dispatch(int dir_fd, const std::string& path, size_t name_offset, size_t depth, const std::vector<DirectoryId_t>& stack) throw(Exception)
+{
+	// the parent descriptor is closed by the dispatching walk before the task runs
+	int fd = ::fcntl(dir_fd, F_DUPFD_CLOEXEC, 0) ;
+	if(fd < 0)
+	{
+		throw(Exception(std::string("Exception dispatching directory [fcntl]:").append(::strerror(errno)))) ;
+	}
+
+	{
+		MutexLock lock(theMutex) ;
+		thePending++ ;
+	}
+
+	try
+	{
+		thePool.execute(new Task(this, fd, path, name_offset, depth, stack)) ;
+	}
+	catch(Exception& e)
+	{
+		finished() ;
+		throw ;
+	}
+}
+
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates a new DirectoryWalker with default options.
+ * By default, hidden entries are visited, symbolic links are not followed, the depth is
+ * unlimited, and filesystem boundaries are crossed.
+ *
+ */
+DirectoryWalker::DirectoryWalker()
+{
+	theMaxDepth = static_cast<size_t>(-1) ;
+	theIncludeHiddenFlag = true ;
+	theFollowSymLinksFlag = false ;
+	theSameFileSystemFlag = false ;
+	theParallelDepth = 1 ;
+}
+
+/**
+ * Destructor.
+ *
+ */
+DirectoryWalker::~DirectoryWalker()
+{
+	// nothing to do
+}
+
+
+//-------------------------------------------------------------------------------//
+// DirectoryWalker Operations
+
+/**
+ * Walks the directory tree below root, passing each entry to visitor.
+ * Entries are visited in directory order, depth first, within the calling thread.
+ * The root itself is not visited.
+ *
+ * @param root the directory to walk
+ * @param visitor receives each entry
+ * @return false if the visitor stopped the traversal, true otherwise
+ * @throw Exception if root cannot be read, or a system error occurs
+ */
+bool
+DirectoryWalker::walk(const FilePath& root, Visitor& visitor) const throw(Exception)
+{
+	int fd = ::open(root.getPath().c_str(), O_RDONLY|O_DIRECTORY|O_CLOEXEC) ;
+	if(fd < 0)
+	{
+		throw(Exception(std::string("Exception opening directory [open]:").append(::strerror(errno)))) ;
+	}
+
+	struct stat statbuf ;
+	if(::fstat(fd, &statbuf) != 0)
+	{
+		::close(fd) ;
+		throw(Exception(std::string("Exception accessing directory [fstat]:").append(::strerror(errno)))) ;
+	}
+
+	Walk walk(*this, visitor, statbuf.st_dev, 0) ;
+	walk.thePath = root.getPath() ;
+	walk.theStack.push_back(DirectoryId_t(statbuf.st_dev, statbuf.st_ino)) ;
+
+	bool cont ;
+	try
+	{
+		cont = walk.walkDirectory(fd, 0) ;
+	}
+	catch(...)
+	{
+		::close(fd) ;
+		throw ;
+	}
+
+	::close(fd) ;
+	return(cont) ;
+}
+
+/**
+ * Walks the directory tree below root, fanning subdirectories out across pool.
+ * Each subdirectory at a depth less than the parallel depth is walked as a separate task,
+ * deeper subdirectories are walked within the task of their ancestor. The visitor is called
+ * concurrently and must be thread safe. This method returns once the whole tree has been walked.
+ *
+ * @param root the directory to walk
+ * @param visitor receives each entry
+ * @param pool the ThreadPool to walk subdirectories upon, must not be the pool executing the caller
+ * @return false if the visitor stopped the traversal, true otherwise
+ * @throw Exception if root cannot be read, or a system error occurs
+ */
+bool
+DirectoryWalker::walk(const FilePath& root, Visitor& visitor, ThreadPool& pool) const throw(Exception)
+{
+	int fd = ::open(root.getPath().c_str(), O_RDONLY|O_DIRECTORY|O_CLOEXEC) ;
+	if(fd < 0)
+	{
+		throw(Exception(std::string("Exception opening directory [open]:").append(::strerror(errno)))) ;
+	}
+
+	struct stat statbuf ;
+	if(::fstat(fd, &statbuf) != 0)
+	{
+		::close(fd) ;
+		throw(Exception(std::string("Exception accessing directory [fstat]:").append(::strerror(errno)))) ;
+	}
+
+	ParallelWalk parallel(*this, visitor, pool, statbuf.st_dev) ;
+
+	Walk walk(*this, visitor, statbuf.st_dev, &parallel) ;
+	walk.thePath = root.getPath() ;
+	walk.theStack.push_back(DirectoryId_t(statbuf.st_dev, statbuf.st_ino)) ;
+
+	// the root is walked by the calling thread, dispatching its subdirectories
+	try
+	{
+		if(!walk.walkDirectory(fd, 0))
+		{
+			parallel.stop() ;
+		}
+	}
+	catch(Exception& e)
+	{
+		parallel.fail(e.toString()) ;
+	}
+	::close(fd) ;
+
+	// always wait, the dispatched tasks reference the walk state
+	return(parallel.wait()) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// Options
+
+/**
+ * Sets the maximum depth of the traversal, entries deeper than depth are not visited.
+ * A depth of 0 visits only the entries of the root directory.
+ *
+ * @param depth the maximum depth
+ */
+void
+DirectoryWalker::setMaxDepth(size_t depth)
+{
+	theMaxDepth = depth ;
+}
+
+/**
+ * Returns the maximum depth of the traversal
+ *
+ * @return the maximum depth of the traversal
+ */
+size_t
+DirectoryWalker::getMaxDepth() const
+{
+	return(theMaxDepth) ;
+}
+
+/**
+ * Sets whether hidden entries, those beginning with a dot, are visited.
+ * Hidden directories which are not visited are not descended into.
+ *
+ * @param include set true to visit hidden entries
+ */
+void
+DirectoryWalker::setIncludeHidden(bool include)
+{
+	theIncludeHiddenFlag = include ;
+}
+
+/**
+ * Returns whether hidden entries are visited
+ *
+ * @return true if hidden entries are visited
+ */
+bool
+DirectoryWalker::getIncludeHidden() const
+{
+	return(theIncludeHiddenFlag) ;
+}
+
+/**
+ * Sets whether symbolic links are followed.
+ * When followed, an entry reports the type of its target, and links to directories are
+ * descended into. Directories already upon the current path are not entered again.
+ *
+ * @param follow set true to follow symbolic links
+ */
+void
+DirectoryWalker::setFollowSymLinks(bool follow)
+{
+	theFollowSymLinksFlag = follow ;
+}
+
+/**
+ * Returns whether symbolic links are followed
+ *
+ * @return true if symbolic links are followed
+ */
+bool
+DirectoryWalker::getFollowSymLinks() const
+{
+	return(theFollowSymLinksFlag) ;
+}
+
+/**
+ * Sets whether the traversal descends into directories upon a different filesystem to root
+ *
+ * @param same set true to remain upon the filesystem of root
+ */
+void
+DirectoryWalker::setSameFileSystem(bool same)
+{
+	theSameFileSystemFlag = same ;
+}
+
+/**
+ * Returns whether the traversal remains upon the filesystem of root
+ *
+ * @return true if the traversal remains upon the filesystem of root
+ */
+bool
+DirectoryWalker::getSameFileSystem() const
+{
+	return(theSameFileSystemFlag) ;
+}
+
+/**
+ * Sets the depth below which subdirectories are no longer fanned out during a parallel walk
+ *
+ * @param depth the parallel depth, 1 fans out only the subdirectories of root, 0 walks within the calling thread
+ */
+void
+DirectoryWalker::setParallelDepth(size_t depth)
+{
+	theParallelDepth = depth ;
+}
+
+/**
+ * Returns the depth below which subdirectories are no longer fanned out during a parallel walk
+ *
+ * @return the parallel depth
+ */
+size_t
+DirectoryWalker::getParallelDepth() const
+{
+	return(theParallelDepth) ;
+}
@@ -0,0 +1,593 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#include <cutil/DirectoryWatcher.h>
+#include <cutil/DirectoryWalker.h>
+
+#include <string>
+#include <vector>
+
+#include <sys/inotify.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstring>
+
+using cutil::DirectoryWalker ;
+using cutil::DirectoryWatcher ;
+using cutil::Exception ;
+using cutil::FilePath ;
+
+namespace
+{
+	/** inotify events a recursive watch requires to follow new subdirectories */
+	const uint32_t RECURSIVE_MASK = IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM ;
+
+	/**
+	 * Maps or'ed EventTypeEnum values to an inotify mask
+	 */
+	uint32_t toMask(int events)
+	{
+		uint32_t mask = 0 ;
+		if(events & DirectoryWatcher::CREATED_ENUM)
+		{
+			mask |= IN_CREATE ;
+		}
+		if(events & DirectoryWatcher::MODIFIED_ENUM)
+		{
+			mask |= IN_MODIFY | IN_ATTRIB ;
+		}
+		if(events & DirectoryWatcher::WRITTEN_ENUM)
+		{
+			mask |= IN_CLOSE_WRITE ;
+		}
+		if(events & DirectoryWatcher::DELETED_ENUM)
+		{
+			mask |= IN_DELETE ;
+		}
+		if(events & DirectoryWatcher::MOVED_FROM_ENUM)
+		{
+			mask |= IN_MOVED_FROM ;
+		}
+		if(events & DirectoryWatcher::MOVED_TO_ENUM)
+		{
+			mask |= IN_MOVED_TO ;
+		}
+		return(mask) ;
+	}
+
+	/**
+	 * Maps an inotify mask to or'ed EventTypeEnum values
+	 */
+	int fromMask(uint32_t mask)
+	{
+		int events = 0 ;
+		if(mask & IN_CREATE)
+		{
+			events |= DirectoryWatcher::CREATED_ENUM ;
+		}
+		if(mask & (IN_MODIFY | IN_ATTRIB))
+		{
+			events |= DirectoryWatcher::MODIFIED_ENUM ;
+		}
+		if(mask & IN_CLOSE_WRITE)
+		{
+			events |= DirectoryWatcher::WRITTEN_ENUM ;
+		}
+		if(mask & IN_DELETE)
+		{
+			events |= DirectoryWatcher::DELETED_ENUM ;
+		}
+		if(mask & IN_MOVED_FROM)
+		{
+			events |= DirectoryWatcher::MOVED_FROM_ENUM ;
+		}
+		if(mask & IN_MOVED_TO)
+		{
+			events |= DirectoryWatcher::MOVED_TO_ENUM ;
+		}
+		return(events) ;
+	}
+
+	/**
+	 * Returns the monotonic time in microseconds
+	 */
+	long long now()
+	{
+		struct timespec ts ;
+		::clock_gettime(CLOCK_MONOTONIC, &ts) ;
+		return(static_cast<long long>(ts.tv_sec) * 1000000LL + ts.tv_nsec / 1000) ;
+	}
+
+	/**
+	 * Collects the entries found beneath a directory appearing within a recursive watch
+	 */
+	class EntryCollector : public DirectoryWalker::Visitor
+	{
+		public:
+			virtual DirectoryWalker::VisitResultEnum visit(const DirectoryWalker::Entry& entry)
+			{
+				thePaths.push_back(std::string(entry.thePath, entry.thePathLength)) ;
+				theDirectories.push_back(entry.theType == FilePath::DIRECTORY_ENUM) ;
+				return(DirectoryWalker::CONTINUE_ENUM) ;
+			}
+
+			std::vector<std::string> thePaths ;
+			std::vector<bool> theDirectories ;
+	} ;
+}
+
+/**
+ * Collects the events of a batch, coalescing all events of a path into a single Event
+ */
+class DirectoryWatcher::Batch
+{
+	public:
+
+		/**
+		 * Adds events for the specified path, merging them with those already collected for the path
+		 */
+		void add(const std::string& path, int events, bool is_directory, unsigned int cookie)
+		{
+			std::map<std::string, size_t>::iterator iter = theIndex.find(path) ;
+			if(iter == theIndex.end())
+			{
+				Event event ;
+				event.thePath = path ;
+				event.theEvents = events ;
+				event.theIsDirectory = is_directory ;
+				event.theCookie = cookie ;
+
+				theIndex.insert(std::make_pair(path, theEvents.size())) ;
+				theEvents.push_back(event) ;
+			}
+			else
+			{
+				Event& event = theEvents[iter->second] ;
+				event.theEvents |= events ;
+				event.theIsDirectory = is_directory ;
+				if(cookie != 0)
+				{
+					event.theCookie = cookie ;
+				}
+			}
+		}
+
+		/** events in the order their paths first changed */
+		std::vector<Event> theEvents ;
+
+	private:
+
+		/** index of each path within theEvents */
+		std::map<std::string, size_t> theIndex ;
+} ;
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates a new DirectoryWatcher, watching no directories
+ *
+ * @throw Exception if a system error occurs
+ */
+DirectoryWatcher::DirectoryWatcher() throw(Exception)
+	: theFd(-1), theCoalesceInterval(0), theBuffer(64 * 1024)
+{
+	theFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC) ;
+	if(theFd == -1)
+	{
+		throw(Exception(std::string("Exception creating directory watcher [inotify_init1]:").append(::strerror(errno)))) ;
+	}
+}
+
+/**
+ * Destructor.
+ *
+ */
+DirectoryWatcher::~DirectoryWatcher()
+{
+	::close(theFd) ;
+}
+
+//-------------------------------------------------------------------------------//
+// DirectoryWatcher Operations
+
+/**
+ * Watches the specified directory for the specified changes to its entries.
+ * Watching a directory already watched replaces its watched changes.
+ *
+ * @param dir the directory to watch
+ * @param recursive set true to watch all subdirectories, including those created later
+ * @param events or'ed EventTypeEnum changes to watch for
+ * @throw Exception if dir is not a directory, or a system error occurs
+ */
+void
+DirectoryWatcher::watch(const FilePath& dir, bool recursive, int events) throw(Exception)
+{
+	std::string path = dir.getPath() ;
+	if(!addWatch(path, events, recursive))
+	{
+		throw(Exception(std::string("Exception watching directory [inotify_add_watch]:").append(::strerror(errno)))) ;
+	}
+
+	if(recursive)
+	{
+		addSubdirectoryWatches(path, events, NULL) ;
+	}
+}
+
+/**
+ * Stops watching the specified directory, and, if it was watched recursively, its subdirectories
+ *
+ * @param dir the directory to stop watching
+ * @return true if dir was watched, false otherwise
+ */
+bool
+DirectoryWatcher::unwatch(const FilePath& dir)
+{
+	std::string path = dir.getPath() ;
+
+	std::map<std::string, int>::iterator root = thePaths.find(path) ;
+	if(root == thePaths.end())
+	{
+		return(false) ;
+	}
+
+	std::vector<int> removed ;
+	removed.push_back(root->second) ;
+
+	if(theWatches[root->second].theRecursive)
+	{
+		std::string prefix = path + FilePath::PATH_SEPARATOR ;
+		for(std::map<std::string, int>::iterator iter = thePaths.lower_bound(prefix) ; iter != thePaths.end() && iter->first.compare(0, prefix.size(), prefix) == 0 ; ++iter)
+		{
+			if(theWatches[iter->second].theRecursive)
+			{
+				removed.push_back(iter->second) ;
+			}
+		}
+	}
+
+	for(std::vector<int>::iterator iter = removed.begin() ; iter != removed.end() ; ++iter)
+	{
+		::inotify_rm_watch(theFd, *iter) ;
+		forgetWatch(*iter) ;
+	}
+
+	return(true) ;
+}
+
+/**
+ * Reads pending events, appending them, coalesced, to events.
+ * If no events are pending, waits up to usec microseconds for an event to occur.
+ * Once an event has been read, further events are collected for the coalesce interval.
+ *
+ * @param events the vector to append events to
+ * @param usec the maximum time to wait for an event, 0 to not wait, negative to wait indefinitely
+ * @return the number of events appended
+ * @throw Exception if a system error occurs
+ */
+size_t
+DirectoryWatcher::readEvents(std::vector<Event>& events, long usec) throw(Exception)
+{
+	if(!waitReadable(usec))
+	{
+		return(0) ;
+	}
+
+	Batch batch ;
+	drain(batch) ;
+
+	if(theCoalesceInterval > 0)
+	{
+		long long deadline = now() + theCoalesceInterval ;
+		long long remaining = theCoalesceInterval ;
+		while(remaining > 0)
+		{
+			if(waitReadable(static_cast<long>(remaining)))
+			{
+				drain(batch) ;
+			}
+			remaining = deadline - now() ;
+		}
+	}
+
+	events.insert(events.end(), batch.theEvents.begin(), batch.theEvents.end()) ;
+	return(batch.theEvents.size()) ;
+}
+
+/**
+ * Returns the file descriptor which becomes readable when events are pending.
+ * The descriptor is non-blocking, and must only be read through readEvents.
+ *
+ * @return the file descriptor of this watcher
+ */
+int
+DirectoryWatcher::getFileDescriptor() const
+{
+	return(theFd) ;
+}
+
+/**
+ * Sets the interval, after the first event of a batch, over which further events are
+ * collected and coalesced by readEvents
+ *
+ * @param usec the coalesce interval in microseconds, 0 to return as soon as pending events are read
+ */
+void
+DirectoryWatcher::setCoalesceInterval(long usec)
+{
+	theCoalesceInterval = usec ;
+}
+
+/**
+ * Returns the interval over which further events are collected and coalesced by readEvents
+ *
+ * @return the coalesce interval in microseconds
+ */
+long
+DirectoryWatcher::getCoalesceInterval() const
+{
+	return(theCoalesceInterval) ;
+}
+
+/**
+ * Returns the number of directories watched, including recursively watched subdirectories
+ *
+ * @return the number of watched directories
+ */
+size_t
+DirectoryWatcher::getWatchCount() const
+{
+	return(theWatches.size()) ;
+}
+
+//-------------------------------------------------------------------------------//
+
+/**
+ * Adds, or updates, a watch on a single directory
+ *
+ * @param path the directory to watch
+ * @param events or'ed EventTypeEnum changes to watch for
+ * @param recursive true if subdirectories are watched
+ * @return false if the directory no longer exists, or is not a directory, with errno set to ENOENT or ENOTDIR
+ * @throw Exception if a system error occurs
+ */
+bool
+DirectoryWatcher::addWatch(const std::string& path, int events, bool recursive) throw(Exception)
+{
+	uint32_t mask = toMask(events) | IN_ONLYDIR ;
+	if(recursive)
+	{
+		mask |= RECURSIVE_MASK ;
+	}
+
+	int wd = ::inotify_add_watch(theFd, path.c_str(), mask) ;
+	if(wd == -1)
+	{
+		if(errno == ENOENT || errno == ENOTDIR)
+		{
+			return(false) ;
+		}
+		throw(Exception(std::string("Exception watching directory [inotify_add_watch]:").append(::strerror(errno)))) ;
+	}
+
+	// the same directory reached through another path replaces the earlier path
+	std::map<int, Watch>::iterator existing = theWatches.find(wd) ;
+	if(existing != theWatches.end() && existing->second.thePath != path)
+	{
+		thePaths.erase(existing->second.thePath) ;
+	}
+
+	Watch& watch = theWatches[wd] ;
+	watch.thePath = path ;
+	watch.theEvents = events ;
+	watch.theRecursive = recursive ;
+	thePaths[path] = wd ;
+
+	return(true) ;
+}
+
+/**
+ * Watches the subdirectories of a recursively watched directory
+ *
+ * @param path the directory whose subdirectories to watch
+ * @param events or'ed EventTypeEnum changes to watch for
+ * @param batch if not NULL, receives a created event for each existing entry
+ * @throw Exception if a system error occurs
+ */
+void
+DirectoryWatcher::addSubdirectoryWatches(const std::string& path, int events, Batch* batch) throw(Exception)
+{
+	DirectoryWalker walker ;
+	walker.setIncludeHidden(true) ;
+	walker.setFollowSymLinks(false) ;
+
+	EntryCollector collector ;
+	try
+	{
+		walker.walk(FilePath(path), collector) ;
+	}
+	catch(Exception& e)
+	{
+		// the directory may have been removed again before it could be read
+		if(FilePath(path).exists())
+		{
+			throw ;
+		}
+	}
+
+	for(size_t i = 0 ; i < collector.thePaths.size() ; ++i)
+	{
+		if(collector.theDirectories[i])
+		{
+			addWatch(collector.thePaths[i], events, true) ;
+		}
+
+		if(batch != NULL && (events & CREATED_ENUM))
+		{
+			batch->add(collector.thePaths[i], CREATED_ENUM, collector.theDirectories[i], 0) ;
+		}
+	}
+}
+
+/**
+ * Removes the record of a watch, the watch having been removed by the kernel or by inotify_rm_watch
+ *
+ * @param wd the watch descriptor
+ */
+void
+DirectoryWatcher::forgetWatch(int wd)
+{
+	std::map<int, Watch>::iterator iter = theWatches.find(wd) ;
+	if(iter != theWatches.end())
+	{
+		std::map<std::string, int>::iterator path = thePaths.find(iter->second.thePath) ;
+		if(path != thePaths.end() && path->second == wd)
+		{
+			thePaths.erase(path) ;
+		}
+		theWatches.erase(iter) ;
+	}
+}
+
+/**
+ * Reads and processes all events currently available
+ *
+ * @param batch receives the events read
+ * @throw Exception if a system error occurs
+ */
+void
+DirectoryWatcher::drain(Batch& batch) throw(Exception)
+{
+	for(;;)
+	{
+		ssize_t count = ::read(theFd, &theBuffer[0], theBuffer.size()) ;
+		if(count == -1)
+		{
+			if(errno == EINTR)
+			{
+				continue ;
+			}
+			if(errno == EAGAIN)
+			{
+				break ;
+			}
+			throw(Exception(std::string("Exception reading directory events [read]:").append(::strerror(errno)))) ;
+		}
+
+		const char* pos = &theBuffer[0] ;
+		const char* end = pos + count ;
+		while(pos < end)
+		{
+			const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(pos) ;
+			pos += sizeof(struct inotify_event) + event->len ;
+
+			if(event->mask & IN_Q_OVERFLOW)
+			{
+				batch.add(std::string(), OVERFLOW_ENUM, false, 0) ;
+				continue ;
+			}
+
+			std::map<int, Watch>::iterator iter = theWatches.find(event->wd) ;
+			if(iter == theWatches.end())
+			{
+				continue ;
+			}
+
+			if(event->mask & IN_IGNORED)
+			{
+				forgetWatch(event->wd) ;
+				continue ;
+			}
+
+			// copy the watch, recursion below may modify theWatches
+			Watch watch = iter->second ;
+
+			std::string path(watch.thePath) ;
+			if(event->len > 0 && event->name[0] != '\0')
+			{
+				path.append(1, FilePath::PATH_SEPARATOR).append(event->name) ;
+			}
+
+			bool is_directory = (event->mask & IN_ISDIR) != 0 ;
+			int events = fromMask(event->mask) & watch.theEvents ;
+			if(events != 0)
+			{
+				batch.add(path, events, is_directory, event->cookie) ;
+			}
+
+			if(watch.theRecursive && is_directory)
+			{
+				if(event->mask & (IN_CREATE | IN_MOVED_TO))
+				{
+					if(addWatch(path, watch.theEvents, true))
+					{
+						addSubdirectoryWatches(path, watch.theEvents, &batch) ;
+					}
+				}
+				else if(event->mask & IN_MOVED_FROM)
+				{
+					unwatch(FilePath(path)) ;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Waits for the inotify descriptor to become readable
+ *
+ * @param usec the maximum time to wait, negative to wait indefinitely
+ * @return true if the descriptor is readable
+ * @throw Exception if a system error occurs
+ */
+bool
+DirectoryWatcher::waitReadable(long usec) throw(Exception)
+{
+	struct pollfd pfd ;
+	pfd.fd = theFd ;
+	pfd.events = POLLIN ;
+	pfd.revents = 0 ;
+
+	struct timespec timeout ;
+	timeout.tv_sec = usec / 1000000 ;
+	timeout.tv_nsec = (usec % 1000000) * 1000 ;
+
+	int result = 0 ;
+	do
+	{
+		result = ::ppoll(&pfd, 1, (usec < 0) ? NULL : &timeout, NULL) ;
+	}
+	while(result == -1 && errno == EINTR) ;
+
+	if(result == -1)
+	{
+		throw(Exception(std::string("Exception waiting for directory events [ppoll]:").append(::strerror(errno)))) ;
+	}
+
+	return(result > 0) ;
+}
@@ -20,6 +20,8 @@
  */
 
 #include <cutil/FilePath.h>
+#include <cutil/DirectoryWalker.h>
+#include <cutil/FileStatus.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -30,13 +32,76 @@
 #include <unistd.h>
 
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
+#include <vector>
 
 
+using cutil::DirectoryWalker ;
 using cutil::FilePath ;
+using cutil::FileStatus ;
 
 const char FilePath::PATH_SEPARATOR = '/' ;
 
+namespace
+{
+	/**
+	 * DirectoryWalker::Visitor collecting entry paths into a list of strings
+	 *
+	 */
+	class StringListVisitor : public DirectoryWalker::Visitor
+	{
+		public:
+			StringListVisitor(std::list<std::string>& fileList) : theFileList(fileList) {}
+
+			virtual DirectoryWalker::VisitResultEnum visit(const DirectoryWalker::Entry& entry)
+			{
+				theFileList.push_back(std::string(entry.thePath, entry.thePathLength)) ;
+				return(DirectoryWalker::CONTINUE_ENUM) ;
+			}
+
+		private:
+			std::list<std::string>& theFileList ;
+	} ;
+
+	/**
+	 * DirectoryWalker::Visitor collecting entry paths into a list of FilePaths
+	 *
+	 */
+	class FilePathListVisitor : public DirectoryWalker::Visitor
+	{
+		public:
+			FilePathListVisitor(std::list<FilePath>& fileList) : theFileList(fileList) {}
+
+			virtual DirectoryWalker::VisitResultEnum visit(const DirectoryWalker::Entry& entry)
+			{
+				theFileList.push_back(FilePath(std::string(entry.thePath, entry.thePathLength))) ;
+				return(DirectoryWalker::CONTINUE_ENUM) ;
+			}
+
+		private:
+			std::list<FilePath>& theFileList ;
+	} ;
+
+	/**
+	 * FilePath::ContentWriter writing a string
+	 *
+	 */
+	class StringWriter : public FilePath::ContentWriter
+	{
+		public:
+			StringWriter(const std::string& content) : theContent(content) {}
+
+			virtual void write(FILE* out)
+			{
+				::fwrite(theContent.data(), 1, theContent.size(), out) ;
+			}
+
+		private:
+			const std::string& theContent ;
+	} ;
+}
+
 //-------------------------------------------------------------------------------//
 // Constructor / Desctructor
 
@@ -267,6 +332,119 @@ FilePath::rename(const std::string& newFile) throw(Exception)
 	}
 }
 
+/**
+ * Atomically replaces the file represented by this FilePath object with the specified content.
+ * The content is written to a uniquely named temporary file beside the file, which is
+ * synchronized to disk and renamed over the file, and the directory is then synchronized
+ * so the rename itself is durable. The file is never left partially written, and no
+ * temporary file remains if the replacement fails.
+ * The permissions of an existing file are retained, otherwise mode is used.
+ *
+ * @param content the new content of the file
+ * @param mode the permissions of the file if it does not already exist
+ * @throw Exception if a system error occured during writing
+ */
+void
+FilePath::replaceFile(const std::string& content, mode_t mode) const throw(Exception)
+{
+	StringWriter writer(content) ;
+	replaceFile(writer, mode) ;
+}
+
+/**
+ * Atomically replaces the file represented by this FilePath object with the content
+ * written by the specified ContentWriter, as replaceFile(const std::string&, mode_t).
+ * The content is written as it is produced, rather than first being held in memory.
+ * An exception thrown by the ContentWriter leaves the file unchanged and is rethrown.
+ *
+ * @param writer writes the new content of the file
+ * @param mode the permissions of the file if it does not already exist
+ * @throw Exception if a system error occured during writing
+ */
+void
+FilePath::replaceFile(ContentWriter& writer, mode_t mode) const throw(Exception)
+{
+	if(isEmpty())
+	{
+		throw(Exception(std::string("Exception replacing file: empty file path"))) ;
+	}
+
+	struct stat st ;
+	if(::stat(getPath().c_str(), &st) == 0)
+	{
+		mode = st.st_mode & 07777 ;
+	}
+
+	// written beside the file, so the rename cannot cross filesystems
+	std::string temp = getPath() ;
+	temp.append(".XXXXXX") ;
+	std::vector<char> tempName(temp.begin(), temp.end()) ;
+	tempName.push_back('\0') ;
+
+	int fd = ::mkstemp(&tempName[0]) ;
+	if(fd == -1)
+	{
+		throw(Exception(std::string("Exception replacing file [mkstemp]:").append(::strerror(errno)))) ;
+	}
+
+	FILE* out = ::fdopen(fd, "w") ;
+	if(out == 0)
+	{
+		int err = errno ;
+		::close(fd) ;
+		::unlink(&tempName[0]) ;
+		throw(Exception(std::string("Exception replacing file [fdopen]:").append(::strerror(err)))) ;
+	}
+
+	try
+	{
+		writer.write(out) ;
+	}
+	catch(...)
+	{
+		::fclose(out) ;
+		::unlink(&tempName[0]) ;
+		throw ;
+	}
+
+	// mkstemp creates the file readable only by its owner
+	bool ok = (::ferror(out) == 0) && (::fflush(out) == 0) && (::fchmod(fd, mode) == 0) && (::fsync(fd) == 0) ;
+	int err = errno ;
+
+	if((::fclose(out) != 0) && ok)
+	{
+		ok = false ;
+		err = errno ;
+	}
+
+	if(!ok)
+	{
+		::unlink(&tempName[0]) ;
+		throw(Exception(std::string("Exception replacing file [write]:").append(::strerror(err)))) ;
+	}
+
+	if(::rename(&tempName[0], getPath().c_str()) == -1)
+	{
+		err = errno ;
+		::unlink(&tempName[0]) ;
+		throw(Exception(std::string("Exception replacing file [rename]:").append(::strerror(err)))) ;
+	}
+
+	// synchronize the directory so the rename itself is durable
+	std::string dir = getParent() ;
+	if(dir.empty())
+	{
+		dir = (getPath()[0] == FilePath::PATH_SEPARATOR) ? std::string(1, FilePath::PATH_SEPARATOR) : std::string(".") ;
+	}
+
+	int dirfd = ::open(dir.c_str(), O_RDONLY) ;
+	if(dirfd != -1)
+	{
+		::fsync(dirfd) ;
+		::close(dirfd) ;
+	}
+}
+
 /**
  * Returns true if the file or directory represented by this FilePath object exists.
  *
@@ -459,50 +637,13 @@ FilePath::isEmpty() const
 FilePath::FileType
 FilePath::getFileType() const throw(Exception)
 {
-	FilePath::FileType fileType = UNKNOWN_TYPE_ENUM;
-
-	struct stat buf ;
-	if(::stat(getPath().c_str(), &buf) == 0)
-	{
-		if(S_ISREG(buf.st_mode))
-		{
-			fileType = REGULAR_FILE_ENUM ;
-		}
-		else if(S_ISDIR(buf.st_mode))
-		{
-			fileType = DIRECTORY_ENUM ;
-		}
-		else if(S_ISFIFO(buf.st_mode))
-		{
-			fileType = FIFO_ENUM ;
-		}
-		else if(S_ISSOCK(buf.st_mode))
-		{
-			fileType = SOCKET_ENUM ;
-		}
-		else if(S_ISLNK(buf.st_mode))
-		{
-			fileType = SYM_LINK_ENUM ;
-		}
-		else if(S_ISCHR(buf.st_mode))
-		{
-			fileType = CHAR_DEV_ENUM ;
-		}
-		else if(S_ISBLK(buf.st_mode))
-		{
-			fileType = BLOCK_DEV_ENUM ;
-		}
-		else
-		{
-			fileType = UNKNOWN_TYPE_ENUM ;
-		}
-	}
-	else
+	FileStatus status(*this, FileStatus::TYPE_FIELD_ENUM) ;
+	if(!status.exists())
 	{
-		throw(Exception(std::string("Exception accesing file type [stat]:").append(::strerror(errno)))) ;
+		throw(Exception(std::string("Exception accesing file type [stat]:").append(::strerror(status.getError())))) ;
 	}
 
-	return(fileType) ;
+	return(status.getFileType()) ;
 }
 
 /**
@@ -515,19 +656,13 @@ FilePath::getFileType() const throw(Exception)
 bool
 FilePath::isDirectory() const throw(Exception)
 {
-	bool regFile = false;
-
-	struct stat buf ;
-	if(::stat(getPath().c_str(), &buf) == 0)
-	{
-		regFile = S_ISDIR(buf.st_mode) ;
-	}
-	else
+	FileStatus status(*this, FileStatus::TYPE_FIELD_ENUM) ;
+	if(!status.exists())
 	{
-		throw(Exception(std::string("Exception accesing file type [stat]:").append(::strerror(errno)))) ;
+		throw(Exception(std::string("Exception accesing file type [stat]:").append(::strerror(status.getError())))) ;
 	}
 
-	return(regFile) ;
+	return(status.isDirectory()) ;
 }
 
 /**
@@ -541,19 +676,13 @@ FilePath::isDirectory() const throw(Exception)
 bool
 FilePath::isRegularFile() const throw(Exception)
 {
-	bool regFile = false;
-
-	struct stat buf ;
-	if(::stat(getPath().c_str(), &buf) == 0)
-	{
-		regFile = S_ISREG(buf.st_mode) ;
-	}
-	else
+	FileStatus status(*this, FileStatus::TYPE_FIELD_ENUM) ;
+	if(!status.exists())
 	{
-		throw(Exception(std::string("Exception accesing file type [stat]:").append(::strerror(errno)))) ;
+		throw(Exception(std::string("Exception accesing file type [stat]:").append(::strerror(status.getError())))) ;
 	}
 
-	return(regFile) ;
+	return(status.isRegularFile()) ;
 }
 
 /**
@@ -671,19 +800,42 @@ FilePath::isAbsolute() const
 unsigned long
 FilePath::getFileSize() const throw(Exception)
 {
-	unsigned long size = 0 ;
-
-	struct stat buf ;
-	if(::stat(theFilePath.c_str(), &buf) == 0)
-	{
-		size = buf.st_size ;
-	}
-	else
+	FileStatus status(*this, FileStatus::SIZE_FIELD_ENUM) ;
+	if(!status.exists())
 	{
-		throw(Exception(std::string("Exception obtaining file size [stat]:").append(::strerror(errno)))) ;
+		throw(Exception(std::string("Exception obtaining file size [stat]:").append(::strerror(status.getError())))) ;
 	}
-	
-	return(size) ;
+
+	return(status.getSize()) ;
+}
+
+/**
+ * Returns a snapshot of the metadata of the file represented by this FilePath object.
+ * The metadata is obtained with a single system call, any number of property queries
+ * may then be answered from the returned FileStatus. A FileStatus is returned, with
+ * exists() false, if the file does not exist.
+ *
+ * @return the metadata of the file
+ * @throw Exception if a system error occured
+ */
+FileStatus
+FilePath::getStatus() const throw(Exception)
+{
+	return(FileStatus(*this)) ;
+}
+
+/**
+ * Returns a snapshot of the requested metadata of the file represented by this FilePath object.
+ * Requesting only the fields required may allow the filesystem to avoid obtaining the others.
+ *
+ * @param fields or'ed FileStatus::FieldEnum values to obtain
+ * @return the metadata of the file
+ * @throw Exception if a system error occured
+ */
+FileStatus
+FilePath::getStatus(int fields) const throw(Exception)
+{
+	return(FileStatus(*this, fields)) ;
 }
 
 
@@ -695,6 +847,7 @@ FilePath::getFileSize() const throw(Exception)
 /**
  * Popultes the specified list with the contents of the directory represented by this FilePath
  * If this FilePath does not represent a directory, no action is taken and filelist is unchanged
+ * DirectoryWalker should be preferred for large, or recursive, listings
  *
  * @param fileList populated with the contenst of the directory represented by this FilePath
  * @return the fileList parameter populated
@@ -703,28 +856,11 @@ FilePath::getFileSize() const throw(Exception)
 std::list<std::string>&
 FilePath::getFiles(std::list<std::string>& fileList) const throw(Exception)
 {
-	DIR* dir = 0 ;
+	StringListVisitor visitor(fileList) ;
 
-	if((dir = ::opendir(theFilePath.c_str())) != 0)
-	{
-		struct dirent* item;
-
-		// @todo how do we tell if we get an error here, or simply reach the end?
-		while((item = ::readdir(dir)) != 0)
-		{
-			if((std::string(item->d_name) != ".") && (std::string(item->d_name) != ".."))
-			{
-				std::string filepath = getPath() ;
-				appendPathSeparator(filepath) ;
-				filepath.append(std::string(item->d_name)) ;
-				fileList.push_back(filepath) ;
-			}
-		}
-	}
-	else
-	{
-		throw(Exception(std::string("Exception accessing directory [opendir]:").append(::strerror(errno)))) ;
-	}
+	DirectoryWalker walker ;
+	walker.setMaxDepth(0) ;
+	walker.walk(*this, visitor) ;
 
 	return(fileList) ;
 }
@@ -732,6 +868,7 @@ FilePath::getFiles(std::list<std::string>& fileList) const throw(Exception)
 /**
  * Popultes the specified list with the contents of the directory represented by this FilePath
  * If this FilePath does not represent a directory, no action is taken and filelist is unchanged
+ * DirectoryWalker should be preferred for large, or recursive, listings
  *
  * @param fileList populated with the contenst of the directory represented by this File
  * @return the fileList parameter populated
@@ -740,13 +877,11 @@ FilePath::getFiles(std::list<std::string>& fileList) const throw(Exception)
 std::list<FilePath>&
 FilePath::getFiles(std::list<FilePath>& fileList) const throw(Exception)
 {
-	std::list<std::string> stringList;
+	FilePathListVisitor visitor(fileList) ;
 
-	getFiles(stringList);
-	for(std::list<std::string>::const_iterator citer = stringList.begin(); citer != stringList.end(); ++citer)
-	{
-		fileList.push_back(FilePath(*citer)) ;
-	}
+	DirectoryWalker walker ;
+	walker.setMaxDepth(0) ;
+	walker.walk(*this, visitor) ;
 
 	return(fileList) ;
 }
@@ -0,0 +1,744 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#include <cutil/FileStatus.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+using cutil::Exception ;
+using cutil::FilePath ;
+using cutil::FileStatus ;
+
+namespace
+{
+	/** set once statx has been found unsupported by the kernel, accessed atomically as any thread may set it */
+	bool statx_unsupported = false ;
+
+	/**
+	 * Maps the type bits of a mode to a FilePath::FileType
+	 *
+	 * @param mode the mode to map
+	 * @return the corresponding FileType
+	 */
+	FilePath::FileType toFileType(mode_t mode)
+	{
+		FilePath::FileType fileType = FilePath::UNKNOWN_TYPE_ENUM ;
+
+		if(S_ISREG(mode))
+		{
+			fileType = FilePath::REGULAR_FILE_ENUM ;
+		}
+		else if(S_ISDIR(mode))
+		{
+			fileType = FilePath::DIRECTORY_ENUM ;
+		}
+		else if(S_ISFIFO(mode))
+		{
+			fileType = FilePath::FIFO_ENUM ;
+		}
+		else if(S_ISSOCK(mode))
+		{
+			fileType = FilePath::SOCKET_ENUM ;
+		}
+		else if(S_ISLNK(mode))
+		{
+			fileType = FilePath::SYM_LINK_ENUM ;
+		}
+		else if(S_ISCHR(mode))
+		{
+			fileType = FilePath::CHAR_DEV_ENUM ;
+		}
+		else if(S_ISBLK(mode))
+		{
+			fileType = FilePath::BLOCK_DEV_ENUM ;
+		}
+
+		return(fileType) ;
+	}
+
+	/**
+	 * Returns whether an error indicates the path does not exist, rather than a system failure
+	 *
+	 * @param error the errno to test
+	 * @return true if the error indicates the path does not exist
+	 */
+	bool isMissing(int error)
+	{
+		return(error == ENOENT || error == ENOTDIR || error == ELOOP || error == ENAMETOOLONG || error == EACCES) ;
+	}
+
+	/**
+	 * Orders path indices by the parent directory of the path
+	 */
+	class ParentOrder
+	{
+		public:
+			ParentOrder(const std::vector<std::string>& parents) : theParents(parents) {}
+			bool operator()(size_t a, size_t b) const { return(theParents[a] < theParents[b]) ; }
+		private:
+			const std::vector<std::string>& theParents ;
+	} ;
+}
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates an empty FileStatus, representing a file which does not exist
+ *
+ */
+FileStatus::FileStatus()
+{
+	clear(ENOENT) ;
+}
+
+/**
+ * Creates a FileStatus holding the metadata of the specified path
+ *
+ * @param path the path to obtain the metadata of
+ * @param fields or'ed FieldEnum values to obtain
+ * @param follow set false to report a symbolic link itself rather than its target
+ * @throw Exception if a system error other than the path not existing occurs
+ */
+FileStatus::FileStatus(const FilePath& path, int fields, bool follow) throw(Exception)
+{
+	load(path, fields, follow) ;
+}
+
+/**
+ * Destructor.
+ *
+ */
+FileStatus::~FileStatus()
+{}
+
+//-------------------------------------------------------------------------------//
+// FileStatus Operations
+
+/**
+ * Obtains the metadata of the specified path, replacing any held by this FileStatus
+ *
+ * @param path the path to obtain the metadata of
+ * @param fields or'ed FieldEnum values to obtain
+ * @param follow set false to report a symbolic link itself rather than its target
+ * @return true if the path exists, false otherwise
+ * @throw Exception if a system error other than the path not existing occurs
+ */
+bool
+FileStatus::load(const FilePath& path, int fields, bool follow) throw(Exception)
+{
+	return(loadAt(AT_FDCWD, path.getPath().c_str(), fields, follow)) ;
+}
+
+/**
+ * Obtains the metadata of the specified path relative to an open directory
+ *
+ * @param dir_fd descriptor of the directory path is relative to, or AT_FDCWD
+ * @param path the path to obtain the metadata of
+ * @param fields or'ed FieldEnum values to obtain
+ * @param follow set false to report a symbolic link itself rather than its target
+ * @return true if the path exists, false otherwise
+ * @throw Exception if a system error other than the path not existing occurs
+ */
+bool
+FileStatus::loadAt(int dir_fd, const char* path, int fields, bool follow) throw(Exception)
+{
+	clear(0) ;
+
+	int at_flags = follow ? 0 : AT_SYMLINK_NOFOLLOW ;
+
+#ifdef STATX_TYPE
+	if(!__atomic_load_n(&statx_unsupported, __ATOMIC_RELAXED))
+	{
+		unsigned int mask = 0 ;
+		if(fields & (TYPE_FIELD_ENUM | MODE_FIELD_ENUM))
+		{
+			mask |= STATX_TYPE | ((fields & MODE_FIELD_ENUM) ? STATX_MODE : 0) ;
+		}
+		if(fields & OWNER_FIELD_ENUM)
+		{
+			mask |= STATX_UID | STATX_GID ;
+		}
+		if(fields & SIZE_FIELD_ENUM)
+		{
+			mask |= STATX_SIZE ;
+		}
+		if(fields & BLOCKS_FIELD_ENUM)
+		{
+			mask |= STATX_BLOCKS ;
+		}
+		if(fields & TIMES_FIELD_ENUM)
+		{
+			mask |= STATX_ATIME | STATX_MTIME | STATX_CTIME ;
+		}
+		if(fields & BIRTH_TIME_FIELD_ENUM)
+		{
+			mask |= STATX_BTIME ;
+		}
+		if(fields & INODE_FIELD_ENUM)
+		{
+			mask |= STATX_INO ;
+		}
+		if(fields & LINK_COUNT_FIELD_ENUM)
+		{
+			mask |= STATX_NLINK ;
+		}
+
+		struct statx buf ;
+		if(::statx(dir_fd, path, at_flags | AT_NO_AUTOMOUNT, mask, &buf) == 0)
+		{
+			theFields = fields & ~BIRTH_TIME_FIELD_ENUM ;
+			if((fields & BIRTH_TIME_FIELD_ENUM) && (buf.stx_mask & STATX_BTIME))
+			{
+				theFields |= BIRTH_TIME_FIELD_ENUM ;
+			}
+
+			theMode = buf.stx_mode ;
+			theOwner = buf.stx_uid ;
+			theGroup = buf.stx_gid ;
+			theSize = buf.stx_size ;
+			theBlocks = buf.stx_blocks ;
+			theAccessTime.tv_sec = buf.stx_atime.tv_sec ;
+			theAccessTime.tv_nsec = buf.stx_atime.tv_nsec ;
+			theModifiedTime.tv_sec = buf.stx_mtime.tv_sec ;
+			theModifiedTime.tv_nsec = buf.stx_mtime.tv_nsec ;
+			theChangeTime.tv_sec = buf.stx_ctime.tv_sec ;
+			theChangeTime.tv_nsec = buf.stx_ctime.tv_nsec ;
+			theBirthTime.tv_sec = buf.stx_btime.tv_sec ;
+			theBirthTime.tv_nsec = buf.stx_btime.tv_nsec ;
+			theDevice = makedev(buf.stx_dev_major, buf.stx_dev_minor) ;
+			theInode = buf.stx_ino ;
+			theLinkCount = buf.stx_nlink ;
+			discardUnrequested() ;
+
+			return(true) ;
+		}
+		else if(errno == ENOSYS)
+		{
+			__atomic_store_n(&statx_unsupported, true, __ATOMIC_RELAXED) ;
+		}
+		else if(isMissing(errno))
+		{
+			clear(errno) ;
+			return(false) ;
+		}
+		else
+		{
+			throw(Exception(std::string("Exception obtaining file status [statx]:").append(::strerror(errno)))) ;
+		}
+	}
+#endif
+
+	struct stat buf ;
+	if(::fstatat(dir_fd, path, &buf, at_flags) == 0)
+	{
+		theFields = fields & ~BIRTH_TIME_FIELD_ENUM ;
+		theMode = buf.st_mode ;
+		theOwner = buf.st_uid ;
+		theGroup = buf.st_gid ;
+		theSize = buf.st_size ;
+		theBlocks = buf.st_blocks ;
+		theAccessTime = buf.st_atim ;
+		theModifiedTime = buf.st_mtim ;
+		theChangeTime = buf.st_ctim ;
+		theDevice = buf.st_dev ;
+		theInode = buf.st_ino ;
+		theLinkCount = buf.st_nlink ;
+		discardUnrequested() ;
+	}
+	else if(isMissing(errno))
+	{
+		clear(errno) ;
+	}
+	else
+	{
+		throw(Exception(std::string("Exception obtaining file status [fstatat]:").append(::strerror(errno)))) ;
+	}
+
+	return(theError == 0) ;
+}
+
+/**
+ * Obtains the metadata of each of the specified paths.
+ * Paths are grouped by parent directory, each parent directory is opened once and its
+ * entries queried relative to it, avoiding resolution of the full path of each entry.
+ * statuses is resized to match paths, each element holding the metadata of the
+ * corresponding path.
+ *
+ * @param paths the paths to obtain the metadata of
+ * @param statuses populated with the metadata of each path
+ * @param fields or'ed FieldEnum values to obtain
+ * @param follow set false to report symbolic links themselves rather than their targets
+ * @return the number of paths which exist
+ * @throw Exception if a system error other than a path not existing occurs
+ */
+size_t
+FileStatus::loadMany(const std::vector<FilePath>& paths, std::vector<FileStatus>& statuses, int fields, bool follow) throw(Exception)
+{
+	statuses.resize(paths.size()) ;
+
+	// split each path into its parent directory and leaf name
+	std::vector<std::string> parents(paths.size()) ;
+	std::vector<std::string> leaves(paths.size()) ;
+	std::vector<size_t> order(paths.size()) ;
+	for(size_t i = 0 ; i < paths.size() ; ++i)
+	{
+		const std::string& path = paths[i].getPath() ;
+		std::string::size_type pos = path.rfind(FilePath::PATH_SEPARATOR) ;
+		if(pos == std::string::npos || pos + 1 == path.size())
+		{
+			leaves[i] = path ;
+		}
+		else
+		{
+			parents[i] = (pos == 0) ? std::string(1, FilePath::PATH_SEPARATOR) : path.substr(0, pos) ;
+			leaves[i] = path.substr(pos + 1) ;
+		}
+		order[i] = i ;
+	}
+
+	std::stable_sort(order.begin(), order.end(), ParentOrder(parents)) ;
+
+	size_t found = 0 ;
+	size_t i = 0 ;
+	while(i < order.size())
+	{
+		const std::string& parent = parents[order[i]] ;
+
+		size_t end = i + 1 ;
+		while(end < order.size() && parents[order[end]] == parent)
+		{
+			++end ;
+		}
+
+		int dir_fd = AT_FDCWD ;
+		if(!parent.empty())
+		{
+			dir_fd = ::open(parent.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC) ;
+		}
+
+		try
+		{
+			for( ; i < end ; ++i)
+			{
+				size_t index = order[i] ;
+				bool exists = (dir_fd == -1)
+					? statuses[index].load(paths[index], fields, follow)
+					: statuses[index].loadAt(dir_fd, leaves[index].c_str(), fields, follow) ;
+
+				if(exists)
+				{
+					++found ;
+				}
+			}
+		}
+		catch(Exception& e)
+		{
+			if(dir_fd >= 0)
+			{
+				::close(dir_fd) ;
+			}
+			throw ;
+		}
+
+		if(dir_fd >= 0)
+		{
+			::close(dir_fd) ;
+		}
+	}
+
+	return(found) ;
+}
+
+//-------------------------------------------------------------------------------//
+// Property Accessors
+
+/**
+ * Returns whether the file existed when the metadata was obtained
+ *
+ * @return true if the file exists, false otherwise
+ */
+bool
+FileStatus::exists() const
+{
+	return(theError == 0) ;
+}
+
+/**
+ * Returns the error which prevented the metadata being obtained
+ *
+ * @return the errno of the failed call, or 0 if the file exists
+ */
+int
+FileStatus::getError() const
+{
+	return(theError) ;
+}
+
+/**
+ * Returns the or'ed FieldEnum values held by this FileStatus
+ *
+ * @return the fields held by this FileStatus
+ */
+int
+FileStatus::getFields() const
+{
+	return(theFields) ;
+}
+
+/**
+ * Returns the type of the file
+ *
+ * @return the type of the file, UNKNOWN_TYPE_ENUM if not held or the file does not exist
+ */
+FilePath::FileType
+FileStatus::getFileType() const
+{
+	FilePath::FileType fileType = FilePath::UNKNOWN_TYPE_ENUM ;
+
+	if(theFields & (TYPE_FIELD_ENUM | MODE_FIELD_ENUM))
+	{
+		fileType = toFileType(theMode) ;
+	}
+
+	return(fileType) ;
+}
+
+/**
+ * Returns whether the file is a directory
+ *
+ * @return true if the file exists and is a directory
+ */
+bool
+FileStatus::isDirectory() const
+{
+	return(getFileType() == FilePath::DIRECTORY_ENUM) ;
+}
+
+/**
+ * Returns whether the file is a regular file
+ *
+ * @return true if the file exists and is a regular file
+ */
+bool
+FileStatus::isRegularFile() const
+{
+	return(getFileType() == FilePath::REGULAR_FILE_ENUM) ;
+}
+
+/**
+ * Returns whether the file is readable by the effective user of the process.
+ * Requires the MODE_FIELD_ENUM and OWNER_FIELD_ENUM fields. The permission bits are evaluated
+ * against the effective user and groups, access control lists and read only mounts are not
+ * considered, FilePath::isReadable should be used where these matter.
+ *
+ * @return true if the permission bits grant read access
+ */
+bool
+FileStatus::isReadable() const
+{
+	return(isPermitted(S_IRUSR)) ;
+}
+
+/**
+ * Returns whether the file is writable by the effective user of the process.
+ * Requires the MODE_FIELD_ENUM and OWNER_FIELD_ENUM fields, and is subject to the same
+ * limitations as isReadable.
+ *
+ * @return true if the permission bits grant write access
+ */
+bool
+FileStatus::isWritable() const
+{
+	return(isPermitted(S_IWUSR)) ;
+}
+
+/**
+ * Returns the mode, type and permission bits, of the file
+ *
+ * @return the mode of the file
+ */
+mode_t
+FileStatus::getMode() const
+{
+	return(theMode) ;
+}
+
+/**
+ * Returns the owning user of the file
+ *
+ * @return the owning user id
+ */
+uid_t
+FileStatus::getOwner() const
+{
+	return(theOwner) ;
+}
+
+/**
+ * Returns the owning group of the file
+ *
+ * @return the owning group id
+ */
+gid_t
+FileStatus::getGroup() const
+{
+	return(theGroup) ;
+}
+
+/**
+ * Returns the size of the file in bytes
+ *
+ * @return the size of the file
+ */
+unsigned long long
+FileStatus::getSize() const
+{
+	return(theSize) ;
+}
+
+/**
+ * Returns the number of 512 byte blocks allocated to the file
+ *
+ * @return the number of allocated blocks
+ */
+unsigned long long
+FileStatus::getBlocks() const
+{
+	return(theBlocks) ;
+}
+
+/**
+ * Returns the time the file was last accessed
+ *
+ * @return the last access time
+ */
+struct timespec
+FileStatus::getAccessTime() const
+{
+	return(theAccessTime) ;
+}
+
+/**
+ * Returns the time the file contents were last modified
+ *
+ * @return the last modification time
+ */
+struct timespec
+FileStatus::getModifiedTime() const
+{
+	return(theModifiedTime) ;
+}
+
+/**
+ * Returns the time the file status was last changed
+ *
+ * @return the last status change time
+ */
+struct timespec
+FileStatus::getChangeTime() const
+{
+	return(theChangeTime) ;
+}
+
+/**
+ * Returns the time the file was created.
+ * Only reported where statx and the filesystem support it, see hasBirthTime
+ *
+ * @return the creation time
+ */
+struct timespec
+FileStatus::getBirthTime() const
+{
+	return(theBirthTime) ;
+}
+
+/**
+ * Returns whether the creation time of the file is held
+ *
+ * @return true if getBirthTime is valid
+ */
+bool
+FileStatus::hasBirthTime() const
+{
+	return((theFields & BIRTH_TIME_FIELD_ENUM) != 0) ;
+}
+
+/**
+ * Returns the device containing the file
+ *
+ * @return the device containing the file
+ */
+dev_t
+FileStatus::getDevice() const
+{
+	return(theDevice) ;
+}
+
+/**
+ * Returns the inode number of the file
+ *
+ * @return the inode number
+ */
+ino_t
+FileStatus::getInode() const
+{
+	return(theInode) ;
+}
+
+/**
+ * Returns the number of hard links to the file
+ *
+ * @return the hard link count
+ */
+nlink_t
+FileStatus::getLinkCount() const
+{
+	return(theLinkCount) ;
+}
+
+//-------------------------------------------------------------------------------//
+
+/**
+ * Resets this FileStatus to represent a file which does not exist
+ *
+ * @param error the errno preventing the metadata being obtained
+ */
+void
+FileStatus::clear(int error)
+{
+	theFields = 0 ;
+	theError = error ;
+	theMode = 0 ;
+	theOwner = 0 ;
+	theGroup = 0 ;
+	theSize = 0 ;
+	theBlocks = 0 ;
+	theAccessTime.tv_sec = theAccessTime.tv_nsec = 0 ;
+	theModifiedTime = theChangeTime = theBirthTime = theAccessTime ;
+	theDevice = 0 ;
+	theInode = 0 ;
+	theLinkCount = 0 ;
+}
+
+/**
+ * Zeroes the metadata of fields not held, which statx and fstatat may report regardless
+ *
+ */
+void
+FileStatus::discardUnrequested()
+{
+	if(!(theFields & MODE_FIELD_ENUM))
+	{
+		theMode &= (theFields & TYPE_FIELD_ENUM) ? S_IFMT : 0 ;
+	}
+	if(!(theFields & OWNER_FIELD_ENUM))
+	{
+		theOwner = 0 ;
+		theGroup = 0 ;
+	}
+	if(!(theFields & SIZE_FIELD_ENUM))
+	{
+		theSize = 0 ;
+	}
+	if(!(theFields & BLOCKS_FIELD_ENUM))
+	{
+		theBlocks = 0 ;
+	}
+	if(!(theFields & TIMES_FIELD_ENUM))
+	{
+		theAccessTime.tv_sec = theAccessTime.tv_nsec = 0 ;
+		theModifiedTime = theChangeTime = theAccessTime ;
+	}
+	if(!(theFields & BIRTH_TIME_FIELD_ENUM))
+	{
+		theBirthTime.tv_sec = theBirthTime.tv_nsec = 0 ;
+	}
+	if(!(theFields & INODE_FIELD_ENUM))
+	{
+		theDevice = 0 ;
+		theInode = 0 ;
+	}
+	if(!(theFields & LINK_COUNT_FIELD_ENUM))
+	{
+		theLinkCount = 0 ;
+	}
+}
+
+/**
+ * Returns whether the permission bits grant the specified access to the effective user
+ *
+ * @param owner_bit the owner permission bit, the group and other bits are derived from it
+ */
+bool
+FileStatus::isPermitted(mode_t owner_bit) const
+{
+	if(theError != 0 || (theFields & MODE_FIELD_ENUM) == 0 || (theFields & OWNER_FIELD_ENUM) == 0)
+	{
+		return(false) ;
+	}
+
+	uid_t euid = ::geteuid() ;
+	if(euid == 0)
+	{
+		return(true) ;
+	}
+
+	if(theOwner == euid)
+	{
+		return((theMode & owner_bit) != 0) ;
+	}
+
+	bool member = (theGroup == ::getegid()) ;
+	if(!member)
+	{
+		int count = ::getgroups(0, NULL) ;
+		if(count > 0)
+		{
+			std::vector<gid_t> groups(count) ;
+			count = ::getgroups(count, &groups[0]) ;
+			for(int i = 0 ; i < count && !member ; ++i)
+			{
+				member = (groups[i] == theGroup) ;
+			}
+		}
+	}
+
+	if(member)
+	{
+		return((theMode & (owner_bit >> 3)) != 0) ;
+	}
+
+	return((theMode & (owner_bit >> 6)) != 0) ;
+}
@@ -0,0 +1,720 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+#include <cutil/FileStream.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <sys/poll.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using cutil::FilePath ;
+using cutil::FileStream ;
+using cutil::FileStreamException ;
+
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates an unopened FileStream.
+ * open must be called before this FileStream is in a useable state
+ *
+ */
+FileStream::FileStream() : m_path("")
+{
+	m_fd = -1 ;
+	m_access_mode = READ_ONLY_ENUM ;
+	m_flags = OPEN_DEFAULT_ENUM ;
+	m_alignment = 0 ;
+}
+
+/**
+ * Creates a FileStream and opens the specified file
+ *
+ * @param path the file to open
+ * @param mode the access mode of this FileStream
+ * @param flags or'ed OpenFlagsEnum values
+ * @throws FileStreamException if the file cannot be opened
+ */
+FileStream::FileStream(const FilePath& path, AccessModeEnum mode, int flags) throw(FileStreamException) : m_path(path)
+{
+	m_fd = -1 ;
+	m_access_mode = mode ;
+	m_flags = flags ;
+	m_alignment = 0 ;
+
+	// throws FileStreamException
+	open(path, mode, flags) ;
+}
+
+/**
+ * Destructor.
+ * Closes this FileStream if it is open
+ *
+ */
+FileStream::~FileStream()
+{
+	try
+	{
+		close() ;
+	}
+	catch(FileStreamException& fse)
+	{
+		// @note [todo] need to log this!
+	}
+}
+
+
+//-------------------------------------------------------------------------------//
+// FileStream Setup Operations
+
+/**
+ * Opens the specified file.
+ * Any file already opened by this FileStream is first closed.
+ * A file created by OPEN_CREATE_ENUM is created with mode 0666, modified by the process umask.
+ *
+ * @param path the file to open
+ * @param mode the access mode of this FileStream
+ * @param flags or'ed OpenFlagsEnum values
+ * @throws FileStreamException if the file cannot be opened
+ */
+void
+FileStream::open(const FilePath& path, AccessModeEnum mode, int flags) throw(FileStreamException)
+{
+	close() ;
+
+	int open_flags ;
+	switch(mode)
+	{
+		case FileStream::WRITE_ONLY_ENUM:
+		{
+			open_flags = O_WRONLY ;
+			break ;
+		}
+		case FileStream::READ_WRITE_ENUM:
+		{
+			open_flags = O_RDWR ;
+			break ;
+		}
+		case FileStream::READ_ONLY_ENUM:
+		default:
+		{
+			open_flags = O_RDONLY ;
+			break ;
+		}
+	}
+
+	open_flags |= O_CLOEXEC ;
+
+	if(flags & OPEN_CREATE_ENUM)
+	{
+		open_flags |= O_CREAT ;
+	}
+	if(flags & OPEN_TRUNCATE_ENUM)
+	{
+		open_flags |= O_TRUNC ;
+	}
+	if(flags & OPEN_APPEND_ENUM)
+	{
+		open_flags |= O_APPEND ;
+	}
+	if(flags & OPEN_DIRECT_ENUM)
+	{
+		open_flags |= O_DIRECT ;
+	}
+
+	int fd = ::open(path.getPath().c_str(), open_flags, 0666) ;
+	if(fd < 0)
+	{
+		throw(FileStreamException(std::string("Exception in open [open]:").append(path.getPath()).append(": ").append(::strerror(errno)))) ;
+	}
+
+	m_fd = fd ;
+	m_path = path ;
+	m_access_mode = mode ;
+	m_flags = flags ;
+
+	queryAlignment() ;
+}
+
+/**
+ * Closes this FileStream
+ * If this FileStream is not open, no action is taken.
+ *
+ * @throws FileStreamException if an error occurs during the closing of this FileStream
+ */
+void
+FileStream::close() throw(FileStreamException)
+{
+	if(isOpen())
+	{
+		int fd = m_fd ;
+		m_fd = -1 ;
+		m_alignment = 0 ;
+
+		if(::close(fd) != 0)
+		{
+			throw(FileStreamException(std::string("Exception in close [close]:").append(::strerror(errno)))) ;
+		}
+	}
+}
+
+
+//-------------------------------------------------------------------------------//
+// General Accessors/Murators
+
+/**
+ * Returns the FilePath this FileStream was last opened upon
+ *
+ * @return the FilePath of this FileStream
+ */
+FilePath
+FileStream::getPath() const
+{
+	return(m_path) ;
+}
+
+/**
+ * Returns the access mode of this FileStream
+ *
+ * @return the access mode of this FileStream
+ */
+FileStream::AccessModeEnum
+FileStream::getMode() const
+{
+	return(m_access_mode) ;
+}
+
+/**
+ * Returns whether this FileStream has been opened.
+ *
+ * @return true if this FileStream has been opened, false otherwise
+ */
+bool
+FileStream::isOpen() const
+{
+	return(m_fd == -1 ? false : true) ;
+}
+
+/**
+ * Returns whether this FileStream was opened for direct I/O
+ *
+ * @return true if this FileStream bypasses the page cache
+ */
+bool
+FileStream::isDirect() const
+{
+	return(isOpen() && (m_flags & OPEN_DIRECT_ENUM)) ;
+}
+
+/**
+ * Returns the underlying file descriptor of this FileStream.
+ *
+ * @return the file descriptor of this FileStream, or -1 if not open
+ */
+int
+FileStream::getFileDescriptor() const
+{
+	return(m_fd) ;
+}
+
+/**
+ * Returns the alignment required of buffers, offsets and lengths for direct I/O upon this FileStream.
+ * Where the kernel reports the direct I/O alignment of the file that value is used, otherwise
+ * the preferred I/O block size of the filesystem is used.
+ *
+ * @return the direct I/O alignment in bytes, or 0 if this FileStream is not open
+ */
+size_t
+FileStream::getAlignment() const
+{
+	return(m_alignment) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// Positional Operations
+
+/**
+ * Reads up to length bytes from the specified offset into buf.
+ * The current position of this FileStream is not changed, allowing several threads to read
+ * from the same FileStream concurrently.
+ *
+ * @param buf buffer into which the data should be read into
+ * @param length number of bytes to be read
+ * @param offset the file offset to read from
+ * @return the number of bytes read, 0 indicating end of file
+ * @throws FileStreamException if there is an error reading data
+ */
+ssize_t
+FileStream::readAt(void* buf, size_t length, off_t offset) const throw(FileStreamException)
+{
+	ssize_t retcode ;
+	do
+	{
+		retcode = ::pread(m_fd, buf, length, offset) ;
+	}
+	while(retcode < 0 && errno == EINTR) ;
+
+	if(retcode < 0)
+	{
+		throw(FileStreamException(std::string("Exception in readAt [pread]:").append(::strerror(errno)))) ;
+	}
+
+	return(retcode) ;
+}
+
+/**
+ * Writes up to size bytes of data at the specified offset.
+ * The current position of this FileStream is not changed.
+ *
+ * @param data the data to write
+ * @param size number of bytes to write
+ * @param offset the file offset to write at
+ * @return the number of bytes written
+ * @throws FileStreamException if there is an error writing data
+ */
+ssize_t
+FileStream::writeAt(const void* data, size_t size, off_t offset) throw(FileStreamException)
+{
+	ssize_t retcode ;
+	do
+	{
+		retcode = ::pwrite(m_fd, data, size, offset) ;
+	}
+	while(retcode < 0 && errno == EINTR) ;
+
+	if(retcode < 0)
+	{
+		throw(FileStreamException(std::string("Exception in writeAt [pwrite]:").append(::strerror(errno)))) ;
+	}
+
+	return(retcode) ;
+}
+
+/**
+ * Moves the current position of this FileStream
+ *
+ * @param offset the offset relative to origin
+ * @param origin the origin of the seek
+ * @return the new position of this FileStream
+ * @throws FileStreamException if the position cannot be changed
+ */
+off_t
+FileStream::seek(off_t offset, SeekOriginEnum origin) throw(FileStreamException)
+{
+	int whence ;
+	switch(origin)
+	{
+		case FileStream::SEEK_CURRENT_ENUM:
+		{
+			whence = SEEK_CUR ;
+			break ;
+		}
+		case FileStream::SEEK_END_ENUM:
+		{
+			whence = SEEK_END ;
+			break ;
+		}
+		case FileStream::SEEK_BEGIN_ENUM:
+		default:
+		{
+			whence = SEEK_SET ;
+			break ;
+		}
+	}
+
+	off_t pos = ::lseek(m_fd, offset, whence) ;
+	if(pos < 0)
+	{
+		throw(FileStreamException(std::string("Exception in seek [lseek]:").append(::strerror(errno)))) ;
+	}
+
+	return(pos) ;
+}
+
+/**
+ * Returns the current position of this FileStream
+ *
+ * @return the current position of this FileStream
+ * @throws FileStreamException if the position cannot be determined
+ */
+off_t
+FileStream::getPosition() const throw(FileStreamException)
+{
+	off_t pos = ::lseek(m_fd, 0, SEEK_CUR) ;
+	if(pos < 0)
+	{
+		throw(FileStreamException(std::string("Exception in getPosition [lseek]:").append(::strerror(errno)))) ;
+	}
+
+	return(pos) ;
+}
+
+/**
+ * Returns the current size of the file opened by this FileStream
+ *
+ * @return the size of the file in bytes
+ * @throws FileStreamException if the size cannot be determined
+ */
+off_t
+FileStream::getSize() const throw(FileStreamException)
+{
+	struct stat statbuf ;
+	if(::fstat(m_fd, &statbuf) != 0)
+	{
+		throw(FileStreamException(std::string("Exception in getSize [fstat]:").append(::strerror(errno)))) ;
+	}
+
+	return(statbuf.st_size) ;
+}
+
+/**
+ * Truncates, or extends, the file opened by this FileStream to the specified length
+ *
+ * @param length the new length of the file
+ * @throws FileStreamException if the file cannot be truncated
+ */
+void
+FileStream::truncate(off_t length) throw(FileStreamException)
+{
+	if(::ftruncate(m_fd, length) != 0)
+	{
+		throw(FileStreamException(std::string("Exception in truncate [ftruncate]:").append(::strerror(errno)))) ;
+	}
+}
+
+/**
+ * Flushes written data to the storage device.
+ *
+ * @param data_only set true to skip flushing metadata not required to retrieve the data (fdatasync)
+ * @throws FileStreamException if an error occurs flushing the data
+ */
+void
+FileStream::sync(bool data_only) throw(FileStreamException)
+{
+	int ret = data_only ? ::fdatasync(m_fd) : ::fsync(m_fd) ;
+	if(ret != 0)
+	{
+		throw(FileStreamException(std::string("Exception in sync [fsync]:").append(::strerror(errno)))) ;
+	}
+}
+
+
+//-------------------------------------------------------------------------------//
+// Kernel Hints
+
+/**
+ * Advises the kernel of the expected access pattern of a region of this FileStream.
+ * A length of 0 extends the region to the end of the file.
+ *
+ * @param pattern the expected access pattern
+ * @param offset the start of the region
+ * @param length the length of the region
+ * @throws FileStreamException if the advice is rejected
+ */
+void
+FileStream::advise(AccessPatternEnum pattern, off_t offset, off_t length) throw(FileStreamException)
+{
+	int advice ;
+	switch(pattern)
+	{
+		case FileStream::PATTERN_SEQUENTIAL_ENUM:
+		{
+			advice = POSIX_FADV_SEQUENTIAL ;
+			break ;
+		}
+		case FileStream::PATTERN_RANDOM_ENUM:
+		{
+			advice = POSIX_FADV_RANDOM ;
+			break ;
+		}
+		case FileStream::PATTERN_WILL_NEED_ENUM:
+		{
+			advice = POSIX_FADV_WILLNEED ;
+			break ;
+		}
+		case FileStream::PATTERN_DONT_NEED_ENUM:
+		{
+			advice = POSIX_FADV_DONTNEED ;
+			break ;
+		}
+		case FileStream::PATTERN_NO_REUSE_ENUM:
+		{
+			advice = POSIX_FADV_NOREUSE ;
+			break ;
+		}
+		case FileStream::PATTERN_NORMAL_ENUM:
+		default:
+		{
+			advice = POSIX_FADV_NORMAL ;
+			break ;
+		}
+	}
+
+	// posix_fadvise returns the error rather than setting errno
+	int err = ::posix_fadvise(m_fd, offset, length, advice) ;
+	if(err != 0)
+	{
+		throw(FileStreamException(std::string("Exception in advise [posix_fadvise]:").append(::strerror(err)))) ;
+	}
+}
+
+/**
+ * Allocates disk space for the specified region of the file opened by this FileStream.
+ * Preallocating a file which is to be written in full avoids fragmentation, and allows
+ * a lack of disk space to be detected before any data is written. Where the filesystem
+ * cannot allocate without writing, the space is reserved by writing zeros.
+ *
+ * @param offset the start of the region
+ * @param length the length of the region
+ * @param keep_size set true to leave the reported file size unchanged
+ * @throws FileStreamException if the space cannot be allocated
+ */
+void
+FileStream::preallocate(off_t offset, off_t length, bool keep_size) throw(FileStreamException)
+{
+	if(::fallocate(m_fd, keep_size ? FALLOC_FL_KEEP_SIZE : 0, offset, length) == 0)
+	{
+		return ;
+	}
+
+	if(errno != EOPNOTSUPP || keep_size)
+	{
+		throw(FileStreamException(std::string("Exception in preallocate [fallocate]:").append(::strerror(errno)))) ;
+	}
+
+	// filesystem cannot allocate without writing, posix_fallocate writes zeros
+	int err = ::posix_fallocate(m_fd, offset, length) ;
+	if(err != 0)
+	{
+		throw(FileStreamException(std::string("Exception in preallocate [posix_fallocate]:").append(::strerror(err)))) ;
+	}
+}
+
+
+//-------------------------------------------------------------------------------//
+// Aligned Buffers
+
+/**
+ * Allocates a buffer of the specified size aligned for direct I/O.
+ * The returned buffer must be released via releaseAligned
+ *
+ * @param size the size of the buffer
+ * @param alignment the required alignment, a power of two
+ * @return the allocated buffer
+ * @throws FileStreamException if the buffer cannot be allocated
+ */
+void*
+FileStream::allocateAligned(size_t size, size_t alignment) throw(FileStreamException)
+{
+	void* buf = 0 ;
+
+	int err = ::posix_memalign(&buf, alignment, size) ;
+	if(err != 0)
+	{
+		throw(FileStreamException(std::string("Exception in allocateAligned [posix_memalign]:").append(::strerror(err)))) ;
+	}
+
+	return(buf) ;
+}
+
+/**
+ * Releases a buffer allocated via allocateAligned
+ *
+ * @param buf the buffer to release
+ */
+void
+FileStream::releaseAligned(void* buf)
+{
+	::free(buf) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// AbstractInputStream
+
+bool
+FileStream::isDataAvailable(long usec) const throw(Exception)
+{
+	bool ret = false ;
+
+	if(isOpen())
+	{
+		::pollfd pfd[1] ;
+		pfd[0].fd = m_fd ;
+		pfd[0].events = POLLIN ;
+
+		int pollret = ::poll(pfd, 1, usec / 1000) ;
+
+		if(pollret == -1)
+		{
+			throw(FileStreamException(std::string("Exception in dataAvailable [poll]:").append(::strerror(errno)))) ;
+		}
+		else if(pollret)
+		{
+			ret = (pfd[0].revents & POLLIN) ? true : false ;
+		}
+	}
+
+	return(ret) ;
+}
+
+ssize_t
+FileStream::read(void* buf, size_t length) const throw(Exception)
+{
+	ssize_t retcode ;
+	do
+	{
+		retcode = ::read(m_fd, buf, length) ;
+	}
+	while(retcode < 0 && errno == EINTR) ;
+
+	if(retcode < 0)
+	{
+		throw(FileStreamException(std::string("Exception in read [read]:").append(::strerror(errno)))) ;
+	}
+
+	return(retcode) ;
+}
+
+ssize_t
+FileStream::read(void* buf, size_t length, int& err_code) const throw()
+{
+	ssize_t retcode ;
+	do
+	{
+		retcode = ::read(m_fd, buf, length) ;
+	}
+	while(retcode < 0 && errno == EINTR) ;
+
+	if(retcode < 0)
+	{
+		err_code = errno ;
+	}
+
+	return(retcode) ;
+}
+
+ssize_t
+FileStream::read(char& read_byte) throw(Exception)
+{
+	return(read(&read_byte, 1)) ;
+}
+
+ssize_t
+FileStream::read(char& read_byte, int& err_code) throw()
+{
+	return(read(&read_byte, 1, err_code)) ;
+}
+
+//-------------------------------------------------------------------------------//
+// AbstractOutputStream
+
+ssize_t
+FileStream::write(const void* data, size_t size) throw(Exception)
+{
+	ssize_t retcode ;
+	do
+	{
+		retcode = ::write(m_fd, data, size) ;
+	}
+	while(retcode < 0 && errno == EINTR) ;
+
+	if(retcode < 0)
+	{
+		throw(FileStreamException(std::string("Exception in write [write]:").append(::strerror(errno)))) ;
+	}
+
+	return(retcode) ;
+}
+
+ssize_t
+FileStream::write(const void* data, size_t size, int& err_code) throw()
+{
+	ssize_t written ;
+	do
+	{
+		written = ::write(m_fd, data, size) ;
+	}
+	while(written < 0 && errno == EINTR) ;
+
+	if(written < 0)
+	{
+		err_code = errno ;
+	}
+
+	return(written) ;
+}
+
+ssize_t
+FileStream::write(const char& write_byte) throw(Exception)
+{
+	return(write(&write_byte, 1)) ;
+}
+
+ssize_t
+FileStream::write(const char& write_byte, int& err_code) throw()
+{
+	return(write(&write_byte, 1, err_code)) ;
+}
+
+//-------------------------------------------------------------------------------//
+// Private Operations
+
+/**
+ * Determines the direct I/O alignment of the open file
+ *
+ */
+void
+FileStream::queryAlignment()
+{
+	m_alignment = 0 ;
+
+#ifdef STATX_DIOALIGN
+	struct statx stx ;
+	if(::statx(m_fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 && (stx.stx_mask & STATX_DIOALIGN))
+	{
+		m_alignment = stx.stx_dio_offset_align > stx.stx_dio_mem_align ? stx.stx_dio_offset_align : stx.stx_dio_mem_align ;
+	}
+#endif
+
+	if(m_alignment == 0)
+	{
+		struct stat statbuf ;
+		if(::fstat(m_fd, &statbuf) == 0 && statbuf.st_blksize > 0)
+		{
+			m_alignment = statbuf.st_blksize ;
+		}
+		else
+		{
+			m_alignment = 512 ;
+		}
+	}
+}
@@ -0,0 +1,789 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#include <cutil/FileTree.h>
+#include <cutil/Closure.h>
+#include <cutil/Condition.h>
+#include <cutil/DirectoryWalker.h>
+#include <cutil/Mutex.h>
+#include <cutil/ThreadPool.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+
+#include <linux/fs.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+
+#include <cstring>
+
+using cutil::AbstractClosure ;
+using cutil::Condition ;
+using cutil::DirectoryWalker ;
+using cutil::Exception ;
+using cutil::FilePath ;
+using cutil::FileTree ;
+using cutil::Mutex ;
+using cutil::MutexLock ;
+using cutil::ThreadPool ;
+
+namespace
+{
+	/** size of the buffer used when a file cannot be copied within the kernel */
+	const size_t COPY_BUFFER_SIZE = 128 * 1024 ;
+
+	/**
+	 * Returns the directory descriptor an entry should be accessed relative to
+	 */
+	int atDescriptor(const DirectoryWalker::Entry& entry)
+	{
+		return(entry.theDirFd >= 0 ? entry.theDirFd : AT_FDCWD) ;
+	}
+
+	/**
+	 * Returns the name an entry should be accessed by, relative to atDescriptor
+	 */
+	const char* atName(const DirectoryWalker::Entry& entry)
+	{
+		return(entry.theDirFd >= 0 ? entry.theName : entry.thePath) ;
+	}
+
+	/**
+	 * Throws an Exception describing the failure of the specified call upon the specified path
+	 */
+	void fail(const char* operation, const char* call, const char* path)
+	{
+		throw(Exception(std::string("Exception ").append(operation).append(" [").append(call).append("]:").append(::strerror(errno)).append(": ").append(path))) ;
+	}
+
+	/**
+	 * Copies the contents of one open file to another
+	 *
+	 * @param source_fd the file to copy from
+	 * @param destination_fd the empty file to copy to
+	 * @param size the size of the source file
+	 * @return the means by which the file was copied
+	 */
+	FileTree::CopyMethodEnum copyContents(int source_fd, int destination_fd, off_t size) throw(Exception)
+	{
+#ifdef FICLONE
+		if(size > 0 && ::ioctl(destination_fd, FICLONE, source_fd) == 0)
+		{
+			return(FileTree::REFLINK_ENUM) ;
+		}
+#endif
+
+		off_t copied = 0 ;
+		while(copied < size)
+		{
+			ssize_t count = ::copy_file_range(source_fd, NULL, destination_fd, NULL, size - copied, 0) ;
+			if(count == -1)
+			{
+				if(copied == 0 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP))
+				{
+					break ;
+				}
+				throw(Exception(std::string("Exception copying file [copy_file_range]:").append(::strerror(errno)))) ;
+			}
+			if(count == 0)
+			{
+				// the source was truncated while being copied
+				return(FileTree::COPY_FILE_RANGE_ENUM) ;
+			}
+			copied += count ;
+		}
+
+		if(copied > 0 || size == 0)
+		{
+			return(FileTree::COPY_FILE_RANGE_ENUM) ;
+		}
+
+		std::vector<char> buffer(COPY_BUFFER_SIZE) ;
+		for(;;)
+		{
+			ssize_t count = ::read(source_fd, &buffer[0], buffer.size()) ;
+			if(count == -1)
+			{
+				if(errno == EINTR)
+				{
+					continue ;
+				}
+				throw(Exception(std::string("Exception copying file [read]:").append(::strerror(errno)))) ;
+			}
+			if(count == 0)
+			{
+				break ;
+			}
+
+			const char* pos = &buffer[0] ;
+			while(count > 0)
+			{
+				ssize_t written = ::write(destination_fd, pos, count) ;
+				if(written == -1)
+				{
+					if(errno == EINTR)
+					{
+						continue ;
+					}
+					throw(Exception(std::string("Exception copying file [write]:").append(::strerror(errno)))) ;
+				}
+				pos += written ;
+				count -= written ;
+			}
+		}
+
+		return(FileTree::READ_WRITE_ENUM) ;
+	}
+
+	/**
+	 * Copies the regular file name, relative to dir_fd, to destination
+	 */
+	FileTree::CopyMethodEnum copyFileAt(int dir_fd, const char* name, const char* destination) throw(Exception)
+	{
+		int source_fd = ::openat(dir_fd, name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC) ;
+		if(source_fd == -1)
+		{
+			fail("copying file", "openat", name) ;
+		}
+
+		int destination_fd = -1 ;
+		FileTree::CopyMethodEnum method ;
+		try
+		{
+			struct stat statbuf ;
+			if(::fstat(source_fd, &statbuf) != 0)
+			{
+				fail("copying file", "fstat", name) ;
+			}
+
+			destination_fd = ::open(destination, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, statbuf.st_mode & 07777) ;
+			if(destination_fd == -1)
+			{
+				fail("copying file", "open", destination) ;
+			}
+
+			method = copyContents(source_fd, destination_fd, statbuf.st_size) ;
+
+			if(::fchmod(destination_fd, statbuf.st_mode & 07777) != 0)
+			{
+				fail("copying file", "fchmod", destination) ;
+			}
+		}
+		catch(...)
+		{
+			::close(source_fd) ;
+			if(destination_fd != -1)
+			{
+				::close(destination_fd) ;
+			}
+			throw ;
+		}
+
+		::close(source_fd) ;
+		if(::close(destination_fd) != 0)
+		{
+			fail("copying file", "close", destination) ;
+		}
+
+		return(method) ;
+	}
+
+	/**
+	 * Creates a directory and any missing parents
+	 *
+	 * @return the number of directories created
+	 */
+	size_t makeDirectories(const std::string& path, mode_t mode) throw(Exception)
+	{
+		if(::mkdir(path.c_str(), mode) == 0)
+		{
+			return(1) ;
+		}
+
+		if(errno == EEXIST)
+		{
+			struct stat statbuf ;
+			if(::stat(path.c_str(), &statbuf) == 0 && !S_ISDIR(statbuf.st_mode))
+			{
+				errno = ENOTDIR ;
+				fail("creating directory", "mkdir", path.c_str()) ;
+			}
+			return(0) ;
+		}
+
+		std::string::size_type pos = path.rfind(FilePath::PATH_SEPARATOR) ;
+		if(errno != ENOENT || pos == std::string::npos || pos == 0)
+		{
+			fail("creating directory", "mkdir", path.c_str()) ;
+		}
+
+		size_t created = makeDirectories(path.substr(0, pos), mode) ;
+
+		// a concurrent task may have created the directory in the meantime
+		if(::mkdir(path.c_str(), mode) == 0)
+		{
+			created++ ;
+		}
+		else if(errno != EEXIST)
+		{
+			fail("creating directory", "mkdir", path.c_str()) ;
+		}
+
+		return(created) ;
+	}
+
+	/**
+	 * Removes each entry as it is visited, and each directory as it is left
+	 */
+	class RemoveVisitor : public DirectoryWalker::Visitor
+	{
+		public:
+			RemoveVisitor() : theCount(0) {}
+
+			virtual DirectoryWalker::VisitResultEnum visit(const DirectoryWalker::Entry& entry)
+			{
+				if(entry.theType != FilePath::DIRECTORY_ENUM)
+				{
+					if(::unlinkat(atDescriptor(entry), atName(entry), 0) == 0)
+					{
+						__sync_add_and_fetch(&theCount, 1) ;
+					}
+					else if(errno != ENOENT)
+					{
+						fail("removing file", "unlinkat", entry.thePath) ;
+					}
+				}
+				return(DirectoryWalker::CONTINUE_ENUM) ;
+			}
+
+			virtual void leave(const DirectoryWalker::Entry& entry)
+			{
+				if(::unlinkat(atDescriptor(entry), atName(entry), AT_REMOVEDIR) == 0)
+				{
+					__sync_add_and_fetch(&theCount, 1) ;
+				}
+				else if(errno != ENOENT)
+				{
+					fail("removing directory", "unlinkat", entry.thePath) ;
+				}
+			}
+
+			size_t theCount ;
+	} ;
+
+	/**
+	 * Recreates each entry visited beneath the destination
+	 */
+	class CopyVisitor : public DirectoryWalker::Visitor
+	{
+		public:
+			CopyVisitor(size_t source_length, const std::string& destination)
+				: theCount(0), theSourceLength(source_length), theDestination(destination)
+			{}
+
+			virtual DirectoryWalker::VisitResultEnum visit(const DirectoryWalker::Entry& entry)
+			{
+				std::string destination(theDestination) ;
+				destination.append(entry.thePath + theSourceLength, entry.thePathLength - theSourceLength) ;
+
+				int dir_fd = atDescriptor(entry) ;
+				const char* name = atName(entry) ;
+
+				switch(entry.theType)
+				{
+					case FilePath::REGULAR_FILE_ENUM:
+						copyFileAt(dir_fd, name, destination.c_str()) ;
+						break ;
+
+					case FilePath::DIRECTORY_ENUM:
+					{
+						mode_t mode = getMode(dir_fd, name) ;
+						if(::mkdir(destination.c_str(), mode | S_IRWXU) != 0)
+						{
+							fail("copying directory", "mkdir", destination.c_str()) ;
+						}
+						if((mode & S_IRWXU) != S_IRWXU)
+						{
+							// restored once the directory has been populated
+							MutexLock lock(theMutex) ;
+							theDeferredPaths.push_back(destination) ;
+							theDeferredModes.push_back(mode) ;
+						}
+						else if(::chmod(destination.c_str(), mode) != 0)
+						{
+							// mkdir applies the umask
+							fail("copying directory", "chmod", destination.c_str()) ;
+						}
+						break ;
+					}
+
+					case FilePath::SYM_LINK_ENUM:
+					{
+						std::vector<char> target(PATH_MAX + 1) ;
+						ssize_t length = ::readlinkat(dir_fd, name, &target[0], PATH_MAX) ;
+						if(length == -1)
+						{
+							fail("copying link", "readlinkat", entry.thePath) ;
+						}
+						target[length] = '\0' ;
+						if(::symlink(&target[0], destination.c_str()) != 0)
+						{
+							fail("copying link", "symlink", destination.c_str()) ;
+						}
+						break ;
+					}
+
+					case FilePath::FIFO_ENUM:
+					{
+						mode_t mode = getMode(dir_fd, name) ;
+						if(::mkfifo(destination.c_str(), mode) != 0)
+						{
+							fail("copying fifo", "mkfifo", destination.c_str()) ;
+						}
+						if(::chmod(destination.c_str(), mode) != 0)
+						{
+							fail("copying fifo", "chmod", destination.c_str()) ;
+						}
+						break ;
+					}
+
+					default:
+						// sockets and devices are not copied
+						return(DirectoryWalker::CONTINUE_ENUM) ;
+				}
+
+				__sync_add_and_fetch(&theCount, 1) ;
+				return(DirectoryWalker::CONTINUE_ENUM) ;
+			}
+
+			/**
+			 * Applies the permission bits of directories not writable by their owner
+			 */
+			void restoreModes() throw(Exception)
+			{
+				for(size_t i = theDeferredPaths.size() ; i > 0 ; --i)
+				{
+					if(::chmod(theDeferredPaths[i - 1].c_str(), theDeferredModes[i - 1]) != 0)
+					{
+						fail("copying directory", "chmod", theDeferredPaths[i - 1].c_str()) ;
+					}
+				}
+			}
+
+			size_t theCount ;
+
+		private:
+			static mode_t getMode(int dir_fd, const char* name) throw(Exception)
+			{
+				struct stat statbuf ;
+				if(::fstatat(dir_fd, name, &statbuf, AT_SYMLINK_NOFOLLOW) != 0)
+				{
+					fail("copying", "fstatat", name) ;
+				}
+				return(statbuf.st_mode & 07777) ;
+			}
+
+			size_t theSourceLength ;
+			std::string theDestination ;
+
+			Mutex theMutex ;
+			std::vector<std::string> theDeferredPaths ;
+			std::vector<mode_t> theDeferredModes ;
+	} ;
+
+	/**
+	 * Tracks completion, results and failure of a group of tasks
+	 */
+	class TaskGroup
+	{
+		public:
+			TaskGroup() : thePending(0), theCount(0) {}
+
+			void started()
+			{
+				MutexLock lock(theMutex) ;
+				thePending++ ;
+			}
+
+			void finished(size_t count)
+			{
+				MutexLock lock(theMutex) ;
+				theCount += count ;
+				if(--thePending == 0)
+				{
+					theCondition.broadcast() ;
+				}
+			}
+
+			void failed(const std::string& error)
+			{
+				MutexLock lock(theMutex) ;
+				if(theError.empty())
+				{
+					theError = error ;
+				}
+			}
+
+			/**
+			 * Waits for all tasks to finish, rethrowing the first failure
+			 *
+			 * @return the total count of all tasks
+			 */
+			size_t wait() throw(Exception)
+			{
+				MutexLock lock(theMutex) ;
+				while(thePending > 0)
+				{
+					theCondition.wait(theMutex) ;
+				}
+				if(!theError.empty())
+				{
+					throw(Exception(theError)) ;
+				}
+				return(theCount) ;
+			}
+
+		private:
+			Mutex theMutex ;
+			Condition theCondition ;
+			size_t thePending ;
+			size_t theCount ;
+			std::string theError ;
+	} ;
+
+	/**
+	 * Task creating a contiguous range of directories
+	 */
+	class MakeDirectoriesTask : public AbstractClosure<void>
+	{
+		public:
+			MakeDirectoriesTask(TaskGroup& group, const std::vector<std::string>& paths, size_t begin, size_t end, mode_t mode)
+				: theGroup(group), thePaths(paths), theBegin(begin), theEnd(end), theMode(mode)
+			{}
+
+			virtual void operator() () const
+			{
+				size_t created = 0 ;
+				try
+				{
+					for(size_t i = theBegin ; i < theEnd ; ++i)
+					{
+						created += makeDirectories(thePaths[i], theMode) ;
+					}
+				}
+				catch(Exception& e)
+				{
+					theGroup.failed(e.toString()) ;
+				}
+				catch(...)
+				{
+					theGroup.failed("Unknown exception creating directories") ;
+				}
+
+				theGroup.finished(created) ;
+			}
+
+		private:
+			TaskGroup& theGroup ;
+			const std::vector<std::string>& thePaths ;
+			size_t theBegin ;
+			size_t theEnd ;
+			mode_t theMode ;
+	} ;
+
+	/**
+	 * Configures a walker for tree operations.
+	 * Only the immediate subdirectories of the root are fanned out across a pool, as each
+	 * is then walked wholly within a single task and left only once its subtree is complete.
+	 */
+	void configureWalker(DirectoryWalker& walker)
+	{
+		walker.setIncludeHidden(true) ;
+		walker.setFollowSymLinks(false) ;
+		walker.setParallelDepth(1) ;
+	}
+}
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates a new FileTree performing operations within the calling thread
+ *
+ */
+FileTree::FileTree()
+	: thePool(NULL), theDirectoryMode(S_IRWXU | S_IRGRP | S_IXGRP)
+{}
+
+/**
+ * Creates a new FileTree performing operations across the specified ThreadPool.
+ * The pool must outlive this FileTree, and must not be the pool executing the caller.
+ *
+ * @param pool the ThreadPool to perform operations upon
+ */
+FileTree::FileTree(ThreadPool& pool)
+	: thePool(&pool), theDirectoryMode(S_IRWXU | S_IRGRP | S_IXGRP)
+{}
+
+/**
+ * Destructor.
+ *
+ */
+FileTree::~FileTree()
+{
+	// nothing to do
+}
+
+//-------------------------------------------------------------------------------//
+// FileTree Operations
+
+/**
+ * Removes the specified path, and, if it is a directory, everything beneath it.
+ * Symbolic links are removed, not followed.
+ *
+ * @param path the file or directory to remove
+ * @return the number of entries removed, including path, 0 if path does not exist
+ * @throw Exception if an entry cannot be removed, or a system error occurs
+ */
+size_t
+FileTree::remove(const FilePath& path) throw(Exception)
+{
+	std::string root = path.getPath() ;
+
+	struct stat statbuf ;
+	if(::lstat(root.c_str(), &statbuf) != 0)
+	{
+		if(errno == ENOENT)
+		{
+			return(0) ;
+		}
+		fail("removing", "lstat", root.c_str()) ;
+	}
+
+	if(!S_ISDIR(statbuf.st_mode))
+	{
+		if(::unlink(root.c_str()) != 0)
+		{
+			fail("removing file", "unlink", root.c_str()) ;
+		}
+		return(1) ;
+	}
+
+	DirectoryWalker walker ;
+	configureWalker(walker) ;
+
+	RemoveVisitor visitor ;
+	if(thePool != NULL)
+	{
+		walker.walk(path, visitor, *thePool) ;
+	}
+	else
+	{
+		walker.walk(path, visitor) ;
+	}
+
+	if(::rmdir(root.c_str()) != 0)
+	{
+		fail("removing directory", "rmdir", root.c_str()) ;
+	}
+
+	return(visitor.theCount + 1) ;
+}
+
+/**
+ * Copies the specified file or directory tree to destination, which must not exist.
+ * Permission bits are preserved, symbolic links are copied as links, and fifos are
+ * recreated. Sockets and devices are skipped.
+ *
+ * @param source the file or directory to copy
+ * @param destination the path to copy to
+ * @return the number of entries copied, including source
+ * @throw Exception if source does not exist, destination exists, or a system error occurs
+ */
+size_t
+FileTree::copy(const FilePath& source, const FilePath& destination) throw(Exception)
+{
+	std::string root = source.getPath() ;
+	std::string target = destination.getPath() ;
+
+	struct stat statbuf ;
+	if(::lstat(root.c_str(), &statbuf) != 0)
+	{
+		fail("copying", "lstat", root.c_str()) ;
+	}
+
+	if(!S_ISDIR(statbuf.st_mode))
+	{
+		if(S_ISREG(statbuf.st_mode))
+		{
+			copyFileAt(AT_FDCWD, root.c_str(), target.c_str()) ;
+		}
+		else if(S_ISLNK(statbuf.st_mode))
+		{
+			std::vector<char> link(PATH_MAX + 1) ;
+			ssize_t length = ::readlink(root.c_str(), &link[0], PATH_MAX) ;
+			if(length == -1)
+			{
+				fail("copying link", "readlink", root.c_str()) ;
+			}
+			link[length] = '\0' ;
+			if(::symlink(&link[0], target.c_str()) != 0)
+			{
+				fail("copying link", "symlink", target.c_str()) ;
+			}
+		}
+		else
+		{
+			throw(Exception(std::string("Exception copying: source is not a file, link or directory: ").append(root))) ;
+		}
+		return(1) ;
+	}
+
+	mode_t mode = statbuf.st_mode & 07777 ;
+	if(::mkdir(target.c_str(), mode | S_IRWXU) != 0)
+	{
+		fail("copying directory", "mkdir", target.c_str()) ;
+	}
+
+	DirectoryWalker walker ;
+	configureWalker(walker) ;
+
+	CopyVisitor visitor(root.size(), target) ;
+	if(thePool != NULL)
+	{
+		walker.walk(source, visitor, *thePool) ;
+	}
+	else
+	{
+		walker.walk(source, visitor) ;
+	}
+
+	visitor.restoreModes() ;
+	if(::chmod(target.c_str(), mode) != 0)
+	{
+		fail("copying directory", "chmod", target.c_str()) ;
+	}
+
+	return(visitor.theCount + 1) ;
+}
+
+/**
+ * Creates each of the specified directories, and any missing parents, as mkdir -p.
+ * Directories which already exist are not an error.
+ *
+ * @param paths the directories to create
+ * @return the number of directories created, including parents
+ * @throw Exception if a directory cannot be created
+ */
+size_t
+FileTree::createDirectories(const std::vector<FilePath>& paths) throw(Exception)
+{
+	// sorted, so parents precede their children and neighbouring paths share parents
+	std::vector<std::string> sorted ;
+	sorted.reserve(paths.size()) ;
+	for(std::vector<FilePath>::const_iterator iter = paths.begin() ; iter != paths.end() ; ++iter)
+	{
+		if(!iter->isEmpty())
+		{
+			sorted.push_back(iter->getPath()) ;
+		}
+	}
+	std::sort(sorted.begin(), sorted.end()) ;
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end()) ;
+
+	if(thePool == NULL || sorted.size() < 2)
+	{
+		size_t created = 0 ;
+		for(std::vector<std::string>::const_iterator iter = sorted.begin() ; iter != sorted.end() ; ++iter)
+		{
+			created += makeDirectories(*iter, theDirectoryMode) ;
+		}
+		return(created) ;
+	}
+
+	size_t tasks = thePool->getThreadCount() * 4 ;
+	size_t chunk = (sorted.size() + tasks - 1) / tasks ;
+
+	TaskGroup group ;
+	for(size_t begin = 0 ; begin < sorted.size() ; begin += chunk)
+	{
+		size_t end = std::min(begin + chunk, sorted.size()) ;
+
+		group.started() ;
+		try
+		{
+			thePool->execute(new MakeDirectoriesTask(group, sorted, begin, end, theDirectoryMode)) ;
+		}
+		catch(Exception& e)
+		{
+			group.failed(e.toString()) ;
+			group.finished(0) ;
+			break ;
+		}
+	}
+
+	return(group.wait()) ;
+}
+
+/**
+ * Copies a single regular file, creating destination with the permission bits of source
+ *
+ * @param source the file to copy
+ * @param destination the file to create, which must not exist
+ * @return the means by which the file was copied
+ * @throw Exception if a system error occurs
+ */
+FileTree::CopyMethodEnum
+FileTree::copyFile(const FilePath& source, const FilePath& destination) throw(Exception)
+{
+	return(copyFileAt(AT_FDCWD, source.getPath().c_str(), destination.getPath().c_str())) ;
+}
+
+/**
+ * Sets the permission bits of directories created by createDirectories, before the umask is applied
+ *
+ * @param mode the permission bits of created directories
+ */
+void
+FileTree::setDirectoryMode(mode_t mode)
+{
+	theDirectoryMode = mode ;
+}
+
+/**
+ * Returns the permission bits of directories created by createDirectories
+ *
+ * @return the permission bits of created directories
+ */
+mode_t
+FileTree::getDirectoryMode() const
+{
+	return(theDirectoryMode) ;
+}
@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+#include <cutil/MappedFile.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using cutil::Exception ;
+using cutil::FilePath ;
+using cutil::MappedFile ;
+
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates an unmapped MappedFile
+ *
+ */
+MappedFile::MappedFile() : m_path("")
+{
+	m_access_mode = READ_ONLY_ENUM ;
+	m_data = 0 ;
+	m_size = 0 ;
+	m_mapped = false ;
+}
+
+/**
+ * Creates a MappedFile and maps the specified file
+ *
+ * @param path the file to map
+ * @param mode the access mode of the mapping
+ * @param flags or'ed MapFlagsEnum values
+ * @param length the minimum length of a READ_WRITE_ENUM mapping, the file is extended if required
+ * @throw Exception if the file cannot be mapped
+ */
+MappedFile::MappedFile(const FilePath& path, AccessModeEnum mode, int flags, size_t length) throw(Exception) : m_path(path)
+{
+	m_access_mode = mode ;
+	m_data = 0 ;
+	m_size = 0 ;
+	m_mapped = false ;
+
+	// throws Exception
+	map(path, mode, flags, length) ;
+}
+
+/**
+ * Destructor.
+ * Unmaps this MappedFile if it is mapped
+ *
+ */
+MappedFile::~MappedFile()
+{
+	unmap() ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// MappedFile Operations
+
+/**
+ * Maps the specified file
+ * Any file already mapped by this MappedFile is first unmapped. A READ_WRITE_ENUM mapping
+ * creates the file if it does not exist, and extends the file to length if it is shorter.
+ * An empty file may be mapped, in which case getData returns NULL and getSize returns 0.
+ *
+ * @param path the file to map
+ * @param mode the access mode of the mapping
+ * @param flags or'ed MapFlagsEnum values
+ * @param length the minimum length of a READ_WRITE_ENUM mapping, the file is extended if required
+ * @throw Exception if the file cannot be mapped
+ */
+void
+MappedFile::map(const FilePath& path, AccessModeEnum mode, int flags, size_t length) throw(Exception)
+{
+	unmap() ;
+
+	int fd ;
+	if(mode == READ_WRITE_ENUM)
+	{
+		fd = ::open(path.getPath().c_str(), O_RDWR|O_CREAT|O_CLOEXEC, 0666) ;
+	}
+	else
+	{
+		fd = ::open(path.getPath().c_str(), O_RDONLY|O_CLOEXEC) ;
+	}
+
+	if(fd < 0)
+	{
+		throw(Exception(std::string("Exception in map [open]:").append(path.getPath()).append(": ").append(::strerror(errno)))) ;
+	}
+
+	struct stat statbuf ;
+	if(::fstat(fd, &statbuf) != 0)
+	{
+		int err = errno ;
+		::close(fd) ;
+		throw(Exception(std::string("Exception in map [fstat]:").append(::strerror(err)))) ;
+	}
+
+	size_t size = statbuf.st_size ;
+	if(mode == READ_WRITE_ENUM && length > size)
+	{
+		if(::ftruncate(fd, length) != 0)
+		{
+			int err = errno ;
+			::close(fd) ;
+			throw(Exception(std::string("Exception in map [ftruncate]:").append(::strerror(err)))) ;
+		}
+		size = length ;
+	}
+
+	char* data = 0 ;
+	if(size > 0)
+	{
+		int prot = PROT_READ ;
+		if(mode == READ_WRITE_ENUM)
+		{
+			prot |= PROT_WRITE ;
+		}
+
+		int map_flags = MAP_SHARED ;
+		if(flags & MAP_POPULATE_ENUM)
+		{
+			map_flags |= MAP_POPULATE ;
+		}
+		if(flags & MAP_LOCKED_ENUM)
+		{
+			map_flags |= MAP_LOCKED ;
+		}
+
+		void* addr = ::mmap(0, size, prot, map_flags, fd, 0) ;
+		if(addr == MAP_FAILED)
+		{
+			int err = errno ;
+			::close(fd) ;
+			throw(Exception(std::string("Exception in map [mmap]:").append(::strerror(err)))) ;
+		}
+		data = static_cast<char*>(addr) ;
+
+		if(flags & MAP_HUGE_PAGES_ENUM)
+		{
+			// best effort, file backed huge pages depend upon the kernel and filesystem
+			::madvise(addr, size, MADV_HUGEPAGE) ;
+		}
+	}
+
+	// the mapping holds its own reference to the file
+	::close(fd) ;
+
+	m_path = path ;
+	m_access_mode = mode ;
+	m_data = data ;
+	m_size = size ;
+	m_mapped = true ;
+}
+
+/**
+ * Unmaps this MappedFile
+ * Changes to a READ_WRITE_ENUM mapping remain in the page cache and are written back by the kernel.
+ * If this MappedFile is not mapped, no action is taken.
+ *
+ */
+void
+MappedFile::unmap()
+{
+	if(m_mapped)
+	{
+		if(m_data)
+		{
+			::munmap(m_data, m_size) ;
+		}
+
+		m_data = 0 ;
+		m_size = 0 ;
+		m_mapped = false ;
+	}
+}
+
+/**
+ * Advises the kernel of the expected access pattern of a region of this MappedFile.
+ * A length of 0 extends the region to the end of the mapping.
+ *
+ * @param advice the expected access pattern
+ * @param offset the start of the region, rounded down to a page boundary
+ * @param length the length of the region
+ * @throw Exception if this MappedFile is not mapped, or the advice is rejected
+ */
+void
+MappedFile::advise(AdviceEnum advice, size_t offset, size_t length) throw(Exception)
+{
+	if(!m_mapped)
+	{
+		throw(Exception("Cannot advise an unmapped MappedFile")) ;
+	}
+
+	if(offset >= m_size)
+	{
+		return ;
+	}
+
+	if(length == 0 || length > m_size - offset)
+	{
+		length = m_size - offset ;
+	}
+
+	int kernel_advice ;
+	switch(advice)
+	{
+		case MappedFile::ADVICE_SEQUENTIAL_ENUM:
+		{
+			kernel_advice = MADV_SEQUENTIAL ;
+			break ;
+		}
+		case MappedFile::ADVICE_RANDOM_ENUM:
+		{
+			kernel_advice = MADV_RANDOM ;
+			break ;
+		}
+		case MappedFile::ADVICE_WILL_NEED_ENUM:
+		{
+			kernel_advice = MADV_WILLNEED ;
+			break ;
+		}
+		case MappedFile::ADVICE_DONT_NEED_ENUM:
+		{
+			kernel_advice = MADV_DONTNEED ;
+			break ;
+		}
+		case MappedFile::ADVICE_NORMAL_ENUM:
+		default:
+		{
+			kernel_advice = MADV_NORMAL ;
+			break ;
+		}
+	}
+
+	// madvise requires a page aligned start address
+	size_t page_size = ::sysconf(_SC_PAGESIZE) ;
+	size_t start = offset - (offset % page_size) ;
+
+	if(::madvise(m_data + start, length + (offset - start), kernel_advice) != 0)
+	{
+		throw(Exception(std::string("Exception in advise [madvise]:").append(::strerror(errno)))) ;
+	}
+}
+
+/**
+ * Flushes changes to a READ_WRITE_ENUM mapping to the storage device
+ *
+ * @param wait set false to schedule the write back without waiting for it to complete
+ * @throw Exception if this MappedFile is not mapped, or the changes cannot be flushed
+ */
+void
+MappedFile::sync(bool wait) throw(Exception)
+{
+	if(!m_mapped)
+	{
+		throw(Exception("Cannot sync an unmapped MappedFile")) ;
+	}
+
+	if(m_data && ::msync(m_data, m_size, wait ? MS_SYNC : MS_ASYNC) != 0)
+	{
+		throw(Exception(std::string("Exception in sync [msync]:").append(::strerror(errno)))) ;
+	}
+}
+
+
+//-------------------------------------------------------------------------------//
+// General Accessors/Murators
+
+/**
+ * Returns whether this MappedFile is currently mapped
+ *
+ * @return true if this MappedFile is mapped, false otherwise
+ */
+bool
+MappedFile::isMapped() const
+{
+	return(m_mapped) ;
+}
+
+/**
+ * Returns the FilePath this MappedFile was last mapped from
+ *
+ * @return the FilePath of this MappedFile
+ */
+FilePath
+MappedFile::getPath() const
+{
+	return(m_path) ;
+}
+
+/**
+ * Returns the access mode of this MappedFile
+ *
+ * @return the access mode of this MappedFile
+ */
+MappedFile::AccessModeEnum
+MappedFile::getMode() const
+{
+	return(m_access_mode) ;
+}
+
+/**
+ * Returns the start of the mapped data
+ *
+ * @return the mapped data, or NULL if not mapped or the file is empty
+ */
+const char*
+MappedFile::getData() const
+{
+	return(m_data) ;
+}
+
+/**
+ * Returns the start of the mapped data for modification.
+ * Only a READ_WRITE_ENUM mapping may be modified, writing to a READ_ONLY_ENUM mapping raises SIGSEGV.
+ *
+ * @return the mapped data, or NULL if not mapped or the file is empty
+ */
+char*
+MappedFile::getData()
+{
+	return(m_data) ;
+}
+
+/**
+ * Returns the length of the mapped data
+ *
+ * @return the length of the mapped data in bytes
+ */
+size_t
+MappedFile::getSize() const
+{
+	return(m_size) ;
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+#include <cutil/MappedFileInputStream.h>
+#include <cutil/MappedFile.h>
+
+#include <cstring>
+
+using cutil::Exception ;
+using cutil::MappedFile ;
+using cutil::MappedFileInputStream ;
+
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates a new MappedFileInputStream reading from the start of the specified MappedFile
+ *
+ * @param file the MappedFile to read from
+ */
+MappedFileInputStream::MappedFileInputStream(const MappedFile& file) : m_file(file)
+{
+	m_position = 0 ;
+}
+
+/**
+ * Destructor.
+ *
+ */
+MappedFileInputStream::~MappedFileInputStream()
+{}
+
+
+//-------------------------------------------------------------------------------//
+// MappedFileInputStream Operations
+
+/**
+ * Returns the current read position within the MappedFile
+ *
+ * @return the current read position
+ */
+size_t
+MappedFileInputStream::getPosition() const
+{
+	return(m_position) ;
+}
+
+/**
+ * Sets the current read position within the MappedFile.
+ * Positions beyond the end of the MappedFile are limited to the end of the MappedFile
+ *
+ * @param position the new read position
+ */
+void
+MappedFileInputStream::setPosition(size_t position)
+{
+	m_position = position < m_file.getSize() ? position : m_file.getSize() ;
+}
+
+/**
+ * Returns the number of bytes remaining to be read
+ *
+ * @return the number of bytes remaining to be read
+ */
+size_t
+MappedFileInputStream::getRemaining() const
+{
+	return(m_position < m_file.getSize() ? m_file.getSize() - m_position : 0) ;
+}
+
+/**
+ * Returns the mapped data at the current read position without copying it.
+ * The read position is not changed, use setPosition to consume the data.
+ *
+ * @return the mapped data at the current read position, or NULL if no data remains
+ */
+const char*
+MappedFileInputStream::peek() const
+{
+	return(getRemaining() ? m_file.getData() + m_position : 0) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// AbstractInputStream
+
+bool
+MappedFileInputStream::isDataAvailable(long) const throw(Exception)
+{
+	return(getRemaining() > 0) ;
+}
+
+ssize_t
+MappedFileInputStream::read(void* buf, size_t length) const throw(Exception)
+{
+	size_t remaining = getRemaining() ;
+	if(length > remaining)
+	{
+		length = remaining ;
+	}
+
+	if(length)
+	{
+		::memcpy(buf, m_file.getData() + m_position, length) ;
+		m_position += length ;
+	}
+
+	return(length) ;
+}
+
+ssize_t
+MappedFileInputStream::read(void* buf, size_t length, int&) const throw()
+{
+	return(read(buf, length)) ;
+}
+
+ssize_t
+MappedFileInputStream::read(char& read_byte) throw(Exception)
+{
+	return(read(&read_byte, 1)) ;
+}
+
+ssize_t
+MappedFileInputStream::read(char& read_byte, int& err_code) throw()
+{
+	return(read(&read_byte, 1, err_code)) ;
+}
@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#include <cutil/MemoryStateHandler.h>
+
+#include <cutil/MemoryStateNode.h>
+#include <cutil/RefCountPtr.h>
+#include <cutil/StateNode.h>
+
+#include <cstdlib>
+#include <list>
+#include <string>
+#include <vector>
+
+using cutil::MemoryStateHandler ;
+using cutil::MemoryStateNode ;
+using cutil::RefCountPtr ;
+using cutil::StateNode ;
+
+//---------------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Constructs a new MemoryStateHandler with an empty state tree
+ */
+MemoryStateHandler::MemoryStateHandler()
+		: theRoot(new MemoryStateNode::NodeData("/"))
+{}
+
+/**
+ * Destructor
+ */
+MemoryStateHandler::~MemoryStateHandler()
+{}
+
+
+//---------------------------------------------------------------------------------------//
+// StateHandler implementations
+
+/**
+ * Initialize this StateHandler.
+ * A MemoryStateHandler requires no initialization
+ */
+void
+MemoryStateHandler::initialize()
+{}
+
+/**
+ * Shutdown this StateHandler.
+ * A MemoryStateHandler has no resources to release, the state tree remains available
+ */
+void
+MemoryStateHandler::shutdown()
+{}
+
+//---------------------------------------------------------------------------------------//
+// Update Control
+
+/**
+ * Force a write of state information back to the persistant store
+ * A MemoryStateHandler has no persistant store, use exportState to write the state
+ * information to another StateHandler
+ */
+void
+MemoryStateHandler::flush()
+{}
+
+/**
+ * Synchronize this StateHandler to the persistant store of state information,
+ * A MemoryStateHandler has no persistant store, use importState to read the state
+ * information of another StateHandler
+ */
+void
+MemoryStateHandler::sync()
+{}
+
+
+//---------------------------------------------------------------------------------------//
+// StateNode Access
+
+/**
+ * Returns the root StateNode within the state tree of this StateHandler
+ * This method returns a user handle for the underlying data of the StateNode
+ * implementation. Subsequent calls to getRootNode need not return the same
+ * handle instance, however, it is guaranteed that each will be a handle to
+ * the same underlying data instance.
+ *
+ * @return the root StateNode within the state tree of this StateHandler
+ */
+RefCountPtr<StateNode>
+MemoryStateHandler::getRootNode()
+{
+	RefCountPtr<StateNode> rootNode(new MemoryStateNode(theRoot, theRoot)) ;
+	return(rootNode) ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// Import / Export
+
+/**
+ * Replaces the state tree of this MemoryStateHandler with a copy of the state tree
+ * of the specified StateHandler.
+ * Values of another MemoryStateHandler keep their set types. Other values are imported
+ * as strings, converted once on import as the source StateHandler would convert them
+ * on access. Handles to StateNodes of the replaced state tree no longer form part of the
+ * state tree.
+ *
+ * @param source the initialized StateHandler to import
+ */
+void
+MemoryStateHandler::importState(StateHandler& source)
+{
+	RefCountPtr<MemoryStateNode::NodeData> root(new MemoryStateNode::NodeData("/")) ;
+
+	// the new tree is built aside, so the current tree is unchanged should the source throw
+	MemoryStateNode rootNode(root, root) ;
+	RefCountPtr<StateNode> sourceRoot = source.getRootNode() ;
+	importNode(*(sourceRoot.getPtr()), rootNode) ;
+
+	// the import itself is not counted as modification
+	root->theModificationCount = 0 ;
+	theRoot = root ;
+}
+
+/**
+ * Copies the state tree of this MemoryStateHandler into the specified StateHandler.
+ * Each value is set in the type it was set with. Values and StateNodes of target not
+ * within this state tree are left unchanged. The target is not flushed.
+ *
+ * @param target the initialized StateHandler to export to
+ */
+void
+MemoryStateHandler::exportState(StateHandler& target)
+{
+	RefCountPtr<StateNode> targetRoot = target.getRootNode() ;
+	exportNode(*(theRoot.getPtr()), *(targetRoot.getPtr())) ;
+}
+
+/**
+ * Returns the number of modifications made to the state tree since it was constructed
+ * or imported. A modification is a value stored or removed, or a StateNode created
+ * or removed. The count may be compared with an earlier count to detect modification.
+ *
+ * @return the number of modifications made to the state tree
+ */
+unsigned long
+MemoryStateHandler::getModificationCount() const
+{
+	return(theRoot->theModificationCount) ;
+}
+
+/**
+ * Copies the values and child StateNodes of from into to, recursively.
+ * Values of a MemoryStateNode are copied in their set types, other values are copied
+ * as strings, converted once to each type as the source StateNode would convert them.
+ *
+ * @param from the StateNode to copy from
+ * @param to the StateNode to copy to
+ */
+void
+MemoryStateHandler::importNode(StateNode& from, MemoryStateNode& to)
+{
+	std::list<std::string> names ;
+	from.getValueNames(names) ;
+
+	const MemoryStateNode* memory = dynamic_cast<const MemoryStateNode*>(&from) ;
+	for(std::list<std::string>::const_iterator citer = names.begin(); citer != names.end(); ++citer)
+	{
+		if(memory)
+		{
+			to.storeValue(*citer, *(memory->findValue(*citer))) ;
+		}
+		else
+		{
+			MemoryStateNode::Value value ;
+			value.theString = from.getString(*citer, "") ;
+			value.theInt = atoi(value.theString.c_str()) ;
+			value.theDouble = strtod(value.theString.c_str(), 0) ;
+			value.theBool = (value.theString == "true") ;
+			value.theConvertedFlag = true ;
+
+			to.storeValue(*citer, value) ;
+		}
+	}
+
+	std::list<std::string> children ;
+	from.getChildren(children) ;
+	for(std::list<std::string>::const_iterator citer = children.begin(); citer != children.end(); ++citer)
+	{
+		RefCountPtr<StateNode> fromChild = from.getChild(*citer) ;
+		RefCountPtr<StateNode> toChild = to.getChild(*citer) ;
+		importNode(*(fromChild.getPtr()), static_cast<MemoryStateNode&>(*(toChild.getPtr()))) ;
+	}
+}
+
+/**
+ * Copies the values and child StateNodes of from into to, recursively, in their set types
+ *
+ * @param from the StateNode data to copy from
+ * @param to the StateNode to copy to
+ */
+void
+MemoryStateHandler::exportNode(const MemoryStateNode::NodeData& from, StateNode& to)
+{
+	for(std::vector<std::string>::const_iterator citer = from.theValueOrder.begin(); citer != from.theValueOrder.end(); ++citer)
+	{
+		const MemoryStateNode::Value& value = from.theValues.find(*citer)->second ;
+		switch(value.theType)
+		{
+			case MemoryStateNode::INT_VALUE:
+				to.setInt(*citer, value.theInt) ;
+				break ;
+
+			case MemoryStateNode::DOUBLE_VALUE:
+				to.setDouble(*citer, value.theDouble) ;
+				break ;
+
+			case MemoryStateNode::BOOL_VALUE:
+				to.setBool(*citer, value.theBool) ;
+				break ;
+
+			default:
+				to.setString(*citer, value.theString) ;
+				break ;
+		}
+	}
+
+	for(std::vector<std::string>::const_iterator citer = from.theChildOrder.begin(); citer != from.theChildOrder.end(); ++citer)
+	{
+		RefCountPtr<StateNode> toChild = to.getChild(*citer) ;
+		exportNode(*(from.theChildren.find(*citer)->second.getPtr()), *(toChild.getPtr())) ;
+	}
+}
@@ -0,0 +1,486 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#include <cutil/MemoryStateNode.h>
+
+#include <cutil/RefCountPtr.h>
+#include <cutil/StateNode.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using cutil::MemoryStateNode ;
+using cutil::RefCountPtr ;
+using cutil::StateNode ;
+
+//---------------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Constructs a new handle to the specified StateNode data, within the state tree of root
+ *
+ * @param root the root of the state tree
+ * @param data the StateNode data
+ */
+MemoryStateNode::MemoryStateNode(RefCountPtr<NodeData> root, RefCountPtr<NodeData> data)
+		: theRoot(root), theData(data)
+{}
+
+/**
+ * Destructor
+ */
+MemoryStateNode::~MemoryStateNode()
+{
+	// nothing to do
+	// ... the data is released with the last handle, or its removal from the state tree
+}
+
+
+//---------------------------------------------------------------------------------------//
+// State Tree Handling
+
+/**
+ * Returns the parent StateNode of this StateNode.
+ * If the parent StateNode does not exist, or this StateNode has been removed from the
+ * state tree, the returned RefCountPtr will point to 0.
+ *
+ * This method returns a user handle for the underlying data of the StateNode
+ * implementation. Subsequent calls to getParent need not return the same
+ * handle instance, however, it is guaranteed that each will be a handle to
+ * the same underlying data instance.
+ *
+ * @return the parent StateNode to this StateNode
+ */
+RefCountPtr<StateNode>
+MemoryStateNode::getParent()
+{
+	RefCountPtr<StateNode> parent ;
+
+	std::list<std::string> segments ;
+	breakPath(theData->thePath, segments) ;
+
+	if(!segments.empty())
+	{
+		std::string name = segments.back() ;
+		segments.pop_back() ;
+
+		// the parent is found from the root, as this StateNode may have been removed from the tree
+		RefCountPtr<NodeData> data = findNode(theRoot, segments, false) ;
+		if(data.hasPtr())
+		{
+			ChildContainer_t::const_iterator citer = data->theChildren.find(name) ;
+			if((citer != data->theChildren.end()) && (citer->second == theData))
+			{
+				parent.bind(new MemoryStateNode(theRoot, data)) ;
+			}
+		}
+	}
+
+	return(parent) ;
+}
+
+/**
+ * Returns thenamed child StateHandler from the state tree below this StateHandler,
+ * If the child StateNode does not yet exist, it is created and returned, creating any
+ * parent nodes as required.
+ * The child node is specified by a '/' separated path, indicating parent StateNodes.
+ *
+ * This method returns a user handle for the underlying data of the StateNode
+ * implementation. Subsequent calls to getChild need not return the same
+ * handle instance, however, it is guaranteed that each will be a handle to
+ * the same underlying data instance.
+ *
+ * @param childPath the path to the child node
+ * @return the specified child node
+ */
+RefCountPtr<StateNode>
+MemoryStateNode::getChild(std::string childPath)
+{
+	std::list<std::string> segments ;
+	breakPath(childPath, segments) ;
+
+	RefCountPtr<NodeData> data = findNode(theData, segments, false) ;
+	if(!data.hasPtr())
+	{
+		data = findNode(theData, segments, true) ;
+		modified() ;
+	}
+
+	RefCountPtr<StateNode> child(new MemoryStateNode(theRoot, data)) ;
+	return(child) ;
+}
+
+/**
+ * Removes the specified child StateNode from the state tree.
+ * The specified child Statehandler must be below this StateNode within the state tree
+ * Handles to the removed StateNode, or those below it, remain valid, however they
+ * no longer form part of the state tree.
+ *
+ * @param childPath the path to the child StateNode to remove
+ */
+void
+MemoryStateNode::removeChild(std::string childPath)
+{
+	std::list<std::string> segments ;
+	breakPath(childPath, segments) ;
+
+	if(!segments.empty())
+	{
+		std::string name = segments.back() ;
+		segments.pop_back() ;
+
+		RefCountPtr<NodeData> data = findNode(theData, segments, false) ;
+		if(data.hasPtr() && (data->theChildren.erase(name) > 0))
+		{
+			std::vector<std::string>& order = data->theChildOrder ;
+			order.erase(std::find(order.begin(), order.end(), name)) ;
+			modified() ;
+		}
+	}
+}
+
+/**
+ * Returns true of this StateNode contains the specified Child StateNode
+ *
+ * @param childPath the path of the specified child StateNode
+ * @return true if thie StateNode contains th specified StateNode
+ */
+bool
+MemoryStateNode::hasChild(const std::string& childPath)
+{
+	std::list<std::string> segments ;
+	breakPath(childPath, segments) ;
+
+	return(!segments.empty() && findNode(theData, segments, false).hasPtr()) ;
+}
+
+/**
+ * Populate the specified list with all the child StateNode names directly below this StateNode in the state tree
+ * The list is not cleared prior to any additions
+ *
+ * @param childList the list to populate
+ * @return the number of elements added to the list
+ */
+int
+MemoryStateNode::getChildren(std::list<std::string>& childList)
+{
+	childList.insert(childList.end(), theData->theChildOrder.begin(), theData->theChildOrder.end()) ;
+	return(static_cast<int>(theData->theChildOrder.size())) ;
+}
+
+/**
+ * Returns the complete path of this StateNode starting at the root '/'
+ *
+ * @return the complete path of this StateNode
+ */
+const std::string&
+MemoryStateNode::getPath() const
+{
+	return(theData->thePath) ;
+}
+
+//---------------------------------------------------------------------------------------//
+// State Handling
+
+/**
+ * Stores the specified value string within this StateHandler associated with the specified name string
+ *
+ * @param name name with which the specified value will be associated
+ * @param value the string value to store with the specified name
+ */
+void
+MemoryStateNode::setString(const std::string& name, const std::string& value)
+{
+	Value v ;
+	v.theType = STRING_VALUE ;
+	v.theString = value ;
+
+	storeValue(name, v) ;
+}
+
+/**
+ * Stores the specified int value within this StateHandler associated with the specified name string
+ *
+ * @param name name with which the specified value will be associated
+ * @param value the int value to store with the specified name
+ */
+void
+MemoryStateNode::setInt(const std::string& name, int value)
+{
+	std::ostringstream buf ;
+	buf << value ;
+
+	Value v ;
+	v.theType = INT_VALUE ;
+	v.theInt = value ;
+	v.theString = buf.str() ;
+
+	storeValue(name, v) ;
+}
+
+/**
+ * Stores the specified double value within this StateHandler associated with the specified name string
+ *
+ * @param name name with which the specified value will be associated
+ * @param value the double value to store with the specified name
+ */
+void
+MemoryStateNode::setDouble(const std::string& name, double value)
+{
+	std::ostringstream buf ;
+	buf << value ;
+
+	Value v ;
+	v.theType = DOUBLE_VALUE ;
+	v.theDouble = value ;
+	v.theString = buf.str() ;
+
+	storeValue(name, v) ;
+}
+
+/**
+ * Stores the specified bool value within this StateHandler associated with the specified name string
+ *
+ * @param name name with which the specified value will be associated
+ * @param value the bool value to store with the specified name
+ */
+void
+MemoryStateNode::setBool(const std::string& name, bool value)
+{
+	Value v ;
+	v.theType = BOOL_VALUE ;
+	v.theBool = value ;
+	v.theString = (value ? "true" : "false") ;
+
+	storeValue(name, v) ;
+}
+
+
+
+/**
+ * Returns the specified string value associated with the specified name from this StateHandler.
+ * If the specified name is not found, the specified default value will be returned
+ *
+ * @param name the name with which the value is associated
+ * @param def the default value if the specified name cannot be found
+ * @return the string value associated with the specified name
+ */
+std::string
+MemoryStateNode::getString(const std::string& name, const std::string& def) const
+{
+	const Value* value = findValue(name) ;
+	return(value ? value->theString : def) ;
+}
+
+/**
+ * Returns the specified int value associated with the specified name from this StateHandler.
+ * If the specified name is not found the specified default value will be returned
+ *
+ * @param name the name with which the value is associated
+ * @param def the default value if the specified name cannot be found
+ * @return the int value associated with the specified name
+ */
+int
+MemoryStateNode::getInt(const std::string& name, int def) const
+{
+	int ret = def ;
+
+	const Value* value = findValue(name) ;
+	if(value)
+	{
+		ret = ((value->theType == INT_VALUE) || value->theConvertedFlag) ? value->theInt : atoi(value->theString.c_str()) ;
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Returns the specified double value associated with the specified name from this StateHandler.
+ * If the specified name is not found the specified default value will be returned
+ *
+ * @param name the name with which the value is associated
+ * @param def the default value if the specified name cannot be found
+ * @return the double value associated with the specified name
+ */
+double
+MemoryStateNode::getDouble(const std::string& name, double def) const
+{
+	double ret = def ;
+
+	const Value* value = findValue(name) ;
+	if(value)
+	{
+		ret = ((value->theType == DOUBLE_VALUE) || value->theConvertedFlag) ? value->theDouble : strtod(value->theString.c_str(), 0) ;
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Returns the specified bool value associated with the specified name from this StateHandler.
+ * If the specified name is not found the specified default value will be returned
+ *
+ * @param name the name with which the value is associated
+ * @param def the default value if the specified name cannot be found
+ * @return the bool value associated with the specified name
+ */
+bool
+MemoryStateNode::getBool(const std::string& name, bool def) const
+{
+	bool ret = def ;
+
+	const Value* value = findValue(name) ;
+	if(value)
+	{
+		ret = ((value->theType == BOOL_VALUE) || value->theConvertedFlag) ? value->theBool : (value->theString == "true") ;
+	}
+
+	return(ret) ;
+}
+
+
+
+/**
+ * Removed the specified name value pair from this StateHandler
+ *
+ * @param name name of the name value pair to remove
+ */
+void
+MemoryStateNode::removeValue(const std::string& name)
+{
+	if(theData->theValues.erase(name) > 0)
+	{
+		std::vector<std::string>& order = theData->theValueOrder ;
+		order.erase(std::find(order.begin(), order.end(), name)) ;
+		modified() ;
+	}
+}
+
+/**
+ * Populate the specified list with the names of all values stored within this StateNode
+ * The list is not cleared prior to any additions
+ *
+ * @param nameList the list to populate
+ * @return the number of elements added to the list
+ */
+int
+MemoryStateNode::getValueNames(std::list<std::string>& nameList)
+{
+	nameList.insert(nameList.end(), theData->theValueOrder.begin(), theData->theValueOrder.end()) ;
+	return(static_cast<int>(theData->theValueOrder.size())) ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// Helper Methods
+
+/**
+ * Returns the StateNode data at the specified path below data, creating the StateNodes
+ * along the path if create is set
+ *
+ * @param data the StateNode data from which the path is followed
+ * @param pathSegments the segments of the path below data
+ * @param create set true to create missing StateNodes
+ * @return the StateNode data at the path, or an empty RefCountPtr if not found and not created
+ */
+RefCountPtr<MemoryStateNode::NodeData>
+MemoryStateNode::findNode(RefCountPtr<NodeData> data, const std::list<std::string>& pathSegments, bool create)
+{
+	RefCountPtr<NodeData> node = data ;
+
+	for(std::list<std::string>::const_iterator citer = pathSegments.begin(); (citer != pathSegments.end()) && node.hasPtr(); ++citer)
+	{
+		ChildContainer_t::const_iterator child = node->theChildren.find(*citer) ;
+		if(child != node->theChildren.end())
+		{
+			node = child->second ;
+		}
+		else if(create)
+		{
+			std::string path = node->thePath ;
+			if(path != "/")
+			{
+				path.append("/") ;
+			}
+			path.append(*citer) ;
+
+			RefCountPtr<NodeData> created(new NodeData(path)) ;
+			node->theChildren.insert(ChildContainer_t::value_type(*citer, created)) ;
+			node->theChildOrder.push_back(*citer) ;
+			node = created ;
+		}
+		else
+		{
+			node.clear() ;
+		}
+	}
+
+	return(node) ;
+}
+
+/**
+ * Stores the specified Value, replacing any existing value of the same name
+ *
+ * @param name the name of the value
+ * @param value the value
+ */
+void
+MemoryStateNode::storeValue(const std::string& name, const Value& value)
+{
+	std::pair<ValueContainer_t::iterator, bool> inserted = theData->theValues.insert(ValueContainer_t::value_type(name, value)) ;
+	if(inserted.second)
+	{
+		theData->theValueOrder.push_back(name) ;
+	}
+	else
+	{
+		inserted.first->second = value ;
+	}
+
+	modified() ;
+}
+
+/**
+ * Returns the named Value, or 0 if no value is stored with the name
+ *
+ * @param name the name of the value
+ * @return the named Value, or 0
+ */
+const MemoryStateNode::Value*
+MemoryStateNode::findValue(const std::string& name) const
+{
+	ValueContainer_t::const_iterator citer = theData->theValues.find(name) ;
+	return((citer != theData->theValues.end()) ? &(citer->second) : 0) ;
+}
+
+/**
+ * Counts a modification of the state tree
+ */
+void
+MemoryStateNode::modified()
+{
+	theRoot->theModificationCount++ ;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+#include <cutil/Mutex.h>
+
+#include <cstring>
+#include <string>
+
+using cutil::Exception ;
+using cutil::Mutex ;
+
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates a new unlocked Mutex
+ *
+ * @throw Exception if the mutex cannot be initialised
+ */
+Mutex::Mutex() throw(Exception)
+{
+	int err = ::pthread_mutex_init(&theMutex, 0) ;
+	if(err != 0)
+	{
+		throw(Exception(std::string("Exception in Mutex [pthread_mutex_init]:").append(::strerror(err)))) ;
+	}
+}
+
+/**
+ * Destructor.
+ * The Mutex must not be locked when destroyed
+ *
+ */
+Mutex::~Mutex()
+{
+	::pthread_mutex_destroy(&theMutex) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// Mutex Operations
+
+/**
+ * Locks this Mutex, blocking until it becomes available
+ *
+ * @throw Exception if the mutex cannot be locked
+ */
+void
+Mutex::lock() throw(Exception)
+{
+	int err = ::pthread_mutex_lock(&theMutex) ;
+	if(err != 0)
+	{
+		throw(Exception(std::string("Exception in lock [pthread_mutex_lock]:").append(::strerror(err)))) ;
+	}
+}
+
+/**
+ * Attempts to lock this Mutex without blocking
+ *
+ * @return true if this Mutex was locked, false if it is held by another thread
+ */
+bool
+Mutex::tryLock()
+{
+	return(::pthread_mutex_trylock(&theMutex) == 0) ;
+}
+
+/**
+ * Unlocks this Mutex
+ *
+ * @throw Exception if the mutex cannot be unlocked
+ */
+void
+Mutex::unlock() throw(Exception)
+{
+	int err = ::pthread_mutex_unlock(&theMutex) ;
+	if(err != 0)
+	{
+		throw(Exception(std::string("Exception in unlock [pthread_mutex_unlock]:").append(::strerror(err)))) ;
+	}
+}
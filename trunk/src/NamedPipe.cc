@@ -22,13 +22,17 @@
 #include <cutil/NamedPipe.h>
 
 #include <cerrno>
+#include <climits>
 #include <cstring>
+#include <ctime>
 #include <string>
 #include <sstream>
 
+#include <sys/inotify.h>
 #include <sys/poll.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include <fcntl.h>
 #include <unistd.h>
@@ -36,6 +40,41 @@
 using cutil::NamedPipe ;
 using cutil::NamedPipeException ;
 
+namespace
+{
+	/** maximum milli seconds open waits between attempts, a blocking reader raises no open notification */
+	const int OPEN_RETRY_MSEC = 10 ;
+
+	/**
+	 * Converts or'ed NamedPipe::TransferFlagsEnum values into SPLICE_F_* flags
+	 *
+	 */
+	unsigned int
+	toSpliceFlags(int flags)
+	{
+		unsigned int ret = 0 ;
+
+		if(flags & NamedPipe::TRANSFER_MOVE_ENUM)
+		{
+			ret |= SPLICE_F_MOVE ;
+		}
+		if(flags & NamedPipe::TRANSFER_NONBLOCK_ENUM)
+		{
+			ret |= SPLICE_F_NONBLOCK ;
+		}
+		if(flags & NamedPipe::TRANSFER_MORE_ENUM)
+		{
+			ret |= SPLICE_F_MORE ;
+		}
+		if(flags & NamedPipe::TRANSFER_GIFT_ENUM)
+		{
+			ret |= SPLICE_F_GIFT ;
+		}
+
+		return(ret) ;
+	}
+}
+
 
 //-------------------------------------------------------------------------------//
 // Constructor / Desctructor
@@ -52,7 +91,8 @@ NamedPipe::NamedPipe()
 	m_fd = -1 ;
 	m_created = false ;
 	m_access_mode = READ_ONLY_ENUM ;
-	m_blocking = false ;
+	m_blocking = true ;
+	m_notify_fd = -1 ;
 }
 
 /**
@@ -72,6 +112,7 @@ NamedPipe::NamedPipe(const std::string& path, AccessModeEnum mode, bool blocking
 	m_created = false ;
 	m_access_mode = mode ;
 	m_blocking = blocking ;
+	m_notify_fd = -1 ;
 
 	// throws NamedPipeException
 	create() ;
@@ -83,6 +124,8 @@ NamedPipe::NamedPipe(const std::string& path, AccessModeEnum mode, bool blocking
  */
 NamedPipe::~NamedPipe()
 {
+	releaseOpenNotify() ;
+
 	try
 	{
 		close() ;
@@ -166,7 +209,7 @@ NamedPipe::create() throw(NamedPipeException)
  * Attempts to open this NamedPipe
  * Care should be taken to setup this NamedPipe as required before calling open, for instance
  * if non-blocking, the read end of the NamedPipe must be opened prior to the write end. If
- * non-blocking, a call to open will normally block until both the read and write end are opened.
+ * blocking, a call to open will normally block until both the read and write end are opened.
  * If this namedPipe is already open, no action is taken.
  *
  * @throws NamedPipeException if an error occurs opening this NamedPipe
@@ -176,41 +219,194 @@ NamedPipe::open() throw(NamedPipeException)
 {
 	if(!isOpen())
 	{
-		int flags ;
-		switch(m_access_mode)
+		int flags = getOpenFlags() ;
+
+		if(!m_blocking)
 		{
-			case NamedPipe::READ_ONLY_ENUM:
-			{
-				flags = O_RDONLY ;
-				break ;
-			}
-			case NamedPipe::WRITE_ONLY_ENUM:
-			{
-				flags = O_WRONLY ;
-				break ;
-			}
-			case NamedPipe::READ_WRITE_ENUM:
+			flags = flags|O_NONBLOCK ;
+		}
+
+		m_fd = ::open(m_file_system_path.c_str(), flags) ;
+
+		if(m_fd < 0)
+		{
+			throw(NamedPipeException(std::string("Exception in open [open]:").append(::strerror(errno)))) ;
+		}
+
+		releaseOpenNotify() ;
+	}
+}
+
+/**
+ * Attempts to open this NamedPipe, waiting at most usec micro seconds for the peer to appear.
+ * The NamedPipe is always opened without blocking the calling thread in the open system call.
+ * A READ_ONLY_ENUM or READ_WRITE_ENUM NamedPipe opens immediately, a WRITE_ONLY_ENUM NamedPipe
+ * cannot be opened until a reader has opened the FIFO, the calling thread sleeps on a filesystem
+ * open notification for the FIFO. A reader opening the FIFO blocking raises no notification until
+ * a writer arrives, so the open is also retried at a short interval while waiting.
+ * Once opened, a NamedPipe set blocking is returned to blocking I/O.
+ * A reader opened before any writer sees end of file from read until a writer opens the FIFO,
+ * isDataAvailable may be used to wait for the first data.
+ * If this NamedPipe is already open, no action is taken and true is returned.
+ *
+ * @param usec the maximum time to wait in micro seconds, a negative value waits indefinitely
+ * @return true if this NamedPipe was opened, false if the deadline passed first
+ * @throws NamedPipeException if an error occurs opening this NamedPipe
+ */
+bool
+NamedPipe::open(long usec) throw(NamedPipeException)
+{
+	if(isOpen())
+	{
+		return(true) ;
+	}
+
+	// readers never wait for the peer when opened non-blocking
+	if(m_access_mode != WRITE_ONLY_ENUM)
+	{
+		return(tryOpen()) ;
+	}
+
+	// register for notification before the first attempt so a reader
+	// opening between the attempt and the wait is not missed
+	int notify_fd = getOpenNotifyDescriptor() ;
+
+	struct timespec deadline ;
+	::clock_gettime(CLOCK_MONOTONIC, &deadline) ;
+	deadline.tv_sec += usec / 1000000 ;
+	deadline.tv_nsec += (usec % 1000000) * 1000 ;
+	if(deadline.tv_nsec >= 1000000000)
+	{
+		deadline.tv_sec++ ;
+		deadline.tv_nsec -= 1000000000 ;
+	}
+
+	while(!tryOpen())
+	{
+		int timeout = OPEN_RETRY_MSEC ;
+		if(usec >= 0)
+		{
+			struct timespec now ;
+			::clock_gettime(CLOCK_MONOTONIC, &now) ;
+
+			long remaining = (deadline.tv_sec - now.tv_sec) * 1000 + (deadline.tv_nsec - now.tv_nsec) / 1000000 ;
+			if(remaining <= 0)
 			{
-				flags = O_RDWR ;
+				return(false) ;
 			}
-			default:
+			if(remaining < timeout)
 			{
-				flags = O_RDONLY ;
+				timeout = static_cast<int>(remaining) ;
 			}
 		}
 
-		if(m_blocking)
+		::pollfd pfd[1] ;
+		pfd[0].fd = notify_fd ;
+		pfd[0].events = POLLIN ;
+
+		if(::poll(pfd, 1, timeout) < 0 && errno != EINTR)
 		{
-			flags = flags|O_NONBLOCK ;
+			throw(NamedPipeException(std::string("Exception in open [poll]:").append(::strerror(errno)))) ;
 		}
+	}
 
-		m_fd = ::open(m_file_system_path.c_str(), flags) ;
+	return(true) ;
+}
 
-		if(m_fd < 0)
+/**
+ * Makes a single non blocking attempt to open this NamedPipe.
+ * This is intended to be called from an event loop when the descriptor returned by
+ * getOpenNotifyDescriptor becomes readable. Any pending notifications are consumed.
+ * If this NamedPipe is already open, no action is taken and true is returned.
+ *
+ * @return true if this NamedPipe was opened, false if the peer has not yet opened the FIFO
+ * @throws NamedPipeException if an error occurs opening this NamedPipe
+ */
+bool
+NamedPipe::tryOpen() throw(NamedPipeException)
+{
+	if(isOpen())
+	{
+		return(true) ;
+	}
+
+	if(m_notify_fd != -1)
+	{
+		// drain pending notifications, the descriptor is non-blocking
+		char events[sizeof(struct inotify_event) + NAME_MAX + 1] ;
+		while(::read(m_notify_fd, events, sizeof(events)) > 0)
 		{
-			throw(NamedPipeException(std::string("Exception in open [open]:").append(::strerror(errno)))) ;
 		}
 	}
+
+	int fd = ::open(m_file_system_path.c_str(), getOpenFlags()|O_NONBLOCK) ;
+	if(fd < 0)
+	{
+		if(errno == ENXIO)
+		{
+			// no reader yet
+			return(false) ;
+		}
+
+		throw(NamedPipeException(std::string("Exception in tryOpen [open]:").append(::strerror(errno)))) ;
+	}
+
+	if(m_blocking)
+	{
+		int flags = ::fcntl(fd, F_GETFL) ;
+		if(flags < 0 || ::fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) < 0)
+		{
+			int err = errno ;
+			::close(fd) ;
+			throw(NamedPipeException(std::string("Exception in tryOpen [fcntl]:").append(::strerror(err)))) ;
+		}
+	}
+
+	m_fd = fd ;
+	releaseOpenNotify() ;
+
+	return(true) ;
+}
+
+/**
+ * Returns a descriptor which becomes readable when the FIFO of this NamedPipe is opened by any process.
+ * The descriptor may be added to a poll/select/epoll based reactor, tryOpen should be called whenever
+ * it becomes readable. A reader blocked opening the FIFO raises no notification until its open
+ * completes, so a writer should also retry tryOpen periodically.
+ * The descriptor is owned by this NamedPipe and is released once this
+ * NamedPipe has been opened, or closed.
+ * This NamedPipe must have been created prior to calling this method.
+ *
+ * @return the open notification descriptor
+ * @throws NamedPipeException if this NamedPipe has not been created, or the notification cannot be setup
+ */
+int
+NamedPipe::getOpenNotifyDescriptor() throw(NamedPipeException)
+{
+	if(!isCreated())
+	{
+		throw(NamedPipeException("Cannot wait for open on an uncreated NamedPipe")) ;
+	}
+
+	if(m_notify_fd == -1)
+	{
+		int fd = ::inotify_init1(IN_NONBLOCK|IN_CLOEXEC) ;
+		if(fd < 0)
+		{
+			throw(NamedPipeException(std::string("Exception in getOpenNotifyDescriptor [inotify_init1]:").append(::strerror(errno)))) ;
+		}
+
+		if(::inotify_add_watch(fd, m_file_system_path.c_str(), IN_OPEN) < 0)
+		{
+			int err = errno ;
+			::close(fd) ;
+			throw(NamedPipeException(std::string("Exception in getOpenNotifyDescriptor [inotify_add_watch]:").append(::strerror(err)))) ;
+		}
+
+		m_notify_fd = fd ;
+	}
+
+	return(m_notify_fd) ;
 }
 
 /**
@@ -221,6 +417,8 @@ NamedPipe::open() throw(NamedPipeException)
 void
 NamedPipe::close() throw(NamedPipeException)
 {
+	releaseOpenNotify() ;
+
 	if(isOpen())
 	{
 		if(::close(m_fd) == 0)
@@ -378,6 +576,234 @@ NamedPipe::isOpen() const
 	return(m_fd == -1 ? false : true) ;
 }
 
+/**
+ * Returns the underlying file descriptor of this NamedPipe.
+ * The descriptor is only valid while this NamedPipe is open, -1 is returned otherwise
+ *
+ * @return the file descriptor of this NamedPipe, or -1 if not open
+ */
+int
+NamedPipe::getFileDescriptor() const
+{
+	return(m_fd) ;
+}
+
+//-------------------------------------------------------------------------------//
+// Pipe Capacity
+
+/**
+ * Sets the kernel buffer capacity of this open NamedPipe.
+ * The kernel rounds the requested size up to a whole number of pages, and an unprivileged
+ * process may not exceed /proc/sys/fs/pipe-max-size. Capacity is a property of the pipe,
+ * not the descriptor, so the change is visible to both ends.
+ *
+ * @param capacity the requested capacity in bytes
+ * @return the actual capacity set by the kernel
+ * @throws NamedPipeException if this NamedPipe is not open, or the capacity cannot be set
+ */
+size_t
+NamedPipe::setCapacity(size_t capacity) throw(NamedPipeException)
+{
+	if(!isOpen())
+	{
+		throw(NamedPipeException("Cannot set capacity of an unopened NamedPipe")) ;
+	}
+
+	int ret = ::fcntl(m_fd, F_SETPIPE_SZ, static_cast<int>(capacity)) ;
+	if(ret < 0)
+	{
+		throw(NamedPipeException(std::string("Exception in setCapacity [fcntl]:").append(::strerror(errno)))) ;
+	}
+
+	return(static_cast<size_t>(ret)) ;
+}
+
+/**
+ * Returns the current kernel buffer capacity of this open NamedPipe
+ *
+ * @return the capacity of this NamedPipe in bytes
+ * @throws NamedPipeException if this NamedPipe is not open, or the capacity cannot be queried
+ */
+size_t
+NamedPipe::getCapacity() const throw(NamedPipeException)
+{
+	if(!isOpen())
+	{
+		throw(NamedPipeException("Cannot get capacity of an unopened NamedPipe")) ;
+	}
+
+	int ret = ::fcntl(m_fd, F_GETPIPE_SZ) ;
+	if(ret < 0)
+	{
+		throw(NamedPipeException(std::string("Exception in getCapacity [fcntl]:").append(::strerror(errno)))) ;
+	}
+
+	return(static_cast<size_t>(ret)) ;
+}
+
+//-------------------------------------------------------------------------------//
+// Zero Copy Transfer Operations
+
+/**
+ * Moves up to length bytes from this NamedPipe to the specified file descriptor without
+ * copying the data through user space.
+ * The destination may be a file, socket or another pipe, a file is written at its current offset.
+ *
+ * @param fd the destination file descriptor
+ * @param length the maximum number of bytes to transfer
+ * @param flags or'ed TransferFlagsEnum values
+ * @return the number of bytes transferred, 0 indicating end of file
+ * @throws NamedPipeException if this NamedPipe is not open, or the transfer fails
+ */
+ssize_t
+NamedPipe::spliceTo(int fd, size_t length, int flags) throw(NamedPipeException)
+{
+	if(!isOpen())
+	{
+		throw(NamedPipeException("Cannot splice from an unopened NamedPipe")) ;
+	}
+
+	ssize_t ret ;
+	do
+	{
+		ret = ::splice(m_fd, NULL, fd, NULL, length, toSpliceFlags(flags)) ;
+	}
+	while(ret < 0 && errno == EINTR) ;
+
+	if(ret < 0)
+	{
+		throw(NamedPipeException(std::string("Exception in spliceTo [splice]:").append(::strerror(errno)))) ;
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Moves up to length bytes from this NamedPipe into the specified NamedPipe
+ *
+ * @param dest the destination NamedPipe
+ * @param length the maximum number of bytes to transfer
+ * @param flags or'ed TransferFlagsEnum values
+ * @return the number of bytes transferred, 0 indicating end of file
+ * @throws NamedPipeException if either NamedPipe is not open, or the transfer fails
+ */
+ssize_t
+NamedPipe::spliceTo(NamedPipe& dest, size_t length, int flags) throw(NamedPipeException)
+{
+	if(!dest.isOpen())
+	{
+		throw(NamedPipeException("Cannot splice to an unopened NamedPipe")) ;
+	}
+
+	return(spliceTo(dest.m_fd, length, flags)) ;
+}
+
+/**
+ * Moves up to length bytes from the specified file descriptor into this NamedPipe without
+ * copying the data through user space.
+ * The source may be a file, socket or another pipe, a file is read from its current offset.
+ *
+ * @param fd the source file descriptor
+ * @param length the maximum number of bytes to transfer
+ * @param flags or'ed TransferFlagsEnum values
+ * @return the number of bytes transferred, 0 indicating end of file
+ * @throws NamedPipeException if this NamedPipe is not open, or the transfer fails
+ */
+ssize_t
+NamedPipe::spliceFrom(int fd, size_t length, int flags) throw(NamedPipeException)
+{
+	if(!isOpen())
+	{
+		throw(NamedPipeException("Cannot splice to an unopened NamedPipe")) ;
+	}
+
+	ssize_t ret ;
+	do
+	{
+		ret = ::splice(fd, NULL, m_fd, NULL, length, toSpliceFlags(flags)) ;
+	}
+	while(ret < 0 && errno == EINTR) ;
+
+	if(ret < 0)
+	{
+		throw(NamedPipeException(std::string("Exception in spliceFrom [splice]:").append(::strerror(errno)))) ;
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Duplicates up to length bytes from this NamedPipe into the specified NamedPipe.
+ * The data is not consumed from this NamedPipe, allowing the same data to be fanned out
+ * to several destinations before being spliced, or read, from this NamedPipe.
+ *
+ * @param dest the destination NamedPipe
+ * @param length the maximum number of bytes to duplicate
+ * @param flags or'ed TransferFlagsEnum values
+ * @return the number of bytes duplicated
+ * @throws NamedPipeException if either NamedPipe is not open, or the operation fails
+ */
+ssize_t
+NamedPipe::tee(NamedPipe& dest, size_t length, int flags) throw(NamedPipeException)
+{
+	if(!isOpen() || !dest.isOpen())
+	{
+		throw(NamedPipeException("Cannot tee with an unopened NamedPipe")) ;
+	}
+
+	ssize_t ret ;
+	do
+	{
+		ret = ::tee(m_fd, dest.m_fd, length, toSpliceFlags(flags)) ;
+	}
+	while(ret < 0 && errno == EINTR) ;
+
+	if(ret < 0)
+	{
+		throw(NamedPipeException(std::string("Exception in tee [tee]:").append(::strerror(errno)))) ;
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Maps the user memory region into this NamedPipe.
+ * Unless TRANSFER_GIFT_ENUM is specified the kernel may still reference the memory after
+ * this call returns, the caller must not modify the data until it has been consumed by the reader.
+ *
+ * @param data the data to map into this NamedPipe
+ * @param size the number of bytes of data
+ * @param flags or'ed TransferFlagsEnum values
+ * @return the number of bytes mapped into this NamedPipe
+ * @throws NamedPipeException if this NamedPipe is not open, or the operation fails
+ */
+ssize_t
+NamedPipe::vmsplice(const void* data, size_t size, int flags) throw(NamedPipeException)
+{
+	if(!isOpen())
+	{
+		throw(NamedPipeException("Cannot vmsplice into an unopened NamedPipe")) ;
+	}
+
+	struct iovec iov ;
+	iov.iov_base = const_cast<void*>(data) ;
+	iov.iov_len = size ;
+
+	ssize_t ret ;
+	do
+	{
+		ret = ::vmsplice(m_fd, &iov, 1, toSpliceFlags(flags)) ;
+	}
+	while(ret < 0 && errno == EINTR) ;
+
+	if(ret < 0)
+	{
+		throw(NamedPipeException(std::string("Exception in vmsplice [vmsplice]:").append(::strerror(errno)))) ;
+	}
+
+	return(ret) ;
+}
+
 
 //-------------------------------------------------------------------------------//
 // AbstractInputStream
@@ -508,3 +934,52 @@ NamedPipe::write(const char& write_byte, int& err_code) throw()
 {
 	return(write(&write_byte, 1, err_code)) ;
 }
+
+//-------------------------------------------------------------------------------//
+// Private Operations
+
+/**
+ * Returns the open flags for the access mode of this NamedPipe
+ *
+ * @return the open flags for the access mode of this NamedPipe
+ */
+int
+NamedPipe::getOpenFlags() const
+{
+	int flags ;
+	switch(m_access_mode)
+	{
+		case NamedPipe::WRITE_ONLY_ENUM:
+		{
+			flags = O_WRONLY ;
+			break ;
+		}
+		case NamedPipe::READ_WRITE_ENUM:
+		{
+			flags = O_RDWR ;
+			break ;
+		}
+		case NamedPipe::READ_ONLY_ENUM:
+		default:
+		{
+			flags = O_RDONLY ;
+			break ;
+		}
+	}
+
+	return(flags) ;
+}
+
+/**
+ * Releases the open notification descriptor, if one has been setup
+ *
+ */
+void
+NamedPipe::releaseOpenNotify()
+{
+	if(m_notify_fd != -1)
+	{
+		::close(m_notify_fd) ;
+		m_notify_fd = -1 ;
+	}
+}
@@ -21,25 +21,168 @@
 
 #include <cutil/PluginManager.h>
 
+#include <cutil/Closure.h>
+#include <cutil/Condition.h>
+#include <cutil/FilePath.h>
+#include <cutil/Mutex.h>
 #include <cutil/Plugin.h>
 #include <cutil/PluginInfo.h>
 #include <cutil/PluginFactory.h>
 #include <cutil/PluginNameTransform.h>
 #include <cutil/PluginManagerException.h>
+#include <cutil/PluginManifest.h>
+#include <cutil/PluginStatistics.h>
 #include <cutil/SharedLibrary.h>
 #include <cutil/SharedLibraryException.h>
+#include <cutil/ThreadPool.h>
 
 #include <algorithm>
+#include <cstring>
+#include <map>
 #include <functional>
 #include <iostream>
 #include <sstream>
 #include <string>
-
+#include <vector>
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+using cutil::AbstractClosure ;
+using cutil::Condition ;
+using cutil::Exception ;
+using cutil::FilePath ;
+using cutil::Mutex ;
+using cutil::MutexLock ;
 using cutil::PluginInfo ;
 using cutil::PluginFactory ;
 using cutil::PluginManager ;
+using cutil::PluginManifest ;
 using cutil::PluginNameTransform ;
+using cutil::PluginStatistics ;
+using cutil::ReadLock ;
 using cutil::SharedLibrary ;
+using cutil::ThreadPool ;
+using cutil::WriteLock ;
+
+namespace
+{
+	/**
+	 * Returns the current time of the monotonic clock, in seconds
+	 */
+	time_t monotonicSeconds()
+	{
+		struct timespec ts ;
+		::clock_gettime(CLOCK_MONOTONIC, &ts) ;
+		return(ts.tv_sec) ;
+	}
+
+	/**
+	 * Returns the current time of the monotonic clock, in nanoseconds
+	 */
+	unsigned long long monotonicNanoseconds()
+	{
+		struct timespec ts ;
+		::clock_gettime(CLOCK_MONOTONIC, &ts) ;
+		return(static_cast<unsigned long long>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec) ;
+	}
+
+	/**
+	 * Returns the time elapsed since mark, in nanoseconds of the monotonic clock, and
+	 * advances mark to the current time
+	 */
+	unsigned long long lap(unsigned long long& mark)
+	{
+		unsigned long long start = mark ;
+		mark = monotonicNanoseconds() ;
+		return(mark - start) ;
+	}
+
+	/**
+	 * Loads a named Plugin on a ThreadPool, in advance of its first access
+	 */
+	class PrewarmTask : public AbstractClosure<void>
+	{
+		public:
+			PrewarmTask(PluginManager& manager, const std::string& name, bool remainLoaded)
+				: theManager(manager), theName(name), theRemainLoadedFlag(remainLoaded)
+			{}
+
+			virtual void operator() () const
+			{
+				if(theManager.loadPlugin(theName) && theRemainLoadedFlag)
+				{
+					theManager.setRemainLoaded(theName, true) ;
+				}
+			}
+
+		private:
+			PluginManager& theManager ;
+			std::string theName ;
+			bool theRemainLoadedFlag ;
+	} ;
+
+	/**
+	 * Tracks completion of a group of tasks
+	 */
+	class DiscoveryGroup
+	{
+		public:
+			DiscoveryGroup() : thePending(0) {}
+
+			void started()
+			{
+				MutexLock lock(theMutex) ;
+				thePending++ ;
+			}
+
+			void finished()
+			{
+				MutexLock lock(theMutex) ;
+				if(--thePending == 0)
+				{
+					theCondition.broadcast() ;
+				}
+			}
+
+			void wait()
+			{
+				MutexLock lock(theMutex) ;
+				while(thePending > 0)
+				{
+					theCondition.wait(theMutex) ;
+				}
+			}
+
+		private:
+			Mutex theMutex ;
+			Condition theCondition ;
+			size_t thePending ;
+	} ;
+}
+
+/**
+ * Task opening and listing a single SharedLibrary during concurrent registration
+ */
+class PluginManager::DiscoverModuleTask : public AbstractClosure<void>
+{
+	public:
+		DiscoverModuleTask(const PluginManager& manager, ModuleDiscovery& discovery, DiscoveryGroup& group)
+			: theManager(manager), theDiscovery(discovery), theGroup(group)
+		{}
+
+		virtual void operator() () const
+		{
+			theManager.discoverModule(theDiscovery) ;
+			theGroup.finished() ;
+		}
+
+	private:
+		const PluginManager& theManager ;
+		ModuleDiscovery& theDiscovery ;
+		DiscoveryGroup& theGroup ;
+} ;
 
 //-------------------------------------------------------------------------------//
 // Constructor / Desctructor
@@ -53,6 +196,22 @@ PluginManager::PluginManager()
 {
 	theAutoLoadFlag = false ;
 	theNameTransform = 0 ;
+	theManifest = 0 ;
+	theGeneration = 0 ;
+	theRetiredCount = 0 ;
+	theIdleTimeout = 0 ;
+	theMemoryBudget = 0 ;
+	theEvictionTime = 0 ;
+	theInstrumentedFlag = false ;
+	theSnapshot = 0 ;
+	theEpoch = 1 ;
+	theReaderSlots = 0 ;
+
+	int err = ::pthread_key_create(&theReaderKey, &PluginManager::releaseReaderSlot) ;
+	if(err != 0)
+	{
+		throw(PluginManagerException(std::string("Exception in PluginManager [pthread_key_create]:").append(::strerror(err)))) ;
+	}
 }
 
 /**
@@ -74,6 +233,27 @@ PluginManager::~PluginManager()
 	{
 		std::cerr << "Error in PluginManager destructor: " << sle.toString() << std::endl ;
 	}
+
+	for(std::vector<PluginRecord*>::iterator iter = theRetiredRecords.begin(); iter != theRetiredRecords.end(); ++iter)
+	{
+		delete *iter ;
+	}
+
+	// no thread may still be reading, exiting threads no longer release their ReaderSlots once the key is deleted
+	::pthread_key_delete(theReaderKey) ;
+
+	delete theSnapshot ;
+	for(std::vector<std::pair<unsigned long, const PluginContainer_t*> >::iterator iter = theRetiredSnapshots.begin(); iter != theRetiredSnapshots.end(); ++iter)
+	{
+		delete iter->second ;
+	}
+
+	while(theReaderSlots)
+	{
+		ReaderSlot* slot = theReaderSlots ;
+		theReaderSlots = slot->theNext ;
+		delete slot ;
+	}
 }
 
 //-------------------------------------------------------------------------------//
@@ -90,8 +270,13 @@ PluginManager::~PluginManager()
 PluginNameTransform*
 PluginManager::setNameTransform(PluginNameTransform* nameTransform)
 {
+	WriteLock lock(theLock) ;
+
 	PluginNameTransform* prev = theNameTransform ;
 	theNameTransform = nameTransform ;
+
+	// application names may now resolve to different Plugins
+	__sync_add_and_fetch(&theGeneration, 1) ;
 	return(prev) ;
 }
 
@@ -114,9 +299,41 @@ PluginManager::removeNameTransform()
 const PluginNameTransform*
 PluginManager::getNameTransform() const
 {
+	ReadLock lock(theLock) ;
 	return(theNameTransform) ;
 }
 
+/**
+ * Sets the PluginManifest used to register the Plugins of unchanged modules without opening them.
+ * Modules opened to list their Plugins are recorded within the PluginManifest, which the caller
+ * may then save. The PluginManifest remains owned by the caller. Any previously set
+ * PluginManifest is returned.
+ *
+ * @param manifest the PluginManifest to use, or 0 to always open modules
+ * @return the previously set PluginManifest, if one has been set.
+ */
+PluginManifest*
+PluginManager::setManifest(PluginManifest* manifest)
+{
+	WriteLock lock(theLock) ;
+
+	PluginManifest* prev = theManifest ;
+	theManifest = manifest ;
+	return(prev) ;
+}
+
+/**
+ * Returns the set PluginManifest
+ *
+ * @return the set PluginManifest, or 0 if none has been set
+ */
+const PluginManifest*
+PluginManager::getManifest() const
+{
+	ReadLock lock(theLock) ;
+	return(theManifest) ;
+}
+
 /**
  * Sets whether unloaded Plugins are automatically loaded during named Plugin access
  * With this flag set, Plugins which are unloaded, or unregistred are automatically
@@ -128,6 +345,8 @@ PluginManager::getNameTransform() const
 void
 PluginManager::setAutoLoad(bool autoload)
 {
+	WriteLock lock(theLock) ;
+
 	theAutoLoadFlag = autoload ;
 }
 
@@ -139,6 +358,7 @@ PluginManager::setAutoLoad(bool autoload)
 bool
 PluginManager::getAutoLoad() const
 {
+	ReadLock lock(theLock) ;
 	return(theAutoLoadFlag) ;
 }
 
@@ -159,6 +379,8 @@ PluginManager::getAutoLoad() const
 bool
 PluginManager::setRemainLoaded(const std::string name, bool loaded)
 {
+	WriteLock lock(theLock) ;
+
 	bool ret = false ;
 
 	if(theNameTransform)
@@ -189,6 +411,8 @@ PluginManager::setRemainLoaded(const std::string name, bool loaded)
 bool
 PluginManager::getRemainLoaded(const std::string name)
 {
+	ReadLock lock(theLock) ;
+
 	bool ret = false ;
 
 	if(theNameTransform)
@@ -207,6 +431,138 @@ PluginManager::getRemainLoaded(const std::string name)
 	return(ret) ;
 }
 
+/**
+ * Sets how long an idle Plugin remains loaded.
+ * A Plugin is idle once only the reference held by this PluginManager remains, and it
+ * is not to remain loaded. With a timeout of 0, the default, an idle Plugin is unloaded
+ * as soon as its last reference is released. With a positive timeout, an idle Plugin
+ * remains loaded, so can be referenced again without reloading, until it has been idle
+ * for at least timeout seconds. With a negative timeout, idle Plugins remain loaded until
+ * evicted to meet the memory budget.
+ * Expired Plugins are evicted when Plugins are loaded, when released if no other thread
+ * holds the lock, and by evictIdle.
+ *
+ * @param timeout the number of seconds an idle Plugin remains loaded
+ */
+void
+PluginManager::setIdleTimeout(long timeout)
+{
+	WriteLock lock(theLock) ;
+	__atomic_store_n(&theIdleTimeout, timeout, __ATOMIC_RELAXED) ;
+}
+
+/**
+ * Returns how long an idle Plugin remains loaded
+ *
+ * @see setIdleTimeout
+ * @return the number of seconds an idle Plugin remains loaded
+ */
+long
+PluginManager::getIdleTimeout() const
+{
+	ReadLock lock(theLock) ;
+	return(theIdleTimeout) ;
+}
+
+/**
+ * Sets the memory budget of the open SharedLibraries.
+ * Once the mapped size of the open SharedLibraries exceeds the budget, SharedLibraries
+ * without loaded Plugins are closed, followed by the SharedLibraries whose loaded Plugins
+ * are all idle, least recently used first, until the budget is met. Referenced Plugins and
+ * Plugins to remain loaded are never evicted, so the budget may still be exceeded.
+ * The budget is enforced when Plugins are loaded or released, and by evictIdle.
+ *
+ * @see SharedLibrary::getMappedSize
+ * @param budget the memory budget in bytes, 0 for no budget
+ */
+void
+PluginManager::setMemoryBudget(size_t budget)
+{
+	WriteLock lock(theLock) ;
+	theMemoryBudget = budget ;
+}
+
+/**
+ * Returns the memory budget of the open SharedLibraries
+ *
+ * @see setMemoryBudget
+ * @return the memory budget in bytes, 0 if there is no budget
+ */
+size_t
+PluginManager::getMemoryBudget() const
+{
+	ReadLock lock(theLock) ;
+	return(theMemoryBudget) ;
+}
+
+/**
+ * Returns the total mapped size of the SharedLibraries currently open
+ *
+ * @see SharedLibrary::getMappedSize
+ * @return the mapped size of the open SharedLibraries in bytes
+ */
+size_t
+PluginManager::getMemoryUsage() const
+{
+	// the mapped size is computed on first request, so access to the SharedLibraries is exclusive
+	WriteLock lock(theLock) ;
+
+	size_t usage = 0 ;
+	for(SharedObjectContainer_t::const_iterator citer = theSharedObjects.begin(); citer != theSharedObjects.end(); ++citer)
+	{
+		if(citer->second->theSharedObject)
+		{
+			usage += citer->second->theSharedObject->getMappedSize() ;
+		}
+	}
+
+	return(usage) ;
+}
+
+/**
+ * Unloads the idle Plugins which have exceeded the idle timeout, then evicts
+ * idle SharedLibraries to meet the memory budget.
+ * Applications using an idle timeout may call this periodically, so idle Plugins
+ * are unloaded without waiting for other Plugins to be loaded or released.
+ *
+ * @return the number of Plugins unloaded
+ * @throw SharedLibraryException if there is an error accessing a SharedLibrary
+ * @throw PluginManagerException if a Plugin cannot be unloaded
+ */
+size_t
+PluginManager::evictIdle() throw(SharedLibraryException, PluginManagerException)
+{
+	return(evictPlugins(0)) ;
+}
+
+/**
+ * Sets whether this PluginManager records instrumentation of its Plugins.
+ * While instrumented, the time taken to open the SharedLibrary, create the
+ * PluginFactory and create the Plugin is recorded as each Plugin is loaded, and
+ * the latency of each call made through a PluginHandle is counted in a histogram
+ * of the Plugin. Instrumentation is disabled by default, when calls through a
+ * PluginHandle are not timed.
+ *
+ * @see getStatistics
+ * @param instrumented set true to record instrumentation
+ */
+void
+PluginManager::setInstrumented(bool instrumented)
+{
+	theInstrumentedFlag = instrumented ;
+}
+
+/**
+ * Returns whether this PluginManager records instrumentation of its Plugins
+ *
+ * @return true if instrumentation is recorded, false otherwise
+ */
+bool
+PluginManager::getInstrumented() const
+{
+	return(theInstrumentedFlag) ;
+}
+
 //-------------------------------------------------------------------------------//
 // PluginManager Operations
 
@@ -225,66 +581,31 @@ PluginManager::getRemainLoaded(const std::string name)
 std::list<PluginInfo>&
 PluginManager::getAvailablePlugins(const std::string& module, std::list<PluginInfo>& pluginList) const throw(SharedLibraryException)
 {
-	SharedObjectRecord* soRec = getSharedObjectRecord(module) ;
-
-	if(soRec && soRec->theSharedObject)
+	// an unchanged module recorded in the manifest need not be opened
 	{
-		// remeber varuious states so we can leave everything as it was
-		// before getAvailablePlugins was called
-		bool soOpen = soRec->theSharedObject->isOpen() ;
-		bool hasFactory = soRec->thePluginFactory ? true : false ;
-
-		if(!soOpen)
-		{
-			// may throw
-			soRec->theSharedObject->open() ;
-		}
+		WriteLock lock(theLock) ;
 
-		PluginFactory* factory = 0 ;
-		if(!hasFactory)
-		{
-			factory = createPluginFactory(*(soRec->theSharedObject)) ;
-		}
-		else
+		if(theManifest && theManifest->lookup(module, pluginList))
 		{
-			factory = soRec->thePluginFactory ;
+			return(pluginList) ;
 		}
+	}
 
-		if(factory)
-		{
-			factory->getAvailablePlugins(pluginList) ;
-
-			if(!hasFactory)
-			{
-				// safely release the facory object
-				releasePluginFactory(*(soRec->theSharedObject), factory) ;
+	// opens the SharedLibrary without holding the lock
+	std::list<PluginInfo> available ;
+	listPlugins(module, available) ;
 
-				// only close if we dont have a factory.
-				if(!soOpen)
-				{
-					// may throw
-					soRec->theSharedObject->close() ;
-				}
-			}
-		}
-	}
-	else // !soRec or !soRec->theSharedObject
 	{
-		SharedLibrary lib(module) ;
-		lib.open() ;
+		WriteLock lock(theLock) ;
 
-		PluginFactory* factory = createPluginFactory(lib) ;
-		if(factory)
+		if(theManifest)
 		{
-			// get the PluginFactor
-			factory->getAvailablePlugins(pluginList) ;
-
-			// safely release the facory object
-			releasePluginFactory(lib, factory) ;
+			theManifest->update(module, available) ;
 		}
-		lib.close() ;
 	}
 
+	pluginList.insert(pluginList.end(), available.begin(), available.end()) ;
+
 	return(pluginList) ;
 }
 
@@ -305,13 +626,185 @@ PluginManager::getAvailablePlugins(const std::string& module, std::list<PluginIn
 void
 PluginManager::registerPlugins(const std::string& module) throw(SharedLibraryException, PluginManagerException)
 {
+	// list the SharedLibrary without holding the lock
 	std::list<PluginInfo> pluginList ;
 	getAvailablePlugins(module, pluginList) ;
 
+	WriteLock lock(theLock) ;
+
+	// register directly from the single listing, rather than listing the SharedLibrary per Plugin
 	for(std::list<PluginInfo>::const_iterator citer = pluginList.begin(); citer != pluginList.end(); ++citer)
 	{
-		registerPlugin(module, citer->getName()) ;
+		if(!getPluginRecord(module, citer->getName()))
+		{
+			addPluginRecord(module, *citer) ;
+		}
+	}
+}
+
+/**
+ * Registers all Plugins contained within each of the specified SharedLibraries.
+ * The SharedLibraries are opened, and their Plugins listed, concurrently on the specified
+ * ThreadPool, the results are then registered in module order, so the registry does not
+ * depend upon the order in which the SharedLibraries complete. Each SharedLibrary remains
+ * open with its PluginFactory, ready for its Plugins to be loaded.
+ * If any SharedLibrary cannot be accessed, the Plugins of the remaining SharedLibraries
+ * are registered before the failure of the first such module is thrown.
+ *
+ * @param modules the SharedLibraries to register
+ * @param pool the ThreadPool on which to open the SharedLibraries
+ * @throw SharedLibraryException if there is an error accessing any of the SharedObjects
+ */
+void
+PluginManager::registerPlugins(const std::vector<std::string>& modules, ThreadPool& pool) throw(SharedLibraryException, PluginManagerException)
+{
+	std::vector<std::string> sorted(modules) ;
+	std::sort(sorted.begin(), sorted.end()) ;
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end()) ;
+
+	std::vector<ModuleDiscovery> discoveries(sorted.size()) ;
+	std::vector<bool> cached(sorted.size(), false) ;
+
+	// unchanged modules recorded in the manifest need not be opened
+	{
+		WriteLock lock(theLock) ;
+
+		for(size_t i = 0 ; i < sorted.size() ; ++i)
+		{
+			discoveries[i].theModule = sorted[i] ;
+			cached[i] = theManifest && theManifest->lookup(sorted[i], discoveries[i].thePlugins) ;
+		}
+	}
+
+	// open and list the remaining SharedLibraries without holding the lock
+	DiscoveryGroup group ;
+	for(size_t i = 0 ; i < sorted.size() ; ++i)
+	{
+		if(cached[i])
+		{
+			continue ;
+		}
+
+		group.started() ;
+		try
+		{
+			pool.execute(new DiscoverModuleTask(*this, discoveries[i], group)) ;
+		}
+		catch(Exception&)
+		{
+			// run the task on this thread instead
+			discoverModule(discoveries[i]) ;
+			group.finished() ;
+		}
+	}
+	group.wait() ;
+
+	// register the results in module order
+	std::string error ;
+	{
+		WriteLock lock(theLock) ;
+
+		for(std::vector<ModuleDiscovery>::iterator iter = discoveries.begin() ; iter != discoveries.end() ; ++iter)
+		{
+			if(!iter->theError.empty())
+			{
+				if(error.empty())
+				{
+					error = iter->theError ;
+				}
+			}
+			else
+			{
+				// modules registered from the manifest are opened when first loaded
+				if(iter->theLibrary)
+				{
+					if(theManifest)
+					{
+						theManifest->update(iter->theModule, iter->thePlugins) ;
+					}
+
+					SharedObjectRecord* soRec = getSharedObjectRecord(iter->theModule) ;
+					if(!soRec)
+					{
+						soRec = registerSharedLibrary(iter->theModule) ;
+					}
+
+					if(!soRec->theSharedObject && iter->theFactory)
+					{
+						soRec->theSharedObject = iter->theLibrary ;
+						soRec->thePluginFactory = iter->theFactory ;
+					}
+					else
+					{
+						// already opened by this PluginManager, or provides no PluginFactory
+						if(iter->theFactory)
+						{
+							releasePluginFactory(*(iter->theLibrary), iter->theFactory) ;
+						}
+						delete iter->theLibrary ;
+					}
+				}
+
+				for(std::list<PluginInfo>::const_iterator citer = iter->thePlugins.begin(); citer != iter->thePlugins.end(); ++citer)
+				{
+					if(!getPluginRecord(iter->theModule, citer->getName()))
+					{
+						addPluginRecord(iter->theModule, *citer) ;
+					}
+				}
+			}
+		}
+	}
+
+	if(!error.empty())
+	{
+		throw(SharedLibraryException(error)) ;
+	}
+}
+
+/**
+ * Registers all Plugins contained within the SharedLibraries of the specified directory.
+ * Each regular file within directory whose name ends with suffix is registered as with
+ * registerPlugins, on the specified ThreadPool.
+ *
+ * @param directory the directory containing the SharedLibraries
+ * @param pool the ThreadPool on which to open the SharedLibraries
+ * @param modules populated with the sorted paths of the discovered SharedLibraries
+ * @param suffix the file name suffix of SharedLibraries
+ * @return modules populated
+ * @throw SharedLibraryException if there is an error accessing any of the SharedObjects
+ * @throw PluginManagerException if the directory cannot be listed
+ */
+std::vector<std::string>&
+PluginManager::registerDirectory(const FilePath& directory, ThreadPool& pool, std::vector<std::string>& modules, const std::string& suffix) throw(SharedLibraryException, PluginManagerException)
+{
+	std::vector<std::string> discovered ;
+
+	try
+	{
+		std::list<FilePath> files ;
+		directory.getFiles(files) ;
+
+		for(std::list<FilePath>::const_iterator citer = files.begin(); citer != files.end(); ++citer)
+		{
+			const std::string& path = citer->getPath() ;
+			if((path.size() > suffix.size()) && (path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0) && citer->isRegularFile())
+			{
+				discovered.push_back(path) ;
+			}
+		}
+	}
+	catch(Exception& e)
+	{
+		throw(PluginManagerException(std::string("Cannot list plugin directory [").append(directory.getPath()).append("]: ").append(e.toString()))) ;
 	}
+
+	std::sort(discovered.begin(), discovered.end()) ;
+	modules.insert(modules.end(), discovered.begin(), discovered.end()) ;
+
+	registerPlugins(discovered, pool) ;
+
+	return(modules) ;
 }
 
 /**
@@ -332,11 +825,9 @@ void
 PluginManager::registerPlugin(const std::string& module, const std::string& name) throw(SharedLibraryException, PluginManagerException)
 {
 	// is the plugin already registred?
-	PluginRecord* prec = getPluginRecord(module, name) ;
-
-	if(!prec)
+	if(!isRegistered(module, name))
 	{
-		// verifyt the SharedLibrary contains the Plugin
+		// verifyt the SharedLibrary contains the Plugin, listing it without holding the lock
 		std::list<PluginInfo> pluginList ;
 
 		// may throw
@@ -346,13 +837,13 @@ PluginManager::registerPlugin(const std::string& module, const std::string& name
 		std::list<PluginInfo>::const_iterator citer = find_if(pluginList.begin(), pluginList.end(), pred) ;
 		if(citer != pluginList.end())
 		{
-			prec = new PluginRecord() ;
-			prec->theSharedObjectId = module ;
-			prec->thePluginInfo = *citer ;
-			prec->theRemainLoadedFlag = false ;
-			prec->theRefCount = 0 ;
+			WriteLock lock(theLock) ;
 
-			thePlugins.insert(PluginContPair_t(name, prec)) ;
+			// unless registered meanwhile
+			if(!getPluginRecord(module, name))
+			{
+				addPluginRecord(module, *citer) ;
+			}
 		}
 		else
 		{
@@ -383,20 +874,13 @@ PluginManager::registerPlugin(const std::string& module, const std::string& name
 bool
 PluginManager::registerPlugin(const std::string& name) throw(SharedLibraryException, PluginManagerException)
 {
-	bool found = false ;
+	std::string module ;
+	std::string plugin ;
 
-	if(theNameTransform)
-	{
-		PluginNameTransform::TransformData data ;
-		if(theNameTransform->lookup(name, data))
-		{
-			found = true ;
-			registerPlugin(data.theModule, data.thePluginName) ;
-		}
-	}
-	else
+	bool found = transformName(name, module, plugin, true) ;
+	if(found)
 	{
-		throw(PluginManagerException("No PluginNameTransform available")) ;
+		registerPlugin(module, plugin) ;
 	}
 
 	return(found) ;
@@ -415,6 +899,8 @@ PluginManager::registerPlugin(const std::string& name) throw(SharedLibraryExcept
 bool
 PluginManager::isRegistered(const std::string& module, const std::string& name)
 {
+	ReadLock lock(theLock) ;
+
 	bool registered = false ;
 	PluginRecord* prec = getPluginRecord(module, name) ;
 
@@ -441,17 +927,11 @@ PluginManager::isRegistered(const std::string& name)
 {
 	bool registered = false ;
 
-	if(theNameTransform)
+	std::string module ;
+	std::string plugin ;
+	if(transformName(name, module, plugin, true))
 	{
-		PluginNameTransform::TransformData data ;
-		if(theNameTransform->lookup(name, data))
-		{
-			registered = isRegistered(data.theModule, data.thePluginName) ;
-		}
-	}
-	else
-	{
-		throw(PluginManagerException("No PluginNameTransform available")) ;
+		registered = isRegistered(module, plugin) ;
 	}
 
 	return(registered) ;
@@ -490,6 +970,8 @@ PluginManager::loadPlugins(const std::string& module) throw(SharedLibraryExcepti
  * to be loaded, and is searched in the usual system manner.
  * The name parameter represents the name of a Plugin available through the
  * specified SharedObject.
+ * The SharedLibrary is opened, and the Plugin created, without holding the lock,
+ * so other Plugins remain accessible meanwhile.
  *
  * @param module the SharedLibrary to load
  * @param name the Plugin to load
@@ -503,48 +985,171 @@ PluginManager::loadPlugin(const std::string& module, const std::string& name) th
 		registerPlugin(module, name) ;
 	}
 
-	PluginRecord* prec = getPluginRecord(module, name) ;
-
-	if(prec)
+	bool loaded = false ;
+	while(!loaded)
 	{
-		// is the plugin already loaded?
-		if(!prec->thePlugin)
+		bool timed = theInstrumentedFlag ;
+		unsigned long long mark = timed ? monotonicNanoseconds() : 0 ;
+		unsigned long long openTime = 0 ;
+		unsigned long long factoryTime = 0 ;
+
+		// reserve the PluginFactory, the SharedLibrary is not closed while a Plugin is created from it
+		SharedObjectRecord* soRec = 0 ;
+		std::string path = module ;
 		{
-			// automatically maintains a pointer to the PluginFactory
-			// within the SharedObjectRecord
-			PluginFactory* factory = getPluginFactory(module) ;
-			if(factory)
+			WriteLock lock(theLock) ;
+
+			PluginRecord* prec = getPluginRecord(module, name) ;
+			if(!prec)
 			{
-				Plugin* plugin = factory->createPlugin(name) ;
-				if(plugin)
-				{
-					prec->thePlugin = plugin ;
+				std::ostringstream buf ;
+				buf << "Plugin does not exists [module=" << module << ",plugin=" << name << "]" ;
+				throw(PluginManagerException(buf.str())) ;
+			}
 
-					// initial reference for the reference this PluginManager holds
-					refPlugin(*plugin) ;
-				}
-				else
+			if(prec->thePlugin)
+			{
+				// ... Plugin already loaded
+				return ;
+			}
+
+			soRec = getSharedObjectRecord(module) ;
+			if(soRec && soRec->thePluginFactory)
+			{
+				soRec->thePluginCreationCount++ ;
+			}
+			else
+			{
+				// a reloaded module is opened from its replacement
+				if(soRec)
 				{
-					std::ostringstream buf ;
-					buf << "Unexpected error creating Plugin [plugin=" << name << ",module=" << module << "]" ;
-					throw(PluginManagerException(buf.str())) ;
+					path = soRec->thePath ;
 				}
+				soRec = 0 ;
 			}
-			else
+		}
+
+		if(!soRec)
+		{
+			// open the SharedLibrary without holding the lock, other Plugins remain accessible
+			SharedLibrary* lib = new SharedLibrary(path) ;
+			PluginFactory* factory = 0 ;
+			try
+			{
+				lib->open() ;
+				openTime = timed ? lap(mark) : 0 ;
+
+				factory = createPluginFactory(*lib) ;
+				factoryTime = timed ? lap(mark) : 0 ;
+			}
+			catch(...)
+			{
+				delete lib ;
+				throw ;
+			}
+
+			if(!factory)
 			{
+				delete lib ;
+
 				std::ostringstream buf ;
 				buf << "Unexpected error accessing PluginFactory [plugin=" << name << ",module=" << module << "]" ;
 				throw(PluginManagerException(buf.str())) ;
 			}
+
+			WriteLock lock(theLock) ;
+
+			soRec = registerSharedLibrary(module) ;
+			if(soRec->thePath != path)
+			{
+				// reloaded meanwhile, the replacement is opened instead
+				releasePluginFactory(*lib, factory) ;
+				delete lib ;
+				continue ;
+			}
+			else if(!soRec->thePluginFactory)
+			{
+				// replaces any SharedLibrary left without a PluginFactory, as after listing its Plugins
+				delete soRec->theSharedObject ;
+				soRec->theSharedObject = lib ;
+				soRec->thePluginFactory = factory ;
+			}
+			else
+			{
+				// opened by another load meanwhile
+				releasePluginFactory(*lib, factory) ;
+				delete lib ;
+			}
+			soRec->thePluginCreationCount++ ;
+		}
+
+		// create the Plugin without holding the lock
+		Plugin* plugin = 0 ;
+		try
+		{
+			plugin = soRec->thePluginFactory->createPlugin(name) ;
+		}
+		catch(...)
+		{
+			WriteLock lock(theLock) ;
+			releaseFactory(soRec, module) ;
+			throw ;
+		}
+		unsigned long long createTime = timed ? lap(mark) : 0 ;
+
+		// publish the Plugin, unless loaded, unregistered or reloaded meanwhile
+		WriteLock lock(theLock) ;
+
+		PluginRecord* prec = getPluginRecord(module, name) ;
+		if(!plugin)
+		{
+			releaseFactory(soRec, module) ;
+
+			std::ostringstream buf ;
+			buf << "Unexpected error creating Plugin [plugin=" << name << ",module=" << module << "]" ;
+			throw(PluginManagerException(buf.str())) ;
+		}
+		else if(prec && !prec->thePlugin && (getSharedObjectRecord(module) == soRec))
+		{
+			if(timed)
+			{
+				prec->theCreateTime = createTime ;
+				prec->theOpenTime = openTime ;
+				prec->theFactoryTime = factoryTime ;
+				prec->theLoadCount++ ;
+			}
+
+			// the reservation of the PluginFactory counts the created Plugin
+			prec->thePlugin = plugin ;
+			prec->theSharedObjectRecord = soRec ;
+			theLoadedPlugins.insert(PluginIndex_t::value_type(plugin, prec)) ;
+
+			// initial reference for the reference this PluginManager holds
+			refRecord(prec) ;
+			prec->theIdleTime = monotonicSeconds() ;
+			loaded = true ;
+
+			// the module just opened may exceed the memory budget
+			if(theMemoryBudget > 0)
+			{
+				evictPlugins(prec) ;
+			}
+		}
+		else
+		{
+			soRec->thePluginFactory->destroyPlugin(plugin) ;
+			releaseFactory(soRec, module) ;
+
+			if(!prec)
+			{
+				std::ostringstream buf ;
+				buf << "Plugin does not exists [module=" << module << ",plugin=" << name << "]" ;
+				throw(PluginManagerException(buf.str())) ;
+			}
+
+			// a reloaded module is loaded again from its replacement
+			loaded = (prec->thePlugin != 0) ;
 		}
-		// else
-		// ... Plugin already loaded
-	}
-	else
-	{
-		std::ostringstream buf ;
-		buf << "Plugin does not exists [module=" << module << ",plugin=" << name << "]" ;
-		throw(PluginManagerException(buf.str())) ;
 	}
 }
 
@@ -562,25 +1167,45 @@ PluginManager::loadPlugin(const std::string& module, const std::string& name) th
 bool
 PluginManager::loadPlugin(const std::string& name) throw(SharedLibraryException, PluginManagerException)
 {
-	bool found = false ;
+	std::string module ;
+	std::string plugin ;
 
-	if(theNameTransform)
-	{
-		PluginNameTransform::TransformData data ;
-		if(theNameTransform->lookup(name, data))
-		{
-			found = true ;
-			loadPlugin(data.theModule, data.thePluginName) ;
-		}
-	}
-	else
+	bool found = transformName(name, module, plugin, true) ;
+	if(found)
 	{
-		throw(PluginManagerException("No PluginNameTransform available")) ;
+		loadPlugin(module, plugin) ;
 	}
 
 	return(found) ;
 }
 
+/**
+ * Loads the named Plugins in the background on the specified ThreadPool.
+ * Each application named Plugin is loaded as with loadPlugin, so that it is already
+ * loaded when first accessed. Failures to load a Plugin are discarded, the Plugin is
+ * then loaded, or the failure reported, on first access as usual. The ThreadPool must
+ * complete the queued loads before this PluginManager is destroyed.
+ *
+ * @param names the application names of the Plugins to load
+ * @param pool the ThreadPool on which to load the Plugins
+ * @param remainLoaded set true to keep the loaded Plugins loaded, as with setRemainLoaded
+ */
+void
+PluginManager::prewarm(const std::vector<std::string>& names, ThreadPool& pool, bool remainLoaded)
+{
+	for(std::vector<std::string>::const_iterator citer = names.begin(); citer != names.end(); ++citer)
+	{
+		try
+		{
+			pool.execute(new PrewarmTask(*this, *citer, remainLoaded)) ;
+		}
+		catch(Exception&)
+		{
+			// the ThreadPool has been shutdown, the Plugin loads on first access instead
+		}
+	}
+}
+
 
 /**
  * Returns whether the named plugin has been loaded.
@@ -595,6 +1220,8 @@ PluginManager::loadPlugin(const std::string& name) throw(SharedLibraryException,
 bool
 PluginManager::isLoaded(const std::string& module, const std::string& name)
 {
+	ReadLock lock(theLock) ;
+
 	bool loaded = false ;
 
 	PluginRecord* prec = getPluginRecord(module, name) ;
@@ -622,14 +1249,11 @@ PluginManager::isLoaded(const std::string& name)
 {
 	bool loaded = false ;
 
-	if(theNameTransform)
+	std::string module ;
+	std::string plugin ;
+	if(transformName(name, module, plugin, false))
 	{
-		PluginNameTransform::TransformData data ;
-
-		if(theNameTransform->lookup(name, data))
-		{
-			loaded = isLoaded(data.theModule, data.thePluginName) ;
-		}
+		loaded = isLoaded(module, plugin) ;
 	}
 
 	return(loaded) ;
@@ -662,20 +1286,13 @@ PluginManager::isLoaded(const std::string& name)
 bool
 PluginManager::unloadPlugin(const std::string& name) throw(SharedLibraryException, PluginManagerException)
 {
-	bool found = false ;
+	std::string module ;
+	std::string plugin ;
 
-	if(theNameTransform)
-	{
-		PluginNameTransform::TransformData data ;
-		if(theNameTransform->lookup(name, data))
-		{
-			found = true ;
-			unloadPlugin(data.theModule, data.thePluginName) ;
-		}
-	}
-	else
+	bool found = transformName(name, module, plugin, true) ;
+	if(found)
 	{
-		throw(PluginManagerException("No PluginNameTransform available")) ;
+		unloadPlugin(module, plugin) ;
 	}
 
 	return(found) ;
@@ -701,6 +1318,8 @@ PluginManager::unloadPlugin(const std::string& name) throw(SharedLibraryExceptio
 bool
 PluginManager::unloadPlugin(const std::string& module, const std::string& name) throw(SharedLibraryException, PluginManagerException)
 {
+	WriteLock lock(theLock) ;
+
 	bool ret = false ;
 
 	if(isLoaded(module, name))
@@ -712,34 +1331,25 @@ PluginManager::unloadPlugin(const std::string& module, const std::string& name)
 		PluginRecord* rec = getPluginRecord(module, name) ;
 		if(rec)
 		{
-			if(rec->theRefCount == 1)
-			{
-				// we need to delete the Plugin using the PluginFactory to ensure
-				// we safely delete it
-				PluginFactory* factory = getPluginFactory(module) ;
+			// invalidate resolved Plugins before testing the reference count, a PluginResolver
+			// references the Plugin before re-checking the generation
+			__sync_add_and_fetch(&theGeneration, 1) ;
 
-				if(factory)
-				{
-					ret = true ;
-
-					unrefPlugin(*(rec->thePlugin)) ;
-					factory->destroyPlugin(rec->thePlugin) ;
-					rec->thePlugin = 0 ;
+			// we need to delete the Plugin using the PluginFactory to ensure
+			// we safely delete it
+			if(!rec->theSharedObjectRecord->thePluginFactory)
+			{
+				std::ostringstream buf ;
+				buf << "Cannot release plugin, cannot access PluginFactory [module=" << module << ",name=" << name << "]" ;
+				throw(PluginManagerException(buf.str())) ;
+			}
 
-					// was this Plugin the last from the Shared Object?
-					SharedObjectRecord* soRec = getSharedObjectRecord(module) ;
-					if(soRec->thePluginCreationCount == 0)
-					{
-						unloadSharedLibrary(module) ;
-					}
-				}
-				else
-				{
-					// references remain to the plugin!
-					std::ostringstream buf ;
-					buf << "Cannot release plugin, cannot access PluginFactory [module=" << module << ",name=" << name << "]" ;
-					throw(PluginManagerException(buf.str())) ;
-				}
+			// release the reference this PluginManager holds only if no other reference remains,
+			// a PluginResolver may still reference the Plugin transiently, until it sees the generation
+			if(__sync_bool_compare_and_swap(&rec->theRefCount, 1, 0))
+			{
+				ret = true ;
+				destroyPlugin(rec) ;
 			}
 			else
 			{
@@ -751,10 +1361,8 @@ PluginManager::unloadPlugin(const std::string& module, const std::string& name)
 		}
 		else
 		{
-			// shouldn't happen, we check the Plugin is loaded, so the record
-			// must exist
-			// @note[design] we have no internal locking at this stage, so this
-			//               assumes non-multi-threaded
+			// shouldn't happen, we check the Plugin is loaded while holding
+			// the write lock, so the record must exist
 
 			std::ostringstream buf ;
 			buf << "Internal error, cannot access Plugin Record [module=" << module << ",name=" << name << "]" ;
@@ -780,11 +1388,12 @@ PluginManager::unloadPlugin(const std::string& module, const std::string& name)
 void
 PluginManager::unloadAll() throw(SharedLibraryException, PluginManagerException)
 {
-	PluginContainer_t::iterator iter = thePlugins.begin() ;
+	WriteLock lock(theLock) ;
+
 	for(PluginContainer_t::const_iterator citer = thePlugins.begin(); citer != thePlugins.end(); ++citer)
 	{
 		PluginRecord* prec = citer->second ;
-		unloadPlugin(prec->theSharedObjectId, citer->first) ;
+		unloadPlugin(prec->theSharedObjectId, prec->thePluginInfo.getName()) ;
 	}
 }
 
@@ -808,20 +1417,13 @@ PluginManager::unloadAll() throw(SharedLibraryException, PluginManagerException)
 bool
 PluginManager::unregisterPlugin(const std::string& name) throw(SharedLibraryException, PluginManagerException)
 {
-	bool found = false ;
+	std::string module ;
+	std::string plugin ;
 
-	if(theNameTransform)
-	{
-		PluginNameTransform::TransformData data ;
-		if(theNameTransform->lookup(name, data))
-		{
-			found = true ;
-			unregisterPlugin(data.theModule, data.thePluginName) ;
-		}
-	}
-	else
+	bool found = transformName(name, module, plugin, true) ;
+	if(found)
 	{
-		throw(PluginManagerException("No PluginNameTransform available")) ;
+		unregisterPlugin(module, plugin) ;
 	}
 
 	return(found) ;
@@ -844,6 +1446,8 @@ PluginManager::unregisterPlugin(const std::string& name) throw(SharedLibraryExce
 bool
 PluginManager::unregisterPlugin(const std::string& module, const std::string& name) throw(SharedLibraryException, PluginManagerException)
 {
+	WriteLock lock(theLock) ;
+
 	bool ret = false ;
 
 	if(isRegistered(module, name))
@@ -855,247 +1459,1313 @@ PluginManager::unregisterPlugin(const std::string& module, const std::string& na
 		}
 
 		// remove the record from the registered plugins
-		PluginRange_t iterRange = thePlugins.equal_range(name) ;
-
-		PluginRecModuleEq pred(module) ;
-		PluginContainer_t::iterator iter = std::find_if(iterRange.first, iterRange.second, pred) ;
-		if(iter != iterRange.second)
+		PluginContainer_t::iterator iter = thePlugins.find(PluginKey(module, name)) ;
+		if(iter != thePlugins.end())
 		{
 			ret = true ;
 
-			PluginRecord* prec = iter->second ;
-			thePlugins.erase(iter) ;
+			// the record is retired rather than deleted, a PluginResolver may still refer to it
+			retireRecord(iter->second) ;
+			reclaimRetiredRecords() ;
+		}
+		else
+		{
+			// shouldn't happen, we check the Plugin is registered while holding
+			// the write lock, so the record must exist
+
+			std::ostringstream buf ;
+			buf << "Internal error, cannot access Plugin Record [module=" << module << ",name=" << name << "]" ;
+			throw(PluginManagerException(buf.str())) ;
+		}
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Unregisters all Plugins
+ * All Plugin are unloaded (if loaded) with a call to unloadAll() 
+ * and unregistered immediatly,
+ * If any of the registered Plugins is still referenced, a PluginManagerException
+ * will be thrown leaving all Plugins in their current loaded and registred state
+ *
+ * @param name the logical name of the Plugin to unload
+ * @throw SharedLibraryException if there is an error accessing the SharedObject
+ * @throw PluginManagerException if the Plugin is still referenced
+ */
+void
+PluginManager::unregisterAll() throw(SharedLibraryException, PluginManagerException)
+{
+	WriteLock lock(theLock) ;
+
+	// may throw
+	unloadAll() ;
+
+	while(!thePlugins.empty())
+	{
+		retireRecord(thePlugins.begin()->second) ;
+	}
+	reclaimRetiredRecords() ;
+
+	// close SharedLibraries left open without loaded Plugins, as by concurrent registration
+	for(SharedObjectContainer_t::const_iterator citer = theSharedObjects.begin(); citer != theSharedObjects.end(); ++citer)
+	{
+		if(citer->second->theSharedObject && (citer->second->thePluginCreationCount == 0))
+		{
+			unloadSharedLibrary(citer->first) ;
+		}
+	}
+}
+
+
+
+
+// Plugin Reloading
+
+/**
+ * Replaces the SharedLibrary from which the Plugins of module are created, without unloading them.
+ * The replacement is opened at path alongside the current version, without holding the
+ * lock, so requests continue to be served meanwhile. A new instance of each loaded Plugin
+ * is then created from the replacement, and subsequent accesses of the Plugin, through
+ * getPlugin, PluginHandles and PluginResolvers, return the new instance. Existing
+ * references continue to use the previous instance, which is retired: it is destroyed once
+ * its last reference is released, and the previous SharedLibrary closed once all its
+ * retired Plugins are destroyed.
+ * The Plugins remain registered under module. Registered Plugins not offered by the
+ * replacement are unregistered. If the replacement cannot be opened, or a Plugin cannot
+ * be created from it, the current version remains in place.
+ * The dynamic linker shares a module already open under the same path, so a replacement
+ * of a module in use should be installed under a new path, such as a versioned file name.
+ *
+ * @param module the SharedLibrary, as registered, of the Plugins to reload
+ * @param path the path of the replacement SharedLibrary
+ * @throw SharedLibraryException if there is an error accessing the replacement SharedLibrary
+ * @throw PluginManagerException if the replacement provides no PluginFactory, or a loaded
+ *        Plugin cannot be created from it
+ */
+void
+PluginManager::reloadModule(const std::string& module, const std::string& path) throw(SharedLibraryException, PluginManagerException)
+{
+	// open the replacement without holding the lock, requests continue to use the current version
+	ModuleDiscovery discovery ;
+	discovery.theModule = path ;
+	discoverModule(discovery) ;
+
+	if(!discovery.theError.empty())
+	{
+		throw(SharedLibraryException(discovery.theError)) ;
+	}
+
+	if(!discovery.theFactory)
+	{
+		delete discovery.theLibrary ;
+
+		std::ostringstream buf ;
+		buf << "Replacement SharedLibrary provides no PluginFactory [module=" << module << ",path=" << path << "]" ;
+		throw(PluginManagerException(buf.str())) ;
+	}
+
+	std::map<std::string, PluginInfo> offered ;
+	for(std::list<PluginInfo>::const_iterator citer = discovery.thePlugins.begin(); citer != discovery.thePlugins.end(); ++citer)
+	{
+		offered.insert(std::make_pair(citer->getName(), *citer)) ;
+	}
+
+	WriteLock lock(theLock) ;
+
+	std::vector<PluginRecord*> records ;
+	for(PluginContainer_t::const_iterator citer = thePlugins.begin(); citer != thePlugins.end(); ++citer)
+	{
+		if(citer->first.theModule == module)
+		{
+			records.push_back(citer->second) ;
+		}
+	}
+
+	// the loaded Plugins are created from the replacement before any are retired,
+	// so a failure leaves the current version in place
+	std::vector<Plugin*> replacements(records.size(), static_cast<Plugin*>(0)) ;
+	try
+	{
+		for(size_t i = 0 ; i < records.size() ; ++i)
+		{
+			const std::string& name = records[i]->thePluginInfo.getName() ;
+			if(records[i]->thePlugin && (offered.find(name) != offered.end()))
+			{
+				replacements[i] = discovery.theFactory->createPlugin(name) ;
+				if(!replacements[i])
+				{
+					std::ostringstream buf ;
+					buf << "Unexpected error creating Plugin [plugin=" << name << ",module=" << module << ",path=" << path << "]" ;
+					throw(PluginManagerException(buf.str())) ;
+				}
+			}
+		}
+	}
+	catch(...)
+	{
+		for(std::vector<Plugin*>::const_iterator citer = replacements.begin(); citer != replacements.end(); ++citer)
+		{
+			if(*citer)
+			{
+				discovery.theFactory->destroyPlugin(*citer) ;
+			}
+		}
+		releasePluginFactory(*(discovery.theLibrary), discovery.theFactory) ;
+		delete discovery.theLibrary ;
+		throw ;
+	}
+
+	// the previous version is retired, and closed once its retired Plugins are destroyed
+	SharedObjectRecord* current = getSharedObjectRecord(module) ;
+	if(current)
+	{
+		theRetiredSharedObjects.push_back(current) ;
+	}
+
+	SharedObjectRecord* soRec = new SharedObjectRecord() ;
+	soRec->theSharedObject = discovery.theLibrary ;
+	soRec->thePluginFactory = discovery.theFactory ;
+	soRec->theVersion = current ? current->theVersion + 1 : 1 ;
+	soRec->thePath = path ;
+	theSharedObjects[module] = soRec ;
+
+	// invalidate resolved Plugins before releasing the references to the retired Plugins,
+	// a PluginResolver references the Plugin before re-checking the generation
+	__sync_add_and_fetch(&theGeneration, 1) ;
+
+	time_t now = monotonicSeconds() ;
+	for(size_t i = 0 ; i < records.size() ; ++i)
+	{
+		PluginRecord* prec = records[i] ;
+		PluginKey key(module, prec->thePluginInfo.getName()) ;
+		std::map<std::string, PluginInfo>::const_iterator info = offered.find(key.theName) ;
+
+		if(replacements[i])
+		{
+			retireRecord(prec) ;
+
+			PluginRecord* next = addPluginRecord(module, info->second) ;
+			next->thePlugin = replacements[i] ;
+			next->theSharedObjectRecord = soRec ;
+			next->theRemainLoadedFlag = prec->theRemainLoadedFlag ;
+			next->theIdleTime = now ;
+			soRec->thePluginCreationCount++ ;
+			theLoadedPlugins.insert(PluginIndex_t::value_type(next->thePlugin, next)) ;
+
+			// initial reference for the reference this PluginManager holds
+			refRecord(next) ;
 
-			delete prec ;
-			prec = 0 ;
+			retirePlugin(prec) ;
+		}
+		else if(prec->thePlugin)
+		{
+			// no longer offered, existing references continue to use the retired Plugin
+			retireRecord(prec) ;
+			retirePlugin(prec) ;
+		}
+		else if(info != offered.end())
+		{
+			prec->thePluginInfo = info->second ;
+			prec->theSharedObjectRecord = 0 ;
 		}
 		else
 		{
-			// shouldn't happen, we check the Plugin is registered, so the record
-			// must exist
-			// @note[design] we have no internal locking at this stage, so this
-			//               assumes non-multi-threaded
+			retireRecord(prec) ;
+		}
+	}
+
+	// the previous version may have had no loaded Plugins, or none still referenced
+	if(current && (std::find(theRetiredSharedObjects.begin(), theRetiredSharedObjects.end(), current) != theRetiredSharedObjects.end()))
+	{
+		if(current->thePluginCreationCount == 0)
+		{
+			closeRetiredSharedLibrary(current) ;
+		}
+	}
+
+	reclaimRetiredRecords() ;
+}
+
+/**
+ * Returns the number of times the specified module has been reloaded
+ *
+ * @see reloadModule
+ * @param module the SharedLibrary, as registered
+ * @return the version of module, 0 if never reloaded or not known
+ */
+unsigned int
+PluginManager::getModuleVersion(const std::string& module) const
+{
+	ReadLock lock(theLock) ;
+
+	SharedObjectRecord* soRec = getSharedObjectRecord(module) ;
+	return(soRec ? soRec->theVersion : 0) ;
+}
+
+/**
+ * Returns the number of retired Plugin instances still referenced.
+ * Retired Plugins are those replaced by reloadModule, and are destroyed once
+ * their last reference is released.
+ *
+ * @see reloadModule
+ * @return the number of retired Plugins not yet destroyed
+ */
+size_t
+PluginManager::getRetiredCount() const
+{
+	ReadLock lock(theLock) ;
+
+	return(theRetiredCount) ;
+}
+
+/**
+ * Returns a snapshot of the instrumentation of each registered Plugin.
+ * Counters are read without stopping concurrent calls, so calls completing while
+ * the snapshot is taken may be partially counted.
+ *
+ * @see setInstrumented
+ * @param statistics populated with the PluginStatistics of each registered Plugin
+ * @return statistics populated
+ */
+std::list<PluginStatistics>&
+PluginManager::getStatistics(std::list<PluginStatistics>& statistics) const
+{
+	ReadLock lock(theLock) ;
+
+	for(PluginContainer_t::const_iterator citer = thePlugins.begin(); citer != thePlugins.end(); ++citer)
+	{
+		statistics.push_back(PluginStatistics()) ;
+		copyStatistics(citer->second, statistics.back()) ;
+	}
+
+	return(statistics) ;
+}
+
+/**
+ * Returns a snapshot of the instrumentation of the specified Plugin
+ *
+ * @see setInstrumented
+ * @param module the SharedLibrary of the Plugin
+ * @param name the Plugin name
+ * @param statistics populated with the PluginStatistics of the Plugin
+ * @return true if the Plugin is registered, false otherwise
+ */
+bool
+PluginManager::getStatistics(const std::string& module, const std::string& name, PluginStatistics& statistics) const
+{
+	ReadLock lock(theLock) ;
+
+	PluginRecord* prec = getPluginRecord(module, name) ;
+	if(prec)
+	{
+		copyStatistics(prec, statistics) ;
+	}
+
+	return(prec != 0) ;
+}
+
+/**
+ * Clears the recorded load timings and calls of every registered Plugin
+ *
+ */
+void
+PluginManager::resetStatistics()
+{
+	WriteLock lock(theLock) ;
+
+	for(PluginContainer_t::iterator iter = thePlugins.begin(); iter != thePlugins.end(); ++iter)
+	{
+		PluginRecord* prec = iter->second ;
+		prec->theLoadCount = 0 ;
+		prec->theOpenTime = 0 ;
+		prec->theFactoryTime = 0 ;
+		prec->theCreateTime = 0 ;
+		prec->theCallCount = 0 ;
+		prec->theCallTime = 0 ;
+		for(size_t i = 0 ; i < PluginStatistics::BUCKET_COUNT ; ++i)
+		{
+			prec->theCallHistogram[i] = 0 ;
+		}
+	}
+}
+
+
+
+
+// Plugin Access
+
+/**
+ * Returns direct access to the named Plugin.
+ * This method returns direct access to the managed Plugin, the user
+ * must update the reference count of the Plugin through a call to refPlugin
+ * and unreference the Plugin with a call to unrefPlugin when complete.
+ * The user should consider using a PluginHandle to automatically handle
+ * reference counting.
+ * The Plugin remains managed by thie PluginManager, the user MUST NOT
+ * attemp to delete the Plugin.
+ *
+ * @param module the SharedLibrary to access
+ * @param name the Plugin to access
+ * @throw SharedLibraryException if there is an error accessing the SharedObject
+ * @throw PluginManagerException if the Plugin is not loaded, or does not exist
+ * @return the named Plugin
+ * @note [design] we return a pointer here over a reference to allow the user to
+ *       lose their handle to the plugin at any point (by setting their pointer to zero).
+ *       This lets the users unreference their Plugin and call unrefPlugin without
+ *       having to wait for the handle to the plugin to fall out of scope, as would
+ *       happen if we were tp return a reference.
+ */
+cutil::Plugin*
+PluginManager::getPlugin(const std::string& module, const std::string& name) throw(SharedLibraryException, PluginManagerException)
+{
+	cutil::Plugin* plugin = 0 ;
+	bool registered = false ;
+	bool autoload = false ;
+
+	// loaded Plugins are returned under the read lock
+	{
+		ReadLock lock(theLock) ;
+
+		PluginRecord* prec = getPluginRecord(module, name) ;
+		if(prec)
+		{
+			plugin = prec->thePlugin ;
+			registered = true ;
+		}
+		autoload = theAutoLoadFlag ;
+	}
+
+	if(!plugin)
+	{
+		if(!registered)
+		{
+			std::ostringstream buf ;
+			buf << "Plugin does not exists [module=" << module << ",plugin=" << name << "]" ;
+			throw(PluginManagerException(buf.str())) ;
+		}
+
+		// the Plugin may be unloaded again before it is accessed
+		while(!plugin && autoload)
+		{
+			// may throw SharedLibraryException, loads without holding the lock
+			loadPlugin(module, name) ;
+
+			ReadLock lock(theLock) ;
+
+			PluginRecord* prec = getPluginRecord(module, name) ;
+			if(prec)
+			{
+				plugin = prec->thePlugin ;
+			}
+			autoload = theAutoLoadFlag ;
+		}
+
+		if(!plugin)
+		{
+			std::ostringstream buf ;
+			buf << "Plugin is not loaded [module=" << module << ",plugin=" << name << "]" ;
+			throw(PluginManagerException(buf.str())) ;
+		}
+	}
+
+	return(plugin) ;
+}
+
+/**
+ * Returns direct access to the named Plugin.
+ * This method returns direct access to the managed Plugin, the user
+ * must update the reference count of the Plugin through a call to refPlugin
+ * and unreference the Plugin with a call to unrefPlugin when complete.
+ * The user should consider using a PluginHandle to automatically handle
+ * reference counting.
+ * The Plugin remains managed by thie PluginManager, the user MUST NOT
+ * attemp to delete the Plugin.
+ *
+ * @param module the SharedLibrary to access
+ * @param name the Plugin to access
+ * @throw SharedLibraryException if there is an error accessing the SharedObject
+ * @throw PluginManagerException if the Plugin is not loaded, or does not exist
+ * @return the named Plugin
+ */
+cutil::Plugin*
+PluginManager::getPlugin(const std::string& name) throw(SharedLibraryException, PluginManagerException)
+{
+	std::string module ;
+	std::string plugin ;
+	if(!transformName(name, module, plugin, true))
+	{
+		std::ostringstream buf ;
+		buf << "No lookup found within PluginNameTransform for specified plugin name [" << name << "]" ;
+		throw(PluginManagerException(buf.str())) ;
+	}
+
+	return(getPlugin(module, plugin)) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// Reference Counting
+
+/**
+ * Decrements the use count of the specified Plugin by one.
+ * The reference count of the Plugin is automatically handled
+ * by the PluginHandle class. If only the reference held by this
+ * PluginManager remains, the Plugin is unloaded unless it is to remain loaded.
+ * This method is an internal reference counting method used by
+ * the PluginHandle class to maintain reference counts of used Plugins.
+ *
+ * @param handle the Plugin of which to decrement the reference count
+ */
+void
+PluginManager::unrefPlugin(const Plugin& plugin)
+{
+	PluginRecord* prec = 0 ;
+	{
+		ReadLock lock(theLock) ;
+		prec = getPluginRecord(plugin) ;
+	}
+
+	// the caller holds a reference, so the record remains valid outside the lock
+	if(prec)
+	{
+		releaseRecord(prec) ;
+	}
+}
+
+/**
+ * Increments the use count of the specified Plugin by one.
+ * The reference count of the Plugin is automatically handled
+ * by the PluginHandle class.
+ * This method is an internal reference counting method used by
+ * the PluginHandle class to maintain reference counts of used Plugins.
+ *
+ * @param handle the Plugin of which to increment the reference count 
+ */
+void
+PluginManager::refPlugin(const Plugin& plugin)
+{
+	acquirePlugin(plugin) ;
+}
+
+/**
+ * Returns the PluginRecord of the specified Plugin with its reference count incremented by one.
+ * A loaded Plugin is looked up within the published snapshot of the registry without locking.
+ * The Plugin is loaded if it is not loaded and auto loading is enabled.
+ *
+ * @param module the SharedLibrary containing the Plugin
+ * @param name the Plugin name
+ * @return the referenced PluginRecord
+ * @throw SharedLibraryException if there is an error accessing the SharedLibrary
+ * @throw PluginManagerException if the Plugin is not registered or cannot be loaded
+ */
+PluginManager::PluginRecord*
+PluginManager::acquirePlugin(const std::string& module, const std::string& name) throw(SharedLibraryException, PluginManagerException)
+{
+	PluginRecord* prec = 0 ;
+
+	// records within the snapshot are not freed until this read is left
+	ReaderSlot* slot = enterRead() ;
+	try
+	{
+		const PluginContainer_t* snapshot = theSnapshot ;
+		if(snapshot)
+		{
+			PluginContainer_t::const_iterator citer = snapshot->find(PluginKey(module, name)) ;
+			if((citer != snapshot->end()) && tryRefRecord(citer->second))
+			{
+				prec = citer->second ;
+			}
+		}
+	}
+	catch(...)
+	{
+		leaveRead(slot) ;
+		throw ;
+	}
+	leaveRead(slot) ;
+
+	// the reference keeps the Plugin loaded, unless it was retired by a reload in the meantime
+	if(prec && (!prec->thePlugin || prec->theRetiredFlag))
+	{
+		dropRecord(prec) ;
+		prec = 0 ;
+	}
+
+	while(!prec)
+	{
+		// the reference is taken while holding the lock, so the Plugin cannot be unloaded before it is referenced
+		{
+			ReadLock lock(theLock) ;
+
+			// republish the registry changed since the last lookup
+			if(!theSnapshot)
+			{
+				publishSnapshot() ;
+			}
+
+			prec = getPluginRecord(module, name) ;
+			if(prec && prec->thePlugin)
+			{
+				refRecord(prec) ;
+			}
+			else
+			{
+				prec = 0 ;
+			}
+		}
+
+		if(!prec)
+		{
+			// may load the Plugin, or throw, the Plugin may be unloaded again before it is referenced
+			getPlugin(module, name) ;
+		}
+	}
+
+	return(prec) ;
+}
+
+/**
+ * Returns the PluginRecord of the Plugin with the specified application name
+ * with its reference count incremented by one.
+ *
+ * @param name the application specific Plugin name
+ * @return the referenced PluginRecord
+ * @throw SharedLibraryException if there is an error accessing the SharedLibrary
+ * @throw PluginManagerException if the name cannot be transformed or the Plugin cannot be loaded
+ */
+PluginManager::PluginRecord*
+PluginManager::acquirePlugin(const std::string& name) throw(SharedLibraryException, PluginManagerException)
+{
+	std::string module ;
+	std::string plugin ;
+	if(!transformName(name, module, plugin, true))
+	{
+		std::ostringstream buf ;
+		buf << "No lookup found within PluginNameTransform for specified plugin name [" << name << "]" ;
+		throw(PluginManagerException(buf.str())) ;
+	}
+
+	return(acquirePlugin(module, plugin)) ;
+}
+
+/**
+ * Returns the PluginRecord of the specified loaded Plugin with its reference count incremented by one.
+ *
+ * @param plugin the Plugin to reference
+ * @return the referenced PluginRecord, or 0 if the Plugin is not loaded by this PluginManager
+ */
+PluginManager::PluginRecord*
+PluginManager::acquirePlugin(const Plugin& plugin)
+{
+	ReadLock lock(theLock) ;
+
+	PluginRecord* prec = getPluginRecord(plugin) ;
+	if(prec)
+	{
+		refRecord(prec) ;
+	}
+
+	return(prec) ;
+}
+
+/**
+ * Increments the reference count of a PluginRecord already referenced by the caller.
+ * This is lock free, an existing reference prevents the Plugin being unloaded.
+ *
+ * @param prec the PluginRecord to reference
+ */
+void
+PluginManager::refRecord(PluginRecord* prec)
+{
+	__sync_add_and_fetch(&prec->theRefCount, 1) ;
+}
+
+/**
+ * Increments the reference count of a PluginRecord found without locking, unless it has
+ * dropped to zero. A loaded Plugin is referenced by this PluginManager, so the count is
+ * zero only once the Plugin is being unloaded, when it must not be referenced again.
+ *
+ * @param prec the PluginRecord to reference
+ * @return true if the PluginRecord was referenced, false otherwise
+ */
+bool
+PluginManager::tryRefRecord(PluginRecord* prec)
+{
+	int count = prec->theRefCount ;
+	while(count > 0)
+	{
+		int prev = __sync_val_compare_and_swap(&prec->theRefCount, count, count + 1) ;
+		if(prev == count)
+		{
+			return(true) ;
+		}
+		count = prev ;
+	}
+
+	return(false) ;
+}
+
+/**
+ * Decrements the reference count of the specified PluginRecord.
+ * The reference count is decremented without locking unless the release
+ * leaves only the reference held by this PluginManager, in which case the
+ * Plugin is unloaded under the write lock if it is not to remain loaded.
+ * With an idle timeout the Plugin instead becomes idle without locking, and
+ * expired Plugins are evicted only if the write lock is free, otherwise by a
+ * later release or evictIdle.
+ *
+ * @param prec the PluginRecord to release
+ */
+void
+PluginManager::releaseRecord(PluginRecord* prec)
+{
+	bool released = false ;
+	int count = prec->theRefCount ;
+	bool idle = (__atomic_load_n(&theIdleTimeout, __ATOMIC_RELAXED) != 0) ;
+	time_t now = 0 ;
+
+	// fast path, while other references remain the Plugin cannot be unloaded by this release,
+	// nor can an idle Plugin which remains loaded until evicted
+	while(!released && ((count > 2) || ((prec->theRemainLoadedFlag || idle) && (count > 1))))
+	{
+		if(idle && (count == 2))
+		{
+			// the idle time is recorded before the reference is released, eviction tests the count first
+			now = monotonicSeconds() ;
+			__atomic_store_n(&prec->theIdleTime, now, __ATOMIC_RELAXED) ;
+		}
+
+		int prev = __sync_val_compare_and_swap(&prec->theRefCount, count, count - 1) ;
+		released = (prev == count) ;
+		count = prev ;
+	}
+
+	if(released)
+	{
+		// expired Plugins are evicted at most once a second, and not while others hold the lock
+		if(idle && (count == 2) && (now != __atomic_load_n(&theEvictionTime, __ATOMIC_RELAXED)) && theLock.tryWriteLock())
+		{
+			try
+			{
+				evictPlugins(0) ;
+			}
+			catch(...)
+			{
+				theLock.unlock() ;
+				throw ;
+			}
+			theLock.unlock() ;
+		}
+	}
+	else
+	{
+		// this may be the last reference, the caller's reference keeps the record
+		// valid until the write lock is held
+		WriteLock lock(theLock) ;
+
+		int remaining = __sync_sub_and_fetch(&prec->theRefCount, 1) ;
+		if(prec->theRetiredFlag)
+		{
+			// this PluginManager no longer references a retired Plugin
+			if((remaining == 0) && prec->thePlugin)
+			{
+				destroyRetiredPlugin(prec) ;
+				reclaimRetiredRecords() ;
+			}
+		}
+		else if((remaining == 1) && (!prec->theRemainLoadedFlag) && prec->thePlugin)
+		{
+			if(theIdleTimeout == 0)
+			{
+				// unloading the Plugin will automatically unload the SharedLibrary, if required
+				unloadUnreferenced(prec) ;
+			}
+			else
+			{
+				// the idle timeout was set meanwhile, the idle Plugin remains loaded until evicted
+				__atomic_store_n(&prec->theIdleTime, monotonicSeconds(), __ATOMIC_RELAXED) ;
+			}
+		}
+	}
+}
+
+/**
+ * Decrements the reference count of a PluginRecord referenced only to test its validity.
+ * A retired Plugin is destroyed if this was its last reference, and a Plugin whose
+ * unload was skipped while this reference was held is unloaded.
+ *
+ * @param prec the PluginRecord to release
+ */
+void
+PluginManager::dropRecord(PluginRecord* prec)
+{
+	if(__sync_sub_and_fetch(&prec->theRefCount, 1) < 2)
+	{
+		WriteLock lock(theLock) ;
+
+		if(prec->theRetiredFlag)
+		{
+			if(prec->thePlugin && (prec->theRefCount == 0))
+			{
+				destroyRetiredPlugin(prec) ;
+				reclaimRetiredRecords() ;
+			}
+		}
+		else if((theIdleTimeout == 0) && (prec->theRefCount == 1) && (!prec->theRemainLoadedFlag) && prec->thePlugin)
+		{
+			// the last handle may have been released while this reference was held
+			unloadUnreferenced(prec) ;
+		}
+	}
+}
+
+/**
+ * Unloads the Plugin of the specified PluginRecord if only this PluginManager references it.
+ * Resolved Plugins are invalidated before the reference count is tested, a PluginResolver
+ * referencing the Plugin meanwhile leaves it loaded, to be unloaded when that reference
+ * is dropped. The write lock must be held.
+ *
+ * @param prec the PluginRecord of the loaded Plugin
+ * @return true if the Plugin was unloaded, false otherwise
+ * @throw SharedLibraryException if there is an error accessing the SharedObject
+ * @throw PluginManagerException if the PluginFactory cannot be accessed
+ */
+bool
+PluginManager::unloadUnreferenced(PluginRecord* prec) throw(SharedLibraryException, PluginManagerException)
+{
+	bool unloaded = false ;
+
+	// once the generation has advanced no PluginResolver can keep a new reference to the Plugin,
+	// so claiming the only reference excludes all others
+	__sync_add_and_fetch(&theGeneration, 1) ;
+	if(__sync_bool_compare_and_swap(&prec->theRefCount, 1, 0))
+	{
+		destroyPlugin(prec) ;
+		unloaded = true ;
+	}
+
+	return(unloaded) ;
+}
+
+/**
+ * Destroys the Plugin of the specified PluginRecord, whose references have all been
+ * released, closing its SharedLibrary if it was the last Plugin created from it.
+ * The write lock must be held.
+ *
+ * @param prec the PluginRecord of the unreferenced Plugin
+ * @throw SharedLibraryException if there is an error closing the SharedLibrary
+ * @throw PluginManagerException if the SharedLibrary cannot be unloaded
+ */
+void
+PluginManager::destroyPlugin(PluginRecord* prec) throw(SharedLibraryException, PluginManagerException)
+{
+	SharedObjectRecord* soRec = prec->theSharedObjectRecord ;
+
+	theLoadedPlugins.erase(prec->thePlugin) ;
+	Plugin* plugin = prec->thePlugin ;
+	prec->thePlugin = 0 ;
+	soRec->thePluginFactory->destroyPlugin(plugin) ;
+
+	releaseFactory(soRec, prec->theSharedObjectId) ;
+}
+
+/**
+ * Releases a Plugin created from, or a reservation of, the PluginFactory of the specified
+ * SharedObjectRecord. The SharedLibrary is closed once no Plugins created from it remain,
+ * whether still current or retired by a reload. The write lock must be held.
+ *
+ * @param soRec the SharedObjectRecord of the PluginFactory
+ * @param module the SharedLibrary, as registered
+ * @throw SharedLibraryException if there is an error closing the SharedLibrary
+ * @throw PluginManagerException if the SharedLibrary cannot be unloaded
+ */
+void
+PluginManager::releaseFactory(SharedObjectRecord* soRec, const std::string& module) throw(SharedLibraryException, PluginManagerException)
+{
+	soRec->thePluginCreationCount-- ;
+	if(soRec->thePluginCreationCount == 0)
+	{
+		if(getSharedObjectRecord(module) == soRec)
+		{
+			unloadSharedLibrary(module) ;
+		}
+		else
+		{
+			closeRetiredSharedLibrary(soRec) ;
+		}
+	}
+}
+
+
+
+
+
+
+
+
+//
+// Retirement
+//
+
+/**
+ * Retires the specified loaded Plugin, replaced by a reload.
+ * The reference held by this PluginManager is released, and the Plugin destroyed
+ * if no other references remain. The write lock must be held.
+ *
+ * @param prec the PluginRecord to retire
+ * @throw SharedLibraryException if there is an error destroying the Plugin
+ */
+void
+PluginManager::retirePlugin(PluginRecord* prec) throw(SharedLibraryException)
+{
+	prec->theRetiredFlag = true ;
+	prec->theRemainLoadedFlag = false ;
+	theRetiredCount++ ;
+
+	if(__sync_sub_and_fetch(&prec->theRefCount, 1) == 0)
+	{
+		destroyRetiredPlugin(prec) ;
+	}
+}
+
+/**
+ * Destroys an unreferenced retired Plugin, closing its SharedLibrary if it was the last
+ * Plugin created from it. The write lock must be held.
+ *
+ * @param prec the PluginRecord of the retired Plugin
+ * @throw SharedLibraryException if there is an error destroying the Plugin or closing the SharedLibrary
+ */
+void
+PluginManager::destroyRetiredPlugin(PluginRecord* prec) throw(SharedLibraryException)
+{
+	SharedObjectRecord* soRec = prec->theSharedObjectRecord ;
+
+	theLoadedPlugins.erase(prec->thePlugin) ;
+	Plugin* plugin = prec->thePlugin ;
+	prec->thePlugin = 0 ;
+	theRetiredCount-- ;
+	soRec->thePluginFactory->destroyPlugin(plugin) ;
+
+	soRec->thePluginCreationCount-- ;
+	if(soRec->thePluginCreationCount == 0)
+	{
+		closeRetiredSharedLibrary(soRec) ;
+	}
+}
+
+/**
+ * Closes a retired SharedLibrary once no Plugins created from it remain, releasing its
+ * PluginFactory and removing it from the retired SharedObjectRecords. The write lock must be held.
+ *
+ * @param soRec the retired SharedObjectRecord
+ * @throw SharedLibraryException if there is an error closing the SharedLibrary
+ */
+void
+PluginManager::closeRetiredSharedLibrary(SharedObjectRecord* soRec) throw(SharedLibraryException)
+{
+	std::vector<SharedObjectRecord*>::iterator iter = std::find(theRetiredSharedObjects.begin(), theRetiredSharedObjects.end(), soRec) ;
+	if(iter != theRetiredSharedObjects.end())
+	{
+		theRetiredSharedObjects.erase(iter) ;
+
+		if(soRec->theSharedObject)
+		{
+			if(soRec->thePluginFactory)
+			{
+				releasePluginFactory(*(soRec->theSharedObject), soRec->thePluginFactory) ;
+			}
+			delete soRec->theSharedObject ;
+		}
+		delete soRec ;
+	}
+}
+
+/**
+ * Removes the specified PluginRecord from the registry, retaining it until no PluginResolver
+ * or lock free lookup can still refer to it. The write lock must be held.
+ *
+ * @param prec the PluginRecord to retire
+ */
+void
+PluginManager::retireRecord(PluginRecord* prec)
+{
+	PluginContainer_t::iterator iter = thePlugins.find(PluginKey(prec->theSharedObjectId, prec->thePluginInfo.getName())) ;
+	if((iter != thePlugins.end()) && (iter->second == prec))
+	{
+		thePlugins.erase(iter) ;
+	}
+	invalidateSnapshot() ;
+
+	prec->theRetiredEpoch = __sync_fetch_and_add(&theEpoch, 1) ;
+	theRetiredRecords.push_back(prec) ;
+}
+
+/**
+ * Frees the retired PluginRecords whose Plugins have been destroyed and are no longer
+ * referenced, and the retired snapshots of the registry. Neither is freed while a thread
+ * which entered a lock free read, to look up a Plugin or test a resolved record, before its
+ * retirement is still reading, those are freed by a later call.
+ * Takes the write lock.
+ */
+void
+PluginManager::reclaimRetiredRecords()
+{
+	WriteLock lock(theLock) ;
+
+	unsigned long epoch = getReadEpoch() ;
+
+	// records are retired after the generation advanced, so a PluginResolver which starts
+	// testing its record in a later epoch finds it invalid without accessing it
+	std::vector<PluginRecord*>::iterator rend = theRetiredRecords.begin() ;
+	for(std::vector<PluginRecord*>::iterator iter = theRetiredRecords.begin(); iter != theRetiredRecords.end(); ++iter)
+	{
+		if(!(*iter)->thePlugin && ((*iter)->theRefCount == 0) && ((*iter)->theRetiredEpoch < epoch))
+		{
+			delete *iter ;
+		}
+		else
+		{
+			*rend++ = *iter ;
+		}
+	}
+	theRetiredRecords.erase(rend, theRetiredRecords.end()) ;
+
+	std::vector<std::pair<unsigned long, const PluginContainer_t*> >::iterator end = theRetiredSnapshots.begin() ;
+	for(std::vector<std::pair<unsigned long, const PluginContainer_t*> >::iterator iter = theRetiredSnapshots.begin(); iter != theRetiredSnapshots.end(); ++iter)
+	{
+		if(iter->first < epoch)
+		{
+			delete iter->second ;
+		}
+		else
+		{
+			*end++ = *iter ;
+		}
+	}
+	theRetiredSnapshots.erase(end, theRetiredSnapshots.end()) ;
+}
+
+
+
+//
+// Lock Free Lookup
+//
+
+/**
+ * Enters a lock free read of the registry by the calling thread. Records and snapshots
+ * retired from now on are not freed until the matching leaveRead. Reads must not be nested.
+ *
+ * @return the ReaderSlot of the calling thread, to pass to leaveRead
+ */
+PluginManager::ReaderSlot*
+PluginManager::enterRead()
+{
+	ReaderSlot* slot = static_cast<ReaderSlot*>(::pthread_getspecific(theReaderKey)) ;
+	if(!slot)
+	{
+		slot = claimReaderSlot() ;
+	}
+
+	// the epoch is published before anything is read, a retirement either sees this
+	// reader, or has completed before the read starts
+	slot->theEpoch = theEpoch ;
+	__sync_synchronize() ;
+
+	return(slot) ;
+}
+
+/**
+ * Leaves the lock free read entered by enterRead
+ *
+ * @param slot the ReaderSlot returned by enterRead
+ */
+void
+PluginManager::leaveRead(ReaderSlot* slot)
+{
+	__atomic_store_n(&slot->theEpoch, 0, __ATOMIC_RELEASE) ;
+}
+
+/**
+ * Claims a ReaderSlot for the calling thread, reusing the slot of an exited thread if one is free
+ *
+ * @return the claimed ReaderSlot
+ */
+PluginManager::ReaderSlot*
+PluginManager::claimReaderSlot()
+{
+	ReaderSlot* slot = theReaderSlots ;
+	while(slot && !(!slot->theOwnedFlag && __sync_bool_compare_and_swap(&slot->theOwnedFlag, 0, 1)))
+	{
+		slot = slot->theNext ;
+	}
+
+	if(!slot)
+	{
+		// slots are never removed, so are added without locking
+		slot = new ReaderSlot() ;
+		slot->theOwnedFlag = 1 ;
+		do
+		{
+			slot->theNext = theReaderSlots ;
+		} while(!__sync_bool_compare_and_swap(&theReaderSlots, slot->theNext, slot)) ;
+	}
+
+	::pthread_setspecific(theReaderKey, slot) ;
+	return(slot) ;
+}
+
+/**
+ * Frees the ReaderSlot of an exiting thread for another to claim
+ *
+ * @param slot the ReaderSlot of the exiting thread
+ */
+void
+PluginManager::releaseReaderSlot(void* slot)
+{
+	__atomic_store_n(&static_cast<ReaderSlot*>(slot)->theOwnedFlag, 0, __ATOMIC_RELEASE) ;
+}
+
+/**
+ * Returns the oldest epoch in which a thread is still reading without locking. Anything
+ * retired at an earlier epoch can no longer be reached by a reader.
+ *
+ * @return the oldest epoch still being read, or the current epoch if no thread is reading
+ */
+unsigned long
+PluginManager::getReadEpoch() const
+{
+	// the epoch is read first, a reader entering meanwhile reads this epoch or a later one
+	unsigned long epoch = __atomic_load_n(&theEpoch, __ATOMIC_SEQ_CST) ;
 
-			std::ostringstream buf ;
-			buf << "Internal error, cannot access Plugin Record [module=" << module << ",name=" << name << "]" ;
-			throw(PluginManagerException(buf.str())) ;
+	for(const ReaderSlot* slot = theReaderSlots ; slot ; slot = slot->theNext)
+	{
+		unsigned long reading = __atomic_load_n(&slot->theEpoch, __ATOMIC_ACQUIRE) ;
+		if((reading != 0) && (reading < epoch))
+		{
+			epoch = reading ;
 		}
 	}
 
-	return(ret) ;
+	return(epoch) ;
 }
 
 /**
- * Unregisters all Plugins
- * All Plugin are unloaded (if loaded) with a call to unloadAll() 
- * and unregistered immediatly,
- * If any of the registered Plugins is still referenced, a PluginManagerException
- * will be thrown leaving all Plugins in their current loaded and registred state
- *
- * @param name the logical name of the Plugin to unload
- * @throw SharedLibraryException if there is an error accessing the SharedObject
- * @throw PluginManagerException if the Plugin is still referenced
+ * Publishes a snapshot of the registered Plugins, if none is published, for lock free lookup.
+ * The read or write lock must be held.
  */
 void
-PluginManager::unregisterAll() throw(SharedLibraryException, PluginManagerException)
+PluginManager::publishSnapshot()
 {
-	// may throw
-	unloadAll() ;
-
-	PluginContainer_t::iterator iter = thePlugins.begin() ;
-	while(iter != thePlugins.end())
+	// concurrent readers may each copy the registry, the first to publish its copy wins
+	const PluginContainer_t* snapshot = new PluginContainer_t(thePlugins) ;
+	if(!__sync_bool_compare_and_swap(&theSnapshot, static_cast<const PluginContainer_t*>(0), snapshot))
 	{
-		PluginContainer_t::iterator next = iter ;
-		++next ;
-
-		PluginRecord* prec = iter->second ;
-		thePlugins.erase(iter) ;
-
-		delete prec ;
-		prec = 0 ;
-
-		iter = next ;
+		delete snapshot ;
 	}
 }
 
+/**
+ * Withdraws the published snapshot of the registered Plugins, as the registry has changed.
+ * The next locked lookup publishes a new snapshot. The write lock must be held.
+ */
+void
+PluginManager::invalidateSnapshot()
+{
+	const PluginContainer_t* snapshot = theSnapshot ;
+	if(snapshot)
+	{
+		theSnapshot = 0 ;
+		theRetiredSnapshots.push_back(std::make_pair(__sync_fetch_and_add(&theEpoch, 1), snapshot)) ;
+	}
+}
 
 
 
-// Plugin Access
+//
+// Eviction
+//
 
 /**
- * Returns direct access to the named Plugin.
- * This method returns direct access to the managed Plugin, the user
- * must update the reference count of the Plugin through a call to refPlugin
- * and unreference the Plugin with a call to unrefPlugin when complete.
- * The user should consider using a PluginHandle to automatically handle
- * reference counting.
- * The Plugin remains managed by thie PluginManager, the user MUST NOT
- * attemp to delete the Plugin.
+ * Unloads the idle Plugins which have exceeded the idle timeout, then evicts
+ * idle SharedLibraries to meet the memory budget.
  *
- * @param module the SharedLibrary to access
- * @param name the Plugin to access
- * @throw SharedLibraryException if there is an error accessing the SharedObject
- * @throw PluginManagerException if the Plugin is not loaded, or does not exist
- * @return the named Plugin
- * @note [design] we return a pointer here over a reference to allow the user to
- *       lose their handle to the plugin at any point (by setting their pointer to zero).
- *       This lets the users unreference their Plugin and call unrefPlugin without
- *       having to wait for the handle to the plugin to fall out of scope, as would
- *       happen if we were tp return a reference.
+ * @param keep a Plugin not to evict, although idle, or 0
+ * @return the number of Plugins unloaded
+ * @throw SharedLibraryException if there is an error accessing a SharedLibrary
+ * @throw PluginManagerException if a Plugin cannot be unloaded
  */
-cutil::Plugin*
-PluginManager::getPlugin(const std::string& module, const std::string& name) throw(SharedLibraryException, PluginManagerException)
+size_t
+PluginManager::evictPlugins(const PluginRecord* keep) throw(SharedLibraryException, PluginManagerException)
 {
-	cutil::Plugin* plugin = 0 ;
+	WriteLock lock(theLock) ;
 
-	PluginRecord* prec = getPluginRecord(module, name) ;
+	size_t evicted = 0 ;
+	time_t now = monotonicSeconds() ;
+	__atomic_store_n(&theEvictionTime, now, __ATOMIC_RELAXED) ;
 
-	if(prec)
+	// idle Plugins are referenced only by this PluginManager, the write lock prevents new references
+	std::vector<PluginRecord*> expired ;
+	std::vector<PluginRecord*> idle ;
+	for(PluginIndex_t::const_iterator citer = theLoadedPlugins.begin(); citer != theLoadedPlugins.end(); ++citer)
 	{
-		if(!isLoaded(module, name) && theAutoLoadFlag)
+		PluginRecord* prec = citer->second ;
+		if((prec != keep) && (prec->theRefCount == 1) && !prec->theRemainLoadedFlag && !prec->theRetiredFlag)
 		{
-			// may throw SharedLibraryException
-			loadPlugin(module, name) ;
+			if((theIdleTimeout > 0) && (now - __atomic_load_n(&prec->theIdleTime, __ATOMIC_RELAXED) >= theIdleTimeout))
+			{
+				expired.push_back(prec) ;
+			}
+			else
+			{
+				idle.push_back(prec) ;
+			}
 		}
+	}
 
-		if(isLoaded(module, name))
-		{
-			plugin = prec->thePlugin ;
-		}
-		else
+	// a Plugin referenced since it was found idle is skipped
+	for(std::vector<PluginRecord*>::const_iterator citer = expired.begin(); citer != expired.end(); ++citer)
+	{
+		if(unloadUnreferenced(*citer))
 		{
-			std::ostringstream buf ;
-			buf << "Plugin is not loaded [module=" << module << ",plugin=" << name << "]" ;
-			throw(PluginManagerException(buf.str())) ;
+			evicted++ ;
 		}
 	}
-	else
+
+	size_t usage = (theMemoryBudget > 0) ? getMemoryUsage() : 0 ;
+	if(usage > theMemoryBudget)
 	{
-		std::ostringstream buf ;
-		buf << "Plugin does not exists [module=" << module << ",plugin=" << name << "]" ;
-		throw(PluginManagerException(buf.str())) ;
-	}
+		// SharedLibraries without loaded Plugins, as left open by registration, are closed first
+		std::vector<std::string> unused ;
+		for(SharedObjectContainer_t::const_iterator citer = theSharedObjects.begin(); citer != theSharedObjects.end(); ++citer)
+		{
+			if(citer->second->theSharedObject && (citer->second->thePluginCreationCount == 0))
+			{
+				unused.push_back(citer->first) ;
+			}
+		}
 
-	return(plugin) ;
-}
+		for(std::vector<std::string>::const_iterator citer = unused.begin(); (citer != unused.end()) && (usage > theMemoryBudget); ++citer)
+		{
+			usage -= getSharedObjectRecord(*citer)->theSharedObject->getMappedSize() ;
+			unloadSharedLibrary(*citer) ;
+		}
 
-/**
- * Returns direct access to the named Plugin.
- * This method returns direct access to the managed Plugin, the user
- * must update the reference count of the Plugin through a call to refPlugin
- * and unreference the Plugin with a call to unrefPlugin when complete.
- * The user should consider using a PluginHandle to automatically handle
- * reference counting.
- * The Plugin remains managed by thie PluginManager, the user MUST NOT
- * attemp to delete the Plugin.
- *
- * @param module the SharedLibrary to access
- * @param name the Plugin to access
- * @throw SharedLibraryException if there is an error accessing the SharedObject
- * @throw PluginManagerException if the Plugin is not loaded, or does not exist
- * @return the named Plugin
- */
-cutil::Plugin*
-PluginManager::getPlugin(const std::string& name) throw(SharedLibraryException, PluginManagerException)
-{
-	Plugin* plugin ;
-	if(theNameTransform)
-	{
-		PluginNameTransform::TransformData data ;
-		if(theNameTransform->lookup(name, data))
+		// then SharedLibraries whose loaded Plugins are all idle, least recently used first
+		std::map<SharedObjectRecord*, std::vector<PluginRecord*> > modules ;
+		for(std::vector<PluginRecord*>::const_iterator citer = idle.begin(); citer != idle.end(); ++citer)
 		{
-			plugin = getPlugin(data.theModule, data.thePluginName) ;
+			modules[(*citer)->theSharedObjectRecord].push_back(*citer) ;
 		}
-		else
+
+		std::vector<std::pair<time_t, SharedObjectRecord*> > candidates ;
+		for(std::map<SharedObjectRecord*, std::vector<PluginRecord*> >::const_iterator citer = modules.begin(); citer != modules.end(); ++citer)
 		{
-			std::ostringstream buf ;
-			buf << "No lookup found within PluginNameTransform for specified plugin name [" << name << "]" ;
-			throw(PluginManagerException(buf.str())) ;
+			if(static_cast<int>(citer->second.size()) == citer->first->thePluginCreationCount)
+			{
+				time_t used = 0 ;
+				for(std::vector<PluginRecord*>::const_iterator piter = citer->second.begin(); piter != citer->second.end(); ++piter)
+				{
+					used = std::max(used, __atomic_load_n(&(*piter)->theIdleTime, __ATOMIC_RELAXED)) ;
+				}
+				candidates.push_back(std::make_pair(used, citer->first)) ;
+			}
+		}
+		std::sort(candidates.begin(), candidates.end()) ;
+
+		for(size_t i = 0 ; (i < candidates.size()) && (usage > theMemoryBudget) ; ++i)
+		{
+			SharedObjectRecord* soRec = candidates[i].second ;
+			size_t size = soRec->theSharedObject->getMappedSize() ;
+
+			// a Plugin referenced since it was found idle is skipped, leaving its SharedLibrary open
+			const std::vector<PluginRecord*>& plugins = modules[soRec] ;
+			for(std::vector<PluginRecord*>::const_iterator citer = plugins.begin(); citer != plugins.end(); ++citer)
+			{
+				if(unloadUnreferenced(*citer))
+				{
+					evicted++ ;
+				}
+			}
+
+			// unloading the last Plugin closes the SharedLibrary
+			if(!soRec->theSharedObject)
+			{
+				usage -= size ;
+			}
 		}
-	}
-	else
-	{
-		throw(PluginManagerException("No PluginNameTransform available")) ;
 	}
 
-	return(plugin) ;
+	return(evicted) ;
 }
 
 
-//-------------------------------------------------------------------------------//
-// Reference Counting
+
+//
+// Instrumentation
+//
 
 /**
- * Decrements the use count of the specified Plugin by one.
- * The reference count of the Plugin is automatically handled
- * by the PluginHandle class. The Plugin use count of the
- * ShreadLibrary containing the Plugin is decremented by one.
- * This method is an internal reference counting method used by
- * the PluginHandle class to maintain reference counts of used Plugins.
+ * Populates a PluginStatistics snapshot from the specified PluginRecord.
+ * The read or write lock must be held.
  *
- * @param handle the Plugin of which to decrement the reference count
+ * @param prec the PluginRecord
+ * @param statistics populated from prec
  */
 void
-PluginManager::unrefPlugin(const Plugin& plugin)
+PluginManager::copyStatistics(const PluginRecord* prec, PluginStatistics& statistics)
 {
-	PluginRecord* prec = getPluginRecord(plugin) ;
-	if(prec)
+	int count = prec->theRefCount ;
+	bool loaded = (prec->thePlugin != 0) && !prec->theRetiredFlag ;
+
+	statistics.theModule = prec->theSharedObjectId ;
+	statistics.theName = prec->thePluginInfo.getName() ;
+	statistics.theLoadedFlag = loaded ;
+
+	// a loaded Plugin holds the reference of this PluginManager
+	statistics.theHandleCount = (loaded && (count > 0)) ? count - 1 : count ;
+
+	statistics.theLoadCount = prec->theLoadCount ;
+	statistics.theOpenTime = prec->theOpenTime ;
+	statistics.theFactoryTime = prec->theFactoryTime ;
+	statistics.theCreateTime = prec->theCreateTime ;
+	statistics.theCallCount = prec->theCallCount ;
+	statistics.theCallTime = prec->theCallTime ;
+	for(size_t i = 0 ; i < PluginStatistics::BUCKET_COUNT ; ++i)
 	{
-		prec->theRefCount-- ;
-		std::cout << plugin.getInfo().getName() << ": Ref Count=" << prec->theRefCount << std::endl ;
-
-		SharedObjectContainer_t::const_iterator citer = theSharedObjects.find(prec->theSharedObjectId) ;
-		if(citer != theSharedObjects.end())
-		{
-			SharedObjectRecord* soRec = citer->second ;
-			soRec->thePluginCreationCount-- ;
-		}
-
-		// do we automatically unload the Plugin
-		if((prec->theRefCount == 1) && (!prec->theRemainLoadedFlag))
-		{
-			// unloading the Plugin will automatically unload the SharedLibrary, if required
-			unloadPlugin(prec->theSharedObjectId, plugin.getInfo().getName()) ;
-		}
+		statistics.theCallHistogram[i] = prec->theCallHistogram[i] ;
 	}
 }
 
 /**
- * Increments the use count of the specified Plugin by one.
- * The reference count of the Plugin is automatically handled
- * by the PluginHandle class. The Plugin use count of the
- * ShreadLibrary containing the Plugin is Incremented by one.
- * This method is an internal reference counting method used by
- * the PluginHandle class to maintain reference counts of used Plugins.
+ * Returns the current time of the monotonic clock, in nanoseconds
+ */
+unsigned long long
+PluginManager::monotonicTime()
+{
+	return(monotonicNanoseconds()) ;
+}
+
+/**
+ * Records a call made through a PluginHandle to the Plugin of the specified PluginRecord,
+ * taking the latency of the call as the time since start. This is lock free.
  *
- * @param handle the Plugin of which to increment the reference count 
+ * @param prec the referenced PluginRecord of the called Plugin
+ * @param start the monotonicTime at which the call was made
  */
 void
-PluginManager::refPlugin(const Plugin& plugin)
+PluginManager::recordCall(PluginRecord* prec, unsigned long long start)
 {
-	PluginRecord* rec = getPluginRecord(plugin) ;
-	if(rec)
-	{
-		rec->theRefCount++ ;
-		std::cout << plugin.getInfo().getName() << ": Ref Count=" << rec->theRefCount << std::endl ;
+	unsigned long long latency = monotonicTime() - start ;
 
-		SharedObjectContainer_t::const_iterator citer = theSharedObjects.find(rec->theSharedObjectId) ;
-		if(citer != theSharedObjects.end())
-		{
-			SharedObjectRecord* soRec = citer->second ;
-			soRec->thePluginCreationCount++ ;
-		}
-	}
+	__sync_add_and_fetch(&prec->theCallCount, 1) ;
+	__sync_add_and_fetch(&prec->theCallTime, latency) ;
+	__sync_add_and_fetch(&prec->theCallHistogram[PluginStatistics::getBucket(latency)], 1) ;
 }
 
 
 
 
-
-
-
-
 //
 // Helper Methods
 //
@@ -1112,11 +2782,8 @@ PluginManager::getPluginRecord(const std::string& module, const std::string& nam
 {
 	PluginRecord* prec = 0 ;
 
-	ConstPluginRange_t iterRange = thePlugins.equal_range(name) ;
-
-	PluginRecModuleEq pred(module) ;
-	PluginContainer_t::const_iterator iter = std::find_if(iterRange.first, iterRange.second, pred) ;
-	if(iter != iterRange.second)
+	PluginContainer_t::const_iterator iter = thePlugins.find(PluginKey(module, name)) ;
+	if(iter != thePlugins.end())
 	{
 		prec = iter->second ;
 	}
@@ -1135,11 +2802,8 @@ PluginManager::getPluginRecord(const Plugin& plugin) const
 {
 	PluginRecord* prec = 0 ;
 
-	ConstPluginRange_t iterRange = thePlugins.equal_range(plugin.getInfo().getName()) ;
-
-	PluginRecPluginEq pred(plugin) ;
-	PluginContainer_t::const_iterator iter = std::find_if(iterRange.first, iterRange.second, pred) ;
-	if(iter != iterRange.second)
+	PluginIndex_t::const_iterator iter = theLoadedPlugins.find(&plugin) ;
+	if(iter != theLoadedPlugins.end())
 	{
 		prec = iter->second ;
 	}
@@ -1147,6 +2811,28 @@ PluginManager::getPluginRecord(const Plugin& plugin) const
 	return(prec) ;
 }
 
+/**
+ * Creates and registers the PluginRecord for the specified Plugin
+ *
+ * @param module the SharedLibrary containing the Plugin
+ * @param info the PluginInfo of the Plugin
+ * @return the new PluginRecord
+ */
+PluginManager::PluginRecord*
+PluginManager::addPluginRecord(const std::string& module, const PluginInfo& info)
+{
+	PluginRecord* prec = new PluginRecord() ;
+	prec->theSharedObjectId = module ;
+	prec->thePluginInfo = info ;
+	prec->theRemainLoadedFlag = false ;
+	prec->theRefCount = 0 ;
+
+	thePlugins.insert(PluginContainer_t::value_type(PluginKey(module, info.getName()), prec)) ;
+	invalidateSnapshot() ;
+
+	return(prec) ;
+}
+
 /**
  * Accesses the registered SharedLibraries and returns the SharedObjectRecord for the specified SharedLibrary
  *
@@ -1185,6 +2871,7 @@ PluginManager::registerSharedLibrary(const std::string& module)
 		record->theSharedObject = 0 ;
 		record->thePluginCreationCount = 0 ;
 		record->thePluginFactory = 0 ;
+		record->thePath = module ;
 
 		theSharedObjects.insert(std::pair<std::string, SharedObjectRecord*>(module, record)) ;
 	}
@@ -1215,7 +2902,7 @@ PluginManager::getSharedLibrary(const std::string& module) throw (SharedLibraryE
 		}
 		else
 		{
-			lib = new SharedLibrary(module) ;
+			lib = new SharedLibrary(soRec->thePath) ;
 			soRec->theSharedObject = lib ;
 		}
 	}
@@ -1251,6 +2938,7 @@ PluginManager::unloadSharedLibrary(const std::string& module) throw (SharedLibra
 			if(soRec->thePluginFactory)
 			{
 				releasePluginFactory(*(soRec->theSharedObject), soRec->thePluginFactory) ;
+				soRec->thePluginFactory = 0 ;
 			}
 
 			if(soRec->theSharedObject)
@@ -1370,35 +3058,152 @@ PluginManager::getPluginFactory(const std::string& module) throw (SharedLibraryE
 	return(factory) ;
 }
 
+/**
+ * Lists the Plugins of the specified SharedLibrary.
+ * A SharedLibrary open with its PluginFactory is listed through it. Otherwise the
+ * SharedLibrary is opened, and its PluginFactory created, without holding the lock, and
+ * both are released once listed.
+ *
+ * @param module the SharedLibrary path
+ * @param pluginList populated with the Plugins available through module
+ * @return pluginList populated
+ * @throw SharedLibraryException if there is an error accessing the SharedLibrary
+ */
+std::list<PluginInfo>&
+PluginManager::listPlugins(const std::string& module, std::list<PluginInfo>& pluginList) const throw(SharedLibraryException)
+{
+	std::string path = module ;
+	{
+		WriteLock lock(theLock) ;
+
+		SharedObjectRecord* soRec = getSharedObjectRecord(module) ;
+		if(soRec && soRec->thePluginFactory)
+		{
+			soRec->thePluginFactory->getAvailablePlugins(pluginList) ;
+			return(pluginList) ;
+		}
 
+		// a reloaded module is listed from its replacement
+		if(soRec)
+		{
+			path = soRec->thePath ;
+		}
+	}
 
+	SharedLibrary lib(path) ;
+	lib.open() ;
 
+	PluginFactory* factory = createPluginFactory(lib) ;
+	if(factory)
+	{
+		// get the PluginFactor
+		factory->getAvailablePlugins(pluginList) ;
 
+		// safely release the facory object
+		releasePluginFactory(lib, factory) ;
+	}
+	lib.close() ;
 
+	return(pluginList) ;
+}
 
-// Nested Classes
+/**
+ * Transforms an application Plugin name into its SharedLibrary and Plugin name.
+ * The PluginNameTransform is accessed under the read lock, so it is not replaced during
+ * the lookup, the names are copied so the caller continues without the lock.
+ *
+ * @param name the application specific Plugin name
+ * @param module populated with the SharedLibrary of the Plugin
+ * @param plugin populated with the Plugin name
+ * @param required set true to throw if no PluginNameTransform is set, otherwise false is returned
+ * @return true if the PluginNameTransform transforms name, false otherwise
+ * @throw PluginManagerException if required and no PluginNameTransform is set
+ */
+bool
+PluginManager::transformName(const std::string& name, std::string& module, std::string& plugin, bool required) const throw(PluginManagerException)
+{
+	ReadLock lock(theLock) ;
 
+	if(!theNameTransform)
+	{
+		if(required)
+		{
+			throw(PluginManagerException("No PluginNameTransform available")) ;
+		}
+		return(false) ;
+	}
 
-PluginManager::PluginRecModuleEq::PluginRecModuleEq(const std::string& module)
-		: theModule(module)
-{}
+	PluginNameTransform::TransformData data ;
+	bool found = theNameTransform->lookup(name, data) ;
+	if(found)
+	{
+		module = data.theModule ;
+		plugin = data.thePluginName ;
+	}
 
-PluginManager::PluginRecModuleEq::result_type
-PluginManager::PluginRecModuleEq::operator() (const PluginManager::PluginRecModuleEq::argument_type a) const
-{
-	return(a.second->theSharedObjectId == theModule) ;
+	return(found) ;
 }
 
-PluginManager::PluginRecPluginEq::PluginRecPluginEq(const Plugin& plugin)
-		: thePlugin(plugin)
-{}
-
-PluginManager::PluginRecPluginEq::result_type
-PluginManager::PluginRecPluginEq::operator() (const PluginManager::PluginRecPluginEq::argument_type a) const
+/**
+ * Opens the SharedLibrary of the specified ModuleDiscovery and lists its Plugins.
+ * This accesses no PluginManager state, so may be called concurrently without locking.
+ *
+ * @param discovery the ModuleDiscovery to populate
+ */
+void
+PluginManager::discoverModule(ModuleDiscovery& discovery) const
 {
-	return(a.second->thePlugin == &thePlugin) ;
+	// read ahead the module, so dlopen, which serialises within the loader, rarely waits on the disk
+	int fd = ::open(discovery.theModule.c_str(), O_RDONLY | O_CLOEXEC) ;
+	if(fd != -1)
+	{
+		::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED) ;
+		::close(fd) ;
+	}
+
+	SharedLibrary* lib = new SharedLibrary(discovery.theModule) ;
+	PluginFactory* factory = 0 ;
+
+	try
+	{
+		lib->open() ;
+
+		factory = createPluginFactory(*lib) ;
+		if(factory)
+		{
+			factory->getAvailablePlugins(discovery.thePlugins) ;
+		}
+
+		discovery.theLibrary = lib ;
+		discovery.theFactory = factory ;
+	}
+	catch(SharedLibraryException& sle)
+	{
+		discovery.theError = sle.toString() ;
+		discovery.thePlugins.clear() ;
+
+		if(factory)
+		{
+			try
+			{
+				releasePluginFactory(*lib, factory) ;
+			}
+			catch(SharedLibraryException&)
+			{}
+		}
+		delete lib ;
+	}
 }
 
+
+
+
+
+
+
+// Nested Classes
+
+
 PluginManager::PluginInfoNameEq::PluginInfoNameEq(const std::string& name)
 		: theName(name)
 {}
@@ -0,0 +1,418 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#include <cutil/PluginManifest.h>
+#include <cutil/FileStatus.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using cutil::Exception ;
+using cutil::FilePath ;
+using cutil::FileStatus ;
+using cutil::PluginInfo ;
+using cutil::PluginManifest ;
+
+namespace
+{
+	/** the first line of a manifest file, identifying its format version */
+	const char* const MANIFEST_HEADER = "cutil-plugin-manifest 1\n" ;
+
+	/**
+	 * Appends a length prefixed string, so fields may contain any character
+	 *
+	 * @param buf the stream to append to
+	 * @param value the string to append
+	 */
+	void writeString(std::ostringstream& buf, const std::string& value)
+	{
+		buf << ' ' << value.size() << ':' << value ;
+	}
+
+	/**
+	 * Sequential parser of the fields of a manifest file
+	 */
+	class ManifestReader
+	{
+		public:
+			ManifestReader(const std::string& data) : theData(data), thePosition(0) {}
+
+			bool atEnd() const
+			{
+				return(thePosition >= theData.size()) ;
+			}
+
+			bool expect(const std::string& token)
+			{
+				bool found = (theData.compare(thePosition, token.size(), token) == 0) ;
+				if(found)
+				{
+					thePosition += token.size() ;
+				}
+				return(found) ;
+			}
+
+			bool readNumber(unsigned long long& value)
+			{
+				if(expect(" ") && (thePosition < theData.size()) && std::isdigit(static_cast<unsigned char>(theData[thePosition])))
+				{
+					char* end = 0 ;
+					value = std::strtoull(theData.c_str() + thePosition, &end, 10) ;
+					thePosition = end - theData.c_str() ;
+					return(true) ;
+				}
+				return(false) ;
+			}
+
+			bool readString(std::string& value)
+			{
+				unsigned long long length = 0 ;
+				if(readNumber(length) && expect(":") && (length <= theData.size() - thePosition))
+				{
+					value.assign(theData, thePosition, length) ;
+					thePosition += length ;
+					return(true) ;
+				}
+				return(false) ;
+			}
+
+		private:
+			const std::string& theData ;
+			size_t thePosition ;
+	} ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates a new empty PluginManifest
+ *
+ */
+PluginManifest::PluginManifest()
+		: theModifiedFlag(false)
+{}
+
+/**
+ * Destructor.
+ *
+ */
+PluginManifest::~PluginManifest()
+{}
+
+
+//-------------------------------------------------------------------------------//
+// PluginManifest Operations
+
+/**
+ * Replaces the entries of this PluginManifest with those read from the specified manifest file
+ * If the file does not exist, or cannot be parsed, this PluginManifest is left empty.
+ *
+ * @param path the manifest file to read
+ * @return true if the manifest file was read, false if it does not exist or was discarded
+ * @throw Exception if the manifest file exists but cannot be read
+ */
+bool
+PluginManifest::load(const FilePath& path) throw(Exception)
+{
+	theEntries.clear() ;
+	theModifiedFlag = false ;
+
+	int fd = ::open(path.getPath().c_str(), O_RDONLY | O_CLOEXEC) ;
+	if(fd == -1)
+	{
+		if(errno == ENOENT)
+		{
+			return(false) ;
+		}
+		throw(Exception(std::string("Exception in load [open]:").append(::strerror(errno)))) ;
+	}
+
+	std::string data ;
+	char buf[16384] ;
+	ssize_t count = 0 ;
+	while((count = ::read(fd, buf, sizeof(buf))) != 0)
+	{
+		if(count == -1)
+		{
+			if(errno == EINTR)
+			{
+				continue ;
+			}
+			int err = errno ;
+			::close(fd) ;
+			throw(Exception(std::string("Exception in load [read]:").append(::strerror(err)))) ;
+		}
+		data.append(buf, count) ;
+	}
+	::close(fd) ;
+
+	// M <path> <size> <mtime sec> <mtime nsec> <device> <inode> <plugin count>
+	// P <name> <type> <description>
+	ManifestReader reader(data) ;
+	bool valid = reader.expect(MANIFEST_HEADER) ;
+	while(valid && !reader.atEnd())
+	{
+		std::string module ;
+		Entry entry ;
+		unsigned long long pluginCount = 0 ;
+
+		valid = reader.expect("M") && reader.readString(module)
+			&& reader.readNumber(entry.theSize)
+			&& reader.readNumber(entry.theModifiedSeconds)
+			&& reader.readNumber(entry.theModifiedNanoseconds)
+			&& reader.readNumber(entry.theDevice)
+			&& reader.readNumber(entry.theInode)
+			&& reader.readNumber(pluginCount)
+			&& reader.expect("\n") ;
+
+		for(unsigned long long i = 0 ; valid && i < pluginCount ; ++i)
+		{
+			std::string name ;
+			std::string type ;
+			std::string description ;
+
+			valid = reader.expect("P") && reader.readString(name) && reader.readString(type) && reader.readString(description) && reader.expect("\n") ;
+			if(valid)
+			{
+				entry.thePlugins.push_back(PluginInfo(name, type, description)) ;
+			}
+		}
+
+		if(valid)
+		{
+			theEntries[module] = entry ;
+		}
+	}
+
+	if(!valid)
+	{
+		// a cache, so a damaged manifest is discarded rather than reported
+		theEntries.clear() ;
+	}
+
+	return(valid) ;
+}
+
+/**
+ * Writes the entries of this PluginManifest to the specified manifest file, atomically replacing it
+ *
+ * @param path the manifest file to write
+ * @throw Exception if the manifest file cannot be written
+ */
+void
+PluginManifest::save(const FilePath& path) throw(Exception)
+{
+	std::ostringstream buf ;
+	buf << MANIFEST_HEADER ;
+
+	for(EntryContainer_t::const_iterator citer = theEntries.begin(); citer != theEntries.end(); ++citer)
+	{
+		const Entry& entry = citer->second ;
+
+		buf << 'M' ;
+		writeString(buf, citer->first) ;
+		buf << ' ' << entry.theSize << ' ' << entry.theModifiedSeconds << ' ' << entry.theModifiedNanoseconds
+			<< ' ' << entry.theDevice << ' ' << entry.theInode << ' ' << entry.thePlugins.size() << '\n' ;
+
+		for(std::list<PluginInfo>::const_iterator piter = entry.thePlugins.begin(); piter != entry.thePlugins.end(); ++piter)
+		{
+			buf << 'P' ;
+			writeString(buf, piter->getName()) ;
+			writeString(buf, piter->getType()) ;
+			writeString(buf, piter->getDescription()) ;
+			buf << '\n' ;
+		}
+	}
+
+	path.replaceFile(buf.str()) ;
+
+	theModifiedFlag = false ;
+}
+
+/**
+ * Populates the specified list with the cached Plugins of the specified module.
+ * The module is only found if its size, modification time, device and inode
+ * match those recorded when its entry was updated.
+ *
+ * @param module the SharedLibrary path
+ * @param plugins populated with the cached Plugins of module
+ * @return true if an up to date entry for module exists, false otherwise
+ */
+bool
+PluginManifest::lookup(const std::string& module, std::list<PluginInfo>& plugins) const
+{
+	bool found = false ;
+
+	EntryContainer_t::const_iterator citer = theEntries.find(module) ;
+	if(citer != theEntries.end())
+	{
+		Entry current ;
+		if(stat(module, current))
+		{
+			const Entry& entry = citer->second ;
+
+			found = (current.theSize == entry.theSize)
+				&& (current.theModifiedSeconds == entry.theModifiedSeconds)
+				&& (current.theModifiedNanoseconds == entry.theModifiedNanoseconds)
+				&& (current.theDevice == entry.theDevice)
+				&& (current.theInode == entry.theInode) ;
+
+			if(found)
+			{
+				plugins.insert(plugins.end(), entry.thePlugins.begin(), entry.thePlugins.end()) ;
+			}
+		}
+	}
+
+	return(found) ;
+}
+
+/**
+ * Records the Plugins offered by the specified module, along with its current metadata.
+ * If the module cannot be found at its path, any entry for it is removed.
+ *
+ * @param module the SharedLibrary path
+ * @param plugins the Plugins available through module
+ */
+void
+PluginManifest::update(const std::string& module, const std::list<PluginInfo>& plugins)
+{
+	Entry entry ;
+	if(stat(module, entry))
+	{
+		entry.thePlugins = plugins ;
+		theEntries[module] = entry ;
+		theModifiedFlag = true ;
+	}
+	else
+	{
+		remove(module) ;
+	}
+}
+
+/**
+ * Removes the entry of the specified module
+ *
+ * @param module the SharedLibrary path
+ * @return true if an entry was removed, false otherwise
+ */
+bool
+PluginManifest::remove(const std::string& module)
+{
+	bool removed = (theEntries.erase(module) > 0) ;
+	if(removed)
+	{
+		theModifiedFlag = true ;
+	}
+
+	return(removed) ;
+}
+
+/**
+ * Removes all entries from this PluginManifest
+ *
+ */
+void
+PluginManifest::clear()
+{
+	if(!theEntries.empty())
+	{
+		theEntries.clear() ;
+		theModifiedFlag = true ;
+	}
+}
+
+/**
+ * Returns the number of modules with an entry in this PluginManifest
+ *
+ * @return the number of cached modules
+ */
+size_t
+PluginManifest::getModuleCount() const
+{
+	return(theEntries.size()) ;
+}
+
+/**
+ * Returns whether this PluginManifest has been changed since it was last loaded or saved
+ *
+ * @return true if this PluginManifest has unsaved changes, false otherwise
+ */
+bool
+PluginManifest::isModified() const
+{
+	return(theModifiedFlag) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// Private Operations
+
+/**
+ * Populates the metadata of the specified Entry from the module file
+ *
+ * @param module the SharedLibrary path
+ * @param entry the Entry to populate
+ * @return true if the module exists at its path, false otherwise
+ */
+bool
+PluginManifest::stat(const std::string& module, Entry& entry)
+{
+	bool exists = false ;
+
+	// modules without a path are located by the dynamic loader, so cannot be validated
+	if(module.find('/') != std::string::npos)
+	{
+		try
+		{
+			FileStatus status(FilePath(module), FileStatus::TYPE_FIELD_ENUM | FileStatus::SIZE_FIELD_ENUM | FileStatus::TIMES_FIELD_ENUM | FileStatus::INODE_FIELD_ENUM) ;
+			if(status.exists() && status.isRegularFile())
+			{
+				exists = true ;
+				entry.theSize = status.getSize() ;
+				entry.theModifiedSeconds = status.getModifiedTime().tv_sec ;
+				entry.theModifiedNanoseconds = status.getModifiedTime().tv_nsec ;
+				entry.theDevice = status.getDevice() ;
+				entry.theInode = status.getInode() ;
+			}
+		}
+		catch(Exception&)
+		{}
+	}
+
+	return(exists) ;
+}
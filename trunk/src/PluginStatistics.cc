@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#include <cutil/PluginStatistics.h>
+
+#include <string>
+#include <vector>
+
+using cutil::PluginStatistics ;
+
+const size_t PluginStatistics::BUCKET_COUNT ;
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Constructs an empty PluginStatistics
+ *
+ */
+PluginStatistics::PluginStatistics()
+		: theLoadedFlag(false), theHandleCount(0), theLoadCount(0), theOpenTime(0), theFactoryTime(0), theCreateTime(0),
+		theCallCount(0), theCallTime(0), theCallHistogram(BUCKET_COUNT, 0)
+{}
+
+/**
+ * Destructor
+ *
+ */
+PluginStatistics::~PluginStatistics()
+{}
+
+//-------------------------------------------------------------------------------//
+// Accessors
+
+/**
+ * Returns the SharedLibrary the Plugin is registered from
+ *
+ * @return the SharedLibrary of the Plugin
+ */
+const std::string&
+PluginStatistics::getModule() const
+{
+	return(theModule) ;
+}
+
+/**
+ * Returns the name of the Plugin
+ *
+ * @return the name of the Plugin
+ */
+const std::string&
+PluginStatistics::getName() const
+{
+	return(theName) ;
+}
+
+/**
+ * Returns whether the Plugin was loaded at the time of the snapshot
+ *
+ * @return true if the Plugin was loaded, false otherwise
+ */
+bool
+PluginStatistics::isLoaded() const
+{
+	return(theLoadedFlag) ;
+}
+
+/**
+ * Returns the number of references to the Plugin held outside the PluginManager,
+ * through PluginHandles or refPlugin, at the time of the snapshot
+ *
+ * @return the number of live references to the Plugin
+ */
+int
+PluginStatistics::getHandleCount() const
+{
+	return(theHandleCount) ;
+}
+
+/**
+ * Returns the number of times the Plugin has been loaded while instrumented
+ *
+ * @return the number of instrumented loads
+ */
+unsigned long
+PluginStatistics::getLoadCount() const
+{
+	return(theLoadCount) ;
+}
+
+/**
+ * Returns the time taken to open the SharedLibrary of the Plugin, when it was last
+ * loaded. The time is 0 if the SharedLibrary was already open.
+ *
+ * @return the open time in nanoseconds
+ */
+unsigned long long
+PluginStatistics::getOpenTime() const
+{
+	return(theOpenTime) ;
+}
+
+/**
+ * Returns the time taken to create the PluginFactory of the SharedLibrary, when the
+ * Plugin was last loaded. The time is negligible if the PluginFactory already existed.
+ *
+ * @return the PluginFactory creation time in nanoseconds
+ */
+unsigned long long
+PluginStatistics::getFactoryTime() const
+{
+	return(theFactoryTime) ;
+}
+
+/**
+ * Returns the time taken by the PluginFactory to create the Plugin, when it was last loaded
+ *
+ * @return the Plugin creation time in nanoseconds
+ */
+unsigned long long
+PluginStatistics::getCreateTime() const
+{
+	return(theCreateTime) ;
+}
+
+/**
+ * Returns the number of calls made through PluginHandles while instrumented
+ *
+ * @return the number of recorded calls
+ */
+unsigned long
+PluginStatistics::getCallCount() const
+{
+	return(theCallCount) ;
+}
+
+/**
+ * Returns the total latency of the recorded calls
+ *
+ * @return the total call time in nanoseconds
+ */
+unsigned long long
+PluginStatistics::getCallTime() const
+{
+	return(theCallTime) ;
+}
+
+/**
+ * Returns the mean latency of the recorded calls
+ *
+ * @return the mean call time in nanoseconds, 0 if no calls were recorded
+ */
+double
+PluginStatistics::getMeanCallTime() const
+{
+	return(theCallCount ? static_cast<double>(theCallTime) / theCallCount : 0.0) ;
+}
+
+/**
+ * Returns an upper bound of the specified percentile of the recorded call latencies,
+ * the limit of the histogram bucket containing the percentile.
+ *
+ * @param percentile the percentile, between 0 and 100
+ * @return the upper bound in nanoseconds, 0 if no calls were recorded
+ */
+unsigned long long
+PluginStatistics::getCallPercentile(double percentile) const
+{
+	// the histogram is summed, calls recorded while the snapshot was taken may differ from theCallCount
+	unsigned long total = 0 ;
+	for(size_t i = 0 ; i < theCallHistogram.size() ; ++i)
+	{
+		total += theCallHistogram[i] ;
+	}
+
+	unsigned long long limit = 0 ;
+	if(total > 0)
+	{
+		double rank = (percentile / 100.0) * total ;
+		size_t bucket = 0 ;
+		unsigned long seen = theCallHistogram[0] ;
+		while((bucket < BUCKET_COUNT - 1) && ((seen == 0) || (seen < rank)))
+		{
+			seen += theCallHistogram[++bucket] ;
+		}
+		limit = getBucketLimit(bucket) ;
+	}
+
+	return(limit) ;
+}
+
+/**
+ * Returns the call latency histogram, of BUCKET_COUNT buckets
+ *
+ * @return the number of calls counted in each bucket
+ */
+const std::vector<unsigned long>&
+PluginStatistics::getCallHistogram() const
+{
+	return(theCallHistogram) ;
+}
+
+//-------------------------------------------------------------------------------//
+// Histogram Buckets
+
+/**
+ * Returns the histogram bucket counting a call of the specified latency
+ *
+ * @param nanoseconds the call latency
+ * @return the bucket of the latency
+ */
+size_t
+PluginStatistics::getBucket(unsigned long long nanoseconds)
+{
+	size_t bucket = 0 ;
+	while(nanoseconds && (bucket < BUCKET_COUNT - 1))
+	{
+		nanoseconds >>= 1 ;
+		bucket++ ;
+	}
+
+	return(bucket) ;
+}
+
+/**
+ * Returns the exclusive upper limit of latencies counted in the specified bucket.
+ * The final bucket has no limit, and returns its lower bound.
+ *
+ * @param bucket the histogram bucket
+ * @return the upper limit in nanoseconds
+ */
+unsigned long long
+PluginStatistics::getBucketLimit(size_t bucket)
+{
+	return((bucket < BUCKET_COUNT - 1) ? (1ULL << bucket) : (1ULL << (BUCKET_COUNT - 2))) ;
+}
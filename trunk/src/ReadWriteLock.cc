@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#include <cutil/ReadWriteLock.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+using cutil::Exception ;
+using cutil::ReadWriteLock ;
+
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates a new unlocked ReadWriteLock
+ *
+ * @throw Exception if the lock cannot be initialised
+ */
+ReadWriteLock::ReadWriteLock() throw(Exception)
+		: theWriter(::pthread_self()), theWriteDepth(0)
+{
+	int err = ::pthread_rwlock_init(&theLock, 0) ;
+	if(err != 0)
+	{
+		throw(Exception(std::string("Exception in ReadWriteLock [pthread_rwlock_init]:").append(::strerror(err)))) ;
+	}
+}
+
+/**
+ * Destructor.
+ * The ReadWriteLock must not be locked when destroyed
+ *
+ */
+ReadWriteLock::~ReadWriteLock()
+{
+	::pthread_rwlock_destroy(&theLock) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// ReadWriteLock Operations
+
+/**
+ * Locks this ReadWriteLock for reading, blocking while a writer holds the lock
+ *
+ * @throw Exception if the lock cannot be acquired
+ */
+void
+ReadWriteLock::readLock() throw(Exception)
+{
+	if(isWriteLocked())
+	{
+		// the write lock already excludes all other threads
+		theWriteDepth++ ;
+	}
+	else
+	{
+		int err = ::pthread_rwlock_rdlock(&theLock) ;
+		if(err != 0)
+		{
+			throw(Exception(std::string("Exception in readLock [pthread_rwlock_rdlock]:").append(::strerror(err)))) ;
+		}
+	}
+}
+
+/**
+ * Locks this ReadWriteLock for writing, blocking while any reader or writer holds the lock
+ *
+ * @throw Exception if the lock cannot be acquired
+ */
+void
+ReadWriteLock::writeLock() throw(Exception)
+{
+	if(isWriteLocked())
+	{
+		theWriteDepth++ ;
+	}
+	else
+	{
+		int err = ::pthread_rwlock_wrlock(&theLock) ;
+		if(err != 0)
+		{
+			throw(Exception(std::string("Exception in writeLock [pthread_rwlock_wrlock]:").append(::strerror(err)))) ;
+		}
+
+		// publish the owner before the depth, isWriteLocked reads them in the reverse order
+		theWriter = ::pthread_self() ;
+		__sync_synchronize() ;
+		theWriteDepth = 1 ;
+	}
+}
+
+/**
+ * Locks this ReadWriteLock for writing if no other reader or writer holds the lock
+ *
+ * @return true if the write lock was acquired, false if it is held
+ * @throw Exception if the lock cannot be acquired for another reason
+ */
+bool
+ReadWriteLock::tryWriteLock() throw(Exception)
+{
+	if(isWriteLocked())
+	{
+		theWriteDepth++ ;
+		return(true) ;
+	}
+
+	int err = ::pthread_rwlock_trywrlock(&theLock) ;
+	if((err == EBUSY) || (err == EDEADLK))
+	{
+		return(false) ;
+	}
+	if(err != 0)
+	{
+		throw(Exception(std::string("Exception in tryWriteLock [pthread_rwlock_trywrlock]:").append(::strerror(err)))) ;
+	}
+
+	theWriter = ::pthread_self() ;
+	__sync_synchronize() ;
+	theWriteDepth = 1 ;
+
+	return(true) ;
+}
+
+/**
+ * Releases a read or write lock held by the calling thread
+ *
+ * @throw Exception if the lock cannot be released
+ */
+void
+ReadWriteLock::unlock() throw(Exception)
+{
+	if(isWriteLocked())
+	{
+		theWriteDepth-- ;
+		if(theWriteDepth > 0)
+		{
+			// nested lock
+			return ;
+		}
+	}
+
+	int err = ::pthread_rwlock_unlock(&theLock) ;
+	if(err != 0)
+	{
+		throw(Exception(std::string("Exception in unlock [pthread_rwlock_unlock]:").append(::strerror(err)))) ;
+	}
+}
+
+/**
+ * Returns whether the calling thread holds the write lock
+ *
+ * @return true if the calling thread holds the write lock, false otherwise
+ */
+bool
+ReadWriteLock::isWriteLocked() const
+{
+	int depth = theWriteDepth ;
+	__sync_synchronize() ;
+
+	return(depth > 0 && ::pthread_equal(theWriter, ::pthread_self())) ;
+}
@@ -26,11 +26,72 @@
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <utility>
+#include <vector>
 
 #include <dlfcn.h>
+#include <link.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
+using cutil::MutexLock ;
 using cutil::SharedLibrary ;
 
+namespace
+{
+	/** the address and memory size of each loadable segment of a loaded object */
+	typedef std::vector<std::pair<ElfW(Addr), size_t> > SegmentList_t ;
+
+	/**
+	 * The loadable segments of a loaded object, located by its load address
+	 */
+	struct MappedObject
+	{
+		MappedObject(ElfW(Addr) address, SegmentList_t& segments) : theAddress(address), theSegments(segments) {}
+
+		/** the load address of the object */
+		ElfW(Addr) theAddress ;
+
+		/** populated with the loadable segments of the object */
+		SegmentList_t& theSegments ;
+	} ;
+
+	int findLoadSegments(struct dl_phdr_info* info, size_t, void* data)
+	{
+		MappedObject* object = static_cast<MappedObject*>(data) ;
+
+		int found = 0 ;
+		if(info->dlpi_addr == object->theAddress)
+		{
+			for(ElfW(Half) i = 0 ; i < info->dlpi_phnum ; ++i)
+			{
+				if(info->dlpi_phdr[i].p_type == PT_LOAD)
+				{
+					object->theSegments.push_back(std::make_pair(info->dlpi_addr + info->dlpi_phdr[i].p_vaddr, static_cast<size_t>(info->dlpi_phdr[i].p_memsz))) ;
+				}
+			}
+			found = 1 ;
+		}
+
+		return(found) ;
+	}
+
+	/**
+	 * Locates the loadable segments of the object loaded by a dlopen handle
+	 */
+	SegmentList_t& getLoadSegments(void* handle, SegmentList_t& segments)
+	{
+		struct link_map* map = 0 ;
+		if(::dlinfo(handle, RTLD_DI_LINKMAP, &map) == 0 && map)
+		{
+			MappedObject object(map->l_addr, segments) ;
+			::dl_iterate_phdr(findLoadSegments, &object) ;
+		}
+
+		return(segments) ;
+	}
+}
+
 //-------------------------------------------------------------------------------//
 // Constructor / Desctructor
 
@@ -49,6 +110,10 @@ SharedLibrary::SharedLibrary(const std::string& name)
 	theHandle = 0 ;
 	theResolveMode = RESOLVE_NOW_ENUM ;
 	theGlobalFlag = true ;
+	theMappedSize = 0 ;
+	theIsolatedFlag = false ;
+	theNoDeleteFlag = false ;
+	thePrefaultFlag = false ;
 }
 
 /**
@@ -198,6 +263,148 @@ SharedLibrary::getGlobalSymbol() const
 	return(theGlobalFlag) ;
 }
 
+/**
+ * Sets whether this SharedLibrary is opened within a new, isolated, linker namespace.
+ * An isolated SharedLibrary, and the dependencies it loads, are bound only to symbols
+ * within its own namespace (dlmopen with LM_ID_NEWLM on glibc systems). Each isolated
+ * SharedLibrary opened receives its own copy of the module and its state, so several
+ * copies or versions of a module may be open at once without their symbols clashing.
+ * The global symbol flag does not apply to an isolated SharedLibrary. Types shared with
+ * the application, such as Plugin, are distinct within the namespace, so an isolated
+ * module should be accessed through plain functions, as with a SymbolTable. The number
+ * of namespaces is limited by the system (16 with glibc).
+ * This flag is effective only during the opening of a shared library, attempting to
+ * change it on an open SharedLibrary results in a SharedLibraryException.
+ *
+ * @param isolated set true to open this SharedLibrary within a new namespace
+ * @throw SharedLibraryException if this SharedLibrary is open
+ */
+void
+SharedLibrary::setIsolated(bool isolated) throw(SharedLibraryException)
+{
+	if(isOpen())
+	{
+		throw(SharedLibraryException(std::string("setIsolated called on an open SharedLibrary"))) ;
+	}
+	else
+	{
+		theIsolatedFlag = isolated ;
+	}
+}
+
+/**
+ * Returns whether this SharedLibrary is opened within a new linker namespace
+ *
+ * @see setIsolated
+ * @return true if this SharedLibrary is opened within a new namespace
+ */
+bool
+SharedLibrary::getIsolated() const
+{
+	return(theIsolatedFlag) ;
+}
+
+/**
+ * Returns the linker namespace this open SharedLibrary was loaded into.
+ * A SharedLibrary which is not isolated is loaded into the base namespace, 0 (LM_ID_BASE).
+ *
+ * @return the linker namespace id of this SharedLibrary
+ * @throw SharedLibraryException if this SharedLibrary is not open, or the namespace cannot be determined
+ */
+long
+SharedLibrary::getNamespace() const throw(SharedLibraryException)
+{
+	Lmid_t lmid = LM_ID_BASE ;
+
+	if(!isOpen())
+	{
+		throw(SharedLibraryException("Attempt to getNamespace on an unopen SharedLibrary")) ;
+	}
+	else if(::dlinfo(theHandle, RTLD_DI_LMID, &lmid) != 0)
+	{
+		const char* errmsg = dlerror() ;
+
+		std::ostringstream buf ;
+		buf << "Exception accessing namespace of SharedLibrary " << theModuleName ;
+		buf << (errmsg ? errmsg : "No error message given") ;
+		throw(SharedLibraryException(buf.str())) ;
+	}
+
+	return(lmid) ;
+}
+
+/**
+ * Sets whether the module remains loaded once this SharedLibrary is closed.
+ * With the flag set (RTLD_NODELETE on UNIX systems), closing this SharedLibrary does not
+ * unmap the module, so reopening it later avoids mapping and relocating it again, and its
+ * static state is retained. Set this for modules which are repeatedly opened and closed.
+ * This flag is effective only during the opening of a shared library, attempting to
+ * change it on an open SharedLibrary results in a SharedLibraryException.
+ *
+ * @param nodelete set true to keep the module loaded once closed
+ * @throw SharedLibraryException if this SharedLibrary is open
+ */
+void
+SharedLibrary::setNoDelete(bool nodelete) throw(SharedLibraryException)
+{
+	if(isOpen())
+	{
+		throw(SharedLibraryException(std::string("setNoDelete called on an open SharedLibrary"))) ;
+	}
+	else
+	{
+		theNoDeleteFlag = nodelete ;
+	}
+}
+
+/**
+ * Returns whether the module remains loaded once this SharedLibrary is closed
+ *
+ * @see setNoDelete
+ * @return true if the module remains loaded once closed
+ */
+bool
+SharedLibrary::getNoDelete() const
+{
+	return(theNoDeleteFlag) ;
+}
+
+/**
+ * Sets whether the pages of the module are faulted in as it is opened.
+ * With the flag set, the loadable segments of the module are read into memory before
+ * open returns, so the first calls into the module do not stall on page faults. This
+ * moves the cost of faulting in the module from its first use to its opening.
+ * This flag is effective only during the opening of a shared library, attempting to
+ * change it on an open SharedLibrary results in a SharedLibraryException.
+ *
+ * @param prefault set true to fault in the module as it is opened
+ * @throw SharedLibraryException if this SharedLibrary is open
+ */
+void
+SharedLibrary::setPrefault(bool prefault) throw(SharedLibraryException)
+{
+	if(isOpen())
+	{
+		throw(SharedLibraryException(std::string("setPrefault called on an open SharedLibrary"))) ;
+	}
+	else
+	{
+		thePrefaultFlag = prefault ;
+	}
+}
+
+/**
+ * Returns whether the pages of the module are faulted in as it is opened
+ *
+ * @see setPrefault
+ * @return true if the module is faulted in as it is opened
+ */
+bool
+SharedLibrary::getPrefault() const
+{
+	return(thePrefaultFlag) ;
+}
+
 
 //-------------------------------------------------------------------------------//
 // SharedLibray Operations
@@ -228,17 +435,36 @@ SharedLibrary::open() throw(SharedLibraryException)
 				}
 		}
 
-		if(theGlobalFlag)
+		if(theNoDeleteFlag)
 		{
-			flags |= RTLD_LAZY ;
+			flags |= RTLD_NODELETE ;
 		}
 
-		void* handle = dlopen(theModuleName.c_str(), flags) ;
+		void* handle = 0 ;
+		if(theIsolatedFlag)
+		{
+			// symbols cannot be made global outside the base namespace
+			handle = dlmopen(LM_ID_NEWLM, theModuleName.c_str(), flags) ;
+		}
+		else
+		{
+			if(theGlobalFlag)
+			{
+				flags |= RTLD_GLOBAL ;
+			}
+
+			handle = dlopen(theModuleName.c_str(), flags) ;
+		}
 
 		if(handle)
 		{
 			theHandle = handle ;
 			theOpenFlag = true ;
+
+			if(thePrefaultFlag)
+			{
+				prefault() ;
+			}
 		}
 		else
 		{
@@ -264,6 +490,10 @@ SharedLibrary::close() throw(SharedLibraryException)
 	{
 		if(dlclose(theHandle) == 0)
 		{
+			MutexLock lock(theSymbolMutex) ;
+
+			theSymbols.clear() ;
+			theMappedSize = 0 ;
 			theHandle = 0 ;
 			theOpenFlag = false ;
 		}
@@ -283,6 +513,10 @@ SharedLibrary::close() throw(SharedLibraryException)
  * Returns the address of the specified symbol within this SharedLibrary
  * The SharedLibrary must have been loaded by a call to open before calling
  * this method.
+ * Resolved symbols are cached until this SharedLibrary is closed, so repeated
+ * lookups of the same symbol do not search the dynamic linker symbol tables.
+ * The cache is locked, so getSymbol may be called concurrently.
+ * For calls on a hot path, bind the symbols once through a SymbolTable.
  *
  * @param symbol the symbl name to get
  * @throw SharedLibraryException if this SharedLibrary is not open, the symbol
@@ -295,20 +529,32 @@ SharedLibrary::getSymbol(const std::string& symbol) throw(SharedLibraryException
 
 	if(isOpen())
 	{
-		// clear any previous error message
-		const char* errmsg =  dlerror() ;
-
-		sym = dlsym(theHandle, symbol.c_str()) ;
+		MutexLock lock(theSymbolMutex) ;
 
-		// test is there was an error
-		errmsg = dlerror() ;
-		if(errmsg)
+		SymbolContainer_t::const_iterator citer = theSymbols.find(symbol) ;
+		if(citer != theSymbols.end())
 		{
-			// got an error
-			sym = 0 ;
-			std::ostringstream buf ;
-			buf << "Exception during symbol lookup [" << theModuleName  << ", " << symbol << "] " << errmsg ;
-			throw(SharedLibraryException(buf.str())) ;
+			sym = citer->second ;
+		}
+		else
+		{
+			// clear any previous error message
+			const char* errmsg =  dlerror() ;
+
+			sym = dlsym(theHandle, symbol.c_str()) ;
+
+			// test is there was an error
+			errmsg = dlerror() ;
+			if(errmsg)
+			{
+				// got an error
+				sym = 0 ;
+				std::ostringstream buf ;
+				buf << "Exception during symbol lookup [" << theModuleName  << ", " << symbol << "] " << errmsg ;
+				throw(SharedLibraryException(buf.str())) ;
+			}
+
+			theSymbols.insert(SymbolContainer_t::value_type(symbol, sym)) ;
 		}
 	}
 	else
@@ -318,3 +564,60 @@ SharedLibrary::getSymbol(const std::string& symbol) throw(SharedLibraryException
 
 	return(sym) ;
 }
+
+/**
+ * Returns the size of the memory mapped for the segments of this open SharedLibrary.
+ * The size is that of the loadable segments of the module itself, excluding
+ * any dependencies and any memory the module allocates. The size is computed once
+ * each time this SharedLibrary is opened. 0 is returned if this SharedLibrary is
+ * not open, or the size cannot be determined.
+ *
+ * @return the size of the mapped segments of this SharedLibrary in bytes
+ */
+size_t
+SharedLibrary::getMappedSize()
+{
+	if(isOpen() && (theMappedSize == 0))
+	{
+		SegmentList_t segments ;
+		getLoadSegments(theHandle, segments) ;
+
+		for(SegmentList_t::const_iterator citer = segments.begin() ; citer != segments.end() ; ++citer)
+		{
+			theMappedSize += citer->second ;
+		}
+	}
+
+	return(isOpen() ? theMappedSize : 0) ;
+}
+
+/**
+ * Faults in the loadable segments of this open SharedLibrary
+ *
+ */
+void
+SharedLibrary::prefault()
+{
+	SegmentList_t segments ;
+	getLoadSegments(theHandle, segments) ;
+
+	const ElfW(Addr) pageSize = ::sysconf(_SC_PAGESIZE) ;
+	for(SegmentList_t::const_iterator citer = segments.begin() ; citer != segments.end() ; ++citer)
+	{
+		ElfW(Addr) start = citer->first & ~(pageSize - 1) ;
+		ElfW(Addr) end = citer->first + citer->second ;
+
+#ifdef MADV_POPULATE_READ
+		// populate the page tables in a single call where the kernel supports it
+		if(::madvise(reinterpret_cast<void*>(start), end - start, MADV_POPULATE_READ) == 0)
+		{
+			continue ;
+		}
+#endif
+		// otherwise read a byte of each page
+		for(ElfW(Addr) page = start ; page < end ; page += pageSize)
+		{
+			*reinterpret_cast<volatile const char*>(page) ;
+		}
+	}
+}
@@ -0,0 +1,763 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#include <cutil/SnapshotStateHandler.h>
+
+#include <cutil/FilePath.h>
+#include <cutil/MemoryStateHandler.h>
+#include <cutil/RefCountPtr.h>
+#include <cutil/SnapshotStateNode.h>
+#include <cutil/StateNode.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using cutil::Exception ;
+using cutil::FilePath ;
+using cutil::MappedFile ;
+using cutil::MemoryStateHandler ;
+using cutil::RefCountPtr ;
+using cutil::SnapshotStateHandler ;
+using cutil::SnapshotStateNode ;
+using cutil::StateNode ;
+
+//---------------------------------------------------------------------------------------//
+// Initialize static memebers
+
+const uint32_t SnapshotStateHandler::NO_NODE = 0xffffffff ;
+
+namespace
+{
+	/** identifies a snapshot file */
+	const char SNAPSHOT_MAGIC[8] = { 'C', 'U', 'T', 'I', 'L', 'S', 'N', 'P' } ;
+
+	/** the snapshot format version, read back differently in the opposite byte order */
+	const uint32_t SNAPSHOT_VERSION = 1 ;
+
+	/**
+	 * Builds the string table of a snapshot, storing each distinct string once.
+	 * Each string is stored as its 32 bit length followed by its characters and a
+	 * terminating nul, padded to a 4 byte boundary.
+	 */
+	class StringTable
+	{
+		public:
+			/**
+			 * Returns the string table offset of the specified string, adding the string if not yet stored
+			 *
+			 * @param s the string
+			 * @return the string table offset of the string
+			 */
+			uint32_t intern(const std::string& s)
+			{
+				uint32_t offset ;
+
+				std::map<std::string, uint32_t>::const_iterator citer = theOffsets.find(s) ;
+				if(citer != theOffsets.end())
+				{
+					offset = (*citer).second ;
+				}
+				else
+				{
+					offset = static_cast<uint32_t>(theData.size()) ;
+
+					uint32_t length = static_cast<uint32_t>(s.size()) ;
+					theData.append(reinterpret_cast<const char*>(&length), sizeof(length)) ;
+					theData.append(s) ;
+					theData.append(1, '\0') ;
+					theData.append((4 - (theData.size() % 4)) % 4, '\0') ;
+
+					theOffsets.insert(std::pair<std::string, uint32_t>(s, offset)) ;
+				}
+
+				return(offset) ;
+			}
+
+			/**
+			 * Returns the string table data
+			 *
+			 * @return the string table data
+			 */
+			const std::string& getData() const
+			{
+				return(theData) ;
+			}
+
+		private:
+			/** offsets of the stored strings */
+			std::map<std::string, uint32_t> theOffsets ;
+
+			/** the string table data */
+			std::string theData ;
+	} ;
+
+	/**
+	 * Returns the sorted, distinct, names within the specified list
+	 *
+	 * @param names the names to sort
+	 * @return the names list
+	 */
+	std::list<std::string>& sortNames(std::list<std::string>& names)
+	{
+		names.sort() ;
+		names.unique() ;
+		return(names) ;
+	}
+}
+
+
+//---------------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Constructs a new SnapshotStateHandler to read and store state information within the
+ * specified snapshot file
+ *
+ * @param filename the file path of the snapshot file
+ */
+SnapshotStateHandler::SnapshotStateHandler(const std::string& filename)
+		: theDataFile(filename)
+{
+	theHeader = 0 ;
+	theNodes = 0 ;
+	theValues = 0 ;
+	theStrings = 0 ;
+	theGeneration = 0 ;
+	theCopyFlag = false ;
+	theDirtyFlag = false ;
+}
+
+/**
+ * Destructor
+ */
+SnapshotStateHandler::~SnapshotStateHandler()
+{
+	shutdown() ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// StateHandler implementations
+
+/**
+ * Initialize this StateHandler.
+ * Maps the snapshot file. If the file does not exist, or is not a valid snapshot,
+ * the state tree is empty.
+ */
+void
+SnapshotStateHandler::initialize()
+{
+	load() ;
+}
+
+/**
+ * Shutdown this StateHandler.
+ * Writes any modifications to the snapshot file and unmaps the snapshot
+ */
+void
+SnapshotStateHandler::shutdown()
+{
+	try
+	{
+		flush() ;
+	}
+	catch(Exception& e)
+	{
+
+	}
+
+	release() ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// Update Control
+
+/**
+ * Force a write of state information back to the persistant store
+ * A new snapshot is written only if the state tree has been modified. The snapshot is
+ * written to a temporary file which is synchronized to disk and renamed over the data file.
+ *
+ * @throw Exception if the snapshot file cannot be written
+ */
+void
+SnapshotStateHandler::flush()
+{
+	if(theDirtyFlag && theCopyFlag)
+	{
+		writeSnapshot(theCopy, theDataFile) ;
+		theDirtyFlag = false ;
+	}
+}
+
+/**
+ * Synchronize this StateHandler to the persistant store of state information,
+ * The snapshot file is mapped again, discarding any unwritten modifications
+ */
+void
+SnapshotStateHandler::sync()
+{
+	load() ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// StateNode Access
+
+/**
+ * Returns the root StateNode within the state tree of this StateHandler
+ * This method returns a user handle for the underlying data of the StateNode
+ * implementation. Subsequent calls to getRootNode need not return the same
+ * handle instance, however, it is guaranteed that each will be a handle to
+ * the same underlying data instance.
+ *
+ * @return the root StateNode within the state tree of this StateHandler
+ */
+RefCountPtr<StateNode>
+SnapshotStateHandler::getRootNode()
+{
+	RefCountPtr<StateNode> rootNode(new SnapshotStateNode(*this, "/", findNode("/"))) ;
+	return(rootNode) ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// Snapshot Handling
+
+/**
+ * Returns whether state information is read directly from the mapped snapshot.
+ * Once the state tree is modified, state information is read from an in memory copy.
+ *
+ * @return true if the snapshot is mapped and unmodified
+ */
+bool
+SnapshotStateHandler::isMapped() const
+{
+	return((theHeader != 0) && !theCopyFlag) ;
+}
+
+/**
+ * Returns whether the state tree has been modified since the snapshot was last
+ * written or mapped
+ *
+ * @return true if the state tree has been modified
+ */
+bool
+SnapshotStateHandler::isDirty() const
+{
+	return(theDirtyFlag) ;
+}
+
+/**
+ * Writes a snapshot of the state tree of the specified StateHandler to the specified file.
+ * The snapshot is written to a temporary file which is synchronized to disk and renamed
+ * over the specified file.
+ *
+ * @param source the initialized StateHandler to write
+ * @param filename the path of the snapshot file
+ * @throw Exception if the snapshot file cannot be written
+ */
+void
+SnapshotStateHandler::writeSnapshot(StateHandler& source, const std::string& filename) throw(Exception)
+{
+	std::vector<NodeRecord> nodes ;
+	std::vector<RefCountPtr<StateNode> > handles ;
+	std::vector<ValueRecord> values ;
+	StringTable strings ;
+
+	NodeRecord root ;
+	root.theName = strings.intern("") ;
+	root.theParent = NO_NODE ;
+	root.theFirstChild = 0 ;
+	root.theChildCount = 0 ;
+	root.theFirstValue = 0 ;
+	root.theValueCount = 0 ;
+
+	nodes.push_back(root) ;
+	handles.push_back(source.getRootNode()) ;
+
+	// StateNodes are visited breadth first, so the children of each StateNode are
+	// appended as consecutive records, and values are appended as each StateNode is visited
+	for(size_t i = 0; i < nodes.size(); i++)
+	{
+		RefCountPtr<StateNode> node = handles[i] ;
+
+		std::list<std::string> names ;
+		node->getValueNames(names) ;
+		sortNames(names) ;
+
+		nodes[i].theFirstValue = static_cast<uint32_t>(values.size()) ;
+		nodes[i].theValueCount = static_cast<uint32_t>(names.size()) ;
+
+		for(std::list<std::string>::const_iterator citer = names.begin(); citer != names.end(); ++citer)
+		{
+			std::string s = node->getString(*citer, "") ;
+
+			ValueRecord value ;
+			value.theName = strings.intern(*citer) ;
+			value.theString = strings.intern(s) ;
+			value.theInt = atoi(s.c_str()) ;
+			value.theBool = (s == "true") ? 1 : 0 ;
+			value.theDouble = strtod(s.c_str(), 0) ;
+
+			values.push_back(value) ;
+		}
+
+		std::list<std::string> children ;
+		node->getChildren(children) ;
+		sortNames(children) ;
+
+		nodes[i].theFirstChild = static_cast<uint32_t>(nodes.size()) ;
+		nodes[i].theChildCount = static_cast<uint32_t>(children.size()) ;
+
+		for(std::list<std::string>::const_iterator citer = children.begin(); citer != children.end(); ++citer)
+		{
+			NodeRecord child ;
+			child.theName = strings.intern(*citer) ;
+			child.theParent = static_cast<uint32_t>(i) ;
+			child.theFirstChild = 0 ;
+			child.theChildCount = 0 ;
+			child.theFirstValue = 0 ;
+			child.theValueCount = 0 ;
+
+			nodes.push_back(child) ;
+			handles.push_back(node->getChild(*citer)) ;
+		}
+
+		// the handle is no longer required
+		handles[i] = RefCountPtr<StateNode>() ;
+	}
+
+	Header header ;
+	std::memset(&header, 0, sizeof(header)) ;
+	std::memcpy(header.theMagic, SNAPSHOT_MAGIC, sizeof(header.theMagic)) ;
+	header.theVersion = SNAPSHOT_VERSION ;
+	header.theNodeCount = static_cast<uint32_t>(nodes.size()) ;
+	header.theNodeOffset = sizeof(Header) ;
+	header.theValueCount = static_cast<uint32_t>(values.size()) ;
+	header.theValueOffset = header.theNodeOffset + header.theNodeCount * sizeof(NodeRecord) ;
+	header.theStringOffset = header.theValueOffset + header.theValueCount * sizeof(ValueRecord) ;
+	header.theStringSize = static_cast<uint32_t>(strings.getData().size()) ;
+
+	std::string content ;
+	content.reserve(header.theStringOffset + header.theStringSize) ;
+	content.append(reinterpret_cast<const char*>(&header), sizeof(header)) ;
+	content.append(reinterpret_cast<const char*>(&nodes[0]), nodes.size() * sizeof(NodeRecord)) ;
+	if(!values.empty())
+	{
+		content.append(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(ValueRecord)) ;
+	}
+	content.append(strings.getData()) ;
+
+	FilePath(filename).replaceFile(content) ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// Snapshot access
+
+/**
+ * Maps and validates the snapshot file, leaving the snapshot unmapped if the
+ * file does not exist or is not a valid snapshot
+ *
+ */
+void
+SnapshotStateHandler::load()
+{
+	release() ;
+
+	try
+	{
+		theFile.map(FilePath(theDataFile), MappedFile::READ_ONLY_ENUM) ;
+	}
+	catch(Exception& e)
+	{
+		// no snapshot, the state tree is empty
+	}
+
+	if(theFile.isMapped())
+	{
+		const char* data = theFile.getData() ;
+		uint64_t size = theFile.getSize() ;
+
+		const Header* header = reinterpret_cast<const Header*>(data) ;
+
+		// each table must lie within the file, and the records be aligned for direct access
+		bool valid = (size >= sizeof(Header))
+				&& (std::memcmp(header->theMagic, SNAPSHOT_MAGIC, sizeof(header->theMagic)) == 0)
+				&& (header->theVersion == SNAPSHOT_VERSION)
+				&& (header->theNodeCount > 0)
+				&& ((header->theNodeOffset % 8) == 0)
+				&& ((header->theValueOffset % 8) == 0)
+				&& ((static_cast<uint64_t>(header->theNodeOffset) + static_cast<uint64_t>(header->theNodeCount) * sizeof(NodeRecord)) <= size)
+				&& ((static_cast<uint64_t>(header->theValueOffset) + static_cast<uint64_t>(header->theValueCount) * sizeof(ValueRecord)) <= size)
+				&& ((static_cast<uint64_t>(header->theStringOffset) + header->theStringSize) <= size) ;
+
+		if(valid)
+		{
+			theHeader = header ;
+			theNodes = reinterpret_cast<const NodeRecord*>(data + header->theNodeOffset) ;
+			theValues = reinterpret_cast<const ValueRecord*>(data + header->theValueOffset) ;
+			theStrings = data + header->theStringOffset ;
+		}
+		else
+		{
+			theFile.unmap() ;
+		}
+	}
+
+	theGeneration++ ;
+}
+
+/**
+ * Discards the snapshot and any in memory copy of the state tree
+ *
+ */
+void
+SnapshotStateHandler::release()
+{
+	if(theFile.isMapped())
+	{
+		theFile.unmap() ;
+	}
+
+	theHeader = 0 ;
+	theNodes = 0 ;
+	theValues = 0 ;
+	theStrings = 0 ;
+
+	if(theCopyFlag)
+	{
+		// importing an empty state tree releases the copy
+		MemoryStateHandler empty ;
+		theCopy.importState(empty) ;
+		theCopyFlag = false ;
+	}
+
+	theDirtyFlag = false ;
+	theGeneration++ ;
+}
+
+/**
+ * Returns the StateNode record at the specified index
+ *
+ * @param index the index of the record, which must be valid
+ * @return the StateNode record
+ */
+const SnapshotStateHandler::NodeRecord&
+SnapshotStateHandler::getNode(uint32_t index) const
+{
+	return(theNodes[index]) ;
+}
+
+/**
+ * Returns the value record at the specified index
+ *
+ * @param index the index of the record, which must be valid
+ * @return the value record
+ */
+const SnapshotStateHandler::ValueRecord&
+SnapshotStateHandler::getValue(uint32_t index) const
+{
+	return(theValues[index]) ;
+}
+
+/**
+ * Returns the string at the specified string table offset
+ *
+ * @param offset the string table offset
+ * @return the string
+ */
+std::string
+SnapshotStateHandler::getString(uint32_t offset) const
+{
+	std::string s ;
+
+	if((static_cast<uint64_t>(offset) + sizeof(uint32_t)) <= theHeader->theStringSize)
+	{
+		uint32_t length ;
+		std::memcpy(&length, theStrings + offset, sizeof(length)) ;
+
+		if((static_cast<uint64_t>(offset) + sizeof(uint32_t) + length) <= theHeader->theStringSize)
+		{
+			s.assign(theStrings + offset + sizeof(uint32_t), length) ;
+		}
+	}
+
+	return(s) ;
+}
+
+/**
+ * Compares the string at the specified string table offset with name, as strcmp
+ *
+ * @param offset the string table offset
+ * @param name the name to compare with
+ * @return less than, equal to or greater than 0 as the string orders before, with or after name
+ */
+int
+SnapshotStateHandler::compareString(uint32_t offset, const std::string& name) const
+{
+	const char* data = "" ;
+	uint32_t length = 0 ;
+
+	if((static_cast<uint64_t>(offset) + sizeof(uint32_t)) <= theHeader->theStringSize)
+	{
+		std::memcpy(&length, theStrings + offset, sizeof(length)) ;
+
+		if((static_cast<uint64_t>(offset) + sizeof(uint32_t) + length) <= theHeader->theStringSize)
+		{
+			data = theStrings + offset + sizeof(uint32_t) ;
+		}
+		else
+		{
+			length = 0 ;
+		}
+	}
+
+	size_t common = (length < name.size()) ? length : name.size() ;
+	int ret = std::memcmp(data, name.data(), common) ;
+
+	if(ret == 0)
+	{
+		if(length < name.size())
+		{
+			ret = -1 ;
+		}
+		else if(length > name.size())
+		{
+			ret = 1 ;
+		}
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Returns the index of the named child record of the specified StateNode record
+ *
+ * @param index the index of the StateNode record
+ * @param name the name of the child
+ * @return the index of the child record, or NO_NODE if not found
+ */
+uint32_t
+SnapshotStateHandler::findChild(uint32_t index, const std::string& name) const
+{
+	uint32_t ret = NO_NODE ;
+
+	const NodeRecord& node = getNode(index) ;
+	if((static_cast<uint64_t>(node.theFirstChild) + node.theChildCount) <= theHeader->theNodeCount)
+	{
+		// binary search of the name ordered child records
+		uint32_t low = node.theFirstChild ;
+		uint32_t high = node.theFirstChild + node.theChildCount ;
+
+		while((low < high) && (ret == NO_NODE))
+		{
+			uint32_t mid = low + (high - low) / 2 ;
+			int cmp = compareString(getNode(mid).theName, name) ;
+
+			if(cmp < 0)
+			{
+				low = mid + 1 ;
+			}
+			else if(cmp > 0)
+			{
+				high = mid ;
+			}
+			else
+			{
+				ret = mid ;
+			}
+		}
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Returns the named value record of the specified StateNode record
+ *
+ * @param index the index of the StateNode record
+ * @param name the name of the value
+ * @return the value record, or 0 if not found
+ */
+const SnapshotStateHandler::ValueRecord*
+SnapshotStateHandler::findValue(uint32_t index, const std::string& name) const
+{
+	const ValueRecord* ret = 0 ;
+
+	const NodeRecord& node = getNode(index) ;
+	if((static_cast<uint64_t>(node.theFirstValue) + node.theValueCount) <= theHeader->theValueCount)
+	{
+		// binary search of the name ordered value records
+		uint32_t low = node.theFirstValue ;
+		uint32_t high = node.theFirstValue + node.theValueCount ;
+
+		while((low < high) && (ret == 0))
+		{
+			uint32_t mid = low + (high - low) / 2 ;
+			int cmp = compareString(getValue(mid).theName, name) ;
+
+			if(cmp < 0)
+			{
+				low = mid + 1 ;
+			}
+			else if(cmp > 0)
+			{
+				high = mid ;
+			}
+			else
+			{
+				ret = &getValue(mid) ;
+			}
+		}
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Returns the index of the StateNode record with the specified complete path
+ *
+ * @param path the complete path of the StateNode
+ * @return the index of the StateNode record, or NO_NODE if not found
+ */
+uint32_t
+SnapshotStateHandler::findNode(const std::string& path) const
+{
+	uint32_t index = NO_NODE ;
+
+	if(theHeader != 0)
+	{
+		// the root is the first record
+		index = 0 ;
+
+		std::string::size_type marker = 0 ;
+		while((index != NO_NODE) && (marker < path.length()))
+		{
+			std::string::size_type pos = path.find('/', marker) ;
+			if(pos == std::string::npos)
+			{
+				pos = path.length() ;
+			}
+
+			if(pos > marker)
+			{
+				index = findChild(index, path.substr(marker, pos - marker)) ;
+			}
+
+			marker = pos + 1 ;
+		}
+	}
+
+	return(index) ;
+}
+
+/**
+ * Returns whether the state tree has been copied into memory
+ *
+ * @return true if the state tree has been copied into memory
+ */
+bool
+SnapshotStateHandler::isCopied() const
+{
+	return(theCopyFlag) ;
+}
+
+/**
+ * Returns the StateNode at the specified path of the in memory copy of the state tree,
+ * if the state tree has been copied and the StateNode exists
+ *
+ * @param path the complete path of the StateNode
+ * @return the in memory StateNode, or an empty RefCountPtr
+ */
+RefCountPtr<StateNode>
+SnapshotStateHandler::findCopy(const std::string& path)
+{
+	RefCountPtr<StateNode> node ;
+
+	if(theCopyFlag)
+	{
+		RefCountPtr<StateNode> root = theCopy.getRootNode() ;
+
+		if(path == "/")
+		{
+			node = root ;
+		}
+		else if(root->hasChild(path))
+		{
+			node = root->getChild(path) ;
+		}
+	}
+
+	return(node) ;
+}
+
+/**
+ * Returns the StateNode at the specified path of the in memory copy of the state tree
+ * for modification, copying the snapshot into memory if not yet copied and creating
+ * the StateNode if required. The state tree is marked modified
+ *
+ * @param path the complete path of the StateNode
+ * @return the in memory StateNode
+ */
+RefCountPtr<StateNode>
+SnapshotStateHandler::modifyCopy(const std::string& path)
+{
+	if(!theCopyFlag)
+	{
+		// the snapshot is read through the StateNode interface while copied
+		theCopy.importState(*this) ;
+		theCopyFlag = true ;
+
+		// the snapshot is no longer read
+		if(theFile.isMapped())
+		{
+			theFile.unmap() ;
+		}
+
+		theHeader = 0 ;
+		theNodes = 0 ;
+		theValues = 0 ;
+		theStrings = 0 ;
+		theGeneration++ ;
+	}
+
+	theDirtyFlag = true ;
+
+	RefCountPtr<StateNode> root = theCopy.getRootNode() ;
+	RefCountPtr<StateNode> node = (path == "/") ? root : root->getChild(path) ;
+
+	return(node) ;
+}
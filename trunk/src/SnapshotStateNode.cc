@@ -0,0 +1,534 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#include <cutil/SnapshotStateNode.h>
+
+#include <cutil/RefCountPtr.h>
+#include <cutil/SnapshotStateHandler.h>
+#include <cutil/StateNode.h>
+
+#include <list>
+#include <string>
+
+using cutil::RefCountPtr ;
+using cutil::SnapshotStateHandler ;
+using cutil::SnapshotStateNode ;
+using cutil::StateNode ;
+
+//---------------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Constructs a new handle to the StateNode at the specified path of the snapshot of handler
+ *
+ * @param handler the SnapshotStateHandler of the state tree
+ * @param path the complete path of the StateNode
+ * @param index the index of the StateNode record within the snapshot
+ */
+SnapshotStateNode::SnapshotStateNode(SnapshotStateHandler& handler, const std::string& path, uint32_t index)
+		: theHandler(handler), thePath(path), theIndex(index), theGeneration(handler.theGeneration)
+{}
+
+/**
+ * Destructor
+ */
+SnapshotStateNode::~SnapshotStateNode()
+{
+	// nothing to do
+	// ... the snapshot is owned by the SnapshotStateHandler
+}
+
+
+//---------------------------------------------------------------------------------------//
+// State Tree Handling
+
+/**
+ * Returns the parent StateNode of this StateNode.
+ * If the parent StateNode does not exist, the returned RefCountPtr will point to 0.
+ *
+ * This method returns a user handle for the underlying data of the StateNode
+ * implementation. Subsequent calls to getParent need not return the same
+ * handle instance, however, it is guaranteed that each will be a handle to
+ * the same underlying data instance.
+ *
+ * @return the parent StateNode to this StateNode
+ */
+RefCountPtr<StateNode>
+SnapshotStateNode::getParent()
+{
+	RefCountPtr<StateNode> parent ;
+
+	if(thePath != "/")
+	{
+		std::string::size_type pos = thePath.rfind('/') ;
+		std::string parentPath = (pos == 0) ? std::string("/") : thePath.substr(0, pos) ;
+
+		parent.bind(new SnapshotStateNode(theHandler, parentPath, theHandler.findNode(parentPath))) ;
+	}
+
+	return(parent) ;
+}
+
+/**
+ * Returns the named child StateNode from the state tree below this StateNode,
+ * If the child StateNode does not yet exist, it is created and returned, creating any
+ * parent nodes as required.
+ * childPath may contain several '/' separated path segments.
+ *
+ * This method returns a user handle for the underlying data of the StateNode
+ * implementation. Subsequent calls to getChild need not return the same
+ * handle instance, however, it is guaranteed that each will be a handle to
+ * the same underlying data instance.
+ *
+ * @param childPath the path to the child node
+ * @return the specified child node
+ */
+RefCountPtr<StateNode>
+SnapshotStateNode::getChild(std::string childPath)
+{
+	std::list<std::string> segments ;
+	breakPath(childPath, segments) ;
+
+	uint32_t index = theHandler.isCopied() ? SnapshotStateHandler::NO_NODE : getIndex() ;
+	std::string path = thePath ;
+
+	for(std::list<std::string>::const_iterator citer = segments.begin(); citer != segments.end(); ++citer)
+	{
+		path = SnapshotStateNode::childPath(path, *citer) ;
+
+		if(index != SnapshotStateHandler::NO_NODE)
+		{
+			index = theHandler.findChild(index, *citer) ;
+		}
+	}
+
+	// a child not within the state tree is created within the in memory copy
+	if(theHandler.isCopied() ? !theHandler.findCopy(path).hasPtr() : (index == SnapshotStateHandler::NO_NODE))
+	{
+		theHandler.modifyCopy(path) ;
+	}
+
+	RefCountPtr<StateNode> child(new SnapshotStateNode(theHandler, path, index)) ;
+	return(child) ;
+}
+
+/**
+ * Removes the specified child StateNode from the state tree.
+ * The specified child StateNode must be below this StateNode within the state tree
+ *
+ * @param childPath the path to the child StateNode to remove
+ */
+void
+SnapshotStateNode::removeChild(std::string childPath)
+{
+	if(hasChild(childPath))
+	{
+		theHandler.modifyCopy(thePath)->removeChild(childPath) ;
+	}
+}
+
+/**
+ * Returns true of this StateNode contains the specified Child StateNode
+ *
+ * @param childPath the path of the specified child StateNode
+ * @return true if thie StateNode contains th specified StateNode
+ */
+bool
+SnapshotStateNode::hasChild(const std::string& childPath)
+{
+	bool ret = false ;
+
+	if(theHandler.isCopied())
+	{
+		RefCountPtr<StateNode> node = theHandler.findCopy(thePath) ;
+		ret = node.hasPtr() && node->hasChild(childPath) ;
+	}
+	else
+	{
+		std::list<std::string> segments ;
+		breakPath(childPath, segments) ;
+
+		uint32_t index = getIndex() ;
+		for(std::list<std::string>::const_iterator citer = segments.begin(); (citer != segments.end()) && (index != SnapshotStateHandler::NO_NODE); ++citer)
+		{
+			index = theHandler.findChild(index, *citer) ;
+		}
+
+		ret = !segments.empty() && (index != SnapshotStateHandler::NO_NODE) ;
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Populate the specified list with all the child StateNode names directly below this StateNode in the state tree
+ * The list is not cleared prior to any additions
+ *
+ * @param childList the list to populate
+ * @return the number of elements added to the list
+ */
+int
+SnapshotStateNode::getChildren(std::list<std::string>& childList)
+{
+	int count = 0 ;
+
+	if(theHandler.isCopied())
+	{
+		RefCountPtr<StateNode> node = theHandler.findCopy(thePath) ;
+		if(node.hasPtr())
+		{
+			count = node->getChildren(childList) ;
+		}
+	}
+	else
+	{
+		uint32_t index = getIndex() ;
+		if(index != SnapshotStateHandler::NO_NODE)
+		{
+			const SnapshotStateHandler::NodeRecord& node = theHandler.getNode(index) ;
+			for(uint32_t i = 0; (i < node.theChildCount) && (node.theFirstChild + i < theHandler.theHeader->theNodeCount); i++)
+			{
+				childList.push_back(theHandler.getString(theHandler.getNode(node.theFirstChild + i).theName)) ;
+				count++ ;
+			}
+		}
+	}
+
+	return(count) ;
+}
+
+/**
+ * Returns the complete path of this StateNode starting at the root '/'
+ *
+ * @return the complete path of this StateNode
+ */
+const std::string&
+SnapshotStateNode::getPath() const
+{
+	return(thePath) ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// State Handling
+
+/**
+ * Stores the specified value string within this StateNode associated with the specified name string
+ *
+ * @param name name with which the specified value will be associated
+ * @param value the string value to store with the specified name
+ */
+void
+SnapshotStateNode::setString(const std::string& name, const std::string& value)
+{
+	theHandler.modifyCopy(thePath)->setString(name, value) ;
+}
+
+/**
+ * Stores the specified int value within this StateNode associated with the specified name string
+ *
+ * @param name name with which the specified value will be associated
+ * @param value the int value to store with the specified name
+ */
+void
+SnapshotStateNode::setInt(const std::string& name, int value)
+{
+	theHandler.modifyCopy(thePath)->setInt(name, value) ;
+}
+
+/**
+ * Stores the specified double value within this StateNode associated with the specified name string
+ *
+ * @param name name with which the specified value will be associated
+ * @param value the double value to store with the specified name
+ */
+void
+SnapshotStateNode::setDouble(const std::string& name, double value)
+{
+	theHandler.modifyCopy(thePath)->setDouble(name, value) ;
+}
+
+/**
+ * Stores the specified bool value within this StateNode associated with the specified name string
+ *
+ * @param name name with which the specified value will be associated
+ * @param value the bool value to store with the specified name
+ */
+void
+SnapshotStateNode::setBool(const std::string& name, bool value)
+{
+	theHandler.modifyCopy(thePath)->setBool(name, value) ;
+}
+
+/**
+ * Returns the specified string value associated with the specified name from this StateNode.
+ * If the specified name is not found, the specified default value will be returned
+ *
+ * @param name the name with which the value is associated
+ * @param def the default value if the specified name cannot be found
+ * @return the string value associated with the specified name
+ */
+std::string
+SnapshotStateNode::getString(const std::string& name, const std::string& def) const
+{
+	std::string ret = def ;
+
+	if(theHandler.isCopied())
+	{
+		RefCountPtr<StateNode> node = theHandler.findCopy(thePath) ;
+		if(node.hasPtr())
+		{
+			ret = node->getString(name, def) ;
+		}
+	}
+	else
+	{
+		uint32_t index = getIndex() ;
+		const SnapshotStateHandler::ValueRecord* value = (index != SnapshotStateHandler::NO_NODE) ? theHandler.findValue(index, name) : 0 ;
+		if(value != 0)
+		{
+			ret = theHandler.getString(value->theString) ;
+		}
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Returns the specified int value associated with the specified name from this StateNode.
+ * If the specified name is not found, the specified default value will be returned
+ *
+ * @param name the name with which the value is associated
+ * @param def the default value if the specified name cannot be found
+ * @return the int value associated with the specified name
+ */
+int
+SnapshotStateNode::getInt(const std::string& name, int def) const
+{
+	int ret = def ;
+
+	if(theHandler.isCopied())
+	{
+		RefCountPtr<StateNode> node = theHandler.findCopy(thePath) ;
+		if(node.hasPtr())
+		{
+			ret = node->getInt(name, def) ;
+		}
+	}
+	else
+	{
+		uint32_t index = getIndex() ;
+		const SnapshotStateHandler::ValueRecord* value = (index != SnapshotStateHandler::NO_NODE) ? theHandler.findValue(index, name) : 0 ;
+		if(value != 0)
+		{
+			ret = value->theInt ;
+		}
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Returns the specified double value associated with the specified name from this StateNode.
+ * If the specified name is not found, the specified default value will be returned
+ *
+ * @param name the name with which the value is associated
+ * @param def the default value if the specified name cannot be found
+ * @return the double value associated with the specified name
+ */
+double
+SnapshotStateNode::getDouble(const std::string& name, double def) const
+{
+	double ret = def ;
+
+	if(theHandler.isCopied())
+	{
+		RefCountPtr<StateNode> node = theHandler.findCopy(thePath) ;
+		if(node.hasPtr())
+		{
+			ret = node->getDouble(name, def) ;
+		}
+	}
+	else
+	{
+		uint32_t index = getIndex() ;
+		const SnapshotStateHandler::ValueRecord* value = (index != SnapshotStateHandler::NO_NODE) ? theHandler.findValue(index, name) : 0 ;
+		if(value != 0)
+		{
+			ret = value->theDouble ;
+		}
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Returns the specified bool value associated with the specified name from this StateNode.
+ * If the specified name is not found, the specified default value will be returned
+ *
+ * @param name the name with which the value is associated
+ * @param def the default value if the specified name cannot be found
+ * @return the bool value associated with the specified name
+ */
+bool
+SnapshotStateNode::getBool(const std::string& name, bool def) const
+{
+	bool ret = def ;
+
+	if(theHandler.isCopied())
+	{
+		RefCountPtr<StateNode> node = theHandler.findCopy(thePath) ;
+		if(node.hasPtr())
+		{
+			ret = node->getBool(name, def) ;
+		}
+	}
+	else
+	{
+		uint32_t index = getIndex() ;
+		const SnapshotStateHandler::ValueRecord* value = (index != SnapshotStateHandler::NO_NODE) ? theHandler.findValue(index, name) : 0 ;
+		if(value != 0)
+		{
+			ret = (value->theBool != 0) ;
+		}
+	}
+
+	return(ret) ;
+}
+
+/**
+ * Removed the specified name value pair from this StateNode
+ *
+ * @param name name of the name value pair to remove
+ */
+void
+SnapshotStateNode::removeValue(const std::string& name)
+{
+	bool exists = false ;
+
+	if(theHandler.isCopied())
+	{
+		std::list<std::string> names ;
+		RefCountPtr<StateNode> node = theHandler.findCopy(thePath) ;
+		if(node.hasPtr())
+		{
+			node->getValueNames(names) ;
+		}
+
+		for(std::list<std::string>::const_iterator citer = names.begin(); (citer != names.end()) && !exists; ++citer)
+		{
+			exists = (*citer == name) ;
+		}
+	}
+	else
+	{
+		uint32_t index = getIndex() ;
+		exists = (index != SnapshotStateHandler::NO_NODE) && (theHandler.findValue(index, name) != 0) ;
+	}
+
+	if(exists)
+	{
+		theHandler.modifyCopy(thePath)->removeValue(name) ;
+	}
+}
+
+/**
+ * Populate the specified list with the names of all values stored within this StateNode
+ * The list is not cleared prior to any additions
+ *
+ * @param nameList the list to populate
+ * @return the number of elements added to the list
+ */
+int
+SnapshotStateNode::getValueNames(std::list<std::string>& nameList)
+{
+	int count = 0 ;
+
+	if(theHandler.isCopied())
+	{
+		RefCountPtr<StateNode> node = theHandler.findCopy(thePath) ;
+		if(node.hasPtr())
+		{
+			count = node->getValueNames(nameList) ;
+		}
+	}
+	else
+	{
+		uint32_t index = getIndex() ;
+		if(index != SnapshotStateHandler::NO_NODE)
+		{
+			const SnapshotStateHandler::NodeRecord& node = theHandler.getNode(index) ;
+			for(uint32_t i = 0; (i < node.theValueCount) && (node.theFirstValue + i < theHandler.theHeader->theValueCount); i++)
+			{
+				nameList.push_back(theHandler.getString(theHandler.getValue(node.theFirstValue + i).theName)) ;
+				count++ ;
+			}
+		}
+	}
+
+	return(count) ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// Snapshot access
+
+/**
+ * Returns the index of the record of this StateNode within the current snapshot,
+ * locating the record again by path should the snapshot have been reloaded
+ *
+ * @return the record index, or SnapshotStateHandler::NO_NODE if the StateNode is not within the snapshot
+ */
+uint32_t
+SnapshotStateNode::getIndex() const
+{
+	if(theGeneration != theHandler.theGeneration)
+	{
+		theIndex = theHandler.findNode(thePath) ;
+		theGeneration = theHandler.theGeneration ;
+	}
+
+	return(theIndex) ;
+}
+
+/**
+ * Returns the path of the named child of the StateNode with the specified path
+ *
+ * @param path the path of the parent StateNode
+ * @param name the name of the child
+ * @return the path of the child
+ */
+std::string
+SnapshotStateNode::childPath(const std::string& path, const std::string& name)
+{
+	std::string ret = path ;
+
+	if(ret != "/")
+	{
+		ret.append("/") ;
+	}
+
+	ret.append(name) ;
+
+	return(ret) ;
+}
@@ -50,6 +50,24 @@ StateNode::~StateNode()
 {}
 
 
+//---------------------------------------------------------------------------------------//
+// State Handling
+
+/**
+ * Populate the specified list with the names of all values stored within this StateNode
+ * The list is not cleared prior to any additions.
+ * The default implementation adds no names, for StateNodes which cannot list their values.
+ *
+ * @param nameList the list to populate
+ * @return the number of elements added to the list
+ */
+int
+StateNode::getValueNames(std::list<std::string>& /* nameList */)
+{
+	return(0) ;
+}
+
+
 /**
  * Breaks the specified path into its component segmants and adds each to pathSegments
  *
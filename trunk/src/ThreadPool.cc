@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+#include <cutil/ThreadPool.h>
+
+#include <cstring>
+#include <string>
+
+#include <unistd.h>
+
+using cutil::AbstractClosure ;
+using cutil::Exception ;
+using cutil::MutexLock ;
+using cutil::ThreadPool ;
+
+
+//-------------------------------------------------------------------------------//
+// Constructor / Desctructor
+
+/**
+ * Creates a new ThreadPool and starts the specified number of worker threads
+ *
+ * @param threads the number of worker threads, 0 uses getDefaultThreadCount
+ * @throw Exception if the worker threads cannot be started
+ */
+ThreadPool::ThreadPool(size_t threads) throw(Exception)
+{
+	theActiveCount = 0 ;
+	theShutdownFlag = false ;
+
+	if(threads == 0)
+	{
+		threads = getDefaultThreadCount() ;
+	}
+
+	for(size_t i = 0; i < threads; i++)
+	{
+		pthread_t thread ;
+		int err = ::pthread_create(&thread, 0, &ThreadPool::threadEntry, this) ;
+		if(err != 0)
+		{
+			shutdown() ;
+			throw(Exception(std::string("Exception in ThreadPool [pthread_create]:").append(::strerror(err)))) ;
+		}
+
+		theThreads.push_back(thread) ;
+	}
+}
+
+/**
+ * Destructor.
+ * Waits for all queued tasks to complete and stops the worker threads
+ *
+ */
+ThreadPool::~ThreadPool()
+{
+	shutdown() ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// ThreadPool Operations
+
+/**
+ * Queues the specified task for execution.
+ * The ThreadPool takes ownership of the task, deleting it once executed.
+ *
+ * @param task the task to execute
+ * @throw Exception if this ThreadPool has been shutdown
+ */
+void
+ThreadPool::execute(AbstractClosure<void>* task) throw(Exception)
+{
+	MutexLock lock(theMutex) ;
+
+	if(theShutdownFlag)
+	{
+		delete task ;
+		throw(Exception("Cannot execute a task upon a shutdown ThreadPool")) ;
+	}
+
+	theTasks.push_back(task) ;
+	theTaskCondition.signal() ;
+}
+
+/**
+ * Blocks the calling thread until all queued tasks have completed.
+ * Must not be called from a task executing within this ThreadPool
+ *
+ */
+void
+ThreadPool::waitIdle()
+{
+	MutexLock lock(theMutex) ;
+
+	while(!theTasks.empty() || theActiveCount > 0)
+	{
+		theIdleCondition.wait(theMutex) ;
+	}
+}
+
+/**
+ * Waits for all queued tasks to complete and stops the worker threads.
+ * No further tasks may be queued once shutdown.
+ *
+ */
+void
+ThreadPool::shutdown()
+{
+	{
+		MutexLock lock(theMutex) ;
+
+		if(theShutdownFlag)
+		{
+			return ;
+		}
+
+		theShutdownFlag = true ;
+		theTaskCondition.broadcast() ;
+	}
+
+	for(std::vector<pthread_t>::iterator iter = theThreads.begin(); iter != theThreads.end(); ++iter)
+	{
+		::pthread_join(*iter, 0) ;
+	}
+
+	theThreads.clear() ;
+}
+
+/**
+ * Returns the number of worker threads of this ThreadPool
+ *
+ * @return the number of worker threads
+ */
+size_t
+ThreadPool::getThreadCount() const
+{
+	return(theThreads.size()) ;
+}
+
+/**
+ * Returns the number of tasks queued, or executing
+ *
+ * @return the number of incomplete tasks
+ */
+size_t
+ThreadPool::getPendingCount() const
+{
+	MutexLock lock(theMutex) ;
+	return(theTasks.size() + theActiveCount) ;
+}
+
+/**
+ * Returns the number of online processors, used as the default worker thread count
+ *
+ * @return the number of online processors, at least 1
+ */
+size_t
+ThreadPool::getDefaultThreadCount()
+{
+	long count = ::sysconf(_SC_NPROCESSORS_ONLN) ;
+	return(count > 0 ? static_cast<size_t>(count) : 1) ;
+}
+
+
+//-------------------------------------------------------------------------------//
+// Private Operations
+
+/**
+ * Entry point of each worker thread
+ *
+ * @param pool the ThreadPool the thread belongs to
+ */
+void*
+ThreadPool::threadEntry(void* pool)
+{
+	static_cast<ThreadPool*>(pool)->run() ;
+	return(0) ;
+}
+
+/**
+ * Executes queued tasks until shutdown
+ *
+ */
+void
+ThreadPool::run()
+{
+	theMutex.lock() ;
+
+	while(true)
+	{
+		while(theTasks.empty() && !theShutdownFlag)
+		{
+			theTaskCondition.wait(theMutex) ;
+		}
+
+		// queued tasks are completed before the worker stops
+		if(theTasks.empty())
+		{
+			break ;
+		}
+
+		AbstractClosure<void>* task = theTasks.front() ;
+		theTasks.pop_front() ;
+		theActiveCount++ ;
+
+		theMutex.unlock() ;
+
+		try
+		{
+			(*task)() ;
+		}
+		catch(...)
+		{
+			// @note [todo] need to log this!
+		}
+
+		delete task ;
+
+		theMutex.lock() ;
+
+		theActiveCount-- ;
+		if(theTasks.empty() && theActiveCount == 0)
+		{
+			theIdleCondition.broadcast() ;
+		}
+	}
+
+	theMutex.unlock() ;
+}
@@ -21,17 +21,30 @@
 
 #include <cutil/XMLStateHandler.h>
 
+#include <cutil/FilePath.h>
 #include <cutil/RefCountPtr.h>
 #include <cutil/XMLStateNode.h>
 
 #include <libxml++/document.h>
 #include <libxml++/parsers/domparser.h>
 
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <exception>
 #include <list>
+#include <sstream>
 #include <string>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
 using namespace xmlpp ;
+using cutil::Exception ;
+using cutil::FilePath ;
+using cutil::MutexLock ;
 using cutil::XMLStateHandler ;
 using cutil::XMLStateNode ;
 
@@ -54,6 +67,9 @@ XMLStateHandler::XMLStateHandler(const std::string filename, const std::string r
 {
 	theConfigDomDocument = 0 ;
 	theDomParser = 0 ;
+	theFlushDelay = 0 ;
+	theFlushThreadFlag = false ;
+	theFlushStopFlag = false ;
 
 	if(rootNode.empty())
 	{
@@ -88,6 +104,10 @@ XMLStateHandler::~XMLStateHandler()
 void
 XMLStateHandler::initialize()
 {
+	// the background flush must not write the document while we replace it
+	MutexLock writeLock(theWriteMutex) ;
+	MutexLock lock(theChangeTracker.getMutex()) ;
+
 	// simply parse the configuration file
 	bool parsed = parseConfigurationFile(theDataFile) ;
 
@@ -125,6 +145,10 @@ XMLStateHandler::initialize()
 	else
 	{
 		// didn't parse, assume the defaults - create a new tree
+		// the DomParser holds no document, and is disposed of as above
+		delete theDomParser ;
+		theDomParser = 0 ;
+
 		createDefaultDocument() ;
 	}
 }
@@ -140,20 +164,29 @@ XMLStateHandler::initialize()
 void
 XMLStateHandler::shutdown()
 {
+	// stop any background flush, we write the remaining modifications ourself
+	stopFlushThread() ;
+
 	if(theConfigDomDocument != 0)
 	{
 		theChildHandleManager.clear() ;
+		{
+			MutexLock lock(theChangeTracker.getMutex()) ;
+			theValueCache.clear() ;
+		}
 
 		try
 		{
 			// write the configuration to the datafile
-			theConfigDomDocument->write_to_file_formatted(theDataFile) ;
+			writeDocument() ;
 		}
 		catch(std::exception e)
 		{
 
 		}
 
+		theChangeTracker.clear() ;
+
 		// dispose of the DOM document and parser
 
 		// if we have a valid parser, the we simply delete it, which
@@ -183,16 +216,17 @@ XMLStateHandler::shutdown()
 
 /**
  * Force a write of state information back to the persistant store
+ * The data file is written only if a StateNode has been modified since the last
+ * write. The document is written to a temporary file which is synchronized to disk
+ * and renamed over the data file, so the data file is never left partially written.
  *
+ * @throw Exception if the data file cannot be written
  */
 void
 XMLStateHandler::flush()
 {
 	// write the configuration to the datafile
-	if(theConfigDomDocument != 0)
-	{
-		theConfigDomDocument->write_to_file_formatted(theDataFile) ;
-	}
+	writeDocument() ;
 }
 
 /**
@@ -200,13 +234,19 @@ XMLStateHandler::flush()
  * This method ensures that this StateHandler has the most up to date information
  * from the persistant store. This may be useful if another componenet has access
  * to the backing store and may be making modification independant of this StateHandler
+ * Unwritten modifications are discarded, and StateNodes previously returned must not
+ * be used, they are obtained again through getRootNode
  *
  */
 void
 XMLStateHandler::sync()
 {
-	// @note [todo] this needs alot more thought
-	parseConfigurationFile(theDataFile) ;
+	// the StateNodes we have created wrap the elements of the document about to be released,
+	// StateNodes must be obtained again from the root StateNode
+	theChildHandleManager.clear() ;
+
+	// parse and verify the data file as when initialized
+	initialize() ;
 }
 
 
@@ -233,13 +273,124 @@ XMLStateHandler::getRootNode()
 	}
 	else
 	{
-		rootNode.bind(new XMLStateNode(theConfigDomDocument->get_root_node(), theConfigDomDocument, theChildHandleManager)) ;
+		rootNode.bind(new XMLStateNode(theConfigDomDocument->get_root_node(), theConfigDomDocument, theChildHandleManager, theValueCache, theChangeTracker)) ;
 	}
 
 	return(rootNode) ;
 }
 
 
+
+//---------------------------------------------------------------------------------------//
+// Modification Tracking
+
+/**
+ * Returns whether any StateNode has been modified since the data file was last
+ * written or read
+ *
+ * @return true if a StateNode has been modified
+ */
+bool
+XMLStateHandler::isDirty() const
+{
+	MutexLock lock(theChangeTracker.getMutex()) ;
+	return(theChangeTracker.isDirty()) ;
+}
+
+/**
+ * Populates the specified list with the paths of all StateNodes modified since the
+ * data file was last written or read
+ * The list is not cleared prior to any additions
+ *
+ * @param pathList the list to populate
+ * @return the number of paths added to the list
+ */
+int
+XMLStateHandler::getDirtyNodes(std::list<std::string>& pathList) const
+{
+	MutexLock lock(theChangeTracker.getMutex()) ;
+	return(theChangeTracker.getDirtyNodes(pathList)) ;
+}
+
+/**
+ * Sets the delay after which modifications are written to the data file from a
+ * background thread. Modifications made within the delay of the first unwritten
+ * modification are coalesced into a single write. A delay of 0 disables the
+ * background flush, modifications are then written only by flush() and shutdown().
+ * The background flush is disabled by default.
+ *
+ * @param msec the flush delay in milli seconds, 0 to disable the background flush
+ * @throw Exception if the background thread cannot be started
+ */
+void
+XMLStateHandler::setFlushDelay(unsigned long msec) throw(Exception)
+{
+	if(msec == 0)
+	{
+		stopFlushThread() ;
+	}
+
+	{
+		MutexLock lock(theChangeTracker.getMutex()) ;
+		theFlushDelay = msec ;
+
+		// wake a running flush thread to wait upon the new delay
+		theChangeTracker.wake() ;
+	}
+
+	if((msec != 0) && !theFlushThreadFlag)
+	{
+		startFlushThread() ;
+	}
+}
+
+/**
+ * Returns the delay after which modifications are written to the data file from a
+ * background thread, 0 if the background flush is disabled
+ *
+ * @return the flush delay in milli seconds
+ */
+unsigned long
+XMLStateHandler::getFlushDelay() const
+{
+	MutexLock lock(theChangeTracker.getMutex()) ;
+	return(theFlushDelay) ;
+}
+
+
+
+//---------------------------------------------------------------------------------------//
+// Value Caching
+
+/**
+ * Sets whether values are cached as they are read.
+ * With caching enabled, each value is located within the XML document, and parsed
+ * into the type requested, only on its first access. Subsequent access is a hash
+ * lookup of the cached value. Setting a value unchanged does not rewrite the document.
+ * The cache is discarded whenever the document is parsed, and when a child StateNode
+ * is removed. Caching is enabled by default.
+ *
+ * @param caching set true to cache values
+ */
+void
+XMLStateHandler::setCaching(bool caching)
+{
+	MutexLock lock(theChangeTracker.getMutex()) ;
+	theValueCache.setEnabled(caching) ;
+}
+
+/**
+ * Returns whether values are cached as they are read
+ *
+ * @return true if values are cached, false otherwise
+ */
+bool
+XMLStateHandler::getCaching() const
+{
+	return(theValueCache.isEnabled()) ;
+}
+
+
 /**
  * Parse the configuration file
  *
@@ -252,6 +403,11 @@ XMLStateHandler::parseConfigurationFile(std::string filename)
 	// track our return status
 	bool ret = false ;
 
+	// cached values refer to the elements of the document we are about to release,
+	// and any modifications are discarded with it
+	theValueCache.clear() ;
+	theChangeTracker.clear() ;
+
 	if(theConfigDomDocument != 0)
 	{
 		// we make the assumption here that we can release the current config document
@@ -306,6 +462,150 @@ XMLStateHandler::createDefaultDocument()
 	theConfigDomDocument->create_root_node(theRootNodeName) ;
 }
 
+/**
+ * Writes the document to the data file if any StateNode has been modified since
+ * the last write, replacing the data file atomically
+ *
+ * @throw Exception if the data file cannot be written
+ */
+void
+XMLStateHandler::writeDocument()
+{
+	// writes are serialized so the data file always receives the latest document
+	MutexLock writeLock(theWriteMutex) ;
+
+	std::set<std::string> written ;
+	std::string content ;
+
+	{
+		// serialize the document while modifications are excluded, the file is
+		// then written without blocking further modification
+		MutexLock lock(theChangeTracker.getMutex()) ;
+
+		if((theConfigDomDocument != 0) && theChangeTracker.isDirty())
+		{
+			content = theConfigDomDocument->write_to_string_formatted() ;
+			theChangeTracker.takeDirty(written) ;
+		}
+	}
+
+	if(!written.empty())
+	{
+		try
+		{
+			FilePath(theDataFile).replaceFile(content) ;
+		}
+		catch(Exception& e)
+		{
+			// the modifications remain to be written
+			MutexLock lock(theChangeTracker.getMutex()) ;
+			theChangeTracker.restoreDirty(written) ;
+
+			throw ;
+		}
+	}
+}
+
+/**
+ * Starts the background flush thread
+ *
+ * @throw Exception if the thread cannot be started
+ */
+void
+XMLStateHandler::startFlushThread() throw(Exception)
+{
+	theFlushStopFlag = false ;
+
+	int err = ::pthread_create(&theFlushThread, 0, &XMLStateHandler::flushThreadEntry, this) ;
+	if(err != 0)
+	{
+		throw(Exception(std::string("Exception in XMLStateHandler [pthread_create]:").append(::strerror(err)))) ;
+	}
+
+	theFlushThreadFlag = true ;
+}
+
+/**
+ * Stops the background flush thread, waiting for any write in progress
+ *
+ */
+void
+XMLStateHandler::stopFlushThread()
+{
+	if(theFlushThreadFlag)
+	{
+		{
+			MutexLock lock(theChangeTracker.getMutex()) ;
+			theFlushStopFlag = true ;
+			theChangeTracker.wake() ;
+		}
+
+		::pthread_join(theFlushThread, 0) ;
+		theFlushThreadFlag = false ;
+	}
+}
+
+/**
+ * Writes modifications to the data file once the flush delay has passed since the
+ * first modification, until the background flush thread is stopped
+ *
+ */
+void
+XMLStateHandler::runFlushThread()
+{
+	Mutex& mutex = theChangeTracker.getMutex() ;
+	mutex.lock() ;
+
+	while(!theFlushStopFlag)
+	{
+		if(!theChangeTracker.isDirty())
+		{
+			theChangeTracker.wait(-1) ;
+		}
+		else
+		{
+			// further modifications within the delay are written together
+			double due = theChangeTracker.getDirtyTime() + (theFlushDelay / 1000.0) ;
+			double remaining = due - ChangeTracker::now() ;
+
+			if(remaining > 0)
+			{
+				theChangeTracker.wait(static_cast<long>(remaining * 1e6) + 1) ;
+			}
+			else
+			{
+				mutex.unlock() ;
+
+				try
+				{
+					writeDocument() ;
+				}
+				catch(std::exception& e)
+				{
+					// the modifications are marked dirty again and retried after the delay
+				}
+
+				mutex.lock() ;
+			}
+		}
+	}
+
+	mutex.unlock() ;
+}
+
+/**
+ * Entry point of the background flush thread
+ *
+ * @param handler the XMLStateHandler the thread flushes
+ * @return 0
+ */
+void*
+XMLStateHandler::flushThreadEntry(void* handler)
+{
+	static_cast<XMLStateHandler*>(handler)->runFlushThread() ;
+	return(0) ;
+}
+
 
 
 
@@ -447,3 +747,295 @@ XMLStateHandler::ChildHandleManager::cleaupHandleReferences()
 	}
 }
 
+
+
+//---------------------------------------------------------------------------------------//
+// Inner class used to cache the name-value pairs of the document
+
+/**
+ * Default Constructor, caching is enabled
+ */
+XMLStateHandler::ValueCache::ValueCache()
+{
+	theEnabledFlag = true ;
+}
+
+/**
+ * Destructor
+ */
+XMLStateHandler::ValueCache::~ValueCache()
+{
+
+}
+
+/**
+ * Returns the cached entry of the named value of the specified StateNode Element
+ *
+ * @param node the DOM Element of the StateNode
+ * @param name the name of the value
+ * @return the cached entry, or 0 if the value is not cached
+ */
+XMLStateHandler::ValueCache::Entry*
+XMLStateHandler::ValueCache::find(const xmlpp::Element* node, const std::string& name)
+{
+	Entry* entry = 0 ;
+
+	NodeContainer::iterator niter = theNodes.find(node) ;
+	if(niter != theNodes.end())
+	{
+		EntryContainer::iterator eiter = (*niter).second.find(name) ;
+		if(eiter != (*niter).second.end())
+		{
+			entry = &((*eiter).second) ;
+		}
+	}
+
+	return(entry) ;
+}
+
+/**
+ * Returns the cached entry of the named value of the specified StateNode Element,
+ * adding an empty entry if the value is not cached
+ *
+ * @param node the DOM Element of the StateNode
+ * @param name the name of the value
+ * @return the cached entry
+ */
+XMLStateHandler::ValueCache::Entry&
+XMLStateHandler::ValueCache::insert(const xmlpp::Element* node, const std::string& name)
+{
+	return(theNodes[node][name]) ;
+}
+
+/**
+ * Removes the cached entry of the named value of the specified StateNode Element
+ *
+ * @param node the DOM Element of the StateNode
+ * @param name the name of the value
+ */
+void
+XMLStateHandler::ValueCache::remove(const xmlpp::Element* node, const std::string& name)
+{
+	NodeContainer::iterator niter = theNodes.find(node) ;
+	if(niter != theNodes.end())
+	{
+		(*niter).second.erase(name) ;
+	}
+}
+
+/**
+ * Removes all cached entries
+ *
+ */
+void
+XMLStateHandler::ValueCache::clear()
+{
+	theNodes.clear() ;
+}
+
+/**
+ * Sets whether values are cached, disabling the cache clears it
+ *
+ * @param enabled set true to cache values
+ */
+void
+XMLStateHandler::ValueCache::setEnabled(bool enabled)
+{
+	theEnabledFlag = enabled ;
+
+	if(!theEnabledFlag)
+	{
+		clear() ;
+	}
+}
+
+/**
+ * Returns whether values are cached
+ *
+ * @return true if values are cached
+ */
+bool
+XMLStateHandler::ValueCache::isEnabled() const
+{
+	return(theEnabledFlag) ;
+}
+
+
+
+//---------------------------------------------------------------------------------------//
+// Inner class used to track the modified StateNodes of the document
+
+/**
+ * Default Constructor
+ *
+ * @throw Exception if the Mutex or Condition cannot be created
+ */
+XMLStateHandler::ChangeTracker::ChangeTracker() throw(Exception)
+{
+	theDirtyTime = 0.0 ;
+}
+
+/**
+ * Destructor
+ */
+XMLStateHandler::ChangeTracker::~ChangeTracker()
+{
+
+}
+
+/**
+ * Returns the Mutex guarding the document and the modified StateNodes
+ *
+ * @return the Mutex guarding the document
+ */
+cutil::Mutex&
+XMLStateHandler::ChangeTracker::getMutex()
+{
+	return(theMutex) ;
+}
+
+/**
+ * Marks the StateNode with the specified path modified, waking any thread
+ * waiting upon the first modification.
+ * The caller must hold the Mutex of this tracker
+ *
+ * @param path the path of the modified StateNode
+ */
+void
+XMLStateHandler::ChangeTracker::markDirty(const std::string& path)
+{
+	if(theDirtyPaths.empty())
+	{
+		theDirtyTime = now() ;
+		theCondition.broadcast() ;
+	}
+
+	theDirtyPaths.insert(path) ;
+}
+
+/**
+ * Returns whether any StateNode is modified.
+ * The caller must hold the Mutex of this tracker
+ *
+ * @return true if a StateNode is modified
+ */
+bool
+XMLStateHandler::ChangeTracker::isDirty() const
+{
+	return(!theDirtyPaths.empty()) ;
+}
+
+/**
+ * Returns the monotonic time, in seconds, of the first modification since
+ * the modified StateNodes were last taken or cleared.
+ * The caller must hold the Mutex of this tracker
+ *
+ * @return the time of the first modification
+ */
+double
+XMLStateHandler::ChangeTracker::getDirtyTime() const
+{
+	return(theDirtyTime) ;
+}
+
+/**
+ * Populates the specified list with the paths of the modified StateNodes.
+ * The caller must hold the Mutex of this tracker
+ *
+ * @param pathList the list to populate
+ * @return the number of paths added to the list
+ */
+int
+XMLStateHandler::ChangeTracker::getDirtyNodes(std::list<std::string>& pathList) const
+{
+	int count = 0 ;
+
+	for(std::set<std::string>::const_iterator citer = theDirtyPaths.begin(); citer != theDirtyPaths.end(); ++citer)
+	{
+		pathList.push_back(*citer) ;
+		count++ ;
+	}
+
+	return(count) ;
+}
+
+/**
+ * Moves the paths of the modified StateNodes into the specified set, leaving
+ * no StateNode marked modified.
+ * The caller must hold the Mutex of this tracker
+ *
+ * @param paths the set to receive the modified paths
+ */
+void
+XMLStateHandler::ChangeTracker::takeDirty(std::set<std::string>& paths)
+{
+	paths.swap(theDirtyPaths) ;
+	theDirtyPaths.clear() ;
+}
+
+/**
+ * Marks the specified StateNodes modified again, after the modifications
+ * taken with takeDirty could not be written
+ * The caller must hold the Mutex of this tracker
+ *
+ * @param paths the paths of the StateNodes to mark modified
+ */
+void
+XMLStateHandler::ChangeTracker::restoreDirty(const std::set<std::string>& paths)
+{
+	// the restored modifications are due again only after a further delay
+	theDirtyTime = now() ;
+	theDirtyPaths.insert(paths.begin(), paths.end()) ;
+}
+
+/**
+ * Marks all StateNodes unmodified
+ * The caller must hold the Mutex of this tracker
+ */
+void
+XMLStateHandler::ChangeTracker::clear()
+{
+	theDirtyPaths.clear() ;
+}
+
+/**
+ * Waits at most usec micro seconds for a modification, or for wake to be called.
+ * The caller must hold the Mutex of this tracker, a negative timeout waits
+ * indefinitely
+ *
+ * @param usec the maximum time to wait in micro seconds
+ */
+void
+XMLStateHandler::ChangeTracker::wait(long usec)
+{
+	if(usec < 0)
+	{
+		theCondition.wait(theMutex) ;
+	}
+	else
+	{
+		theCondition.timedWait(theMutex, usec) ;
+	}
+}
+
+/**
+ * Wakes all threads waiting within wait
+ */
+void
+XMLStateHandler::ChangeTracker::wake()
+{
+	theCondition.broadcast() ;
+}
+
+/**
+ * Returns the current monotonic time in seconds
+ *
+ * @return the current monotonic time
+ */
+double
+XMLStateHandler::ChangeTracker::now()
+{
+	struct timespec ts ;
+	::clock_gettime(CLOCK_MONOTONIC, &ts) ;
+	return(ts.tv_sec + ts.tv_nsec / 1e9) ;
+}
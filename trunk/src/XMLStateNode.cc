@@ -31,6 +31,7 @@
 #include <cstdlib>
 #include <sstream>
 
+using cutil::MutexLock ;
 using cutil::StateNode ;
 using cutil::XMLStateNode ;
 using namespace xmlpp ;
@@ -57,9 +58,11 @@ const std::string XMLStateNode::VALUE_ATTR = "value" ;
  * @param element the xmlpp::Element which stores the actual data
  * @param document the xml document we are acting as a state node for
  * @param childHandler the container to manage constructed state handlers
+ * @param valueCache the cache of values shared by all state nodes of the document
+ * @param changeTracker the tracker of modified state nodes of the document
  */
-XMLStateNode::XMLStateNode(xmlpp::Element* element, xmlpp::Document* document, XMLStateHandler::ChildHandleManager& childHandler)
-	: thePath("/"), theParent(cutil::RefCountPtr<cutil::StateNode>()), theDOMElement(element), theDOMDocument(document), theChildHandleManager(childHandler)
+XMLStateNode::XMLStateNode(xmlpp::Element* element, xmlpp::Document* document, XMLStateHandler::ChildHandleManager& childHandler, XMLStateHandler::ValueCache& valueCache, XMLStateHandler::ChangeTracker& changeTracker)
+	: thePath("/"), theParent(cutil::RefCountPtr<cutil::StateNode>()), theDOMElement(element), theDOMDocument(document), theChildHandleManager(childHandler), theValueCache(valueCache), theChangeTracker(changeTracker)
 {
 	
 }
@@ -76,9 +79,11 @@ XMLStateNode::XMLStateNode(xmlpp::Element* element, xmlpp::Document* document, X
  * @param element the xmlpp::Element which stores the actual data
  * @param document the xml document we are acting as a state node for
  * @param childHandler the container to manage constructed state handlers
+ * @param valueCache the cache of values shared by all state nodes of the document
+ * @param changeTracker the tracker of modified state nodes of the document
  */
-XMLStateNode::XMLStateNode(const std::string& path, RefCountPtr<StateNode> parent, Element* element, Document* document, XMLStateHandler::ChildHandleManager& childHandler)
-		: thePath(path), theParent(parent), theDOMElement(element), theDOMDocument(document), theChildHandleManager(childHandler)
+XMLStateNode::XMLStateNode(const std::string& path, RefCountPtr<StateNode> parent, Element* element, Document* document, XMLStateHandler::ChildHandleManager& childHandler, XMLStateHandler::ValueCache& valueCache, XMLStateHandler::ChangeTracker& changeTracker)
+		: thePath(path), theParent(parent), theDOMElement(element), theDOMDocument(document), theChildHandleManager(childHandler), theValueCache(valueCache), theChangeTracker(changeTracker)
 {
 	// nothing else to do
 }
@@ -186,8 +191,12 @@ XMLStateNode::getChild(std::string childPath)
 		if(!foundNode)
 		{
 			// didnt find the element, so create a new one
+			MutexLock lock(theChangeTracker.getMutex()) ;
+
 			child = theDOMElement->add_child(XMLStateNode::CONFIG_TAG) ;
 			child->set_attribute(XMLStateNode::CONFIG_ID, childPath) ;
+
+			theChangeTracker.markDirty(getPath()) ;
 		}
 
 		if(child != 0)
@@ -195,7 +204,7 @@ XMLStateNode::getChild(std::string childPath)
 			// get the StateNode (as handled by a RefCountPtr) for use as the parent
 			// of the newly created StateNode
 			cutil::RefCountPtr<StateNode> parentHandler = theChildHandleManager.getChild(getPath()) ;
-			stateNode.bind(new XMLStateNode(completePath, parentHandler, child, theDOMDocument, theChildHandleManager)) ;
+			stateNode.bind(new XMLStateNode(completePath, parentHandler, child, theDOMDocument, theChildHandleManager, theValueCache, theChangeTracker)) ;
 
 			// since we have created a new handler, we place it into the child container
 			// making sure we use the complete path, not just relative to this StateNode
@@ -240,7 +249,14 @@ XMLStateNode::removeChild(std::string childPath)
 
 	if(toRemove)
 	{
+		MutexLock lock(theChangeTracker.getMutex()) ;
+
 		theDOMElement->remove_child(toRemove) ;
+		theChangeTracker.markDirty(getPath()) ;
+
+		// the values of the removed subtree are cached against elements now released,
+		// whose addresses may be reused, so we discard the whole cache
+		theValueCache.clear() ;
 	}
 
 	// before we return, we perform some cleanup on child handle reference
@@ -332,15 +348,7 @@ XMLStateNode::getPath() const
 void
 XMLStateNode::setString(const std::string& name, const std::string& value)
 {
-	Element* configParamElem = getNameValueElement(name) ;
-
-	if(configParamElem == 0)
-	{
-		configParamElem = theDOMElement->add_child(XMLStateNode::PARAM_TAG) ;
-	}
-
-	configParamElem->set_attribute(XMLStateNode::NAME_ATTR, name) ;
-	configParamElem->set_attribute(XMLStateNode::VALUE_ATTR, value) ;
+	storeValue(name, value) ;
 }
 
 /**
@@ -352,17 +360,9 @@ XMLStateNode::setString(const std::string& name, const std::string& value)
 void
 XMLStateNode::setInt(const std::string& name, int value)
 {
-	Element* configParamElem = getNameValueElement(name) ;
-
-	if(configParamElem == 0)
-	{
-		configParamElem = theDOMElement->add_child(XMLStateNode::PARAM_TAG) ;
-	}
-
-	configParamElem->set_attribute(XMLStateNode::NAME_ATTR, name) ;
 	std::ostringstream buf ;
 	buf << value ;
-	configParamElem->set_attribute(XMLStateNode::VALUE_ATTR, buf.str()) ;
+	storeValue(name, buf.str()) ;
 }
 
 /**
@@ -374,17 +374,9 @@ XMLStateNode::setInt(const std::string& name, int value)
 void
 XMLStateNode::setDouble(const std::string& name, double value)
 {
-	Element* configParamElem = getNameValueElement(name) ;
-
-	if(configParamElem == 0)
-	{
-		configParamElem = theDOMElement->add_child(XMLStateNode::PARAM_TAG) ;
-	}
-
-	configParamElem->set_attribute(XMLStateNode::NAME_ATTR, name) ;
 	std::ostringstream buf ;
 	buf << value ;
-	configParamElem->set_attribute(XMLStateNode::VALUE_ATTR, buf.str()) ;
+	storeValue(name, buf.str()) ;
 }
 
 /**
@@ -396,15 +388,7 @@ XMLStateNode::setDouble(const std::string& name, double value)
 void
 XMLStateNode::setBool(const std::string& name, bool value)
 {
-	Element* configParamElem = getNameValueElement(name) ;
-
-	if(configParamElem == 0)
-	{
-		configParamElem = theDOMElement->add_child(XMLStateNode::PARAM_TAG) ;
-	}
-
-	configParamElem->set_attribute(XMLStateNode::NAME_ATTR, name) ;
-	configParamElem->set_attribute(XMLStateNode::VALUE_ATTR, (value ? "true" : "false")) ;
+	storeValue(name, (value ? "true" : "false")) ;
 }
 
 
@@ -422,12 +406,27 @@ XMLStateNode::getString(const std::string& name, const std::string& def) const
 {
 	std::string ret = def ;
 
-	Element* element = getNameValueElement(name) ;
+	// the cache is shared by all StateNodes of the document, and filled as values are read
+	MutexLock lock(theChangeTracker.getMutex()) ;
 
-	if(element != 0)
+	XMLStateHandler::ValueCache::Entry* entry = lookupValue(name) ;
+
+	if(entry != 0)
+	{
+		if(entry->theElement != 0)
+		{
+			ret = entry->theString ;
+		}
+	}
+	else
 	{
-		Attribute* attr = element->get_attribute(XMLStateNode::VALUE_ATTR) ;
-		ret = attr->get_value() ;
+		Element* element = getNameValueElement(name) ;
+
+		if(element != 0)
+		{
+			Attribute* attr = element->get_attribute(XMLStateNode::VALUE_ATTR) ;
+			ret = attr->get_value() ;
+		}
 	}
 
 	return(ret) ;
@@ -447,13 +446,34 @@ XMLStateNode::getInt(const std::string& name, int def) const
 {
 	int ret = def ;
 
-	Element* element = getNameValueElement(name) ;
+	// the cache is shared by all StateNodes of the document, and filled as values are read
+	MutexLock lock(theChangeTracker.getMutex()) ;
 
-	if(element != 0)
+	XMLStateHandler::ValueCache::Entry* entry = lookupValue(name) ;
+
+	if(entry != 0)
+	{
+		if(entry->theElement != 0)
+		{
+			if(!entry->theIntFlag)
+			{
+				entry->theInt = atoi(entry->theString.c_str()) ;
+				entry->theIntFlag = true ;
+			}
+
+			ret = entry->theInt ;
+		}
+	}
+	else
 	{
-		Attribute* attr = element->get_attribute(XMLStateNode::VALUE_ATTR) ;
-		std::string s = attr->get_value() ;
-		ret = atoi(s.c_str()) ;
+		Element* element = getNameValueElement(name) ;
+
+		if(element != 0)
+		{
+			Attribute* attr = element->get_attribute(XMLStateNode::VALUE_ATTR) ;
+			std::string s = attr->get_value() ;
+			ret = atoi(s.c_str()) ;
+		}
 	}
 
 	return(ret) ;
@@ -473,13 +493,34 @@ XMLStateNode::getDouble(const std::string& name, double def) const
 {
 	double ret = def ;
 
-	Element* element = getNameValueElement(name) ;
+	// the cache is shared by all StateNodes of the document, and filled as values are read
+	MutexLock lock(theChangeTracker.getMutex()) ;
 
-	if(element != 0)
+	XMLStateHandler::ValueCache::Entry* entry = lookupValue(name) ;
+
+	if(entry != 0)
+	{
+		if(entry->theElement != 0)
+		{
+			if(!entry->theDoubleFlag)
+			{
+				entry->theDouble = strtod(entry->theString.c_str(), 0) ;
+				entry->theDoubleFlag = true ;
+			}
+
+			ret = entry->theDouble ;
+		}
+	}
+	else
 	{
-		Attribute* attr = element->get_attribute(XMLStateNode::VALUE_ATTR) ;
-		std::string s = attr->get_value() ;
-		ret = strtod(s.c_str(), 0) ;
+		Element* element = getNameValueElement(name) ;
+
+		if(element != 0)
+		{
+			Attribute* attr = element->get_attribute(XMLStateNode::VALUE_ATTR) ;
+			std::string s = attr->get_value() ;
+			ret = strtod(s.c_str(), 0) ;
+		}
 	}
 
 	return(ret) ;
@@ -499,19 +540,40 @@ XMLStateNode::getBool(const std::string& name, bool def) const
 {
 	bool ret = def ;
 
-	Element* element = getNameValueElement(name) ;
+	// the cache is shared by all StateNodes of the document, and filled as values are read
+	MutexLock lock(theChangeTracker.getMutex()) ;
 
-	if(element != 0)
+	XMLStateHandler::ValueCache::Entry* entry = lookupValue(name) ;
+
+	if(entry != 0)
 	{
-		Attribute* attr = element->get_attribute(XMLStateNode::VALUE_ATTR) ;
-		std::string s = attr->get_value() ;
-		if(s == "true")
+		if(entry->theElement != 0)
 		{
-			ret = true ;
+			if(!entry->theBoolFlag)
+			{
+				entry->theBool = (entry->theString == "true") ;
+				entry->theBoolFlag = true ;
+			}
+
+			ret = entry->theBool ;
 		}
-		else
+	}
+	else
+	{
+		Element* element = getNameValueElement(name) ;
+
+		if(element != 0)
 		{
-			ret = false ;
+			Attribute* attr = element->get_attribute(XMLStateNode::VALUE_ATTR) ;
+			std::string s = attr->get_value() ;
+			if(s == "true")
+			{
+				ret = true ;
+			}
+			else
+			{
+				ret = false ;
+			}
 		}
 	}
 
@@ -528,12 +590,46 @@ XMLStateNode::getBool(const std::string& name, bool def) const
 void
 XMLStateNode::removeValue(const std::string& name)
 {
+	MutexLock lock(theChangeTracker.getMutex()) ;
+
 	Element* element = getNameValueElement(name) ;
 
 	if(element != 0)
 	{
 		theDOMElement->remove_child(element) ;
+		theChangeTracker.markDirty(getPath()) ;
+	}
+
+	theValueCache.remove(theDOMElement, name) ;
+}
+
+/**
+ * Populate the specified list with the names of all values stored within this StateNode
+ * The list is not cleared prior to any additions
+ *
+ * @param nameList the list to populate
+ * @return the number of elements added to the list
+ */
+int
+XMLStateNode::getValueNames(std::list<std::string>& nameList)
+{
+	int count = 0 ;
+
+	Node::NodeList nodeList = theDOMElement->get_children(XMLStateNode::PARAM_TAG) ;
+
+	for(Node::NodeList::const_iterator citer = nodeList.begin(); citer != nodeList.end(); ++citer)
+	{
+		Element* tempElement = (Element*)(*citer) ;
+
+		Attribute* attr = tempElement->get_attribute(XMLStateNode::NAME_ATTR) ;
+		if(attr != 0)
+		{
+			nameList.push_back(attr->get_value()) ;
+			count++ ;
+		}
 	}
+
+	return(count) ;
 }
 
 
@@ -568,3 +664,95 @@ XMLStateNode::getNameValueElement(const std::string& name) const
 	return(ret) ;
 }
 
+/**
+ * Returns the cached entry of the named value, locating the value within the
+ * document if it is not yet cached. The entry Element is 0 if the value does not exist.
+ * If value caching is disabled, 0 is returned.
+ * The caller must hold the Mutex of the ChangeTracker
+ *
+ * @param name the name associated with the value
+ * @return the cached entry of the named value, or 0 if caching is disabled
+ */
+cutil::XMLStateHandler::ValueCache::Entry*
+XMLStateNode::lookupValue(const std::string& name) const
+{
+	XMLStateHandler::ValueCache::Entry* entry = 0 ;
+
+	if(theValueCache.isEnabled())
+	{
+		entry = theValueCache.find(theDOMElement, name) ;
+
+		if(entry == 0)
+		{
+			// first access, locate the value within the document and cache it,
+			// caching the absence of the value also
+			Element* element = getNameValueElement(name) ;
+
+			entry = &(theValueCache.insert(theDOMElement, name)) ;
+			entry->theElement = element ;
+
+			if(element != 0)
+			{
+				Attribute* attr = element->get_attribute(XMLStateNode::VALUE_ATTR) ;
+				if(attr != 0)
+				{
+					entry->theString = attr->get_value() ;
+				}
+			}
+		}
+	}
+
+	return(entry) ;
+}
+
+/**
+ * Stores the specified value string associated with the specified name within the
+ * document, updating the cached entry and marking this StateNode modified. The document
+ * is not modified if the cached value is unchanged
+ *
+ * @param name name with which the specified value will be associated
+ * @param value the value string to store with the specified name
+ */
+void
+XMLStateNode::storeValue(const std::string& name, const std::string& value)
+{
+	MutexLock lock(theChangeTracker.getMutex()) ;
+
+	XMLStateHandler::ValueCache::Entry* entry = lookupValue(name) ;
+
+	if(entry != 0)
+	{
+		if((entry->theElement == 0) || (entry->theString != value))
+		{
+			if(entry->theElement == 0)
+			{
+				entry->theElement = theDOMElement->add_child(XMLStateNode::PARAM_TAG) ;
+				entry->theElement->set_attribute(XMLStateNode::NAME_ATTR, name) ;
+			}
+
+			entry->theElement->set_attribute(XMLStateNode::VALUE_ATTR, value) ;
+
+			// reset the entry to the new value, discarding any parsed values
+			entry->theString = value ;
+			entry->theIntFlag = false ;
+			entry->theDoubleFlag = false ;
+			entry->theBoolFlag = false ;
+
+			theChangeTracker.markDirty(getPath()) ;
+		}
+	}
+	else
+	{
+		Element* configParamElem = getNameValueElement(name) ;
+
+		if(configParamElem == 0)
+		{
+			configParamElem = theDOMElement->add_child(XMLStateNode::PARAM_TAG) ;
+		}
+
+		configParamElem->set_attribute(XMLStateNode::NAME_ATTR, name) ;
+		configParamElem->set_attribute(XMLStateNode::VALUE_ATTR, value) ;
+
+		theChangeTracker.markDirty(getPath()) ;
+	}
+}
@@ -0,0 +1,489 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#include <cutil/XMLStreamStateHandler.h>
+
+#include <cutil/FilePath.h>
+#include <cutil/MemoryStateHandler.h>
+#include <cutil/RefCountPtr.h>
+#include <cutil/StateNode.h>
+#include <cutil/XMLStateHandler.h>
+#include <cutil/XMLStateNode.h>
+
+#include <libxml++/parsers/saxparser.h>
+
+#include <cstdio>
+#include <exception>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using cutil::Exception ;
+using cutil::FilePath ;
+using cutil::MemoryStateHandler ;
+using cutil::RefCountPtr ;
+using cutil::StateNode ;
+using cutil::XMLStateHandler ;
+using cutil::XMLStateNode ;
+using cutil::XMLStreamStateHandler ;
+
+namespace
+{
+	/**
+	 * SAX parser adding each config_node and config_param to a state tree as it is parsed.
+	 * A stack holds the StateNode of each open element, or an empty handle for elements
+	 * which are not config_nodes, so only the path from the root to the current element
+	 * is held at any time.
+	 */
+	class StateParser : public xmlpp::SaxParser
+	{
+		public:
+			/**
+			 * Constructs a new StateParser adding state information beneath the specified
+			 * root StateNode
+			 *
+			 * @param root the root StateNode of the state tree to populate
+			 * @param rootName the expected name of the root element
+			 */
+			StateParser(RefCountPtr<StateNode> root, const std::string& rootName)
+				: theRoot(root), theRootName(rootName), theValidFlag(true)
+			{
+				// otherwise libxml2 reports &amp; within attribute values as &#38;
+				set_substitute_entities(true) ;
+			}
+
+			/**
+			 * Returns whether the document root element matched the expected root name
+			 *
+			 * @return true if the document root element was valid
+			 */
+			bool isValid() const
+			{
+				return(theValidFlag) ;
+			}
+
+		protected:
+			virtual void on_start_element(const Glib::ustring& name, const AttributeList& attributes)
+			{
+				RefCountPtr<StateNode> node ;
+
+				if(theStack.empty())
+				{
+					if(name == theRootName)
+					{
+						node = theRoot ;
+					}
+					else
+					{
+						theValidFlag = false ;
+					}
+				}
+				else if(theStack.back().hasPtr())
+				{
+					RefCountPtr<StateNode> parent = theStack.back() ;
+
+					if(name == XMLStateNode::CONFIG_TAG)
+					{
+						std::string id ;
+						if(findAttribute(attributes, XMLStateNode::CONFIG_ID, id))
+						{
+							node = parent->getChild(id) ;
+						}
+					}
+					else if(name == XMLStateNode::PARAM_TAG)
+					{
+						std::string paramName ;
+						std::string value ;
+						if(findAttribute(attributes, XMLStateNode::NAME_ATTR, paramName) && findAttribute(attributes, XMLStateNode::VALUE_ATTR, value))
+						{
+							parent->setString(paramName, value) ;
+						}
+					}
+				}
+
+				theStack.push_back(node) ;
+			}
+
+			virtual void on_end_element(const Glib::ustring&)
+			{
+				if(!theStack.empty())
+				{
+					theStack.pop_back() ;
+				}
+			}
+
+		private:
+			/**
+			 * Finds the value of the named attribute within the specified attributes
+			 *
+			 * @param attributes the attributes of an element
+			 * @param name the attribute name to find
+			 * @param value set to the attribute value if found
+			 * @return true if the attribute was found
+			 */
+			static bool findAttribute(const AttributeList& attributes, const std::string& name, std::string& value)
+			{
+				for(AttributeList::const_iterator citer = attributes.begin(); citer != attributes.end(); ++citer)
+				{
+					if(citer->name == name)
+					{
+						value = citer->value ;
+						return(true) ;
+					}
+				}
+
+				return(false) ;
+			}
+
+			/** the root StateNode of the state tree */
+			RefCountPtr<StateNode> theRoot ;
+
+			/** the expected name of the root element */
+			std::string theRootName ;
+
+			/** the StateNode of each open element, or an empty handle if not a config_node */
+			std::vector<RefCountPtr<StateNode> > theStack ;
+
+			/** set false if the root element did not match the expected name */
+			bool theValidFlag ;
+	} ;
+
+	/**
+	 * Writes the specified number of indentation levels to the specified stream
+	 *
+	 * @param out the stream to write to
+	 * @param depth the indentation level
+	 */
+	void indent(FILE* out, int depth)
+	{
+		for(int i = 0; i < depth; i++)
+		{
+			fputs("  ", out) ;
+		}
+	}
+}
+
+/**
+ * FilePath::ContentWriter writing a state tree as an XML document
+ */
+class XMLStreamStateHandler::StateWriter : public FilePath::ContentWriter
+{
+	public:
+		/**
+		 * Constructs a new StateWriter writing the state tree of the specified StateHandler
+		 *
+		 * @param source the initialized StateHandler to write
+		 * @param rootName the name of the root element
+		 */
+		StateWriter(StateHandler& source, const std::string& rootName)
+			: theSource(source), theRootName(rootName)
+		{}
+
+		virtual void write(FILE* out)
+		{
+			fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n", out) ;
+			fprintf(out, "<%s>\n", theRootName.c_str()) ;
+
+			RefCountPtr<StateNode> root = theSource.getRootNode() ;
+			writeNode(out, *root.getPtr(), 1) ;
+
+			fprintf(out, "</%s>\n", theRootName.c_str()) ;
+		}
+
+	private:
+		/** the StateHandler to write */
+		StateHandler& theSource ;
+
+		/** the name of the root element */
+		std::string theRootName ;
+} ;
+
+/**
+ * Constructs a new XMLStreamStateHandler to read and store state information within
+ * the specified XML data file
+ *
+ * @param filename the file path of the XML data file
+ * @param rootNode the name of the root element within the XML data file,
+ *        if left blank, this will default to XMLStatehandler::ROOT_NODE
+ */
+XMLStreamStateHandler::XMLStreamStateHandler(const std::string& filename, const std::string& rootNode)
+	: theDataFile(filename), theRootNodeName(rootNode), theWrittenCount(0)
+{
+	if(theRootNodeName.empty())
+	{
+		theRootNodeName = XMLStateHandler::ROOT_NODE ;
+	}
+}
+
+/**
+ * Destructor
+ */
+XMLStreamStateHandler::~XMLStreamStateHandler()
+{}
+
+
+
+//---------------------------------------------------------------------------------------//
+// StateHandler implementations
+
+/**
+ * Initialize this StateHandler.
+ * Parses the XML data file into the state tree. If the file does not exist, or
+ * cannot be parsed, the state tree is empty.
+ */
+void
+XMLStreamStateHandler::initialize()
+{
+	load() ;
+}
+
+/**
+ * Shutdown this StateHandler.
+ * Writes any modifications to the XML data file and releases the state tree
+ */
+void
+XMLStreamStateHandler::shutdown()
+{
+	try
+	{
+		flush() ;
+	}
+	catch(Exception& e)
+	{
+		// nothing we can do at shutdown
+	}
+
+	MemoryStateHandler empty ;
+	theState.importState(empty) ;
+	theWrittenCount = theState.getModificationCount() ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// Update Control
+
+/**
+ * Force a write of state information back to the persistant store
+ * The XML data file is written only if the state tree has been modified. The file is
+ * written to a temporary file which is synchronized to disk and renamed over the data file.
+ *
+ * @throw Exception if the XML data file cannot be written
+ */
+void
+XMLStreamStateHandler::flush()
+{
+	if(isDirty())
+	{
+		unsigned long count = theState.getModificationCount() ;
+		writeState(theState, theDataFile, theRootNodeName) ;
+		theWrittenCount = count ;
+	}
+}
+
+/**
+ * Synchronize this StateHandler to the persistant store of state information,
+ * The XML data file is parsed again, discarding any unwritten modifications
+ */
+void
+XMLStreamStateHandler::sync()
+{
+	load() ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// StateNode Access
+
+/**
+ * Returns the root StateNode within the state tree of this StateHandler
+ * This method returns a user handle for the underlying data of the StateNode
+ * implementation. Subsequent calls to getRootNode need not return the same
+ * handle instance, however, it is guaranteed that each will be a handle to
+ * the same underlying data instance.
+ *
+ * @return the root StateNode within the state tree of this StateHandler
+ */
+RefCountPtr<StateNode>
+XMLStreamStateHandler::getRootNode()
+{
+	return(theState.getRootNode()) ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// Stream Handling
+
+/**
+ * Returns whether the state tree has been modified since the XML data file was last
+ * written or parsed
+ *
+ * @return true if the state tree has been modified
+ */
+bool
+XMLStreamStateHandler::isDirty() const
+{
+	return(theState.getModificationCount() != theWrittenCount) ;
+}
+
+/**
+ * Writes the state tree of the specified StateHandler to the specified file in the
+ * XMLStateHandler file format, without building a DOM document.
+ * The file is atomically replaced, being written to a uniquely named temporary file
+ * which is synchronized to disk and renamed over the specified file.
+ *
+ * @param source the initialized StateHandler to write
+ * @param filename the path of the XML data file
+ * @param rootNode the name of the root element,
+ *        if left blank, this will default to XMLStatehandler::ROOT_NODE
+ * @throw Exception if the XML data file cannot be written
+ */
+void
+XMLStreamStateHandler::writeState(StateHandler& source, const std::string& filename, const std::string& rootNode) throw(Exception)
+{
+	StateWriter writer(source, rootNode.empty() ? XMLStateHandler::ROOT_NODE : rootNode) ;
+	FilePath(filename).replaceFile(writer) ;
+}
+
+
+//---------------------------------------------------------------------------------------//
+// Stream access
+
+/**
+ * Parses the XML data file into the state tree, leaving the state tree empty if
+ * the file does not exist or cannot be parsed
+ *
+ */
+void
+XMLStreamStateHandler::load()
+{
+	MemoryStateHandler empty ;
+	theState.importState(empty) ;
+
+	if(::access(theDataFile.c_str(), F_OK) == 0)
+	{
+		StateParser parser(theState.getRootNode(), theRootNodeName) ;
+		bool valid = true ;
+
+		try
+		{
+			parser.parse_file(theDataFile) ;
+			valid = parser.isValid() ;
+		}
+		catch(std::exception& e)
+		{
+			valid = false ;
+		}
+
+		if(!valid)
+		{
+			theState.importState(empty) ;
+		}
+	}
+
+	theWrittenCount = theState.getModificationCount() ;
+}
+
+/**
+ * Writes the values and child StateNodes of the specified StateNode, recursively,
+ * to the specified stream
+ *
+ * @param out the stream to write to
+ * @param node the StateNode to write
+ * @param depth the nesting depth of the StateNode, used for indentation
+ */
+void
+XMLStreamStateHandler::writeNode(FILE* out, StateNode& node, int depth)
+{
+	std::list<std::string> names ;
+	node.getValueNames(names) ;
+
+	for(std::list<std::string>::const_iterator citer = names.begin(); citer != names.end(); ++citer)
+	{
+		indent(out, depth) ;
+		fprintf(out, "<%s %s=\"", XMLStateNode::PARAM_TAG.c_str(), XMLStateNode::NAME_ATTR.c_str()) ;
+		writeEscaped(out, *citer) ;
+		fprintf(out, "\" %s=\"", XMLStateNode::VALUE_ATTR.c_str()) ;
+		writeEscaped(out, node.getString(*citer, "")) ;
+		fputs("\"/>\n", out) ;
+	}
+
+	std::list<std::string> children ;
+	node.getChildren(children) ;
+
+	for(std::list<std::string>::const_iterator citer = children.begin(); citer != children.end(); ++citer)
+	{
+		indent(out, depth) ;
+		fprintf(out, "<%s %s=\"", XMLStateNode::CONFIG_TAG.c_str(), XMLStateNode::CONFIG_ID.c_str()) ;
+		writeEscaped(out, *citer) ;
+		fputs("\">\n", out) ;
+
+		RefCountPtr<StateNode> child = node.getChild(*citer) ;
+		writeNode(out, *child.getPtr(), depth + 1) ;
+
+		indent(out, depth) ;
+		fprintf(out, "</%s>\n", XMLStateNode::CONFIG_TAG.c_str()) ;
+	}
+}
+
+/**
+ * Writes the specified string as an XML attribute value to the specified stream,
+ * escaping markup characters
+ *
+ * @param out the stream to write to
+ * @param s the string to write
+ */
+void
+XMLStreamStateHandler::writeEscaped(FILE* out, const std::string& s)
+{
+	for(std::string::const_iterator citer = s.begin(); citer != s.end(); ++citer)
+	{
+		switch(*citer)
+		{
+			case '&':
+				fputs("&amp;", out) ;
+				break ;
+			case '<':
+				fputs("&lt;", out) ;
+				break ;
+			case '>':
+				fputs("&gt;", out) ;
+				break ;
+			case '"':
+				fputs("&quot;", out) ;
+				break ;
+			case '\n':
+				fputs("&#10;", out) ;
+				break ;
+			case '\r':
+				fputs("&#13;", out) ;
+				break ;
+			case '\t':
+				fputs("&#9;", out) ;
+				break ;
+			default:
+				fputc(*citer, out) ;
+				break ;
+		}
+	}
+}
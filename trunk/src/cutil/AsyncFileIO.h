@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_ASYNCFILEIO_H_
+#define _CUTIL_ASYNCFILEIO_H_
+
+#include <cutil/BufferPool.h>
+#include <cutil/Exception.h>
+#include <cutil/FilePath.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace cutil
+{
+	/**
+	 * Asynchronous file I/O engine for bulk reads and writes.
+	 * Read and write requests, each a FilePath, offset and length, are submitted without waiting for
+	 * the I/O to complete, and complete in any order. A single thread may therefore keep many
+	 * requests in flight, allowing the storage device to service them concurrently.
+	 *
+	 * Where the kernel supports it, requests are issued through io_uring, otherwise each request is
+	 * performed by a pool of worker threads. The number of requests in flight is bounded, a submission
+	 * when the bound is reached waits for an earlier request to complete, the completion being queued
+	 * for the next reap. With io_uring, requests are submitted to the kernel in batches, on flush,
+	 * on reap, or when the bound is reached, rather than one system call per request.
+	 *
+	 * Read data is returned in buffers taken from an internal BufferPool, which must be returned
+	 * via releaseBuffer once processed. Write data is copied into a pooled buffer on submission.
+	 *
+	 * An AsyncFileIO is intended to be driven by a single thread, submit and reap must not be
+	 * called concurrently. releaseBuffer may be called from any thread.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class AsyncFileIO
+	{
+		public:
+
+			/** the mechanism used to perform the I/O */
+			enum BackendEnum
+			{
+				/** io_uring if available, otherwise a thread pool */
+				BACKEND_AUTO_ENUM,
+				/** io_uring, failing if unavailable */
+				BACKEND_URING_ENUM,
+				/** a pool of worker threads performing blocking I/O */
+				BACKEND_THREAD_POOL_ENUM
+			} ;
+
+			/** request operation types */
+			enum OperationEnum { READ_ENUM, WRITE_ENUM } ;
+
+			/**
+			 * The result of a completed request
+			 */
+			struct Completion
+			{
+				/** the request operation */
+				OperationEnum theOperation ;
+
+				/** the file path of the request */
+				std::string thePath ;
+
+				/** the file offset of the request */
+				off_t theOffset ;
+
+				/** the requested length */
+				size_t theLength ;
+
+				/** read data, to be returned via releaseBuffer, NULL for a write */
+				char* theBuffer ;
+
+				/** bytes transferred, or -1 on error */
+				ssize_t theResult ;
+
+				/** the error code if theResult is -1 */
+				int theError ;
+
+				/** the user data specified on submission */
+				void* theUserData ;
+			} ;
+
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates a new AsyncFileIO
+			 *
+			 * @param max_in_flight the maximum number of requests in flight
+			 * @param buffer_size the size of each pooled buffer, requests larger than this use a dedicated buffer
+			 * @param backend the mechanism used to perform the I/O
+			 * @throw Exception if the requested backend cannot be initialised
+			 */
+			AsyncFileIO(size_t max_in_flight = 32, size_t buffer_size = 65536, BackendEnum backend = BACKEND_AUTO_ENUM) throw(Exception) ;
+
+			/**
+			 * Destructor.
+			 * Waits for all requests in flight to complete, completions not reaped are discarded
+			 *
+			 */
+			virtual ~AsyncFileIO() ;
+
+			//-------------------------------------------------------------------------------//
+			// AsyncFileIO Operations
+
+			/**
+			 * Submits a request to read length bytes from the specified file at offset.
+			 * A file which cannot be opened results in a failed Completion rather than an Exception.
+			 *
+			 * @param path the file to read
+			 * @param offset the file offset to read from
+			 * @param length the number of bytes to read
+			 * @param user_data caller data returned in the Completion
+			 * @throw Exception if the request cannot be submitted
+			 */
+			void submitRead(const FilePath& path, off_t offset, size_t length, void* user_data = 0) throw(Exception) ;
+
+			/**
+			 * Submits a request to write length bytes of data to the specified file at offset.
+			 * The file is created if it does not exist. The data is copied, and may be reused once this
+			 * method returns. A file which cannot be opened results in a failed Completion rather than an Exception.
+			 *
+			 * @param path the file to write
+			 * @param offset the file offset to write at
+			 * @param data the data to write
+			 * @param length the number of bytes to write
+			 * @param user_data caller data returned in the Completion
+			 * @throw Exception if the request cannot be submitted
+			 */
+			void submitWrite(const FilePath& path, off_t offset, const void* data, size_t length, void* user_data = 0) throw(Exception) ;
+
+			/**
+			 * Starts all submitted requests not yet started.
+			 * With io_uring, submitted requests are queued, and passed to the kernel together by a single
+			 * system call when flush or reap is called, or the bound on requests in flight is reached.
+			 * flush need only be called to start queued requests before the next reap.
+			 *
+			 * @throw Exception if the requests cannot be started
+			 */
+			void flush() throw(Exception) ;
+
+			/**
+			 * Collects completed requests, appending them to completions.
+			 * Submitted requests not yet started are started first.
+			 * Waits until at least min_completions requests have completed, or usec micro seconds have
+			 * elapsed. min_completions is limited to the number of outstanding requests.
+			 *
+			 * @param completions vector to append completed requests to
+			 * @param min_completions the minimum number of completions to wait for
+			 * @param usec the maximum time to wait in micro seconds, a negative value waits indefinitely
+			 * @return the number of completions appended
+			 * @throw Exception if an error occurs waiting for completions
+			 */
+			size_t reap(std::vector<Completion>& completions, size_t min_completions = 1, long usec = -1) throw(Exception) ;
+
+			/**
+			 * Returns a read buffer from a Completion to the buffer pool
+			 *
+			 * @param buffer the buffer to return
+			 */
+			void releaseBuffer(char* buffer) ;
+
+			//-------------------------------------------------------------------------------//
+			// General Accessors/Murators
+
+			/**
+			 * Returns the mechanism in use to perform the I/O, never BACKEND_AUTO_ENUM
+			 *
+			 * @return the backend in use
+			 */
+			BackendEnum getBackend() const ;
+
+			/**
+			 * Returns the number of submitted requests which have not yet been reaped
+			 *
+			 * @return the number of outstanding requests
+			 */
+			size_t getOutstanding() const ;
+
+			/**
+			 * Returns the maximum number of requests in flight
+			 *
+			 * @return the maximum number of requests in flight
+			 */
+			size_t getMaxInFlight() const ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+			class Engine ;
+			class ThreadPoolEngine ;
+			class UringEngine ;
+			struct Operation ;
+
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			AsyncFileIO(const AsyncFileIO&) : theBufferPool(0) {}
+
+			/**
+			 * Opens the file of the specified operation and submits it, waiting for an in flight request
+			 * to complete if the bound is reached
+			 *
+			 * @param op the operation to submit
+			 * @param flags the open flags of the file
+			 * @throw Exception if the operation cannot be submitted
+			 */
+			void submit(Operation* op, int flags) throw(Exception) ;
+
+			/**
+			 * Waits for in flight requests to complete, queuing them for reaping
+			 *
+			 * @param min_completions the minimum number of requests to wait for
+			 * @param usec the maximum time to wait in micro seconds, a negative value waits indefinitely
+			 * @throw Exception if an error occurs waiting for completions
+			 */
+			void collect(size_t min_completions, long usec) throw(Exception) ;
+
+			/** the I/O mechanism */
+			Engine* theEngine ;
+
+			/** the backend in use */
+			BackendEnum theBackend ;
+
+			/** pool of read and write buffers */
+			BufferPool theBufferPool ;
+
+			/** maximum number of requests in flight */
+			size_t theMaxInFlight ;
+
+			/** number of requests in flight */
+			size_t theInFlight ;
+
+			/** completed operations awaiting reaping */
+			std::deque<Operation*> theCompleted ;
+
+	} ; /* class AsyncFileIO */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_ASYNCFILEIO_H_ */
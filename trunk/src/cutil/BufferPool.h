@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_BUFFERPOOL_H_
+#define _CUTIL_BUFFERPOOL_H_
+
+#include <cutil/Exception.h>
+#include <cutil/Mutex.h>
+
+#include <set>
+#include <vector>
+
+namespace cutil
+{
+	/**
+	 * A pool of reusable, aligned, fixed size buffers.
+	 * Buffers are recycled rather than returned to the heap, avoiding repeated allocation of large
+	 * I/O buffers. Buffers are aligned such that they may be used for direct I/O. A request larger
+	 * than the pool buffer size is satisfied by a dedicated allocation, freed upon release.
+	 * A BufferPool may be shared between threads.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class BufferPool
+	{
+		public:
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates a new empty BufferPool
+			 *
+			 * @param buffer_size the size of each pooled buffer
+			 * @param alignment the alignment of each buffer, a power of two
+			 * @param max_free the maximum number of free buffers retained, 0 for no limit
+			 */
+			BufferPool(size_t buffer_size, size_t alignment = 4096, size_t max_free = 0) ;
+
+			/**
+			 * Destructor.
+			 * Frees all free buffers, buffers still acquired must not be used after the BufferPool is destroyed
+			 *
+			 */
+			virtual ~BufferPool() ;
+
+			//-------------------------------------------------------------------------------//
+			// BufferPool Operations
+
+			/**
+			 * Acquires a buffer of at least length bytes
+			 *
+			 * @param length the minimum required buffer length
+			 * @return the acquired buffer
+			 * @throw Exception if a buffer cannot be allocated
+			 */
+			char* acquire(size_t length) throw(Exception) ;
+
+			/**
+			 * Returns a buffer previously acquired from this BufferPool
+			 *
+			 * @param buffer the buffer to return
+			 */
+			void release(char* buffer) ;
+
+			/**
+			 * Returns the size of each pooled buffer
+			 *
+			 * @return the size of each pooled buffer
+			 */
+			size_t getBufferSize() const ;
+
+			/**
+			 * Returns the number of free buffers currently retained by this BufferPool
+			 *
+			 * @return the number of free buffers
+			 */
+			size_t getFreeCount() const ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			BufferPool(const BufferPool&) {}
+
+			/**
+			 * Allocates a new aligned buffer
+			 *
+			 * @param length the buffer length
+			 * @return the allocated buffer
+			 * @throw Exception if the buffer cannot be allocated
+			 */
+			char* allocate(size_t length) throw(Exception) ;
+
+			/** size of each pooled buffer */
+			size_t theBufferSize ;
+
+			/** alignment of each buffer */
+			size_t theAlignment ;
+
+			/** maximum number of free buffers retained */
+			size_t theMaxFree ;
+
+			/** free pooled buffers */
+			std::vector<char*> theFreeBuffers ;
+
+			/** acquired buffers larger than the pool buffer size */
+			std::set<char*> theOversizeBuffers ;
+
+			/** protects the free list */
+			mutable Mutex theMutex ;
+
+	} ; /* class BufferPool */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_BUFFERPOOL_H_ */
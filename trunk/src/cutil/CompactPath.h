@@ -0,0 +1,412 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_COMPACTPATH_H_
+#define _CUTIL_COMPACTPATH_H_
+
+#include <cutil/FilePath.h>
+
+#include <string>
+
+namespace cutil
+{
+	/**
+	 * CompactPath is an allocation light representation of a filesystem path, intended for code
+	 * creating large numbers of paths, such as directory scans.
+	 * The path is held within a single buffer, stored inline for paths up to INLINE_CAPACITY bytes,
+	 * and components are accessed as Component views into that buffer rather than as new strings.
+	 *
+	 * A path may be interned, after which its buffer is shared, reference counted and immutable.
+	 * Copies of an interned path, and paths created as children of it, share the interned prefix
+	 * and store only their own trailing components, so the children of a directory need hold only
+	 * their leaf names. The parent of such a child is obtained without copying.
+	 *
+	 * Paths are cleaned as FilePath cleans them, leading and trailing whitespace, trailing separators
+	 * and repeated separators are removed, with the exception that the root path is held as "/".
+	 * Interned prefixes may be shared between threads, a CompactPath itself must not be modified
+	 * concurrently.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class CompactPath
+	{
+		public:
+
+			/** the number of bytes of path held without a heap allocation */
+			static const size_t INLINE_CAPACITY = 48 ;
+
+			/**
+			 * A view of a path component, valid while the CompactPath it was obtained from is unmodified
+			 */
+			struct Component
+			{
+				/** the first byte of the component, not null terminated */
+				const char* theData ;
+
+				/** the length of the component in bytes */
+				size_t theLength ;
+
+				/**
+				 * Returns whether the component is equal to the specified string
+				 *
+				 * @param str the string to compare to
+				 * @return true if the component and str are equal
+				 */
+				bool equals(const char* str) const ;
+
+				/**
+				 * Returns a copy of the component as a string
+				 *
+				 * @return the component as a string
+				 */
+				std::string toString() const ;
+			} ;
+
+			/**
+			 * Iterates over the components of a CompactPath without allocation.
+			 * The root of an absolute path is not reported as a component.
+			 */
+			class ComponentIterator
+			{
+				public:
+
+					/**
+					 * Creates a new ComponentIterator over the components of the specified path.
+					 * The path must remain unmodified for the lifetime of the iterator.
+					 *
+					 * @param path the path to iterate over
+					 */
+					ComponentIterator(const CompactPath& path) ;
+
+					/**
+					 * Returns whether a further component is available
+					 *
+					 * @return true if next will return a component
+					 */
+					bool hasNext() const ;
+
+					/**
+					 * Returns the next component
+					 *
+					 * @return the next component, an empty component if !hasNext()
+					 */
+					Component next() ;
+
+				private:
+
+					/**
+					 * Skips separators, advancing to the next segment as required
+					 */
+					void skipSeparators() ;
+
+					/** the prefix and suffix segments of the path */
+					const char* theSegments[2] ;
+					const char* theSegmentEnds[2] ;
+
+					/** the current segment */
+					size_t theSegment ;
+
+					/** the current position within the current segment */
+					const char* thePosition ;
+			} ;
+
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates a new empty CompactPath
+			 *
+			 */
+			CompactPath() ;
+
+			/**
+			 * Creates a new CompactPath from the specified path
+			 *
+			 * @param path the path
+			 */
+			CompactPath(const char* path) ;
+
+			/**
+			 * Creates a new CompactPath from the specified path
+			 *
+			 * @param path the path
+			 */
+			CompactPath(const std::string& path) ;
+
+			/**
+			 * Creates a new CompactPath from the specified FilePath
+			 *
+			 * @param path the FilePath
+			 */
+			CompactPath(const FilePath& path) ;
+
+			/**
+			 * Creates a new CompactPath from the specified parent path and child path.
+			 * If parent is interned, the new path shares its buffer and holds only child.
+			 *
+			 * @param parent the parent directory path
+			 * @param child the child path, relative to parent
+			 */
+			CompactPath(const CompactPath& parent, const char* child) ;
+
+			/**
+			 * Creates a new CompactPath from the specified parent path and child component.
+			 * If parent is interned, the new path shares its buffer and holds only child.
+			 *
+			 * @param parent the parent directory path
+			 * @param child the child component
+			 */
+			CompactPath(const CompactPath& parent, const Component& child) ;
+
+			/**
+			 * Copy constructor.
+			 * An interned buffer is shared rather than copied.
+			 *
+			 * @param path the CompactPath to copy
+			 */
+			CompactPath(const CompactPath& path) ;
+
+			/**
+			 * Destructor.
+			 *
+			 */
+			~CompactPath() ;
+
+			/**
+			 * Assignment operator.
+			 * An interned buffer is shared rather than copied.
+			 *
+			 * @param path the CompactPath to assign from
+			 * @return this CompactPath
+			 */
+			CompactPath& operator=(const CompactPath& path) ;
+
+			//-------------------------------------------------------------------------------//
+			// Path Operations
+
+			/**
+			 * Appends the specified path to this CompactPath
+			 *
+			 * @param path the path to append
+			 */
+			void append(const char* path) ;
+
+			/**
+			 * Appends the specified path to this CompactPath
+			 *
+			 * @param path the path to append
+			 * @param length the length of path in bytes
+			 */
+			void append(const char* path, size_t length) ;
+
+			/**
+			 * Interns this CompactPath, moving the whole path into a shared, reference counted, buffer.
+			 * Subsequent copies of this path, and paths created with this path as their parent, share
+			 * the buffer rather than copying it.
+			 *
+			 */
+			void intern() ;
+
+			/**
+			 * Returns whether this CompactPath holds an interned prefix
+			 *
+			 * @return true if this path shares an interned prefix
+			 */
+			bool isInterned() const ;
+
+			//-------------------------------------------------------------------------------//
+			// Path Accessors
+
+			/**
+			 * Returns whether this CompactPath is empty
+			 *
+			 * @return true if this path is empty
+			 */
+			bool isEmpty() const ;
+
+			/**
+			 * Returns whether this CompactPath is an absolute path
+			 *
+			 * @return true if this path begins with a path separator
+			 */
+			bool isAbsolute() const ;
+
+			/**
+			 * Returns the length of this path in bytes
+			 *
+			 * @return the length of this path
+			 */
+			size_t getLength() const ;
+
+			/**
+			 * Returns the number of components of this path
+			 *
+			 * @return the number of components
+			 */
+			size_t getComponentCount() const ;
+
+			/**
+			 * Returns the leaf, file or directory name, of this path without allocation
+			 *
+			 * @return the last component of this path, empty if there is none
+			 */
+			Component getLeaf() const ;
+
+			/**
+			 * Returns the parent of this path.
+			 * The parent of a child of an interned path shares the interned buffer.
+			 *
+			 * @return the parent of this path, empty if this path has a single relative component
+			 */
+			CompactPath getParent() const ;
+
+			/**
+			 * Returns this path as a string
+			 *
+			 * @return this path as a string
+			 */
+			std::string getPath() const ;
+
+			/**
+			 * Appends this path to the specified string
+			 *
+			 * @param str the string to append to
+			 */
+			void appendTo(std::string& str) const ;
+
+			/**
+			 * Copies this path, null terminated, into the specified buffer.
+			 * Nothing is copied if the buffer is too small.
+			 *
+			 * @param buffer the buffer to copy to
+			 * @param size the size of buffer in bytes
+			 * @return the length of this path, the path has been copied if less than size
+			 */
+			size_t copyTo(char* buffer, size_t size) const ;
+
+			/**
+			 * Returns this path as a FilePath
+			 *
+			 * @return this path as a FilePath
+			 */
+			FilePath toFilePath() const ;
+
+			/**
+			 * Returns a hash of this path, equal paths have equal hashes
+			 *
+			 * @return a hash of this path
+			 */
+			size_t hash() const ;
+
+			/**
+			 * Compares this path to the specified path bytewise
+			 *
+			 * @param path the path to compare to
+			 * @return less than, equal to, or greater than zero as this path orders before, equal to, or after path
+			 */
+			int compare(const CompactPath& path) const ;
+
+			/**
+			 * Returns whether this path is equal to the specified path
+			 *
+			 * @param path the path to compare to
+			 * @return true if the paths are equal
+			 */
+			bool operator==(const CompactPath& path) const ;
+
+			/**
+			 * Returns whether this path is not equal to the specified path
+			 *
+			 * @param path the path to compare to
+			 * @return true if the paths are not equal
+			 */
+			bool operator!=(const CompactPath& path) const ;
+
+			/**
+			 * Returns whether this path orders before the specified path
+			 *
+			 * @param path the path to compare to
+			 * @return true if this path orders before path
+			 */
+			bool operator<(const CompactPath& path) const ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+
+			/** Interned, reference counted, path buffer */
+			struct Prefix ;
+
+			/**
+			 * Returns whether a separator is required between the prefix and suffix
+			 *
+			 * @return true if the prefix and suffix are joined with a separator
+			 */
+			bool needsJoin() const ;
+
+			/**
+			 * Ensures the suffix buffer can hold length bytes plus a terminator
+			 *
+			 * @param length the required suffix length
+			 */
+			void reserve(size_t length) ;
+
+			/**
+			 * Replaces the suffix with the specified bytes
+			 *
+			 * @param data the new suffix
+			 * @param length the length of data
+			 */
+			void assignSuffix(const char* data, size_t length) ;
+
+			/**
+			 * Releases the interned prefix and any heap buffer
+			 */
+			void release() ;
+
+			/** the shared prefix, NULL if none */
+			Prefix* thePrefix ;
+
+			/** the suffix buffer, theInline or a heap allocation */
+			char* theData ;
+
+			/** the length of the suffix */
+			size_t theLength ;
+
+			/** the capacity of the suffix buffer */
+			size_t theCapacity ;
+
+			/** inline suffix storage */
+			char theInline[INLINE_CAPACITY] ;
+
+	} ; /* class CompactPath */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_COMPACTPATH_H_ */
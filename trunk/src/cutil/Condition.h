@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_CONDITION_H_
+#define _CUTIL_CONDITION_H_
+
+#include <cutil/Exception.h>
+
+#include <pthread.h>
+
+namespace cutil
+{
+	class Mutex ;
+
+	/**
+	 * A condition variable, a simple wrapper around a pthread condition.
+	 * Timed waits are measured against the monotonic clock and are unaffected by changes to the system time.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class Condition
+	{
+		public:
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates a new Condition
+			 *
+			 * @throw Exception if the condition cannot be initialised
+			 */
+			Condition() throw(Exception) ;
+
+			/**
+			 * Destructor.
+			 * No thread may be waiting upon the Condition when it is destroyed
+			 *
+			 */
+			virtual ~Condition() ;
+
+			//-------------------------------------------------------------------------------//
+			// Condition Operations
+
+			/**
+			 * Atomically releases the specified locked Mutex and waits for this Condition to be signalled.
+			 * The Mutex is locked again before returning. As spurious wake ups may occur, the caller
+			 * should recheck its predicate upon return.
+			 *
+			 * @param mutex the Mutex held by the calling thread
+			 */
+			void wait(Mutex& mutex) ;
+
+			/**
+			 * Atomically releases the specified locked Mutex and waits at most usec micro seconds
+			 * for this Condition to be signalled. The Mutex is locked again before returning.
+			 *
+			 * @param mutex the Mutex held by the calling thread
+			 * @param usec the maximum time to wait in micro seconds
+			 * @return false if the wait timed out, true otherwise
+			 */
+			bool timedWait(Mutex& mutex, long usec) ;
+
+			/**
+			 * Wakes at least one thread waiting upon this Condition
+			 *
+			 */
+			void signal() ;
+
+			/**
+			 * Wakes all threads waiting upon this Condition
+			 *
+			 */
+			void broadcast() ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			Condition(const Condition&) {}
+
+			/** the underlying pthread condition */
+			pthread_cond_t theCondition ;
+
+	} ; /* class Condition */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_CONDITION_H_ */
@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_DIRECTORYWALKER_H_
+#define _CUTIL_DIRECTORYWALKER_H_
+
+#include <cutil/Exception.h>
+#include <cutil/FilePath.h>
+
+#include <string>
+
+namespace cutil
+{
+	class ThreadPool ;
+
+	/**
+	 * Streaming recursive directory traversal.
+	 * DirectoryWalker reads directory entries directly via getdents64, taking the type of each
+	 * entry from the directory itself rather than a stat of each path, and passes each entry to a
+	 * Visitor as it is read. No container of paths is built, the path of each entry is held in a
+	 * single buffer which is extended and truncated as the traversal descends and returns, so no
+	 * heap allocation is made per entry.
+	 *
+	 * The Visitor decides, for each directory, whether to descend into it or prune it, and may stop
+	 * the traversal at any time. Subdirectories near the root may be fanned out across a ThreadPool.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class DirectoryWalker
+	{
+		public:
+
+			/** the action to take following a visit */
+			enum VisitResultEnum
+			{
+				/** continue, descending into the entry if it is a directory */
+				CONTINUE_ENUM,
+				/** continue, without descending into the entry */
+				PRUNE_ENUM,
+				/** stop the traversal */
+				STOP_ENUM
+			} ;
+
+			/**
+			 * A directory entry passed to a Visitor.
+			 * The strings referenced are only valid for the duration of the visit.
+			 */
+			struct Entry
+			{
+				/** the path of the entry, the root path followed by each component */
+				const char* thePath ;
+
+				/** the length of thePath */
+				size_t thePathLength ;
+
+				/** the name of the entry, the last component of thePath */
+				const char* theName ;
+
+				/** the type of the entry, the type of a symbolic link target when following links */
+				FilePath::FileType theType ;
+
+				/** the depth of the entry, 0 for entries of the root directory */
+				size_t theDepth ;
+
+				/** descriptor of the directory containing the entry, for use with the *at system calls, -1 if unavailable */
+				int theDirFd ;
+			} ;
+
+			/**
+			 * Receives the entries of a traversal.
+			 * When a traversal is fanned out across a ThreadPool, the Visitor is called concurrently
+			 * from several threads and must be thread safe.
+			 */
+			class Visitor
+			{
+				public:
+					virtual ~Visitor() {}
+
+					/**
+					 * Visits a directory entry
+					 *
+					 * @param entry the entry being visited
+					 * @return the action to take
+					 */
+					virtual VisitResultEnum visit(const Entry& entry) = 0 ;
+
+					/**
+					 * Called once all entries of a directory which was descended into have been visited,
+					 * or the traversal was stopped within it. Every directory descended into is left,
+					 * whether the traversal is serial or parallel. During a parallel traversal
+					 * subdirectories handed to other threads may still be in progress.
+					 *
+					 * @param entry the directory being left
+					 */
+					virtual void leave(const Entry&) {}
+			} ;
+
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates a new DirectoryWalker with default options.
+			 * By default, hidden entries are visited, symbolic links are not followed, the depth is
+			 * unlimited, and filesystem boundaries are crossed.
+			 *
+			 */
+			DirectoryWalker() ;
+
+			/**
+			 * Destructor.
+			 *
+			 */
+			virtual ~DirectoryWalker() ;
+
+			//-------------------------------------------------------------------------------//
+			// DirectoryWalker Operations
+
+			/**
+			 * Walks the directory tree below root, passing each entry to visitor.
+			 * Entries are visited in directory order, depth first, within the calling thread.
+			 * The root itself is not visited.
+			 *
+			 * @param root the directory to walk
+			 * @param visitor receives each entry
+			 * @return false if the visitor stopped the traversal, true otherwise
+			 * @throw Exception if root cannot be read, or a system error occurs
+			 */
+			bool walk(const FilePath& root, Visitor& visitor) const throw(Exception) ;
+
+			/**
+			 * Walks the directory tree below root, fanning subdirectories out across pool.
+			 * Each subdirectory at a depth less than the parallel depth is walked as a separate task,
+			 * deeper subdirectories are walked within the task of their ancestor. The visitor is called
+			 * concurrently and must be thread safe. This method returns once the whole tree has been walked.
+			 *
+			 * @param root the directory to walk
+			 * @param visitor receives each entry
+			 * @param pool the ThreadPool to walk subdirectories upon, must not be the pool executing the caller
+			 * @return false if the visitor stopped the traversal, true otherwise
+			 * @throw Exception if root cannot be read, or a system error occurs
+			 */
+			bool walk(const FilePath& root, Visitor& visitor, ThreadPool& pool) const throw(Exception) ;
+
+			//-------------------------------------------------------------------------------//
+			// Options
+
+			/**
+			 * Sets the maximum depth of the traversal, entries deeper than depth are not visited.
+			 * A depth of 0 visits only the entries of the root directory.
+			 *
+			 * @param depth the maximum depth
+			 */
+			void setMaxDepth(size_t depth) ;
+
+			/**
+			 * Returns the maximum depth of the traversal
+			 *
+			 * @return the maximum depth of the traversal
+			 */
+			size_t getMaxDepth() const ;
+
+			/**
+			 * Sets whether hidden entries, those beginning with a dot, are visited.
+			 * Hidden directories which are not visited are not descended into.
+			 *
+			 * @param include set true to visit hidden entries
+			 */
+			void setIncludeHidden(bool include) ;
+
+			/**
+			 * Returns whether hidden entries are visited
+			 *
+			 * @return true if hidden entries are visited
+			 */
+			bool getIncludeHidden() const ;
+
+			/**
+			 * Sets whether symbolic links are followed.
+			 * When followed, an entry reports the type of its target, and links to directories are
+			 * descended into. Directories already upon the current path are not entered again.
+			 *
+			 * @param follow set true to follow symbolic links
+			 */
+			void setFollowSymLinks(bool follow) ;
+
+			/**
+			 * Returns whether symbolic links are followed
+			 *
+			 * @return true if symbolic links are followed
+			 */
+			bool getFollowSymLinks() const ;
+
+			/**
+			 * Sets whether the traversal descends into directories upon a different filesystem to root
+			 *
+			 * @param same set true to remain upon the filesystem of root
+			 */
+			void setSameFileSystem(bool same) ;
+
+			/**
+			 * Returns whether the traversal remains upon the filesystem of root
+			 *
+			 * @return true if the traversal remains upon the filesystem of root
+			 */
+			bool getSameFileSystem() const ;
+
+			/**
+			 * Sets the depth below which subdirectories are no longer fanned out during a parallel walk
+			 *
+			 * @param depth the parallel depth, 1 fans out only the subdirectories of root, 0 walks within the calling thread
+			 */
+			void setParallelDepth(size_t depth) ;
+
+			/**
+			 * Returns the depth below which subdirectories are no longer fanned out during a parallel walk
+			 *
+			 * @return the parallel depth
+			 */
+			size_t getParallelDepth() const ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+			class Walk ;
+			class ParallelWalk ;
+
+			/** maximum depth of the traversal */
+			size_t theMaxDepth ;
+
+			/** whether hidden entries are visited */
+			bool theIncludeHiddenFlag ;
+
+			/** whether symbolic links are followed */
+			bool theFollowSymLinksFlag ;
+
+			/** whether the traversal remains upon the root filesystem */
+			bool theSameFileSystemFlag ;
+
+			/** depth below which subdirectories are not fanned out */
+			size_t theParallelDepth ;
+
+	} ; /* class DirectoryWalker */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_DIRECTORYWALKER_H_ */
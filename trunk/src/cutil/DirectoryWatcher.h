@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_DIRECTORYWATCHER_H_
+#define _CUTIL_DIRECTORYWATCHER_H_
+
+#include <cutil/Exception.h>
+#include <cutil/FilePath.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cutil
+{
+	/**
+	 * DirectoryWatcher reports changes to the contents of watched directories as they occur,
+	 * avoiding repeated rescans of directories with FilePath::getFiles.
+	 *
+	 * Changes are obtained from inotify. Directories may be watched recursively, in which case
+	 * subdirectories created, or moved, beneath the watched directory are watched as they appear,
+	 * with the entries they already contain reported as created.
+	 *
+	 * The watcher exposes a file descriptor, which becomes readable when events are pending, so
+	 * it may be integrated with a poll, select or epoll readiness loop. readEvents then coalesces
+	 * the pending events, all changes to a path within a batch being reported as a single Event.
+	 * An optional coalesce interval extends a batch to absorb bursts of changes.
+	 *
+	 * If the kernel event queue overflows, an OVERFLOW_ENUM event is reported, and the watched
+	 * directories should be rescanned.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class DirectoryWatcher
+	{
+		public:
+
+			/**
+			 * Changes which may be watched for, and reported, or'ed together
+			 */
+			enum EventTypeEnum
+			{
+				/** an entry was created */
+				CREATED_ENUM = 0x01,
+				/** an entry was modified */
+				MODIFIED_ENUM = 0x02,
+				/** an entry opened for writing was closed */
+				WRITTEN_ENUM = 0x04,
+				/** an entry was deleted */
+				DELETED_ENUM = 0x08,
+				/** an entry was moved out of, or renamed within, a watched directory */
+				MOVED_FROM_ENUM = 0x10,
+				/** an entry was moved into, or renamed within, a watched directory */
+				MOVED_TO_ENUM = 0x20,
+				/** all changes */
+				ALL_EVENTS_ENUM = 0x3f,
+				/** events were lost, watched directories should be rescanned, reported only */
+				OVERFLOW_ENUM = 0x40
+			} ;
+
+			/**
+			 * A change, or coalesced changes, to a path
+			 */
+			struct Event
+			{
+				/** the path of the changed entry, empty for OVERFLOW_ENUM */
+				std::string thePath ;
+
+				/** the or'ed EventTypeEnum changes to the path */
+				int theEvents ;
+
+				/** true if the entry is a directory */
+				bool theIsDirectory ;
+
+				/** cookie relating MOVED_FROM_ENUM and MOVED_TO_ENUM events of the same rename */
+				unsigned int theCookie ;
+			} ;
+
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates a new DirectoryWatcher, watching no directories
+			 *
+			 * @throw Exception if a system error occurs
+			 */
+			DirectoryWatcher() throw(Exception) ;
+
+			/**
+			 * Destructor.
+			 *
+			 */
+			virtual ~DirectoryWatcher() ;
+
+			//-------------------------------------------------------------------------------//
+			// DirectoryWatcher Operations
+
+			/**
+			 * Watches the specified directory for the specified changes to its entries.
+			 * Watching a directory already watched replaces its watched changes.
+			 *
+			 * @param dir the directory to watch
+			 * @param recursive set true to watch all subdirectories, including those created later
+			 * @param events or'ed EventTypeEnum changes to watch for
+			 * @throw Exception if dir is not a directory, or a system error occurs
+			 */
+			void watch(const FilePath& dir, bool recursive = false, int events = ALL_EVENTS_ENUM) throw(Exception) ;
+
+			/**
+			 * Stops watching the specified directory, and, if it was watched recursively, its subdirectories
+			 *
+			 * @param dir the directory to stop watching
+			 * @return true if dir was watched, false otherwise
+			 */
+			bool unwatch(const FilePath& dir) ;
+
+			/**
+			 * Reads pending events, appending them, coalesced, to events.
+			 * If no events are pending, waits up to usec microseconds for an event to occur.
+			 * Once an event has been read, further events are collected for the coalesce interval.
+			 *
+			 * @param events the vector to append events to
+			 * @param usec the maximum time to wait for an event, 0 to not wait, negative to wait indefinitely
+			 * @return the number of events appended
+			 * @throw Exception if a system error occurs
+			 */
+			size_t readEvents(std::vector<Event>& events, long usec = 0) throw(Exception) ;
+
+			/**
+			 * Returns the file descriptor which becomes readable when events are pending.
+			 * The descriptor is non-blocking, and must only be read through readEvents.
+			 *
+			 * @return the file descriptor of this watcher
+			 */
+			int getFileDescriptor() const ;
+
+			/**
+			 * Sets the interval, after the first event of a batch, over which further events are
+			 * collected and coalesced by readEvents
+			 *
+			 * @param usec the coalesce interval in microseconds, 0 to return as soon as pending events are read
+			 */
+			void setCoalesceInterval(long usec) ;
+
+			/**
+			 * Returns the interval over which further events are collected and coalesced by readEvents
+			 *
+			 * @return the coalesce interval in microseconds
+			 */
+			long getCoalesceInterval() const ;
+
+			/**
+			 * Returns the number of directories watched, including recursively watched subdirectories
+			 *
+			 * @return the number of watched directories
+			 */
+			size_t getWatchCount() const ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+
+			/**
+			 * A watched directory
+			 */
+			struct Watch
+			{
+				/** the path of the directory */
+				std::string thePath ;
+
+				/** the or'ed EventTypeEnum changes watched for */
+				int theEvents ;
+
+				/** true if subdirectories are watched */
+				bool theRecursive ;
+			} ;
+
+			/** Collects the coalesced events of a batch */
+			class Batch ;
+
+			/**
+			 * Adds, or updates, a watch on a single directory
+			 *
+			 * @param path the directory to watch
+			 * @param events or'ed EventTypeEnum changes to watch for
+			 * @param recursive true if subdirectories are watched
+			 * @return false if the directory no longer exists, or is not a directory, with errno set to ENOENT or ENOTDIR
+			 * @throw Exception if a system error occurs
+			 */
+			bool addWatch(const std::string& path, int events, bool recursive) throw(Exception) ;
+
+			/**
+			 * Watches the subdirectories of a recursively watched directory
+			 *
+			 * @param path the directory whose subdirectories to watch
+			 * @param events or'ed EventTypeEnum changes to watch for
+			 * @param batch if not NULL, receives a created event for each existing entry
+			 * @throw Exception if a system error occurs
+			 */
+			void addSubdirectoryWatches(const std::string& path, int events, Batch* batch) throw(Exception) ;
+
+			/**
+			 * Removes the record of a watch, the watch having been removed by the kernel or by inotify_rm_watch
+			 *
+			 * @param wd the watch descriptor
+			 */
+			void forgetWatch(int wd) ;
+
+			/**
+			 * Reads and processes all events currently available
+			 *
+			 * @param batch receives the events read
+			 * @throw Exception if a system error occurs
+			 */
+			void drain(Batch& batch) throw(Exception) ;
+
+			/**
+			 * Waits for the inotify descriptor to become readable
+			 *
+			 * @param usec the maximum time to wait, negative to wait indefinitely
+			 * @return true if the descriptor is readable
+			 * @throw Exception if a system error occurs
+			 */
+			bool waitReadable(long usec) throw(Exception) ;
+
+			DirectoryWatcher(const DirectoryWatcher&) ;
+			DirectoryWatcher& operator=(const DirectoryWatcher&) ;
+
+			/** the inotify descriptor */
+			int theFd ;
+
+			/** watched directories by watch descriptor */
+			std::map<int, Watch> theWatches ;
+
+			/** watch descriptors by directory path */
+			std::map<std::string, int> thePaths ;
+
+			/** interval over which events are coalesced */
+			long theCoalesceInterval ;
+
+			/** buffer events are read into */
+			std::vector<char> theBuffer ;
+
+	} ; /* class DirectoryWatcher */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_DIRECTORYWATCHER_H_ */
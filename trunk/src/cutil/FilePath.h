@@ -25,11 +25,16 @@
 
 #include <cutil/Exception.h>
 
+#include <cstdio>
 #include <list>
 #include <string>
 
+#include <sys/types.h>
+
 namespace cutil
 {
+	class FileStatus ;
+
 	/**
 	 * Representation of a file or directory path.
 	 *
@@ -39,6 +44,23 @@ namespace cutil
 	class FilePath
 	{
 		public:
+			/**
+			 * Writes the content of a file being replaced by replaceFile.
+			 * Write errors are detected from the stream once the content has been written.
+			 */
+			class ContentWriter
+			{
+				public:
+					virtual ~ContentWriter() {}
+
+					/**
+					 * Writes the content of the file
+					 *
+					 * @param out the stream of the temporary file to write to
+					 */
+					virtual void write(FILE* out) = 0 ;
+			} ;
+
 			//-------------------------------------------------------------------------------//
 			// Constructor / Desctructor
 
@@ -128,6 +150,32 @@ namespace cutil
 			 */
 			void rename(const std::string& newFile) throw(Exception) ;
 
+			/**
+			 * Atomically replaces the file represented by this FilePath object with the specified content.
+			 * The content is written to a uniquely named temporary file beside the file, which is
+			 * synchronized to disk and renamed over the file, and the directory is then synchronized
+			 * so the rename itself is durable. The file is never left partially written, and no
+			 * temporary file remains if the replacement fails.
+			 * The permissions of an existing file are retained, otherwise mode is used.
+			 *
+			 * @param content the new content of the file
+			 * @param mode the permissions of the file if it does not already exist
+			 * @throw Exception if a system error occured during writing
+			 */
+			void replaceFile(const std::string& content, mode_t mode = 0644) const throw(Exception) ;
+
+			/**
+			 * Atomically replaces the file represented by this FilePath object with the content
+			 * written by the specified ContentWriter, as replaceFile(const std::string&, mode_t).
+			 * The content is written as it is produced, rather than first being held in memory.
+			 * An exception thrown by the ContentWriter leaves the file unchanged and is rethrown.
+			 *
+			 * @param writer writes the new content of the file
+			 * @param mode the permissions of the file if it does not already exist
+			 * @throw Exception if a system error occured during writing
+			 */
+			void replaceFile(ContentWriter& writer, mode_t mode = 0644) const throw(Exception) ;
+
 			/**
 			 * Returns true if the file or directory represented by this FilePath object exists.
 			 *
@@ -299,6 +347,27 @@ namespace cutil
 			 */
 			unsigned long getFileSize() const throw(Exception) ;
 
+			/**
+			 * Returns a snapshot of the metadata of the file represented by this FilePath object.
+			 * The metadata is obtained with a single system call, any number of property queries
+			 * may then be answered from the returned FileStatus. A FileStatus is returned, with
+			 * exists() false, if the file does not exist.
+			 *
+			 * @return the metadata of the file
+			 * @throw Exception if a system error occured
+			 */
+			FileStatus getStatus() const throw(Exception) ;
+
+			/**
+			 * Returns a snapshot of the requested metadata of the file represented by this FilePath object.
+			 * Requesting only the fields required may allow the filesystem to avoid obtaining the others.
+			 *
+			 * @param fields or'ed FileStatus::FieldEnum values to obtain
+			 * @return the metadata of the file
+			 * @throw Exception if a system error occured
+			 */
+			FileStatus getStatus(int fields) const throw(Exception) ;
+
 
 
 
@@ -308,6 +377,7 @@ namespace cutil
 			/**
 			 * Popultes the specified list with the contents of the directory represented by this FilePath
 			 * If this FilePath does not represent a directory, no action is taken and filelist is unchanged
+			 * DirectoryWalker should be preferred for large, or recursive, listings
 			 *
 			 * @param fileList populated with the contenst of the directory represented by this FilePath
 			 * @return the fileList parameter populated
@@ -318,6 +388,7 @@ namespace cutil
 			/**
 			 * Popultes the specified list with the contents of the directory represented by this FilePath
 			 * If this FilePath does not represent a directory, no action is taken and filelist is unchanged
+			 * DirectoryWalker should be preferred for large, or recursive, listings
 			 *
 			 * @param fileList populated with the contenst of the directory represented by this File
 			 * @return the fileList parameter populated
@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_FILESTATUS_H_
+#define _CUTIL_FILESTATUS_H_
+
+#include <cutil/Exception.h>
+#include <cutil/FilePath.h>
+
+#include <vector>
+
+#include <sys/types.h>
+#include <time.h>
+
+namespace cutil
+{
+	/**
+	 * A snapshot of the metadata of a file.
+	 * The metadata is obtained with a single statx call, requesting only the fields required,
+	 * after which any number of property queries are answered without further system calls.
+	 * Fields not requested are reported as zero. Where statx is unavailable, fstatat is used.
+	 *
+	 * loadMany obtains the metadata of many paths, resolving each parent directory only once.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class FileStatus
+	{
+		public:
+
+			/**
+			 * Metadata fields which may be or'ed together and requested
+			 */
+			enum FieldEnum
+			{
+				/** the file type */
+				TYPE_FIELD_ENUM = 0x001,
+				/** the permission bits, and file type */
+				MODE_FIELD_ENUM = 0x002,
+				/** the owning user and group */
+				OWNER_FIELD_ENUM = 0x004,
+				/** the size in bytes */
+				SIZE_FIELD_ENUM = 0x008,
+				/** the allocated blocks */
+				BLOCKS_FIELD_ENUM = 0x010,
+				/** the access, modification and status change times */
+				TIMES_FIELD_ENUM = 0x020,
+				/** the creation time, where supported by the filesystem */
+				BIRTH_TIME_FIELD_ENUM = 0x040,
+				/** the device and inode number */
+				INODE_FIELD_ENUM = 0x080,
+				/** the hard link count */
+				LINK_COUNT_FIELD_ENUM = 0x100,
+				/** all fields */
+				ALL_FIELDS_ENUM = 0x1ff
+			} ;
+
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates an empty FileStatus, representing a file which does not exist
+			 *
+			 */
+			FileStatus() ;
+
+			/**
+			 * Creates a FileStatus holding the metadata of the specified path
+			 *
+			 * @param path the path to obtain the metadata of
+			 * @param fields or'ed FieldEnum values to obtain
+			 * @param follow set false to report a symbolic link itself rather than its target
+			 * @throw Exception if a system error other than the path not existing occurs
+			 */
+			FileStatus(const FilePath& path, int fields = ALL_FIELDS_ENUM, bool follow = true) throw(Exception) ;
+
+			/**
+			 * Destructor.
+			 *
+			 */
+			virtual ~FileStatus() ;
+
+			//-------------------------------------------------------------------------------//
+			// FileStatus Operations
+
+			/**
+			 * Obtains the metadata of the specified path, replacing any held by this FileStatus
+			 *
+			 * @param path the path to obtain the metadata of
+			 * @param fields or'ed FieldEnum values to obtain
+			 * @param follow set false to report a symbolic link itself rather than its target
+			 * @return true if the path exists, false otherwise
+			 * @throw Exception if a system error other than the path not existing occurs
+			 */
+			bool load(const FilePath& path, int fields = ALL_FIELDS_ENUM, bool follow = true) throw(Exception) ;
+
+			/**
+			 * Obtains the metadata of the specified path relative to an open directory
+			 *
+			 * @param dir_fd descriptor of the directory path is relative to, or AT_FDCWD
+			 * @param path the path to obtain the metadata of
+			 * @param fields or'ed FieldEnum values to obtain
+			 * @param follow set false to report a symbolic link itself rather than its target
+			 * @return true if the path exists, false otherwise
+			 * @throw Exception if a system error other than the path not existing occurs
+			 */
+			bool loadAt(int dir_fd, const char* path, int fields = ALL_FIELDS_ENUM, bool follow = true) throw(Exception) ;
+
+			/**
+			 * Obtains the metadata of each of the specified paths.
+			 * Paths are grouped by parent directory, each parent directory is opened once and its
+			 * entries queried relative to it, avoiding resolution of the full path of each entry.
+			 * statuses is resized to match paths, each element holding the metadata of the
+			 * corresponding path.
+			 *
+			 * @param paths the paths to obtain the metadata of
+			 * @param statuses populated with the metadata of each path
+			 * @param fields or'ed FieldEnum values to obtain
+			 * @param follow set false to report symbolic links themselves rather than their targets
+			 * @return the number of paths which exist
+			 * @throw Exception if a system error other than a path not existing occurs
+			 */
+			static size_t loadMany(const std::vector<FilePath>& paths, std::vector<FileStatus>& statuses, int fields = ALL_FIELDS_ENUM, bool follow = true) throw(Exception) ;
+
+			//-------------------------------------------------------------------------------//
+			// Property Accessors
+
+			/**
+			 * Returns whether the file existed when the metadata was obtained
+			 *
+			 * @return true if the file exists, false otherwise
+			 */
+			bool exists() const ;
+
+			/**
+			 * Returns the error which prevented the metadata being obtained
+			 *
+			 * @return the errno of the failed call, or 0 if the file exists
+			 */
+			int getError() const ;
+
+			/**
+			 * Returns the or'ed FieldEnum values held by this FileStatus
+			 *
+			 * @return the fields held by this FileStatus
+			 */
+			int getFields() const ;
+
+			/**
+			 * Returns the type of the file
+			 *
+			 * @return the type of the file, UNKNOWN_TYPE_ENUM if not held or the file does not exist
+			 */
+			FilePath::FileType getFileType() const ;
+
+			/**
+			 * Returns whether the file is a directory
+			 *
+			 * @return true if the file exists and is a directory
+			 */
+			bool isDirectory() const ;
+
+			/**
+			 * Returns whether the file is a regular file
+			 *
+			 * @return true if the file exists and is a regular file
+			 */
+			bool isRegularFile() const ;
+
+			/**
+			 * Returns whether the file is readable by the effective user of the process.
+			 * Requires the MODE_FIELD_ENUM and OWNER_FIELD_ENUM fields. The permission bits are evaluated
+			 * against the effective user and groups, access control lists and read only mounts are not
+			 * considered, FilePath::isReadable should be used where these matter.
+			 *
+			 * @return true if the permission bits grant read access
+			 */
+			bool isReadable() const ;
+
+			/**
+			 * Returns whether the file is writable by the effective user of the process.
+			 * Requires the MODE_FIELD_ENUM and OWNER_FIELD_ENUM fields, and is subject to the same
+			 * limitations as isReadable.
+			 *
+			 * @return true if the permission bits grant write access
+			 */
+			bool isWritable() const ;
+
+			/**
+			 * Returns the mode, type and permission bits, of the file
+			 *
+			 * @return the mode of the file
+			 */
+			mode_t getMode() const ;
+
+			/**
+			 * Returns the owning user of the file
+			 *
+			 * @return the owning user id
+			 */
+			uid_t getOwner() const ;
+
+			/**
+			 * Returns the owning group of the file
+			 *
+			 * @return the owning group id
+			 */
+			gid_t getGroup() const ;
+
+			/**
+			 * Returns the size of the file in bytes
+			 *
+			 * @return the size of the file
+			 */
+			unsigned long long getSize() const ;
+
+			/**
+			 * Returns the number of 512 byte blocks allocated to the file
+			 *
+			 * @return the number of allocated blocks
+			 */
+			unsigned long long getBlocks() const ;
+
+			/**
+			 * Returns the time the file was last accessed
+			 *
+			 * @return the last access time
+			 */
+			struct timespec getAccessTime() const ;
+
+			/**
+			 * Returns the time the file contents were last modified
+			 *
+			 * @return the last modification time
+			 */
+			struct timespec getModifiedTime() const ;
+
+			/**
+			 * Returns the time the file status was last changed
+			 *
+			 * @return the last status change time
+			 */
+			struct timespec getChangeTime() const ;
+
+			/**
+			 * Returns the time the file was created.
+			 * Only reported where statx and the filesystem support it, see hasBirthTime
+			 *
+			 * @return the creation time
+			 */
+			struct timespec getBirthTime() const ;
+
+			/**
+			 * Returns whether the creation time of the file is held
+			 *
+			 * @return true if getBirthTime is valid
+			 */
+			bool hasBirthTime() const ;
+
+			/**
+			 * Returns the device containing the file
+			 *
+			 * @return the device containing the file
+			 */
+			dev_t getDevice() const ;
+
+			/**
+			 * Returns the inode number of the file
+			 *
+			 * @return the inode number
+			 */
+			ino_t getInode() const ;
+
+			/**
+			 * Returns the number of hard links to the file
+			 *
+			 * @return the hard link count
+			 */
+			nlink_t getLinkCount() const ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+
+			/**
+			 * Resets this FileStatus to represent a file which does not exist
+			 *
+			 * @param error the errno preventing the metadata being obtained
+			 */
+			void clear(int error) ;
+
+			/**
+			 * Zeroes the metadata of fields not held, which statx and fstatat may report regardless
+			 *
+			 */
+			void discardUnrequested() ;
+
+			/**
+			 * Returns whether the permission bits grant the specified access to the effective user
+			 *
+			 * @param owner_bit the owner permission bit, the group and other bits are derived from it
+			 */
+			bool isPermitted(mode_t owner_bit) const ;
+
+			/** or'ed FieldEnum values held */
+			int theFields ;
+
+			/** errno preventing the metadata being obtained, 0 if the file exists */
+			int theError ;
+
+			mode_t theMode ;
+			uid_t theOwner ;
+			gid_t theGroup ;
+			unsigned long long theSize ;
+			unsigned long long theBlocks ;
+			struct timespec theAccessTime ;
+			struct timespec theModifiedTime ;
+			struct timespec theChangeTime ;
+			struct timespec theBirthTime ;
+			dev_t theDevice ;
+			ino_t theInode ;
+			nlink_t theLinkCount ;
+
+	} ; /* class FileStatus */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_FILESTATUS_H_ */
@@ -0,0 +1,374 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_FILESTREAM_
+#define _CUTIL_FILESTREAM_
+
+#include <cutil/AbstractInputStream.h>
+#include <cutil/AbstractOutputStream.h>
+#include <cutil/FilePath.h>
+#include <cutil/FileStreamException.h>
+
+#include <sys/types.h>
+
+namespace cutil
+{
+	/**
+	 * A stream over a regular file, opened from a FilePath.
+	 * FileStream allows regular files to be processed through the AbstractInputStream and
+	 * AbstractOutputStream interfaces, and therefore through an InputReader or BufferedOutputWriter,
+	 * while also exposing positional I/O, kernel access pattern hints, and preallocation for
+	 * bulk file processing.
+	 *
+	 * When opened with DIRECT_ENUM the page cache is bypassed, in which case the buffer address,
+	 * the file offset, and the transfer length must all be multiples of getAlignment. Buffers
+	 * suitable for direct I/O may be obtained via allocateAligned. As an InputReader and
+	 * BufferedOutputWriter do not align their buffers, direct I/O should only be used with the
+	 * positional operations, or with suitably aligned buffers.
+	 *
+	 */
+	class FileStream : public AbstractInputStream, public AbstractOutputStream
+	{
+		public:
+
+			/** access modes for the FileStream */
+			enum AccessModeEnum { READ_ONLY_ENUM, WRITE_ONLY_ENUM, READ_WRITE_ENUM } ;
+
+			/**
+			 * Flags which may be or'ed together and passed when opening a FileStream
+			 */
+			enum OpenFlagsEnum
+			{
+				/** no flags */
+				OPEN_DEFAULT_ENUM = 0x00,
+				/** create the file if it does not exist */
+				OPEN_CREATE_ENUM = 0x01,
+				/** truncate the file to zero length on open */
+				OPEN_TRUNCATE_ENUM = 0x02,
+				/** all writes append to the end of the file */
+				OPEN_APPEND_ENUM = 0x04,
+				/** bypass the page cache, see getAlignment */
+				OPEN_DIRECT_ENUM = 0x08
+			} ;
+
+			/** origin for seek operations */
+			enum SeekOriginEnum { SEEK_BEGIN_ENUM, SEEK_CURRENT_ENUM, SEEK_END_ENUM } ;
+
+			/** access patterns which may be advised to the kernel, see posix_fadvise(2) */
+			enum AccessPatternEnum
+			{
+				/** no special treatment */
+				PATTERN_NORMAL_ENUM,
+				/** data will be accessed sequentially, readahead is increased */
+				PATTERN_SEQUENTIAL_ENUM,
+				/** data will be accessed randomly, readahead is disabled */
+				PATTERN_RANDOM_ENUM,
+				/** data will be accessed in the near future, readahead is started immediately */
+				PATTERN_WILL_NEED_ENUM,
+				/** data will not be accessed in the near future, cached pages may be dropped */
+				PATTERN_DONT_NEED_ENUM,
+				/** data will be accessed only once */
+				PATTERN_NO_REUSE_ENUM
+			} ;
+
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates an unopened FileStream.
+			 * open must be called before this FileStream is in a useable state
+			 *
+			 */
+			FileStream() ;
+
+			/**
+			 * Creates a FileStream and opens the specified file
+			 *
+			 * @param path the file to open
+			 * @param mode the access mode of this FileStream
+			 * @param flags or'ed OpenFlagsEnum values
+			 * @throws FileStreamException if the file cannot be opened
+			 */
+			FileStream(const FilePath& path, AccessModeEnum mode, int flags = OPEN_DEFAULT_ENUM) throw(FileStreamException) ;
+
+			/**
+			 * Destructor.
+			 * Closes this FileStream if it is open
+			 *
+			 */
+			virtual ~FileStream() ;
+
+			//-------------------------------------------------------------------------------//
+			// FileStream Setup Operations
+
+			/**
+			 * Opens the specified file.
+			 * Any file already opened by this FileStream is first closed.
+			 * A file created by OPEN_CREATE_ENUM is created with mode 0666, modified by the process umask.
+			 *
+			 * @param path the file to open
+			 * @param mode the access mode of this FileStream
+			 * @param flags or'ed OpenFlagsEnum values
+			 * @throws FileStreamException if the file cannot be opened
+			 */
+			void open(const FilePath& path, AccessModeEnum mode, int flags = OPEN_DEFAULT_ENUM) throw(FileStreamException) ;
+
+			/**
+			 * Closes this FileStream
+			 * If this FileStream is not open, no action is taken.
+			 *
+			 * @throws FileStreamException if an error occurs during the closing of this FileStream
+			 */
+			void close() throw(FileStreamException) ;
+
+			//-------------------------------------------------------------------------------//
+			// General Accessors/Murators
+
+			/**
+			 * Returns the FilePath this FileStream was last opened upon
+			 *
+			 * @return the FilePath of this FileStream
+			 */
+			FilePath getPath() const ;
+
+			/**
+			 * Returns the access mode of this FileStream
+			 *
+			 * @return the access mode of this FileStream
+			 */
+			AccessModeEnum getMode() const ;
+
+			/**
+			 * Returns whether this FileStream has been opened.
+			 *
+			 * @return true if this FileStream has been opened, false otherwise
+			 */
+			bool isOpen() const ;
+
+			/**
+			 * Returns whether this FileStream was opened for direct I/O
+			 *
+			 * @return true if this FileStream bypasses the page cache
+			 */
+			bool isDirect() const ;
+
+			/**
+			 * Returns the underlying file descriptor of this FileStream.
+			 *
+			 * @return the file descriptor of this FileStream, or -1 if not open
+			 */
+			int getFileDescriptor() const ;
+
+			/**
+			 * Returns the alignment required of buffers, offsets and lengths for direct I/O upon this FileStream.
+			 * Where the kernel reports the direct I/O alignment of the file that value is used, otherwise
+			 * the preferred I/O block size of the filesystem is used.
+			 *
+			 * @return the direct I/O alignment in bytes, or 0 if this FileStream is not open
+			 */
+			size_t getAlignment() const ;
+
+			//-------------------------------------------------------------------------------//
+			// Positional Operations
+
+			/**
+			 * Reads up to length bytes from the specified offset into buf.
+			 * The current position of this FileStream is not changed, allowing several threads to read
+			 * from the same FileStream concurrently.
+			 *
+			 * @param buf buffer into which the data should be read into
+			 * @param length number of bytes to be read
+			 * @param offset the file offset to read from
+			 * @return the number of bytes read, 0 indicating end of file
+			 * @throws FileStreamException if there is an error reading data
+			 */
+			ssize_t readAt(void* buf, size_t length, off_t offset) const throw(FileStreamException) ;
+
+			/**
+			 * Writes up to size bytes of data at the specified offset.
+			 * The current position of this FileStream is not changed.
+			 *
+			 * @param data the data to write
+			 * @param size number of bytes to write
+			 * @param offset the file offset to write at
+			 * @return the number of bytes written
+			 * @throws FileStreamException if there is an error writing data
+			 */
+			ssize_t writeAt(const void* data, size_t size, off_t offset) throw(FileStreamException) ;
+
+			/**
+			 * Moves the current position of this FileStream
+			 *
+			 * @param offset the offset relative to origin
+			 * @param origin the origin of the seek
+			 * @return the new position of this FileStream
+			 * @throws FileStreamException if the position cannot be changed
+			 */
+			off_t seek(off_t offset, SeekOriginEnum origin = SEEK_BEGIN_ENUM) throw(FileStreamException) ;
+
+			/**
+			 * Returns the current position of this FileStream
+			 *
+			 * @return the current position of this FileStream
+			 * @throws FileStreamException if the position cannot be determined
+			 */
+			off_t getPosition() const throw(FileStreamException) ;
+
+			/**
+			 * Returns the current size of the file opened by this FileStream
+			 *
+			 * @return the size of the file in bytes
+			 * @throws FileStreamException if the size cannot be determined
+			 */
+			off_t getSize() const throw(FileStreamException) ;
+
+			/**
+			 * Truncates, or extends, the file opened by this FileStream to the specified length
+			 *
+			 * @param length the new length of the file
+			 * @throws FileStreamException if the file cannot be truncated
+			 */
+			void truncate(off_t length) throw(FileStreamException) ;
+
+			/**
+			 * Flushes written data to the storage device.
+			 *
+			 * @param data_only set true to skip flushing metadata not required to retrieve the data (fdatasync)
+			 * @throws FileStreamException if an error occurs flushing the data
+			 */
+			void sync(bool data_only = false) throw(FileStreamException) ;
+
+			//-------------------------------------------------------------------------------//
+			// Kernel Hints
+
+			/**
+			 * Advises the kernel of the expected access pattern of a region of this FileStream.
+			 * A length of 0 extends the region to the end of the file.
+			 *
+			 * @param pattern the expected access pattern
+			 * @param offset the start of the region
+			 * @param length the length of the region
+			 * @throws FileStreamException if the advice is rejected
+			 */
+			void advise(AccessPatternEnum pattern, off_t offset = 0, off_t length = 0) throw(FileStreamException) ;
+
+			/**
+			 * Allocates disk space for the specified region of the file opened by this FileStream.
+			 * Preallocating a file which is to be written in full avoids fragmentation, and allows
+			 * a lack of disk space to be detected before any data is written. Where the filesystem
+			 * cannot allocate without writing, the space is reserved by writing zeros.
+			 *
+			 * @param offset the start of the region
+			 * @param length the length of the region
+			 * @param keep_size set true to leave the reported file size unchanged
+			 * @throws FileStreamException if the space cannot be allocated
+			 */
+			void preallocate(off_t offset, off_t length, bool keep_size = false) throw(FileStreamException) ;
+
+			//-------------------------------------------------------------------------------//
+			// Aligned Buffers
+
+			/**
+			 * Allocates a buffer of the specified size aligned for direct I/O.
+			 * The returned buffer must be released via releaseAligned
+			 *
+			 * @param size the size of the buffer
+			 * @param alignment the required alignment, a power of two
+			 * @return the allocated buffer
+			 * @throws FileStreamException if the buffer cannot be allocated
+			 */
+			static void* allocateAligned(size_t size, size_t alignment) throw(FileStreamException) ;
+
+			/**
+			 * Releases a buffer allocated via allocateAligned
+			 *
+			 * @param buf the buffer to release
+			 */
+			static void releaseAligned(void* buf) ;
+
+			//-------------------------------------------------------------------------------//
+			// AbstractInputStream
+
+			virtual bool isDataAvailable(long usec) const throw(Exception) ;
+
+			virtual ssize_t read(void* buf, size_t length) const throw(Exception) ;
+
+			virtual ssize_t read(void* buf, size_t length, int& err_code) const throw() ;
+
+			virtual ssize_t read(char& read_byte) throw(Exception) ;
+
+			virtual ssize_t read(char& read_byte, int& err_code) throw() ;
+
+			//-------------------------------------------------------------------------------//
+			// AbstractOutputStream
+
+			virtual ssize_t write(const void* data, size_t size) throw(Exception) ;
+
+			virtual ssize_t write(const void* data, size_t size, int& err_code) throw() ;
+
+			virtual ssize_t write(const char& write_byte) throw(Exception) ;
+
+			virtual ssize_t write(const char& write_byte, int& err_code) throw() ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			FileStream(const FileStream&) : AbstractInputStream(), AbstractOutputStream(), m_path("") {}
+
+			/**
+			 * Determines the direct I/O alignment of the open file
+			 *
+			 */
+			void queryAlignment() ;
+
+			/** the FilePath last opened by this FileStream */
+			FilePath m_path ;
+
+			/** the File Descriptor of the opened file */
+			int m_fd ;
+
+			/** the access mode of this FileStream */
+			AccessModeEnum m_access_mode ;
+
+			/** or'ed OpenFlagsEnum this FileStream was opened with */
+			int m_flags ;
+
+			/** direct I/O alignment of the open file */
+			size_t m_alignment ;
+
+	} ; /* class FileStream */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_FILESTREAM_ */
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_FILETREE_H_
+#define _CUTIL_FILETREE_H_
+
+#include <cutil/Exception.h>
+#include <cutil/FilePath.h>
+
+#include <vector>
+
+#include <sys/types.h>
+
+namespace cutil
+{
+	class ThreadPool ;
+
+	/**
+	 * FileTree performs bulk operations upon directory trees: recursive removal, recursive copy,
+	 * and creation of many directories with their parents.
+	 *
+	 * Trees are traversed with DirectoryWalker, entries being removed with unlinkat and opened with
+	 * openat relative to the descriptor of their directory, avoiding resolution of full paths.
+	 * Files are copied by reflink where the filesystem supports it, then by copy_file_range, and
+	 * only otherwise through user space buffers.
+	 *
+	 * A FileTree created with a ThreadPool spreads each operation across the pool, the subdirectories
+	 * of the root being processed concurrently. Each operation returns once complete.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class FileTree
+	{
+		public:
+
+			/**
+			 * The means by which a file was copied
+			 */
+			enum CopyMethodEnum
+			{
+				/** the destination shares the extents of the source */
+				REFLINK_ENUM,
+				/** the data was copied within the kernel */
+				COPY_FILE_RANGE_ENUM,
+				/** the data was copied through a user space buffer */
+				READ_WRITE_ENUM
+			} ;
+
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates a new FileTree performing operations within the calling thread
+			 *
+			 */
+			FileTree() ;
+
+			/**
+			 * Creates a new FileTree performing operations across the specified ThreadPool.
+			 * The pool must outlive this FileTree, and must not be the pool executing the caller.
+			 *
+			 * @param pool the ThreadPool to perform operations upon
+			 */
+			FileTree(ThreadPool& pool) ;
+
+			/**
+			 * Destructor.
+			 *
+			 */
+			virtual ~FileTree() ;
+
+			//-------------------------------------------------------------------------------//
+			// FileTree Operations
+
+			/**
+			 * Removes the specified path, and, if it is a directory, everything beneath it.
+			 * Symbolic links are removed, not followed.
+			 *
+			 * @param path the file or directory to remove
+			 * @return the number of entries removed, including path, 0 if path does not exist
+			 * @throw Exception if an entry cannot be removed, or a system error occurs
+			 */
+			size_t remove(const FilePath& path) throw(Exception) ;
+
+			/**
+			 * Copies the specified file or directory tree to destination, which must not exist.
+			 * Permission bits are preserved, symbolic links are copied as links, and fifos are
+			 * recreated. Sockets and devices are skipped.
+			 *
+			 * @param source the file or directory to copy
+			 * @param destination the path to copy to
+			 * @return the number of entries copied, including source
+			 * @throw Exception if source does not exist, destination exists, or a system error occurs
+			 */
+			size_t copy(const FilePath& source, const FilePath& destination) throw(Exception) ;
+
+			/**
+			 * Creates each of the specified directories, and any missing parents, as mkdir -p.
+			 * Directories which already exist are not an error.
+			 *
+			 * @param paths the directories to create
+			 * @return the number of directories created, including parents
+			 * @throw Exception if a directory cannot be created
+			 */
+			size_t createDirectories(const std::vector<FilePath>& paths) throw(Exception) ;
+
+			/**
+			 * Copies a single regular file, creating destination with the permission bits of source
+			 *
+			 * @param source the file to copy
+			 * @param destination the file to create, which must not exist
+			 * @return the means by which the file was copied
+			 * @throw Exception if a system error occurs
+			 */
+			static CopyMethodEnum copyFile(const FilePath& source, const FilePath& destination) throw(Exception) ;
+
+			/**
+			 * Sets the permission bits of directories created by createDirectories, before the umask is applied
+			 *
+			 * @param mode the permission bits of created directories
+			 */
+			void setDirectoryMode(mode_t mode) ;
+
+			/**
+			 * Returns the permission bits of directories created by createDirectories
+			 *
+			 * @return the permission bits of created directories
+			 */
+			mode_t getDirectoryMode() const ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+
+			FileTree(const FileTree&) ;
+			FileTree& operator=(const FileTree&) ;
+
+			/** the pool operations are spread across, NULL to operate within the calling thread */
+			ThreadPool* thePool ;
+
+			/** permission bits of directories created by createDirectories */
+			mode_t theDirectoryMode ;
+
+	} ; /* class FileTree */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_FILETREE_H_ */
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_MAPPEDFILE_
+#define _CUTIL_MAPPEDFILE_
+
+#include <cutil/Exception.h>
+#include <cutil/FilePath.h>
+
+#include <sys/types.h>
+
+namespace cutil
+{
+	/**
+	 * A memory-mapped view of a file, opened from a FilePath.
+	 * The contents of the file are mapped into the address space of the process on construction
+	 * without being read, pages are faulted in from the page cache on first access. A read only
+	 * MappedFile of a large lookup table can therefore be opened in constant time, and the physical
+	 * pages are shared by all processes mapping the same file.
+	 *
+	 * Changes to a READ_WRITE_ENUM MappedFile are written directly into the page cache, and are
+	 * therefore visible to other processes mapping the file, sync may be used to flush the changes
+	 * to the storage device.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class MappedFile
+	{
+		public:
+
+			/** access modes for the MappedFile */
+			enum AccessModeEnum { READ_ONLY_ENUM, READ_WRITE_ENUM } ;
+
+			/**
+			 * Flags which may be or'ed together and passed when mapping a file
+			 */
+			enum MapFlagsEnum
+			{
+				/** no flags */
+				MAP_DEFAULT_ENUM = 0x00,
+				/** fault the whole file in during map, avoiding page faults on later access */
+				MAP_POPULATE_ENUM = 0x01,
+				/** request transparent huge pages for the mapping, ignored where unsupported */
+				MAP_HUGE_PAGES_ENUM = 0x02,
+				/** lock the mapping into memory, preventing it being paged out */
+				MAP_LOCKED_ENUM = 0x04
+			} ;
+
+			/** expected access patterns of the mapping, see madvise(2) */
+			enum AdviceEnum
+			{
+				/** no special treatment */
+				ADVICE_NORMAL_ENUM,
+				/** pages will be accessed sequentially, aggressive readahead */
+				ADVICE_SEQUENTIAL_ENUM,
+				/** pages will be accessed randomly, no readahead */
+				ADVICE_RANDOM_ENUM,
+				/** pages will be accessed in the near future, readahead is started immediately */
+				ADVICE_WILL_NEED_ENUM,
+				/** pages will not be accessed in the near future */
+				ADVICE_DONT_NEED_ENUM
+			} ;
+
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates an unmapped MappedFile
+			 *
+			 */
+			MappedFile() ;
+
+			/**
+			 * Creates a MappedFile and maps the specified file
+			 *
+			 * @param path the file to map
+			 * @param mode the access mode of the mapping
+			 * @param flags or'ed MapFlagsEnum values
+			 * @param length the minimum length of a READ_WRITE_ENUM mapping, the file is extended if required
+			 * @throw Exception if the file cannot be mapped
+			 */
+			MappedFile(const FilePath& path, AccessModeEnum mode, int flags = MAP_DEFAULT_ENUM, size_t length = 0) throw(Exception) ;
+
+			/**
+			 * Destructor.
+			 * Unmaps this MappedFile if it is mapped
+			 *
+			 */
+			virtual ~MappedFile() ;
+
+			//-------------------------------------------------------------------------------//
+			// MappedFile Operations
+
+			/**
+			 * Maps the specified file
+			 * Any file already mapped by this MappedFile is first unmapped. A READ_WRITE_ENUM mapping
+			 * creates the file if it does not exist, and extends the file to length if it is shorter.
+			 * An empty file may be mapped, in which case getData returns NULL and getSize returns 0.
+			 *
+			 * @param path the file to map
+			 * @param mode the access mode of the mapping
+			 * @param flags or'ed MapFlagsEnum values
+			 * @param length the minimum length of a READ_WRITE_ENUM mapping, the file is extended if required
+			 * @throw Exception if the file cannot be mapped
+			 */
+			void map(const FilePath& path, AccessModeEnum mode, int flags = MAP_DEFAULT_ENUM, size_t length = 0) throw(Exception) ;
+
+			/**
+			 * Unmaps this MappedFile
+			 * Changes to a READ_WRITE_ENUM mapping remain in the page cache and are written back by the kernel.
+			 * If this MappedFile is not mapped, no action is taken.
+			 *
+			 */
+			void unmap() ;
+
+			/**
+			 * Advises the kernel of the expected access pattern of a region of this MappedFile.
+			 * A length of 0 extends the region to the end of the mapping.
+			 *
+			 * @param advice the expected access pattern
+			 * @param offset the start of the region, rounded down to a page boundary
+			 * @param length the length of the region
+			 * @throw Exception if this MappedFile is not mapped, or the advice is rejected
+			 */
+			void advise(AdviceEnum advice, size_t offset = 0, size_t length = 0) throw(Exception) ;
+
+			/**
+			 * Flushes changes to a READ_WRITE_ENUM mapping to the storage device
+			 *
+			 * @param wait set false to schedule the write back without waiting for it to complete
+			 * @throw Exception if this MappedFile is not mapped, or the changes cannot be flushed
+			 */
+			void sync(bool wait = true) throw(Exception) ;
+
+			//-------------------------------------------------------------------------------//
+			// General Accessors/Murators
+
+			/**
+			 * Returns whether this MappedFile is currently mapped
+			 *
+			 * @return true if this MappedFile is mapped, false otherwise
+			 */
+			bool isMapped() const ;
+
+			/**
+			 * Returns the FilePath this MappedFile was last mapped from
+			 *
+			 * @return the FilePath of this MappedFile
+			 */
+			FilePath getPath() const ;
+
+			/**
+			 * Returns the access mode of this MappedFile
+			 *
+			 * @return the access mode of this MappedFile
+			 */
+			AccessModeEnum getMode() const ;
+
+			/**
+			 * Returns the start of the mapped data
+			 *
+			 * @return the mapped data, or NULL if not mapped or the file is empty
+			 */
+			const char* getData() const ;
+
+			/**
+			 * Returns the start of the mapped data for modification.
+			 * Only a READ_WRITE_ENUM mapping may be modified, writing to a READ_ONLY_ENUM mapping raises SIGSEGV.
+			 *
+			 * @return the mapped data, or NULL if not mapped or the file is empty
+			 */
+			char* getData() ;
+
+			/**
+			 * Returns the length of the mapped data
+			 *
+			 * @return the length of the mapped data in bytes
+			 */
+			size_t getSize() const ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			MappedFile(const MappedFile&) : m_path("") {}
+
+			/**
+			 * Dis-allow assignment
+			 *
+			 */
+			MappedFile& operator=(const MappedFile&) { return(*this) ; }
+
+			/** the FilePath last mapped by this MappedFile */
+			FilePath m_path ;
+
+			/** the access mode of the mapping */
+			AccessModeEnum m_access_mode ;
+
+			/** the start of the mapping */
+			char* m_data ;
+
+			/** the length of the mapping */
+			size_t m_size ;
+
+			/** indicates if a file is mapped */
+			bool m_mapped ;
+
+	} ; /* class MappedFile */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_MAPPEDFILE_ */
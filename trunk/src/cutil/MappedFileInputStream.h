@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_MAPPEDFILEINPUTSTREAM_
+#define _CUTIL_MAPPEDFILEINPUTSTREAM_
+
+#include <cutil/AbstractInputStream.h>
+
+#include <sys/types.h>
+
+namespace cutil
+{
+	class MappedFile ;
+
+	/**
+	 * An AbstractInputStream reading sequentially from a MappedFile.
+	 * Allows mapped data to be consumed through an InputReader, each read being a copy from the
+	 * mapping with no system call. The MappedFile must remain mapped for the lifetime of the stream.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class MappedFileInputStream : public AbstractInputStream
+	{
+		public:
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates a new MappedFileInputStream reading from the start of the specified MappedFile
+			 *
+			 * @param file the MappedFile to read from
+			 */
+			MappedFileInputStream(const MappedFile& file) ;
+
+			/**
+			 * Destructor.
+			 *
+			 */
+			virtual ~MappedFileInputStream() ;
+
+			//-------------------------------------------------------------------------------//
+			// MappedFileInputStream Operations
+
+			/**
+			 * Returns the current read position within the MappedFile
+			 *
+			 * @return the current read position
+			 */
+			size_t getPosition() const ;
+
+			/**
+			 * Sets the current read position within the MappedFile.
+			 * Positions beyond the end of the MappedFile are limited to the end of the MappedFile
+			 *
+			 * @param position the new read position
+			 */
+			void setPosition(size_t position) ;
+
+			/**
+			 * Returns the number of bytes remaining to be read
+			 *
+			 * @return the number of bytes remaining to be read
+			 */
+			size_t getRemaining() const ;
+
+			/**
+			 * Returns the mapped data at the current read position without copying it.
+			 * The read position is not changed, use setPosition to consume the data.
+			 *
+			 * @return the mapped data at the current read position, or NULL if no data remains
+			 */
+			const char* peek() const ;
+
+			//-------------------------------------------------------------------------------//
+			// AbstractInputStream
+
+			virtual bool isDataAvailable(long usec) const throw(Exception) ;
+
+			virtual ssize_t read(void* buf, size_t length) const throw(Exception) ;
+
+			virtual ssize_t read(void* buf, size_t length, int& err_code) const throw() ;
+
+			virtual ssize_t read(char& read_byte) throw(Exception) ;
+
+			virtual ssize_t read(char& read_byte, int& err_code) throw() ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			MappedFileInputStream(const MappedFileInputStream& s) : AbstractInputStream(), m_file(s.m_file) {}
+
+			/** the MappedFile being read */
+			const MappedFile& m_file ;
+
+			/** the current read position, reads are const within AbstractInputStream */
+			mutable size_t m_position ;
+
+	} ; /* class MappedFileInputStream */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_MAPPEDFILEINPUTSTREAM_ */
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#ifndef _CUTIL_MEMORYSTATEHANDLER_H_
+#define _CUTIL_MEMORYSTATEHANDLER_H_
+
+#include <cutil/StateHandler.h>
+
+#include <cutil/MemoryStateNode.h>
+#include <cutil/RefCountPtr.h>
+
+namespace cutil
+{
+	class StateNode ;
+
+	/**
+	 * StateHandler implementation holding state information in memory.
+	 * Each StateNode holds its children and values in hashed containers, with values held
+	 * in their set type, so state information may be read on frequently used paths without
+	 * searching or converting. There is no persistant store, state information is instead
+	 * imported from, and exported to, another StateHandler, such as an XMLStateHandler.
+	 *
+	 * @see MemoryStateNode
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class MemoryStateHandler : public StateHandler
+	{
+		public:
+			//---------------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Constructs a new MemoryStateHandler with an empty state tree
+			 */
+			MemoryStateHandler() ;
+
+			/**
+			 * Destructor
+			 */
+			virtual ~MemoryStateHandler() ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// StateHandler implementations
+
+			/**
+			 * Initialize this StateHandler.
+			 * A MemoryStateHandler requires no initialization
+			 */
+			virtual void initialize() ;
+
+			/**
+			 * Shutdown this StateHandler.
+			 * A MemoryStateHandler has no resources to release, the state tree remains available
+			 */
+			virtual void shutdown() ;
+
+			//---------------------------------------------------------------------------------------//
+			// Update Control
+
+			/**
+			 * Force a write of state information back to the persistant store
+			 * A MemoryStateHandler has no persistant store, use exportState to write the state
+			 * information to another StateHandler
+			 */
+			virtual void flush() ;
+
+			/**
+			 * Synchronize this StateHandler to the persistant store of state information,
+			 * A MemoryStateHandler has no persistant store, use importState to read the state
+			 * information of another StateHandler
+			 */
+			virtual void sync() ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// StateNode Access
+
+			/**
+			 * Returns the root StateNode within the state tree of this StateHandler
+			 * This method returns a user handle for the underlying data of the StateNode
+			 * implementation. Subsequent calls to getRootNode need not return the same
+			 * handle instance, however, it is guaranteed that each will be a handle to
+			 * the same underlying data instance.
+			 *
+			 * @return the root StateNode within the state tree of this StateHandler
+			 */
+			virtual RefCountPtr<StateNode> getRootNode() ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// Import / Export
+
+			/**
+			 * Replaces the state tree of this MemoryStateHandler with a copy of the state tree
+			 * of the specified StateHandler.
+			 * Values are imported as strings, and converted on access as the source StateHandler
+			 * would. Handles to StateNodes of the replaced state tree no longer form part of the
+			 * state tree.
+			 *
+			 * @param source the initialized StateHandler to import
+			 */
+			void importState(StateHandler& source) ;
+
+			/**
+			 * Copies the state tree of this MemoryStateHandler into the specified StateHandler.
+			 * Each value is set in the type it was set with. Values and StateNodes of target not
+			 * within this state tree are left unchanged. The target is not flushed.
+			 *
+			 * @param target the initialized StateHandler to export to
+			 */
+			void exportState(StateHandler& target) ;
+
+			/**
+			 * Returns the number of modifications made to the state tree since it was constructed
+			 * or imported. A modification is a value stored or removed, or a StateNode created
+			 * or removed. The count may be compared with an earlier count to detect modification.
+			 *
+			 * @return the number of modifications made to the state tree
+			 */
+			unsigned long getModificationCount() const ;
+
+			//---------------------------------------------------------------------------------------//
+
+		protected:
+
+			//---------------------------------------------------------------------------------------//
+
+		private:
+			/**
+			 * Disallow copy constructor
+			 */
+			MemoryStateHandler(const MemoryStateHandler&) {} ;
+
+			/**
+			 * Copies the values and child StateNodes of from into to, recursively.
+			 * Values of a MemoryStateNode are copied in their set types, other values are copied
+			 * as strings, converted once to each type as the source StateNode would convert them.
+			 *
+			 * @param from the StateNode to copy from
+			 * @param to the StateNode to copy to
+			 */
+			static void importNode(StateNode& from, MemoryStateNode& to) ;
+
+			/**
+			 * Copies the values and child StateNodes of from into to, recursively, in their set types
+			 *
+			 * @param from the StateNode data to copy from
+			 * @param to the StateNode to copy to
+			 */
+			static void exportNode(const MemoryStateNode::NodeData& from, StateNode& to) ;
+
+			/** the root of the state tree */
+			RefCountPtr<MemoryStateNode::NodeData> theRoot ;
+
+	} ; /* class MemoryStateHandler */
+
+} /* namespace cutil */
+
+#endif /* _CUTIL_MEMORYSTATEHANDLER_H_ */
@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#ifndef _CUTIL_MEMORYSTATENODE_H_
+#define _CUTIL_MEMORYSTATENODE_H_
+
+#include <cutil/StateNode.h>
+
+#include <cutil/RefCountPtr.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <tr1/unordered_map>
+
+namespace cutil
+{
+	class MemoryStateHandler ;
+
+	/**
+	 * MemoryStateNode is an implementation of the StateNode interface holding state information
+	 * in memory.
+	 * Child StateNodes and values are held in hashed containers, so each access is a hash lookup
+	 * of the name rather than a search of the children. Values are held in the type they were
+	 * set with, along with their string representation, so reading a value in its own type, or
+	 * as a string, requires no conversion. A value read as another type is converted from its
+	 * string representation, as XMLStateNode converts values, so values read back are unchanged
+	 * by an export to XML and subsequent import. String values imported from another StateHandler
+	 * are converted once, when imported.
+	 * Child StateNodes and values are listed in the order they were first set.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class MemoryStateNode : public StateNode
+	{
+		public:
+			//---------------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Destructor
+			 */
+			virtual ~MemoryStateNode() ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// State Tree Handling
+
+			/**
+			 * Returns the parent StateNode of this StateNode.
+			 * If the parent StateNode does not exist, or this StateNode has been removed from the
+			 * state tree, the returned RefCountPtr will point to 0.
+			 *
+			 * This method returns a user handle for the underlying data of the StateNode
+			 * implementation. Subsequent calls to getParent need not return the same
+			 * handle instance, however, it is guaranteed that each will be a handle to
+			 * the same underlying data instance.
+			 *
+			 * @return the parent StateNode to this StateNode
+			 */
+			virtual RefCountPtr<StateNode> getParent() ;
+
+			/**
+			 * Returns thenamed child StateHandler from the state tree below this StateHandler,
+			 * If the child StateNode does not yet exist, it is created and returned, creating any
+			 * parent nodes as required.
+			 * The child node is specified by a '/' separated path, indicating parent StateNodes.
+			 *
+			 * This method returns a user handle for the underlying data of the StateNode
+			 * implementation. Subsequent calls to getChild need not return the same
+			 * handle instance, however, it is guaranteed that each will be a handle to
+			 * the same underlying data instance.
+			 *
+			 * @param childPath the path to the child node
+			 * @return the specified child node
+			 */
+			virtual RefCountPtr<StateNode> getChild(std::string childPath) ;
+
+			/**
+			 * Removes the specified child StateNode from the state tree.
+			 * The specified child Statehandler must be below this StateNode within the state tree
+			 * Handles to the removed StateNode, or those below it, remain valid, however they
+			 * no longer form part of the state tree.
+			 *
+			 * @param childPath the path to the child StateNode to remove
+			 */
+			virtual void removeChild(std::string childPath) ;
+
+			/**
+			 * Returns true of this StateNode contains the specified Child StateNode
+			 *
+			 * @param childPath the path of the specified child StateNode
+			 * @return true if thie StateNode contains th specified StateNode
+			 */
+			virtual bool hasChild(const std::string& childPath) ;
+
+			/**
+			 * Populate the specified list with all the child StateNode names directly below this StateNode in the state tree
+			 * The list is not cleared prior to any additions
+			 *
+			 * @param childList the list to populate
+			 * @return the number of elements added to the list
+			 */
+			virtual int getChildren(std::list<std::string>& childList) ;
+
+			/**
+			 * Returns the complete path of this StateNode starting at the root '/'
+			 *
+			 * @return the complete path of this StateNode
+			 */
+			virtual const std::string& getPath() const ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// State Handling
+
+			/**
+			 * Stores the specified value string within this StateHandler associated with the specified name string
+			 *
+			 * @param name name with which the specified value will be associated
+			 * @param value the string value to store with the specified name
+			 */
+			virtual void setString(const std::string& name, const std::string& value) ;
+
+			/**
+			 * Stores the specified int value within this StateHandler associated with the specified name string
+			 *
+			 * @param name name with which the specified value will be associated
+			 * @param value the int value to store with the specified name
+			 */
+			virtual void setInt(const std::string& name, int value) ;
+
+			/**
+			 * Stores the specified double value within this StateHandler associated with the specified name string
+			 *
+			 * @param name name with which the specified value will be associated
+			 * @param value the double value to store with the specified name
+			 */
+			virtual void setDouble(const std::string& name, double value) ;
+
+			/**
+			 * Stores the specified bool value within this StateHandler associated with the specified name string
+			 *
+			 * @param name name with which the specified value will be associated
+			 * @param value the bool value to store with the specified name
+			 */
+			virtual void setBool(const std::string& name, bool value) ;
+
+
+
+			/**
+			 * Returns the specified string value associated with the specified name from this StateHandler.
+			 * If the specified name is not found, the specified default value will be returned
+			 *
+			 * @param name the name with which the value is associated
+			 * @param def the default value if the specified name cannot be found
+			 * @return the string value associated with the specified name
+			 */
+			virtual std::string getString(const std::string& name, const std::string& def) const ;
+
+			/**
+			 * Returns the specified int value associated with the specified name from this StateHandler.
+			 * If the specified name is not found the specified default value will be returned
+			 *
+			 * @param name the name with which the value is associated
+			 * @param def the default value if the specified name cannot be found
+			 * @return the int value associated with the specified name
+			 */
+			virtual int getInt(const std::string& name, int def) const ;
+
+			/**
+			 * Returns the specified double value associated with the specified name from this StateHandler.
+			 * If the specified name is not found the specified default value will be returned
+			 *
+			 * @param name the name with which the value is associated
+			 * @param def the default value if the specified name cannot be found
+			 * @return the double value associated with the specified name
+			 */
+			virtual double getDouble(const std::string& name, double def) const ;
+
+			/**
+			 * Returns the specified bool value associated with the specified name from this StateHandler.
+			 * If the specified name is not found the specified default value will be returned
+			 *
+			 * @param name the name with which the value is associated
+			 * @param def the default value if the specified name cannot be found
+			 * @return the bool value associated with the specified name
+			 */
+			virtual bool getBool(const std::string& name, bool def) const ;
+
+
+
+			/**
+			 * Removed the specified name value pair from this StateHandler
+			 *
+			 * @param name name of the name value pair to remove
+			 */
+			virtual void removeValue(const std::string& name) ;
+
+			/**
+			 * Populate the specified list with the names of all values stored within this StateNode
+			 * The list is not cleared prior to any additions
+			 *
+			 * @param nameList the list to populate
+			 * @return the number of elements added to the list
+			 */
+			virtual int getValueNames(std::list<std::string>& nameList) ;
+
+			//---------------------------------------------------------------------------------------//
+
+		protected:
+
+			//---------------------------------------------------------------------------------------//
+
+		private:
+			// MemoryStateHandler creates the root StateNode, and accesses the state tree directly
+			friend class MemoryStateHandler ;
+
+			struct NodeData ;
+
+			/** the type a value was set with */
+			enum ValueType { STRING_VALUE, INT_VALUE, DOUBLE_VALUE, BOOL_VALUE } ;
+
+			/**
+			 * A value held in its set type, with its string representation
+			 */
+			struct Value
+			{
+				Value() : theType(STRING_VALUE), theInt(0), theDouble(0.0), theBool(false), theConvertedFlag(false) {}
+
+				/** the type the value was set with */
+				ValueType theType ;
+
+				/** the string representation of the value */
+				std::string theString ;
+
+				/** the value, according to theType, or each conversion of theString if theConvertedFlag is set */
+				int theInt ;
+				double theDouble ;
+				bool theBool ;
+
+				/** indicates a string value was converted to each type when imported */
+				bool theConvertedFlag ;
+			} ;
+
+			typedef std::tr1::unordered_map<std::string, RefCountPtr<NodeData> > ChildContainer_t ;
+			typedef std::tr1::unordered_map<std::string, Value> ValueContainer_t ;
+
+			/**
+			 * The underlying data of a StateNode, shared by each handle to the StateNode
+			 */
+			struct NodeData
+			{
+				NodeData(const std::string& path) : thePath(path), theModificationCount(0) {}
+
+				/** the complete path of the StateNode */
+				std::string thePath ;
+
+				/** the child StateNodes, by name, and the names in the order they were added */
+				ChildContainer_t theChildren ;
+				std::vector<std::string> theChildOrder ;
+
+				/** the values, by name, and the names in the order they were added */
+				ValueContainer_t theValues ;
+				std::vector<std::string> theValueOrder ;
+
+				/** the number of modifications of the state tree, held by the root only */
+				unsigned long theModificationCount ;
+			} ;
+
+			/**
+			 * Constructs a new handle to the specified StateNode data, within the state tree of root
+			 *
+			 * @param root the root of the state tree
+			 * @param data the StateNode data
+			 */
+			MemoryStateNode(RefCountPtr<NodeData> root, RefCountPtr<NodeData> data) ;
+
+			/**
+			 * Returns the StateNode data at the specified path below data, creating the StateNodes
+			 * along the path if create is set
+			 *
+			 * @param data the StateNode data from which the path is followed
+			 * @param pathSegments the segments of the path below data
+			 * @param create set true to create missing StateNodes
+			 * @return the StateNode data at the path, or an empty RefCountPtr if not found and not created
+			 */
+			static RefCountPtr<NodeData> findNode(RefCountPtr<NodeData> data, const std::list<std::string>& pathSegments, bool create) ;
+
+			/**
+			 * Stores the specified Value, replacing any existing value of the same name
+			 *
+			 * @param name the name of the value
+			 * @param value the value
+			 */
+			void storeValue(const std::string& name, const Value& value) ;
+
+			/**
+			 * Returns the named Value, or 0 if no value is stored with the name
+			 *
+			 * @param name the name of the value
+			 * @return the named Value, or 0
+			 */
+			const Value* findValue(const std::string& name) const ;
+
+			/**
+			 * Counts a modification of the state tree
+			 */
+			void modified() ;
+
+			/** the root of the state tree */
+			RefCountPtr<NodeData> theRoot ;
+
+			/** the data of this StateNode */
+			RefCountPtr<NodeData> theData ;
+
+	} ; /* class MemoryStateNode */
+
+} /* namespace cutil */
+
+#endif /* _CUTIL_MEMORYSTATENODE_H_ */
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_MUTEX_H_
+#define _CUTIL_MUTEX_H_
+
+#include <cutil/Exception.h>
+
+#include <pthread.h>
+
+namespace cutil
+{
+	/**
+	 * A mutual exclusion lock, a simple wrapper around a pthread mutex.
+	 * The Mutex is not recursive, a thread must not lock a Mutex it already holds.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class Mutex
+	{
+		public:
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates a new unlocked Mutex
+			 *
+			 * @throw Exception if the mutex cannot be initialised
+			 */
+			Mutex() throw(Exception) ;
+
+			/**
+			 * Destructor.
+			 * The Mutex must not be locked when destroyed
+			 *
+			 */
+			virtual ~Mutex() ;
+
+			//-------------------------------------------------------------------------------//
+			// Mutex Operations
+
+			/**
+			 * Locks this Mutex, blocking until it becomes available
+			 *
+			 * @throw Exception if the mutex cannot be locked
+			 */
+			void lock() throw(Exception) ;
+
+			/**
+			 * Attempts to lock this Mutex without blocking
+			 *
+			 * @return true if this Mutex was locked, false if it is held by another thread
+			 */
+			bool tryLock() ;
+
+			/**
+			 * Unlocks this Mutex
+			 *
+			 * @throw Exception if the mutex cannot be unlocked
+			 */
+			void unlock() throw(Exception) ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+			friend class Condition ;
+
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			Mutex(const Mutex&) {}
+
+			/** the underlying pthread mutex */
+			pthread_mutex_t theMutex ;
+
+	} ; /* class Mutex */
+
+
+	/**
+	 * Scoped lock of a Mutex.
+	 * The Mutex is locked on construction and unlocked on destruction, ensuring the Mutex is
+	 * released when the scope is left by an exception.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class MutexLock
+	{
+		public:
+			/**
+			 * Locks the specified Mutex for the lifetime of this MutexLock
+			 *
+			 * @param mutex the Mutex to lock
+			 */
+			MutexLock(Mutex& mutex) : theMutex(mutex)
+			{
+				theMutex.lock() ;
+			}
+
+			/**
+			 * Destructor.
+			 * Unlocks the Mutex
+			 *
+			 */
+			~MutexLock()
+			{
+				theMutex.unlock() ;
+			}
+
+		private:
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			MutexLock(const MutexLock& lock) : theMutex(lock.theMutex) {}
+
+			/** the locked Mutex */
+			Mutex& theMutex ;
+
+	} ; /* class MutexLock */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_MUTEX_H_ */
@@ -45,6 +45,24 @@ namespace cutil
 			/** access modes for the NamedPipe */
 			enum AccessModeEnum { READ_ONLY_ENUM, WRITE_ONLY_ENUM, READ_WRITE_ENUM } ;
 
+			/**
+			 * Flags which may be or'ed together and passed to the splice, tee and vmsplice operations.
+			 * These correspond to the SPLICE_F_* kernel flags.
+			 */
+			enum TransferFlagsEnum
+			{
+				/** no flags */
+				TRANSFER_NONE_ENUM = 0x00,
+				/** attempt to move pages instead of copying */
+				TRANSFER_MOVE_ENUM = 0x01,
+				/** do not block on the pipe I/O */
+				TRANSFER_NONBLOCK_ENUM = 0x02,
+				/** more data will be coming in a subsequent transfer */
+				TRANSFER_MORE_ENUM = 0x04,
+				/** vmsplice only, gift the user pages to the kernel */
+				TRANSFER_GIFT_ENUM = 0x08
+			} ;
+
 			//-------------------------------------------------------------------------------//
 			// Constructor / Desctructor
 
@@ -101,6 +119,49 @@ namespace cutil
 			 */
 			void open() throw(NamedPipeException) ;
 
+			/**
+			 * Attempts to open this NamedPipe, waiting at most usec micro seconds for the peer to appear.
+			 * The NamedPipe is always opened without blocking the calling thread in the open system call.
+			 * A READ_ONLY_ENUM or READ_WRITE_ENUM NamedPipe opens immediately, a WRITE_ONLY_ENUM NamedPipe
+			 * cannot be opened until a reader has opened the FIFO, the calling thread sleeps on a filesystem
+			 * open notification for the FIFO. A reader opening the FIFO blocking raises no notification until
+			 * a writer arrives, so the open is also retried at a short interval while waiting.
+			 * Once opened, a NamedPipe set blocking is returned to blocking I/O.
+			 * A reader opened before any writer sees end of file from read until a writer opens the FIFO,
+			 * isDataAvailable may be used to wait for the first data.
+			 * If this NamedPipe is already open, no action is taken and true is returned.
+			 *
+			 * @param usec the maximum time to wait in micro seconds, a negative value waits indefinitely
+			 * @return true if this NamedPipe was opened, false if the deadline passed first
+			 * @throws NamedPipeException if an error occurs opening this NamedPipe
+			 */
+			bool open(long usec) throw(NamedPipeException) ;
+
+			/**
+			 * Makes a single non blocking attempt to open this NamedPipe.
+			 * This is intended to be called from an event loop when the descriptor returned by
+			 * getOpenNotifyDescriptor becomes readable. Any pending notifications are consumed.
+			 * If this NamedPipe is already open, no action is taken and true is returned.
+			 *
+			 * @return true if this NamedPipe was opened, false if the peer has not yet opened the FIFO
+			 * @throws NamedPipeException if an error occurs opening this NamedPipe
+			 */
+			bool tryOpen() throw(NamedPipeException) ;
+
+			/**
+			 * Returns a descriptor which becomes readable when the FIFO of this NamedPipe is opened by any process.
+			 * The descriptor may be added to a poll/select/epoll based reactor, tryOpen should be called whenever
+			 * it becomes readable. A reader blocked opening the FIFO raises no notification until its open
+			 * completes, so a writer should also retry tryOpen periodically.
+			 * The descriptor is owned by this NamedPipe and is released once this
+			 * NamedPipe has been opened, or closed.
+			 * This NamedPipe must have been created prior to calling this method.
+			 *
+			 * @return the open notification descriptor
+			 * @throws NamedPipeException if this NamedPipe has not been created, or the notification cannot be setup
+			 */
+			int getOpenNotifyDescriptor() throw(NamedPipeException) ;
+
 			/**
 			 * Closes this NamedPipe
 			 *
@@ -193,6 +254,103 @@ namespace cutil
 			 */
 			bool isOpen() const ;
 
+			/**
+			 * Returns the underlying file descriptor of this NamedPipe.
+			 * The descriptor is only valid while this NamedPipe is open, -1 is returned otherwise
+			 *
+			 * @return the file descriptor of this NamedPipe, or -1 if not open
+			 */
+			int getFileDescriptor() const ;
+
+			//-------------------------------------------------------------------------------//
+			// Pipe Capacity
+
+			/**
+			 * Sets the kernel buffer capacity of this open NamedPipe.
+			 * The kernel rounds the requested size up to a whole number of pages, and an unprivileged
+			 * process may not exceed /proc/sys/fs/pipe-max-size. Capacity is a property of the pipe,
+			 * not the descriptor, so the change is visible to both ends.
+			 *
+			 * @param capacity the requested capacity in bytes
+			 * @return the actual capacity set by the kernel
+			 * @throws NamedPipeException if this NamedPipe is not open, or the capacity cannot be set
+			 */
+			size_t setCapacity(size_t capacity) throw(NamedPipeException) ;
+
+			/**
+			 * Returns the current kernel buffer capacity of this open NamedPipe
+			 *
+			 * @return the capacity of this NamedPipe in bytes
+			 * @throws NamedPipeException if this NamedPipe is not open, or the capacity cannot be queried
+			 */
+			size_t getCapacity() const throw(NamedPipeException) ;
+
+			//-------------------------------------------------------------------------------//
+			// Zero Copy Transfer Operations
+
+			/**
+			 * Moves up to length bytes from this NamedPipe to the specified file descriptor without
+			 * copying the data through user space.
+			 * The destination may be a file, socket or another pipe, a file is written at its current offset.
+			 *
+			 * @param fd the destination file descriptor
+			 * @param length the maximum number of bytes to transfer
+			 * @param flags or'ed TransferFlagsEnum values
+			 * @return the number of bytes transferred, 0 indicating end of file
+			 * @throws NamedPipeException if this NamedPipe is not open, or the transfer fails
+			 */
+			ssize_t spliceTo(int fd, size_t length, int flags = TRANSFER_NONE_ENUM) throw(NamedPipeException) ;
+
+			/**
+			 * Moves up to length bytes from this NamedPipe into the specified NamedPipe
+			 *
+			 * @param dest the destination NamedPipe
+			 * @param length the maximum number of bytes to transfer
+			 * @param flags or'ed TransferFlagsEnum values
+			 * @return the number of bytes transferred, 0 indicating end of file
+			 * @throws NamedPipeException if either NamedPipe is not open, or the transfer fails
+			 */
+			ssize_t spliceTo(NamedPipe& dest, size_t length, int flags = TRANSFER_NONE_ENUM) throw(NamedPipeException) ;
+
+			/**
+			 * Moves up to length bytes from the specified file descriptor into this NamedPipe without
+			 * copying the data through user space.
+			 * The source may be a file, socket or another pipe, a file is read from its current offset.
+			 *
+			 * @param fd the source file descriptor
+			 * @param length the maximum number of bytes to transfer
+			 * @param flags or'ed TransferFlagsEnum values
+			 * @return the number of bytes transferred, 0 indicating end of file
+			 * @throws NamedPipeException if this NamedPipe is not open, or the transfer fails
+			 */
+			ssize_t spliceFrom(int fd, size_t length, int flags = TRANSFER_NONE_ENUM) throw(NamedPipeException) ;
+
+			/**
+			 * Duplicates up to length bytes from this NamedPipe into the specified NamedPipe.
+			 * The data is not consumed from this NamedPipe, allowing the same data to be fanned out
+			 * to several destinations before being spliced, or read, from this NamedPipe.
+			 *
+			 * @param dest the destination NamedPipe
+			 * @param length the maximum number of bytes to duplicate
+			 * @param flags or'ed TransferFlagsEnum values
+			 * @return the number of bytes duplicated
+			 * @throws NamedPipeException if either NamedPipe is not open, or the operation fails
+			 */
+			ssize_t tee(NamedPipe& dest, size_t length, int flags = TRANSFER_NONE_ENUM) throw(NamedPipeException) ;
+
+			/**
+			 * Maps the user memory region into this NamedPipe.
+			 * Unless TRANSFER_GIFT_ENUM is specified the kernel may still reference the memory after
+			 * this call returns, the caller must not modify the data until it has been consumed by the reader.
+			 *
+			 * @param data the data to map into this NamedPipe
+			 * @param size the number of bytes of data
+			 * @param flags or'ed TransferFlagsEnum values
+			 * @return the number of bytes mapped into this NamedPipe
+			 * @throws NamedPipeException if this NamedPipe is not open, or the operation fails
+			 */
+			ssize_t vmsplice(const void* data, size_t size, int flags = TRANSFER_NONE_ENUM) throw(NamedPipeException) ;
+
 			//-------------------------------------------------------------------------------//
 			// AbstractInputStream
 
@@ -232,6 +390,19 @@ namespace cutil
 			 */
 			NamedPipe(const NamedPipe&) : AbstractInputStream(), AbstractOutputStream() {}
 
+			/**
+			 * Returns the open flags for the access mode of this NamedPipe
+			 *
+			 * @return the open flags for the access mode of this NamedPipe
+			 */
+			int getOpenFlags() const ;
+
+			/**
+			 * Releases the open notification descriptor, if one has been setup
+			 *
+			 */
+			void releaseOpenNotify() ;
+
 			/** the filesysten path of this NamedPipe */
 			std::string m_file_system_path ;
 
@@ -247,6 +418,9 @@ namespace cutil
 			/** Inidicates the access mode of this NamedPipe */
 			AccessModeEnum m_access_mode ;
 
+			/** inotify descriptor used to wait for the peer to open the FIFO, -1 if not setup */
+			int m_notify_fd ;
+
 	} ; /* class NamedPipe */
 
 } /* namespace cutil */
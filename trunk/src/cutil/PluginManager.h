@@ -24,24 +24,45 @@
 
 #include <cutil/PluginInfo.h>
 #include <cutil/PluginManagerException.h>
+#include <cutil/PluginStatistics.h>
+#include <cutil/ReadWriteLock.h>
 #include <cutil/SharedLibraryException.h>
 
 #include <list>
-#include <map>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include <tr1/unordered_map>
+
+#include <pthread.h>
+#include <time.h>
 
 namespace cutil
 {
+	class FilePath ;
 	class Plugin ;
 	class PluginFactory ;
+	class PluginManifest ;
 	class PluginNameTransform ;
 	class SharedLibrary ;
+	class ThreadPool ;
+	template <class T> class PluginCall ;
 	template <class T> class PluginHandle ;
+	template <class T> class PluginResolver ;
 
 
 	/**
 	 * PluginManager provides management of loaded SharedLibraries / Plugins
 	 *
+	 * A PluginManager may be used concurrently from multiple threads. Lookups of
+	 * registered and loaded Plugins share a read lock, while registering, loading and
+	 * unloading Plugins is serialised by a write lock. Acquiring a handle to a loaded
+	 * Plugin looks it up within a published snapshot of the registry without locking.
+	 * SharedLibraries are opened and listed without holding the lock. Copying and
+	 * releasing a PluginHandle updates the reference count of its Plugin atomically,
+	 * without locking, unless the release drops the last reference and may unload the Plugin.
+	 *
 	 * The PluginManager maintains a reference count of each Plugin to ensure that
 	 * it is safe to delete Plugins and close SharedLibraries. Attempting to
 	 * unload a referenced Plugin will result in a PluginManagerException being thrown.
@@ -82,12 +103,26 @@ namespace cutil
 	class PluginManager
 	{
 		private:
+			template <class T> friend class PluginCall ;
+			template <class T> friend class PluginHandle ;
+			template <class T> friend class PluginResolver ;
+
+			struct SharedObjectRecord ;
+			class DiscoverModuleTask ;
+
 			/**
 			 * Internal struct detailing a registered Plugin 
 			 */
 			struct PluginRecord
 			{
-				PluginRecord() : thePlugin(0), theRemainLoadedFlag(false) {}
+				PluginRecord() : thePlugin(0), theSharedObjectRecord(0), theRemainLoadedFlag(false), theRefCount(0), theIdleTime(0), theRetiredFlag(false),
+						theRetiredEpoch(0), theLoadCount(0), theOpenTime(0), theFactoryTime(0), theCreateTime(0), theCallCount(0), theCallTime(0)
+				{
+					for(size_t i = 0 ; i < PluginStatistics::BUCKET_COUNT ; ++i)
+					{
+						theCallHistogram[i] = 0 ;
+					}
+				}
 
 				/** the id of the dynamically loadable module */
 				std::string theSharedObjectId ;
@@ -98,16 +133,39 @@ namespace cutil
 				/** the plugin */
 				Plugin* thePlugin ;
 
+				/** the record of the shared object the plugin was created from, set once loaded */
+				SharedObjectRecord* theSharedObjectRecord ;
+
 				/** indicates if this Plugin should remain loaded despite no references to it */
 				bool theRemainLoadedFlag ;
 
-				/** reference count for this Plugin */
-				int theRefCount ;
+				/** reference count for this Plugin, updated atomically */
+				volatile int theRefCount ;
+
+				/** the time, in seconds of the monotonic clock, at which the Plugin was loaded or last released, updated atomically */
+				time_t theIdleTime ;
+
+				/** indicates the Plugin has been replaced by a reload, and is destroyed once unreferenced */
+				bool theRetiredFlag ;
+
+				/** the epoch at which the record was removed from the registry */
+				unsigned long theRetiredEpoch ;
+
+				/** instrumented loads, and the timings in nanoseconds of the most recent */
+				unsigned long theLoadCount ;
+				unsigned long long theOpenTime ;
+				unsigned long long theFactoryTime ;
+				unsigned long long theCreateTime ;
+
+				/** the number, total latency in nanoseconds and histogram of instrumented calls, updated atomically */
+				volatile unsigned long theCallCount ;
+				volatile unsigned long long theCallTime ;
+				volatile unsigned long theCallHistogram[PluginStatistics::BUCKET_COUNT] ;
 			} ;
 
 			struct SharedObjectRecord
 			{
-				SharedObjectRecord() : theSharedObject(0), thePluginFactory(0), thePluginCreationCount(0) {}
+				SharedObjectRecord() : theSharedObject(0), thePluginFactory(0), thePluginCreationCount(0), theVersion(0) {}
 
 				/** the shared object from which Plugins are created */
 				SharedLibrary* theSharedObject ;
@@ -115,16 +173,93 @@ namespace cutil
 				/** the PluginFactory used to construct actual Plugin instances */
 				PluginFactory* thePluginFactory ;
 
-				/** count of the total number of plugins created via the SharedObject */
+				/** count of the loaded plugins created via the SharedObject */
 				int thePluginCreationCount ;
+
+				/** the number of times the module has been reloaded */
+				unsigned int theVersion ;
+
+				/** the path the SharedLibrary is opened from, the module unless replaced by a reload */
+				std::string thePath ;
+			} ;
+
+			/**
+			 * Result of opening and listing a SharedLibrary during concurrent registration
+			 */
+			struct ModuleDiscovery
+			{
+				ModuleDiscovery() : theLibrary(0), theFactory(0) {}
+
+				/** the SharedLibrary path */
+				std::string theModule ;
+
+				/** the opened SharedLibrary, 0 on failure */
+				SharedLibrary* theLibrary ;
+
+				/** the PluginFactory created from theLibrary */
+				PluginFactory* theFactory ;
+
+				/** the Plugins available through theFactory */
+				std::list<PluginInfo> thePlugins ;
+
+				/** the failure accessing the SharedLibrary, empty on success */
+				std::string theError ;
+			} ;
+
+			/**
+			 * The epoch in which a thread reads the registry without locking.
+			 * Each thread reading without locking claims a ReaderSlot of its own, so entering and
+			 * leaving a read writes only to the slot of the reading thread.
+			 */
+			struct ReaderSlot
+			{
+				ReaderSlot() : theEpoch(0), theOwnedFlag(0), theNext(0) {}
+
+				/** the epoch current as the read was entered, 0 while not reading */
+				volatile unsigned long theEpoch ;
+
+				/** non-zero while claimed by a thread */
+				volatile int theOwnedFlag ;
+
+				/** the next ReaderSlot of the PluginManager */
+				ReaderSlot* theNext ;
+
+				/** keeps the slots of different threads upon separate cache lines */
+				char thePadding[64] ;
 			} ;
 
-			typedef std::multimap<std::string, PluginManager::PluginRecord*> PluginContainer_t ;
-			typedef std::pair<std::string, PluginManager::PluginRecord*> PluginContPair_t ;
-			typedef std::pair<PluginContainer_t::iterator, PluginContainer_t::iterator> PluginRange_t ;
-			typedef std::pair<PluginContainer_t::const_iterator, PluginContainer_t::const_iterator> ConstPluginRange_t ;
+			/**
+			 * Key identifying a registered Plugin by its module and Plugin name
+			 */
+			struct PluginKey
+			{
+				PluginKey(const std::string& module, const std::string& name) : theModule(module), theName(name) {}
+
+				bool operator==(const PluginKey& key) const { return(theName == key.theName && theModule == key.theModule) ; }
+
+				/** the id of the dynamically loadable module */
+				std::string theModule ;
+
+				/** the name of the Plugin */
+				std::string theName ;
+			} ;
 
-			typedef std::map<std::string, SharedObjectRecord*> SharedObjectContainer_t ;
+			/**
+			 * Hash function of a PluginKey
+			 */
+			struct PluginKeyHash
+			{
+				size_t operator() (const PluginKey& key) const
+				{
+					std::tr1::hash<std::string> hasher ;
+					return(hasher(key.theName) * 31 + hasher(key.theModule)) ;
+				}
+			} ;
+
+			typedef std::tr1::unordered_map<PluginKey, PluginManager::PluginRecord*, PluginKeyHash> PluginContainer_t ;
+			typedef std::tr1::unordered_map<const Plugin*, PluginManager::PluginRecord*> PluginIndex_t ;
+
+			typedef std::tr1::unordered_map<std::string, SharedObjectRecord*> SharedObjectContainer_t ;
 
 		public:
 			//-------------------------------------------------------------------------------//
@@ -171,6 +306,24 @@ namespace cutil
 			 */
 			const PluginNameTransform* getNameTransform() const ;
 
+			/**
+			 * Sets the PluginManifest used to register the Plugins of unchanged modules without opening them.
+			 * Modules opened to list their Plugins are recorded within the PluginManifest, which the caller
+			 * may then save. The PluginManifest remains owned by the caller. Any previously set
+			 * PluginManifest is returned.
+			 *
+			 * @param manifest the PluginManifest to use, or 0 to always open modules
+			 * @return the previously set PluginManifest, if one has been set.
+			 */
+			PluginManifest* setManifest(PluginManifest* manifest) ;
+
+			/**
+			 * Returns the set PluginManifest
+			 *
+			 * @return the set PluginManifest, or 0 if none has been set
+			 */
+			const PluginManifest* getManifest() const ;
+
 			/**
 			 * Sets whether unloaded Plugins are automatically loaded during named Plugin access
 			 * With this flag set, Plugins which are unloaded, or unregistred are automatically
@@ -214,6 +367,90 @@ namespace cutil
 			 */
 			bool getRemainLoaded(const std::string name) ;
 
+			/**
+			 * Sets how long an idle Plugin remains loaded.
+			 * A Plugin is idle once only the reference held by this PluginManager remains, and it
+			 * is not to remain loaded. With a timeout of 0, the default, an idle Plugin is unloaded
+			 * as soon as its last reference is released. With a positive timeout, an idle Plugin
+			 * remains loaded, so can be referenced again without reloading, until it has been idle
+			 * for at least timeout seconds. With a negative timeout, idle Plugins remain loaded until
+			 * evicted to meet the memory budget.
+			 * Expired Plugins are evicted when Plugins are loaded, when released if no other thread
+			 * holds the lock, and by evictIdle.
+			 *
+			 * @param timeout the number of seconds an idle Plugin remains loaded
+			 */
+			void setIdleTimeout(long timeout) ;
+
+			/**
+			 * Returns how long an idle Plugin remains loaded
+			 *
+			 * @see setIdleTimeout
+			 * @return the number of seconds an idle Plugin remains loaded
+			 */
+			long getIdleTimeout() const ;
+
+			/**
+			 * Sets the memory budget of the open SharedLibraries.
+			 * Once the mapped size of the open SharedLibraries exceeds the budget, SharedLibraries
+			 * without loaded Plugins are closed, followed by the SharedLibraries whose loaded Plugins
+			 * are all idle, least recently used first, until the budget is met. Referenced Plugins and
+			 * Plugins to remain loaded are never evicted, so the budget may still be exceeded.
+			 * The budget is enforced when Plugins are loaded or released, and by evictIdle.
+			 *
+			 * @see SharedLibrary::getMappedSize
+			 * @param budget the memory budget in bytes, 0 for no budget
+			 */
+			void setMemoryBudget(size_t budget) ;
+
+			/**
+			 * Returns the memory budget of the open SharedLibraries
+			 *
+			 * @see setMemoryBudget
+			 * @return the memory budget in bytes, 0 if there is no budget
+			 */
+			size_t getMemoryBudget() const ;
+
+			/**
+			 * Returns the total mapped size of the SharedLibraries currently open
+			 *
+			 * @see SharedLibrary::getMappedSize
+			 * @return the mapped size of the open SharedLibraries in bytes
+			 */
+			size_t getMemoryUsage() const ;
+
+			/**
+			 * Unloads the idle Plugins which have exceeded the idle timeout, then evicts
+			 * idle SharedLibraries to meet the memory budget.
+			 * Applications using an idle timeout may call this periodically, so idle Plugins
+			 * are unloaded without waiting for other Plugins to be loaded or released.
+			 *
+			 * @return the number of Plugins unloaded
+			 * @throw SharedLibraryException if there is an error accessing a SharedLibrary
+			 * @throw PluginManagerException if a Plugin cannot be unloaded
+			 */
+			size_t evictIdle() throw(SharedLibraryException, PluginManagerException) ;
+
+			/**
+			 * Sets whether this PluginManager records instrumentation of its Plugins.
+			 * While instrumented, the time taken to open the SharedLibrary, create the
+			 * PluginFactory and create the Plugin is recorded as each Plugin is loaded, and
+			 * the latency of each call made through a PluginHandle is counted in a histogram
+			 * of the Plugin. Instrumentation is disabled by default, when calls through a
+			 * PluginHandle are not timed.
+			 *
+			 * @see getStatistics
+			 * @param instrumented set true to record instrumentation
+			 */
+			void setInstrumented(bool instrumented) ;
+
+			/**
+			 * Returns whether this PluginManager records instrumentation of its Plugins
+			 *
+			 * @return true if instrumentation is recorded, false otherwise
+			 */
+			bool getInstrumented() const ;
+
 			//-------------------------------------------------------------------------------//
 			// PluginManager Operations
 
@@ -247,6 +484,36 @@ namespace cutil
 			 */
 			void registerPlugins(const std::string& module) throw(SharedLibraryException, PluginManagerException) ;
 
+			/**
+			 * Registers all Plugins contained within each of the specified SharedLibraries.
+			 * The SharedLibraries are opened, and their Plugins listed, concurrently on the specified
+			 * ThreadPool, the results are then registered in module order, so the registry does not
+			 * depend upon the order in which the SharedLibraries complete. Each SharedLibrary remains
+			 * open with its PluginFactory, ready for its Plugins to be loaded.
+			 * If any SharedLibrary cannot be accessed, the Plugins of the remaining SharedLibraries
+			 * are registered before the failure of the first such module is thrown.
+			 *
+			 * @param modules the SharedLibraries to register
+			 * @param pool the ThreadPool on which to open the SharedLibraries
+			 * @throw SharedLibraryException if there is an error accessing any of the SharedObjects
+			 */
+			void registerPlugins(const std::vector<std::string>& modules, ThreadPool& pool) throw(SharedLibraryException, PluginManagerException) ;
+
+			/**
+			 * Registers all Plugins contained within the SharedLibraries of the specified directory.
+			 * Each regular file within directory whose name ends with suffix is registered as with
+			 * registerPlugins, on the specified ThreadPool.
+			 *
+			 * @param directory the directory containing the SharedLibraries
+			 * @param pool the ThreadPool on which to open the SharedLibraries
+			 * @param modules populated with the sorted paths of the discovered SharedLibraries
+			 * @param suffix the file name suffix of SharedLibraries
+			 * @return modules populated
+			 * @throw SharedLibraryException if there is an error accessing any of the SharedObjects
+			 * @throw PluginManagerException if the directory cannot be listed
+			 */
+			std::vector<std::string>& registerDirectory(const FilePath& directory, ThreadPool& pool, std::vector<std::string>& modules, const std::string& suffix = ".so") throw(SharedLibraryException, PluginManagerException) ;
+
 			/**
 			 * Registers the named plugin within the specified SharedLibrary.
 			 * The Plugin is not loaded until loadPlugin is called, or, if
@@ -324,6 +591,8 @@ namespace cutil
 			 * to be loaded, and is searched in the usual system manner.
 			 * The name parameter represents the name of a Plugin available through the
 			 * specified SharedObject.
+			 * The SharedLibrary is opened, and the Plugin created, without holding the lock,
+			 * so other Plugins remain accessible meanwhile.
 			 *
 			 * @param module the SharedLibrary to load
 			 * @param name the Plugin to load
@@ -344,6 +613,19 @@ namespace cutil
 			 */
 			bool loadPlugin(const std::string& name) throw(SharedLibraryException, PluginManagerException) ;
 
+			/**
+			 * Loads the named Plugins in the background on the specified ThreadPool.
+			 * Each application named Plugin is loaded as with loadPlugin, so that it is already
+			 * loaded when first accessed. Failures to load a Plugin are discarded, the Plugin is
+			 * then loaded, or the failure reported, on first access as usual. The ThreadPool must
+			 * complete the queued loads before this PluginManager is destroyed.
+			 *
+			 * @param names the application names of the Plugins to load
+			 * @param pool the ThreadPool on which to load the Plugins
+			 * @param remainLoaded set true to keep the loaded Plugins loaded, as with setRemainLoaded
+			 */
+			void prewarm(const std::vector<std::string>& names, ThreadPool& pool, bool remainLoaded = true) ;
+
 
 			/**
 			 * Returns whether the named plugin has been loaded.
@@ -477,6 +759,79 @@ namespace cutil
 			void unregisterAll() throw(SharedLibraryException, PluginManagerException) ;
 
 
+			// Plugin Reloading
+
+			/**
+			 * Replaces the SharedLibrary from which the Plugins of module are created, without unloading them.
+			 * The replacement is opened at path alongside the current version, without holding the
+			 * lock, so requests continue to be served meanwhile. A new instance of each loaded Plugin
+			 * is then created from the replacement, and subsequent accesses of the Plugin, through
+			 * getPlugin, PluginHandles and PluginResolvers, return the new instance. Existing
+			 * references continue to use the previous instance, which is retired: it is destroyed once
+			 * its last reference is released, and the previous SharedLibrary closed once all its
+			 * retired Plugins are destroyed.
+			 * The Plugins remain registered under module. Registered Plugins not offered by the
+			 * replacement are unregistered. If the replacement cannot be opened, or a Plugin cannot
+			 * be created from it, the current version remains in place.
+			 * The dynamic linker shares a module already open under the same path, so a replacement
+			 * of a module in use should be installed under a new path, such as a versioned file name.
+			 *
+			 * @param module the SharedLibrary, as registered, of the Plugins to reload
+			 * @param path the path of the replacement SharedLibrary
+			 * @throw SharedLibraryException if there is an error accessing the replacement SharedLibrary
+			 * @throw PluginManagerException if the replacement provides no PluginFactory, or a loaded
+			 *        Plugin cannot be created from it
+			 */
+			void reloadModule(const std::string& module, const std::string& path) throw(SharedLibraryException, PluginManagerException) ;
+
+			/**
+			 * Returns the number of times the specified module has been reloaded
+			 *
+			 * @see reloadModule
+			 * @param module the SharedLibrary, as registered
+			 * @return the version of module, 0 if never reloaded or not known
+			 */
+			unsigned int getModuleVersion(const std::string& module) const ;
+
+			/**
+			 * Returns the number of retired Plugin instances still referenced.
+			 * Retired Plugins are those replaced by reloadModule, and are destroyed once
+			 * their last reference is released.
+			 *
+			 * @see reloadModule
+			 * @return the number of retired Plugins not yet destroyed
+			 */
+			size_t getRetiredCount() const ;
+
+			/**
+			 * Returns a snapshot of the instrumentation of each registered Plugin.
+			 * Counters are read without stopping concurrent calls, so calls completing while
+			 * the snapshot is taken may be partially counted.
+			 *
+			 * @see setInstrumented
+			 * @param statistics populated with the PluginStatistics of each registered Plugin
+			 * @return statistics populated
+			 */
+			std::list<PluginStatistics>& getStatistics(std::list<PluginStatistics>& statistics) const ;
+
+			/**
+			 * Returns a snapshot of the instrumentation of the specified Plugin
+			 *
+			 * @see setInstrumented
+			 * @param module the SharedLibrary of the Plugin
+			 * @param name the Plugin name
+			 * @param statistics populated with the PluginStatistics of the Plugin
+			 * @return true if the Plugin is registered, false otherwise
+			 */
+			bool getStatistics(const std::string& module, const std::string& name, PluginStatistics& statistics) const ;
+
+			/**
+			 * Clears the recorded load timings and calls of every registered Plugin
+			 *
+			 */
+			void resetStatistics() ;
+
+
 			// Plugin Access
 
 			/**
@@ -563,8 +918,8 @@ namespace cutil
 			/**
 			 * Decrements the use count of the specified Plugin by one.
 			 * The reference count of the Plugin is automatically handled
-			 * by the PluginHandle class. The Plugin use count of the
-			 * ShreadLibrary containing the Plugin is decremented by one.
+			 * by the PluginHandle class. If only the reference held by this
+			 * PluginManager remains, the Plugin is unloaded unless it is to remain loaded.
 			 * This method is an internal reference counting method used by
 			 * the PluginHandle class to maintain reference counts of used Plugins.
 			 *
@@ -575,8 +930,7 @@ namespace cutil
 			/**
 			 * Increments the use count of the specified Plugin by one.
 			 * The reference count of the Plugin is automatically handled
-			 * by the PluginHandle class. The Plugin use count of the
-			 * ShreadLibrary containing the Plugin is Incremented by one.
+			 * by the PluginHandle class.
 			 * This method is an internal reference counting method used by
 			 * the PluginHandle class to maintain reference counts of used Plugins.
 			 *
@@ -605,28 +959,6 @@ namespace cutil
 			// nested algorithm classes
 			//
 
-			class PluginRecModuleEq : public std::unary_function<PluginContPair_t, bool>
-			{
-				public:
-					PluginRecModuleEq(const std::string& module) ;
-
-					result_type operator() (const argument_type a) const ;
-				protected:
-				private:
-					std::string theModule ;
-			} ;
-
-			class PluginRecPluginEq : public std::unary_function<PluginContPair_t, bool>
-			{
-				public:
-					PluginRecPluginEq(const Plugin& plugin) ;
-
-					result_type operator() (const argument_type a) const ;
-				protected:
-				private:
-					const Plugin& thePlugin ;
-			} ;
-
 			class PluginInfoNameEq : public std::unary_function<PluginInfo, bool>
 			{
 				public:
@@ -660,6 +992,15 @@ namespace cutil
 			 */
 			PluginRecord* getPluginRecord(const Plugin& plugin) const ;
 
+			/**
+			 * Creates and registers the PluginRecord for the specified Plugin
+			 *
+			 * @param module the SharedLibrary containing the Plugin
+			 * @param info the PluginInfo of the Plugin
+			 * @return the new PluginRecord
+			 */
+			PluginRecord* addPluginRecord(const std::string& module, const PluginInfo& info) ;
+
 			/**
 			 * Accesses the registered SharedLibraries and returns the SharedObjectRecord for the specified SharedLibrary
 			 *
@@ -728,6 +1069,288 @@ namespace cutil
 			 */
 			PluginFactory* getPluginFactory(const std::string& module) throw (SharedLibraryException) ;
 
+			/**
+			 * Opens the SharedLibrary of the specified ModuleDiscovery and lists its Plugins.
+			 * This accesses no PluginManager state, so may be called concurrently without locking.
+			 *
+			 * @param discovery the ModuleDiscovery to populate
+			 */
+			void discoverModule(ModuleDiscovery& discovery) const ;
+
+			/**
+			 * Opens the specified SharedLibrary, if not already open, and lists its Plugins.
+			 * Any SharedLibrary opened, and PluginFactory created, only to list the Plugins is released.
+			 *
+			 * @param module the SharedLibrary path
+			 * @param pluginList populated with the Plugins available through module
+			 * @return pluginList populated
+			 * @throw SharedLibraryException if there is an error accessing the SharedLibrary
+			 */
+			std::list<PluginInfo>& listPlugins(const std::string& module, std::list<PluginInfo>& pluginList) const throw(SharedLibraryException) ;
+
+			/**
+			 * Transforms an application Plugin name into its SharedLibrary and Plugin name.
+			 * The PluginNameTransform is accessed under the read lock, so it is not replaced during
+			 * the lookup, the names are copied so the caller continues without the lock.
+			 *
+			 * @param name the application specific Plugin name
+			 * @param module populated with the SharedLibrary of the Plugin
+			 * @param plugin populated with the Plugin name
+			 * @param required set true to throw if no PluginNameTransform is set, otherwise false is returned
+			 * @return true if the PluginNameTransform transforms name, false otherwise
+			 * @throw PluginManagerException if required and no PluginNameTransform is set
+			 */
+			bool transformName(const std::string& name, std::string& module, std::string& plugin, bool required) const throw(PluginManagerException) ;
+
+
+			//
+			// Reference Counting
+			//
+
+			/**
+			 * Returns the PluginRecord of the specified Plugin with its reference count incremented by one.
+			 * The Plugin is loaded if it is not loaded and auto loading is enabled.
+			 *
+			 * @param module the SharedLibrary containing the Plugin
+			 * @param name the Plugin name
+			 * @return the referenced PluginRecord
+			 * @throw SharedLibraryException if there is an error accessing the SharedLibrary
+			 * @throw PluginManagerException if the Plugin is not registered or cannot be loaded
+			 */
+			PluginRecord* acquirePlugin(const std::string& module, const std::string& name) throw(SharedLibraryException, PluginManagerException) ;
+
+			/**
+			 * Returns the PluginRecord of the Plugin with the specified application name
+			 * with its reference count incremented by one.
+			 *
+			 * @param name the application specific Plugin name
+			 * @return the referenced PluginRecord
+			 * @throw SharedLibraryException if there is an error accessing the SharedLibrary
+			 * @throw PluginManagerException if the name cannot be transformed or the Plugin cannot be loaded
+			 */
+			PluginRecord* acquirePlugin(const std::string& name) throw(SharedLibraryException, PluginManagerException) ;
+
+			/**
+			 * Returns the PluginRecord of the specified loaded Plugin with its reference count incremented by one.
+			 *
+			 * @param plugin the Plugin to reference
+			 * @return the referenced PluginRecord, or 0 if the Plugin is not loaded by this PluginManager
+			 */
+			PluginRecord* acquirePlugin(const Plugin& plugin) ;
+
+			/**
+			 * Increments the reference count of a PluginRecord already referenced by the caller.
+			 * This is lock free, an existing reference prevents the Plugin being unloaded.
+			 *
+			 * @param prec the PluginRecord to reference
+			 */
+			static void refRecord(PluginRecord* prec) ;
+
+			/**
+			 * Increments the reference count of a PluginRecord found without locking, unless it has
+			 * dropped to zero. A loaded Plugin is referenced by this PluginManager, so the count is
+			 * zero only once the Plugin is being unloaded, when it must not be referenced again.
+			 *
+			 * @param prec the PluginRecord to reference
+			 * @return true if the PluginRecord was referenced, false otherwise
+			 */
+			static bool tryRefRecord(PluginRecord* prec) ;
+
+			/**
+			 * Decrements the reference count of the specified PluginRecord.
+			 * The reference count is decremented without locking unless the release
+			 * leaves only the reference held by this PluginManager, in which case the
+			 * Plugin is unloaded under the write lock if it is not to remain loaded.
+			 * With an idle timeout the Plugin instead becomes idle without locking, and
+			 * expired Plugins are evicted only if the write lock is free, otherwise by a
+			 * later release or evictIdle.
+			 *
+			 * @param prec the PluginRecord to release
+			 */
+			void releaseRecord(PluginRecord* prec) ;
+
+			/**
+			 * Decrements the reference count of a PluginRecord referenced only to test its validity.
+			 * A retired Plugin is destroyed if this was its last reference, and a Plugin whose
+			 * unload was skipped while this reference was held is unloaded.
+			 *
+			 * @param prec the PluginRecord to release
+			 */
+			void dropRecord(PluginRecord* prec) ;
+
+			/**
+			 * Unloads the Plugin of the specified PluginRecord if only this PluginManager references it.
+			 * Resolved Plugins are invalidated before the reference count is tested, a PluginResolver
+			 * referencing the Plugin meanwhile leaves it loaded, to be unloaded when that reference
+			 * is dropped. The write lock must be held.
+			 *
+			 * @param prec the PluginRecord of the loaded Plugin
+			 * @return true if the Plugin was unloaded, false otherwise
+			 * @throw SharedLibraryException if there is an error accessing the SharedObject
+			 * @throw PluginManagerException if the PluginFactory cannot be accessed
+			 */
+			bool unloadUnreferenced(PluginRecord* prec) throw(SharedLibraryException, PluginManagerException) ;
+
+			/**
+			 * Destroys the Plugin of the specified PluginRecord, whose references have all been
+			 * released, closing its SharedLibrary if it was the last Plugin created from it.
+			 * The write lock must be held.
+			 *
+			 * @param prec the PluginRecord of the unreferenced Plugin
+			 * @throw SharedLibraryException if there is an error closing the SharedLibrary
+			 * @throw PluginManagerException if the SharedLibrary cannot be unloaded
+			 */
+			void destroyPlugin(PluginRecord* prec) throw(SharedLibraryException, PluginManagerException) ;
+
+			/**
+			 * Releases a Plugin created from, or a reservation of, the PluginFactory of the specified
+			 * SharedObjectRecord. The SharedLibrary is closed once no Plugins created from it remain,
+			 * whether still current or retired by a reload. The write lock must be held.
+			 *
+			 * @param soRec the SharedObjectRecord of the PluginFactory
+			 * @param module the SharedLibrary, as registered
+			 * @throw SharedLibraryException if there is an error closing the SharedLibrary
+			 * @throw PluginManagerException if the SharedLibrary cannot be unloaded
+			 */
+			void releaseFactory(SharedObjectRecord* soRec, const std::string& module) throw(SharedLibraryException, PluginManagerException) ;
+
+			//-------------------------------------------------------------------------------//
+			// Retirement
+
+			/**
+			 * Retires the specified loaded Plugin, replaced by a reload.
+			 * The reference held by this PluginManager is released, and the Plugin destroyed
+			 * if no other references remain. The write lock must be held.
+			 *
+			 * @param prec the PluginRecord to retire
+			 * @throw SharedLibraryException if there is an error destroying the Plugin
+			 */
+			void retirePlugin(PluginRecord* prec) throw(SharedLibraryException) ;
+
+			/**
+			 * Destroys an unreferenced retired Plugin, closing its SharedLibrary if it was the last
+			 * Plugin created from it. The write lock must be held.
+			 *
+			 * @param prec the PluginRecord of the retired Plugin
+			 * @throw SharedLibraryException if there is an error destroying the Plugin or closing the SharedLibrary
+			 */
+			void destroyRetiredPlugin(PluginRecord* prec) throw(SharedLibraryException) ;
+
+			/**
+			 * Closes a retired SharedLibrary once no Plugins created from it remain, releasing its
+			 * PluginFactory and removing it from the retired SharedObjectRecords. The write lock must be held.
+			 *
+			 * @param soRec the retired SharedObjectRecord
+			 * @throw SharedLibraryException if there is an error closing the SharedLibrary
+			 */
+			void closeRetiredSharedLibrary(SharedObjectRecord* soRec) throw(SharedLibraryException) ;
+
+			/**
+			 * Removes the specified PluginRecord from the registry, retaining it until no PluginResolver
+			 * or lock free lookup can still refer to it. The write lock must be held.
+			 *
+			 * @param prec the PluginRecord to retire
+			 */
+			void retireRecord(PluginRecord* prec) ;
+
+			/**
+			 * Frees the retired PluginRecords whose Plugins have been destroyed and are no longer
+			 * referenced, and the retired snapshots of the registry. Neither is freed while a thread
+			 * which entered a lock free read, to look up a Plugin or test a resolved record, before its
+			 * retirement is still reading, those are freed by a later call.
+			 * Takes the write lock.
+			 */
+			void reclaimRetiredRecords() ;
+
+			//-------------------------------------------------------------------------------//
+			// Lock Free Lookup
+
+			/**
+			 * Enters a lock free read of the registry by the calling thread. Records and snapshots
+			 * retired from now on are not freed until the matching leaveRead. Reads must not be nested.
+			 *
+			 * @return the ReaderSlot of the calling thread, to pass to leaveRead
+			 */
+			ReaderSlot* enterRead() ;
+
+			/**
+			 * Leaves the lock free read entered by enterRead
+			 *
+			 * @param slot the ReaderSlot returned by enterRead
+			 */
+			static void leaveRead(ReaderSlot* slot) ;
+
+			/**
+			 * Claims a ReaderSlot for the calling thread, reusing the slot of an exited thread if one is free
+			 *
+			 * @return the claimed ReaderSlot
+			 */
+			ReaderSlot* claimReaderSlot() ;
+
+			/**
+			 * Frees the ReaderSlot of an exiting thread for another to claim
+			 *
+			 * @param slot the ReaderSlot of the exiting thread
+			 */
+			static void releaseReaderSlot(void* slot) ;
+
+			/**
+			 * Returns the oldest epoch in which a thread is still reading without locking. Anything
+			 * retired at an earlier epoch can no longer be reached by a reader.
+			 *
+			 * @return the oldest epoch still being read, or the current epoch if no thread is reading
+			 */
+			unsigned long getReadEpoch() const ;
+
+			/**
+			 * Publishes a snapshot of the registered Plugins, if none is published, for lock free lookup.
+			 * The read or write lock must be held.
+			 */
+			void publishSnapshot() ;
+
+			/**
+			 * Withdraws the published snapshot of the registered Plugins, as the registry has changed.
+			 * The next locked lookup publishes a new snapshot. The write lock must be held.
+			 */
+			void invalidateSnapshot() ;
+
+			//-------------------------------------------------------------------------------//
+			// Eviction
+
+			/**
+			 * Unloads the idle Plugins which have exceeded the idle timeout, then evicts
+			 * idle SharedLibraries to meet the memory budget.
+			 *
+			 * @param keep a Plugin not to evict, although idle, or 0
+			 * @return the number of Plugins unloaded
+			 * @throw SharedLibraryException if there is an error accessing a SharedLibrary
+			 * @throw PluginManagerException if a Plugin cannot be unloaded
+			 */
+			size_t evictPlugins(const PluginRecord* keep) throw(SharedLibraryException, PluginManagerException) ;
+
+			/**
+			 * Populates a PluginStatistics snapshot from the specified PluginRecord.
+			 * The read or write lock must be held.
+			 *
+			 * @param prec the PluginRecord
+			 * @param statistics populated from prec
+			 */
+			static void copyStatistics(const PluginRecord* prec, PluginStatistics& statistics) ;
+
+			/**
+			 * Returns the current time of the monotonic clock, in nanoseconds
+			 */
+			static unsigned long long monotonicTime() ;
+
+			/**
+			 * Records a call made through a PluginHandle to the Plugin of the specified PluginRecord,
+			 * taking the latency of the call as the time since start. This is lock free.
+			 *
+			 * @param prec the referenced PluginRecord of the called Plugin
+			 * @param start the monotonicTime at which the call was made
+			 */
+			static void recordCall(PluginRecord* prec, unsigned long long start) ;
+
 
 
 
@@ -738,9 +1361,12 @@ namespace cutil
 			// member data
 			//
 
-			/** contains the currently registred plugin data */
+			/** contains the currently registred plugin data, by module and Plugin name */
 			PluginContainer_t thePlugins ;
 
+			/** the registered plugin data of each loaded Plugin */
+			PluginIndex_t theLoadedPlugins ;
+
 			/** contains all opened shared objects */
 			SharedObjectContainer_t theSharedObjects ;
 
@@ -750,6 +1376,51 @@ namespace cutil
 			/** used to transform logical Plugins names to physical modules/Plugin names */
 			PluginNameTransform* theNameTransform ;
 
+			/** records the Plugins of modules, so unchanged modules need not be opened to register them */
+			PluginManifest* theManifest ;
+
+			/** guards the registered plugin, loaded plugin and shared object data */
+			mutable ReadWriteLock theLock ;
+
+			/** PluginRecords removed by unregistering or reloading, retained until no PluginResolver can still refer to them */
+			std::vector<PluginRecord*> theRetiredRecords ;
+
+			/** an immutable copy of thePlugins, looked up without locking, 0 while being republished after a change */
+			const PluginContainer_t* volatile theSnapshot ;
+
+			/** withdrawn snapshots, with the epoch of their withdrawal, retained until no lock free lookup can still read them */
+			std::vector<std::pair<unsigned long, const PluginContainer_t*> > theRetiredSnapshots ;
+
+			/** the reclamation epoch, advanced as PluginRecords and snapshots are retired */
+			volatile unsigned long theEpoch ;
+
+			/** the ReaderSlots of the threads which have read without locking, added atomically */
+			ReaderSlot* volatile theReaderSlots ;
+
+			/** the key of the ReaderSlot claimed by each thread */
+			pthread_key_t theReaderKey ;
+
+			/** the number of retired Plugins not yet destroyed */
+			size_t theRetiredCount ;
+
+			/** SharedObjectRecords replaced by reloading, retained until their retired Plugins are destroyed */
+			std::vector<SharedObjectRecord*> theRetiredSharedObjects ;
+
+			/** incremented when a Plugin is unloaded or the name transform changes, invalidating resolved Plugins */
+			volatile unsigned long theGeneration ;
+
+			/** the number of seconds idle Plugins remain loaded, negative to remain until evicted */
+			long theIdleTimeout ;
+
+			/** the memory budget of the open SharedLibraries in bytes, 0 for no budget */
+			size_t theMemoryBudget ;
+
+			/** the time, in seconds of the monotonic clock, at which idle Plugins were last evicted, updated atomically */
+			time_t theEvictionTime ;
+
+			/** indicates Plugin loads and calls are instrumented */
+			volatile bool theInstrumentedFlag ;
+
 			// typedefs for function pointer to create and destroy a PluginFactory
 			typedef PluginFactory* (*createPluginFactoryFunc)(void) ;
 			typedef void (*releasePluginFactoryFunc)(PluginFactory*) ;
@@ -758,6 +1429,77 @@ namespace cutil
 	} ; /* class SharedLibrary */
 
 
+	/**
+	 * PluginCall is the temporary returned by PluginHandle::operator->, through which a
+	 * call to the handled Plugin is made.
+	 * When the PluginManager is instrumented, the PluginCall records the latency of the call
+	 * on its destruction, at the end of the full expression containing the call. Otherwise it
+	 * only forwards the Plugin pointer.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	template <class T>
+	class PluginCall
+	{
+		public:
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Constructs a PluginCall to the specified Plugin
+			 *
+			 * @param plugin the called Plugin
+			 * @param record the referenced record of the Plugin, if the call is to be timed, otherwise 0
+			 */
+			PluginCall(T* plugin, PluginManager::PluginRecord* record) ;
+
+			/**
+			 * Constructs a copy of the specified PluginCall, taking over the timing of the call
+			 *
+			 */
+			PluginCall(const PluginCall<T>& call) ;
+
+			/**
+			 * Destructor, records the call if timed
+			 *
+			 */
+			~PluginCall() ;
+
+			//---------------------------------------------------------------------------------------//
+			// Accessors / Mutators
+
+			/**
+			 * Returns a pointer to the called Plugin
+			 *
+			 * @return a pointer to the called Plugin
+			 */
+			T* operator->() const ;
+
+			//---------------------------------------------------------------------------------------//
+
+		protected:
+
+			//---------------------------------------------------------------------------------------//
+
+		private:
+			/**
+			 * Disallow assignment
+			 */
+			PluginCall<T>& operator=(const PluginCall<T>&) { return(*this) ; }
+
+			/** the called Plugin */
+			T* thePlugin ;
+
+			/** the record the call is recorded against, 0 if the call is not timed */
+			mutable PluginManager::PluginRecord* theRecord ;
+
+			/** the time the call started */
+			unsigned long long theStartTime ;
+	} ;
+
+
+
 	/**
 	 * PluginHandle provides a smart handle to a Plugin.
 	 * The PluginHandle aurtomatically handling reference and unreferencing the Plugin
@@ -804,16 +1546,29 @@ namespace cutil
 			 */
 			~PluginHandle() ;
 
+			/**
+			 * Assigns the Plugin and PluginManager of the specified PluginHandle to this PluginHandle.
+			 * The reference count of any previously handled Plugin is decremented and that of
+			 * the newly handled Plugin incremented.
+			 *
+			 * @param handle the PluginHandle to assign to this PluginHandle
+			 * @return this PluginHandle
+			 */
+			PluginHandle<T>& operator=(const PluginHandle<T>& handle) ;
+
 
 			//---------------------------------------------------------------------------------------//
 			// Accessors / Mutators
 
 			/**
-			 * Returns a pointer to the handled Plugin
+			 * Returns a PluginCall to the handled Plugin, which in turn provides a pointer to the
+			 * Plugin. If the managing PluginManager is instrumented, the latency of the call is
+			 * recorded once the full expression completes.
 			 *
-			 * @return a pointer to the handled Plugin
+			 * @see PluginManager::setInstrumented
+			 * @return a PluginCall to the handled Plugin
 			 */ 
-			T* operator->() const ;
+			PluginCall<T> operator->() const ;
 
 			/**
 			 * Binds the specified Plugin and PluginManager to this PluginHandle
@@ -875,12 +1630,118 @@ namespace cutil
 			//---------------------------------------------------------------------------------------//
 
 		private:
+			friend class PluginManager ;
+			template <class U> friend class PluginResolver ;
+
+			/**
+			 * Binds the specified Plugin to this invalid PluginHandle, taking ownership of
+			 * a reference already acquired from the PluginManager
+			 *
+			 * @param plugin the Plugin to handle
+			 * @param pluginManager the PluginManager managing the Plugin
+			 * @param record the referenced record of the Plugin
+			 */
+			void adopt(T& plugin, PluginManager& pluginManager, PluginManager::PluginRecord* record) ;
 
 			/** the (possibly derived) Plugin */
 			T* thePlugin ;
 
 			/** The PluginManager managing the Plugin */
 			PluginManager* theManager ;
+
+			/** the referenced record of the Plugin within theManager, 0 if the Plugin is not managed */
+			PluginManager::PluginRecord* theRecord ;
+	} ;
+
+
+
+
+	/**
+	 * PluginResolver caches the resolution of a named Plugin to a PluginHandle of a specific type.
+	 * The first call to getHandle looks up the Plugin within the PluginManager, through the
+	 * PluginNameTransform if constructed with an application name, and casts it to T. Subsequent
+	 * calls return a PluginHandle to the cached Plugin after checking the generation of the
+	 * PluginManager, which changes whenever a Plugin is unloaded or the name transform is replaced.
+	 * The check is made within a lock free read of the PluginManager, which publishes the epoch
+	 * of the calling thread in its own ReaderSlot rather than counting readers, so the steady
+	 * state cost of getHandle is a generation check and an atomic increment of the Plugin
+	 * reference count, and touches no state shared with other threads resolving other Plugins.
+	 * A PluginResolver holds no reference to the Plugin, so does not prevent it being unloaded.
+	 * A PluginResolver is not itself thread safe, each thread should resolve through its own instance.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	template <class T>
+	class PluginResolver
+	{
+		public:
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Constructs a new PluginResolver for the Plugin with the specified application name,
+			 * transformed by the PluginNameTransform of the PluginManager
+			 *
+			 * @param pluginManager the PluginManager managing the Plugin
+			 * @param name the application specific Plugin name
+			 */
+			PluginResolver(PluginManager& pluginManager, const std::string& name) ;
+
+			/**
+			 * Constructs a new PluginResolver for the specified Plugin
+			 *
+			 * @param pluginManager the PluginManager managing the Plugin
+			 * @param module the SharedLibrary containing the Plugin
+			 * @param name the Plugin name
+			 */
+			PluginResolver(PluginManager& pluginManager, const std::string& module, const std::string& name) ;
+
+
+			//-------------------------------------------------------------------------------//
+			// Accessors
+
+			/**
+			 * Returns a PluginHandle to the resolved Plugin.
+			 * If the Plugin does not match the type T, an invalid PluginHandle is returned.
+			 *
+			 * @return a PluginHandle to the resolved Plugin
+			 * @throw SharedLibraryException if there is an error accessing the SharedObject
+			 * @throw PluginManagerException if the Plugin is not loaded, or does not exist
+			 */
+			PluginHandle<T> getHandle() throw(SharedLibraryException, PluginManagerException) ;
+
+			/**
+			 * Discards the cached resolution, the next call to getHandle resolves the Plugin again
+			 *
+			 */
+			void invalidate() ;
+
+			//---------------------------------------------------------------------------------------//
+
+		protected:
+
+			//---------------------------------------------------------------------------------------//
+
+		private:
+
+			/** the PluginManager managing the Plugin */
+			PluginManager* theManager ;
+
+			/** the SharedLibrary containing the Plugin, empty if resolved by application name */
+			std::string theModule ;
+
+			/** the Plugin name, or application name if theModule is empty */
+			std::string theName ;
+
+			/** the resolved Plugin record, 0 if not resolved */
+			PluginManager::PluginRecord* theRecord ;
+
+			/** the resolved Plugin */
+			T* thePlugin ;
+
+			/** the generation of theManager at which the Plugin was resolved */
+			unsigned long theGeneration ;
 	} ;
 
 
@@ -896,14 +1757,17 @@ namespace cutil
 	{
 		PluginHandle<T> handle ;
 
-		Plugin* plugin = getPlugin(module, name) ;
-		if(plugin)
+		// the reference is taken while the Plugin is looked up, so it cannot be unloaded in between
+		PluginRecord* prec = acquirePlugin(module, name) ;
+
+		T* derived = dynamic_cast<T*>(prec->thePlugin) ;
+		if(derived)
 		{
-			T* derived = dynamic_cast<T*>(plugin) ;
-			if(derived)
-			{
-				handle.bind(*derived, *this) ;
-			}
+			handle.adopt(*derived, *this, prec) ;
+		}
+		else
+		{
+			releaseRecord(prec) ;
 		}
 
 		return(handle) ;
@@ -914,15 +1778,16 @@ namespace cutil
 	PluginManager::getPluginHandle(const std::string& name) throw(SharedLibraryException, PluginManagerException)
 	{
 		PluginHandle<T> handle ;
-		Plugin* plugin = getPlugin(name) ;
+		PluginRecord* prec = acquirePlugin(name) ;
 
-		if(plugin)
+		T* derived = dynamic_cast<T*>(prec->thePlugin) ;
+		if(derived)
 		{
-			T* derived = dynamic_cast<T*>(plugin) ;
-			if(derived)
-			{
-				handle.bind(*derived, *this) ;
-			}
+			handle.adopt(*derived, *this, prec) ;
+		}
+		else
+		{
+			releaseRecord(prec) ;
 		}
 
 		return(handle) ;
@@ -932,73 +1797,136 @@ namespace cutil
 
 
 
+	//---------------------------------------------------------------------------------------//
+	// PluginCall Template Implementation
+
+
+	template <class T>
+	PluginCall<T>::PluginCall(T* plugin, PluginManager::PluginRecord* record)
+			: thePlugin(plugin), theRecord(record), theStartTime(0)
+	{
+		if(theRecord)
+		{
+			theStartTime = PluginManager::monotonicTime() ;
+		}
+	}
+
+	template <class T>
+	PluginCall<T>::PluginCall(const PluginCall<T>& call)
+			: thePlugin(call.thePlugin), theRecord(call.theRecord), theStartTime(call.theStartTime)
+	{
+		call.theRecord = 0 ;
+	}
+
+	template <class T>
+	PluginCall<T>::~PluginCall()
+	{
+		if(theRecord)
+		{
+			PluginManager::recordCall(theRecord, theStartTime) ;
+		}
+	}
+
+	template <class T>
+	T* PluginCall<T>::operator->() const
+	{
+		return(thePlugin) ;
+	}
+
+
+
+
 	//---------------------------------------------------------------------------------------//
 	// PluginHandle Template Implementation
 
 
 	template <class T>
 	PluginHandle<T>::PluginHandle()
-			: thePlugin(0), theManager(0)
+			: thePlugin(0), theManager(0), theRecord(0)
 	{}
 
 	template <class T>
 	PluginHandle<T>::PluginHandle(T& plugin, PluginManager& pluginManager) throw (PluginManagerException)
-			: thePlugin(&plugin), theManager(&pluginManager)
+			: thePlugin(&plugin), theManager(&pluginManager), theRecord(0)
 	{
-		theManager->refPlugin(*thePlugin) ;
+		theRecord = theManager->acquirePlugin(*thePlugin) ;
 	}
 
 	template <class T>
 	PluginHandle<T>::PluginHandle(const PluginHandle<T>& handle)
-			: thePlugin(handle.thePlugin), theManager(handle.theManager)
+			: thePlugin(handle.thePlugin), theManager(handle.theManager), theRecord(handle.theRecord)
 	{
-		if(isValid())
+		if(theRecord)
 		{
-			theManager->refPlugin(*thePlugin) ;
+			PluginManager::refRecord(theRecord) ;
 		}
 	}
 
 	template <class T>
 	PluginHandle<T>::~PluginHandle()
 	{
-		if(isValid())
+		if(theRecord)
 		{
-			theManager->unrefPlugin(*thePlugin) ;
+			theManager->releaseRecord(theRecord) ;
 		}
 	}
 
 	template <class T>
-	T* PluginHandle<T>::operator->() const
+	PluginHandle<T>& PluginHandle<T>::operator=(const PluginHandle<T>& handle)
 	{
-		return(thePlugin) ;
+		// reference the new Plugin first, in case of self assignment
+		if(handle.theRecord)
+		{
+			PluginManager::refRecord(handle.theRecord) ;
+		}
+
+		if(theRecord)
+		{
+			theManager->releaseRecord(theRecord) ;
+		}
+
+		thePlugin = handle.thePlugin ;
+		theManager = handle.theManager ;
+		theRecord = handle.theRecord ;
+
+		return(*this) ;
+	}
+
+	template <class T>
+	PluginCall<T> PluginHandle<T>::operator->() const
+	{
+		return(PluginCall<T>(thePlugin, (theRecord && theManager->theInstrumentedFlag) ? theRecord : 0)) ;
 	}
 
 	template <class T>
 	void PluginHandle<T>::bind(T& plugin, PluginManager& pluginManager) throw (PluginManagerException)
 	{
-		if(isValid())
-		{
-			theManager->unrefPlugin(*thePlugin) ;
-		}
+		clear() ;
 
 		thePlugin = &plugin ;
 		theManager = &pluginManager ;
-
-		if(isValid())
-		{
-			theManager->refPlugin(*thePlugin) ;
-		}
+		theRecord = theManager->acquirePlugin(*thePlugin) ;
 	}
 
 	template <class T>
 	void PluginHandle<T>::clear()
 	{
-		if(isValid())
+		if(theRecord)
 		{
-			theManager->unrefPlugin(*thePlugin) ;
-			thePlugin = 0 ;
-			theManager = 0 ;
+			theManager->releaseRecord(theRecord) ;
 		}
+
+		thePlugin = 0 ;
+		theManager = 0 ;
+		theRecord = 0 ;
+	}
+
+	template <class T>
+	void PluginHandle<T>::adopt(T& plugin, PluginManager& pluginManager, PluginManager::PluginRecord* record)
+	{
+		thePlugin = &plugin ;
+		theManager = &pluginManager ;
+		theRecord = record ;
 	}
 
 	template <class T>
@@ -1020,6 +1948,95 @@ namespace cutil
 	}
 
 
+
+
+
+	//---------------------------------------------------------------------------------------//
+	// PluginResolver Template Implementation
+
+
+	template <class T>
+	PluginResolver<T>::PluginResolver(PluginManager& pluginManager, const std::string& name)
+			: theManager(&pluginManager), theName(name), theRecord(0), thePlugin(0), theGeneration(0)
+	{}
+
+	template <class T>
+	PluginResolver<T>::PluginResolver(PluginManager& pluginManager, const std::string& module, const std::string& name)
+			: theManager(&pluginManager), theModule(module), theName(name), theRecord(0), thePlugin(0), theGeneration(0)
+	{}
+
+	template <class T>
+	PluginHandle<T> PluginResolver<T>::getHandle() throw(SharedLibraryException, PluginManagerException)
+	{
+		PluginHandle<T> handle ;
+
+		if(theRecord)
+		{
+			// retired PluginRecords are not freed while this thread reads, so theRecord remains valid
+			// until the generation is found unchanged, and then until it is referenced
+			PluginManager::ReaderSlot* slot = theManager->enterRead() ;
+			if(theGeneration == theManager->theGeneration)
+			{
+				// reference first, then re-check the generation. An unload advances the generation
+				// before testing the reference count, so either the unload sees this reference,
+				// or this sees the new generation
+				PluginManager::refRecord(theRecord) ;
+				bool current = (theGeneration == theManager->theGeneration) ;
+				PluginManager::leaveRead(slot) ;
+
+				if(current)
+				{
+					handle.adopt(*thePlugin, *theManager, theRecord) ;
+				}
+				else
+				{
+					// drop the reference without unloading, the Plugin was referenced only to test it
+					PluginManager::PluginRecord* prec = theRecord ;
+					invalidate() ;
+					theManager->dropRecord(prec) ;
+				}
+			}
+			else
+			{
+				PluginManager::leaveRead(slot) ;
+				invalidate() ;
+			}
+		}
+
+		if(!handle.isValid())
+		{
+			// the generation is read before resolving, so a concurrent unload invalidates the result
+			unsigned long generation = theManager->theGeneration ;
+			__sync_synchronize() ;
+
+			PluginManager::PluginRecord* prec = theModule.empty() ? theManager->acquirePlugin(theName) : theManager->acquirePlugin(theModule, theName) ;
+
+			T* derived = dynamic_cast<T*>(prec->thePlugin) ;
+			if(derived)
+			{
+				handle.adopt(*derived, *theManager, prec) ;
+
+				theRecord = prec ;
+				thePlugin = derived ;
+				theGeneration = generation ;
+			}
+			else
+			{
+				theManager->releaseRecord(prec) ;
+			}
+		}
+
+		return(handle) ;
+	}
+
+	template <class T>
+	void PluginResolver<T>::invalidate()
+	{
+		theRecord = 0 ;
+		thePlugin = 0 ;
+	}
+
+
 } /* namespace cutil */
 
 #endif /* _CUTIL_PLUGINMANAGER_ */
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+
+#ifndef _CUTIL_PLUGINMANIFEST_H_
+#define _CUTIL_PLUGINMANIFEST_H_
+
+#include <cutil/Exception.h>
+#include <cutil/FilePath.h>
+#include <cutil/PluginInfo.h>
+
+#include <list>
+#include <map>
+#include <string>
+
+#include <sys/types.h>
+
+namespace cutil
+{
+	/**
+	 * An on-disk cache of the Plugins offered by each SharedLibrary.
+	 * Each entry records the PluginInfo list of a module, keyed by the module path and
+	 * validated against its size, modification time, device and inode, so a PluginManager
+	 * with a PluginManifest set can register the Plugins of an unchanged module from a
+	 * stat rather than opening the SharedLibrary. Modules are then only opened when a
+	 * Plugin is first loaded.
+	 * Modules specified without a path, which are searched for by the dynamic loader,
+	 * cannot be validated and are never cached.
+	 *
+	 * The manifest file is written to a temporary file which is synced and renamed over the
+	 * manifest, so readers never observe a partially written manifest. A manifest which
+	 * cannot be parsed is discarded, as the entries can always be recreated.
+	 *
+	 * A PluginManifest is not thread safe, a PluginManager only accesses its manifest
+	 * while holding its write lock.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class PluginManifest
+	{
+		public:
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates a new empty PluginManifest
+			 *
+			 */
+			PluginManifest() ;
+
+			/**
+			 * Destructor.
+			 *
+			 */
+			virtual ~PluginManifest() ;
+
+
+			//-------------------------------------------------------------------------------//
+			// PluginManifest Operations
+
+			/**
+			 * Replaces the entries of this PluginManifest with those read from the specified manifest file
+			 * If the file does not exist, or cannot be parsed, this PluginManifest is left empty.
+			 *
+			 * @param path the manifest file to read
+			 * @return true if the manifest file was read, false if it does not exist or was discarded
+			 * @throw Exception if the manifest file exists but cannot be read
+			 */
+			bool load(const FilePath& path) throw(Exception) ;
+
+			/**
+			 * Writes the entries of this PluginManifest to the specified manifest file, atomically replacing it
+			 *
+			 * @param path the manifest file to write
+			 * @throw Exception if the manifest file cannot be written
+			 */
+			void save(const FilePath& path) throw(Exception) ;
+
+			/**
+			 * Populates the specified list with the cached Plugins of the specified module.
+			 * The module is only found if its size, modification time, device and inode
+			 * match those recorded when its entry was updated.
+			 *
+			 * @param module the SharedLibrary path
+			 * @param plugins populated with the cached Plugins of module
+			 * @return true if an up to date entry for module exists, false otherwise
+			 */
+			bool lookup(const std::string& module, std::list<PluginInfo>& plugins) const ;
+
+			/**
+			 * Records the Plugins offered by the specified module, along with its current metadata.
+			 * If the module cannot be found at its path, any entry for it is removed.
+			 *
+			 * @param module the SharedLibrary path
+			 * @param plugins the Plugins available through module
+			 */
+			void update(const std::string& module, const std::list<PluginInfo>& plugins) ;
+
+			/**
+			 * Removes the entry of the specified module
+			 *
+			 * @param module the SharedLibrary path
+			 * @return true if an entry was removed, false otherwise
+			 */
+			bool remove(const std::string& module) ;
+
+			/**
+			 * Removes all entries from this PluginManifest
+			 *
+			 */
+			void clear() ;
+
+			/**
+			 * Returns the number of modules with an entry in this PluginManifest
+			 *
+			 * @return the number of cached modules
+			 */
+			size_t getModuleCount() const ;
+
+			/**
+			 * Returns whether this PluginManifest has been changed since it was last loaded or saved
+			 *
+			 * @return true if this PluginManifest has unsaved changes, false otherwise
+			 */
+			bool isModified() const ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+			/**
+			 * The cached Plugins of a module, and the metadata they were recorded against
+			 */
+			struct Entry
+			{
+				Entry() : theSize(0), theModifiedSeconds(0), theModifiedNanoseconds(0), theDevice(0), theInode(0) {}
+
+				/** the size of the module */
+				unsigned long long theSize ;
+
+				/** the modification time of the module */
+				unsigned long long theModifiedSeconds ;
+				unsigned long long theModifiedNanoseconds ;
+
+				/** the device and inode of the module */
+				unsigned long long theDevice ;
+				unsigned long long theInode ;
+
+				/** the Plugins available through the module */
+				std::list<PluginInfo> thePlugins ;
+			} ;
+
+			/**
+			 * Populates the metadata of the specified Entry from the module file
+			 *
+			 * @param module the SharedLibrary path
+			 * @param entry the Entry to populate
+			 * @return true if the module exists at its path, false otherwise
+			 */
+			static bool stat(const std::string& module, Entry& entry) ;
+
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			PluginManifest(const PluginManifest&) {}
+
+			// typedefs of module path to Entry, ordered so saved manifests are stable
+			typedef std::map<std::string, Entry> EntryContainer_t ;
+
+			/** the cached module entries */
+			EntryContainer_t theEntries ;
+
+			/** indicates if theEntries have changed since last loaded or saved */
+			bool theModifiedFlag ;
+
+	} ; /* class PluginManifest */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_PLUGINMANIFEST_H_ */
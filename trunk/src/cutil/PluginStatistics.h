@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#ifndef _CUTIL_PLUGINSTATISTICS_H_
+#define _CUTIL_PLUGINSTATISTICS_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cutil
+{
+	/**
+	 * A snapshot of the instrumentation a PluginManager records for a registered Plugin.
+	 * Load timings are those of the most recent load of the Plugin, and are only
+	 * recorded while the PluginManager is instrumented, as are call latencies.
+	 *
+	 * Call latencies are counted in a histogram of buckets doubling in width. Bucket 0
+	 * counts calls under 1 nanosecond, and bucket i counts calls of at least 2^(i-1),
+	 * and under 2^i, nanoseconds. The final bucket counts every longer call.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class PluginStatistics
+	{
+		public:
+			/** the number of buckets of the call latency histogram */
+			static const size_t BUCKET_COUNT = 40 ;
+
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Constructs an empty PluginStatistics
+			 *
+			 */
+			PluginStatistics() ;
+
+			/**
+			 * Destructor
+			 *
+			 */
+			~PluginStatistics() ;
+
+			//-------------------------------------------------------------------------------//
+			// Accessors
+
+			/**
+			 * Returns the SharedLibrary the Plugin is registered from
+			 *
+			 * @return the SharedLibrary of the Plugin
+			 */
+			const std::string& getModule() const ;
+
+			/**
+			 * Returns the name of the Plugin
+			 *
+			 * @return the name of the Plugin
+			 */
+			const std::string& getName() const ;
+
+			/**
+			 * Returns whether the Plugin was loaded at the time of the snapshot
+			 *
+			 * @return true if the Plugin was loaded, false otherwise
+			 */
+			bool isLoaded() const ;
+
+			/**
+			 * Returns the number of references to the Plugin held outside the PluginManager,
+			 * through PluginHandles or refPlugin, at the time of the snapshot
+			 *
+			 * @return the number of live references to the Plugin
+			 */
+			int getHandleCount() const ;
+
+			/**
+			 * Returns the number of times the Plugin has been loaded while instrumented
+			 *
+			 * @return the number of instrumented loads
+			 */
+			unsigned long getLoadCount() const ;
+
+			/**
+			 * Returns the time taken to open the SharedLibrary of the Plugin, when it was last
+			 * loaded. The time is 0 if the SharedLibrary was already open.
+			 *
+			 * @return the open time in nanoseconds
+			 */
+			unsigned long long getOpenTime() const ;
+
+			/**
+			 * Returns the time taken to create the PluginFactory of the SharedLibrary, when the
+			 * Plugin was last loaded. The time is negligible if the PluginFactory already existed.
+			 *
+			 * @return the PluginFactory creation time in nanoseconds
+			 */
+			unsigned long long getFactoryTime() const ;
+
+			/**
+			 * Returns the time taken by the PluginFactory to create the Plugin, when it was last loaded
+			 *
+			 * @return the Plugin creation time in nanoseconds
+			 */
+			unsigned long long getCreateTime() const ;
+
+			/**
+			 * Returns the number of calls made through PluginHandles while instrumented
+			 *
+			 * @return the number of recorded calls
+			 */
+			unsigned long getCallCount() const ;
+
+			/**
+			 * Returns the total latency of the recorded calls
+			 *
+			 * @return the total call time in nanoseconds
+			 */
+			unsigned long long getCallTime() const ;
+
+			/**
+			 * Returns the mean latency of the recorded calls
+			 *
+			 * @return the mean call time in nanoseconds, 0 if no calls were recorded
+			 */
+			double getMeanCallTime() const ;
+
+			/**
+			 * Returns an upper bound of the specified percentile of the recorded call latencies,
+			 * the limit of the histogram bucket containing the percentile.
+			 *
+			 * @param percentile the percentile, between 0 and 100
+			 * @return the upper bound in nanoseconds, 0 if no calls were recorded
+			 */
+			unsigned long long getCallPercentile(double percentile) const ;
+
+			/**
+			 * Returns the call latency histogram, of BUCKET_COUNT buckets
+			 *
+			 * @return the number of calls counted in each bucket
+			 */
+			const std::vector<unsigned long>& getCallHistogram() const ;
+
+			//-------------------------------------------------------------------------------//
+			// Histogram Buckets
+
+			/**
+			 * Returns the histogram bucket counting a call of the specified latency
+			 *
+			 * @param nanoseconds the call latency
+			 * @return the bucket of the latency
+			 */
+			static size_t getBucket(unsigned long long nanoseconds) ;
+
+			/**
+			 * Returns the exclusive upper limit of latencies counted in the specified bucket.
+			 * The final bucket has no limit, and returns its lower bound.
+			 *
+			 * @param bucket the histogram bucket
+			 * @return the upper limit in nanoseconds
+			 */
+			static unsigned long long getBucketLimit(size_t bucket) ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+			friend class PluginManager ;
+
+			/** the SharedLibrary of the Plugin */
+			std::string theModule ;
+
+			/** the Plugin name */
+			std::string theName ;
+
+			/** indicates the Plugin was loaded */
+			bool theLoadedFlag ;
+
+			/** references held outside the PluginManager */
+			int theHandleCount ;
+
+			/** instrumented loads of the Plugin */
+			unsigned long theLoadCount ;
+
+			/** the load timings of the most recent load, in nanoseconds */
+			unsigned long long theOpenTime ;
+			unsigned long long theFactoryTime ;
+			unsigned long long theCreateTime ;
+
+			/** the number and total latency, in nanoseconds, of recorded calls */
+			unsigned long theCallCount ;
+			unsigned long long theCallTime ;
+
+			/** the call latency histogram */
+			std::vector<unsigned long> theCallHistogram ;
+
+	} ; /* class PluginStatistics */
+
+} /* namespace cutil */
+
+#endif /* _CUTIL_PLUGINSTATISTICS_H_ */
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+
+#ifndef _CUTIL_READWRITELOCK_H_
+#define _CUTIL_READWRITELOCK_H_
+
+#include <cutil/Exception.h>
+
+#include <pthread.h>
+
+namespace cutil
+{
+	/**
+	 * A readers/writer lock, a wrapper around a pthread rwlock.
+	 * Any number of threads may hold the read lock, or a single thread the write lock.
+	 * The write lock is re-entrant, the thread holding the write lock may lock this
+	 * ReadWriteLock again for reading or writing, nested locks are released by a matching
+	 * number of calls to unlock. A thread holding only the read lock must not request
+	 * the write lock.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class ReadWriteLock
+	{
+		public:
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates a new unlocked ReadWriteLock
+			 *
+			 * @throw Exception if the lock cannot be initialised
+			 */
+			ReadWriteLock() throw(Exception) ;
+
+			/**
+			 * Destructor.
+			 * The ReadWriteLock must not be locked when destroyed
+			 *
+			 */
+			virtual ~ReadWriteLock() ;
+
+			//-------------------------------------------------------------------------------//
+			// ReadWriteLock Operations
+
+			/**
+			 * Locks this ReadWriteLock for reading, blocking while a writer holds the lock
+			 *
+			 * @throw Exception if the lock cannot be acquired
+			 */
+			void readLock() throw(Exception) ;
+
+			/**
+			 * Locks this ReadWriteLock for writing, blocking while any reader or writer holds the lock
+			 *
+			 * @throw Exception if the lock cannot be acquired
+			 */
+			void writeLock() throw(Exception) ;
+
+			/**
+			 * Locks this ReadWriteLock for writing if no other reader or writer holds the lock
+			 *
+			 * @return true if the write lock was acquired, false if it is held
+			 * @throw Exception if the lock cannot be acquired for another reason
+			 */
+			bool tryWriteLock() throw(Exception) ;
+
+			/**
+			 * Releases a read or write lock held by the calling thread
+			 *
+			 * @throw Exception if the lock cannot be released
+			 */
+			void unlock() throw(Exception) ;
+
+			/**
+			 * Returns whether the calling thread holds the write lock
+			 *
+			 * @return true if the calling thread holds the write lock, false otherwise
+			 */
+			bool isWriteLocked() const ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			ReadWriteLock(const ReadWriteLock&) {}
+
+			/** the underlying pthread rwlock */
+			pthread_rwlock_t theLock ;
+
+			/** the thread holding the write lock, valid while theWriteDepth is non-zero */
+			pthread_t theWriter ;
+
+			/** the nesting depth of the write lock held by theWriter */
+			volatile int theWriteDepth ;
+
+	} ; /* class ReadWriteLock */
+
+
+	/**
+	 * Scoped read lock of a ReadWriteLock.
+	 * The ReadWriteLock is locked for reading on construction and unlocked on destruction.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class ReadLock
+	{
+		public:
+			/**
+			 * Locks the specified ReadWriteLock for reading for the lifetime of this ReadLock
+			 *
+			 * @param lock the ReadWriteLock to lock
+			 */
+			ReadLock(ReadWriteLock& lock) : theLock(lock)
+			{
+				theLock.readLock() ;
+			}
+
+			/**
+			 * Destructor.
+			 * Unlocks the ReadWriteLock
+			 *
+			 */
+			~ReadLock()
+			{
+				theLock.unlock() ;
+			}
+
+		private:
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			ReadLock(const ReadLock& lock) : theLock(lock.theLock) {}
+
+			/** the locked ReadWriteLock */
+			ReadWriteLock& theLock ;
+
+	} ; /* class ReadLock */
+
+
+	/**
+	 * Scoped write lock of a ReadWriteLock.
+	 * The ReadWriteLock is locked for writing on construction and unlocked on destruction.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class WriteLock
+	{
+		public:
+			/**
+			 * Locks the specified ReadWriteLock for writing for the lifetime of this WriteLock
+			 *
+			 * @param lock the ReadWriteLock to lock
+			 */
+			WriteLock(ReadWriteLock& lock) : theLock(lock)
+			{
+				theLock.writeLock() ;
+			}
+
+			/**
+			 * Destructor.
+			 * Unlocks the ReadWriteLock
+			 *
+			 */
+			~WriteLock()
+			{
+				theLock.unlock() ;
+			}
+
+		private:
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			WriteLock(const WriteLock& lock) : theLock(lock.theLock) {}
+
+			/** the locked ReadWriteLock */
+			ReadWriteLock& theLock ;
+
+	} ; /* class WriteLock */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_READWRITELOCK_H_ */
@@ -22,14 +22,18 @@
 #ifndef _CUTIL_SHAREDLIBRARY_
 #define _CUTIL_SHAREDLIBRARY_
 
+#include <cutil/Mutex.h>
 #include <cutil/SharedLibraryException.h>
 
 #include <string>
+#include <tr1/unordered_map>
 
 namespace cutil
 {
 	/**
 	 * Representation of a dynamically loadable module.
+	 * A SharedLibrary is not thread safe, concurrent access must be synchronised by the user,
+	 * with the exception of getSymbol, which may be called concurrently on an open SharedLibrary.
 	 *
 	 * @author Colin Law [claw@mail.berlios.de]
 	 * @version $Rev$
@@ -137,6 +141,83 @@ namespace cutil
 			 */
 			bool getGlobalSymbol() const ;
 
+			/**
+			 * Sets whether this SharedLibrary is opened within a new, isolated, linker namespace.
+			 * An isolated SharedLibrary, and the dependencies it loads, are bound only to symbols
+			 * within its own namespace (dlmopen with LM_ID_NEWLM on glibc systems). Each isolated
+			 * SharedLibrary opened receives its own copy of the module and its state, so several
+			 * copies or versions of a module may be open at once without their symbols clashing.
+			 * The global symbol flag does not apply to an isolated SharedLibrary. Types shared with
+			 * the application, such as Plugin, are distinct within the namespace, so an isolated
+			 * module should be accessed through plain functions, as with a SymbolTable. The number
+			 * of namespaces is limited by the system (16 with glibc).
+			 * This flag is effective only during the opening of a shared library, attempting to
+			 * change it on an open SharedLibrary results in a SharedLibraryException.
+			 *
+			 * @param isolated set true to open this SharedLibrary within a new namespace
+			 * @throw SharedLibraryException if this SharedLibrary is open
+			 */
+			void setIsolated(bool isolated) throw(SharedLibraryException) ;
+
+			/**
+			 * Returns whether this SharedLibrary is opened within a new linker namespace
+			 *
+			 * @see setIsolated
+			 * @return true if this SharedLibrary is opened within a new namespace
+			 */
+			bool getIsolated() const ;
+
+			/**
+			 * Returns the linker namespace this open SharedLibrary was loaded into.
+			 * A SharedLibrary which is not isolated is loaded into the base namespace, 0 (LM_ID_BASE).
+			 *
+			 * @return the linker namespace id of this SharedLibrary
+			 * @throw SharedLibraryException if this SharedLibrary is not open, or the namespace cannot be determined
+			 */
+			long getNamespace() const throw(SharedLibraryException) ;
+
+			/**
+			 * Sets whether the module remains loaded once this SharedLibrary is closed.
+			 * With the flag set (RTLD_NODELETE on UNIX systems), closing this SharedLibrary does not
+			 * unmap the module, so reopening it later avoids mapping and relocating it again, and its
+			 * static state is retained. Set this for modules which are repeatedly opened and closed.
+			 * This flag is effective only during the opening of a shared library, attempting to
+			 * change it on an open SharedLibrary results in a SharedLibraryException.
+			 *
+			 * @param nodelete set true to keep the module loaded once closed
+			 * @throw SharedLibraryException if this SharedLibrary is open
+			 */
+			void setNoDelete(bool nodelete) throw(SharedLibraryException) ;
+
+			/**
+			 * Returns whether the module remains loaded once this SharedLibrary is closed
+			 *
+			 * @see setNoDelete
+			 * @return true if the module remains loaded once closed
+			 */
+			bool getNoDelete() const ;
+
+			/**
+			 * Sets whether the pages of the module are faulted in as it is opened.
+			 * With the flag set, the loadable segments of the module are read into memory before
+			 * open returns, so the first calls into the module do not stall on page faults. This
+			 * moves the cost of faulting in the module from its first use to its opening.
+			 * This flag is effective only during the opening of a shared library, attempting to
+			 * change it on an open SharedLibrary results in a SharedLibraryException.
+			 *
+			 * @param prefault set true to fault in the module as it is opened
+			 * @throw SharedLibraryException if this SharedLibrary is open
+			 */
+			void setPrefault(bool prefault) throw(SharedLibraryException) ;
+
+			/**
+			 * Returns whether the pages of the module are faulted in as it is opened
+			 *
+			 * @see setPrefault
+			 * @return true if the module is faulted in as it is opened
+			 */
+			bool getPrefault() const ;
+
 
 			//-------------------------------------------------------------------------------//
 			// SharedLibray Operations
@@ -160,6 +241,10 @@ namespace cutil
 			 * Returns the address of the specified symbol within this SharedLibrary
 			 * The SharedLibrary must have been loaded by a call to open before calling
 			 * this method.
+			 * Resolved symbols are cached until this SharedLibrary is closed, so repeated
+			 * lookups of the same symbol do not search the dynamic linker symbol tables.
+			 * The cache is locked, so getSymbol may be called concurrently.
+			 * For calls on a hot path, bind the symbols once through a SymbolTable.
 			 *
 			 * @param symbol the symbl name to get
 			 * @throw SharedLibraryException if this SharedLibrary is not open, the symbol
@@ -167,6 +252,17 @@ namespace cutil
 			 */
 			void* getSymbol(const std::string& symbol) throw(SharedLibraryException) ;
 
+			/**
+			 * Returns the size of the memory mapped for the segments of this open SharedLibrary.
+			 * The size is that of the loadable segments of the module itself, excluding
+			 * any dependencies and any memory the module allocates. The size is computed once
+			 * each time this SharedLibrary is opened. 0 is returned if this SharedLibrary is
+			 * not open, or the size cannot be determined.
+			 *
+			 * @return the size of the mapped segments of this SharedLibrary in bytes
+			 */
+			size_t getMappedSize() ;
+
 
 		protected:
 
@@ -174,6 +270,12 @@ namespace cutil
 
 		private:
 
+			/**
+			 * Faults in the loadable segments of this open SharedLibrary
+			 *
+			 */
+			void prefault() ;
+
 			/** the dynamic module name */
 			std::string theModuleName ;
 
@@ -189,6 +291,26 @@ namespace cutil
 			/** indicates if loaded symbols are available globally (true), or local (false) */
 			bool theGlobalFlag ;
 
+			typedef std::tr1::unordered_map<std::string, void*> SymbolContainer_t ;
+
+			/** symbols resolved since this SharedLibrary was opened */
+			SymbolContainer_t theSymbols ;
+
+			/** guards theSymbols */
+			Mutex theSymbolMutex ;
+
+			/** the size of the mapped segments, 0 if not yet computed */
+			size_t theMappedSize ;
+
+			/** indicates if this SharedLibrary is opened within a new linker namespace */
+			bool theIsolatedFlag ;
+
+			/** indicates if the module remains loaded once closed */
+			bool theNoDeleteFlag ;
+
+			/** indicates if the module is faulted in as it is opened */
+			bool thePrefaultFlag ;
+
 
 	} ; /* class SharedLibrary */
 
@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_SNAPSHOTSTATEHANDLER_H_
+#define _CUTIL_SNAPSHOTSTATEHANDLER_H_
+
+#include <cutil/StateHandler.h>
+
+#include <cutil/Exception.h>
+#include <cutil/MappedFile.h>
+#include <cutil/MemoryStateHandler.h>
+#include <cutil/RefCountPtr.h>
+
+#include <string>
+
+#include <stdint.h>
+
+namespace cutil
+{
+	class StateNode ;
+
+	/**
+	 * StateHandler implementation reading state information from a memory mapped binary snapshot.
+	 * A snapshot is produced once from any initialized StateHandler, such as an XMLStateHandler,
+	 * with writeSnapshot. Initialization maps the snapshot and checks its header, no state
+	 * information is parsed or copied onto the heap, values are read directly from the mapping
+	 * by SnapshotStateNodes.
+	 *
+	 * The snapshot holds, in native byte order, a header, a table of StateNode records, a table
+	 * of value records and a string table. The children of each StateNode are stored as
+	 * consecutive records, as are its values, each ordered by name so a child or value is
+	 * located by binary search. Names and value strings are stored once within the string table
+	 * and referenced by offset. Each value record holds its string, int, double and bool
+	 * representation, parsed as XMLStateNode parses values.
+	 *
+	 * The state tree remains modifiable. The first modification copies the snapshot into a
+	 * MemoryStateHandler, and flush() then writes a new snapshot from the copy, replacing the
+	 * data file atomically.
+	 *
+	 * @see SnapshotStateNode
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class SnapshotStateHandler : public StateHandler
+	{
+		public:
+			//---------------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Constructs a new SnapshotStateHandler to read and store state information within the
+			 * specified snapshot file
+			 *
+			 * @param filename the file path of the snapshot file
+			 */
+			SnapshotStateHandler(const std::string& filename) ;
+
+			/**
+			 * Destructor
+			 */
+			virtual ~SnapshotStateHandler() ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// StateHandler implementations
+
+			/**
+			 * Initialize this StateHandler.
+			 * Maps the snapshot file. If the file does not exist, or is not a valid snapshot,
+			 * the state tree is empty.
+			 */
+			virtual void initialize() ;
+
+			/**
+			 * Shutdown this StateHandler.
+			 * Writes any modifications to the snapshot file and unmaps the snapshot
+			 */
+			virtual void shutdown() ;
+
+			//---------------------------------------------------------------------------------------//
+			// Update Control
+
+			/**
+			 * Force a write of state information back to the persistant store
+			 * A new snapshot is written only if the state tree has been modified. The snapshot is
+			 * written to a temporary file which is synchronized to disk and renamed over the data file.
+			 *
+			 * @throw Exception if the snapshot file cannot be written
+			 */
+			virtual void flush() ;
+
+			/**
+			 * Synchronize this StateHandler to the persistant store of state information,
+			 * The snapshot file is mapped again, discarding any unwritten modifications
+			 */
+			virtual void sync() ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// StateNode Access
+
+			/**
+			 * Returns the root StateNode within the state tree of this StateHandler
+			 * This method returns a user handle for the underlying data of the StateNode
+			 * implementation. Subsequent calls to getRootNode need not return the same
+			 * handle instance, however, it is guaranteed that each will be a handle to
+			 * the same underlying data instance.
+			 *
+			 * @return the root StateNode within the state tree of this StateHandler
+			 */
+			virtual RefCountPtr<StateNode> getRootNode() ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// Snapshot Handling
+
+			/**
+			 * Returns whether state information is read directly from the mapped snapshot.
+			 * Once the state tree is modified, state information is read from an in memory copy.
+			 *
+			 * @return true if the snapshot is mapped and unmodified
+			 */
+			bool isMapped() const ;
+
+			/**
+			 * Returns whether the state tree has been modified since the snapshot was last
+			 * written or mapped
+			 *
+			 * @return true if the state tree has been modified
+			 */
+			bool isDirty() const ;
+
+			/**
+			 * Writes a snapshot of the state tree of the specified StateHandler to the specified file.
+			 * The snapshot is written to a temporary file which is synchronized to disk and renamed
+			 * over the specified file.
+			 *
+			 * @param source the initialized StateHandler to write
+			 * @param filename the path of the snapshot file
+			 * @throw Exception if the snapshot file cannot be written
+			 */
+			static void writeSnapshot(StateHandler& source, const std::string& filename) throw(Exception) ;
+
+			/** record index indicating no StateNode */
+			static const uint32_t NO_NODE ;
+
+			//---------------------------------------------------------------------------------------//
+
+		protected:
+
+			//---------------------------------------------------------------------------------------//
+
+		private:
+			// SnapshotStateNodes read the snapshot records directly
+			friend class SnapshotStateNode ;
+
+			/**
+			 * Disallow copy constructor
+			 */
+			SnapshotStateHandler(const SnapshotStateHandler&) {} ;
+
+			/**
+			 * Snapshot file header
+			 */
+			struct Header
+			{
+				/** identifies a snapshot file */
+				char theMagic[8] ;
+
+				/** the snapshot format version, and byte order */
+				uint32_t theVersion ;
+
+				/** the number of, and file offset of, the StateNode records, the root is the first record */
+				uint32_t theNodeCount ;
+				uint32_t theNodeOffset ;
+
+				/** the number of, and file offset of, the value records */
+				uint32_t theValueCount ;
+				uint32_t theValueOffset ;
+
+				/** the file offset and size of the string table */
+				uint32_t theStringOffset ;
+				uint32_t theStringSize ;
+
+				/** reserved, 0 */
+				uint32_t theReserved ;
+			} ;
+
+			/**
+			 * Snapshot StateNode record
+			 */
+			struct NodeRecord
+			{
+				/** string table offset of the name of the StateNode */
+				uint32_t theName ;
+
+				/** index of the parent StateNode record, NO_NODE for the root */
+				uint32_t theParent ;
+
+				/** index of the first child record, and the number of children */
+				uint32_t theFirstChild ;
+				uint32_t theChildCount ;
+
+				/** index of the first value record, and the number of values */
+				uint32_t theFirstValue ;
+				uint32_t theValueCount ;
+			} ;
+
+			/**
+			 * Snapshot value record
+			 */
+			struct ValueRecord
+			{
+				/** string table offsets of the name and string value */
+				uint32_t theName ;
+				uint32_t theString ;
+
+				/** the value parsed as each type */
+				int32_t theInt ;
+				uint32_t theBool ;
+				double theDouble ;
+			} ;
+
+			/**
+			 * Maps and validates the snapshot file, leaving the snapshot unmapped if the
+			 * file does not exist or is not a valid snapshot
+			 *
+			 */
+			void load() ;
+
+			/**
+			 * Discards the snapshot and any in memory copy of the state tree
+			 *
+			 */
+			void release() ;
+
+			/**
+			 * Returns the StateNode record at the specified index
+			 *
+			 * @param index the index of the record, which must be valid
+			 * @return the StateNode record
+			 */
+			const NodeRecord& getNode(uint32_t index) const ;
+
+			/**
+			 * Returns the value record at the specified index
+			 *
+			 * @param index the index of the record, which must be valid
+			 * @return the value record
+			 */
+			const ValueRecord& getValue(uint32_t index) const ;
+
+			/**
+			 * Returns the string at the specified string table offset
+			 *
+			 * @param offset the string table offset
+			 * @return the string
+			 */
+			std::string getString(uint32_t offset) const ;
+
+			/**
+			 * Compares the string at the specified string table offset with name, as strcmp
+			 *
+			 * @param offset the string table offset
+			 * @param name the name to compare with
+			 * @return less than, equal to or greater than 0 as the string orders before, with or after name
+			 */
+			int compareString(uint32_t offset, const std::string& name) const ;
+
+			/**
+			 * Returns the index of the named child record of the specified StateNode record
+			 *
+			 * @param index the index of the StateNode record
+			 * @param name the name of the child
+			 * @return the index of the child record, or NO_NODE if not found
+			 */
+			uint32_t findChild(uint32_t index, const std::string& name) const ;
+
+			/**
+			 * Returns the named value record of the specified StateNode record
+			 *
+			 * @param index the index of the StateNode record
+			 * @param name the name of the value
+			 * @return the value record, or 0 if not found
+			 */
+			const ValueRecord* findValue(uint32_t index, const std::string& name) const ;
+
+			/**
+			 * Returns the index of the StateNode record with the specified complete path
+			 *
+			 * @param path the complete path of the StateNode
+			 * @return the index of the StateNode record, or NO_NODE if not found
+			 */
+			uint32_t findNode(const std::string& path) const ;
+
+			/**
+			 * Returns whether the state tree has been copied into memory
+			 *
+			 * @return true if the state tree has been copied into memory
+			 */
+			bool isCopied() const ;
+
+			/**
+			 * Returns the StateNode at the specified path of the in memory copy of the state tree,
+			 * if the state tree has been copied and the StateNode exists
+			 *
+			 * @param path the complete path of the StateNode
+			 * @return the in memory StateNode, or an empty RefCountPtr
+			 */
+			RefCountPtr<StateNode> findCopy(const std::string& path) ;
+
+			/**
+			 * Returns the StateNode at the specified path of the in memory copy of the state tree
+			 * for modification, copying the snapshot into memory if not yet copied and creating
+			 * the StateNode if required. The state tree is marked modified
+			 *
+			 * @param path the complete path of the StateNode
+			 * @return the in memory StateNode
+			 */
+			RefCountPtr<StateNode> modifyCopy(const std::string& path) ;
+
+			/** the file path of the snapshot file */
+			std::string theDataFile ;
+
+			/** the mapped snapshot file */
+			MappedFile theFile ;
+
+			/** the snapshot records, 0 if no snapshot is mapped */
+			const Header* theHeader ;
+			const NodeRecord* theNodes ;
+			const ValueRecord* theValues ;
+			const char* theStrings ;
+
+			/** incremented each time the snapshot is mapped, or copied into memory */
+			unsigned long theGeneration ;
+
+			/** the in memory copy of the state tree, once modified */
+			MemoryStateHandler theCopy ;
+
+			/** indicates the state tree has been copied into memory */
+			bool theCopyFlag ;
+
+			/** indicates the state tree has been modified since last written or mapped */
+			bool theDirtyFlag ;
+
+	} ; /* class SnapshotStateHandler */
+
+} /* namespace cutil */
+
+#endif /* _CUTIL_SNAPSHOTSTATEHANDLER_H_ */
@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_SNAPSHOTSTATENODE_H_
+#define _CUTIL_SNAPSHOTSTATENODE_H_
+
+#include <cutil/StateNode.h>
+
+#include <cutil/RefCountPtr.h>
+
+#include <list>
+#include <string>
+
+#include <stdint.h>
+
+namespace cutil
+{
+	class SnapshotStateHandler ;
+
+	/**
+	 * SnapshotStateNode is an implementation of the StateNode interface reading state
+	 * information directly from the mapped snapshot file of a SnapshotStateHandler.
+	 * Child StateNodes and values are located by a binary search of the name ordered records
+	 * of the StateNode, and values are stored parsed into each type, so no state information
+	 * is copied onto the heap to be read.
+	 * The first modification of the state tree copies the snapshot into memory, after which
+	 * each SnapshotStateNode operates upon the copy at its path.
+	 * Child StateNodes and values are listed in name order.
+	 *
+	 * @see SnapshotStateHandler
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class SnapshotStateNode : public StateNode
+	{
+		public:
+			//---------------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Destructor
+			 */
+			virtual ~SnapshotStateNode() ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// State Tree Handling
+
+			/**
+			 * Returns the parent StateNode of this StateNode.
+			 * If the parent StateNode does not exist, the returned RefCountPtr will point to 0.
+			 *
+			 * This method returns a user handle for the underlying data of the StateNode
+			 * implementation. Subsequent calls to getParent need not return the same
+			 * handle instance, however, it is guaranteed that each will be a handle to
+			 * the same underlying data instance.
+			 *
+			 * @return the parent StateNode to this StateNode
+			 */
+			virtual RefCountPtr<StateNode> getParent() ;
+
+			/**
+			 * Returns the named child StateNode from the state tree below this StateNode,
+			 * If the child StateNode does not yet exist, it is created and returned, creating any
+			 * parent nodes as required.
+			 * childPath may contain several '/' separated path segments.
+			 *
+			 * This method returns a user handle for the underlying data of the StateNode
+			 * implementation. Subsequent calls to getChild need not return the same
+			 * handle instance, however, it is guaranteed that each will be a handle to
+			 * the same underlying data instance.
+			 *
+			 * @param childPath the path to the child node
+			 * @return the specified child node
+			 */
+			virtual RefCountPtr<StateNode> getChild(std::string childPath) ;
+
+			/**
+			 * Removes the specified child StateNode from the state tree.
+			 * The specified child StateNode must be below this StateNode within the state tree
+			 *
+			 * @param childPath the path to the child StateNode to remove
+			 */
+			virtual void removeChild(std::string childPath) ;
+
+			/**
+			 * Returns true of this StateNode contains the specified Child StateNode
+			 *
+			 * @param childPath the path of the specified child StateNode
+			 * @return true if thie StateNode contains th specified StateNode
+			 */
+			virtual bool hasChild(const std::string& childPath) ;
+
+			/**
+			 * Populate the specified list with all the child StateNode names directly below this StateNode in the state tree
+			 * The list is not cleared prior to any additions
+			 *
+			 * @param childList the list to populate
+			 * @return the number of elements added to the list
+			 */
+			virtual int getChildren(std::list<std::string>& childList) ;
+
+			/**
+			 * Returns the complete path of this StateNode starting at the root '/'
+			 *
+			 * @return the complete path of this StateNode
+			 */
+			virtual const std::string& getPath() const ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// State Handling
+
+			/**
+			 * Stores the specified value string within this StateNode associated with the specified name string
+			 *
+			 * @param name name with which the specified value will be associated
+			 * @param value the string value to store with the specified name
+			 */
+			virtual void setString(const std::string& name, const std::string& value) ;
+
+			/**
+			 * Stores the specified int value within this StateNode associated with the specified name string
+			 *
+			 * @param name name with which the specified value will be associated
+			 * @param value the int value to store with the specified name
+			 */
+			virtual void setInt(const std::string& name, int value) ;
+
+			/**
+			 * Stores the specified double value within this StateNode associated with the specified name string
+			 *
+			 * @param name name with which the specified value will be associated
+			 * @param value the double value to store with the specified name
+			 */
+			virtual void setDouble(const std::string& name, double value) ;
+
+			/**
+			 * Stores the specified bool value within this StateNode associated with the specified name string
+			 *
+			 * @param name name with which the specified value will be associated
+			 * @param value the bool value to store with the specified name
+			 */
+			virtual void setBool(const std::string& name, bool value) ;
+
+			/**
+			 * Returns the specified string value associated with the specified name from this StateNode.
+			 * If the specified name is not found, the specified default value will be returned
+			 *
+			 * @param name the name with which the value is associated
+			 * @param def the default value if the specified name cannot be found
+			 * @return the string value associated with the specified name
+			 */
+			virtual std::string getString(const std::string& name, const std::string& def) const ;
+
+			/**
+			 * Returns the specified int value associated with the specified name from this StateNode.
+			 * If the specified name is not found, the specified default value will be returned
+			 *
+			 * @param name the name with which the value is associated
+			 * @param def the default value if the specified name cannot be found
+			 * @return the int value associated with the specified name
+			 */
+			virtual int getInt(const std::string& name, int def) const ;
+
+			/**
+			 * Returns the specified double value associated with the specified name from this StateNode.
+			 * If the specified name is not found, the specified default value will be returned
+			 *
+			 * @param name the name with which the value is associated
+			 * @param def the default value if the specified name cannot be found
+			 * @return the double value associated with the specified name
+			 */
+			virtual double getDouble(const std::string& name, double def) const ;
+
+			/**
+			 * Returns the specified bool value associated with the specified name from this StateNode.
+			 * If the specified name is not found, the specified default value will be returned
+			 *
+			 * @param name the name with which the value is associated
+			 * @param def the default value if the specified name cannot be found
+			 * @return the bool value associated with the specified name
+			 */
+			virtual bool getBool(const std::string& name, bool def) const ;
+
+			/**
+			 * Removed the specified name value pair from this StateNode
+			 *
+			 * @param name name of the name value pair to remove
+			 */
+			virtual void removeValue(const std::string& name) ;
+
+			/**
+			 * Populate the specified list with the names of all values stored within this StateNode
+			 * The list is not cleared prior to any additions
+			 *
+			 * @param nameList the list to populate
+			 * @return the number of elements added to the list
+			 */
+			virtual int getValueNames(std::list<std::string>& nameList) ;
+
+			//---------------------------------------------------------------------------------------//
+
+		protected:
+
+			//---------------------------------------------------------------------------------------//
+
+		private:
+			// SnapshotStateHandler creates the root StateNode
+			friend class SnapshotStateHandler ;
+
+			/**
+			 * Constructs a new handle to the StateNode at the specified path of the snapshot of handler
+			 *
+			 * @param handler the SnapshotStateHandler of the state tree
+			 * @param path the complete path of the StateNode
+			 * @param index the index of the StateNode record within the snapshot
+			 */
+			SnapshotStateNode(SnapshotStateHandler& handler, const std::string& path, uint32_t index) ;
+
+			/**
+			 * Returns the index of the record of this StateNode within the current snapshot,
+			 * locating the record again by path should the snapshot have been reloaded
+			 *
+			 * @return the record index, or SnapshotStateHandler::NO_NODE if the StateNode is not within the snapshot
+			 */
+			uint32_t getIndex() const ;
+
+			/**
+			 * Returns the path of the named child of the StateNode with the specified path
+			 *
+			 * @param path the path of the parent StateNode
+			 * @param name the name of the child
+			 * @return the path of the child
+			 */
+			static std::string childPath(const std::string& path, const std::string& name) ;
+
+			/** the SnapshotStateHandler of the state tree */
+			SnapshotStateHandler& theHandler ;
+
+			/** the complete path of this StateNode */
+			std::string thePath ;
+
+			/** the index of the StateNode record within the snapshot, valid for theGeneration */
+			mutable uint32_t theIndex ;
+
+			/** the generation of the snapshot theIndex was located within */
+			mutable unsigned long theGeneration ;
+
+	} ; /* class SnapshotStateNode */
+
+} /* namespace cutil */
+
+#endif /* _CUTIL_SNAPSHOTSTATENODE_H_ */
@@ -202,6 +202,16 @@ namespace cutil
 			 */
 			virtual void removeValue(const std::string& name) = 0 ;
 
+			/**
+			 * Populate the specified list with the names of all values stored within this StateNode
+			 * The list is not cleared prior to any additions.
+			 * The default implementation adds no names, for StateNodes which cannot list their values.
+			 *
+			 * @param nameList the list to populate
+			 * @return the number of elements added to the list
+			 */
+			virtual int getValueNames(std::list<std::string>& nameList) ;
+
 
 
 			//---------------------------------------------------------------------------------------//
@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#ifndef _CUTIL_SYMBOLTABLE_
+#define _CUTIL_SYMBOLTABLE_
+
+#include <cutil/SharedLibrary.h>
+#include <cutil/SharedLibraryException.h>
+
+#include <string>
+#include <vector>
+
+namespace cutil
+{
+	/**
+	 * SymbolTable binds a declared list of SharedLibrary symbols to the function pointer members of a struct.
+	 * T is a plain struct of function pointers. Each member is declared once with the name of the
+	 * symbol it is bound to, after which bind resolves every declared symbol within an open
+	 * SharedLibrary and assigns the members of a T. Calls through the bound T are then direct
+	 * indirect calls, with no further symbol lookup.
+	 *
+	 * <pre>
+	 * struct CodecSymbols
+	 * {
+	 *     int (*encode)(const char*, size_t) ;
+	 *     void (*reset)() ;
+	 * } ;
+	 *
+	 * SymbolTable<CodecSymbols> table ;
+	 * table.declare("codec_encode", &CodecSymbols::encode).declare("codec_reset", &CodecSymbols::reset) ;
+	 *
+	 * CodecSymbols codec ;
+	 * table.bind(library, codec) ;
+	 * codec.encode(data, size) ;
+	 * </pre>
+	 *
+	 * The bound function pointers remain valid only while the SharedLibrary remains open.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	template <class T>
+	class SymbolTable
+	{
+		public:
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Constructs a new SymbolTable with no declared symbols
+			 *
+			 */
+			SymbolTable() ;
+
+			/**
+			 * Destructor
+			 *
+			 */
+			~SymbolTable() ;
+
+
+			//-------------------------------------------------------------------------------//
+			// Symbol Declaration
+
+			/**
+			 * Declares that the specified member of T is bound to the specified symbol
+			 *
+			 * @param symbol the name of the symbol within the SharedLibrary
+			 * @param member the function pointer member of T to which the symbol is bound
+			 * @return this SymbolTable, allowing declarations to be chained
+			 */
+			template <class F>
+			SymbolTable<T>& declare(const std::string& symbol, F T::* member) ;
+
+			/**
+			 * Returns the number of declared symbols
+			 *
+			 * @return the number of declared symbols
+			 */
+			size_t getSymbolCount() const ;
+
+
+			//-------------------------------------------------------------------------------//
+			// Symbol Binding
+
+			/**
+			 * Resolves all declared symbols within the specified SharedLibrary and assigns them to table.
+			 * The SharedLibrary is opened if not already open. If any symbol cannot be resolved,
+			 * table is left unchanged.
+			 *
+			 * @param library the SharedLibrary containing the symbols
+			 * @param table the struct to which the resolved symbols are assigned
+			 * @return table with all declared members bound
+			 * @throw SharedLibraryException if the SharedLibrary cannot be opened, or a declared
+			 *        symbol cannot be resolved
+			 */
+			T& bind(SharedLibrary& library, T& table) const throw(SharedLibraryException) ;
+
+			//---------------------------------------------------------------------------------------//
+
+		protected:
+
+			//---------------------------------------------------------------------------------------//
+
+		private:
+
+			/**
+			 * Binds a single symbol to a member of T
+			 */
+			class Binding
+			{
+				public:
+					Binding(const std::string& symbol) : theSymbol(symbol) {}
+					virtual ~Binding() {}
+
+					/**
+					 * Resolves the symbol within library and assigns it to the bound member of table
+					 *
+					 * @param library the SharedLibrary containing the symbol
+					 * @param table the struct to which the resolved symbol is assigned
+					 * @throw SharedLibraryException if the symbol cannot be resolved
+					 */
+					virtual void bind(SharedLibrary& library, T& table) const throw(SharedLibraryException) = 0 ;
+
+				protected:
+					/** the name of the symbol */
+					std::string theSymbol ;
+			} ;
+
+			/**
+			 * Binding of a symbol to a member of function pointer type F
+			 */
+			template <class F>
+			class MemberBinding : public Binding
+			{
+				public:
+					MemberBinding(const std::string& symbol, F T::* member) : Binding(symbol), theMember(member) {}
+
+					virtual void bind(SharedLibrary& library, T& table) const throw(SharedLibraryException)
+					{
+						table.*theMember = (F)library.getSymbol(this->theSymbol) ;
+					}
+
+				private:
+					/** the member of T to which the symbol is bound */
+					F T::* theMember ;
+			} ;
+
+			/**
+			 * Prevent copying of SymbolTable, which owns its Bindings
+			 *
+			 */
+			SymbolTable(const SymbolTable<T>& table) {}
+
+			/**
+			 * Prevent assignment of SymbolTable, which owns its Bindings
+			 *
+			 */
+			SymbolTable<T>& operator=(const SymbolTable<T>&) { return(*this) ; }
+
+			/** the declared symbol Bindings */
+			std::vector<Binding*> theBindings ;
+
+	} ; /* class SymbolTable */
+
+
+
+	//---------------------------------------------------------------------------------------//
+	// Template Implementation
+
+	template <class T>
+	SymbolTable<T>::SymbolTable()
+	{}
+
+	template <class T>
+	SymbolTable<T>::~SymbolTable()
+	{
+		for(typename std::vector<Binding*>::iterator iter = theBindings.begin() ; iter != theBindings.end() ; ++iter)
+		{
+			delete *iter ;
+		}
+	}
+
+	template <class T>
+	template <class F>
+	SymbolTable<T>&
+	SymbolTable<T>::declare(const std::string& symbol, F T::* member)
+	{
+		theBindings.push_back(new MemberBinding<F>(symbol, member)) ;
+		return(*this) ;
+	}
+
+	template <class T>
+	size_t
+	SymbolTable<T>::getSymbolCount() const
+	{
+		return(theBindings.size()) ;
+	}
+
+	template <class T>
+	T&
+	SymbolTable<T>::bind(SharedLibrary& library, T& table) const throw(SharedLibraryException)
+	{
+		if(!library.isOpen())
+		{
+			library.open() ;
+		}
+
+		// bind into a copy so a failure to resolve a symbol leaves table unchanged
+		T bound(table) ;
+		for(typename std::vector<Binding*>::const_iterator citer = theBindings.begin() ; citer != theBindings.end() ; ++citer)
+		{
+			(*citer)->bind(library, bound) ;
+		}
+
+		table = bound ;
+		return(table) ;
+	}
+
+} /* namespace cutil */
+
+#endif /* _CUTIL_SYMBOLTABLE_ */
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+
+#ifndef _CUTIL_THREADPOOL_H_
+#define _CUTIL_THREADPOOL_H_
+
+#include <cutil/Closure.h>
+#include <cutil/Condition.h>
+#include <cutil/Exception.h>
+#include <cutil/Mutex.h>
+
+#include <deque>
+#include <vector>
+
+#include <pthread.h>
+
+namespace cutil
+{
+	/**
+	 * A fixed size pool of worker threads executing queued tasks.
+	 * Tasks are AbstractClosure<void> objects, executed in submission order by the first available
+	 * worker thread. Any exception escaping a task is discarded.
+	 *
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class ThreadPool
+	{
+		public:
+			//-------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Creates a new ThreadPool and starts the specified number of worker threads
+			 *
+			 * @param threads the number of worker threads, 0 uses getDefaultThreadCount
+			 * @throw Exception if the worker threads cannot be started
+			 */
+			ThreadPool(size_t threads = 0) throw(Exception) ;
+
+			/**
+			 * Destructor.
+			 * Waits for all queued tasks to complete and stops the worker threads
+			 *
+			 */
+			virtual ~ThreadPool() ;
+
+			//-------------------------------------------------------------------------------//
+			// ThreadPool Operations
+
+			/**
+			 * Queues the specified task for execution.
+			 * The ThreadPool takes ownership of the task, deleting it once executed.
+			 *
+			 * @param task the task to execute
+			 * @throw Exception if this ThreadPool has been shutdown
+			 */
+			void execute(AbstractClosure<void>* task) throw(Exception) ;
+
+			/**
+			 * Blocks the calling thread until all queued tasks have completed.
+			 * Must not be called from a task executing within this ThreadPool
+			 *
+			 */
+			void waitIdle() ;
+
+			/**
+			 * Waits for all queued tasks to complete and stops the worker threads.
+			 * No further tasks may be queued once shutdown.
+			 *
+			 */
+			void shutdown() ;
+
+			/**
+			 * Returns the number of worker threads of this ThreadPool
+			 *
+			 * @return the number of worker threads
+			 */
+			size_t getThreadCount() const ;
+
+			/**
+			 * Returns the number of tasks queued, or executing
+			 *
+			 * @return the number of incomplete tasks
+			 */
+			size_t getPendingCount() const ;
+
+			/**
+			 * Returns the number of online processors, used as the default worker thread count
+			 *
+			 * @return the number of online processors, at least 1
+			 */
+			static size_t getDefaultThreadCount() ;
+
+			//-------------------------------------------------------------------------------//
+
+		protected:
+
+			//-------------------------------------------------------------------------------//
+
+		private:
+
+			/**
+			 * Dis-allow Copy constructor
+			 *
+			 */
+			ThreadPool(const ThreadPool&) {}
+
+			/**
+			 * Entry point of each worker thread
+			 *
+			 * @param pool the ThreadPool the thread belongs to
+			 */
+			static void* threadEntry(void* pool) ;
+
+			/**
+			 * Executes queued tasks until shutdown
+			 *
+			 */
+			void run() ;
+
+			/** the worker threads */
+			std::vector<pthread_t> theThreads ;
+
+			/** queued tasks */
+			std::deque<AbstractClosure<void>*> theTasks ;
+
+			/** number of tasks currently executing */
+			size_t theActiveCount ;
+
+			/** indicates shutdown has been requested */
+			bool theShutdownFlag ;
+
+			/** protects the task queue and counters */
+			mutable Mutex theMutex ;
+
+			/** signalled when a task is queued, or upon shutdown */
+			Condition theTaskCondition ;
+
+			/** signalled when the pool becomes idle */
+			Condition theIdleCondition ;
+
+	} ; /* class ThreadPool */
+
+} /* namespace cutil */
+
+
+#endif /* _CUTIL_THREADPOOL_H_ */
@@ -24,15 +24,25 @@
 
 #include <cutil/StateHandler.h>
 
+#include <cutil/Condition.h>
+#include <cutil/Exception.h>
+#include <cutil/Mutex.h>
 #include <cutil/RefCountPtr.h>
 
+#include <list>
 #include <map>
+#include <set>
 #include <string>
 
+#include <tr1/unordered_map>
+
+#include <pthread.h>
+
 namespace xmlpp
 {
 	class Document ;
 	class DomParser ;
+	class Element ;
 }
 
 
@@ -45,7 +55,11 @@ namespace cutil
 	 * State data set and accessed through a name/value scheme, where a value is associated
 	 * with a specified name. This name can later be used to access the named data value.
 	 *
-	 * Currently flush() and sync() are not fully implemented and should not be used
+	 * Modifications are tracked per StateNode. flush() and shutdown() write the document
+	 * only if a StateNode has been modified since the last write, replacing the data file
+	 * atomically through a synchronized temporary file. A flush delay may be set to write
+	 * modifications from a background thread instead, coalescing all modifications made
+	 * within the delay into a single write.
 	 *
 	 * @author Colin Law [claw@mail.berlios.de]
 	 * @version $Rev$
@@ -99,7 +113,11 @@ namespace cutil
 
 			/**
 			 * Force a write of state information back to the persistant store
+			 * The data file is written only if a StateNode has been modified since the last
+			 * write. The document is written to a temporary file which is synchronized to disk
+			 * and renamed over the data file, so the data file is never left partially written.
 			 *
+			 * @throw Exception if the data file cannot be written
 			 */
 			virtual void flush() ;
 
@@ -108,6 +126,8 @@ namespace cutil
 			 * This method ensures that this StateHandler has the most up to date information
 			 * from the persistant store. This may be useful if another componenet has access
 			 * to the backing store and may be making modification independant of this StateHandler
+			 * Unwritten modifications are discarded, and StateNodes previously returned must not
+			 * be used, they are obtained again through getRootNode
 			 *
 			 */
 			virtual void sync() ;
@@ -127,6 +147,69 @@ namespace cutil
 			 */
 			virtual RefCountPtr<StateNode> getRootNode() ;
 
+			//---------------------------------------------------------------------------------------//
+			// Modification Tracking
+
+			/**
+			 * Returns whether any StateNode has been modified since the data file was last
+			 * written or read
+			 *
+			 * @return true if a StateNode has been modified
+			 */
+			bool isDirty() const ;
+
+			/**
+			 * Populates the specified list with the paths of all StateNodes modified since the
+			 * data file was last written or read
+			 * The list is not cleared prior to any additions
+			 *
+			 * @param pathList the list to populate
+			 * @return the number of paths added to the list
+			 */
+			int getDirtyNodes(std::list<std::string>& pathList) const ;
+
+			/**
+			 * Sets the delay after which modifications are written to the data file from a
+			 * background thread. Modifications made within the delay of the first unwritten
+			 * modification are coalesced into a single write. A delay of 0 disables the
+			 * background flush, modifications are then written only by flush() and shutdown().
+			 * The background flush is disabled by default.
+			 *
+			 * @param msec the flush delay in milli seconds, 0 to disable the background flush
+			 * @throw Exception if the background thread cannot be started
+			 */
+			void setFlushDelay(unsigned long msec) throw(Exception) ;
+
+			/**
+			 * Returns the delay after which modifications are written to the data file from a
+			 * background thread, 0 if the background flush is disabled
+			 *
+			 * @return the flush delay in milli seconds
+			 */
+			unsigned long getFlushDelay() const ;
+
+			//---------------------------------------------------------------------------------------//
+			// Value Caching
+
+			/**
+			 * Sets whether values are cached as they are read.
+			 * With caching enabled, each value is located within the XML document, and parsed
+			 * into the type requested, only on its first access. Subsequent access is a hash
+			 * lookup of the cached value. Setting a value unchanged does not rewrite the document.
+			 * The cache is discarded whenever the document is parsed, and when a child StateNode
+			 * is removed. Caching is enabled by default.
+			 *
+			 * @param caching set true to cache values
+			 */
+			void setCaching(bool caching) ;
+
+			/**
+			 * Returns whether values are cached as they are read
+			 *
+			 * @return true if values are cached, false otherwise
+			 */
+			bool getCaching() const ;
+
 
 			/** the root node of the configuration data file */
 			static const std::string ROOT_NODE ;
@@ -217,6 +300,241 @@ namespace cutil
 					ChildHandleContainer theChildHandles ;
 			} ;
 
+			/**
+			 * Inner class to cache the name-value pairs of the document, shared by all
+			 * StateNodes of this StateHandler. Entries are keyed by the DOM Element of the
+			 * StateNode and the value name. Entries are added as values are read, so readers
+			 * as well as writers must hold the Mutex of the ChangeTracker.
+			 */
+			class ValueCache
+			{
+				public:
+					/**
+					 * A cached name-value pair, and its value parsed into each type once requested
+					 */
+					struct Entry
+					{
+						Entry() : theElement(0), theIntFlag(false), theInt(0), theDoubleFlag(false), theDouble(0.0), theBoolFlag(false), theBool(false) {}
+
+						/** the DOM Element of the name-value pair, 0 if the name has no value */
+						xmlpp::Element* theElement ;
+
+						/** the value string */
+						std::string theString ;
+
+						/** the parsed values, each valid once its flag is set */
+						bool theIntFlag ;
+						int theInt ;
+						bool theDoubleFlag ;
+						double theDouble ;
+						bool theBoolFlag ;
+						bool theBool ;
+					} ;
+
+					/**
+					 * Default Constructor, caching is enabled
+					 */
+					ValueCache() ;
+
+					/**
+					 * Destructor
+					 */
+					~ValueCache() ;
+
+					/**
+					 * Returns the cached entry of the named value of the specified StateNode Element
+					 *
+					 * @param node the DOM Element of the StateNode
+					 * @param name the name of the value
+					 * @return the cached entry, or 0 if the value is not cached
+					 */
+					Entry* find(const xmlpp::Element* node, const std::string& name) ;
+
+					/**
+					 * Returns the cached entry of the named value of the specified StateNode Element,
+					 * adding an empty entry if the value is not cached
+					 *
+					 * @param node the DOM Element of the StateNode
+					 * @param name the name of the value
+					 * @return the cached entry
+					 */
+					Entry& insert(const xmlpp::Element* node, const std::string& name) ;
+
+					/**
+					 * Removes the cached entry of the named value of the specified StateNode Element
+					 *
+					 * @param node the DOM Element of the StateNode
+					 * @param name the name of the value
+					 */
+					void remove(const xmlpp::Element* node, const std::string& name) ;
+
+					/**
+					 * Removes all cached entries
+					 */
+					void clear() ;
+
+					/**
+					 * Sets whether values are cached, disabling the cache clears it
+					 *
+					 * @param enabled set true to cache values
+					 */
+					void setEnabled(bool enabled) ;
+
+					/**
+					 * Returns whether values are cached
+					 *
+					 * @return true if values are cached
+					 */
+					bool isEnabled() const ;
+
+				protected:
+				private:
+					/**
+					 * Disallow copy constructor
+					 */
+					ValueCache(const ValueCache&) {} ;
+
+					/** cached entries of a StateNode by value name */
+					typedef std::tr1::unordered_map<std::string, Entry> EntryContainer ;
+
+					/** cached entries by StateNode Element */
+					typedef std::tr1::unordered_map<const xmlpp::Element*, EntryContainer> NodeContainer ;
+
+					/** the cached entries */
+					NodeContainer theNodes ;
+
+					/** indicates values are cached */
+					bool theEnabledFlag ;
+			} ;
+
+			/**
+			 * Inner class to track the modified StateNodes of the document, shared by all
+			 * StateNodes of this StateHandler. The Mutex of the tracker guards the document
+			 * and the ValueCache against concurrent writes to the data file, StateNodes must
+			 * hold the Mutex while accessing the document or the ValueCache.
+			 */
+			class ChangeTracker
+			{
+				public:
+					/**
+					 * Default Constructor
+					 *
+					 * @throw Exception if the Mutex or Condition cannot be created
+					 */
+					ChangeTracker() throw(Exception) ;
+
+					/**
+					 * Destructor
+					 */
+					~ChangeTracker() ;
+
+					/**
+					 * Returns the Mutex guarding the document and the modified StateNodes
+					 *
+					 * @return the Mutex guarding the document
+					 */
+					Mutex& getMutex() ;
+
+					/**
+					 * Marks the StateNode with the specified path modified, waking any thread
+					 * waiting upon the first modification.
+					 * The caller must hold the Mutex of this tracker
+					 *
+					 * @param path the path of the modified StateNode
+					 */
+					void markDirty(const std::string& path) ;
+
+					/**
+					 * Returns whether any StateNode is modified.
+					 * The caller must hold the Mutex of this tracker
+					 *
+					 * @return true if a StateNode is modified
+					 */
+					bool isDirty() const ;
+
+					/**
+					 * Returns the monotonic time, in seconds, of the first modification since
+					 * the modified StateNodes were last taken or cleared.
+					 * The caller must hold the Mutex of this tracker
+					 *
+					 * @return the time of the first modification
+					 */
+					double getDirtyTime() const ;
+
+					/**
+					 * Populates the specified list with the paths of the modified StateNodes.
+					 * The caller must hold the Mutex of this tracker
+					 *
+					 * @param pathList the list to populate
+					 * @return the number of paths added to the list
+					 */
+					int getDirtyNodes(std::list<std::string>& pathList) const ;
+
+					/**
+					 * Moves the paths of the modified StateNodes into the specified set, leaving
+					 * no StateNode marked modified.
+					 * The caller must hold the Mutex of this tracker
+					 *
+					 * @param paths the set to receive the modified paths
+					 */
+					void takeDirty(std::set<std::string>& paths) ;
+
+					/**
+					 * Marks the specified StateNodes modified again, after the modifications
+					 * taken with takeDirty could not be written
+					 * The caller must hold the Mutex of this tracker
+					 *
+					 * @param paths the paths of the StateNodes to mark modified
+					 */
+					void restoreDirty(const std::set<std::string>& paths) ;
+
+					/**
+					 * Marks all StateNodes unmodified
+					 * The caller must hold the Mutex of this tracker
+					 */
+					void clear() ;
+
+					/**
+					 * Waits at most usec micro seconds for a modification, or for wake to be called.
+					 * The caller must hold the Mutex of this tracker, a negative timeout waits
+					 * indefinitely
+					 *
+					 * @param usec the maximum time to wait in micro seconds
+					 */
+					void wait(long usec) ;
+
+					/**
+					 * Wakes all threads waiting within wait
+					 */
+					void wake() ;
+
+					/**
+					 * Returns the current monotonic time in seconds
+					 *
+					 * @return the current monotonic time
+					 */
+					static double now() ;
+
+				protected:
+				private:
+					/**
+					 * Disallow copy constructor
+					 */
+					ChangeTracker(const ChangeTracker&) {} ;
+
+					/** guards the document and the modified paths */
+					Mutex theMutex ;
+
+					/** signalled upon the first modification, or to wake waiting threads */
+					Condition theCondition ;
+
+					/** the paths of the modified StateNodes */
+					std::set<std::string> theDirtyPaths ;
+
+					/** monotonic time of the first modification */
+					double theDirtyTime ;
+			} ;
+
 			//---------------------------------------------------------------------------------------//
 		protected:
 
@@ -237,6 +555,42 @@ namespace cutil
 			 */
 			void createDefaultDocument() ;
 
+			/**
+			 * Writes the document to the data file if any StateNode has been modified since
+			 * the last write, replacing the data file atomically
+			 *
+			 * @throw Exception if the data file cannot be written
+			 */
+			void writeDocument() ;
+
+			/**
+			 * Starts the background flush thread
+			 *
+			 * @throw Exception if the thread cannot be started
+			 */
+			void startFlushThread() throw(Exception) ;
+
+			/**
+			 * Stops the background flush thread, waiting for any write in progress
+			 *
+			 */
+			void stopFlushThread() ;
+
+			/**
+			 * Writes modifications to the data file once the flush delay has passed since the
+			 * first modification, until the background flush thread is stopped
+			 *
+			 */
+			void runFlushThread() ;
+
+			/**
+			 * Entry point of the background flush thread
+			 *
+			 * @param handler the XMLStateHandler the thread flushes
+			 * @return 0
+			 */
+			static void* flushThreadEntry(void* handler) ;
+
 			/** the parsed XML state information */
 			xmlpp::Document* theConfigDomDocument ;
 
@@ -251,6 +605,27 @@ namespace cutil
 			
 			ChildHandleManager theChildHandleManager ;
 
+			/** cache of the values of the document */
+			ValueCache theValueCache ;
+
+			/** tracks the modified StateNodes, guarding the document */
+			mutable ChangeTracker theChangeTracker ;
+
+			/** serializes writes of the data file */
+			Mutex theWriteMutex ;
+
+			/** the background flush delay in milli seconds, guarded by the tracker Mutex */
+			unsigned long theFlushDelay ;
+
+			/** the background flush thread */
+			pthread_t theFlushThread ;
+
+			/** indicates the background flush thread is running */
+			bool theFlushThreadFlag ;
+
+			/** requests the background flush thread stop, guarded by the tracker Mutex */
+			bool theFlushStopFlag ;
+
 
 	} ; /* class XMLStateHandler */
 
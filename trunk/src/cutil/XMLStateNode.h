@@ -24,7 +24,7 @@
 
 #include <cutil/StateNode.h>
 
-#include <cutil/XMLStateHandler.h> // reg for XMLStateHandler::ChildHandleManager
+#include <cutil/XMLStateHandler.h> // reg for XMLStateHandler inner classes
 
 #include <string>
 
@@ -213,6 +213,15 @@ namespace cutil
 			 */
 			virtual void removeValue(const std::string& name) ;
 
+			/**
+			 * Populate the specified list with the names of all values stored within this StateNode
+			 * The list is not cleared prior to any additions
+			 *
+			 * @param nameList the list to populate
+			 * @return the number of elements added to the list
+			 */
+			virtual int getValueNames(std::list<std::string>& nameList) ;
+
 
 
 			/** node tag for configuration information */
@@ -246,8 +255,10 @@ namespace cutil
 			 * @param element the xmlpp::Element which stores the actual data
 			 * @param document the xml document we are acting as a state node for
 			 * @param childHandler the container to manage constructed state handlers
+			 * @param valueCache the cache of values shared by all state nodes of the document
+			 * @param changeTracker the tracker of modified state nodes of the document
 			 */
-			XMLStateNode(xmlpp::Element* element, xmlpp::Document* document, XMLStateHandler::ChildHandleManager& childHandler) ;
+			XMLStateNode(xmlpp::Element* element, xmlpp::Document* document, XMLStateHandler::ChildHandleManager& childHandler, XMLStateHandler::ValueCache& valueCache, XMLStateHandler::ChangeTracker& changeTracker) ;
 
 			/**
 			 * Constructs a new XMLStateNode with the specified parent Node and handled XML element.
@@ -259,8 +270,10 @@ namespace cutil
 			 * @param element the xmlpp::Element which stores the actual data
 			 * @param document the xml document we are acting as a state node for
 			 * @param childHandler the container to manage constructed state handlers
+			 * @param valueCache the cache of values shared by all state nodes of the document
+			 * @param changeTracker the tracker of modified state nodes of the document
 			 */
-			XMLStateNode(const std::string& path, RefCountPtr<StateNode> parent, xmlpp::Element* element, xmlpp::Document* document, XMLStateHandler::ChildHandleManager& childHandler) ;
+			XMLStateNode(const std::string& path, RefCountPtr<StateNode> parent, xmlpp::Element* element, xmlpp::Document* document, XMLStateHandler::ChildHandleManager& childHandler, XMLStateHandler::ValueCache& valueCache, XMLStateHandler::ChangeTracker& changeTracker) ;
 
 
 		private:
@@ -273,6 +286,27 @@ namespace cutil
 			 */
 			xmlpp::Element* getNameValueElement(const std::string& name) const ;
 
+			/**
+			 * Returns the cached entry of the named value, locating the value within the
+			 * document if it is not yet cached. The entry Element is 0 if the value does not exist.
+			 * If value caching is disabled, 0 is returned.
+			 * The caller must hold the Mutex of the ChangeTracker
+			 *
+			 * @param name the name associated with the value
+			 * @return the cached entry of the named value, or 0 if caching is disabled
+			 */
+			XMLStateHandler::ValueCache::Entry* lookupValue(const std::string& name) const ;
+
+			/**
+			 * Stores the specified value string associated with the specified name within the
+			 * document, updating the cached entry and marking this StateNode modified. The document
+			 * is not modified if the cached value is unchanged
+			 *
+			 * @param name name with which the specified value will be associated
+			 * @param value the value string to store with the specified name
+			 */
+			void storeValue(const std::string& name, const std::string& value) ;
+
 			/** this StateNodes complete path */
 			std::string thePath ;
 
@@ -288,6 +322,12 @@ namespace cutil
 			/** handler to manage constructed StateNodes */
 			XMLStateHandler::ChildHandleManager& theChildHandleManager ;
 
+			/** cache of values shared by all StateNodes of the document */
+			XMLStateHandler::ValueCache& theValueCache ;
+
+			/** tracker of modified StateNodes, guarding the document */
+			XMLStateHandler::ChangeTracker& theChangeTracker ;
+
 	} ; /* class XMLStateNode */
 
 } /* namespace cutil */
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2004-2005  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ * $Id$
+ */
+
+
+#ifndef _CUTIL_XMLSTREAMSTATEHANDLER_H_
+#define _CUTIL_XMLSTREAMSTATEHANDLER_H_
+
+#include <cutil/StateHandler.h>
+
+#include <cutil/Exception.h>
+#include <cutil/MemoryStateHandler.h>
+#include <cutil/RefCountPtr.h>
+
+#include <cstdio>
+#include <string>
+
+namespace cutil
+{
+	class StateNode ;
+
+	/**
+	 * StateHandler implementation reading and writing the XMLStateHandler file format as a stream.
+	 * The data file is read with a SAX parser, each config_node and config_param being added to
+	 * a MemoryStateHandler state tree as it is parsed, so no DOM document is held either while
+	 * loading or afterwards. flush() writes the state tree element by element as it is walked.
+	 * Memory use is therefore bounded by the state information itself, making this StateHandler
+	 * suited to very large state files.
+	 *
+	 * Values are held as strings when loaded, and converted on access as an XMLStateNode
+	 * converts them.
+	 *
+	 * @see XMLStateHandler
+	 * @see MemoryStateHandler
+	 * @author Colin Law [claw@mail.berlios.de]
+	 * @version $Rev$
+	 */
+	class XMLStreamStateHandler : public StateHandler
+	{
+		public:
+			//---------------------------------------------------------------------------------------//
+			// Constructor / Desctructor
+
+			/**
+			 * Constructs a new XMLStreamStateHandler to read and store state information within
+			 * the specified XML data file
+			 *
+			 * @param filename the file path of the XML data file
+			 * @param rootNode the name of the root element within the XML data file,
+			 *        if left blank, this will default to XMLStatehandler::ROOT_NODE
+			 */
+			XMLStreamStateHandler(const std::string& filename, const std::string& rootNode = "") ;
+
+			/**
+			 * Destructor
+			 */
+			virtual ~XMLStreamStateHandler() ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// StateHandler implementations
+
+			/**
+			 * Initialize this StateHandler.
+			 * Parses the XML data file into the state tree. If the file does not exist, or
+			 * cannot be parsed, the state tree is empty.
+			 */
+			virtual void initialize() ;
+
+			/**
+			 * Shutdown this StateHandler.
+			 * Writes any modifications to the XML data file and releases the state tree
+			 */
+			virtual void shutdown() ;
+
+			//---------------------------------------------------------------------------------------//
+			// Update Control
+
+			/**
+			 * Force a write of state information back to the persistant store
+			 * The XML data file is written only if the state tree has been modified. The file is
+			 * written to a temporary file which is synchronized to disk and renamed over the data file.
+			 *
+			 * @throw Exception if the XML data file cannot be written
+			 */
+			virtual void flush() ;
+
+			/**
+			 * Synchronize this StateHandler to the persistant store of state information,
+			 * The XML data file is parsed again, discarding any unwritten modifications
+			 */
+			virtual void sync() ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// StateNode Access
+
+			/**
+			 * Returns the root StateNode within the state tree of this StateHandler
+			 * This method returns a user handle for the underlying data of the StateNode
+			 * implementation. Subsequent calls to getRootNode need not return the same
+			 * handle instance, however, it is guaranteed that each will be a handle to
+			 * the same underlying data instance.
+			 *
+			 * @return the root StateNode within the state tree of this StateHandler
+			 */
+			virtual RefCountPtr<StateNode> getRootNode() ;
+
+
+			//---------------------------------------------------------------------------------------//
+			// Stream Handling
+
+			/**
+			 * Returns whether the state tree has been modified since the XML data file was last
+			 * written or parsed
+			 *
+			 * @return true if the state tree has been modified
+			 */
+			bool isDirty() const ;
+
+			/**
+			 * Writes the state tree of the specified StateHandler to the specified file in the
+			 * XMLStateHandler file format, without building a DOM document.
+			 * The file is atomically replaced, being written to a uniquely named temporary file
+			 * which is synchronized to disk and renamed over the specified file.
+			 *
+			 * @param source the initialized StateHandler to write
+			 * @param filename the path of the XML data file
+			 * @param rootNode the name of the root element,
+			 *        if left blank, this will default to XMLStatehandler::ROOT_NODE
+			 * @throw Exception if the XML data file cannot be written
+			 */
+			static void writeState(StateHandler& source, const std::string& filename, const std::string& rootNode = "") throw(Exception) ;
+
+			//---------------------------------------------------------------------------------------//
+
+		protected:
+
+			//---------------------------------------------------------------------------------------//
+
+		private:
+			/**
+			 * FilePath::ContentWriter writing a state tree as an XML document
+			 */
+			class StateWriter ;
+
+			/**
+			 * Disallow copy constructor
+			 */
+			XMLStreamStateHandler(const XMLStreamStateHandler&) {} ;
+
+			/**
+			 * Parses the XML data file into the state tree, leaving the state tree empty if
+			 * the file does not exist or cannot be parsed
+			 */
+			void load() ;
+
+			/**
+			 * Writes the values and child StateNodes of the specified StateNode, recursively,
+			 * to the specified stream
+			 *
+			 * @param out the stream to write to
+			 * @param node the StateNode to write
+			 * @param depth the nesting depth of the StateNode, used for indentation
+			 */
+			static void writeNode(FILE* out, StateNode& node, int depth) ;
+
+			/**
+			 * Writes the specified string as an XML attribute value to the specified stream,
+			 * escaping markup characters
+			 *
+			 * @param out the stream to write to
+			 * @param s the string to write
+			 */
+			static void writeEscaped(FILE* out, const std::string& s) ;
+
+			/** the XML data file */
+			std::string theDataFile ;
+
+			/** the name of the root element within the XML data file */
+			std::string theRootNodeName ;
+
+			/** the state tree */
+			MemoryStateHandler theState ;
+
+			/** the modification count of the state tree when last written or parsed */
+			unsigned long theWrittenCount ;
+
+	} ; /* class XMLStreamStateHandler */
+
+} /* namespace cutil */
+
+#endif /* _CUTIL_XMLSTREAMSTATEHANDLER_H_ */
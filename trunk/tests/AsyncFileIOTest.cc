@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "AsyncFileIOTest.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/AsyncFileIO.h>
+#include <cutil/Assert.h>
+#include <cutil/Exception.h>
+#include <cutil/FilePath.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+namespace
+{
+	/**
+	 * Creates an AsyncFileIO upon the specified backend, or returns NULL if the backend
+	 * is unavailable on this system
+	 */
+	cutil::AsyncFileIO* createIO(cutil::AsyncFileIO::BackendEnum backend)
+	{
+		try
+		{
+			return(new cutil::AsyncFileIO(4, 4096, backend)) ;
+		}
+		catch(cutil::Exception& e)
+		{
+			if(backend != cutil::AsyncFileIO::BACKEND_URING_ENUM)
+			{
+				throw ;
+			}
+		}
+
+		// io_uring is unavailable, or disabled, the automatic backend must fall back
+		cutil::AsyncFileIO fallback(4, 4096) ;
+		cutil::Assert::isTrue(fallback.getBackend() == cutil::AsyncFileIO::BACKEND_THREAD_POOL_ENUM) ;
+
+		return(0) ;
+	}
+
+	/**
+	 * Writes more blocks than may be in flight, reads them back and checks the contents,
+	 * lengths and user data of every Completion
+	 */
+	void roundTrip(cutil::AsyncFileIO::BackendEnum backend)
+	{
+		std::auto_ptr<cutil::AsyncFileIO> io(createIO(backend)) ;
+		if(io.get() == 0)
+		{
+			return ;
+		}
+
+		cutil::Assert::isTrue(io->getBackend() == backend) ;
+		cutil::Assert::areEqual(static_cast<size_t>(4), io->getMaxInFlight()) ;
+
+		TempFile file("AsyncFileIOTest") ;
+		const size_t blocks = 16 ;
+		const size_t block_size = 1000 ;
+
+		// submission beyond the in flight bound waits for a completion
+		for(size_t i = 0; i < blocks; i++)
+		{
+			std::string block(block_size, static_cast<char>('a' + i)) ;
+			io->submitWrite(file.getPath(), i * block_size, block.data(), block.size(), reinterpret_cast<void*>(i + 1)) ;
+			cutil::Assert::isTrue(io->getOutstanding() <= blocks) ;
+		}
+
+		std::vector<cutil::AsyncFileIO::Completion> completions ;
+		while(completions.size() < blocks)
+		{
+			io->reap(completions, blocks - completions.size()) ;
+		}
+		cutil::Assert::areEqual(static_cast<size_t>(0), io->getOutstanding()) ;
+
+		std::vector<bool> seen(blocks, false) ;
+		for(size_t i = 0; i < completions.size(); i++)
+		{
+			size_t index = reinterpret_cast<size_t>(completions[i].theUserData) - 1 ;
+			cutil::Assert::isTrue(completions[i].theOperation == cutil::AsyncFileIO::WRITE_ENUM) ;
+			cutil::Assert::areEqual(static_cast<ssize_t>(block_size), completions[i].theResult) ;
+			cutil::Assert::areEqual(static_cast<off_t>(index * block_size), completions[i].theOffset) ;
+			cutil::Assert::isTrue(completions[i].theBuffer == 0) ;
+			seen[index] = true ;
+		}
+		for(size_t i = 0; i < blocks; i++)
+		{
+			cutil::Assert::isTrue(seen[i]) ;
+		}
+
+		for(size_t i = 0; i < blocks; i++)
+		{
+			io->submitRead(file.getPath(), i * block_size, block_size, reinterpret_cast<void*>(i + 1)) ;
+		}
+
+		// a read larger than a pooled buffer, and a short read at end of file
+		io->submitRead(file.getPath(), 0, 10000, 0) ;
+		io->submitRead(file.getPath(), blocks * block_size - 10, 100, reinterpret_cast<void*>(-1)) ;
+
+		completions.clear() ;
+		while(completions.size() < blocks + 2)
+		{
+			io->reap(completions, blocks + 2 - completions.size()) ;
+		}
+
+		for(size_t i = 0; i < completions.size(); i++)
+		{
+			cutil::AsyncFileIO::Completion& completion = completions[i] ;
+			cutil::Assert::isTrue(completion.theOperation == cutil::AsyncFileIO::READ_ENUM) ;
+			cutil::Assert::isTrue(completion.theBuffer != 0) ;
+
+			if(completion.theUserData == 0)
+			{
+				cutil::Assert::areEqual(static_cast<ssize_t>(10000), completion.theResult) ;
+				cutil::Assert::areEqual(std::string(block_size, 'a'), std::string(completion.theBuffer, block_size)) ;
+				cutil::Assert::areEqual(std::string(block_size, 'j'), std::string(completion.theBuffer + 9 * block_size, block_size)) ;
+			}
+			else if(completion.theUserData == reinterpret_cast<void*>(-1))
+			{
+				cutil::Assert::areEqual(static_cast<ssize_t>(10), completion.theResult) ;
+				cutil::Assert::areEqual(std::string(10, 'p'), std::string(completion.theBuffer, 10)) ;
+			}
+			else
+			{
+				size_t index = reinterpret_cast<size_t>(completion.theUserData) - 1 ;
+				cutil::Assert::areEqual(static_cast<ssize_t>(block_size), completion.theResult) ;
+				cutil::Assert::areEqual(std::string(block_size, static_cast<char>('a' + index)), std::string(completion.theBuffer, block_size)) ;
+			}
+
+			io->releaseBuffer(completion.theBuffer) ;
+		}
+
+		// nothing outstanding, reap returns immediately
+		completions.clear() ;
+		cutil::Assert::areEqual(static_cast<size_t>(0), io->reap(completions, 1, -1)) ;
+	}
+
+	/**
+	 * Checks a file which cannot be opened is reported through a failed Completion
+	 */
+	void missingFileFails(cutil::AsyncFileIO::BackendEnum backend)
+	{
+		std::auto_ptr<cutil::AsyncFileIO> io(createIO(backend)) ;
+		if(io.get() == 0)
+		{
+			return ;
+		}
+
+		io->submitRead(cutil::FilePath("/nonexistent/AsyncFileIOTest"), 0, 100) ;
+		io->submitWrite(cutil::FilePath("/nonexistent/AsyncFileIOTest"), 0, "x", 1) ;
+
+		std::vector<cutil::AsyncFileIO::Completion> completions ;
+		cutil::Assert::areEqual(static_cast<size_t>(2), io->reap(completions, 2, 0)) ;
+
+		for(size_t i = 0; i < completions.size(); i++)
+		{
+			cutil::Assert::areEqual(static_cast<ssize_t>(-1), completions[i].theResult) ;
+			cutil::Assert::areEqual(ENOENT, completions[i].theError) ;
+			if(completions[i].theBuffer != 0)
+			{
+				io->releaseBuffer(completions[i].theBuffer) ;
+			}
+		}
+	}
+
+	/**
+	 * Submits writes without reaping, checking flush starts them
+	 */
+	void flushStartsRequests(cutil::AsyncFileIO::BackendEnum backend)
+	{
+		std::auto_ptr<cutil::AsyncFileIO> io(createIO(backend)) ;
+		if(io.get() == 0)
+		{
+			return ;
+		}
+
+		TempFile file("AsyncFileIOTest") ;
+		std::string block(1000, 'x') ;
+		for(int i = 0; i < 3; i++)
+		{
+			io->submitWrite(file.getPath(), i * block.size(), block.data(), block.size()) ;
+		}
+		io->flush() ;
+		cutil::Assert::areEqual(static_cast<size_t>(3), io->getOutstanding()) ;
+
+		// the writes complete without a reap entering the kernel
+		struct stat st ;
+		st.st_size = 0 ;
+		for(int i = 0; i < 200 && st.st_size < 3000; i++)
+		{
+			::usleep(10000) ;
+			::stat(file.getPath().c_str(), &st) ;
+		}
+		cutil::Assert::areEqual(static_cast<long>(3000), static_cast<long>(st.st_size)) ;
+
+		std::vector<cutil::AsyncFileIO::Completion> completions ;
+		cutil::Assert::areEqual(static_cast<size_t>(3), io->reap(completions, 3, 0)) ;
+		for(size_t i = 0; i < completions.size(); i++)
+		{
+			cutil::Assert::areEqual(static_cast<ssize_t>(1000), completions[i].theResult) ;
+		}
+	}
+}
+
+AsyncFileIOTest::AsyncFileIOTest() : cutil::AbstractUnitTest("AsyncFileIO Test", "cutil")
+{
+}
+
+void
+AsyncFileIOTest::uringRoundTrip()
+{
+	roundTrip(cutil::AsyncFileIO::BACKEND_URING_ENUM) ;
+}
+
+void
+AsyncFileIOTest::threadPoolRoundTrip()
+{
+	roundTrip(cutil::AsyncFileIO::BACKEND_THREAD_POOL_ENUM) ;
+}
+
+void
+AsyncFileIOTest::uringMissingFileFails()
+{
+	missingFileFails(cutil::AsyncFileIO::BACKEND_URING_ENUM) ;
+}
+
+void
+AsyncFileIOTest::threadPoolMissingFileFails()
+{
+	missingFileFails(cutil::AsyncFileIO::BACKEND_THREAD_POOL_ENUM) ;
+}
+
+void
+AsyncFileIOTest::uringFlushStartsRequests()
+{
+	flushStartsRequests(cutil::AsyncFileIO::BACKEND_URING_ENUM) ;
+}
+
+void
+AsyncFileIOTest::threadPoolFlushStartsRequests()
+{
+	flushStartsRequests(cutil::AsyncFileIO::BACKEND_THREAD_POOL_ENUM) ;
+}
+
+void
+AsyncFileIOTest::autoSelectsBackend()
+{
+	cutil::AsyncFileIO io ;
+	cutil::Assert::isTrue(io.getBackend() != cutil::AsyncFileIO::BACKEND_AUTO_ENUM) ;
+	cutil::Assert::areEqual(static_cast<size_t>(32), io.getMaxInFlight()) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), io.getOutstanding()) ;
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+AsyncFileIOTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<AsyncFileIOTest>(this, &AsyncFileIOTest::uringRoundTrip, "uringRoundTrip", "", ""));
+	test_cases.push_back(makeTestCase<AsyncFileIOTest>(this, &AsyncFileIOTest::threadPoolRoundTrip, "threadPoolRoundTrip", "", ""));
+	test_cases.push_back(makeTestCase<AsyncFileIOTest>(this, &AsyncFileIOTest::uringMissingFileFails, "uringMissingFileFails", "", ""));
+	test_cases.push_back(makeTestCase<AsyncFileIOTest>(this, &AsyncFileIOTest::threadPoolMissingFileFails, "threadPoolMissingFileFails", "", ""));
+	test_cases.push_back(makeTestCase<AsyncFileIOTest>(this, &AsyncFileIOTest::uringFlushStartsRequests, "uringFlushStartsRequests", "", ""));
+	test_cases.push_back(makeTestCase<AsyncFileIOTest>(this, &AsyncFileIOTest::threadPoolFlushStartsRequests, "threadPoolFlushStartsRequests", "", ""));
+	test_cases.push_back(makeTestCase<AsyncFileIOTest>(this, &AsyncFileIOTest::autoSelectsBackend, "autoSelectsBackend", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
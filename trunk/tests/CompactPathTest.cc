@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "CompactPathTest.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/CompactPath.h>
+#include <cutil/RefCountPtr.h>
+
+#include <string>
+
+using namespace cutil::unit_tests ;
+
+using cutil::CompactPath ;
+
+CompactPathTest::CompactPathTest() : cutil::AbstractUnitTest("CompactPath Test", "cutil")
+{
+}
+
+void
+CompactPathTest::pathIsCleaned()
+{
+	CompactPath path("  /usr//local///lib/ ") ;
+	cutil::Assert::areEqual(std::string("/usr/local/lib"), path.getPath()) ;
+	cutil::Assert::areEqual(size_t(14), path.getLength()) ;
+	cutil::Assert::isTrue(path.isAbsolute()) ;
+
+	CompactPath relative("a/b") ;
+	cutil::Assert::isFalse(relative.isAbsolute()) ;
+	cutil::Assert::isTrue(CompactPath().isEmpty()) ;
+}
+
+void
+CompactPathTest::rootIsKept()
+{
+	CompactPath root("//") ;
+	cutil::Assert::areEqual(std::string("/"), root.getPath()) ;
+	cutil::Assert::areEqual(size_t(0), root.getComponentCount()) ;
+	cutil::Assert::isTrue(root.getParent().isEmpty()) ;
+
+	CompactPath child(root, "etc") ;
+	cutil::Assert::areEqual(std::string("/etc"), child.getPath()) ;
+	cutil::Assert::areEqual(std::string("/"), child.getParent().getPath()) ;
+}
+
+void
+CompactPathTest::childIsAppended()
+{
+	CompactPath parent("/usr") ;
+	CompactPath child(parent, "/include//sys/") ;
+	cutil::Assert::areEqual(std::string("/usr/include/sys"), child.getPath()) ;
+
+	child.append("types.h") ;
+	cutil::Assert::areEqual(std::string("/usr/include/sys/types.h"), child.getPath()) ;
+
+	child.append("") ;
+	cutil::Assert::areEqual(std::string("/usr/include/sys/types.h"), child.getPath()) ;
+}
+
+void
+CompactPathTest::longPathIsHeld()
+{
+	std::string expected ;
+	CompactPath path ;
+	for(int i = 0 ; i < 40 ; ++i)
+	{
+		expected.append("/component") ;
+		path.append(i == 0 ? "/component" : "component") ;
+	}
+
+	cutil::Assert::areEqual(expected, path.getPath()) ;
+	cutil::Assert::areEqual(size_t(40), path.getComponentCount()) ;
+
+	CompactPath copy(path) ;
+	cutil::Assert::isTrue(copy == path) ;
+
+	char buffer[8] ;
+	cutil::Assert::areEqual(expected.size(), path.copyTo(buffer, sizeof(buffer))) ;
+}
+
+void
+CompactPathTest::leafAndParent()
+{
+	CompactPath path("/var/log/messages") ;
+	cutil::Assert::isTrue(path.getLeaf().equals("messages")) ;
+	cutil::Assert::areEqual(std::string("/var/log"), path.getParent().getPath()) ;
+	cutil::Assert::areEqual(std::string("/var"), path.getParent().getParent().getPath()) ;
+	cutil::Assert::areEqual(std::string("/"), path.getParent().getParent().getParent().getPath()) ;
+
+	CompactPath single("name") ;
+	cutil::Assert::isTrue(single.getLeaf().equals("name")) ;
+	cutil::Assert::isTrue(single.getParent().isEmpty()) ;
+}
+
+void
+CompactPathTest::componentsAreIterated()
+{
+	CompactPath dir("/usr/share") ;
+	dir.intern() ;
+	CompactPath path(dir, "doc/readme") ;
+
+	const char* expected[] = { "usr", "share", "doc", "readme" } ;
+	size_t count = 0 ;
+
+	CompactPath::ComponentIterator iter(path) ;
+	while(iter.hasNext())
+	{
+		CompactPath::Component component = iter.next() ;
+		cutil::Assert::isTrue(count < 4) ;
+		cutil::Assert::isTrue(component.equals(expected[count])) ;
+		++count ;
+	}
+
+	cutil::Assert::areEqual(size_t(4), count) ;
+}
+
+void
+CompactPathTest::internedPrefixIsShared()
+{
+	CompactPath dir("/home/user/projects") ;
+	dir.intern() ;
+	cutil::Assert::isTrue(dir.isInterned()) ;
+	cutil::Assert::areEqual(std::string("/home/user/projects"), dir.getPath()) ;
+
+	CompactPath child(dir, "cutil") ;
+	cutil::Assert::isTrue(child.isInterned()) ;
+	cutil::Assert::areEqual(std::string("/home/user/projects/cutil"), child.getPath()) ;
+	cutil::Assert::isTrue(child.getLeaf().equals("cutil")) ;
+	cutil::Assert::isTrue(child.getParent() == dir) ;
+
+	char buffer[64] ;
+	cutil::Assert::areEqual(size_t(25), child.copyTo(buffer, sizeof(buffer))) ;
+	cutil::Assert::areEqual(std::string("/home/user/projects/cutil"), std::string(buffer)) ;
+
+	CompactPath plain("/home/user/projects/cutil") ;
+	cutil::Assert::isTrue(plain == child) ;
+	cutil::Assert::areEqual(plain.hash(), child.hash()) ;
+}
+
+void
+CompactPathTest::pathsCompare()
+{
+	CompactPath dir("/a") ;
+	dir.intern() ;
+
+	CompactPath first(dir, "b") ;
+	CompactPath second("/a/c") ;
+
+	cutil::Assert::isTrue(first < second) ;
+	cutil::Assert::isFalse(second < first) ;
+	cutil::Assert::isTrue(first != second) ;
+	cutil::Assert::areEqual(0, first.compare(CompactPath("/a/b"))) ;
+	cutil::Assert::isTrue(CompactPath("/a") < first) ;
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+CompactPathTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<CompactPathTest>(this, &CompactPathTest::pathIsCleaned, "pathIsCleaned", "", ""));
+	test_cases.push_back(makeTestCase<CompactPathTest>(this, &CompactPathTest::rootIsKept, "rootIsKept", "", ""));
+	test_cases.push_back(makeTestCase<CompactPathTest>(this, &CompactPathTest::childIsAppended, "childIsAppended", "", ""));
+	test_cases.push_back(makeTestCase<CompactPathTest>(this, &CompactPathTest::longPathIsHeld, "longPathIsHeld", "", ""));
+	test_cases.push_back(makeTestCase<CompactPathTest>(this, &CompactPathTest::leafAndParent, "leafAndParent", "", ""));
+	test_cases.push_back(makeTestCase<CompactPathTest>(this, &CompactPathTest::componentsAreIterated, "componentsAreIterated", "", ""));
+	test_cases.push_back(makeTestCase<CompactPathTest>(this, &CompactPathTest::internedPrefixIsShared, "internedPrefixIsShared", "", ""));
+	test_cases.push_back(makeTestCase<CompactPathTest>(this, &CompactPathTest::pathsCompare, "pathsCompare", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
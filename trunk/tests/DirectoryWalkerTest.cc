@@ -0,0 +1,415 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "DirectoryWalkerTest.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/DirectoryWalker.h>
+#include <cutil/FilePath.h>
+#include <cutil/Mutex.h>
+#include <cutil/ThreadPool.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+namespace
+{
+	/**
+	 * Creates a tree of 4 directories, each of 2 subdirectories, each of 3 files, 36 entries
+	 */
+	void makeTree(const TempDirectory& root)
+	{
+		for(int d = 0; d < 4; d++)
+		{
+			char dir[32] ;
+			std::snprintf(dir, sizeof(dir), "d%d", d) ;
+			::mkdir(root.getPath(dir).c_str(), 0755) ;
+
+			for(int s = 0; s < 2; s++)
+			{
+				char sub[32] ;
+				std::snprintf(sub, sizeof(sub), "d%d/s%d", d, s) ;
+				::mkdir(root.getPath(sub).c_str(), 0755) ;
+
+				for(int f = 0; f < 3; f++)
+				{
+					char file[32] ;
+					std::snprintf(file, sizeof(file), "d%d/s%d/f%d", d, s, f) ;
+					::close(::open(root.getPath(file).c_str(), O_WRONLY|O_CREAT, 0644)) ;
+				}
+			}
+		}
+	}
+
+	/**
+	 * Counts the entries visited and left, and the thread visiting each
+	 */
+	class RecordingVisitor : public cutil::DirectoryWalker::Visitor
+	{
+		public:
+			RecordingVisitor()
+				: theCaller(::pthread_self()), theVisitCount(0), theLeaveCount(0), theCallerCount(0), theInvalidLeaveCount(0)
+			{
+				for(size_t i = 0; i < 4; i++)
+				{
+					theDepthCounts[i] = 0 ;
+					theCallerDepthCounts[i] = 0 ;
+				}
+			}
+
+			virtual cutil::DirectoryWalker::VisitResultEnum visit(const cutil::DirectoryWalker::Entry& entry)
+			{
+				cutil::MutexLock lock(theMutex) ;
+
+				bool caller = ::pthread_equal(::pthread_self(), theCaller) ;
+				size_t depth = (entry.theDepth < 4) ? entry.theDepth : 3 ;
+
+				theVisitCount++ ;
+				theDepthCounts[depth]++ ;
+				if(caller)
+				{
+					theCallerCount++ ;
+					theCallerDepthCounts[depth]++ ;
+				}
+
+				thePaths.append(entry.thePath, entry.thePathLength).append(";") ;
+				return(cutil::DirectoryWalker::CONTINUE_ENUM) ;
+			}
+
+			virtual void leave(const cutil::DirectoryWalker::Entry& entry)
+			{
+				cutil::MutexLock lock(theMutex) ;
+
+				theLeaveCount++ ;
+				if(entry.theDirFd < 0)
+				{
+					theInvalidLeaveCount++ ;
+				}
+			}
+
+			/**
+			 * Returns the number of entries at or below depth visited by a pool thread
+			 */
+			size_t getPoolCount(size_t depth) const
+			{
+				size_t count = 0 ;
+				for(size_t i = depth; i < 4; i++)
+				{
+					count += theDepthCounts[i] - theCallerDepthCounts[i] ;
+				}
+				return(count) ;
+			}
+
+			/**
+			 * Returns the number of entries at or below depth
+			 */
+			size_t getCount(size_t depth) const
+			{
+				size_t count = 0 ;
+				for(size_t i = depth; i < 4; i++)
+				{
+					count += theDepthCounts[i] ;
+				}
+				return(count) ;
+			}
+
+			pthread_t theCaller ;
+			size_t theVisitCount ;
+			size_t theLeaveCount ;
+			size_t theCallerCount ;
+			size_t theInvalidLeaveCount ;
+			size_t theDepthCounts[4] ;
+			size_t theCallerDepthCounts[4] ;
+			std::string thePaths ;
+
+		private:
+			cutil::Mutex theMutex ;
+	} ;
+
+	/**
+	 * Replaces the directory d0 with a symbolic link to another directory as it is
+	 * visited, before it is opened
+	 */
+	class SwappingVisitor : public RecordingVisitor
+	{
+		public:
+			SwappingVisitor(const TempDirectory& root, const std::string& target)
+				: theRoot(root), theTarget(target)
+			{}
+
+			virtual cutil::DirectoryWalker::VisitResultEnum visit(const cutil::DirectoryWalker::Entry& entry)
+			{
+				if(std::string(entry.theName) == "d0")
+				{
+					::rename(theRoot.getPath("d0").c_str(), theRoot.getPath("moved").c_str()) ;
+					if(::symlink(theTarget.c_str(), theRoot.getPath("d0").c_str()) != 0)
+					{
+						std::perror("symlink") ;
+					}
+				}
+				return(RecordingVisitor::visit(entry)) ;
+			}
+
+		private:
+			const TempDirectory& theRoot ;
+			std::string theTarget ;
+	} ;
+
+	/**
+	 * Stops the walk at the first file named f1, recording the directories holding
+	 * a visited entry and the directories left
+	 */
+	class StoppingVisitor : public cutil::DirectoryWalker::Visitor
+	{
+		public:
+			virtual cutil::DirectoryWalker::VisitResultEnum visit(const cutil::DirectoryWalker::Entry& entry)
+			{
+				cutil::MutexLock lock(theMutex) ;
+
+				std::string path(entry.thePath, entry.thePathLength) ;
+				theParents.insert(path.substr(0, path.rfind('/'))) ;
+
+				if(std::string(entry.theName) == "f1")
+				{
+					return(cutil::DirectoryWalker::STOP_ENUM) ;
+				}
+				return(cutil::DirectoryWalker::CONTINUE_ENUM) ;
+			}
+
+			virtual void leave(const cutil::DirectoryWalker::Entry& entry)
+			{
+				cutil::MutexLock lock(theMutex) ;
+				theLeft.insert(std::string(entry.thePath, entry.thePathLength)) ;
+			}
+
+			/**
+			 * Returns true if every directory below root holding a visited entry was left
+			 */
+			bool isBalanced(const std::string& root) const
+			{
+				for(std::set<std::string>::const_iterator i = theParents.begin(); i != theParents.end(); ++i)
+				{
+					if((*i != root) && (theLeft.find(*i) == theLeft.end()))
+					{
+						return(false) ;
+					}
+				}
+				return(true) ;
+			}
+
+			std::set<std::string> theParents ;
+			std::set<std::string> theLeft ;
+
+		private:
+			cutil::Mutex theMutex ;
+	} ;
+}
+
+DirectoryWalkerTest::DirectoryWalkerTest() : cutil::AbstractUnitTest("DirectoryWalker Test", "cutil")
+{
+}
+
+void
+DirectoryWalkerTest::serialWalkVisitsTree()
+{
+	TempDirectory root("DirectoryWalkerTest") ;
+	makeTree(root) ;
+
+	cutil::DirectoryWalker walker ;
+	RecordingVisitor visitor ;
+	cutil::Assert::isTrue(walker.walk(cutil::FilePath(root.getPath()), visitor)) ;
+
+	cutil::Assert::areEqual(static_cast<size_t>(36), visitor.theVisitCount) ;
+	cutil::Assert::areEqual(static_cast<size_t>(12), visitor.theLeaveCount) ;
+	cutil::Assert::areEqual(static_cast<size_t>(36), visitor.theCallerCount) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), visitor.theInvalidLeaveCount) ;
+
+	walker.setMaxDepth(0) ;
+	RecordingVisitor shallow ;
+	walker.walk(cutil::FilePath(root.getPath()), shallow) ;
+	cutil::Assert::areEqual(static_cast<size_t>(4), shallow.theVisitCount) ;
+}
+
+void
+DirectoryWalkerTest::parallelWalkReachesPool()
+{
+	TempDirectory root("DirectoryWalkerTest") ;
+	makeTree(root) ;
+
+	cutil::ThreadPool pool(4) ;
+	cutil::DirectoryWalker walker ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), walker.getParallelDepth()) ;
+
+	RecordingVisitor visitor ;
+	cutil::Assert::isTrue(walker.walk(cutil::FilePath(root.getPath()), visitor, pool)) ;
+
+	cutil::Assert::areEqual(static_cast<size_t>(36), visitor.theVisitCount) ;
+	cutil::Assert::areEqual(static_cast<size_t>(12), visitor.theLeaveCount) ;
+
+	// the root is listed by the caller, each of its subdirectories is walked by the pool
+	cutil::Assert::areEqual(static_cast<size_t>(4), visitor.theCallerCount) ;
+	cutil::Assert::areEqual(static_cast<size_t>(32), visitor.getPoolCount(1)) ;
+
+	// directories left within a task are reported relative to their parent
+	cutil::Assert::areEqual(static_cast<size_t>(0), visitor.theInvalidLeaveCount) ;
+}
+
+void
+DirectoryWalkerTest::parallelDepthZeroWalksSerially()
+{
+	TempDirectory root("DirectoryWalkerTest") ;
+	makeTree(root) ;
+
+	cutil::ThreadPool pool(4) ;
+	cutil::DirectoryWalker walker ;
+	walker.setParallelDepth(0) ;
+
+	RecordingVisitor visitor ;
+	walker.walk(cutil::FilePath(root.getPath()), visitor, pool) ;
+
+	cutil::Assert::areEqual(static_cast<size_t>(36), visitor.theVisitCount) ;
+	cutil::Assert::areEqual(static_cast<size_t>(36), visitor.theCallerCount) ;
+}
+
+void
+DirectoryWalkerTest::parallelDepthTwoFansOutDeeper()
+{
+	TempDirectory root("DirectoryWalkerTest") ;
+	makeTree(root) ;
+
+	cutil::ThreadPool pool(4) ;
+	cutil::DirectoryWalker walker ;
+	walker.setParallelDepth(2) ;
+
+	RecordingVisitor visitor ;
+	walker.walk(cutil::FilePath(root.getPath()), visitor, pool) ;
+
+	cutil::Assert::areEqual(static_cast<size_t>(36), visitor.theVisitCount) ;
+	cutil::Assert::areEqual(static_cast<size_t>(12), visitor.theLeaveCount) ;
+	cutil::Assert::areEqual(static_cast<size_t>(4), visitor.theCallerCount) ;
+
+	// files are listed by the tasks walking their subdirectories
+	cutil::Assert::areEqual(static_cast<size_t>(24), visitor.getCount(2)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(24), visitor.getPoolCount(2)) ;
+}
+
+void
+DirectoryWalkerTest::replacedDirectoryIsNotFollowed()
+{
+	TempDirectory root("DirectoryWalkerTest") ;
+	makeTree(root) ;
+
+	TempDirectory outside("DirectoryWalkerTest") ;
+	::close(::open(outside.getPath("secret").c_str(), O_WRONLY|O_CREAT, 0644)) ;
+
+	// the directory is replaced between being listed and being opened by its task
+	cutil::ThreadPool pool(4) ;
+	cutil::DirectoryWalker walker ;
+
+	SwappingVisitor visitor(root, outside.getPath()) ;
+	walker.walk(cutil::FilePath(root.getPath()), visitor, pool) ;
+
+	cutil::Assert::isTrue(visitor.thePaths.find("secret") == std::string::npos, visitor.thePaths) ;
+	cutil::Assert::isTrue(visitor.thePaths.find(outside.getPath()) == std::string::npos, visitor.thePaths) ;
+}
+
+void
+DirectoryWalkerTest::parallelLinkLoopIsSkipped()
+{
+	TempDirectory root("DirectoryWalkerTest") ;
+	makeTree(root) ;
+
+	// a link from within a subdirectory back to the root
+	if(::symlink(root.getPath().c_str(), root.getPath("d0/s0/loop").c_str()) != 0)
+	{
+		std::perror("symlink") ;
+	}
+
+	cutil::DirectoryWalker walker ;
+	walker.setFollowSymLinks(true) ;
+
+	RecordingVisitor serial ;
+	walker.walk(cutil::FilePath(root.getPath()), serial) ;
+	cutil::Assert::areEqual(static_cast<size_t>(37), serial.theVisitCount) ;
+
+	// the link is followed within a task, which must see the root upon its path
+	cutil::ThreadPool pool(4) ;
+	walker.setParallelDepth(3) ;
+
+	RecordingVisitor parallel ;
+	walker.walk(cutil::FilePath(root.getPath()), parallel, pool) ;
+	cutil::Assert::areEqual(static_cast<size_t>(37), parallel.theVisitCount) ;
+	cutil::Assert::areEqual(static_cast<size_t>(12), parallel.theLeaveCount) ;
+}
+
+void
+DirectoryWalkerTest::stoppedWalkLeavesDirectories()
+{
+	TempDirectory root("DirectoryWalkerTest") ;
+	makeTree(root) ;
+
+	cutil::DirectoryWalker walker ;
+	StoppingVisitor serial ;
+	cutil::Assert::isFalse(walker.walk(cutil::FilePath(root.getPath()), serial)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(2), serial.theLeft.size()) ;
+	cutil::Assert::isTrue(serial.isBalanced(root.getPath())) ;
+
+	// the directories handed to the pool are left just as those walked serially
+	cutil::ThreadPool pool(4) ;
+	for(int parallel_depth = 1; parallel_depth <= 2; parallel_depth++)
+	{
+		walker.setParallelDepth(parallel_depth) ;
+
+		StoppingVisitor parallel ;
+		cutil::Assert::isFalse(walker.walk(cutil::FilePath(root.getPath()), parallel, pool)) ;
+		cutil::Assert::isFalse(parallel.theLeft.empty()) ;
+		cutil::Assert::isTrue(parallel.isBalanced(root.getPath())) ;
+	}
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+DirectoryWalkerTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<DirectoryWalkerTest>(this, &DirectoryWalkerTest::serialWalkVisitsTree, "serialWalkVisitsTree", "", ""));
+	test_cases.push_back(makeTestCase<DirectoryWalkerTest>(this, &DirectoryWalkerTest::parallelWalkReachesPool, "parallelWalkReachesPool", "", ""));
+	test_cases.push_back(makeTestCase<DirectoryWalkerTest>(this, &DirectoryWalkerTest::parallelDepthZeroWalksSerially, "parallelDepthZeroWalksSerially", "", ""));
+	test_cases.push_back(makeTestCase<DirectoryWalkerTest>(this, &DirectoryWalkerTest::parallelDepthTwoFansOutDeeper, "parallelDepthTwoFansOutDeeper", "", ""));
+	test_cases.push_back(makeTestCase<DirectoryWalkerTest>(this, &DirectoryWalkerTest::replacedDirectoryIsNotFollowed, "replacedDirectoryIsNotFollowed", "", ""));
+	test_cases.push_back(makeTestCase<DirectoryWalkerTest>(this, &DirectoryWalkerTest::parallelLinkLoopIsSkipped, "parallelLinkLoopIsSkipped", "", ""));
+	test_cases.push_back(makeTestCase<DirectoryWalkerTest>(this, &DirectoryWalkerTest::stoppedWalkLeavesDirectories, "stoppedWalkLeavesDirectories", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
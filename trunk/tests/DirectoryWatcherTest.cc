@@ -0,0 +1,446 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "DirectoryWatcherTest.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/DirectoryWatcher.h>
+#include <cutil/Exception.h>
+#include <cutil/FilePath.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+using cutil::DirectoryWatcher ;
+using cutil::FilePath ;
+
+namespace
+{
+	/**
+	 * Creates a file, writing a single byte to it
+	 */
+	void writeFile(const std::string& path)
+	{
+		int fd = ::open(path.c_str(), O_WRONLY|O_CREAT|O_APPEND, 0644) ;
+		if(::write(fd, "x", 1) != 1)
+		{
+			// the missing write event fails the test
+		}
+		::close(fd) ;
+	}
+
+	/**
+	 * Returns the or'ed events reported for the specified path, 0 if none were reported
+	 */
+	int eventsFor(const std::vector<DirectoryWatcher::Event>& events, const std::string& path)
+	{
+		int found = 0 ;
+		for(std::vector<DirectoryWatcher::Event>::const_iterator iter = events.begin() ; iter != events.end() ; ++iter)
+		{
+			if(iter->thePath == path)
+			{
+				found |= iter->theEvents ;
+			}
+		}
+		return(found) ;
+	}
+
+	/**
+	 * Returns the number of events reported for the specified path
+	 */
+	size_t countFor(const std::vector<DirectoryWatcher::Event>& events, const std::string& path)
+	{
+		size_t count = 0 ;
+		for(std::vector<DirectoryWatcher::Event>::const_iterator iter = events.begin() ; iter != events.end() ; ++iter)
+		{
+			if(iter->thePath == path)
+			{
+				count++ ;
+			}
+		}
+		return(count) ;
+	}
+
+	/**
+	 * Reads events until none arrive for 100ms
+	 */
+	void readAll(DirectoryWatcher& watcher, std::vector<DirectoryWatcher::Event>& events)
+	{
+		while(watcher.readEvents(events, 100000) > 0)
+		{
+		}
+	}
+
+	/**
+	 * Writes 5 files, 20ms apart, into a directory
+	 */
+	void* writeBurst(void* arg)
+	{
+		const TempDirectory* root = static_cast<const TempDirectory*>(arg) ;
+		for(int i = 0; i < 5; i++)
+		{
+			::usleep(20000) ;
+			writeFile(root->getPath(std::string("burst").append(1, static_cast<char>('0' + i)))) ;
+		}
+		return(NULL) ;
+	}
+}
+
+DirectoryWatcherTest::DirectoryWatcherTest()
+	: cutil::AbstractUnitTest("DirectoryWatcher Test", "cutil")
+{}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+DirectoryWatcherTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<DirectoryWatcherTest>(this, &DirectoryWatcherTest::missingDirectoryIsRejected, "missingDirectoryIsRejected", "", "")) ;
+	test_cases.push_back(makeTestCase<DirectoryWatcherTest>(this, &DirectoryWatcherTest::fileIsRejected, "fileIsRejected", "", "")) ;
+	test_cases.push_back(makeTestCase<DirectoryWatcherTest>(this, &DirectoryWatcherTest::changesAreReported, "changesAreReported", "", "")) ;
+	test_cases.push_back(makeTestCase<DirectoryWatcherTest>(this, &DirectoryWatcherTest::unwatchedEventsAreFiltered, "unwatchedEventsAreFiltered", "", "")) ;
+	test_cases.push_back(makeTestCase<DirectoryWatcherTest>(this, &DirectoryWatcherTest::recursiveWatchCoversTree, "recursiveWatchCoversTree", "", "")) ;
+	test_cases.push_back(makeTestCase<DirectoryWatcherTest>(this, &DirectoryWatcherTest::createdSubdirectoryIsWatched, "createdSubdirectoryIsWatched", "", "")) ;
+	test_cases.push_back(makeTestCase<DirectoryWatcherTest>(this, &DirectoryWatcherTest::movedSubdirectoryIsWatched, "movedSubdirectoryIsWatched", "", "")) ;
+	test_cases.push_back(makeTestCase<DirectoryWatcherTest>(this, &DirectoryWatcherTest::changesToPathAreCoalesced, "changesToPathAreCoalesced", "", "")) ;
+	test_cases.push_back(makeTestCase<DirectoryWatcherTest>(this, &DirectoryWatcherTest::coalesceIntervalAbsorbsBurst, "coalesceIntervalAbsorbsBurst", "", "")) ;
+	test_cases.push_back(makeTestCase<DirectoryWatcherTest>(this, &DirectoryWatcherTest::descriptorSignalsPendingEvents, "descriptorSignalsPendingEvents", "", "")) ;
+
+	// copy on return
+	return(test_cases) ;
+}
+
+void
+DirectoryWatcherTest::missingDirectoryIsRejected()
+{
+	TempDirectory root("DirectoryWatcherTest") ;
+	DirectoryWatcher watcher ;
+
+	bool thrown = false ;
+	try
+	{
+		watcher.watch(FilePath(root.getPath("missing"))) ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown, "watching a missing directory throws") ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), watcher.getWatchCount()) ;
+	cutil::Assert::isFalse(watcher.unwatch(FilePath(root.getPath("missing")))) ;
+}
+
+void
+DirectoryWatcherTest::fileIsRejected()
+{
+	TempDirectory root("DirectoryWatcherTest") ;
+	::close(::open(root.getPath("file").c_str(), O_WRONLY|O_CREAT, 0644)) ;
+	DirectoryWatcher watcher ;
+
+	std::string message ;
+	try
+	{
+		watcher.watch(FilePath(root.getPath("file"))) ;
+	}
+	catch(cutil::Exception& e)
+	{
+		message = e.toString() ;
+	}
+	cutil::Assert::isTrue(message.find(::strerror(ENOTDIR)) != std::string::npos, "watching a file reports ENOTDIR") ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), watcher.getWatchCount()) ;
+}
+
+void
+DirectoryWatcherTest::changesAreReported()
+{
+	TempDirectory root("DirectoryWatcherTest") ;
+	DirectoryWatcher watcher ;
+	watcher.watch(FilePath(root.getPath())) ;
+
+	std::vector<DirectoryWatcher::Event> events ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), watcher.readEvents(events, 0)) ;
+
+	writeFile(root.getPath("file")) ;
+	::mkdir(root.getPath("dir").c_str(), 0755) ;
+	readAll(watcher, events) ;
+
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::CREATED_ENUM | DirectoryWatcher::MODIFIED_ENUM | DirectoryWatcher::WRITTEN_ENUM), eventsFor(events, root.getPath("file"))) ;
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::CREATED_ENUM), eventsFor(events, root.getPath("dir"))) ;
+	for(size_t i = 0; i < events.size(); i++)
+	{
+		cutil::Assert::areEqual(events[i].thePath == root.getPath("dir"), events[i].theIsDirectory) ;
+	}
+
+	events.clear() ;
+	::rename(root.getPath("file").c_str(), root.getPath("renamed").c_str()) ;
+	::unlink(root.getPath("renamed").c_str()) ;
+	::rmdir(root.getPath("dir").c_str()) ;
+	readAll(watcher, events) ;
+
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::MOVED_FROM_ENUM), eventsFor(events, root.getPath("file"))) ;
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::MOVED_TO_ENUM | DirectoryWatcher::DELETED_ENUM), eventsFor(events, root.getPath("renamed"))) ;
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::DELETED_ENUM), eventsFor(events, root.getPath("dir"))) ;
+
+	unsigned int from_cookie = 0 ;
+	unsigned int to_cookie = 0 ;
+	for(size_t i = 0; i < events.size(); i++)
+	{
+		if(events[i].thePath == root.getPath("file"))
+		{
+			from_cookie = events[i].theCookie ;
+		}
+		else if(events[i].thePath == root.getPath("renamed"))
+		{
+			to_cookie = events[i].theCookie ;
+		}
+	}
+	cutil::Assert::isTrue(from_cookie != 0, "rename carries a cookie") ;
+	cutil::Assert::areEqual(from_cookie, to_cookie) ;
+
+	cutil::Assert::isTrue(watcher.unwatch(FilePath(root.getPath()))) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), watcher.getWatchCount()) ;
+}
+
+void
+DirectoryWatcherTest::unwatchedEventsAreFiltered()
+{
+	TempDirectory root("DirectoryWatcherTest") ;
+	DirectoryWatcher watcher ;
+	watcher.watch(FilePath(root.getPath()), false, DirectoryWatcher::DELETED_ENUM) ;
+
+	std::vector<DirectoryWatcher::Event> events ;
+	writeFile(root.getPath("file")) ;
+	readAll(watcher, events) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), events.size()) ;
+
+	::unlink(root.getPath("file").c_str()) ;
+	readAll(watcher, events) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), events.size()) ;
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::DELETED_ENUM), events[0].theEvents) ;
+
+	// watching again replaces the watched changes
+	events.clear() ;
+	watcher.watch(FilePath(root.getPath()), false, DirectoryWatcher::CREATED_ENUM) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), watcher.getWatchCount()) ;
+	writeFile(root.getPath("file")) ;
+	::unlink(root.getPath("file").c_str()) ;
+	readAll(watcher, events) ;
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::CREATED_ENUM), eventsFor(events, root.getPath("file"))) ;
+}
+
+void
+DirectoryWatcherTest::recursiveWatchCoversTree()
+{
+	TempDirectory root("DirectoryWatcherTest") ;
+	::mkdir(root.getPath("a").c_str(), 0755) ;
+	::mkdir(root.getPath("a/b").c_str(), 0755) ;
+	::mkdir(root.getPath("a/b/c").c_str(), 0755) ;
+	::mkdir(root.getPath(".hidden").c_str(), 0755) ;
+	writeFile(root.getPath("a/file")) ;
+
+	DirectoryWatcher flat ;
+	flat.watch(FilePath(root.getPath())) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), flat.getWatchCount()) ;
+
+	DirectoryWatcher watcher ;
+	watcher.watch(FilePath(root.getPath()), true) ;
+	cutil::Assert::areEqual(static_cast<size_t>(5), watcher.getWatchCount()) ;
+
+	std::vector<DirectoryWatcher::Event> events ;
+	writeFile(root.getPath("a/b/c/deep")) ;
+	writeFile(root.getPath(".hidden/file")) ;
+	readAll(watcher, events) ;
+	cutil::Assert::isTrue((eventsFor(events, root.getPath("a/b/c/deep")) & DirectoryWatcher::CREATED_ENUM) != 0, "deep file reported") ;
+	cutil::Assert::isTrue((eventsFor(events, root.getPath(".hidden/file")) & DirectoryWatcher::CREATED_ENUM) != 0, "hidden file reported") ;
+
+	// unwatching a subdirectory of a recursive watch removes its own subdirectories
+	cutil::Assert::isTrue(watcher.unwatch(FilePath(root.getPath("a/b")))) ;
+	cutil::Assert::areEqual(static_cast<size_t>(3), watcher.getWatchCount()) ;
+
+	cutil::Assert::isTrue(watcher.unwatch(FilePath(root.getPath()))) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), watcher.getWatchCount()) ;
+}
+
+void
+DirectoryWatcherTest::createdSubdirectoryIsWatched()
+{
+	TempDirectory root("DirectoryWatcherTest") ;
+	DirectoryWatcher watcher ;
+	watcher.watch(FilePath(root.getPath()), true) ;
+
+	// entries created before the new directory is watched are reported by its scan
+	::mkdir(root.getPath("sub").c_str(), 0755) ;
+	::mkdir(root.getPath("sub/inner").c_str(), 0755) ;
+	writeFile(root.getPath("sub/inner/early")) ;
+
+	std::vector<DirectoryWatcher::Event> events ;
+	readAll(watcher, events) ;
+	cutil::Assert::areEqual(static_cast<size_t>(3), watcher.getWatchCount()) ;
+	cutil::Assert::isTrue((eventsFor(events, root.getPath("sub")) & DirectoryWatcher::CREATED_ENUM) != 0, "sub reported") ;
+	cutil::Assert::isTrue((eventsFor(events, root.getPath("sub/inner")) & DirectoryWatcher::CREATED_ENUM) != 0, "sub/inner reported") ;
+	cutil::Assert::isTrue((eventsFor(events, root.getPath("sub/inner/early")) & DirectoryWatcher::CREATED_ENUM) != 0, "early file reported") ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), countFor(events, root.getPath("sub/inner")), "scanned and notified entries are coalesced") ;
+
+	events.clear() ;
+	writeFile(root.getPath("sub/inner/late")) ;
+	readAll(watcher, events) ;
+	cutil::Assert::isTrue((eventsFor(events, root.getPath("sub/inner/late")) & DirectoryWatcher::CREATED_ENUM) != 0, "late file reported") ;
+
+	// a removed subdirectory is forgotten once the kernel drops its watch
+	events.clear() ;
+	::unlink(root.getPath("sub/inner/early").c_str()) ;
+	::unlink(root.getPath("sub/inner/late").c_str()) ;
+	::rmdir(root.getPath("sub/inner").c_str()) ;
+	readAll(watcher, events) ;
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::DELETED_ENUM), eventsFor(events, root.getPath("sub/inner"))) ;
+	cutil::Assert::areEqual(static_cast<size_t>(2), watcher.getWatchCount()) ;
+}
+
+void
+DirectoryWatcherTest::movedSubdirectoryIsWatched()
+{
+	TempDirectory root("DirectoryWatcherTest") ;
+	TempDirectory outside("DirectoryWatcherTest") ;
+	::mkdir(root.getPath("watched").c_str(), 0755) ;
+	::mkdir(outside.getPath("incoming").c_str(), 0755) ;
+	::mkdir(outside.getPath("incoming/nested").c_str(), 0755) ;
+	writeFile(outside.getPath("incoming/nested/file")) ;
+
+	DirectoryWatcher watcher ;
+	watcher.watch(FilePath(root.getPath("watched")), true) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), watcher.getWatchCount()) ;
+
+	std::vector<DirectoryWatcher::Event> events ;
+	::rename(outside.getPath("incoming").c_str(), root.getPath("watched/incoming").c_str()) ;
+	readAll(watcher, events) ;
+	cutil::Assert::areEqual(static_cast<size_t>(3), watcher.getWatchCount()) ;
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::MOVED_TO_ENUM), eventsFor(events, root.getPath("watched/incoming"))) ;
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::CREATED_ENUM), eventsFor(events, root.getPath("watched/incoming/nested"))) ;
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::CREATED_ENUM), eventsFor(events, root.getPath("watched/incoming/nested/file"))) ;
+
+	events.clear() ;
+	writeFile(root.getPath("watched/incoming/nested/later")) ;
+	readAll(watcher, events) ;
+	cutil::Assert::isTrue((eventsFor(events, root.getPath("watched/incoming/nested/later")) & DirectoryWatcher::CREATED_ENUM) != 0, "file in moved directory reported") ;
+
+	// moving the directory out stops watching it and its subdirectories
+	events.clear() ;
+	::rename(root.getPath("watched/incoming").c_str(), root.getPath("gone").c_str()) ;
+	readAll(watcher, events) ;
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::MOVED_FROM_ENUM), eventsFor(events, root.getPath("watched/incoming"))) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), watcher.getWatchCount()) ;
+
+	events.clear() ;
+	writeFile(root.getPath("gone/nested/after")) ;
+	readAll(watcher, events) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), events.size(), "moved out directory is not reported") ;
+}
+
+void
+DirectoryWatcherTest::changesToPathAreCoalesced()
+{
+	TempDirectory root("DirectoryWatcherTest") ;
+	DirectoryWatcher watcher ;
+	watcher.watch(FilePath(root.getPath())) ;
+
+	for(int i = 0; i < 10; i++)
+	{
+		writeFile(root.getPath("file")) ;
+	}
+	writeFile(root.getPath("other")) ;
+
+	std::vector<DirectoryWatcher::Event> events ;
+	cutil::Assert::areEqual(static_cast<size_t>(2), watcher.readEvents(events, 1000000)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(2), events.size()) ;
+	cutil::Assert::areEqual(root.getPath("file"), events[0].thePath, "events are ordered by first change") ;
+	cutil::Assert::areEqual(static_cast<int>(DirectoryWatcher::CREATED_ENUM | DirectoryWatcher::MODIFIED_ENUM | DirectoryWatcher::WRITTEN_ENUM), events[0].theEvents) ;
+	cutil::Assert::areEqual(root.getPath("other"), events[1].thePath) ;
+}
+
+void
+DirectoryWatcherTest::coalesceIntervalAbsorbsBurst()
+{
+	TempDirectory root("DirectoryWatcherTest") ;
+	DirectoryWatcher watcher ;
+	watcher.watch(FilePath(root.getPath())) ;
+	watcher.setCoalesceInterval(500000) ;
+	cutil::Assert::areEqual(500000L, watcher.getCoalesceInterval()) ;
+
+	pthread_t thread ;
+	::pthread_create(&thread, NULL, writeBurst, &root) ;
+
+	// the first write starts the batch, the remainder arrive within the interval
+	std::vector<DirectoryWatcher::Event> events ;
+	size_t count = watcher.readEvents(events, 1000000) ;
+	::pthread_join(thread, NULL) ;
+
+	cutil::Assert::areEqual(static_cast<size_t>(5), count) ;
+	for(int i = 0; i < 5; i++)
+	{
+		std::string path = root.getPath(std::string("burst").append(1, static_cast<char>('0' + i))) ;
+		cutil::Assert::areEqual(static_cast<size_t>(1), countFor(events, path)) ;
+	}
+
+	// without an interval the batch ends once pending events are read
+	events.clear() ;
+	watcher.setCoalesceInterval(0) ;
+	::pthread_create(&thread, NULL, writeBurst, &root) ;
+	count = watcher.readEvents(events, 1000000) ;
+	::pthread_join(thread, NULL) ;
+	cutil::Assert::isTrue(count >= 1 && count < 5, "burst split across reads") ;
+}
+
+void
+DirectoryWatcherTest::descriptorSignalsPendingEvents()
+{
+	TempDirectory root("DirectoryWatcherTest") ;
+	DirectoryWatcher watcher ;
+	watcher.watch(FilePath(root.getPath())) ;
+
+	struct pollfd pfd ;
+	pfd.fd = watcher.getFileDescriptor() ;
+	pfd.events = POLLIN ;
+	pfd.revents = 0 ;
+	cutil::Assert::areEqual(0, ::poll(&pfd, 1, 0)) ;
+
+	writeFile(root.getPath("file")) ;
+	cutil::Assert::areEqual(1, ::poll(&pfd, 1, 1000)) ;
+	cutil::Assert::isTrue((pfd.revents & POLLIN) != 0) ;
+
+	std::vector<DirectoryWatcher::Event> events ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), watcher.readEvents(events, 0)) ;
+	cutil::Assert::areEqual(0, ::poll(&pfd, 1, 0), "events are drained") ;
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "FilePathTest.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/Exception.h>
+#include <cutil/FilePath.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <list>
+#include <sstream>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+using cutil::FilePath ;
+
+namespace
+{
+	/**
+	 * Returns the content of the specified file
+	 */
+	std::string readFile(const std::string& path)
+	{
+		std::ifstream in(path.c_str()) ;
+		std::ostringstream buf ;
+		buf << in.rdbuf() ;
+		return(buf.str()) ;
+	}
+
+	/**
+	 * Returns the permissions of the specified file
+	 */
+	int getMode(const std::string& path)
+	{
+		struct stat st ;
+		return((::stat(path.c_str(), &st) == 0) ? static_cast<int>(st.st_mode & 07777) : -1) ;
+	}
+}
+
+FilePathTest::FilePathTest()
+	: cutil::AbstractUnitTest("FilePath Test", "cutil")
+{}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+FilePathTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<FilePathTest>(this, &FilePathTest::replaceFileCreatesFile, "replaceFileCreatesFile", "", "")) ;
+	test_cases.push_back(makeTestCase<FilePathTest>(this, &FilePathTest::replaceFileRetainsMode, "replaceFileRetainsMode", "", "")) ;
+	test_cases.push_back(makeTestCase<FilePathTest>(this, &FilePathTest::replaceFileLeavesNoTemporary, "replaceFileLeavesNoTemporary", "", "")) ;
+	test_cases.push_back(makeTestCase<FilePathTest>(this, &FilePathTest::failedReplaceLeavesFile, "failedReplaceLeavesFile", "", "")) ;
+
+	// copy on return
+	return(test_cases) ;
+}
+
+void
+FilePathTest::replaceFileCreatesFile()
+{
+	TempDirectory dir("FilePathTest") ;
+	FilePath path(dir.getPath("data")) ;
+
+	path.replaceFile("first", 0600) ;
+	cutil::Assert::areEqual(std::string("first"), readFile(path.getPath())) ;
+	cutil::Assert::areEqual(0600, getMode(path.getPath())) ;
+
+	// an empty content is written
+	path.replaceFile("") ;
+	cutil::Assert::isTrue(path.exists()) ;
+	cutil::Assert::areEqual(std::string(), readFile(path.getPath())) ;
+}
+
+void
+FilePathTest::replaceFileRetainsMode()
+{
+	TempDirectory dir("FilePathTest") ;
+	FilePath path(dir.getPath("data")) ;
+
+	path.replaceFile("first") ;
+	cutil::Assert::areEqual(0644, getMode(path.getPath())) ;
+
+	::chmod(path.getPath().c_str(), 0640) ;
+	path.replaceFile(std::string(100000, 'x'), 0600) ;
+	cutil::Assert::areEqual(0640, getMode(path.getPath())) ;
+	cutil::Assert::areEqual(std::string(100000, 'x'), readFile(path.getPath())) ;
+}
+
+void
+FilePathTest::replaceFileLeavesNoTemporary()
+{
+	TempDirectory dir("FilePathTest") ;
+	FilePath path(dir.getPath("data")) ;
+
+	// a temporary file left by an earlier writer is not reused
+	FilePath(dir.getPath("data.tmp")).replaceFile("stale") ;
+
+	for(int i = 0 ; i < 10 ; ++i)
+	{
+		path.replaceFile("content") ;
+	}
+
+	std::list<std::string> files ;
+	FilePath(dir.getPath()).getFiles(files) ;
+	cutil::Assert::areEqual(2, static_cast<int>(files.size())) ;
+	cutil::Assert::areEqual(std::string("stale"), readFile(dir.getPath("data.tmp"))) ;
+	cutil::Assert::areEqual(std::string("content"), readFile(path.getPath())) ;
+}
+
+void
+FilePathTest::failedReplaceLeavesFile()
+{
+	TempDirectory dir("FilePathTest") ;
+	FilePath path(dir.getPath("data")) ;
+	path.replaceFile("first") ;
+
+	// the rename fails, a directory cannot be replaced by a file
+	FilePath target(dir.getPath("directory")) ;
+	target.createDir(false) ;
+	FilePath(dir.getPath("directory/entry")).replaceFile("entry") ;
+
+	bool thrown = false ;
+	try
+	{
+		target.replaceFile("second") ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown) ;
+
+	// the temporary file is removed
+	std::list<std::string> files ;
+	FilePath(dir.getPath()).getFiles(files) ;
+	cutil::Assert::areEqual(2, static_cast<int>(files.size())) ;
+	cutil::Assert::areEqual(std::string("first"), readFile(path.getPath())) ;
+
+	// the directory does not exist
+	thrown = false ;
+	try
+	{
+		FilePath(dir.getPath("missing/data")).replaceFile("second") ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown) ;
+}
+
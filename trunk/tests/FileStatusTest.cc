@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "FileStatusTest.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/FilePath.h>
+#include <cutil/FileStatus.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+
+using namespace cutil::unit_tests ;
+
+using cutil::FilePath ;
+using cutil::FileStatus ;
+
+namespace
+{
+	/**
+	 * Creates a file of the specified size and mode
+	 */
+	void makeFile(const std::string& path, size_t size, mode_t mode)
+	{
+		int fd = ::open(path.c_str(), O_WRONLY|O_CREAT|O_TRUNC, mode) ;
+		std::string data(size, 'x') ;
+		if(::write(fd, data.data(), data.size()) != static_cast<ssize_t>(data.size()))
+		{
+			// a short file fails the size comparisons
+		}
+		::fchmod(fd, mode) ;
+		::close(fd) ;
+	}
+
+	/**
+	 * Returns whether a FileStatus holds the same metadata as lstat, or stat when following links
+	 */
+	bool matchesStat(const FileStatus& status, const std::string& path, bool follow)
+	{
+		struct stat buf ;
+		if((follow ? ::stat(path.c_str(), &buf) : ::lstat(path.c_str(), &buf)) != 0)
+		{
+			return(false) ;
+		}
+
+		return(status.exists()
+			&& status.getMode() == buf.st_mode
+			&& status.getOwner() == buf.st_uid
+			&& status.getGroup() == buf.st_gid
+			&& status.getSize() == static_cast<unsigned long long>(buf.st_size)
+			&& status.getBlocks() == static_cast<unsigned long long>(buf.st_blocks)
+			&& status.getModifiedTime().tv_sec == buf.st_mtim.tv_sec
+			&& status.getModifiedTime().tv_nsec == buf.st_mtim.tv_nsec
+			&& status.getDevice() == buf.st_dev
+			&& status.getInode() == buf.st_ino
+			&& status.getLinkCount() == buf.st_nlink) ;
+	}
+
+	/**
+	 * Creates the files used by the loadMany tests, returning the paths queried, in an order
+	 * alternating between parent directories, with missing entries and a missing parent
+	 */
+	std::vector<FilePath> makeManyPaths(const TempDirectory& root)
+	{
+		::mkdir(root.getPath("a").c_str(), 0755) ;
+		::mkdir(root.getPath("b").c_str(), 0755) ;
+		makeFile(root.getPath("a/one"), 1, 0644) ;
+		makeFile(root.getPath("a/two"), 2, 0600) ;
+		makeFile(root.getPath("b/three"), 3, 0640) ;
+		::symlink("three", root.getPath("b/link").c_str()) ;
+
+		std::vector<FilePath> paths ;
+		paths.push_back(FilePath(root.getPath("a/one"))) ;
+		paths.push_back(FilePath(root.getPath("b/three"))) ;
+		paths.push_back(FilePath(root.getPath("a/missing"))) ;
+		paths.push_back(FilePath(root.getPath("a/two"))) ;
+		paths.push_back(FilePath(root.getPath("c/missing"))) ;
+		paths.push_back(FilePath(root.getPath("b/link"))) ;
+		paths.push_back(FilePath(root.getPath("a"))) ;
+		return(paths) ;
+	}
+
+	/**
+	 * Returns whether loadMany reports the paths created by makeManyPaths correctly
+	 */
+	bool loadsManyPaths(const TempDirectory& root, const std::vector<FilePath>& paths, bool follow)
+	{
+		std::vector<FileStatus> statuses ;
+		size_t found = FileStatus::loadMany(paths, statuses, FileStatus::ALL_FIELDS_ENUM, follow) ;
+
+		return(found == 5
+			&& statuses.size() == paths.size()
+			&& matchesStat(statuses[0], root.getPath("a/one"), follow)
+			&& matchesStat(statuses[1], root.getPath("b/three"), follow)
+			&& !statuses[2].exists() && statuses[2].getError() == ENOENT
+			&& matchesStat(statuses[3], root.getPath("a/two"), follow)
+			&& !statuses[4].exists() && statuses[4].getError() == ENOENT
+			&& matchesStat(statuses[5], root.getPath("b/link"), follow)
+			&& statuses[5].isRegularFile() == follow
+			&& matchesStat(statuses[6], root.getPath("a"), follow)
+			&& statuses[6].isDirectory()) ;
+	}
+
+#if defined(__NR_statx) && defined(SECCOMP_MODE_FILTER)
+	/**
+	 * Installs a seccomp filter failing statx with ENOSYS, as a kernel without statx would
+	 *
+	 * @return true if the filter was installed
+	 */
+	bool disableStatx()
+	{
+		struct sock_filter filter[] =
+		{
+			BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+			BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_statx, 0, 1),
+			BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | ENOSYS),
+			BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW)
+		} ;
+		struct sock_fprog program ;
+		program.len = sizeof(filter) / sizeof(filter[0]) ;
+		program.filter = filter ;
+
+		return(::prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0
+			&& ::prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program, 0, 0) == 0) ;
+	}
+#endif
+}
+
+FileStatusTest::FileStatusTest()
+	: cutil::AbstractUnitTest("FileStatus Test", "cutil")
+{}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+FileStatusTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<FileStatusTest>(this, &FileStatusTest::loadMatchesStat, "loadMatchesStat", "", "")) ;
+	test_cases.push_back(makeTestCase<FileStatusTest>(this, &FileStatusTest::missingPathIsReported, "missingPathIsReported", "", "")) ;
+	test_cases.push_back(makeTestCase<FileStatusTest>(this, &FileStatusTest::unrequestedFieldsAreZero, "unrequestedFieldsAreZero", "", "")) ;
+	test_cases.push_back(makeTestCase<FileStatusTest>(this, &FileStatusTest::loadManyKeepsOrder, "loadManyKeepsOrder", "", "")) ;
+	test_cases.push_back(makeTestCase<FileStatusTest>(this, &FileStatusTest::loadManyFollowsLinks, "loadManyFollowsLinks", "", "")) ;
+	test_cases.push_back(makeTestCase<FileStatusTest>(this, &FileStatusTest::loadManyRelativePaths, "loadManyRelativePaths", "", "")) ;
+	test_cases.push_back(makeTestCase<FileStatusTest>(this, &FileStatusTest::statxFallbackMatchesStat, "statxFallbackMatchesStat", "", "")) ;
+
+	// copy on return
+	return(test_cases) ;
+}
+
+void
+FileStatusTest::loadMatchesStat()
+{
+	TempDirectory root("FileStatusTest") ;
+	makeFile(root.getPath("file"), 1000, 0640) ;
+	::symlink("file", root.getPath("link").c_str()) ;
+
+	FileStatus status(FilePath(root.getPath("file"))) ;
+	cutil::Assert::isTrue(matchesStat(status, root.getPath("file"), true), "status of file matches stat") ;
+	cutil::Assert::isTrue(status.isRegularFile()) ;
+	cutil::Assert::areEqual(1000ULL, status.getSize()) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(0640), status.getMode() & 07777) ;
+	cutil::Assert::areEqual(static_cast<int>(FileStatus::ALL_FIELDS_ENUM), status.getFields() | FileStatus::BIRTH_TIME_FIELD_ENUM) ;
+
+	cutil::Assert::isTrue(status.load(FilePath(root.getPath("link")), FileStatus::ALL_FIELDS_ENUM, false)) ;
+	cutil::Assert::isTrue(matchesStat(status, root.getPath("link"), false), "status of link matches lstat") ;
+	cutil::Assert::areEqual(FilePath::SYM_LINK_ENUM, status.getFileType()) ;
+
+	cutil::Assert::isTrue(status.load(FilePath(root.getPath("link")))) ;
+	cutil::Assert::isTrue(matchesStat(status, root.getPath("file"), true), "followed link matches target") ;
+}
+
+void
+FileStatusTest::missingPathIsReported()
+{
+	TempDirectory root("FileStatusTest") ;
+
+	FileStatus status ;
+	cutil::Assert::isFalse(status.exists()) ;
+
+	cutil::Assert::isFalse(status.load(FilePath(root.getPath("missing")))) ;
+	cutil::Assert::isFalse(status.exists()) ;
+	cutil::Assert::areEqual(ENOENT, status.getError()) ;
+	cutil::Assert::areEqual(FilePath::UNKNOWN_TYPE_ENUM, status.getFileType()) ;
+
+	makeFile(root.getPath("file"), 1, 0644) ;
+	cutil::Assert::isFalse(status.load(FilePath(root.getPath("file/child")))) ;
+	cutil::Assert::areEqual(ENOTDIR, status.getError()) ;
+}
+
+void
+FileStatusTest::unrequestedFieldsAreZero()
+{
+	TempDirectory root("FileStatusTest") ;
+	makeFile(root.getPath("file"), 100, 0644) ;
+
+	FileStatus status(FilePath(root.getPath("file")), FileStatus::TYPE_FIELD_ENUM | FileStatus::SIZE_FIELD_ENUM) ;
+	cutil::Assert::isTrue(status.exists()) ;
+	cutil::Assert::isTrue(status.isRegularFile()) ;
+	cutil::Assert::areEqual(100ULL, status.getSize()) ;
+	cutil::Assert::areEqual(static_cast<int>(FileStatus::TYPE_FIELD_ENUM | FileStatus::SIZE_FIELD_ENUM), status.getFields()) ;
+	cutil::Assert::areEqual(static_cast<ino_t>(0), status.getInode()) ;
+	cutil::Assert::areEqual(static_cast<nlink_t>(0), status.getLinkCount()) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(S_IFREG), status.getMode()) ;
+	cutil::Assert::areEqual(0LL, static_cast<long long>(status.getModifiedTime().tv_sec)) ;
+}
+
+void
+FileStatusTest::loadManyKeepsOrder()
+{
+	TempDirectory root("FileStatusTest") ;
+	std::vector<FilePath> paths = makeManyPaths(root) ;
+
+	cutil::Assert::isTrue(loadsManyPaths(root, paths, false), "loadMany reports each path in order") ;
+
+	std::vector<FileStatus> statuses(3) ;
+	std::vector<FilePath> none ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), FileStatus::loadMany(none, statuses)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), statuses.size()) ;
+}
+
+void
+FileStatusTest::loadManyFollowsLinks()
+{
+	TempDirectory root("FileStatusTest") ;
+	std::vector<FilePath> paths = makeManyPaths(root) ;
+
+	cutil::Assert::isTrue(loadsManyPaths(root, paths, true), "loadMany reports link targets") ;
+}
+
+void
+FileStatusTest::loadManyRelativePaths()
+{
+	TempDirectory root("FileStatusTest") ;
+	makeManyPaths(root) ;
+
+	char cwd[4096] ;
+	cutil::Assert::isTrue(::getcwd(cwd, sizeof(cwd)) != 0) ;
+	cutil::Assert::areEqual(0, ::chdir(root.getPath("a").c_str())) ;
+
+	std::vector<FilePath> paths ;
+	paths.push_back(FilePath("one")) ;
+	paths.push_back(FilePath("../b/three")) ;
+	paths.push_back(FilePath("missing")) ;
+
+	std::vector<FileStatus> statuses ;
+	size_t found = FileStatus::loadMany(paths, statuses) ;
+
+	bool matched = matchesStat(statuses[0], root.getPath("a/one"), true)
+		&& matchesStat(statuses[1], root.getPath("b/three"), true)
+		&& !statuses[2].exists() ;
+
+	cutil::Assert::areEqual(0, ::chdir(cwd)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(2), found) ;
+	cutil::Assert::isTrue(matched, "relative paths are resolved from the working directory") ;
+}
+
+void
+FileStatusTest::statxFallbackMatchesStat()
+{
+#if defined(__NR_statx) && defined(SECCOMP_MODE_FILTER)
+	TempDirectory root("FileStatusTest") ;
+	std::vector<FilePath> paths = makeManyPaths(root) ;
+
+	// the fallback is latched process wide, so is exercised in a child process
+	pid_t pid = ::fork() ;
+	if(pid == 0)
+	{
+		if(!disableStatx())
+		{
+			::_exit(2) ;
+		}
+
+		int result = 1 ;
+		try
+		{
+			FileStatus status(FilePath(root.getPath("a/one")), FileStatus::ALL_FIELDS_ENUM | FileStatus::BIRTH_TIME_FIELD_ENUM) ;
+			if(matchesStat(status, root.getPath("a/one"), true) && !status.hasBirthTime()
+				&& !status.load(FilePath(root.getPath("a/missing"))) && status.getError() == ENOENT
+				&& loadsManyPaths(root, paths, false) && loadsManyPaths(root, paths, true))
+			{
+				result = 0 ;
+			}
+		}
+		catch(...)
+		{
+			result = 3 ;
+		}
+		::_exit(result) ;
+	}
+
+	cutil::Assert::isTrue(pid > 0, "child process created") ;
+
+	int status = 0 ;
+	cutil::Assert::areEqual(pid, ::waitpid(pid, &status, 0)) ;
+	cutil::Assert::isTrue(WIFEXITED(status)) ;
+	if(WEXITSTATUS(status) == 2)
+	{
+		// seccomp is unavailable, the fallback cannot be forced
+		return ;
+	}
+	cutil::Assert::areEqual(0, WEXITSTATUS(status), "fstatat fallback matches stat") ;
+#endif
+}
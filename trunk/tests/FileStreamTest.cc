@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "FileStreamTest.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/FilePath.h>
+#include <cutil/FileStream.h>
+#include <cutil/FileStreamException.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+namespace
+{
+	/**
+	 * Arguments of a concurrent readAt thread
+	 */
+	struct ReadArgs
+	{
+		const cutil::FileStream* theStream ;
+		off_t theOffset ;
+		bool theMatchFlag ;
+	} ;
+
+	/**
+	 * Thread entry repeatedly reading a record at its offset with readAt
+	 */
+	void* readRecords(void* arg)
+	{
+		ReadArgs* args = static_cast<ReadArgs*>(arg) ;
+		args->theMatchFlag = true ;
+
+		for(int i = 0; i < 1000; i++)
+		{
+			char buf[64] ;
+			if(args->theStream->readAt(buf, sizeof(buf), args->theOffset) != sizeof(buf))
+			{
+				args->theMatchFlag = false ;
+			}
+			for(size_t n = 0; n < sizeof(buf); n++)
+			{
+				if(buf[n] != static_cast<char>('a' + args->theOffset / 64))
+				{
+					args->theMatchFlag = false ;
+				}
+			}
+		}
+
+		return(0) ;
+	}
+}
+
+FileStreamTest::FileStreamTest() : cutil::AbstractUnitTest("FileStream Test", "cutil")
+{
+}
+
+void
+FileStreamTest::positionalIoLeavesPosition()
+{
+	TempFile file("FileStreamTest") ;
+	cutil::FileStream stream(file.getPath(), cutil::FileStream::READ_WRITE_ENUM, cutil::FileStream::OPEN_TRUNCATE_ENUM) ;
+
+	stream.write("hello world", 11) ;
+	stream.seek(2) ;
+
+	cutil::Assert::areEqual(static_cast<ssize_t>(5), stream.writeAt("WORLD", 5, 6)) ;
+	cutil::Assert::areEqual(static_cast<off_t>(2), stream.getPosition()) ;
+
+	char buf[32] ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(11), stream.readAt(buf, sizeof(buf), 0)) ;
+	cutil::Assert::areEqual(std::string("hello WORLD"), std::string(buf, 11)) ;
+	cutil::Assert::areEqual(static_cast<off_t>(2), stream.getPosition()) ;
+
+	// sequential reads continue from the unchanged position
+	cutil::Assert::areEqual(static_cast<ssize_t>(3), stream.read(buf, 3)) ;
+	cutil::Assert::areEqual(std::string("llo"), std::string(buf, 3)) ;
+
+	// reading at end of file returns 0, writing beyond it extends the file
+	cutil::Assert::areEqual(static_cast<ssize_t>(0), stream.readAt(buf, sizeof(buf), 11)) ;
+	stream.writeAt("!", 1, 20) ;
+	cutil::Assert::areEqual(static_cast<off_t>(21), stream.getSize()) ;
+}
+
+void
+FileStreamTest::concurrentReadAt()
+{
+	TempFile file("FileStreamTest") ;
+	cutil::FileStream stream(file.getPath(), cutil::FileStream::READ_WRITE_ENUM, cutil::FileStream::OPEN_TRUNCATE_ENUM) ;
+
+	for(int i = 0; i < 4; i++)
+	{
+		std::string record(64, static_cast<char>('a' + i)) ;
+		stream.writeAt(record.data(), record.size(), i * 64) ;
+	}
+
+	// readAt does not share a file position between threads
+	pthread_t threads[4] ;
+	ReadArgs args[4] ;
+	for(int i = 0; i < 4; i++)
+	{
+		args[i].theStream = &stream ;
+		args[i].theOffset = i * 64 ;
+		::pthread_create(&threads[i], 0, readRecords, &args[i]) ;
+	}
+
+	for(int i = 0; i < 4; i++)
+	{
+		::pthread_join(threads[i], 0) ;
+		cutil::Assert::isTrue(args[i].theMatchFlag) ;
+	}
+}
+
+void
+FileStreamTest::preallocateExtendsFile()
+{
+	TempFile file("FileStreamTest") ;
+	cutil::FileStream stream(file.getPath(), cutil::FileStream::READ_WRITE_ENUM) ;
+
+	stream.preallocate(0, 65536) ;
+	cutil::Assert::areEqual(static_cast<off_t>(65536), stream.getSize()) ;
+	cutil::Assert::isTrue(file.getBlocks() * 512 >= 65536) ;
+
+	// preallocated space reads as zeros
+	char buf[16] ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(16), stream.readAt(buf, sizeof(buf), 32768)) ;
+	cutil::Assert::areEqual(std::string(16, '\0'), std::string(buf, 16)) ;
+}
+
+void
+FileStreamTest::preallocateKeepsSize()
+{
+	TempFile file("FileStreamTest") ;
+	cutil::FileStream stream(file.getPath(), cutil::FileStream::READ_WRITE_ENUM) ;
+
+	stream.write("data", 4) ;
+	stream.preallocate(0, 131072, true) ;
+
+	cutil::Assert::areEqual(static_cast<off_t>(4), stream.getSize()) ;
+	cutil::Assert::isTrue(file.getBlocks() * 512 >= 131072) ;
+}
+
+void
+FileStreamTest::alignmentIsQueried()
+{
+	cutil::FileStream unopened ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), unopened.getAlignment()) ;
+
+	TempFile file("FileStreamTest") ;
+	cutil::FileStream stream(file.getPath(), cutil::FileStream::READ_ONLY_ENUM) ;
+
+	size_t alignment = stream.getAlignment() ;
+	cutil::Assert::isTrue(alignment >= 512) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), alignment & (alignment - 1)) ;
+
+	void* buf = cutil::FileStream::allocateAligned(alignment * 2, alignment) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), reinterpret_cast<size_t>(buf) % alignment) ;
+	cutil::FileStream::releaseAligned(buf) ;
+
+	stream.close() ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), stream.getAlignment()) ;
+}
+
+void
+FileStreamTest::directIoRoundTrip()
+{
+	TempFile file("FileStreamTest") ;
+	cutil::FileStream stream ;
+
+	try
+	{
+		stream.open(file.getPath(), cutil::FileStream::READ_WRITE_ENUM, cutil::FileStream::OPEN_DIRECT_ENUM) ;
+	}
+	catch(cutil::FileStreamException& e)
+	{
+		// the filesystem holding /tmp does not support direct I/O
+		return ;
+	}
+
+	cutil::Assert::isTrue(stream.isDirect()) ;
+
+	size_t alignment = stream.getAlignment() ;
+	char* out = static_cast<char*>(cutil::FileStream::allocateAligned(alignment, alignment)) ;
+	char* in = static_cast<char*>(cutil::FileStream::allocateAligned(alignment, alignment)) ;
+	std::memset(out, 'd', alignment) ;
+	std::memset(in, 0, alignment) ;
+
+	cutil::Assert::areEqual(static_cast<ssize_t>(alignment), stream.writeAt(out, alignment, alignment)) ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(alignment), stream.readAt(in, alignment, alignment)) ;
+	cutil::Assert::isTrue(std::memcmp(in, out, alignment) == 0) ;
+
+	cutil::FileStream::releaseAligned(in) ;
+	cutil::FileStream::releaseAligned(out) ;
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+FileStreamTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<FileStreamTest>(this, &FileStreamTest::positionalIoLeavesPosition, "positionalIoLeavesPosition", "", ""));
+	test_cases.push_back(makeTestCase<FileStreamTest>(this, &FileStreamTest::concurrentReadAt, "concurrentReadAt", "", ""));
+	test_cases.push_back(makeTestCase<FileStreamTest>(this, &FileStreamTest::preallocateExtendsFile, "preallocateExtendsFile", "", ""));
+	test_cases.push_back(makeTestCase<FileStreamTest>(this, &FileStreamTest::preallocateKeepsSize, "preallocateKeepsSize", "", ""));
+	test_cases.push_back(makeTestCase<FileStreamTest>(this, &FileStreamTest::alignmentIsQueried, "alignmentIsQueried", "", ""));
+	test_cases.push_back(makeTestCase<FileStreamTest>(this, &FileStreamTest::directIoRoundTrip, "directIoRoundTrip", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
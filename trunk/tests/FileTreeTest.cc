@@ -0,0 +1,561 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "FileTreeTest.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/Closure.h>
+#include <cutil/Condition.h>
+#include <cutil/Exception.h>
+#include <cutil/FilePath.h>
+#include <cutil/FileTree.h>
+#include <cutil/Mutex.h>
+#include <cutil/ThreadPool.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+using cutil::FilePath ;
+using cutil::FileTree ;
+
+namespace
+{
+	/** entries created by makeTree, excluding the root */
+	const size_t TREE_ENTRIES = 43 ;
+
+	/**
+	 * Creates a file holding its own name, with the specified mode
+	 */
+	void makeFile(const std::string& path, mode_t mode)
+	{
+		int fd = ::open(path.c_str(), O_WRONLY|O_CREAT|O_TRUNC, mode) ;
+		if(::write(fd, path.data(), path.size()) != static_cast<ssize_t>(path.size()))
+		{
+			// the contents comparison fails the test
+		}
+		::fchmod(fd, mode) ;
+		::close(fd) ;
+	}
+
+	/**
+	 * Returns the contents of a file
+	 */
+	std::string readFile(const std::string& path)
+	{
+		std::string contents ;
+		int fd = ::open(path.c_str(), O_RDONLY) ;
+		char buffer[256] ;
+		ssize_t count ;
+		while(fd != -1 && (count = ::read(fd, buffer, sizeof(buffer))) > 0)
+		{
+			contents.append(buffer, count) ;
+		}
+		::close(fd) ;
+		return(contents) ;
+	}
+
+	/**
+	 * Returns the mode of a path, not following links, 0 if it does not exist
+	 */
+	mode_t modeOf(const std::string& path)
+	{
+		struct stat statbuf ;
+		return((::lstat(path.c_str(), &statbuf) == 0) ? statbuf.st_mode : 0) ;
+	}
+
+	/**
+	 * Returns the target of a symbolic link
+	 */
+	std::string linkOf(const std::string& path)
+	{
+		char target[256] ;
+		ssize_t length = ::readlink(path.c_str(), target, sizeof(target)) ;
+		return((length > 0) ? std::string(target, length) : std::string()) ;
+	}
+
+	/**
+	 * Returns the path of a file beneath makeTree
+	 */
+	std::string treeFile(const std::string& root, int d, int s, int f)
+	{
+		char name[32] ;
+		std::snprintf(name, sizeof(name), "/d%d/s%d/f%d", d, s, f) ;
+		return(std::string(root).append(name)) ;
+	}
+
+	/**
+	 * Creates a tree of TREE_ENTRIES entries: files of assorted modes, hidden files, links, a fifo,
+	 * and 4 directories, each of 2 subdirectories, each of 3 files.
+	 * d3 is group writable. If read_only is set, d1 is left without owner write permission.
+	 */
+	void makeTree(const std::string& root, bool read_only)
+	{
+		::mkdir(root.c_str(), 0750) ;
+		makeFile(root + "/file", 0640) ;
+		makeFile(root + "/.hidden", 0600) ;
+		makeFile(root + "/exec", 0755) ;
+		::symlink("file", (root + "/link").c_str()) ;
+		::symlink("missing", (root + "/dangling").c_str()) ;
+		::mkfifo((root + "/fifo").c_str(), 0620) ;
+		::chmod((root + "/fifo").c_str(), 0620) ;
+
+		for(int d = 0; d < 4; d++)
+		{
+			char dir[32] ;
+			std::snprintf(dir, sizeof(dir), "/d%d", d) ;
+			::mkdir((root + dir).c_str(), 0755) ;
+
+			for(int s = 0; s < 2; s++)
+			{
+				char sub[32] ;
+				std::snprintf(sub, sizeof(sub), "/d%d/s%d", d, s) ;
+				::mkdir((root + sub).c_str(), 0755) ;
+
+				for(int f = 0; f < 3; f++)
+				{
+					makeFile(treeFile(root, d, s, f), 0644) ;
+				}
+			}
+		}
+		::symlink("../file", (root + "/d2/link").c_str()) ;
+		::chmod((root + "/d3").c_str(), 0775) ;
+		::chmod(root.c_str(), 0750) ;
+
+		if(read_only)
+		{
+			::chmod((root + "/d1").c_str(), 0555) ;
+		}
+	}
+
+	/**
+	 * Returns a description of the first difference between a tree created by makeTree and its copy,
+	 * empty if they match
+	 */
+	std::string compareTree(const std::string& source, const std::string& copy)
+	{
+		const char* names[] = { "", "/file", "/.hidden", "/exec", "/link", "/dangling", "/fifo", "/d0", "/d1", "/d1/s0", "/d3", "/d2/link", NULL } ;
+		for(size_t i = 0; names[i] != NULL; i++)
+		{
+			std::string from = source + names[i] ;
+			std::string to = copy + names[i] ;
+			if(modeOf(from) != modeOf(to))
+			{
+				return(std::string("mode of ").append(to)) ;
+			}
+			if(S_ISLNK(modeOf(from)) && linkOf(from) != linkOf(to))
+			{
+				return(std::string("target of ").append(to)) ;
+			}
+		}
+
+		for(int d = 0; d < 4; d++)
+		{
+			for(int s = 0; s < 2; s++)
+			{
+				for(int f = 0; f < 3; f++)
+				{
+					std::string to = treeFile(copy, d, s, f) ;
+					if(modeOf(to) != (S_IFREG | 0644) || readFile(to) != readFile(treeFile(source, d, s, f)))
+					{
+						return(std::string("contents of ").append(to)) ;
+					}
+				}
+			}
+		}
+
+		return(std::string()) ;
+	}
+
+	/**
+	 * Occupies a thread of a ThreadPool until opened
+	 */
+	class Gate
+	{
+		public:
+			Gate() : theOpen(false) {}
+
+			void block()
+			{
+				cutil::MutexLock lock(theMutex) ;
+				while(!theOpen)
+				{
+					theCondition.wait(theMutex) ;
+				}
+			}
+
+			void open()
+			{
+				cutil::MutexLock lock(theMutex) ;
+				theOpen = true ;
+				theCondition.broadcast() ;
+			}
+
+		private:
+			cutil::Mutex theMutex ;
+			cutil::Condition theCondition ;
+			bool theOpen ;
+	} ;
+
+	/**
+	 * Performs a FileTree operation within a separate thread
+	 */
+	struct Operation
+	{
+		FileTree* theTree ;
+		std::string theSource ;
+		std::string theDestination ;
+		size_t theCount ;
+		bool theFailed ;
+	} ;
+
+	void* removeTree(void* arg)
+	{
+		Operation* operation = static_cast<Operation*>(arg) ;
+		try
+		{
+			operation->theCount = operation->theTree->remove(FilePath(operation->theSource)) ;
+		}
+		catch(cutil::Exception& e)
+		{
+			operation->theFailed = true ;
+		}
+		return(NULL) ;
+	}
+
+	void* copyTree(void* arg)
+	{
+		Operation* operation = static_cast<Operation*>(arg) ;
+		try
+		{
+			operation->theCount = operation->theTree->copy(FilePath(operation->theSource), FilePath(operation->theDestination)) ;
+		}
+		catch(cutil::Exception& e)
+		{
+			operation->theFailed = true ;
+		}
+		return(NULL) ;
+	}
+
+	/**
+	 * Runs an operation upon a FileTree whose single thread pool is occupied, returning whether
+	 * the entry probe still existed, or was yet to exist, while the pool was occupied
+	 */
+	bool waitsForPool(void* (*function)(void*), Operation& operation, const std::string& probe, bool exists)
+	{
+		cutil::ThreadPool pool(1) ;
+		FileTree tree(pool) ;
+		operation.theTree = &tree ;
+		operation.theCount = 0 ;
+		operation.theFailed = false ;
+
+		Gate gate ;
+		pool.execute(new cutil::Closure0<void, Gate>(&gate, &Gate::block)) ;
+
+		pthread_t thread ;
+		::pthread_create(&thread, NULL, function, &operation) ;
+		::usleep(200000) ;
+
+		bool waited = ((modeOf(probe) != 0) == exists) ;
+
+		gate.open() ;
+		::pthread_join(thread, NULL) ;
+		return(waited) ;
+	}
+}
+
+FileTreeTest::FileTreeTest()
+	: cutil::AbstractUnitTest("FileTree Test", "cutil")
+{}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+FileTreeTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<FileTreeTest>(this, &FileTreeTest::removeNestedTree, "removeNestedTree", "", "")) ;
+	test_cases.push_back(makeTestCase<FileTreeTest>(this, &FileTreeTest::removeNestedTreeWithPool, "removeNestedTreeWithPool", "", "")) ;
+	test_cases.push_back(makeTestCase<FileTreeTest>(this, &FileTreeTest::removeDoesNotFollowLinks, "removeDoesNotFollowLinks", "", "")) ;
+	test_cases.push_back(makeTestCase<FileTreeTest>(this, &FileTreeTest::removeRunsOnPool, "removeRunsOnPool", "", "")) ;
+	test_cases.push_back(makeTestCase<FileTreeTest>(this, &FileTreeTest::copyPreservesTree, "copyPreservesTree", "", "")) ;
+	test_cases.push_back(makeTestCase<FileTreeTest>(this, &FileTreeTest::copyPreservesTreeWithPool, "copyPreservesTreeWithPool", "", "")) ;
+	test_cases.push_back(makeTestCase<FileTreeTest>(this, &FileTreeTest::copyRunsOnPool, "copyRunsOnPool", "", "")) ;
+	test_cases.push_back(makeTestCase<FileTreeTest>(this, &FileTreeTest::copySingleEntries, "copySingleEntries", "", "")) ;
+	test_cases.push_back(makeTestCase<FileTreeTest>(this, &FileTreeTest::createDirectoriesMakesParents, "createDirectoriesMakesParents", "", "")) ;
+	test_cases.push_back(makeTestCase<FileTreeTest>(this, &FileTreeTest::createDirectoriesWithPool, "createDirectoriesWithPool", "", "")) ;
+
+	// copy on return
+	return(test_cases) ;
+}
+
+void
+FileTreeTest::removeNestedTree()
+{
+	TempDirectory temp("FileTreeTest") ;
+	std::string root = temp.getPath("tree") ;
+	makeTree(root, false) ;
+
+	FileTree tree ;
+	cutil::Assert::areEqual(TREE_ENTRIES + 1, tree.remove(FilePath(root))) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(0), modeOf(root)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), tree.remove(FilePath(root)), "missing path removes nothing") ;
+
+	makeFile(temp.getPath("single"), 0644) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), tree.remove(FilePath(temp.getPath("single")))) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(0), modeOf(temp.getPath("single"))) ;
+}
+
+void
+FileTreeTest::removeNestedTreeWithPool()
+{
+	TempDirectory temp("FileTreeTest") ;
+	std::string root = temp.getPath("tree") ;
+	makeTree(root, false) ;
+
+	cutil::ThreadPool pool(4) ;
+	FileTree tree(pool) ;
+	cutil::Assert::areEqual(TREE_ENTRIES + 1, tree.remove(FilePath(root))) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(0), modeOf(root)) ;
+}
+
+void
+FileTreeTest::removeDoesNotFollowLinks()
+{
+	TempDirectory temp("FileTreeTest") ;
+	std::string root = temp.getPath("tree") ;
+	std::string outside = temp.getPath("outside") ;
+	makeTree(outside, false) ;
+	::mkdir(root.c_str(), 0755) ;
+	::mkdir((root + "/sub").c_str(), 0755) ;
+	::symlink(outside.c_str(), (root + "/sub/escape").c_str()) ;
+	::symlink(outside.c_str(), temp.getPath("root_link").c_str()) ;
+
+	cutil::ThreadPool pool(2) ;
+	FileTree tree(pool) ;
+	cutil::Assert::areEqual(static_cast<size_t>(3), tree.remove(FilePath(root))) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), tree.remove(FilePath(temp.getPath("root_link"))), "link root is unlinked") ;
+	cutil::Assert::areEqual(static_cast<mode_t>(S_IFREG | 0644), modeOf(treeFile(outside, 3, 1, 2)), "link target is untouched") ;
+}
+
+void
+FileTreeTest::removeRunsOnPool()
+{
+	TempDirectory temp("FileTreeTest") ;
+	std::string root = temp.getPath("tree") ;
+	makeTree(root, false) ;
+
+	// subdirectories of the root are removed by the pool, so remain while it is occupied
+	Operation operation ;
+	operation.theSource = root ;
+	cutil::Assert::isTrue(waitsForPool(removeTree, operation, treeFile(root, 0, 0, 0), true), "remove waits for the pool") ;
+	cutil::Assert::isFalse(operation.theFailed) ;
+	cutil::Assert::areEqual(TREE_ENTRIES + 1, operation.theCount) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(0), modeOf(root)) ;
+}
+
+void
+FileTreeTest::copyPreservesTree()
+{
+	TempDirectory temp("FileTreeTest") ;
+	std::string source = temp.getPath("source") ;
+	std::string destination = temp.getPath("destination") ;
+	makeTree(source, true) ;
+
+	FileTree tree ;
+	cutil::Assert::areEqual(TREE_ENTRIES + 1, tree.copy(FilePath(source), FilePath(destination))) ;
+	cutil::Assert::areEqual(std::string(), compareTree(source, destination)) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(S_IFDIR | 0555), modeOf(destination + "/d1"), "read only directory mode restored") ;
+	cutil::Assert::isTrue(S_ISFIFO(modeOf(destination + "/fifo")), "fifo recreated") ;
+
+	bool thrown = false ;
+	try
+	{
+		tree.copy(FilePath(source), FilePath(destination)) ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown, "copying onto an existing destination throws") ;
+
+	thrown = false ;
+	try
+	{
+		tree.copy(FilePath(temp.getPath("missing")), FilePath(temp.getPath("other"))) ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown, "copying a missing source throws") ;
+}
+
+void
+FileTreeTest::copyPreservesTreeWithPool()
+{
+	TempDirectory temp("FileTreeTest") ;
+	std::string source = temp.getPath("source") ;
+	std::string destination = temp.getPath("destination") ;
+	makeTree(source, true) ;
+
+	cutil::ThreadPool pool(4) ;
+	FileTree tree(pool) ;
+	cutil::Assert::areEqual(TREE_ENTRIES + 1, tree.copy(FilePath(source), FilePath(destination))) ;
+	cutil::Assert::areEqual(std::string(), compareTree(source, destination)) ;
+}
+
+void
+FileTreeTest::copyRunsOnPool()
+{
+	TempDirectory temp("FileTreeTest") ;
+	std::string source = temp.getPath("source") ;
+	std::string destination = temp.getPath("destination") ;
+	makeTree(source, false) ;
+
+	// subdirectories of the root are copied by the pool, so are absent while it is occupied
+	Operation operation ;
+	operation.theSource = source ;
+	operation.theDestination = destination ;
+	cutil::Assert::isTrue(waitsForPool(copyTree, operation, treeFile(destination, 0, 0, 0), false), "copy waits for the pool") ;
+	cutil::Assert::isFalse(operation.theFailed) ;
+	cutil::Assert::areEqual(TREE_ENTRIES + 1, operation.theCount) ;
+	cutil::Assert::areEqual(std::string(), compareTree(source, destination)) ;
+}
+
+void
+FileTreeTest::copySingleEntries()
+{
+	TempDirectory temp("FileTreeTest") ;
+	makeFile(temp.getPath("file"), 0604) ;
+	::symlink("file", temp.getPath("link").c_str()) ;
+	::mkfifo(temp.getPath("fifo").c_str(), 0600) ;
+
+	FileTree tree ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), tree.copy(FilePath(temp.getPath("file")), FilePath(temp.getPath("file_copy")))) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(S_IFREG | 0604), modeOf(temp.getPath("file_copy"))) ;
+	cutil::Assert::areEqual(readFile(temp.getPath("file")), readFile(temp.getPath("file_copy"))) ;
+
+	cutil::Assert::areEqual(static_cast<size_t>(1), tree.copy(FilePath(temp.getPath("link")), FilePath(temp.getPath("link_copy")))) ;
+	cutil::Assert::areEqual(std::string("file"), linkOf(temp.getPath("link_copy"))) ;
+
+	FileTree::copyFile(FilePath(temp.getPath("file")), FilePath(temp.getPath("copied"))) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(S_IFREG | 0604), modeOf(temp.getPath("copied"))) ;
+	cutil::Assert::areEqual(readFile(temp.getPath("file")), readFile(temp.getPath("copied"))) ;
+
+	bool thrown = false ;
+	try
+	{
+		tree.copy(FilePath(temp.getPath("fifo")), FilePath(temp.getPath("fifo_copy"))) ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown, "a fifo root is not copied") ;
+}
+
+void
+FileTreeTest::createDirectoriesMakesParents()
+{
+	TempDirectory temp("FileTreeTest") ;
+	::mkdir(temp.getPath("existing").c_str(), 0755) ;
+
+	std::vector<FilePath> paths ;
+	paths.push_back(FilePath(temp.getPath("a/b/c"))) ;
+	paths.push_back(FilePath(temp.getPath("a/b/d"))) ;
+	paths.push_back(FilePath(temp.getPath("a/b/c"))) ;
+	paths.push_back(FilePath(temp.getPath("existing"))) ;
+	paths.push_back(FilePath(temp.getPath("existing/e"))) ;
+	paths.push_back(FilePath("")) ;
+
+	FileTree tree ;
+	tree.setDirectoryMode(0700) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(0700), tree.getDirectoryMode()) ;
+	cutil::Assert::areEqual(static_cast<size_t>(5), tree.createDirectories(paths)) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(S_IFDIR | 0700), modeOf(temp.getPath("a/b/c"))) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(S_IFDIR | 0700), modeOf(temp.getPath("a"))) ;
+	cutil::Assert::areEqual(static_cast<mode_t>(S_IFDIR | 0700), modeOf(temp.getPath("existing/e"))) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), tree.createDirectories(paths), "existing directories are not an error") ;
+
+	makeFile(temp.getPath("file"), 0644) ;
+	paths.clear() ;
+	paths.push_back(FilePath(temp.getPath("file/child"))) ;
+
+	bool thrown = false ;
+	try
+	{
+		tree.createDirectories(paths) ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown, "a file parent throws") ;
+}
+
+void
+FileTreeTest::createDirectoriesWithPool()
+{
+	TempDirectory temp("FileTreeTest") ;
+
+	// paths share parents across the chunks given to each pool thread
+	std::vector<FilePath> paths ;
+	for(int i = 0; i < 64; i++)
+	{
+		char name[64] ;
+		std::snprintf(name, sizeof(name), "p%d/q%d/r%d", i % 4, i % 8, i) ;
+		paths.push_back(FilePath(temp.getPath(name))) ;
+	}
+
+	cutil::ThreadPool pool(4) ;
+	FileTree tree(pool) ;
+	cutil::Assert::areEqual(static_cast<size_t>(4 + 8 + 64), tree.createDirectories(paths), "each directory counted once") ;
+	for(int i = 0; i < 64; i++)
+	{
+		cutil::Assert::isTrue(S_ISDIR(modeOf(paths[i].getPath())), paths[i].getPath()) ;
+	}
+	cutil::Assert::areEqual(static_cast<size_t>(0), tree.createDirectories(paths)) ;
+
+	makeFile(temp.getPath("file"), 0644) ;
+	paths.push_back(FilePath(temp.getPath("file/child"))) ;
+
+	bool thrown = false ;
+	try
+	{
+		tree.createDirectories(paths) ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown, "failure within the pool is reported") ;
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "MappedFileTest.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/Exception.h>
+#include <cutil/FilePath.h>
+#include <cutil/MappedFile.h>
+#include <cutil/MappedFileInputStream.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+MappedFileTest::MappedFileTest() : cutil::AbstractUnitTest("MappedFile Test", "cutil")
+{
+}
+
+void
+MappedFileTest::readOnlyMappingReadsFile()
+{
+	TempFile file("MappedFileTest", "lookup table contents") ;
+
+	cutil::MappedFile mapped(file.getPath(), cutil::MappedFile::READ_ONLY_ENUM, cutil::MappedFile::MAP_POPULATE_ENUM) ;
+
+	cutil::Assert::isTrue(mapped.isMapped()) ;
+	cutil::Assert::isTrue(mapped.getMode() == cutil::MappedFile::READ_ONLY_ENUM) ;
+	cutil::Assert::areEqual(static_cast<size_t>(21), mapped.getSize()) ;
+	cutil::Assert::areEqual(std::string("lookup table contents"), std::string(mapped.getData(), mapped.getSize())) ;
+
+	// a read only mapping is never extended
+	cutil::MappedFile longer(file.getPath(), cutil::MappedFile::READ_ONLY_ENUM, cutil::MappedFile::MAP_DEFAULT_ENUM, 4096) ;
+	cutil::Assert::areEqual(static_cast<size_t>(21), longer.getSize()) ;
+}
+
+void
+MappedFileTest::sharedWritesAreVisible()
+{
+	TempFile file("MappedFileTest") ;
+
+	cutil::MappedFile writer(file.getPath(), cutil::MappedFile::READ_WRITE_ENUM, cutil::MappedFile::MAP_DEFAULT_ENUM, 8192) ;
+	cutil::Assert::areEqual(static_cast<size_t>(8192), writer.getSize()) ;
+	cutil::Assert::areEqual(static_cast<off_t>(8192), file.getSize()) ;
+
+	cutil::MappedFile reader(file.getPath(), cutil::MappedFile::READ_ONLY_ENUM) ;
+	cutil::Assert::areEqual(static_cast<size_t>(8192), reader.getSize()) ;
+
+	// the mapping is shared, writes reach the page cache without sync
+	std::memcpy(writer.getData() + 5000, "shared", 6) ;
+	cutil::Assert::areEqual(std::string("shared"), std::string(reader.getData() + 5000, 6)) ;
+	cutil::Assert::areEqual(std::string("shared"), file.read(5000, 6)) ;
+
+	// and remain once unmapped
+	writer.unmap() ;
+	cutil::Assert::isFalse(writer.isMapped()) ;
+	cutil::Assert::areEqual(std::string("shared"), file.read(5000, 6)) ;
+}
+
+void
+MappedFileTest::syncFlushesChanges()
+{
+	TempFile file("MappedFileTest", "0123456789") ;
+
+	cutil::MappedFile mapped(file.getPath(), cutil::MappedFile::READ_WRITE_ENUM) ;
+	cutil::Assert::areEqual(static_cast<size_t>(10), mapped.getSize()) ;
+
+	mapped.getData()[0] = 'x' ;
+	mapped.sync() ;
+	mapped.getData()[1] = 'y' ;
+	mapped.sync(false) ;
+
+	cutil::Assert::areEqual(std::string("xy23456789"), file.read(0, 10)) ;
+}
+
+void
+MappedFileTest::adviceKeepsContents()
+{
+	size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE)) ;
+	TempFile file("MappedFileTest") ;
+
+	cutil::MappedFile mapped(file.getPath(), cutil::MappedFile::READ_WRITE_ENUM, cutil::MappedFile::MAP_DEFAULT_ENUM, page * 4) ;
+	std::memset(mapped.getData(), 'a', mapped.getSize()) ;
+
+	// offsets within a page are rounded down, lengths are clipped to the mapping
+	mapped.advise(cutil::MappedFile::ADVICE_SEQUENTIAL_ENUM) ;
+	mapped.advise(cutil::MappedFile::ADVICE_RANDOM_ENUM, page + 10, page) ;
+	mapped.advise(cutil::MappedFile::ADVICE_WILL_NEED_ENUM, page * 3, page * 8) ;
+	mapped.advise(cutil::MappedFile::ADVICE_NORMAL_ENUM, page * 16) ;
+
+	// dropped pages of a shared mapping are faulted back in from the file
+	mapped.advise(cutil::MappedFile::ADVICE_DONT_NEED_ENUM) ;
+	cutil::Assert::areEqual(std::string(page * 4, 'a'), std::string(mapped.getData(), mapped.getSize())) ;
+}
+
+void
+MappedFileTest::emptyFileIsMapped()
+{
+	TempFile file("MappedFileTest") ;
+
+	cutil::MappedFile mapped(file.getPath(), cutil::MappedFile::READ_ONLY_ENUM) ;
+	cutil::Assert::isTrue(mapped.isMapped()) ;
+	cutil::Assert::isTrue(mapped.getData() == 0) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), mapped.getSize()) ;
+
+	mapped.advise(cutil::MappedFile::ADVICE_SEQUENTIAL_ENUM) ;
+	mapped.sync() ;
+
+	cutil::MappedFileInputStream stream(mapped) ;
+	char c ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(0), stream.read(c)) ;
+}
+
+void
+MappedFileTest::unmappedOperationsFail()
+{
+	cutil::MappedFile mapped ;
+	cutil::Assert::isFalse(mapped.isMapped()) ;
+
+	bool thrown = false ;
+	try
+	{
+		mapped.sync() ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown) ;
+
+	thrown = false ;
+	try
+	{
+		mapped.advise(cutil::MappedFile::ADVICE_RANDOM_ENUM) ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown) ;
+
+	thrown = false ;
+	try
+	{
+		mapped.map(cutil::FilePath("/nonexistent/MappedFileTest"), cutil::MappedFile::READ_ONLY_ENUM) ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown) ;
+	cutil::Assert::isFalse(mapped.isMapped()) ;
+}
+
+void
+MappedFileTest::inputStreamReadsMapping()
+{
+	TempFile file("MappedFileTest", "stream over a mapping") ;
+	cutil::MappedFile mapped(file.getPath(), cutil::MappedFile::READ_ONLY_ENUM) ;
+
+	cutil::MappedFileInputStream stream(mapped) ;
+	cutil::Assert::isTrue(stream.isDataAvailable(0)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(21), stream.getRemaining()) ;
+
+	char buf[8] ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(6), stream.read(buf, 6)) ;
+	cutil::Assert::areEqual(std::string("stream"), std::string(buf, 6)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(6), stream.getPosition()) ;
+
+	// peek exposes the mapping without copying
+	cutil::Assert::isTrue(stream.peek() == mapped.getData() + 6) ;
+
+	stream.setPosition(15) ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(6), stream.read(buf, sizeof(buf))) ;
+	cutil::Assert::areEqual(std::string("apping"), std::string(buf, 6)) ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(0), stream.read(buf, sizeof(buf))) ;
+	cutil::Assert::isFalse(stream.isDataAvailable(0)) ;
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+MappedFileTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<MappedFileTest>(this, &MappedFileTest::readOnlyMappingReadsFile, "readOnlyMappingReadsFile", "", ""));
+	test_cases.push_back(makeTestCase<MappedFileTest>(this, &MappedFileTest::sharedWritesAreVisible, "sharedWritesAreVisible", "", ""));
+	test_cases.push_back(makeTestCase<MappedFileTest>(this, &MappedFileTest::syncFlushesChanges, "syncFlushesChanges", "", ""));
+	test_cases.push_back(makeTestCase<MappedFileTest>(this, &MappedFileTest::adviceKeepsContents, "adviceKeepsContents", "", ""));
+	test_cases.push_back(makeTestCase<MappedFileTest>(this, &MappedFileTest::emptyFileIsMapped, "emptyFileIsMapped", "", ""));
+	test_cases.push_back(makeTestCase<MappedFileTest>(this, &MappedFileTest::unmappedOperationsFail, "unmappedOperationsFail", "", ""));
+	test_cases.push_back(makeTestCase<MappedFileTest>(this, &MappedFileTest::inputStreamReadsMapping, "inputStreamReadsMapping", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
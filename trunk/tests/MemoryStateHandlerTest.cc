@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "MemoryStateHandlerTest.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/MemoryStateHandler.h>
+#include <cutil/RefCountPtr.h>
+#include <cutil/StateNode.h>
+
+#include <list>
+#include <string>
+
+using namespace cutil::unit_tests ;
+
+namespace
+{
+	std::string join(const std::list<std::string>& names)
+	{
+		std::string joined ;
+		for(std::list<std::string>::const_iterator citer = names.begin(); citer != names.end(); ++citer)
+		{
+			joined.append(joined.empty() ? "" : ",").append(*citer) ;
+		}
+
+		return(joined) ;
+	}
+}
+
+MemoryStateHandlerTest::MemoryStateHandlerTest() : cutil::AbstractUnitTest("MemoryStateHandler Test", "cutil")
+{
+}
+
+void
+MemoryStateHandlerTest::valuesAreTyped()
+{
+	cutil::MemoryStateHandler handler ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+	root->setInt("int", 42) ;
+	root->setDouble("double", 2.5) ;
+	root->setBool("bool", true) ;
+	root->setString("string", "text") ;
+
+	cutil::Assert::areEqual(42, root->getInt("int", 0)) ;
+	cutil::Assert::areEqual(2.5, root->getDouble("double", 0.0)) ;
+	cutil::Assert::isTrue(root->getBool("bool", false)) ;
+	cutil::Assert::areEqual(std::string("text"), root->getString("string", "")) ;
+
+	// typed values also hold their string representation
+	cutil::Assert::areEqual(std::string("42"), root->getString("int", "")) ;
+	cutil::Assert::areEqual(std::string("true"), root->getString("bool", "")) ;
+}
+
+void
+MemoryStateHandlerTest::valuesConvertAsText()
+{
+	cutil::MemoryStateHandler handler ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+	root->setString("int", "17") ;
+	root->setString("double", "0.25") ;
+	root->setString("bool", "true") ;
+	root->setDouble("fraction", 2.5) ;
+
+	cutil::Assert::areEqual(17, root->getInt("int", 0)) ;
+	cutil::Assert::areEqual(0.25, root->getDouble("double", 0.0)) ;
+	cutil::Assert::isTrue(root->getBool("bool", false)) ;
+	cutil::Assert::areEqual(2, root->getInt("fraction", 0)) ;
+	cutil::Assert::isFalse(root->getBool("int", true)) ;
+}
+
+void
+MemoryStateHandlerTest::missingValuesReturnDefault()
+{
+	cutil::MemoryStateHandler handler ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+	root->setInt("removed", 1) ;
+	root->removeValue("removed") ;
+
+	cutil::Assert::areEqual(7, root->getInt("removed", 7)) ;
+	cutil::Assert::areEqual(std::string("def"), root->getString("missing", "def")) ;
+	cutil::Assert::isTrue(root->getBool("missing", true)) ;
+}
+
+void
+MemoryStateHandlerTest::childPathsCreateNodes()
+{
+	cutil::MemoryStateHandler handler ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+	cutil::RefCountPtr<cutil::StateNode> child = root->getChild("a/b") ;
+	cutil::Assert::areEqual(std::string("/a/b"), child->getPath()) ;
+	cutil::Assert::isTrue(root->hasChild("a")) ;
+	cutil::Assert::isTrue(root->hasChild("a/b")) ;
+	cutil::Assert::isFalse(root->hasChild("b")) ;
+
+	// each handle shares the underlying StateNode
+	child->setInt("value", 3) ;
+	cutil::Assert::areEqual(3, root->getChild("a")->getChild("b")->getInt("value", 0)) ;
+	cutil::Assert::areEqual(3, handler.getRootNode()->getChild("/a/b")->getInt("value", 0)) ;
+}
+
+void
+MemoryStateHandlerTest::parentIsFound()
+{
+	cutil::MemoryStateHandler handler ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+	cutil::RefCountPtr<cutil::StateNode> child = root->getChild("a/b") ;
+
+	cutil::RefCountPtr<cutil::StateNode> parent = child->getParent() ;
+	cutil::Assert::isTrue(parent.hasPtr()) ;
+	cutil::Assert::areEqual(std::string("/a"), parent->getPath()) ;
+	cutil::Assert::areEqual(std::string("/"), parent->getParent()->getPath()) ;
+	cutil::Assert::isFalse(root->getParent().hasPtr()) ;
+}
+
+void
+MemoryStateHandlerTest::removedChildIsDetached()
+{
+	cutil::MemoryStateHandler handler ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+	cutil::RefCountPtr<cutil::StateNode> child = root->getChild("a/b") ;
+	child->setInt("value", 3) ;
+
+	root->removeChild("a") ;
+	cutil::Assert::isFalse(root->hasChild("a")) ;
+
+	// the handle remains usable, outside the state tree
+	cutil::Assert::areEqual(3, child->getInt("value", 0)) ;
+	cutil::Assert::isFalse(child->getParent().hasPtr()) ;
+
+	// a new StateNode at the same path is not the removed StateNode
+	cutil::Assert::areEqual(0, root->getChild("a/b")->getInt("value", 0)) ;
+	cutil::Assert::isFalse(child->getParent().hasPtr()) ;
+}
+
+void
+MemoryStateHandlerTest::namesKeepSetOrder()
+{
+	cutil::MemoryStateHandler handler ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+	root->setInt("z", 1) ;
+	root->setInt("a", 2) ;
+	root->setInt("m", 3) ;
+	root->setInt("z", 4) ;
+	root->removeValue("a") ;
+
+	std::list<std::string> names ;
+	cutil::Assert::areEqual(2, root->getValueNames(names)) ;
+	cutil::Assert::areEqual(std::string("z,m"), join(names)) ;
+
+	root->getChild("y") ;
+	root->getChild("b") ;
+	root->getChild("x") ;
+	root->removeChild("b") ;
+
+	std::list<std::string> children ;
+	cutil::Assert::areEqual(2, root->getChildren(children)) ;
+	cutil::Assert::areEqual(std::string("y,x"), join(children)) ;
+}
+
+void
+MemoryStateHandlerTest::exportAndImportCopyState()
+{
+	cutil::MemoryStateHandler source ;
+	cutil::RefCountPtr<cutil::StateNode> root = source.getRootNode() ;
+	root->setString("name", "source") ;
+	root->getChild("a")->setDouble("ratio", 0.5) ;
+	root->getChild("a/b")->setBool("enabled", true) ;
+	root->getChild("c")->setInt("count", 9) ;
+
+	// exported and imported values keep their type
+	cutil::MemoryStateHandler exported ;
+	source.exportState(exported) ;
+
+	cutil::MemoryStateHandler imported ;
+	imported.getRootNode()->setInt("replaced", 1) ;
+	imported.importState(exported) ;
+
+	cutil::RefCountPtr<cutil::StateNode> copy = imported.getRootNode() ;
+	cutil::Assert::areEqual(std::string("source"), copy->getString("name", "")) ;
+	cutil::Assert::areEqual(0.5, copy->getChild("a")->getDouble("ratio", 0.0)) ;
+	cutil::Assert::isTrue(copy->getChild("a/b")->getBool("enabled", false)) ;
+	cutil::Assert::areEqual(9, copy->getChild("c")->getInt("count", 0)) ;
+	cutil::Assert::areEqual(-1, copy->getInt("replaced", -1)) ;
+
+	std::list<std::string> children ;
+	copy->getChildren(children) ;
+	cutil::Assert::areEqual(std::string("a,c"), join(children)) ;
+}
+
+void
+MemoryStateHandlerTest::importKeepsSetTypes()
+{
+	cutil::MemoryStateHandler source ;
+	cutil::RefCountPtr<cutil::StateNode> root = source.getRootNode() ;
+	root->setDouble("sum", 0.1 + 0.2) ;
+	root->getChild("a")->setString("count", "12") ;
+
+	// a double held as a string would be read back at the precision of its text
+	cutil::MemoryStateHandler imported ;
+	imported.importState(source) ;
+
+	cutil::RefCountPtr<cutil::StateNode> copy = imported.getRootNode() ;
+	cutil::Assert::areEqual(0.1 + 0.2, copy->getDouble("sum", 0.0)) ;
+	cutil::Assert::areEqual(root->getString("sum", ""), copy->getString("sum", "")) ;
+	cutil::Assert::areEqual(12, copy->getChild("a")->getInt("count", 0)) ;
+	cutil::Assert::areEqual(12.0, copy->getChild("a")->getDouble("count", 0.0)) ;
+}
+
+void
+MemoryStateHandlerTest::modificationsAreCounted()
+{
+	cutil::MemoryStateHandler handler ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+	cutil::Assert::areEqual(0ul, handler.getModificationCount()) ;
+
+	root->setInt("count", 1) ;
+	cutil::RefCountPtr<cutil::StateNode> child = root->getChild("a") ;
+	cutil::Assert::areEqual(2ul, handler.getModificationCount()) ;
+
+	// reading, and finding existing StateNodes, is not modification
+	root->getInt("count", 0) ;
+	root->getChild("a") ;
+	root->removeValue("missing") ;
+	root->removeChild("missing") ;
+	cutil::Assert::areEqual(2ul, handler.getModificationCount()) ;
+
+	child->setString("name", "a") ;
+	root->removeValue("count") ;
+	root->removeChild("a") ;
+	cutil::Assert::areEqual(5ul, handler.getModificationCount()) ;
+
+	// an import starts the count again
+	cutil::MemoryStateHandler source ;
+	source.getRootNode()->setInt("count", 2) ;
+	handler.importState(source) ;
+	cutil::Assert::areEqual(0ul, handler.getModificationCount()) ;
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+MemoryStateHandlerTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<MemoryStateHandlerTest>(this, &MemoryStateHandlerTest::valuesAreTyped, "valuesAreTyped", "", ""));
+	test_cases.push_back(makeTestCase<MemoryStateHandlerTest>(this, &MemoryStateHandlerTest::valuesConvertAsText, "valuesConvertAsText", "", ""));
+	test_cases.push_back(makeTestCase<MemoryStateHandlerTest>(this, &MemoryStateHandlerTest::missingValuesReturnDefault, "missingValuesReturnDefault", "", ""));
+	test_cases.push_back(makeTestCase<MemoryStateHandlerTest>(this, &MemoryStateHandlerTest::childPathsCreateNodes, "childPathsCreateNodes", "", ""));
+	test_cases.push_back(makeTestCase<MemoryStateHandlerTest>(this, &MemoryStateHandlerTest::parentIsFound, "parentIsFound", "", ""));
+	test_cases.push_back(makeTestCase<MemoryStateHandlerTest>(this, &MemoryStateHandlerTest::removedChildIsDetached, "removedChildIsDetached", "", ""));
+	test_cases.push_back(makeTestCase<MemoryStateHandlerTest>(this, &MemoryStateHandlerTest::namesKeepSetOrder, "namesKeepSetOrder", "", ""));
+	test_cases.push_back(makeTestCase<MemoryStateHandlerTest>(this, &MemoryStateHandlerTest::exportAndImportCopyState, "exportAndImportCopyState", "", ""));
+	test_cases.push_back(makeTestCase<MemoryStateHandlerTest>(this, &MemoryStateHandlerTest::importKeepsSetTypes, "importKeepsSetTypes", "", ""));
+	test_cases.push_back(makeTestCase<MemoryStateHandlerTest>(this, &MemoryStateHandlerTest::modificationsAreCounted, "modificationsAreCounted", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
@@ -0,0 +1,394 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "NamedPipeTest.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/NamedPipe.h>
+#include <cutil/NamedPipeException.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+namespace
+{
+	/**
+	 * The read and write ends of a non-blocking FIFO, the FIFO is unlinked on destruction
+	 */
+	class PipePair
+	{
+		public:
+			PipePair()
+				: theReader(tempPath("NamedPipeTest"), cutil::NamedPipe::READ_ONLY_ENUM, false),
+				theWriter(theReader.getPath(), cutil::NamedPipe::WRITE_ONLY_ENUM, false)
+			{
+				theReader.open() ;
+				theWriter.open() ;
+			}
+
+			cutil::NamedPipe& getReader()
+			{
+				return(theReader) ;
+			}
+
+			cutil::NamedPipe& getWriter()
+			{
+				return(theWriter) ;
+			}
+
+			/**
+			 * Reads whatever is available from the reader as a string
+			 */
+			std::string readAll()
+			{
+				char buf[256] ;
+				ssize_t count = theReader.read(buf, sizeof(buf)) ;
+				return(std::string(buf, (count > 0) ? count : 0)) ;
+			}
+
+		private:
+			cutil::NamedPipe theReader ;
+			cutil::NamedPipe theWriter ;
+	} ;
+
+	/**
+	 * Returns the monotonic time in seconds
+	 */
+	double now()
+	{
+		struct timespec ts ;
+		::clock_gettime(CLOCK_MONOTONIC, &ts) ;
+		return(ts.tv_sec + ts.tv_nsec / 1e9) ;
+	}
+
+	/**
+	 * Thread entry opening the specified NamedPipe after a short delay
+	 */
+	void* delayedOpen(void* pipe)
+	{
+		::usleep(50000) ;
+		static_cast<cutil::NamedPipe*>(pipe)->open() ;
+		return(0) ;
+	}
+
+	/**
+	 * A NamedPipe opened blocking by a thread, and the data it reads once opened
+	 */
+	struct BlockingReader
+	{
+		BlockingReader(const std::string& path) : theReader(path, cutil::NamedPipe::READ_ONLY_ENUM, true), theCount(0) {}
+
+		cutil::NamedPipe theReader ;
+		char theData[16] ;
+		ssize_t theCount ;
+	} ;
+
+	/**
+	 * Thread entry opening the specified BlockingReader after a short delay, blocking in
+	 * open until a writer arrives, then reading from it
+	 */
+	void* blockingOpen(void* arg)
+	{
+		BlockingReader* reader = static_cast<BlockingReader*>(arg) ;
+		::usleep(50000) ;
+		reader->theReader.open() ;
+		reader->theCount = reader->theReader.read(reader->theData, sizeof(reader->theData)) ;
+		return(0) ;
+	}
+}
+
+NamedPipeTest::NamedPipeTest() : cutil::AbstractUnitTest("NamedPipe Test", "cutil")
+{
+}
+
+void
+NamedPipeTest::capacityIsSet()
+{
+	PipePair pipe ;
+
+	size_t set = pipe.getWriter().setCapacity(128 * 1024) ;
+	cutil::Assert::isTrue(set >= 128 * 1024) ;
+
+	// capacity belongs to the pipe, both ends see it
+	cutil::Assert::areEqual(set, pipe.getWriter().getCapacity()) ;
+	cutil::Assert::areEqual(set, pipe.getReader().getCapacity()) ;
+
+	// the kernel rounds up to whole pages
+	size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE)) ;
+	set = pipe.getReader().setCapacity(page + 1) ;
+	cutil::Assert::isTrue(set >= page + 1) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), set % page) ;
+}
+
+void
+NamedPipeTest::spliceMovesData()
+{
+	PipePair from ;
+	PipePair to ;
+
+	from.getWriter().write("spliced data", 12) ;
+
+	cutil::Assert::areEqual(static_cast<ssize_t>(7), from.getReader().spliceTo(to.getWriter(), 7)) ;
+	cutil::Assert::areEqual(std::string("spliced"), to.readAll()) ;
+
+	// spliced data is consumed from the source
+	cutil::Assert::areEqual(std::string(" data"), from.readAll()) ;
+
+	// splice into a file at its current offset
+	std::string path = tempPath("NamedPipeTest") ;
+	int fd = ::open(path.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0600) ;
+	::unlink(path.c_str()) ;
+
+	from.getWriter().write("to file", 7) ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(7), from.getReader().spliceTo(fd, 7)) ;
+
+	char buf[16] ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(7), ::pread(fd, buf, sizeof(buf), 0)) ;
+	cutil::Assert::areEqual(std::string("to file"), std::string(buf, 7)) ;
+	::close(fd) ;
+}
+
+void
+NamedPipeTest::spliceFromFile()
+{
+	std::string path = tempPath("NamedPipeTest") ;
+	int fd = ::open(path.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0600) ;
+	::unlink(path.c_str()) ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(13), ::write(fd, "file contents", 13)) ;
+	::lseek(fd, 5, SEEK_SET) ;
+
+	PipePair pipe ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(8), pipe.getWriter().spliceFrom(fd, 64)) ;
+	cutil::Assert::areEqual(std::string("contents"), pipe.readAll()) ;
+
+	// the file offset is advanced, end of file is 0
+	cutil::Assert::areEqual(static_cast<ssize_t>(0), pipe.getWriter().spliceFrom(fd, 64)) ;
+	::close(fd) ;
+}
+
+void
+NamedPipeTest::teeDuplicatesData()
+{
+	PipePair from ;
+	PipePair to ;
+
+	from.getWriter().write("fan out", 7) ;
+
+	cutil::Assert::areEqual(static_cast<ssize_t>(7), from.getReader().tee(to.getWriter(), 64)) ;
+	cutil::Assert::areEqual(std::string("fan out"), to.readAll()) ;
+
+	// tee does not consume the source
+	cutil::Assert::areEqual(std::string("fan out"), from.readAll()) ;
+}
+
+void
+NamedPipeTest::vmspliceWritesData()
+{
+	PipePair pipe ;
+
+	static const char data[] = "mapped user memory" ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(18), pipe.getWriter().vmsplice(data, 18)) ;
+	cutil::Assert::areEqual(std::string("mapped user memory"), pipe.readAll()) ;
+}
+
+void
+NamedPipeTest::unopenedTransferFails()
+{
+	cutil::NamedPipe pipe(tempPath("NamedPipeTest"), cutil::NamedPipe::READ_ONLY_ENUM, false) ;
+
+	bool thrown = false ;
+	try
+	{
+		pipe.setCapacity(4096) ;
+	}
+	catch(cutil::NamedPipeException& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown) ;
+
+	thrown = false ;
+	try
+	{
+		pipe.vmsplice("x", 1) ;
+	}
+	catch(cutil::NamedPipeException& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown) ;
+}
+
+void
+NamedPipeTest::writerOpenTimesOut()
+{
+	cutil::NamedPipe writer(tempPath("NamedPipeTest"), cutil::NamedPipe::WRITE_ONLY_ENUM, true) ;
+
+	double start = now() ;
+	cutil::Assert::isFalse(writer.open(100000)) ;
+	cutil::Assert::isTrue(now() - start >= 0.09) ;
+	cutil::Assert::isFalse(writer.isOpen()) ;
+
+	// a zero deadline makes a single attempt
+	cutil::Assert::isFalse(writer.open(0)) ;
+}
+
+void
+NamedPipeTest::writerOpensWhenReaderAppears()
+{
+	cutil::NamedPipe writer(tempPath("NamedPipeTest"), cutil::NamedPipe::WRITE_ONLY_ENUM, true) ;
+	cutil::NamedPipe reader(writer.getPath(), cutil::NamedPipe::READ_ONLY_ENUM, false) ;
+
+	pthread_t thread ;
+	::pthread_create(&thread, 0, delayedOpen, &reader) ;
+
+	double start = now() ;
+	bool opened = writer.open(5000000) ;
+	double elapsed = now() - start ;
+	::pthread_join(thread, 0) ;
+
+	cutil::Assert::isTrue(opened) ;
+	cutil::Assert::isTrue(writer.isOpen()) ;
+	cutil::Assert::isTrue(elapsed < 2.0) ;
+
+	// a blocking NamedPipe is returned to blocking I/O once opened
+	cutil::Assert::areEqual(0, ::fcntl(writer.getFileDescriptor(), F_GETFL) & O_NONBLOCK) ;
+
+	writer.write("opened", 6) ;
+	char buf[16] ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(6), reader.read(buf, sizeof(buf))) ;
+
+	// opening an open NamedPipe succeeds immediately
+	cutil::Assert::isTrue(writer.open(0)) ;
+}
+
+void
+NamedPipeTest::writerOpensForBlockingReader()
+{
+	cutil::NamedPipe writer(tempPath("NamedPipeTest"), cutil::NamedPipe::WRITE_ONLY_ENUM, true) ;
+	BlockingReader reader(writer.getPath()) ;
+
+	// the reader raises no open notification while blocked in open
+	pthread_t thread ;
+	::pthread_create(&thread, 0, blockingOpen, &reader) ;
+
+	double start = now() ;
+	bool opened = writer.open(5000000) ;
+	double elapsed = now() - start ;
+
+	if(opened)
+	{
+		writer.write("opened", 6) ;
+	}
+	else
+	{
+		// release the blocked reader
+		writer.open() ;
+	}
+	writer.close() ;
+	::pthread_join(thread, 0) ;
+
+	cutil::Assert::isTrue(opened) ;
+	cutil::Assert::isTrue(elapsed < 2.0) ;
+	cutil::Assert::areEqual(static_cast<ssize_t>(6), reader.theCount) ;
+	cutil::Assert::areEqual(std::string("opened"), std::string(reader.theData, 6)) ;
+}
+
+void
+NamedPipeTest::readerOpenDoesNotWait()
+{
+	cutil::NamedPipe reader(tempPath("NamedPipeTest"), cutil::NamedPipe::READ_ONLY_ENUM, true) ;
+
+	double start = now() ;
+	cutil::Assert::isTrue(reader.open(-1)) ;
+	cutil::Assert::isTrue(now() - start < 1.0) ;
+	cutil::Assert::isTrue(reader.isOpen()) ;
+	cutil::Assert::areEqual(0, ::fcntl(reader.getFileDescriptor(), F_GETFL) & O_NONBLOCK) ;
+}
+
+void
+NamedPipeTest::notifyDescriptorSignalsOpen()
+{
+	cutil::NamedPipe writer(tempPath("NamedPipeTest"), cutil::NamedPipe::WRITE_ONLY_ENUM, false) ;
+	cutil::NamedPipe reader(writer.getPath(), cutil::NamedPipe::READ_ONLY_ENUM, false) ;
+
+	cutil::Assert::isFalse(writer.tryOpen()) ;
+
+	::pollfd pfd[1] ;
+	pfd[0].fd = writer.getOpenNotifyDescriptor() ;
+	pfd[0].events = POLLIN ;
+
+	// the same descriptor is returned until the NamedPipe is opened
+	cutil::Assert::areEqual(pfd[0].fd, writer.getOpenNotifyDescriptor()) ;
+	cutil::Assert::areEqual(0, ::poll(pfd, 1, 0)) ;
+
+	reader.open() ;
+	cutil::Assert::areEqual(1, ::poll(pfd, 1, 1000)) ;
+
+	cutil::Assert::isTrue(writer.tryOpen()) ;
+	cutil::Assert::isTrue(writer.isOpen()) ;
+
+	// an uncreated NamedPipe has nothing to watch
+	cutil::NamedPipe uncreated ;
+	bool thrown = false ;
+	try
+	{
+		uncreated.getOpenNotifyDescriptor() ;
+	}
+	catch(cutil::NamedPipeException& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown) ;
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+NamedPipeTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<NamedPipeTest>(this, &NamedPipeTest::capacityIsSet, "capacityIsSet", "", ""));
+	test_cases.push_back(makeTestCase<NamedPipeTest>(this, &NamedPipeTest::spliceMovesData, "spliceMovesData", "", ""));
+	test_cases.push_back(makeTestCase<NamedPipeTest>(this, &NamedPipeTest::spliceFromFile, "spliceFromFile", "", ""));
+	test_cases.push_back(makeTestCase<NamedPipeTest>(this, &NamedPipeTest::teeDuplicatesData, "teeDuplicatesData", "", ""));
+	test_cases.push_back(makeTestCase<NamedPipeTest>(this, &NamedPipeTest::vmspliceWritesData, "vmspliceWritesData", "", ""));
+	test_cases.push_back(makeTestCase<NamedPipeTest>(this, &NamedPipeTest::unopenedTransferFails, "unopenedTransferFails", "", ""));
+	test_cases.push_back(makeTestCase<NamedPipeTest>(this, &NamedPipeTest::writerOpenTimesOut, "writerOpenTimesOut", "", ""));
+	test_cases.push_back(makeTestCase<NamedPipeTest>(this, &NamedPipeTest::writerOpensWhenReaderAppears, "writerOpensWhenReaderAppears", "", ""));
+	test_cases.push_back(makeTestCase<NamedPipeTest>(this, &NamedPipeTest::writerOpensForBlockingReader, "writerOpensForBlockingReader", "", ""));
+	test_cases.push_back(makeTestCase<NamedPipeTest>(this, &NamedPipeTest::readerOpenDoesNotWait, "readerOpenDoesNotWait", "", ""));
+	test_cases.push_back(makeTestCase<NamedPipeTest>(this, &NamedPipeTest::notifyDescriptorSignalsOpen, "notifyDescriptorSignalsOpen", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
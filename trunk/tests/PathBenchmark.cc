@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+/*
+ * Compares the cost of common path operations between FilePath and CompactPath,
+ * modelled on a directory scan creating a path for every entry of a directory.
+ *
+ * usage: PathBenchmark [iterations]
+ */
+
+#include <cutil/CompactPath.h>
+#include <cutil/FilePath.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+namespace
+{
+	/** prevents the optimiser discarding benchmark results */
+	volatile size_t sink = 0 ;
+
+	double now()
+	{
+		struct timespec ts ;
+		::clock_gettime(CLOCK_MONOTONIC, &ts) ;
+		return(ts.tv_sec + ts.tv_nsec / 1e9) ;
+	}
+
+	void report(const char* name, double file_path_secs, double compact_path_secs, size_t operations)
+	{
+		std::printf("%-24s FilePath %8.1f ns/op   CompactPath %8.1f ns/op   %5.2fx\n",
+			name,
+			file_path_secs * 1e9 / operations,
+			compact_path_secs * 1e9 / operations,
+			file_path_secs / compact_path_secs) ;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	size_t iterations = (argc > 1) ? std::strtoul(argv[1], NULL, 10) : 200 ;
+
+	const std::string directory("/home/user/src/project/library/include/detail") ;
+	std::vector<std::string> names ;
+	for(int i = 0 ; i < 1000 ; ++i)
+	{
+		char name[32] ;
+		std::snprintf(name, sizeof(name), "source_file_%04d.cc", i) ;
+		names.push_back(name) ;
+	}
+	size_t operations = iterations * names.size() ;
+
+	// child path construction, as performed for every entry of a scanned directory
+	double start = now() ;
+	{
+		cutil::FilePath dir(directory) ;
+		for(size_t i = 0 ; i < iterations ; ++i)
+		{
+			for(size_t n = 0 ; n < names.size() ; ++n)
+			{
+				cutil::FilePath child(dir, names[n]) ;
+				sink += child.getPath().size() ;
+			}
+		}
+	}
+	double file_path_secs = now() - start ;
+
+	start = now() ;
+	{
+		cutil::CompactPath dir(directory) ;
+		dir.intern() ;
+		for(size_t i = 0 ; i < iterations ; ++i)
+		{
+			for(size_t n = 0 ; n < names.size() ; ++n)
+			{
+				cutil::CompactPath child(dir, names[n].c_str()) ;
+				sink += child.getLength() ;
+			}
+		}
+	}
+	report("construct child", file_path_secs, now() - start, operations) ;
+
+	// leaf and parent access
+	std::vector<cutil::FilePath> file_paths ;
+	std::vector<cutil::CompactPath> compact_paths ;
+	{
+		cutil::CompactPath dir(directory) ;
+		dir.intern() ;
+		for(size_t n = 0 ; n < names.size() ; ++n)
+		{
+			file_paths.push_back(cutil::FilePath(directory, names[n])) ;
+			compact_paths.push_back(cutil::CompactPath(dir, names[n].c_str())) ;
+		}
+	}
+
+	start = now() ;
+	for(size_t i = 0 ; i < iterations ; ++i)
+	{
+		for(size_t n = 0 ; n < file_paths.size() ; ++n)
+		{
+			sink += file_paths[n].getLeaf().size() + file_paths[n].getParentFile().getPath().size() ;
+		}
+	}
+	file_path_secs = now() - start ;
+
+	start = now() ;
+	for(size_t i = 0 ; i < iterations ; ++i)
+	{
+		for(size_t n = 0 ; n < compact_paths.size() ; ++n)
+		{
+			sink += compact_paths[n].getLeaf().theLength + compact_paths[n].getParent().getLength() ;
+		}
+	}
+	report("leaf and parent", file_path_secs, now() - start, operations) ;
+
+	// component iteration, FilePath offers no iteration so components are peeled from the leaf
+	start = now() ;
+	for(size_t i = 0 ; i < iterations ; ++i)
+	{
+		for(size_t n = 0 ; n < file_paths.size() ; ++n)
+		{
+			cutil::FilePath path(file_paths[n]) ;
+			while(!path.isEmpty())
+			{
+				sink += path.getLeaf().size() ;
+				path = path.getParentFile() ;
+			}
+		}
+	}
+	file_path_secs = now() - start ;
+
+	start = now() ;
+	for(size_t i = 0 ; i < iterations ; ++i)
+	{
+		for(size_t n = 0 ; n < compact_paths.size() ; ++n)
+		{
+			cutil::CompactPath::ComponentIterator iter(compact_paths[n]) ;
+			while(iter.hasNext())
+			{
+				sink += iter.next().theLength ;
+			}
+		}
+	}
+	report("iterate components", file_path_secs, now() - start, operations) ;
+
+	std::printf("sizeof(FilePath) %lu, sizeof(CompactPath) %lu\n",
+		static_cast<unsigned long>(sizeof(cutil::FilePath)),
+		static_cast<unsigned long>(sizeof(cutil::CompactPath))) ;
+
+	return(0) ;
+}
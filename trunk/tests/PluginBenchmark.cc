@@ -0,0 +1,508 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+/*
+ * Measures PluginManager registry operations against the number of registered Plugins,
+ * using the testplugin fixture module. Per operation costs should remain flat as the
+ * registry grows.
+ *
+ * Also compares registering a directory of modules one at a time against concurrent
+ * discovery with PluginManager::registerDirectory.
+ *
+ * usage: PluginBenchmark [module] [iterations]
+ */
+
+#include "TestPlugin.h"
+
+#include <cutil/FilePath.h>
+#include <cutil/FileTree.h>
+#include <cutil/PluginManager.h>
+#include <cutil/PluginManifest.h>
+#include <cutil/PluginStatistics.h>
+#include <cutil/SharedLibrary.h>
+#include <cutil/SymbolTable.h>
+#include <cutil/ThreadPool.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef TEST_PLUGIN_MODULE
+#define TEST_PLUGIN_MODULE "./.libs/testplugin.so"
+#endif
+
+namespace
+{
+	/** prevents the optimiser discarding benchmark results */
+	volatile long sink = 0 ;
+
+	double now()
+	{
+		struct timespec ts ;
+		::clock_gettime(CLOCK_MONOTONIC, &ts) ;
+		return(ts.tv_sec + ts.tv_nsec / 1e9) ;
+	}
+
+	/** shared state of the concurrent handle benchmark */
+	struct ConcurrentRun
+	{
+		cutil::PluginHandle<cutil::unit_tests::TestPlugin>* theHandles ;
+		size_t theCount ;
+		size_t theIterations ;
+	} ;
+
+	/** copies and releases handles from a worker thread, as on each request of a server */
+	void* copyHandles(void* arg)
+	{
+		ConcurrentRun* run = static_cast<ConcurrentRun*>(arg) ;
+
+		long sum = 0 ;
+		unsigned int index = static_cast<unsigned int>(reinterpret_cast<size_t>(&sum)) ;
+		for(size_t i = 0 ; i < run->theIterations ; ++i)
+		{
+			index = index * 1103515245 + 12345 ;
+			cutil::PluginHandle<cutil::unit_tests::TestPlugin> handle(run->theHandles[index % run->theCount]) ;
+			sum += handle->getValue() ;
+		}
+		sink += sum ;
+
+		return(0) ;
+	}
+
+	/** shared state of the reload benchmark, resolving a Plugin while its module is reloaded */
+	struct ReloadRun
+	{
+		cutil::PluginManager* theManager ;
+		std::string theModule ;
+		volatile bool theStopFlag ;
+		volatile long theRequests ;
+		volatile long theFailures ;
+	} ;
+
+	/** serves requests through a PluginResolver until stopped */
+	void* serveRequests(void* arg)
+	{
+		ReloadRun* run = static_cast<ReloadRun*>(arg) ;
+		cutil::PluginResolver<cutil::unit_tests::TestPlugin> resolver(*run->theManager, run->theModule, "plugin3") ;
+
+		long requests = 0 ;
+		long failures = 0 ;
+		while(!run->theStopFlag)
+		{
+			try
+			{
+				cutil::PluginHandle<cutil::unit_tests::TestPlugin> handle = resolver.getHandle() ;
+				if(!handle.isValid() || handle->getValue() != 3)
+				{
+					failures++ ;
+				}
+			}
+			catch(cutil::Exception&)
+			{
+				failures++ ;
+			}
+			requests++ ;
+		}
+		__sync_add_and_fetch(&run->theRequests, requests) ;
+		__sync_add_and_fetch(&run->theFailures, failures) ;
+
+		return(0) ;
+	}
+
+	/** entry points of the fixture module bound through a SymbolTable */
+	struct FixtureSymbols
+	{
+		int (*add)(int, int) ;
+	} ;
+
+	std::string pluginName(size_t index)
+	{
+		char name[32] ;
+		std::snprintf(name, sizeof(name), "plugin%lu", static_cast<unsigned long>(index)) ;
+		return(std::string(name)) ;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const std::string module((argc > 1) ? argv[1] : TEST_PLUGIN_MODULE) ;
+	size_t iterations = (argc > 2) ? std::strtoul(argv[2], NULL, 10) : 200000 ;
+
+	const size_t sizes[] = { 100, 1000, 10000 } ;
+
+	const size_t threadCount = 4 ;
+
+	std::printf("%8s %14s %14s %14s %14s %14s %14s\n", "plugins", "register/op", "load/op", "lookup/op", "handle/op", "resolver/op", "copy x4/op") ;
+
+	for(size_t s = 0 ; s < sizeof(sizes) / sizeof(sizes[0]) ; ++s)
+	{
+		size_t count = sizes[s] ;
+
+		char value[32] ;
+		std::snprintf(value, sizeof(value), "%lu", static_cast<unsigned long>(count)) ;
+		::setenv("CUTIL_TEST_PLUGIN_COUNT", value, 1) ;
+
+		// lookup keys are built up front so string construction is not measured
+		std::vector<std::string> names ;
+		for(size_t i = 0 ; i < count ; ++i)
+		{
+			names.push_back(pluginName(i)) ;
+		}
+
+		try
+		{
+			cutil::PluginManager manager ;
+
+			double start = now() ;
+			manager.registerPlugins(module) ;
+			double registerSecs = now() - start ;
+
+			start = now() ;
+			manager.loadPlugins(module) ;
+			double loadSecs = now() - start ;
+
+			// hold a handle to each Plugin, otherwise releasing the last handle unloads the Plugin
+			std::vector<cutil::PluginHandle<cutil::unit_tests::TestPlugin> > held ;
+			held.reserve(count) ;
+			for(size_t i = 0 ; i < count ; ++i)
+			{
+				held.push_back(manager.getPluginHandle<cutil::unit_tests::TestPlugin>(module, names[i])) ;
+			}
+
+			// name lookup, as performed for each access of a loaded Plugin
+			unsigned int index = 12345 ;
+			start = now() ;
+			for(size_t i = 0 ; i < iterations ; ++i)
+			{
+				index = index * 1103515245 + 12345 ;
+				sink += manager.isLoaded(module, names[index % count]) ;
+			}
+			double lookupSecs = now() - start ;
+
+			// handle acquire and release, each referencing and unreferencing the Plugin
+			start = now() ;
+			for(size_t i = 0 ; i < iterations ; ++i)
+			{
+				index = index * 1103515245 + 12345 ;
+				cutil::PluginHandle<cutil::unit_tests::TestPlugin> handle = manager.getPluginHandle<cutil::unit_tests::TestPlugin>(module, names[index % count]) ;
+				sink += handle->getValue() ;
+			}
+			double handleSecs = now() - start ;
+
+			// handle acquire and release through a PluginResolver per Plugin, caching the lookup and cast
+			std::vector<cutil::PluginResolver<cutil::unit_tests::TestPlugin> > resolvers ;
+			resolvers.reserve(count) ;
+			for(size_t i = 0 ; i < count ; ++i)
+			{
+				resolvers.push_back(cutil::PluginResolver<cutil::unit_tests::TestPlugin>(manager, module, names[i])) ;
+			}
+
+			start = now() ;
+			for(size_t i = 0 ; i < iterations ; ++i)
+			{
+				index = index * 1103515245 + 12345 ;
+				cutil::PluginHandle<cutil::unit_tests::TestPlugin> handle = resolvers[index % count].getHandle() ;
+				sink += handle->getValue() ;
+			}
+			double resolverSecs = now() - start ;
+
+			// handle copies from concurrent threads, reported as wall time per copy of each thread
+			ConcurrentRun run ;
+			run.theHandles = &held[0] ;
+			run.theCount = count ;
+			run.theIterations = iterations ;
+
+			std::vector<pthread_t> threads(threadCount) ;
+			start = now() ;
+			for(size_t t = 0 ; t < threadCount ; ++t)
+			{
+				::pthread_create(&threads[t], NULL, copyHandles, &run) ;
+			}
+			for(size_t t = 0 ; t < threadCount ; ++t)
+			{
+				::pthread_join(threads[t], NULL) ;
+			}
+			double copySecs = now() - start ;
+
+			std::printf("%8lu %11.1f ns %11.1f ns %11.1f ns %11.1f ns %11.1f ns %11.1f ns\n",
+				static_cast<unsigned long>(count),
+				registerSecs * 1e9 / count,
+				loadSecs * 1e9 / count,
+				lookupSecs * 1e9 / iterations,
+				handleSecs * 1e9 / iterations,
+				resolverSecs * 1e9 / iterations,
+				copySecs * 1e9 / iterations) ;
+
+			held.clear() ;
+			manager.unloadAll() ;
+			manager.unregisterAll() ;
+		}
+		catch(cutil::PluginManagerException& pme)
+		{
+			std::fprintf(stderr, "%s\n", pme.toString().c_str()) ;
+			return(1) ;
+		}
+		catch(cutil::SharedLibraryException& sle)
+		{
+			std::fprintf(stderr, "%s\n", sle.toString().c_str()) ;
+			return(1) ;
+		}
+	}
+
+	// entry point calls, looked up on each call and through pre-bound symbols
+	try
+	{
+		cutil::SharedLibrary library(module) ;
+		library.open() ;
+		void* handle = ::dlopen(module.c_str(), RTLD_NOW) ;
+
+		double start = now() ;
+		for(size_t i = 0 ; i < iterations ; ++i)
+		{
+			int (*add)(int, int) = (int (*)(int, int))::dlsym(handle, "testPluginAdd") ;
+			sink += add(static_cast<int>(i), 1) ;
+		}
+		double dlsymSecs = now() - start ;
+
+		start = now() ;
+		for(size_t i = 0 ; i < iterations ; ++i)
+		{
+			int (*add)(int, int) = (int (*)(int, int))library.getSymbol("testPluginAdd") ;
+			sink += add(static_cast<int>(i), 1) ;
+		}
+		double cachedSecs = now() - start ;
+
+		cutil::SymbolTable<FixtureSymbols> table ;
+		table.declare("testPluginAdd", &FixtureSymbols::add) ;
+		FixtureSymbols symbols ;
+		table.bind(library, symbols) ;
+
+		start = now() ;
+		for(size_t i = 0 ; i < iterations ; ++i)
+		{
+			sink += symbols.add(static_cast<int>(i), 1) ;
+		}
+		double boundSecs = now() - start ;
+
+		::dlclose(handle) ;
+
+		std::printf("\nentry point call: dlsym %.1f ns, cached getSymbol %.1f ns, SymbolTable bound %.1f ns\n",
+			dlsymSecs * 1e9 / iterations,
+			cachedSecs * 1e9 / iterations,
+			boundSecs * 1e9 / iterations) ;
+	}
+	catch(cutil::SharedLibraryException& sle)
+	{
+		std::fprintf(stderr, "%s\n", sle.toString().c_str()) ;
+		return(1) ;
+	}
+
+	// Plugin calls through a handle, without and with instrumentation
+	try
+	{
+		cutil::PluginManager manager ;
+		manager.loadPlugin(module, "plugin3") ;
+		cutil::PluginHandle<cutil::unit_tests::TestPlugin> handle = manager.getPluginHandle<cutil::unit_tests::TestPlugin>(module, "plugin3") ;
+
+		double start = now() ;
+		for(size_t i = 0 ; i < iterations ; ++i)
+		{
+			sink += handle->getValue() ;
+		}
+		double plainSecs = now() - start ;
+
+		manager.setInstrumented(true) ;
+		start = now() ;
+		for(size_t i = 0 ; i < iterations ; ++i)
+		{
+			sink += handle->getValue() ;
+		}
+		double instrumentedSecs = now() - start ;
+
+		cutil::PluginStatistics stats ;
+		manager.getStatistics(module, "plugin3", stats) ;
+
+		std::printf("plugin call: plain %.1f ns, instrumented %.1f ns, recorded mean %.1f ns, p50 < %llu ns, p99 < %llu ns\n",
+			plainSecs * 1e9 / iterations,
+			instrumentedSecs * 1e9 / iterations,
+			stats.getMeanCallTime(),
+			stats.getCallPercentile(50),
+			stats.getCallPercentile(99)) ;
+	}
+	catch(cutil::Exception& e)
+	{
+		std::fprintf(stderr, "%s\n", e.toString().c_str()) ;
+		return(1) ;
+	}
+
+	// module discovery, each module a copy of the fixture so it is opened as a distinct SharedLibrary
+	char directory[] = "/tmp/PluginBenchmarkXXXXXX" ;
+	if(::mkdtemp(directory) == NULL)
+	{
+		std::perror("mkdtemp") ;
+		return(1) ;
+	}
+
+	try
+	{
+		const size_t moduleCount = 200 ;
+		::setenv("CUTIL_TEST_PLUGIN_COUNT", "16", 1) ;
+
+		std::vector<std::string> modules ;
+		for(size_t i = 0 ; i < moduleCount ; ++i)
+		{
+			char name[32] ;
+			std::snprintf(name, sizeof(name), "module%03lu.so", static_cast<unsigned long>(i)) ;
+			cutil::FilePath path(directory, name) ;
+			cutil::FileTree::copyFile(cutil::FilePath(module), path) ;
+			modules.push_back(path.getPath()) ;
+		}
+
+		double serialSecs = 0 ;
+		{
+			cutil::PluginManager manager ;
+			double start = now() ;
+			for(size_t i = 0 ; i < moduleCount ; ++i)
+			{
+				manager.registerPlugins(modules[i]) ;
+				manager.loadPlugins(modules[i]) ;
+			}
+			serialSecs = now() - start ;
+			manager.unloadAll() ;
+		}
+
+		double parallelSecs = 0 ;
+		{
+			cutil::ThreadPool pool ;
+			cutil::PluginManager manager ;
+			std::vector<std::string> discovered ;
+
+			double start = now() ;
+			manager.registerDirectory(cutil::FilePath(directory), pool, discovered) ;
+			for(size_t i = 0 ; i < discovered.size() ; ++i)
+			{
+				manager.loadPlugins(discovered[i]) ;
+			}
+			parallelSecs = now() - start ;
+			manager.unloadAll() ;
+		}
+
+		std::printf("\n%lu modules registered and loaded: serial %.1f ms, concurrent discovery (%lu threads) %.1f ms\n",
+			static_cast<unsigned long>(moduleCount),
+			serialSecs * 1e3,
+			static_cast<unsigned long>(cutil::ThreadPool::getDefaultThreadCount()),
+			parallelSecs * 1e3) ;
+
+		// start-up registration only, opening every module to record the manifest and then from the manifest
+		cutil::FilePath manifestPath(directory, "plugins.manifest") ;
+		double openedSecs = 0 ;
+		{
+			cutil::ThreadPool pool ;
+			cutil::PluginManifest manifest ;
+			cutil::PluginManager manager ;
+			manager.setManifest(&manifest) ;
+
+			double start = now() ;
+			manager.registerPlugins(modules, pool) ;
+			openedSecs = now() - start ;
+			manifest.save(manifestPath) ;
+		}
+
+		double manifestSecs = 0 ;
+		{
+			cutil::ThreadPool pool ;
+			cutil::PluginManifest manifest ;
+			cutil::PluginManager manager ;
+			manager.setManifest(&manifest) ;
+
+			double start = now() ;
+			manifest.load(manifestPath) ;
+			manager.registerPlugins(modules, pool) ;
+			manifestSecs = now() - start ;
+		}
+
+		std::printf("%lu modules registered: opened %.1f ms, from manifest %.1f ms\n",
+			static_cast<unsigned long>(moduleCount),
+			openedSecs * 1e3,
+			manifestSecs * 1e3) ;
+
+		// module reloads, alternating between two copies, while requests are served concurrently
+		{
+			const size_t reloadCount = 100 ;
+
+			cutil::PluginManager manager ;
+			manager.registerPlugins(modules[0]) ;
+			manager.loadPlugin(modules[0], "plugin3") ;
+			cutil::PluginHandle<cutil::unit_tests::TestPlugin> held = manager.getPluginHandle<cutil::unit_tests::TestPlugin>(modules[0], "plugin3") ;
+			manager.setAutoLoad(true) ;
+
+			ReloadRun run ;
+			run.theManager = &manager ;
+			run.theModule = modules[0] ;
+			run.theStopFlag = false ;
+			run.theRequests = 0 ;
+			run.theFailures = 0 ;
+
+			std::vector<pthread_t> threads(threadCount) ;
+			for(size_t t = 0 ; t < threadCount ; ++t)
+			{
+				::pthread_create(&threads[t], NULL, serveRequests, &run) ;
+			}
+
+			double start = now() ;
+			for(size_t i = 0 ; i < reloadCount ; ++i)
+			{
+				manager.reloadModule(modules[0], modules[1 + (i % 2)]) ;
+			}
+			double reloadSecs = now() - start ;
+
+			run.theStopFlag = true ;
+			for(size_t t = 0 ; t < threadCount ; ++t)
+			{
+				::pthread_join(threads[t], NULL) ;
+			}
+
+			std::printf("%lu module reloads under load: %.2f ms per reload, %ld requests, %ld failed, %lu retired Plugins held\n",
+				static_cast<unsigned long>(reloadCount),
+				reloadSecs * 1e3 / reloadCount,
+				static_cast<long>(run.theRequests),
+				static_cast<long>(run.theFailures),
+				static_cast<unsigned long>(manager.getRetiredCount())) ;
+		}
+
+		cutil::FileTree().remove(cutil::FilePath(directory)) ;
+	}
+	catch(cutil::Exception& e)
+	{
+		std::fprintf(stderr, "%s\n", e.toString().c_str()) ;
+		cutil::FileTree().remove(cutil::FilePath(directory)) ;
+		return(1) ;
+	}
+
+	return(0) ;
+}
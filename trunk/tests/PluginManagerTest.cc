@@ -0,0 +1,994 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "PluginManagerTest.h"
+#include "TestPlugin.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/FilePath.h>
+#include <cutil/FileTree.h>
+#include <cutil/PluginManager.h>
+#include <cutil/PluginManagerException.h>
+#include <cutil/PluginNameTransform.h>
+#include <cutil/PluginStatistics.h>
+#include <cutil/RefCountPtr.h>
+#include <cutil/SharedLibraryException.h>
+#include <cutil/ThreadPool.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+using cutil::PluginHandle ;
+using cutil::PluginManager ;
+using cutil::PluginResolver ;
+
+namespace
+{
+	/**
+	 * Copies the testplugin fixture, the copy being a distinct module to the dynamic linker
+	 */
+	std::string copyModule(const TempDirectory& dir, const std::string& name)
+	{
+		std::string path = dir.getPath(name) ;
+		cutil::FileTree::copyFile(cutil::FilePath(TEST_PLUGIN_MODULE), cutil::FilePath(path)) ;
+		return(path) ;
+	}
+
+	/**
+	 * Returns true if the specified path is mapped into this process
+	 */
+	bool isMapped(const std::string& path)
+	{
+		std::ifstream in("/proc/self/maps") ;
+		std::string line ;
+		while(std::getline(in, line))
+		{
+			if(line.find(path) != std::string::npos)
+			{
+				return(true) ;
+			}
+		}
+		return(false) ;
+	}
+
+	/**
+	 * Sets the number of Plugins the testplugin fixture offers for the lifetime of this PluginCount
+	 */
+	class PluginCount
+	{
+		public:
+			PluginCount(int count)
+			{
+				char value[32] ;
+				std::snprintf(value, sizeof(value), "%d", count) ;
+				::setenv("CUTIL_TEST_PLUGIN_COUNT", value, 1) ;
+			}
+
+			~PluginCount()
+			{
+				::unsetenv("CUTIL_TEST_PLUGIN_COUNT") ;
+			}
+	} ;
+
+	/**
+	 * Maps application names to fixture Plugins
+	 */
+	class MapTransform : public cutil::PluginNameTransform
+	{
+		public:
+			void add(const std::string& name, const std::string& module, const std::string& plugin)
+			{
+				TransformData data ;
+				data.theModule = module ;
+				data.thePluginName = plugin ;
+				theNames[name] = data ;
+			}
+
+			virtual bool lookup(const std::string& name, TransformData& data)
+			{
+				std::map<std::string, TransformData>::const_iterator citer = theNames.find(name) ;
+				if(citer != theNames.end())
+				{
+					data = citer->second ;
+				}
+				return(citer != theNames.end()) ;
+			}
+
+		private:
+			std::map<std::string, TransformData> theNames ;
+	} ;
+
+	/**
+	 * Returns the number of PluginHandles referencing the specified Plugin
+	 */
+	int handleCount(const PluginManager& manager, const std::string& module, const std::string& name)
+	{
+		cutil::PluginStatistics stats ;
+		manager.getStatistics(module, name, stats) ;
+		return(stats.getHandleCount()) ;
+	}
+
+	/**
+	 * Copies and destroys a shared PluginHandle from many threads
+	 */
+	struct HandleChurn
+	{
+		const PluginHandle<TestPlugin>* theHandle ;
+		int theIterations ;
+		int theSum ;
+	} ;
+
+	void* churnHandles(void* arg)
+	{
+		HandleChurn* churn = static_cast<HandleChurn*>(arg) ;
+		PluginHandle<TestPlugin> local ;
+		for(int i = 0 ; i < churn->theIterations ; ++i)
+		{
+			PluginHandle<TestPlugin> copy(*churn->theHandle) ;
+			local = copy ;
+			churn->theSum += local->getValue() ;
+		}
+		return(NULL) ;
+	}
+
+	/**
+	 * Resolves and releases a Plugin from many threads, each with its own PluginResolver
+	 */
+	struct ResolverChurn
+	{
+		PluginManager* theManager ;
+		int theIterations ;
+		int theSum ;
+		std::string theError ;
+	} ;
+
+	void* churnResolver(void* arg)
+	{
+		ResolverChurn* churn = static_cast<ResolverChurn*>(arg) ;
+		PluginResolver<TestPlugin> resolver(*churn->theManager, TEST_PLUGIN_MODULE, "plugin9") ;
+		try
+		{
+			for(int i = 0 ; i < churn->theIterations ; ++i)
+			{
+				PluginHandle<TestPlugin> handle = resolver.getHandle() ;
+				churn->theSum += handle->getValue() ;
+			}
+		}
+		catch(cutil::Exception& e)
+		{
+			churn->theError = e.toString() ;
+		}
+		return(NULL) ;
+	}
+
+	/**
+	 * Acquires and releases a Plugin by application name from many threads
+	 */
+	void* churnNamedHandles(void* arg)
+	{
+		ResolverChurn* churn = static_cast<ResolverChurn*>(arg) ;
+		try
+		{
+			for(int i = 0 ; i < churn->theIterations ; ++i)
+			{
+				PluginHandle<TestPlugin> handle = churn->theManager->getPluginHandle<TestPlugin>("nine") ;
+				churn->theSum += handle->getValue() ;
+			}
+		}
+		catch(cutil::Exception& e)
+		{
+			churn->theError = e.toString() ;
+		}
+		return(NULL) ;
+	}
+
+	/**
+	 * Evicts idle Plugins repeatedly until stopped
+	 */
+	struct Evictor
+	{
+		PluginManager* theManager ;
+		volatile bool theStopFlag ;
+		size_t theEvicted ;
+		std::string theError ;
+	} ;
+
+	void* evictIdle(void* arg)
+	{
+		Evictor* evictor = static_cast<Evictor*>(arg) ;
+		try
+		{
+			while(!evictor->theStopFlag)
+			{
+				evictor->theEvicted += evictor->theManager->evictIdle() ;
+			}
+		}
+		catch(cutil::Exception& e)
+		{
+			evictor->theError = e.toString() ;
+		}
+		return(NULL) ;
+	}
+}
+
+PluginManagerTest::PluginManagerTest() : cutil::AbstractUnitTest("PluginManager Test", "cutil")
+{
+}
+
+void
+PluginManagerTest::registryFindsPlugins()
+{
+	PluginManager manager ;
+	manager.registerPlugins(TEST_PLUGIN_MODULE) ;
+
+	for(int i = 0 ; i < 16 ; ++i)
+	{
+		char name[32] ;
+		std::snprintf(name, sizeof(name), "plugin%d", i) ;
+		cutil::Assert::isTrue(manager.isRegistered(TEST_PLUGIN_MODULE, name), name) ;
+		cutil::Assert::isFalse(manager.isLoaded(TEST_PLUGIN_MODULE, name), name) ;
+	}
+	cutil::Assert::isFalse(manager.isRegistered(TEST_PLUGIN_MODULE, "plugin16")) ;
+	cutil::Assert::isFalse(manager.isRegistered("other.so", "plugin1")) ;
+
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin5") ;
+	cutil::Assert::isTrue(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin5")) ;
+
+	TestPlugin* plugin = dynamic_cast<TestPlugin*>(manager.getPlugin(TEST_PLUGIN_MODULE, "plugin5")) ;
+	cutil::Assert::isTrue(plugin != 0) ;
+	cutil::Assert::areEqual(5, plugin->getValue()) ;
+
+	// references by Plugin are found through the index of loaded Plugins
+	manager.refPlugin(*plugin) ;
+	cutil::Assert::areEqual(1, handleCount(manager, TEST_PLUGIN_MODULE, "plugin5")) ;
+	manager.unrefPlugin(*plugin) ;
+	cutil::Assert::isFalse(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin5"), "unloaded once unreferenced") ;
+
+	// unknown Plugins are ignored
+	manager.unrefPlugin(*plugin) ;
+}
+
+void
+PluginManagerTest::registryScales()
+{
+	PluginCount count(2000) ;
+
+	PluginManager manager ;
+	manager.registerPlugins(TEST_PLUGIN_MODULE) ;
+	cutil::Assert::isTrue(manager.isRegistered(TEST_PLUGIN_MODULE, "plugin0")) ;
+	cutil::Assert::isTrue(manager.isRegistered(TEST_PLUGIN_MODULE, "plugin1999")) ;
+	cutil::Assert::isFalse(manager.isRegistered(TEST_PLUGIN_MODULE, "plugin2000")) ;
+
+	std::vector<PluginHandle<TestPlugin> > handles ;
+	for(int i = 0 ; i < 2000 ; i += 100)
+	{
+		char name[32] ;
+		std::snprintf(name, sizeof(name), "plugin%d", i) ;
+		manager.loadPlugin(TEST_PLUGIN_MODULE, name) ;
+		handles.push_back(manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, name)) ;
+		cutil::Assert::areEqual(i, handles.back()->getValue()) ;
+	}
+
+	std::list<cutil::PluginStatistics> statistics ;
+	manager.getStatistics(statistics) ;
+	cutil::Assert::areEqual(static_cast<size_t>(2000), statistics.size()) ;
+}
+
+void
+PluginManagerTest::handleAssignmentCounts()
+{
+	PluginManager manager ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin1") ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin2") ;
+
+	PluginHandle<TestPlugin> first = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin1") ;
+	PluginHandle<TestPlugin> second = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin2") ;
+	PluginHandle<TestPlugin> copy(first) ;
+	cutil::Assert::areEqual(2, handleCount(manager, TEST_PLUGIN_MODULE, "plugin1")) ;
+	cutil::Assert::isTrue(copy == first) ;
+
+	// self assignment keeps the reference
+	copy = copy ;
+	cutil::Assert::areEqual(2, handleCount(manager, TEST_PLUGIN_MODULE, "plugin1")) ;
+
+	copy = second ;
+	cutil::Assert::areEqual(1, handleCount(manager, TEST_PLUGIN_MODULE, "plugin1")) ;
+	cutil::Assert::areEqual(2, handleCount(manager, TEST_PLUGIN_MODULE, "plugin2")) ;
+	cutil::Assert::areEqual(2, copy->getValue()) ;
+
+	// assigning over the last handle unloads the Plugin
+	first = second ;
+	cutil::Assert::isFalse(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin1")) ;
+	cutil::Assert::areEqual(3, handleCount(manager, TEST_PLUGIN_MODULE, "plugin2")) ;
+
+	PluginHandle<TestPlugin> empty ;
+	cutil::Assert::isFalse(empty.isValid()) ;
+	first = empty ;
+	copy.clear() ;
+	cutil::Assert::isFalse(first.isValid()) ;
+	cutil::Assert::areEqual(1, handleCount(manager, TEST_PLUGIN_MODULE, "plugin2")) ;
+
+	second = empty ;
+	cutil::Assert::isFalse(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin2")) ;
+}
+
+void
+PluginManagerTest::concurrentHandlesAreCounted()
+{
+	PluginManager manager ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin7") ;
+
+	PluginHandle<TestPlugin> handle = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin7") ;
+
+	const int THREADS = 8 ;
+	pthread_t threads[THREADS] ;
+	HandleChurn churn[THREADS] ;
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		churn[i].theHandle = &handle ;
+		churn[i].theIterations = 20000 ;
+		churn[i].theSum = 0 ;
+		::pthread_create(&threads[i], NULL, churnHandles, &churn[i]) ;
+	}
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		::pthread_join(threads[i], NULL) ;
+	}
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		cutil::Assert::areEqual(7 * 20000, churn[i].theSum) ;
+	}
+
+	cutil::Assert::areEqual(1, handleCount(manager, TEST_PLUGIN_MODULE, "plugin7")) ;
+	cutil::Assert::isTrue(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin7")) ;
+
+	handle.clear() ;
+	cutil::Assert::isFalse(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin7")) ;
+}
+
+void
+PluginManagerTest::resolverCachesPlugin()
+{
+	PluginManager manager ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin3") ;
+
+	PluginResolver<TestPlugin> resolver(manager, TEST_PLUGIN_MODULE, "plugin3") ;
+	PluginHandle<TestPlugin> first = resolver.getHandle() ;
+	PluginHandle<TestPlugin> second = resolver.getHandle() ;
+	cutil::Assert::isTrue(first.isValid()) ;
+	cutil::Assert::isTrue(first == second) ;
+	cutil::Assert::areEqual(3, second->getValue()) ;
+	cutil::Assert::areEqual(2, handleCount(manager, TEST_PLUGIN_MODULE, "plugin3")) ;
+
+	// resolved by application name
+	MapTransform transform ;
+	transform.add("three", TEST_PLUGIN_MODULE, "plugin3") ;
+	manager.setNameTransform(&transform) ;
+
+	PluginResolver<TestPlugin> named(manager, "three") ;
+	cutil::Assert::isTrue(named.getHandle() == first) ;
+	manager.removeNameTransform() ;
+}
+
+void
+PluginManagerTest::resolverInvalidatedOnUnload()
+{
+	PluginManager manager ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin4") ;
+
+	PluginResolver<TestPlugin> resolver(manager, TEST_PLUGIN_MODULE, "plugin4") ;
+	resolver.getHandle() ;
+
+	// releasing the only handle unloaded the Plugin
+	cutil::Assert::isFalse(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin4")) ;
+
+	bool thrown = false ;
+	try
+	{
+		resolver.getHandle() ;
+	}
+	catch(cutil::PluginManagerException& pme)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown, "unloaded Plugin is not resolved") ;
+
+	manager.setAutoLoad(true) ;
+	PluginHandle<TestPlugin> handle = resolver.getHandle() ;
+	cutil::Assert::isTrue(handle.isValid()) ;
+	cutil::Assert::areEqual(4, handle->getValue()) ;
+	cutil::Assert::isTrue(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin4")) ;
+
+	// an explicit unload, once unreferenced, also invalidates the resolved Plugin
+	handle.clear() ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin4") ;
+	cutil::Assert::isTrue(manager.unloadPlugin(TEST_PLUGIN_MODULE, "plugin4")) ;
+	cutil::Assert::areEqual(4, resolver.getHandle()->getValue()) ;
+}
+
+void
+PluginManagerTest::concurrentResolveAndRelease()
+{
+	PluginManager manager ;
+	manager.setAutoLoad(true) ;
+	manager.registerPlugin(TEST_PLUGIN_MODULE, "plugin9") ;
+
+	// each release of the last handle unloads the Plugin, racing the lock free resolution of the others
+	const int THREADS = 8 ;
+	pthread_t threads[THREADS] ;
+	ResolverChurn churn[THREADS] ;
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		churn[i].theManager = &manager ;
+		churn[i].theIterations = 5000 ;
+		churn[i].theSum = 0 ;
+		::pthread_create(&threads[i], NULL, churnResolver, &churn[i]) ;
+	}
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		::pthread_join(threads[i], NULL) ;
+	}
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		cutil::Assert::areEqual(std::string(), churn[i].theError) ;
+		cutil::Assert::areEqual(9 * 5000, churn[i].theSum) ;
+	}
+
+	// the last release unloads the Plugin, whether or not a resolver referenced it meanwhile
+	cutil::Assert::isFalse(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin9")) ;
+	cutil::Assert::areEqual(0, handleCount(manager, TEST_PLUGIN_MODULE, "plugin9")) ;
+}
+
+void
+PluginManagerTest::resolverInvalidatedOnReload()
+{
+	TempDirectory dir("PluginManagerTest") ;
+	std::string replacement = copyModule(dir, "replacement.so") ;
+
+	PluginManager manager ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin2") ;
+
+	PluginResolver<TestPlugin> resolver(manager, TEST_PLUGIN_MODULE, "plugin2") ;
+	PluginHandle<TestPlugin> before = resolver.getHandle() ;
+
+	manager.reloadModule(TEST_PLUGIN_MODULE, replacement) ;
+
+	PluginHandle<TestPlugin> after = resolver.getHandle() ;
+	cutil::Assert::isTrue(after.isValid()) ;
+	cutil::Assert::isFalse(after == before, "reloaded Plugin is resolved") ;
+	cutil::Assert::areEqual(2, after->getValue()) ;
+	cutil::Assert::areEqual(2, before->getValue()) ;
+}
+
+void
+PluginManagerTest::idleTimeoutEvicts()
+{
+	PluginManager manager ;
+	manager.setIdleTimeout(1) ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin1") ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin2") ;
+
+	PluginHandle<TestPlugin> held = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin2") ;
+	manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin1").clear() ;
+
+	// released Plugins remain loaded until idle for the timeout
+	cutil::Assert::isTrue(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin1")) ;
+
+	::usleep(1100000) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), manager.evictIdle()) ;
+	cutil::Assert::isFalse(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin1")) ;
+	cutil::Assert::isTrue(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin2"), "referenced Plugin is not idle") ;
+	cutil::Assert::areEqual(2, held->getValue()) ;
+
+	held.clear() ;
+	cutil::Assert::isTrue(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin2")) ;
+}
+
+void
+PluginManagerTest::releaseEvictsExpired()
+{
+	PluginManager manager ;
+	manager.setIdleTimeout(1) ;
+
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin1") ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin2") ;
+
+	PluginHandle<TestPlugin> first = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin1") ;
+	PluginHandle<TestPlugin> second = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin2") ;
+	first.clear() ;
+
+	// the release of another Plugin evicts the expired Plugin, while the lock is free
+	::usleep(1100000) ;
+	second.clear() ;
+	cutil::Assert::isFalse(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin1")) ;
+	cutil::Assert::isTrue(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin2"), "just released Plugin is not expired") ;
+}
+
+void
+PluginManagerTest::budgetEvictsLeastRecentlyUsed()
+{
+	TempDirectory dir("PluginManagerTest") ;
+	std::string a = copyModule(dir, "a.so") ;
+	std::string b = copyModule(dir, "b.so") ;
+	std::string c = copyModule(dir, "c.so") ;
+
+	// released Plugins remain loaded, idle, until evicted for the budget
+	PluginManager manager ;
+	manager.setIdleTimeout(3600) ;
+
+	manager.loadPlugin(a, "plugin0") ;
+	size_t module = manager.getMemoryUsage() ;
+	cutil::Assert::isTrue(module > 0) ;
+
+	// idle times are kept in seconds
+	::usleep(1100000) ;
+	manager.loadPlugin(b, "plugin0") ;
+	PluginHandle<TestPlugin> held = manager.getPluginHandle<TestPlugin>(b, "plugin0") ;
+	cutil::Assert::areEqual(2 * module, manager.getMemoryUsage()) ;
+
+	::usleep(1100000) ;
+	manager.setMemoryBudget(2 * module) ;
+	manager.loadPlugin(c, "plugin0") ;
+	cutil::Assert::isFalse(manager.isLoaded(a, "plugin0"), "least recently used module is evicted") ;
+	cutil::Assert::isTrue(manager.isLoaded(b, "plugin0"), "referenced module is not evicted") ;
+	cutil::Assert::isTrue(manager.isLoaded(c, "plugin0"), "loaded module is not evicted") ;
+	cutil::Assert::areEqual(2 * module, manager.getMemoryUsage()) ;
+
+	// releasing b makes it more recently used than c
+	::usleep(1100000) ;
+	held.clear() ;
+	manager.loadPlugin(a, "plugin0") ;
+	cutil::Assert::isTrue(manager.isLoaded(a, "plugin0")) ;
+	cutil::Assert::isTrue(manager.isLoaded(b, "plugin0")) ;
+	cutil::Assert::isFalse(manager.isLoaded(c, "plugin0")) ;
+	cutil::Assert::areEqual(2 * module, manager.getMemoryUsage()) ;
+}
+
+void
+PluginManagerTest::evictionSkipsReferencedPlugins()
+{
+	PluginManager manager ;
+	manager.setAutoLoad(true) ;
+	manager.setIdleTimeout(3600) ;
+	manager.setMemoryBudget(1) ;
+	manager.registerPlugin(TEST_PLUGIN_MODULE, "plugin9") ;
+
+	// every idle moment of the Plugin is a candidate for eviction, racing its resolution
+	Evictor evictor ;
+	evictor.theManager = &manager ;
+	evictor.theStopFlag = false ;
+	evictor.theEvicted = 0 ;
+	pthread_t evicting ;
+	::pthread_create(&evicting, NULL, evictIdle, &evictor) ;
+
+	const int THREADS = 4 ;
+	pthread_t threads[THREADS] ;
+	ResolverChurn churn[THREADS] ;
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		churn[i].theManager = &manager ;
+		churn[i].theIterations = 5000 ;
+		churn[i].theSum = 0 ;
+		::pthread_create(&threads[i], NULL, churnResolver, &churn[i]) ;
+	}
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		::pthread_join(threads[i], NULL) ;
+	}
+	evictor.theStopFlag = true ;
+	::pthread_join(evicting, NULL) ;
+
+	cutil::Assert::areEqual(std::string(), evictor.theError) ;
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		cutil::Assert::areEqual(std::string(), churn[i].theError) ;
+		cutil::Assert::areEqual(9 * 5000, churn[i].theSum) ;
+	}
+
+	manager.evictIdle() ;
+	cutil::Assert::isFalse(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin9")) ;
+	cutil::Assert::areEqual(0, handleCount(manager, TEST_PLUGIN_MODULE, "plugin9")) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), manager.getMemoryUsage()) ;
+}
+
+void
+PluginManagerTest::prewarmLoadsInBackground()
+{
+	MapTransform transform ;
+	transform.add("one", TEST_PLUGIN_MODULE, "plugin1") ;
+	transform.add("two", TEST_PLUGIN_MODULE, "plugin2") ;
+	transform.add("missing", TEST_PLUGIN_MODULE, "plugin99") ;
+
+	PluginManager manager ;
+	manager.setNameTransform(&transform) ;
+
+	std::vector<std::string> names ;
+	names.push_back("missing") ;
+	names.push_back("one") ;
+	names.push_back("two") ;
+
+	cutil::ThreadPool pool(2) ;
+	manager.prewarm(names, pool) ;
+	pool.waitIdle() ;
+
+	// the failure is discarded, the remaining Plugins stay loaded once released
+	cutil::Assert::isTrue(manager.isLoaded("one")) ;
+	cutil::Assert::isTrue(manager.isLoaded("two")) ;
+	cutil::Assert::isFalse(manager.isRegistered("missing")) ;
+
+	manager.getPluginHandle<TestPlugin>("two").clear() ;
+	cutil::Assert::isTrue(manager.isLoaded("two")) ;
+	cutil::Assert::isTrue(manager.getRemainLoaded("two")) ;
+	manager.removeNameTransform() ;
+}
+
+void
+PluginManagerTest::parallelRegistrationIsDeterministic()
+{
+	TempDirectory dir("PluginManagerTest") ;
+	std::vector<std::string> modules ;
+	modules.push_back(copyModule(dir, "c.so")) ;
+	modules.push_back(dir.getPath("b_missing.so")) ;
+	modules.push_back(copyModule(dir, "a.so")) ;
+	modules.push_back(dir.getPath("d_missing.so")) ;
+	modules.push_back(TEST_PLUGIN_MODULE) ;
+	modules.push_back(dir.getPath("c.so")) ;
+
+	cutil::ThreadPool pool(4) ;
+	for(int attempt = 0 ; attempt < 3 ; ++attempt)
+	{
+		PluginManager manager ;
+
+		// the first failing module, in module order, is reported once all others are registered
+		std::string error ;
+		try
+		{
+			manager.registerPlugins(modules, pool) ;
+		}
+		catch(cutil::SharedLibraryException& sle)
+		{
+			error = sle.toString() ;
+		}
+		cutil::Assert::isTrue(error.find("b_missing.so") != std::string::npos, error) ;
+		cutil::Assert::isTrue(error.find("d_missing.so") == std::string::npos, error) ;
+
+		std::list<cutil::PluginStatistics> statistics ;
+		manager.getStatistics(statistics) ;
+		cutil::Assert::areEqual(static_cast<size_t>(48), statistics.size()) ;
+		cutil::Assert::isTrue(manager.isRegistered(dir.getPath("a.so"), "plugin15")) ;
+		cutil::Assert::isTrue(manager.isRegistered(dir.getPath("c.so"), "plugin0")) ;
+		cutil::Assert::isTrue(manager.isRegistered(TEST_PLUGIN_MODULE, "plugin8")) ;
+
+		// the SharedLibraries opened by registration are used to load
+		manager.loadPlugin(dir.getPath("a.so"), "plugin9") ;
+		cutil::Assert::areEqual(9, manager.getPluginHandle<TestPlugin>(dir.getPath("a.so"), "plugin9")->getValue()) ;
+	}
+}
+
+void
+PluginManagerTest::directoryRegistration()
+{
+	TempDirectory dir("PluginManagerTest") ;
+	copyModule(dir, "b.so") ;
+	copyModule(dir, "a.so") ;
+	std::ofstream(dir.getPath("notes.txt").c_str()) << "not a module" ;
+	::mkdir(dir.getPath("sub.so").c_str(), 0755) ;
+
+	cutil::ThreadPool pool(2) ;
+	PluginManager manager ;
+
+	std::vector<std::string> modules ;
+	manager.registerDirectory(cutil::FilePath(dir.getPath()), pool, modules) ;
+	cutil::Assert::areEqual(static_cast<size_t>(2), modules.size()) ;
+	cutil::Assert::areEqual(dir.getPath("a.so"), modules[0]) ;
+	cutil::Assert::areEqual(dir.getPath("b.so"), modules[1]) ;
+	cutil::Assert::isTrue(manager.isRegistered(dir.getPath("b.so"), "plugin3")) ;
+
+	bool thrown = false ;
+	try
+	{
+		manager.registerDirectory(cutil::FilePath(dir.getPath("missing")), pool, modules) ;
+	}
+	catch(cutil::PluginManagerException& pme)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown, "missing directory is reported") ;
+}
+
+void
+PluginManagerTest::reloadRetiresAndDrains()
+{
+	TempDirectory dir("PluginManagerTest") ;
+	std::string replacement = copyModule(dir, "replacement.so") ;
+
+	PluginManager manager ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin1") ;
+
+	PluginHandle<TestPlugin> first = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin1") ;
+	PluginHandle<TestPlugin> second = first ;
+	cutil::Assert::areEqual(0U, manager.getModuleVersion(TEST_PLUGIN_MODULE)) ;
+
+	manager.reloadModule(TEST_PLUGIN_MODULE, replacement) ;
+	cutil::Assert::areEqual(1U, manager.getModuleVersion(TEST_PLUGIN_MODULE)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), manager.getRetiredCount()) ;
+	cutil::Assert::isTrue(manager.isLoaded(TEST_PLUGIN_MODULE, "plugin1")) ;
+
+	// new acquisitions use the replacement, existing references the retired Plugin
+	PluginHandle<TestPlugin> current = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin1") ;
+	cutil::Assert::isFalse(current == first) ;
+	cutil::Assert::areEqual(1, current->getValue()) ;
+	cutil::Assert::areEqual(1, first->getValue()) ;
+	cutil::Assert::areEqual(1, handleCount(manager, TEST_PLUGIN_MODULE, "plugin1")) ;
+
+	// the retired Plugin is destroyed once drained
+	first.clear() ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), manager.getRetiredCount()) ;
+	second.clear() ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), manager.getRetiredCount()) ;
+	cutil::Assert::areEqual(1, current->getValue()) ;
+}
+
+void
+PluginManagerTest::reloadWithdrawsPlugins()
+{
+	TempDirectory dir("PluginManagerTest") ;
+	std::string replacement = copyModule(dir, "replacement.so") ;
+
+	PluginManager manager ;
+	manager.registerPlugins(TEST_PLUGIN_MODULE) ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin12") ;
+	PluginHandle<TestPlugin> withdrawn = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin12") ;
+
+	{
+		PluginCount count(8) ;
+		manager.reloadModule(TEST_PLUGIN_MODULE, replacement) ;
+	}
+
+	cutil::Assert::isTrue(manager.isRegistered(TEST_PLUGIN_MODULE, "plugin7")) ;
+	cutil::Assert::isFalse(manager.isRegistered(TEST_PLUGIN_MODULE, "plugin8")) ;
+	cutil::Assert::isFalse(manager.isRegistered(TEST_PLUGIN_MODULE, "plugin12")) ;
+
+	// a withdrawn Plugin remains usable through existing references
+	cutil::Assert::areEqual(12, withdrawn->getValue()) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), manager.getRetiredCount()) ;
+	withdrawn.clear() ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), manager.getRetiredCount()) ;
+}
+
+void
+PluginManagerTest::failedReloadKeepsVersion()
+{
+	TempDirectory dir("PluginManagerTest") ;
+
+	PluginManager manager ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin6") ;
+	PluginHandle<TestPlugin> handle = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin6") ;
+
+	bool thrown = false ;
+	try
+	{
+		manager.reloadModule(TEST_PLUGIN_MODULE, dir.getPath("missing.so")) ;
+	}
+	catch(cutil::SharedLibraryException& sle)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown, "missing replacement is reported") ;
+	cutil::Assert::areEqual(0U, manager.getModuleVersion(TEST_PLUGIN_MODULE)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), manager.getRetiredCount()) ;
+	cutil::Assert::isTrue(handle == manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin6")) ;
+}
+
+void
+PluginManagerTest::reloadedModuleReopensReplacement()
+{
+	TempDirectory dir("PluginManagerTest") ;
+	std::string module = copyModule(dir, "module.so") ;
+	std::string replacement = copyModule(dir, "replacement.so") ;
+
+	PluginManager manager ;
+	manager.loadPlugin(module, "plugin3") ;
+	manager.reloadModule(module, replacement) ;
+	cutil::Assert::isTrue(isMapped(replacement)) ;
+
+	// once released, the module is closed, and loaded again from the replacement
+	manager.unloadPlugin(module, "plugin3") ;
+	cutil::Assert::isFalse(isMapped(replacement)) ;
+	cutil::Assert::isFalse(isMapped(module)) ;
+
+	manager.loadPlugin(module, "plugin3") ;
+	cutil::Assert::areEqual(1U, manager.getModuleVersion(module)) ;
+	cutil::Assert::isTrue(isMapped(replacement)) ;
+	cutil::Assert::isFalse(isMapped(module)) ;
+
+	PluginHandle<TestPlugin> handle = manager.getPluginHandle<TestPlugin>(module, "plugin3") ;
+	cutil::Assert::areEqual(3, handle->getValue()) ;
+
+	// listing the Plugins of the closed module also uses the replacement
+	handle.clear() ;
+	manager.unloadPlugin(module, "plugin3") ;
+	std::list<cutil::PluginInfo> plugins ;
+	manager.getAvailablePlugins(module, plugins) ;
+	cutil::Assert::isFalse(plugins.empty()) ;
+	cutil::Assert::isFalse(isMapped(module)) ;
+}
+
+void
+PluginManagerTest::reloadUnderResolversDrains()
+{
+	TempDirectory dir("PluginManagerTest") ;
+
+	PluginManager manager ;
+	manager.setAutoLoad(true) ;
+	manager.registerPlugin(TEST_PLUGIN_MODULE, "plugin9") ;
+
+	// resolvers race each reload, retiring the records they resolved
+	const int THREADS = 4 ;
+	const int RELOADS = 16 ;
+	pthread_t threads[THREADS] ;
+	ResolverChurn churn[THREADS] ;
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		churn[i].theManager = &manager ;
+		churn[i].theIterations = 2000 ;
+		churn[i].theSum = 0 ;
+		::pthread_create(&threads[i], NULL, churnResolver, &churn[i]) ;
+	}
+
+	std::string error ;
+	try
+	{
+		for(int i = 0 ; i < RELOADS ; ++i)
+		{
+			std::ostringstream name ;
+			name << "replacement" << i << ".so" ;
+			manager.reloadModule(TEST_PLUGIN_MODULE, copyModule(dir, name.str())) ;
+		}
+	}
+	catch(cutil::Exception& e)
+	{
+		error = e.toString() ;
+	}
+
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		::pthread_join(threads[i], NULL) ;
+	}
+	cutil::Assert::areEqual(std::string(), error) ;
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		cutil::Assert::areEqual(std::string(), churn[i].theError) ;
+		cutil::Assert::areEqual(9 * 2000, churn[i].theSum) ;
+	}
+
+	cutil::Assert::areEqual(static_cast<unsigned int>(RELOADS), manager.getModuleVersion(TEST_PLUGIN_MODULE)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), manager.getRetiredCount()) ;
+
+	PluginResolver<TestPlugin> resolver(manager, TEST_PLUGIN_MODULE, "plugin9") ;
+	cutil::Assert::areEqual(9, resolver.getHandle()->getValue()) ;
+}
+
+void
+PluginManagerTest::acquireWhileRegistryChanges()
+{
+	MapTransform first ;
+	first.add("nine", TEST_PLUGIN_MODULE, "plugin9") ;
+	MapTransform second ;
+	second.add("nine", TEST_PLUGIN_MODULE, "plugin9") ;
+
+	PluginManager manager ;
+	manager.setAutoLoad(true) ;
+	manager.setNameTransform(&first) ;
+	manager.registerPlugin(TEST_PLUGIN_MODULE, "plugin9") ;
+
+	// handles are acquired through the published registry, which each change withdraws
+	const int THREADS = 4 ;
+	pthread_t threads[THREADS] ;
+	ResolverChurn churn[THREADS] ;
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		churn[i].theManager = &manager ;
+		churn[i].theIterations = 5000 ;
+		churn[i].theSum = 0 ;
+		::pthread_create(&threads[i], NULL, churnNamedHandles, &churn[i]) ;
+	}
+
+	std::string error ;
+	try
+	{
+		for(int i = 0 ; i < 200 ; ++i)
+		{
+			char name[32] ;
+			std::snprintf(name, sizeof(name), "plugin%d", 10 + (i % 6)) ;
+
+			manager.setNameTransform((i % 2) ? &first : &second) ;
+			manager.registerPlugin(TEST_PLUGIN_MODULE, name) ;
+			manager.unregisterPlugin(TEST_PLUGIN_MODULE, name) ;
+		}
+	}
+	catch(cutil::Exception& e)
+	{
+		error = e.toString() ;
+	}
+
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		::pthread_join(threads[i], NULL) ;
+	}
+	manager.removeNameTransform() ;
+
+	cutil::Assert::areEqual(std::string(), error) ;
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		cutil::Assert::areEqual(std::string(), churn[i].theError) ;
+		cutil::Assert::areEqual(9 * 5000, churn[i].theSum) ;
+	}
+	cutil::Assert::isTrue(manager.isRegistered(TEST_PLUGIN_MODULE, "plugin9")) ;
+	cutil::Assert::isFalse(manager.isRegistered(TEST_PLUGIN_MODULE, "plugin10")) ;
+	cutil::Assert::areEqual(0, handleCount(manager, TEST_PLUGIN_MODULE, "plugin9")) ;
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+PluginManagerTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::registryFindsPlugins, "registryFindsPlugins", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::registryScales, "registryScales", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::handleAssignmentCounts, "handleAssignmentCounts", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::concurrentHandlesAreCounted, "concurrentHandlesAreCounted", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::resolverCachesPlugin, "resolverCachesPlugin", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::resolverInvalidatedOnUnload, "resolverInvalidatedOnUnload", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::concurrentResolveAndRelease, "concurrentResolveAndRelease", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::resolverInvalidatedOnReload, "resolverInvalidatedOnReload", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::idleTimeoutEvicts, "idleTimeoutEvicts", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::releaseEvictsExpired, "releaseEvictsExpired", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::budgetEvictsLeastRecentlyUsed, "budgetEvictsLeastRecentlyUsed", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::evictionSkipsReferencedPlugins, "evictionSkipsReferencedPlugins", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::prewarmLoadsInBackground, "prewarmLoadsInBackground", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::parallelRegistrationIsDeterministic, "parallelRegistrationIsDeterministic", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::directoryRegistration, "directoryRegistration", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::reloadRetiresAndDrains, "reloadRetiresAndDrains", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::reloadWithdrawsPlugins, "reloadWithdrawsPlugins", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::failedReloadKeepsVersion, "failedReloadKeepsVersion", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::reloadedModuleReopensReplacement, "reloadedModuleReopensReplacement", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::reloadUnderResolversDrains, "reloadUnderResolversDrains", "", ""));
+	test_cases.push_back(makeTestCase<PluginManagerTest>(this, &PluginManagerTest::acquireWhileRegistryChanges, "acquireWhileRegistryChanges", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
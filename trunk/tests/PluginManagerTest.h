@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#ifndef _CUTIL_UNITTESTS_PLUGINMANAGERTEST_H_
+#define _CUTIL_UNITTESTS_PLUGINMANAGERTEST_H_
+
+#include <cutil/AbstractUnitTest.h>
+
+#include <cutil/AbstractTestCase.h>
+#include <cutil/RefCountPtr.h>
+
+#include <vector>
+
+namespace cutil
+{
+	namespace unit_tests
+	{
+		class PluginManagerTest : public cutil::AbstractUnitTest
+		{
+			public:
+				PluginManagerTest() ;
+				virtual std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > getTestCases() ;
+
+				void registryFindsPlugins() ;
+				void registryScales() ;
+				void handleAssignmentCounts() ;
+				void concurrentHandlesAreCounted() ;
+				void resolverCachesPlugin() ;
+				void resolverInvalidatedOnUnload() ;
+				void concurrentResolveAndRelease() ;
+				void resolverInvalidatedOnReload() ;
+				void idleTimeoutEvicts() ;
+				void releaseEvictsExpired() ;
+				void budgetEvictsLeastRecentlyUsed() ;
+				void evictionSkipsReferencedPlugins() ;
+				void prewarmLoadsInBackground() ;
+				void parallelRegistrationIsDeterministic() ;
+				void directoryRegistration() ;
+				void reloadRetiresAndDrains() ;
+				void reloadWithdrawsPlugins() ;
+				void failedReloadKeepsVersion() ;
+				void reloadedModuleReopensReplacement() ;
+				void reloadUnderResolversDrains() ;
+				void acquireWhileRegistryChanges() ;
+		} ;
+	}
+}
+
+#endif /* _CUTIL_UNITTESTS_PLUGINMANAGERTEST_H_ */
@@ -0,0 +1,392 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "PluginManifestTest.h"
+#include "TestPlugin.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/FilePath.h>
+#include <cutil/FileTree.h>
+#include <cutil/PluginInfo.h>
+#include <cutil/PluginManager.h>
+#include <cutil/PluginManifest.h>
+#include <cutil/RefCountPtr.h>
+#include <cutil/ThreadPool.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+using cutil::FilePath ;
+using cutil::PluginInfo ;
+using cutil::PluginManifest ;
+
+namespace
+{
+	/**
+	 * Copies the testplugin fixture, the copy being a distinct module to the dynamic linker
+	 */
+	std::string copyModule(const TempDirectory& dir, const std::string& name)
+	{
+		std::string path = dir.getPath(name) ;
+		cutil::FileTree::copyFile(FilePath(TEST_PLUGIN_MODULE), FilePath(path)) ;
+		return(path) ;
+	}
+
+	/**
+	 * Returns Plugin descriptions exercising the manifest field encoding
+	 */
+	std::list<PluginInfo> makePlugins()
+	{
+		std::list<PluginInfo> plugins ;
+		plugins.push_back(PluginInfo("first", "TestPlugin", "a description with spaces")) ;
+		plugins.push_back(PluginInfo("second", "", "line one\nline two 12:colon")) ;
+		plugins.push_back(PluginInfo("M 3:odd P", "TestPlugin", "")) ;
+		return(plugins) ;
+	}
+
+	void assertPlugins(const std::list<PluginInfo>& expected, const std::list<PluginInfo>& actual)
+	{
+		cutil::Assert::areEqual(expected.size(), actual.size()) ;
+		std::list<PluginInfo>::const_iterator eiter = expected.begin() ;
+		for(std::list<PluginInfo>::const_iterator aiter = actual.begin() ; aiter != actual.end() ; ++aiter, ++eiter)
+		{
+			cutil::Assert::areEqual(eiter->getName(), aiter->getName()) ;
+			cutil::Assert::areEqual(eiter->getType(), aiter->getType()) ;
+			cutil::Assert::areEqual(eiter->getDescription(), aiter->getDescription()) ;
+		}
+	}
+
+	std::string readFile(const std::string& path)
+	{
+		std::ifstream in(path.c_str()) ;
+		return(std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>())) ;
+	}
+
+	void writeFile(const std::string& path, const std::string& data)
+	{
+		std::ofstream out(path.c_str(), std::ios::trunc) ;
+		out << data ;
+	}
+
+	/**
+	 * Returns whether the specified file is mapped into this process
+	 */
+	bool isMapped(const std::string& path)
+	{
+		return(readFile("/proc/self/maps").find(path) != std::string::npos) ;
+	}
+}
+
+PluginManifestTest::PluginManifestTest() : cutil::AbstractUnitTest("PluginManifest Test", "cutil")
+{
+}
+
+void
+PluginManifestTest::lookupHitAndMiss()
+{
+	TempDirectory dir("PluginManifestTest") ;
+	std::string module = copyModule(dir, "a.so") ;
+
+	PluginManifest manifest ;
+	std::list<PluginInfo> plugins ;
+	cutil::Assert::isFalse(manifest.lookup(module, plugins)) ;
+	cutil::Assert::isFalse(manifest.isModified()) ;
+
+	manifest.update(module, makePlugins()) ;
+	cutil::Assert::isTrue(manifest.isModified()) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), manifest.getModuleCount()) ;
+
+	cutil::Assert::isTrue(manifest.lookup(module, plugins)) ;
+	assertPlugins(makePlugins(), plugins) ;
+
+	plugins.clear() ;
+	cutil::Assert::isFalse(manifest.lookup(dir.getPath("b.so"), plugins)) ;
+	cutil::Assert::isTrue(plugins.empty()) ;
+}
+
+void
+PluginManifestTest::staleEntriesMiss()
+{
+	TempDirectory dir("PluginManifestTest") ;
+	std::string touched = copyModule(dir, "touched.so") ;
+	std::string grown = copyModule(dir, "grown.so") ;
+	std::string replaced = copyModule(dir, "replaced.so") ;
+	std::string removed = copyModule(dir, "removed.so") ;
+
+	PluginManifest manifest ;
+	manifest.update(touched, makePlugins()) ;
+	manifest.update(grown, makePlugins()) ;
+	manifest.update(replaced, makePlugins()) ;
+	manifest.update(removed, makePlugins()) ;
+
+	// modification time
+	struct timespec times[2] ;
+	times[0].tv_sec = 1000000000 ;
+	times[0].tv_nsec = 0 ;
+	times[1] = times[0] ;
+	cutil::Assert::areEqual(0, ::utimensat(AT_FDCWD, touched.c_str(), times, 0)) ;
+
+	// size, keeping the modification time
+	struct stat sb ;
+	::stat(grown.c_str(), &sb) ;
+	{
+		std::ofstream out(grown.c_str(), std::ios::app) ;
+		out << '\0' ;
+	}
+	times[0] = sb.st_atim ;
+	times[1] = sb.st_mtim ;
+	cutil::Assert::areEqual(0, ::utimensat(AT_FDCWD, grown.c_str(), times, 0)) ;
+
+	// inode, the replacement keeping size and modification time
+	::stat(replaced.c_str(), &sb) ;
+	std::string replacement = copyModule(dir, "replacement") ;
+	times[0] = sb.st_atim ;
+	times[1] = sb.st_mtim ;
+	cutil::Assert::areEqual(0, ::utimensat(AT_FDCWD, replacement.c_str(), times, 0)) ;
+	cutil::Assert::areEqual(0, ::rename(replacement.c_str(), replaced.c_str())) ;
+
+	::unlink(removed.c_str()) ;
+
+	std::list<PluginInfo> plugins ;
+	cutil::Assert::isFalse(manifest.lookup(touched, plugins), "modification time") ;
+	cutil::Assert::isFalse(manifest.lookup(grown, plugins), "size") ;
+	cutil::Assert::isFalse(manifest.lookup(replaced, plugins), "inode") ;
+	cutil::Assert::isFalse(manifest.lookup(removed, plugins), "removed") ;
+	cutil::Assert::isTrue(plugins.empty()) ;
+
+	// updating a missing module withdraws its entry
+	manifest.update(removed, makePlugins()) ;
+	cutil::Assert::areEqual(static_cast<size_t>(3), manifest.getModuleCount()) ;
+
+	manifest.update(touched, makePlugins()) ;
+	cutil::Assert::isTrue(manifest.lookup(touched, plugins)) ;
+}
+
+void
+PluginManifestTest::saveLoadRoundTrip()
+{
+	TempDirectory dir("PluginManifestTest") ;
+	std::string first = copyModule(dir, "first.so") ;
+	std::string second = copyModule(dir, "second module.so") ;
+	std::string path = dir.getPath("manifest") ;
+
+	{
+		PluginManifest manifest ;
+		manifest.update(first, makePlugins()) ;
+		manifest.update(second, std::list<PluginInfo>()) ;
+		manifest.save(FilePath(path)) ;
+		cutil::Assert::isFalse(manifest.isModified()) ;
+	}
+
+	// saved manifests are replaced whole
+	std::string saved = readFile(path) ;
+	{
+		PluginManifest manifest ;
+		cutil::Assert::isTrue(manifest.load(FilePath(path))) ;
+		manifest.save(FilePath(path)) ;
+	}
+	cutil::Assert::areEqual(saved, readFile(path)) ;
+
+	PluginManifest manifest ;
+	cutil::Assert::isTrue(manifest.load(FilePath(path))) ;
+	cutil::Assert::isFalse(manifest.isModified()) ;
+	cutil::Assert::areEqual(static_cast<size_t>(2), manifest.getModuleCount()) ;
+
+	std::list<PluginInfo> plugins ;
+	cutil::Assert::isTrue(manifest.lookup(first, plugins)) ;
+	assertPlugins(makePlugins(), plugins) ;
+
+	plugins.clear() ;
+	cutil::Assert::isTrue(manifest.lookup(second, plugins)) ;
+	cutil::Assert::isTrue(plugins.empty()) ;
+}
+
+void
+PluginManifestTest::missingFileLoadsEmpty()
+{
+	TempDirectory dir("PluginManifestTest") ;
+	std::string module = copyModule(dir, "a.so") ;
+
+	PluginManifest manifest ;
+	manifest.update(module, makePlugins()) ;
+
+	cutil::Assert::isFalse(manifest.load(FilePath(dir.getPath("missing")))) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), manifest.getModuleCount()) ;
+	cutil::Assert::isFalse(manifest.isModified()) ;
+}
+
+void
+PluginManifestTest::corruptFileIsDiscarded()
+{
+	TempDirectory dir("PluginManifestTest") ;
+	std::string module = copyModule(dir, "a.so") ;
+	std::string path = dir.getPath("manifest") ;
+
+	{
+		PluginManifest manifest ;
+		manifest.update(module, makePlugins()) ;
+		manifest.save(FilePath(path)) ;
+	}
+	std::string saved = readFile(path) ;
+
+	std::vector<std::string> damaged ;
+	damaged.push_back("") ;
+	damaged.push_back("not a manifest\n") ;
+	damaged.push_back(saved.substr(0, saved.size() / 2)) ;
+	damaged.push_back(saved.substr(0, saved.size() - 1)) ;
+	damaged.push_back(std::string(saved).append("M garbage\n")) ;
+
+	std::string lengths(saved) ;
+	std::string::size_type plugin = lengths.rfind("\nP ") ;
+	lengths.insert(plugin + 3, "9") ;
+	damaged.push_back(lengths) ;
+
+	for(std::vector<std::string>::const_iterator citer = damaged.begin() ; citer != damaged.end() ; ++citer)
+	{
+		writeFile(path, *citer) ;
+
+		PluginManifest manifest ;
+		manifest.update(module, makePlugins()) ;
+		cutil::Assert::isFalse(manifest.load(FilePath(path)), *citer) ;
+		cutil::Assert::areEqual(static_cast<size_t>(0), manifest.getModuleCount(), *citer) ;
+
+		std::list<PluginInfo> plugins ;
+		cutil::Assert::isFalse(manifest.lookup(module, plugins), *citer) ;
+	}
+}
+
+void
+PluginManifestTest::unqualifiedModulesNotCached()
+{
+	PluginManifest manifest ;
+	manifest.update("libtestplugin.so", makePlugins()) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), manifest.getModuleCount()) ;
+	cutil::Assert::isFalse(manifest.isModified()) ;
+
+	std::list<PluginInfo> plugins ;
+	cutil::Assert::isFalse(manifest.lookup("libtestplugin.so", plugins)) ;
+}
+
+void
+PluginManifestTest::removeAndClear()
+{
+	TempDirectory dir("PluginManifestTest") ;
+	std::string first = copyModule(dir, "first.so") ;
+	std::string second = copyModule(dir, "second.so") ;
+	std::string path = dir.getPath("manifest") ;
+
+	PluginManifest manifest ;
+	manifest.update(first, makePlugins()) ;
+	manifest.update(second, makePlugins()) ;
+	manifest.save(FilePath(path)) ;
+
+	cutil::Assert::isFalse(manifest.remove(dir.getPath("third.so"))) ;
+	cutil::Assert::isFalse(manifest.isModified()) ;
+
+	cutil::Assert::isTrue(manifest.remove(first)) ;
+	cutil::Assert::isTrue(manifest.isModified()) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), manifest.getModuleCount()) ;
+
+	std::list<PluginInfo> plugins ;
+	cutil::Assert::isFalse(manifest.lookup(first, plugins)) ;
+	cutil::Assert::isTrue(manifest.lookup(second, plugins)) ;
+
+	manifest.load(FilePath(path)) ;
+	manifest.clear() ;
+	cutil::Assert::isTrue(manifest.isModified()) ;
+	cutil::Assert::areEqual(static_cast<size_t>(0), manifest.getModuleCount()) ;
+}
+
+void
+PluginManifestTest::registrationUsesManifest()
+{
+	TempDirectory dir("PluginManifestTest") ;
+	std::vector<std::string> modules ;
+	modules.push_back(copyModule(dir, "a.so")) ;
+	modules.push_back(copyModule(dir, "b.so")) ;
+	std::string path = dir.getPath("manifest") ;
+
+	cutil::ThreadPool pool(2) ;
+	{
+		PluginManifest manifest ;
+		cutil::PluginManager manager ;
+		manager.setManifest(&manifest) ;
+		manager.registerPlugins(modules, pool) ;
+
+		cutil::Assert::areEqual(static_cast<size_t>(2), manifest.getModuleCount()) ;
+		manifest.save(FilePath(path)) ;
+		manager.setManifest(0) ;
+	}
+	cutil::Assert::isFalse(isMapped(modules[1]), "closed with its PluginManager") ;
+
+	PluginManifest manifest ;
+	cutil::Assert::isTrue(manifest.load(FilePath(path))) ;
+
+	cutil::PluginManager manager ;
+	manager.setManifest(&manifest) ;
+	manager.registerPlugins(modules, pool) ;
+
+	// registered from the manifest without opening the SharedLibraries
+	cutil::Assert::isTrue(manager.isRegistered(modules[1], "plugin15")) ;
+	cutil::Assert::isFalse(manager.isLoaded(modules[1], "plugin15")) ;
+	cutil::Assert::isFalse(isMapped(modules[0])) ;
+	cutil::Assert::isFalse(isMapped(modules[1])) ;
+	cutil::Assert::isFalse(manifest.isModified()) ;
+
+	// opened when first loaded
+	manager.loadPlugin(modules[1], "plugin15") ;
+	cutil::Assert::isTrue(isMapped(modules[1])) ;
+	cutil::Assert::areEqual(15, manager.getPluginHandle<TestPlugin>(modules[1], "plugin15")->getValue()) ;
+	manager.setManifest(0) ;
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+PluginManifestTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<PluginManifestTest>(this, &PluginManifestTest::lookupHitAndMiss, "lookupHitAndMiss", "", ""));
+	test_cases.push_back(makeTestCase<PluginManifestTest>(this, &PluginManifestTest::staleEntriesMiss, "staleEntriesMiss", "", ""));
+	test_cases.push_back(makeTestCase<PluginManifestTest>(this, &PluginManifestTest::saveLoadRoundTrip, "saveLoadRoundTrip", "", ""));
+	test_cases.push_back(makeTestCase<PluginManifestTest>(this, &PluginManifestTest::missingFileLoadsEmpty, "missingFileLoadsEmpty", "", ""));
+	test_cases.push_back(makeTestCase<PluginManifestTest>(this, &PluginManifestTest::corruptFileIsDiscarded, "corruptFileIsDiscarded", "", ""));
+	test_cases.push_back(makeTestCase<PluginManifestTest>(this, &PluginManifestTest::unqualifiedModulesNotCached, "unqualifiedModulesNotCached", "", ""));
+	test_cases.push_back(makeTestCase<PluginManifestTest>(this, &PluginManifestTest::removeAndClear, "removeAndClear", "", ""));
+	test_cases.push_back(makeTestCase<PluginManifestTest>(this, &PluginManifestTest::registrationUsesManifest, "registrationUsesManifest", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "PluginStatisticsTest.h"
+#include "TestPlugin.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/PluginManager.h>
+#include <cutil/PluginStatistics.h>
+#include <cutil/RefCountPtr.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace cutil::unit_tests ;
+
+namespace
+{
+	unsigned long sum(const std::vector<unsigned long>& histogram)
+	{
+		unsigned long total = 0 ;
+		for(size_t i = 0 ; i < histogram.size() ; ++i)
+		{
+			total += histogram[i] ;
+		}
+
+		return(total) ;
+	}
+}
+
+PluginStatisticsTest::PluginStatisticsTest() : cutil::AbstractUnitTest("PluginStatistics Test", "cutil")
+{
+}
+
+void
+PluginStatisticsTest::bucketsDoubleInWidth()
+{
+	cutil::Assert::areEqual(static_cast<size_t>(0), cutil::PluginStatistics::getBucket(0)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(1), cutil::PluginStatistics::getBucket(1)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(10), cutil::PluginStatistics::getBucket(1023)) ;
+	cutil::Assert::areEqual(static_cast<size_t>(11), cutil::PluginStatistics::getBucket(1024)) ;
+	cutil::Assert::areEqual(1024ULL, cutil::PluginStatistics::getBucketLimit(10)) ;
+
+	// the final bucket counts every longer call
+	size_t last = cutil::PluginStatistics::BUCKET_COUNT - 1 ;
+	cutil::Assert::areEqual(last, cutil::PluginStatistics::getBucket(~0ULL)) ;
+}
+
+void
+PluginStatisticsTest::loadIsTimed()
+{
+	cutil::PluginManager manager ;
+	manager.setInstrumented(true) ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin1") ;
+
+	cutil::PluginStatistics stats ;
+	cutil::Assert::isTrue(manager.getStatistics(TEST_PLUGIN_MODULE, "plugin1", stats)) ;
+	cutil::Assert::isTrue(stats.isLoaded()) ;
+	cutil::Assert::areEqual(1UL, stats.getLoadCount()) ;
+	cutil::Assert::isTrue(stats.getOpenTime() > 0) ;
+
+	// the SharedLibrary is already open for the second Plugin
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin2") ;
+	cutil::Assert::isTrue(manager.getStatistics(TEST_PLUGIN_MODULE, "plugin2", stats)) ;
+	cutil::Assert::areEqual(0ULL, stats.getOpenTime()) ;
+}
+
+void
+PluginStatisticsTest::handlesAreCounted()
+{
+	cutil::PluginManager manager ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin1") ;
+
+	cutil::PluginHandle<TestPlugin> first = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin1") ;
+	cutil::PluginHandle<TestPlugin> second = first ;
+
+	cutil::PluginStatistics stats ;
+	manager.getStatistics(TEST_PLUGIN_MODULE, "plugin1", stats) ;
+	cutil::Assert::areEqual(2, stats.getHandleCount()) ;
+
+	second.clear() ;
+	manager.getStatistics(TEST_PLUGIN_MODULE, "plugin1", stats) ;
+	cutil::Assert::areEqual(1, stats.getHandleCount()) ;
+}
+
+void
+PluginStatisticsTest::callsAreRecorded()
+{
+	cutil::PluginManager manager ;
+	manager.setInstrumented(true) ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin3") ;
+
+	cutil::PluginHandle<TestPlugin> handle = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin3") ;
+	for(int i = 0 ; i < 10 ; ++i)
+	{
+		cutil::Assert::areEqual(3, handle->getValue()) ;
+	}
+
+	std::list<cutil::PluginStatistics> statistics ;
+	manager.getStatistics(statistics) ;
+
+	const cutil::PluginStatistics* stats = 0 ;
+	for(std::list<cutil::PluginStatistics>::const_iterator citer = statistics.begin(); citer != statistics.end(); ++citer)
+	{
+		if(citer->getName() == "plugin3")
+		{
+			stats = &(*citer) ;
+		}
+	}
+
+	cutil::Assert::isTrue(stats != 0) ;
+	cutil::Assert::areEqual(10UL, stats->getCallCount()) ;
+	cutil::Assert::areEqual(10UL, sum(stats->getCallHistogram())) ;
+	cutil::Assert::isTrue(stats->getCallPercentile(99) >= stats->getCallPercentile(50)) ;
+	cutil::Assert::isTrue(stats->getCallPercentile(50) > 0) ;
+}
+
+void
+PluginStatisticsTest::uninstrumentedCallsAreNotRecorded()
+{
+	cutil::PluginManager manager ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin3") ;
+
+	cutil::PluginHandle<TestPlugin> handle = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin3") ;
+	cutil::Assert::areEqual(3, handle->getValue()) ;
+
+	cutil::PluginStatistics stats ;
+	manager.getStatistics(TEST_PLUGIN_MODULE, "plugin3", stats) ;
+	cutil::Assert::areEqual(0UL, stats.getLoadCount()) ;
+	cutil::Assert::areEqual(0UL, stats.getCallCount()) ;
+	cutil::Assert::areEqual(0ULL, stats.getCallPercentile(50)) ;
+}
+
+void
+PluginStatisticsTest::resetClearsStatistics()
+{
+	cutil::PluginManager manager ;
+	manager.setInstrumented(true) ;
+	manager.loadPlugin(TEST_PLUGIN_MODULE, "plugin3") ;
+
+	cutil::PluginHandle<TestPlugin> handle = manager.getPluginHandle<TestPlugin>(TEST_PLUGIN_MODULE, "plugin3") ;
+	handle->getValue() ;
+	manager.resetStatistics() ;
+
+	cutil::PluginStatistics stats ;
+	manager.getStatistics(TEST_PLUGIN_MODULE, "plugin3", stats) ;
+	cutil::Assert::areEqual(0UL, stats.getLoadCount()) ;
+	cutil::Assert::areEqual(0UL, stats.getCallCount()) ;
+	cutil::Assert::areEqual(0UL, sum(stats.getCallHistogram())) ;
+	cutil::Assert::areEqual(1, stats.getHandleCount()) ;
+}
+
+void
+PluginStatisticsTest::unregisteredPluginHasNoStatistics()
+{
+	cutil::PluginManager manager ;
+
+	cutil::PluginStatistics stats ;
+	cutil::Assert::isFalse(manager.getStatistics(TEST_PLUGIN_MODULE, "plugin1", stats)) ;
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+PluginStatisticsTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<PluginStatisticsTest>(this, &PluginStatisticsTest::bucketsDoubleInWidth, "bucketsDoubleInWidth", "", ""));
+	test_cases.push_back(makeTestCase<PluginStatisticsTest>(this, &PluginStatisticsTest::loadIsTimed, "loadIsTimed", "", ""));
+	test_cases.push_back(makeTestCase<PluginStatisticsTest>(this, &PluginStatisticsTest::handlesAreCounted, "handlesAreCounted", "", ""));
+	test_cases.push_back(makeTestCase<PluginStatisticsTest>(this, &PluginStatisticsTest::callsAreRecorded, "callsAreRecorded", "", ""));
+	test_cases.push_back(makeTestCase<PluginStatisticsTest>(this, &PluginStatisticsTest::uninstrumentedCallsAreNotRecorded, "uninstrumentedCallsAreNotRecorded", "", ""));
+	test_cases.push_back(makeTestCase<PluginStatisticsTest>(this, &PluginStatisticsTest::resetClearsStatistics, "resetClearsStatistics", "", ""));
+	test_cases.push_back(makeTestCase<PluginStatisticsTest>(this, &PluginStatisticsTest::unregisteredPluginHasNoStatistics, "unregisteredPluginHasNoStatistics", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "SharedLibraryTest.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/RefCountPtr.h>
+#include <cutil/SharedLibrary.h>
+#include <cutil/SharedLibraryException.h>
+
+#include <string>
+
+#include <dlfcn.h>
+
+using namespace cutil::unit_tests ;
+
+/*
+ * The test cases run in order. Both a default lookup that resolves to the module and
+ * the no delete flag pin the module for the life of the process, so those test cases
+ * run last.
+ */
+
+namespace
+{
+	typedef int (*CounterFunc)() ;
+
+	int increment(cutil::SharedLibrary& library)
+	{
+		return(((CounterFunc)library.getSymbol("testModuleIncrement"))()) ;
+	}
+
+	int counter(cutil::SharedLibrary& library)
+	{
+		return(((CounterFunc)library.getSymbol("testModuleCounter"))()) ;
+	}
+}
+
+SharedLibraryTest::SharedLibraryTest() : cutil::AbstractUnitTest("SharedLibrary Test", "cutil")
+{
+}
+
+void
+SharedLibraryTest::localSymbolsAreNotGlobal()
+{
+	cutil::SharedLibrary library(TEST_MODULE) ;
+	library.setGlobalSymbol(false) ;
+	library.open() ;
+
+	cutil::Assert::isNull(::dlsym(RTLD_DEFAULT, "testModuleCounter")) ;
+}
+
+void
+SharedLibraryTest::globalSymbolsAreGlobal()
+{
+	cutil::SharedLibrary library(TEST_MODULE) ;
+	library.setGlobalSymbol(true) ;
+	library.open() ;
+
+	cutil::Assert::isNotNull(::dlsym(RTLD_DEFAULT, "testModuleCounter")) ;
+}
+
+void
+SharedLibraryTest::closedModuleIsUnmapped()
+{
+	cutil::SharedLibrary library(TEST_MODULE) ;
+	library.open() ;
+	cutil::Assert::areEqual(1, increment(library)) ;
+
+	// reopening maps the module afresh
+	library.close() ;
+	library.open() ;
+	cutil::Assert::areEqual(0, counter(library)) ;
+}
+
+void
+SharedLibraryTest::isolatedCopiesHaveSeparateState()
+{
+	cutil::SharedLibrary first(TEST_MODULE) ;
+	first.setIsolated(true) ;
+	first.open() ;
+
+	cutil::SharedLibrary second(TEST_MODULE) ;
+	second.setIsolated(true) ;
+	second.open() ;
+
+	increment(first) ;
+	increment(first) ;
+	cutil::Assert::areEqual(2, counter(first)) ;
+	cutil::Assert::areEqual(0, counter(second)) ;
+	cutil::Assert::areEqual(1, increment(second)) ;
+}
+
+void
+SharedLibraryTest::isolatedNamespaceIsNotBase()
+{
+	cutil::SharedLibrary base(TEST_MODULE) ;
+	base.open() ;
+
+	cutil::SharedLibrary isolated(TEST_MODULE) ;
+	isolated.setIsolated(true) ;
+	isolated.open() ;
+
+	cutil::Assert::areEqual(0L, base.getNamespace()) ;
+	cutil::Assert::areNotEqual(0L, isolated.getNamespace()) ;
+}
+
+void
+SharedLibraryTest::modesCannotChangeWhenOpen()
+{
+	cutil::SharedLibrary library(TEST_MODULE) ;
+	library.open() ;
+	library.setIsolated(true) ;
+}
+
+void
+SharedLibraryTest::prefaultedModuleIsUsable()
+{
+	cutil::SharedLibrary library(TEST_MODULE) ;
+	library.setPrefault(true) ;
+	library.open() ;
+
+	cutil::Assert::isTrue(library.getMappedSize() > 0) ;
+	cutil::Assert::areEqual(1, increment(library)) ;
+}
+
+void
+SharedLibraryTest::noDeleteModuleRemainsMapped()
+{
+	cutil::SharedLibrary library(TEST_MODULE) ;
+	library.setNoDelete(true) ;
+	library.open() ;
+	cutil::Assert::areEqual(1, increment(library)) ;
+
+	// the module, and its state, survive the close
+	library.close() ;
+	library.setNoDelete(false) ;
+	library.open() ;
+	cutil::Assert::areEqual(1, counter(library)) ;
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+SharedLibraryTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<SharedLibraryTest>(this, &SharedLibraryTest::closedModuleIsUnmapped, "closedModuleIsUnmapped", "", ""));
+	test_cases.push_back(makeTestCase<SharedLibraryTest>(this, &SharedLibraryTest::isolatedCopiesHaveSeparateState, "isolatedCopiesHaveSeparateState", "", ""));
+	test_cases.push_back(makeTestCase<SharedLibraryTest>(this, &SharedLibraryTest::isolatedNamespaceIsNotBase, "isolatedNamespaceIsNotBase", "", ""));
+	test_cases.push_back(makeExpectedExceptionTestCase<SharedLibraryTest, cutil::SharedLibraryException>(this, &SharedLibraryTest::modesCannotChangeWhenOpen, "modesCannotChangeWhenOpen", "", ""));
+	test_cases.push_back(makeTestCase<SharedLibraryTest>(this, &SharedLibraryTest::prefaultedModuleIsUsable, "prefaultedModuleIsUsable", "", ""));
+	test_cases.push_back(makeTestCase<SharedLibraryTest>(this, &SharedLibraryTest::localSymbolsAreNotGlobal, "localSymbolsAreNotGlobal", "", ""));
+	test_cases.push_back(makeTestCase<SharedLibraryTest>(this, &SharedLibraryTest::globalSymbolsAreGlobal, "globalSymbolsAreGlobal", "", ""));
+	test_cases.push_back(makeTestCase<SharedLibraryTest>(this, &SharedLibraryTest::noDeleteModuleRemainsMapped, "noDeleteModuleRemainsMapped", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "SnapshotStateHandlerTest.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/MemoryStateHandler.h>
+#include <cutil/RefCountPtr.h>
+#include <cutil/SnapshotStateHandler.h>
+#include <cutil/StateNode.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+namespace
+{
+	std::string join(const std::list<std::string>& names)
+	{
+		std::string joined ;
+		for(std::list<std::string>::const_iterator citer = names.begin(); citer != names.end(); ++citer)
+		{
+			joined.append(joined.empty() ? "" : ",").append(*citer) ;
+		}
+
+		return(joined) ;
+	}
+
+	/**
+	 * Returns the inode of the specified file
+	 */
+	ino_t getInode(const std::string& path)
+	{
+		struct stat st ;
+		::stat(path.c_str(), &st) ;
+		return(st.st_ino) ;
+	}
+
+	/**
+	 * Writes a snapshot of a small state tree to the specified file
+	 */
+	void writeState(const std::string& path)
+	{
+		cutil::MemoryStateHandler source ;
+		cutil::RefCountPtr<cutil::StateNode> root = source.getRootNode() ;
+
+		root->setString("name", "source") ;
+		root->setInt("count", 42) ;
+		root->setDouble("ratio", 0.25) ;
+		root->setBool("enabled", true) ;
+		root->getChild("window")->setInt("width", 640) ;
+		root->getChild("window/frame")->setString("title", "main") ;
+		root->getChild("audio")->setBool("muted", false) ;
+
+		cutil::SnapshotStateHandler::writeSnapshot(source, path) ;
+	}
+}
+
+SnapshotStateHandlerTest::SnapshotStateHandlerTest() : cutil::AbstractUnitTest("SnapshotStateHandler Test", "cutil")
+{
+}
+
+void
+SnapshotStateHandlerTest::valuesAreReadFromMapping()
+{
+	TempDirectory dir("SnapshotStateHandlerTest") ;
+	std::string path = dir.getPath("state.snap") ;
+	writeState(path) ;
+
+	cutil::SnapshotStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+	cutil::Assert::isTrue(handler.isMapped()) ;
+	cutil::Assert::areEqual(std::string("source"), root->getString("name", "")) ;
+	cutil::Assert::areEqual(42, root->getInt("count", 0)) ;
+	cutil::Assert::areEqual(0.25, root->getDouble("ratio", 0.0)) ;
+	cutil::Assert::isTrue(root->getBool("enabled", false)) ;
+
+	// values are stored parsed as XMLStateNode parses them
+	cutil::Assert::areEqual(std::string("42"), root->getString("count", "")) ;
+	cutil::Assert::isFalse(root->getBool("count", true)) ;
+
+	cutil::Assert::areEqual(7, root->getInt("missing", 7)) ;
+	cutil::Assert::areEqual(std::string("def"), root->getString("missing", "def")) ;
+
+	// reading does not copy the state tree
+	cutil::Assert::isTrue(handler.isMapped()) ;
+	cutil::Assert::isFalse(handler.isDirty()) ;
+}
+
+void
+SnapshotStateHandlerTest::childPathsAreFound()
+{
+	TempDirectory dir("SnapshotStateHandlerTest") ;
+	std::string path = dir.getPath("state.snap") ;
+	writeState(path) ;
+
+	cutil::SnapshotStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+	cutil::Assert::isTrue(root->hasChild("window")) ;
+	cutil::Assert::isTrue(root->hasChild("window/frame")) ;
+	cutil::Assert::isFalse(root->hasChild("video")) ;
+
+	cutil::RefCountPtr<cutil::StateNode> frame = root->getChild("window/frame") ;
+	cutil::Assert::areEqual(std::string("/window/frame"), frame->getPath()) ;
+	cutil::Assert::areEqual(std::string("main"), frame->getString("title", "")) ;
+
+	cutil::RefCountPtr<cutil::StateNode> window = frame->getParent() ;
+	cutil::Assert::areEqual(std::string("/window"), window->getPath()) ;
+	cutil::Assert::areEqual(640, window->getInt("width", 0)) ;
+	cutil::Assert::areEqual(std::string("/"), window->getParent()->getPath()) ;
+	cutil::Assert::isFalse(root->getParent().hasPtr()) ;
+
+	cutil::Assert::isTrue(handler.isMapped()) ;
+}
+
+void
+SnapshotStateHandlerTest::namesAreOrdered()
+{
+	TempDirectory dir("SnapshotStateHandlerTest") ;
+	std::string path = dir.getPath("state.snap") ;
+	writeState(path) ;
+
+	cutil::SnapshotStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+	std::list<std::string> children ;
+	cutil::Assert::areEqual(2, root->getChildren(children)) ;
+	cutil::Assert::areEqual(std::string("audio,window"), join(children)) ;
+
+	std::list<std::string> names ;
+	cutil::Assert::areEqual(4, root->getValueNames(names)) ;
+	cutil::Assert::areEqual(std::string("count,enabled,name,ratio"), join(names)) ;
+}
+
+void
+SnapshotStateHandlerTest::modificationIsWrittenOnFlush()
+{
+	TempDirectory dir("SnapshotStateHandlerTest") ;
+	std::string path = dir.getPath("state.snap") ;
+	writeState(path) ;
+
+	{
+		cutil::SnapshotStateHandler handler(path) ;
+		handler.initialize() ;
+		cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+		cutil::RefCountPtr<cutil::StateNode> window = root->getChild("window") ;
+
+		window->setInt("height", 480) ;
+		root->getChild("video")->setString("mode", "full") ;
+
+		// the state tree is copied, existing handles read the copy
+		cutil::Assert::isFalse(handler.isMapped()) ;
+		cutil::Assert::isTrue(handler.isDirty()) ;
+		cutil::Assert::areEqual(640, window->getInt("width", 0)) ;
+		cutil::Assert::areEqual(480, window->getInt("height", 0)) ;
+		cutil::Assert::areEqual(std::string("source"), root->getString("name", "")) ;
+
+		handler.flush() ;
+		cutil::Assert::isFalse(handler.isDirty()) ;
+	}
+
+	cutil::SnapshotStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+	cutil::Assert::isTrue(handler.isMapped()) ;
+	cutil::Assert::areEqual(480, root->getChild("window")->getInt("height", 0)) ;
+	cutil::Assert::areEqual(std::string("full"), root->getChild("video")->getString("mode", "")) ;
+	cutil::Assert::areEqual(std::string("main"), root->getChild("window/frame")->getString("title", "")) ;
+}
+
+void
+SnapshotStateHandlerTest::unmodifiedStateIsNotWritten()
+{
+	TempDirectory dir("SnapshotStateHandlerTest") ;
+	std::string path = dir.getPath("state.snap") ;
+	writeState(path) ;
+	ino_t written = getInode(path) ;
+
+	cutil::SnapshotStateHandler handler(path) ;
+	handler.initialize() ;
+	handler.getRootNode()->getChild("window")->getInt("width", 0) ;
+
+	handler.flush() ;
+	cutil::Assert::isTrue(written == getInode(path)) ;
+
+	// a modification replaces the file
+	handler.getRootNode()->setInt("count", 43) ;
+	handler.flush() ;
+	cutil::Assert::isTrue(written != getInode(path)) ;
+}
+
+void
+SnapshotStateHandlerTest::removedChildIsWritten()
+{
+	TempDirectory dir("SnapshotStateHandlerTest") ;
+	std::string path = dir.getPath("state.snap") ;
+	writeState(path) ;
+
+	{
+		cutil::SnapshotStateHandler handler(path) ;
+		handler.initialize() ;
+		cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+		// removing what is not there is no modification
+		root->removeChild("video") ;
+		root->removeValue("missing") ;
+		cutil::Assert::isFalse(handler.isDirty()) ;
+
+		root->removeChild("window") ;
+		root->removeValue("count") ;
+		cutil::Assert::isTrue(handler.isDirty()) ;
+		cutil::Assert::isFalse(root->hasChild("window")) ;
+
+		// shutdown writes the modifications
+		handler.shutdown() ;
+	}
+
+	cutil::SnapshotStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+	cutil::Assert::isFalse(root->hasChild("window")) ;
+	cutil::Assert::isTrue(root->hasChild("audio")) ;
+	cutil::Assert::areEqual(-1, root->getInt("count", -1)) ;
+}
+
+void
+SnapshotStateHandlerTest::syncDiscardsModifications()
+{
+	TempDirectory dir("SnapshotStateHandlerTest") ;
+	std::string path = dir.getPath("state.snap") ;
+	writeState(path) ;
+
+	cutil::SnapshotStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> window = handler.getRootNode()->getChild("window") ;
+
+	window->setInt("width", 800) ;
+	cutil::Assert::areEqual(800, window->getInt("width", 0)) ;
+
+	handler.sync() ;
+	cutil::Assert::isTrue(handler.isMapped()) ;
+	cutil::Assert::isFalse(handler.isDirty()) ;
+	cutil::Assert::areEqual(640, window->getInt("width", 0)) ;
+}
+
+void
+SnapshotStateHandlerTest::invalidSnapshotIsEmpty()
+{
+	TempDirectory dir("SnapshotStateHandlerTest") ;
+	std::string path = dir.getPath("state.snap") ;
+
+	std::FILE* fp = std::fopen(path.c_str(), "w") ;
+	std::fputs("<?xml version=\"1.0\"?><state_config/>", fp) ;
+	std::fclose(fp) ;
+
+	cutil::SnapshotStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+	cutil::Assert::isFalse(handler.isMapped()) ;
+
+	std::list<std::string> children ;
+	cutil::Assert::areEqual(0, root->getChildren(children)) ;
+	cutil::Assert::areEqual(5, root->getInt("count", 5)) ;
+
+	// the empty state tree may be written as a snapshot
+	root->setInt("count", 1) ;
+	handler.flush() ;
+	handler.sync() ;
+	cutil::Assert::isTrue(handler.isMapped()) ;
+	cutil::Assert::areEqual(1, handler.getRootNode()->getInt("count", 0)) ;
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+SnapshotStateHandlerTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<SnapshotStateHandlerTest>(this, &SnapshotStateHandlerTest::valuesAreReadFromMapping, "valuesAreReadFromMapping", "", ""));
+	test_cases.push_back(makeTestCase<SnapshotStateHandlerTest>(this, &SnapshotStateHandlerTest::childPathsAreFound, "childPathsAreFound", "", ""));
+	test_cases.push_back(makeTestCase<SnapshotStateHandlerTest>(this, &SnapshotStateHandlerTest::namesAreOrdered, "namesAreOrdered", "", ""));
+	test_cases.push_back(makeTestCase<SnapshotStateHandlerTest>(this, &SnapshotStateHandlerTest::modificationIsWrittenOnFlush, "modificationIsWrittenOnFlush", "", ""));
+	test_cases.push_back(makeTestCase<SnapshotStateHandlerTest>(this, &SnapshotStateHandlerTest::unmodifiedStateIsNotWritten, "unmodifiedStateIsNotWritten", "", ""));
+	test_cases.push_back(makeTestCase<SnapshotStateHandlerTest>(this, &SnapshotStateHandlerTest::removedChildIsWritten, "removedChildIsWritten", "", ""));
+	test_cases.push_back(makeTestCase<SnapshotStateHandlerTest>(this, &SnapshotStateHandlerTest::syncDiscardsModifications, "syncDiscardsModifications", "", ""));
+	test_cases.push_back(makeTestCase<SnapshotStateHandlerTest>(this, &SnapshotStateHandlerTest::invalidSnapshotIsEmpty, "invalidSnapshotIsEmpty", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+/*
+ * Compares the cost of typed value access of an XMLStateNode with value caching
+ * disabled, locating and parsing the value within the document on every access,
+ * and enabled, modelled on a component reading its settings repeatedly.
+ * Then compares loading a large state file, and reading each of its values once,
+ * between an XMLStateHandler, an XMLStreamStateHandler and a SnapshotStateHandler.
+ *
+ * usage: StateBenchmark [iterations]
+ */
+
+#include <cutil/RefCountPtr.h>
+#include <cutil/SnapshotStateHandler.h>
+#include <cutil/StateNode.h>
+#include <cutil/XMLStateHandler.h>
+#include <cutil/XMLStreamStateHandler.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <string>
+#include <vector>
+
+#include <time.h>
+#include <unistd.h>
+
+namespace
+{
+	/** prevents the optimiser discarding benchmark results */
+	volatile double sink = 0 ;
+
+	double now()
+	{
+		struct timespec ts ;
+		::clock_gettime(CLOCK_MONOTONIC, &ts) ;
+		return(ts.tv_sec + ts.tv_nsec / 1e9) ;
+	}
+
+	void report(const char* name, double uncached_secs, double cached_secs, size_t operations)
+	{
+		std::printf("%-18s uncached %8.1f ns/op   cached %8.1f ns/op   %6.2fx\n",
+			name,
+			uncached_secs * 1e9 / operations,
+			cached_secs * 1e9 / operations,
+			uncached_secs / cached_secs) ;
+	}
+
+	/**
+	 * Reads every value of the node in each type, returning the elapsed time
+	 */
+	double readValues(cutil::RefCountPtr<cutil::StateNode> node, const std::vector<std::string>& names, size_t iterations)
+	{
+		double start = now() ;
+		for(size_t i = 0 ; i < iterations ; ++i)
+		{
+			for(size_t n = 0 ; n < names.size() ; ++n)
+			{
+				sink += node->getInt(names[n], 0) ;
+				sink += node->getDouble(names[n], 0.0) ;
+				sink += node->getBool(names[n], false) ;
+			}
+		}
+		return(now() - start) ;
+	}
+
+	/**
+	 * Reads every value of every child of the root node of the handler once, returning the elapsed time
+	 */
+	double readState(cutil::StateHandler& handler)
+	{
+		double start = now() ;
+
+		cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+		std::list<std::string> children ;
+		root->getChildren(children) ;
+
+		for(std::list<std::string>::const_iterator citer = children.begin(); citer != children.end(); ++citer)
+		{
+			cutil::RefCountPtr<cutil::StateNode> child = root->getChild(*citer) ;
+
+			std::list<std::string> names ;
+			child->getValueNames(names) ;
+			for(std::list<std::string>::const_iterator niter = names.begin(); niter != names.end(); ++niter)
+			{
+				sink += child->getInt(*niter, 0) ;
+			}
+		}
+
+		return(now() - start) ;
+	}
+
+	/**
+	 * Stores every value of the node unchanged, returning the elapsed time
+	 */
+	double writeValues(cutil::RefCountPtr<cutil::StateNode> node, const std::vector<std::string>& names, size_t iterations)
+	{
+		double start = now() ;
+		for(size_t i = 0 ; i < iterations ; ++i)
+		{
+			for(size_t n = 0 ; n < names.size() ; ++n)
+			{
+				node->setInt(names[n], static_cast<int>(n)) ;
+			}
+		}
+		return(now() - start) ;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	size_t iterations = (argc > 1) ? std::strtoul(argv[1], NULL, 10) : 200 ;
+
+	char datafile[64] ;
+	std::snprintf(datafile, sizeof(datafile), "/tmp/StateBenchmark.%ld.xml", static_cast<long>(::getpid())) ;
+
+	std::vector<std::string> names ;
+	for(int i = 0 ; i < 50 ; ++i)
+	{
+		char name[32] ;
+		std::snprintf(name, sizeof(name), "setting_%02d", i) ;
+		names.push_back(name) ;
+	}
+	size_t operations = iterations * names.size() ;
+
+	cutil::XMLStateHandler handler(datafile, "") ;
+	handler.initialize() ;
+
+	cutil::RefCountPtr<cutil::StateNode> node = handler.getRootNode()->getChild("component") ;
+	for(size_t n = 0 ; n < names.size() ; ++n)
+	{
+		node->setInt(names[n], static_cast<int>(n)) ;
+	}
+
+	// typed reads, three getters per operation
+	handler.setCaching(false) ;
+	double uncached_secs = readValues(node, names, iterations) ;
+	handler.setCaching(true) ;
+	report("read int/dbl/bool", uncached_secs, readValues(node, names, iterations), operations) ;
+
+	// unchanged writes, as performed when a component saves its settings
+	handler.setCaching(false) ;
+	uncached_secs = writeValues(node, names, iterations) ;
+	handler.setCaching(true) ;
+	report("write unchanged", uncached_secs, writeValues(node, names, iterations), operations) ;
+
+	handler.shutdown() ;
+	::unlink(datafile) ;
+
+	// load a large state file, 2000 nodes of 20 values
+	char snapshotfile[64] ;
+	std::snprintf(snapshotfile, sizeof(snapshotfile), "/tmp/StateBenchmark.%ld.snap", static_cast<long>(::getpid())) ;
+	{
+		cutil::XMLStateHandler source(datafile, "") ;
+		source.initialize() ;
+
+		cutil::RefCountPtr<cutil::StateNode> root = source.getRootNode() ;
+		for(int i = 0 ; i < 2000 ; ++i)
+		{
+			char name[32] ;
+			std::snprintf(name, sizeof(name), "component_%04d", i) ;
+
+			cutil::RefCountPtr<cutil::StateNode> child = root->getChild(name) ;
+			for(int n = 0 ; n < 20 ; ++n)
+			{
+				child->setInt(names[n], i * n) ;
+			}
+		}
+
+		source.flush() ;
+		cutil::SnapshotStateHandler::writeSnapshot(source, snapshotfile) ;
+		source.shutdown() ;
+	}
+
+	double start = now() ;
+	double xml_secs ;
+	{
+		cutil::XMLStateHandler xml(datafile, "") ;
+		xml.initialize() ;
+		readState(xml) ;
+		xml_secs = now() - start ;
+	}
+
+	start = now() ;
+	double stream_secs ;
+	{
+		cutil::XMLStreamStateHandler stream(datafile, "") ;
+		stream.initialize() ;
+		readState(stream) ;
+		stream_secs = now() - start ;
+	}
+
+	start = now() ;
+	double snapshot_secs ;
+	{
+		cutil::SnapshotStateHandler snapshot(snapshotfile) ;
+		snapshot.initialize() ;
+		readState(snapshot) ;
+		snapshot_secs = now() - start ;
+	}
+
+	std::printf("%-18s xml      %8.2f ms      snapshot %8.2f ms      %6.2fx\n",
+		"load and read",
+		xml_secs * 1e3,
+		snapshot_secs * 1e3,
+		xml_secs / snapshot_secs) ;
+
+	std::printf("%-18s xml      %8.2f ms      stream   %8.2f ms      %6.2fx\n",
+		"stream load",
+		xml_secs * 1e3,
+		stream_secs * 1e3,
+		xml_secs / stream_secs) ;
+
+	::unlink(datafile) ;
+	::unlink(snapshotfile) ;
+
+	return(0) ;
+}
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "SymbolTableTest.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/RefCountPtr.h>
+#include <cutil/SharedLibrary.h>
+#include <cutil/SharedLibraryException.h>
+#include <cutil/SymbolTable.h>
+
+#include <string>
+
+#include <pthread.h>
+
+using namespace cutil::unit_tests ;
+
+namespace
+{
+	struct FixtureSymbols
+	{
+		int (*add)(int, int) ;
+		int (*count)() ;
+	} ;
+
+	struct MissingSymbols
+	{
+		int (*add)(int, int) ;
+		void (*missing)() ;
+	} ;
+
+	const char* const FIXTURE_SYMBOLS[] = { "testPluginAdd", "testPluginCount", "getPluginFactory", "releasePluginFactory" } ;
+	const size_t FIXTURE_SYMBOL_COUNT = sizeof(FIXTURE_SYMBOLS) / sizeof(FIXTURE_SYMBOLS[0]) ;
+
+	/**
+	 * Looks up the fixture symbols of a shared SharedLibrary, counting those not matching the expected addresses
+	 */
+	struct SymbolLookups
+	{
+		cutil::SharedLibrary* theLibrary ;
+		void* theExpected[FIXTURE_SYMBOL_COUNT] ;
+		int theMismatches ;
+	} ;
+
+	void* lookupSymbols(void* arg)
+	{
+		SymbolLookups* lookups = static_cast<SymbolLookups*>(arg) ;
+		for(int i = 0 ; i < 2000 ; ++i)
+		{
+			size_t index = i % FIXTURE_SYMBOL_COUNT ;
+			if(lookups->theLibrary->getSymbol(FIXTURE_SYMBOLS[index]) != lookups->theExpected[index])
+			{
+				lookups->theMismatches++ ;
+			}
+		}
+		return(NULL) ;
+	}
+}
+
+SymbolTableTest::SymbolTableTest() : cutil::AbstractUnitTest("SymbolTable Test", "cutil")
+{
+}
+
+void
+SymbolTableTest::bindsDeclaredSymbols()
+{
+	cutil::SharedLibrary library(TEST_PLUGIN_MODULE) ;
+	library.open() ;
+
+	cutil::SymbolTable<FixtureSymbols> table ;
+	table.declare("testPluginAdd", &FixtureSymbols::add).declare("testPluginCount", &FixtureSymbols::count) ;
+	cutil::Assert::areEqual(static_cast<size_t>(2), table.getSymbolCount()) ;
+
+	FixtureSymbols symbols = { 0, 0 } ;
+	table.bind(library, symbols) ;
+
+	cutil::Assert::areEqual(5, symbols.add(2, 3)) ;
+	cutil::Assert::isTrue(symbols.count() > 0) ;
+}
+
+void
+SymbolTableTest::bindOpensLibrary()
+{
+	cutil::SharedLibrary library(TEST_PLUGIN_MODULE) ;
+	cutil::Assert::isFalse(library.isOpen()) ;
+
+	cutil::SymbolTable<FixtureSymbols> table ;
+	table.declare("testPluginAdd", &FixtureSymbols::add) ;
+
+	FixtureSymbols symbols = { 0, 0 } ;
+	table.bind(library, symbols) ;
+
+	cutil::Assert::isTrue(library.isOpen()) ;
+	cutil::Assert::areEqual(7, symbols.add(3, 4)) ;
+}
+
+void
+SymbolTableTest::missingSymbolThrows()
+{
+	cutil::SharedLibrary library(TEST_PLUGIN_MODULE) ;
+
+	cutil::SymbolTable<MissingSymbols> table ;
+	table.declare("testPluginAdd", &MissingSymbols::add).declare("testPluginMissing", &MissingSymbols::missing) ;
+
+	MissingSymbols symbols = { 0, 0 } ;
+	table.bind(library, symbols) ;
+}
+
+void
+SymbolTableTest::missingSymbolLeavesTableUnchanged()
+{
+	cutil::SharedLibrary library(TEST_PLUGIN_MODULE) ;
+
+	cutil::SymbolTable<MissingSymbols> table ;
+	table.declare("testPluginAdd", &MissingSymbols::add).declare("testPluginMissing", &MissingSymbols::missing) ;
+
+	MissingSymbols symbols = { 0, 0 } ;
+	try
+	{
+		table.bind(library, symbols) ;
+		cutil::Assert::fail("bind did not throw for a missing symbol") ;
+	}
+	catch(cutil::SharedLibraryException& e)
+	{
+	}
+
+	cutil::Assert::isTrue(symbols.add == 0) ;
+	cutil::Assert::isTrue(symbols.missing == 0) ;
+}
+
+void
+SymbolTableTest::symbolLookupIsCached()
+{
+	cutil::SharedLibrary library(TEST_PLUGIN_MODULE) ;
+	library.open() ;
+
+	void* first = library.getSymbol("testPluginAdd") ;
+	void* second = library.getSymbol("testPluginAdd") ;
+	cutil::Assert::isNotNull(first) ;
+	cutil::Assert::isTrue(first == second) ;
+
+	// the cache is discarded on close, and refilled once reopened
+	library.close() ;
+	library.open() ;
+	cutil::Assert::isNotNull(library.getSymbol("testPluginAdd")) ;
+}
+
+void
+SymbolTableTest::concurrentSymbolLookups()
+{
+	// the addresses are resolved through a separate SharedLibrary, leaving the cache under test empty
+	cutil::SharedLibrary reference(TEST_PLUGIN_MODULE) ;
+	reference.open() ;
+
+	cutil::SharedLibrary library(TEST_PLUGIN_MODULE) ;
+	library.open() ;
+
+	const int THREADS = 4 ;
+	pthread_t threads[THREADS] ;
+	SymbolLookups lookups[THREADS] ;
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		lookups[i].theLibrary = &library ;
+		for(size_t j = 0 ; j < FIXTURE_SYMBOL_COUNT ; ++j)
+		{
+			lookups[i].theExpected[j] = reference.getSymbol(FIXTURE_SYMBOLS[j]) ;
+		}
+		lookups[i].theMismatches = 0 ;
+	}
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		::pthread_create(&threads[i], NULL, lookupSymbols, &lookups[i]) ;
+	}
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		::pthread_join(threads[i], NULL) ;
+	}
+
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		cutil::Assert::areEqual(0, lookups[i].theMismatches) ;
+	}
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+SymbolTableTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<SymbolTableTest>(this, &SymbolTableTest::bindsDeclaredSymbols, "bindsDeclaredSymbols", "", ""));
+	test_cases.push_back(makeTestCase<SymbolTableTest>(this, &SymbolTableTest::bindOpensLibrary, "bindOpensLibrary", "", ""));
+	test_cases.push_back(makeExpectedExceptionTestCase<SymbolTableTest, cutil::SharedLibraryException>(this, &SymbolTableTest::missingSymbolThrows, "missingSymbolThrows", "", ""));
+	test_cases.push_back(makeTestCase<SymbolTableTest>(this, &SymbolTableTest::missingSymbolLeavesTableUnchanged, "missingSymbolLeavesTableUnchanged", "", ""));
+	test_cases.push_back(makeTestCase<SymbolTableTest>(this, &SymbolTableTest::symbolLookupIsCached, "symbolLookupIsCached", "", ""));
+	test_cases.push_back(makeTestCase<SymbolTableTest>(this, &SymbolTableTest::concurrentSymbolLookups, "concurrentSymbolLookups", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
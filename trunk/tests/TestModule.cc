@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+/*
+ * testmodule fixture module, a small module of plain entry points opened directly through a
+ * SharedLibrary by the SharedLibrary tests. The module keeps a counter, so tests can tell whether
+ * two opens share one copy of the module and whether the module was unmapped in between.
+ */
+
+namespace
+{
+	int theCounter = 0 ;
+}
+
+extern "C"
+{
+	int testModuleIncrement()
+	{
+		return(++theCounter) ;
+	}
+
+	int testModuleCounter()
+	{
+		return(theCounter) ;
+	}
+}
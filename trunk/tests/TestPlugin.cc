@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+/*
+ * testplugin fixture module, loaded through a PluginManager by the Plugin tests and benchmarks.
+ * The number of available Plugins is read from CUTIL_TEST_PLUGIN_COUNT each time the
+ * PluginFactory is queried, so a single module can serve registries of differing sizes.
+ */
+
+#include "TestPlugin.h"
+
+#include <cutil/PluginFactory.h>
+#include <cutil/PluginInfo.h>
+#include <cutil/SharedLibraryException.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <string>
+
+namespace
+{
+	const int DEFAULT_PLUGIN_COUNT = 16 ;
+
+	int getTestPluginCount()
+	{
+		const char* count = std::getenv("CUTIL_TEST_PLUGIN_COUNT") ;
+		return((count && *count) ? std::atoi(count) : DEFAULT_PLUGIN_COUNT) ;
+	}
+
+	std::string getTestPluginName(int index)
+	{
+		char name[32] ;
+		std::snprintf(name, sizeof(name), "plugin%d", index) ;
+		return(std::string(name)) ;
+	}
+
+	class TestPluginImpl : public cutil::unit_tests::TestPlugin
+	{
+		public:
+			TestPluginImpl(int index)
+					: theInfo(getTestPluginName(index), "test", "testplugin fixture Plugin"), theValue(index)
+			{}
+
+			virtual const cutil::PluginInfo& getInfo() const
+			{
+				return(theInfo) ;
+			}
+
+			virtual int getValue() const
+			{
+				return(theValue) ;
+			}
+
+		private:
+			cutil::PluginInfo theInfo ;
+			int theValue ;
+	} ;
+
+	class TestPluginFactory : public cutil::PluginFactory
+	{
+		public:
+			virtual int getPluginCount() const
+			{
+				return(getTestPluginCount()) ;
+			}
+
+			virtual std::list<cutil::PluginInfo>& getAvailablePlugins(std::list<cutil::PluginInfo>& pluginList) const
+			{
+				int count = getTestPluginCount() ;
+				for(int i = 0 ; i < count ; ++i)
+				{
+					pluginList.push_back(cutil::PluginInfo(getTestPluginName(i), "test", "testplugin fixture Plugin")) ;
+				}
+
+				return(pluginList) ;
+			}
+
+			virtual cutil::Plugin* createPlugin(const std::string& name) const throw(cutil::SharedLibraryException)
+			{
+				char* end = 0 ;
+				long index = -1 ;
+				if(name.compare(0, 6, "plugin") == 0 && name.size() > 6)
+				{
+					index = std::strtol(name.c_str() + 6, &end, 10) ;
+				}
+
+				if(index < 0 || index >= getTestPluginCount() || *end != '\0')
+				{
+					throw(cutil::SharedLibraryException(std::string("Exception in TestPluginFactory::createPlugin: no such Plugin ").append(name))) ;
+				}
+
+				return(new TestPluginImpl(static_cast<int>(index))) ;
+			}
+
+			virtual void destroyPlugin(cutil::Plugin* plugin) const throw(cutil::SharedLibraryException)
+			{
+				delete plugin ;
+			}
+	} ;
+}
+
+extern "C"
+{
+	cutil::PluginFactory* getPluginFactory()
+	{
+		return(new TestPluginFactory()) ;
+	}
+
+	void releasePluginFactory(cutil::PluginFactory* factory)
+	{
+		delete factory ;
+	}
+
+	// plain entry points, bound through a SymbolTable by the SharedLibrary tests
+	int testPluginAdd(int a, int b)
+	{
+		return(a + b) ;
+	}
+
+	int testPluginCount()
+	{
+		return(getTestPluginCount()) ;
+	}
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#ifndef _CUTIL_UNITTESTS_TESTPLUGIN_H_
+#define _CUTIL_UNITTESTS_TESTPLUGIN_H_
+
+#include <cutil/Plugin.h>
+
+namespace cutil
+{
+	namespace unit_tests
+	{
+		/**
+		 * Plugin interface implemented by the testplugin fixture module.
+		 * The fixture offers CUTIL_TEST_PLUGIN_COUNT Plugins (default 16) named
+		 * "plugin0", "plugin1"..., each returning its index from getValue.
+		 */
+		class TestPlugin : public cutil::Plugin
+		{
+			public:
+				virtual int getValue() const = 0 ;
+		} ;
+	}
+}
+
+#endif /* _CUTIL_UNITTESTS_TESTPLUGIN_H_ */
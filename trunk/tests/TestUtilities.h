@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#ifndef _CUTIL_UNITTESTS_TESTUTILITIES_H_
+#define _CUTIL_UNITTESTS_TESTUTILITIES_H_
+
+#include <cutil/Exception.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace cutil
+{
+	namespace unit_tests
+	{
+		/**
+		 * Returns an unused path below /tmp, starting with the specified prefix,
+		 * for a file or FIFO created by the caller
+		 *
+		 * @param prefix the prefix of the file name
+		 * @return the unused path
+		 * @throw Exception if the path cannot be reserved
+		 */
+		inline std::string tempPath(const std::string& prefix) throw(Exception)
+		{
+			std::string name = std::string("/tmp/").append(prefix).append("XXXXXX") ;
+			int fd = ::mkstemp(&name[0]) ;
+			if(fd < 0)
+			{
+				throw(Exception(std::string("Exception in tempPath [mkstemp]:").append(::strerror(errno)))) ;
+			}
+			::close(fd) ;
+			::unlink(name.c_str()) ;
+
+			return(name) ;
+		}
+
+		/**
+		 * Temporary directory below /tmp, removed with its contents on destruction
+		 */
+		class TempDirectory
+		{
+			public:
+				/**
+				 * Creates a new directory, named with the specified prefix
+				 *
+				 * @param prefix the prefix of the directory name
+				 * @throw Exception if the directory cannot be created
+				 */
+				TempDirectory(const std::string& prefix) throw(Exception)
+				{
+					std::string name = std::string("/tmp/").append(prefix).append("XXXXXX") ;
+					if(::mkdtemp(&name[0]) == NULL)
+					{
+						throw(Exception(std::string("Exception in TempDirectory [mkdtemp]:").append(::strerror(errno)))) ;
+					}
+					thePath = name ;
+				}
+
+				~TempDirectory()
+				{
+					// entries made read only by a test are made writable, so they can be removed
+					std::string command("chmod -R u+w ") ;
+					command.append(thePath).append(" ; rm -rf ").append(thePath) ;
+					if(::system(command.c_str()) != 0)
+					{
+						// nothing to do, the directory is left behind
+					}
+				}
+
+				const std::string& getPath() const
+				{
+					return(thePath) ;
+				}
+
+				std::string getPath(const std::string& name) const
+				{
+					return(std::string(thePath).append("/").append(name)) ;
+				}
+
+				/**
+				 * Returns the number of entries within the directory
+				 */
+				int getEntryCount() const
+				{
+					int count = 0 ;
+					DIR* dir = ::opendir(thePath.c_str()) ;
+					for(struct dirent* entry = dir ? ::readdir(dir) : 0 ; entry != 0 ; entry = ::readdir(dir))
+					{
+						if(std::string(entry->d_name) != "." && std::string(entry->d_name) != "..")
+						{
+							count++ ;
+						}
+					}
+					if(dir)
+					{
+						::closedir(dir) ;
+					}
+					return(count) ;
+				}
+
+			private:
+				/**
+				 * Dis-allow copy constructor, the copy would remove the directory
+				 */
+				TempDirectory(const TempDirectory&) ;
+
+				std::string thePath ;
+		} ;
+
+		/**
+		 * Temporary file below /tmp, removed on destruction
+		 */
+		class TempFile
+		{
+			public:
+				/**
+				 * Creates a new file, named with the specified prefix, holding the specified contents
+				 *
+				 * @param prefix the prefix of the file name
+				 * @param contents the initial contents of the file
+				 * @throw Exception if the file cannot be created or written
+				 */
+				TempFile(const std::string& prefix, const std::string& contents = "") throw(Exception)
+				{
+					std::string name = std::string("/tmp/").append(prefix).append("XXXXXX") ;
+					int fd = ::mkstemp(&name[0]) ;
+					if(fd < 0)
+					{
+						throw(Exception(std::string("Exception in TempFile [mkstemp]:").append(::strerror(errno)))) ;
+					}
+					thePath = name ;
+
+					if(!contents.empty() && (::write(fd, contents.data(), contents.size()) != static_cast<ssize_t>(contents.size())))
+					{
+						::close(fd) ;
+						::unlink(thePath.c_str()) ;
+						throw(Exception("Exception in TempFile [write]:Cannot write temporary file")) ;
+					}
+					::close(fd) ;
+				}
+
+				~TempFile()
+				{
+					::unlink(thePath.c_str()) ;
+				}
+
+				const std::string& getPath() const
+				{
+					return(thePath) ;
+				}
+
+				/**
+				 * Reads the file through the page cache, rather than any mapping of it
+				 */
+				std::string read(size_t offset, size_t length) const
+				{
+					std::string contents(length, '\0') ;
+					int fd = ::open(thePath.c_str(), O_RDONLY) ;
+					ssize_t count = (fd >= 0) ? ::pread(fd, &contents[0], length, offset) : -1 ;
+					if(fd >= 0)
+					{
+						::close(fd) ;
+					}
+					contents.resize((count > 0) ? count : 0) ;
+					return(contents) ;
+				}
+
+				off_t getSize() const
+				{
+					struct stat st ;
+					return((::stat(thePath.c_str(), &st) == 0) ? st.st_size : -1) ;
+				}
+
+				blkcnt_t getBlocks() const
+				{
+					struct stat st ;
+					return((::stat(thePath.c_str(), &st) == 0) ? st.st_blocks : -1) ;
+				}
+
+			private:
+				/**
+				 * Dis-allow copy constructor, the copy would remove the file
+				 */
+				TempFile(const TempFile&) ;
+
+				std::string thePath ;
+		} ;
+	}
+}
+
+#endif /* _CUTIL_UNITTESTS_TESTUTILITIES_H_ */
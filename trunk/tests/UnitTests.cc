@@ -21,9 +21,31 @@
  */
 
 #include "RefCountPtrTest.h"
+#include "CompactPathTest.h"
 #include "EnumTest.h"
 #include "MapIteratorTest.h"
+#include "MemoryStateHandlerTest.h"
 #include "NullableTest.h"
+#include "PluginStatisticsTest.h"
+#include "SharedLibraryTest.h"
+#include "SnapshotStateHandlerTest.h"
+#include "SymbolTableTest.h"
+#include "NamedPipeTest.h"
+#include "FileStreamTest.h"
+#include "MappedFileTest.h"
+#include "AsyncFileIOTest.h"
+#include "DirectoryWalkerTest.h"
+#include "FilePathTest.h"
+#include "FileStatusTest.h"
+#include "DirectoryWatcherTest.h"
+#include "FileTreeTest.h"
+#include "PluginManagerTest.h"
+#include "PluginManifestTest.h"
+
+#ifdef XMLPP_SUPPORT
+#include "XMLStateHandlerTest.h"
+#include "XMLStreamStateHandlerTest.h"
+#endif
 
 #include <cutil/AbstractTestReporter.h>
 #include <cutil/AbstractUnitTest.h>
@@ -41,6 +63,28 @@ int main(int argc, char* argv[])
 	cutil::unit_tests::EnumTest enum_test ;
 	cutil::unit_tests::MapIteratorTest map_iterator_test ;
 	cutil::unit_tests::NullableTest nullable_test ;
+	cutil::unit_tests::CompactPathTest compact_path_test ;
+	cutil::unit_tests::MemoryStateHandlerTest memory_state_handler_test ;
+	cutil::unit_tests::PluginStatisticsTest plugin_statistics_test ;
+	cutil::unit_tests::SharedLibraryTest shared_library_test ;
+	cutil::unit_tests::SnapshotStateHandlerTest snapshot_state_handler_test ;
+	cutil::unit_tests::SymbolTableTest symbol_table_test ;
+	cutil::unit_tests::NamedPipeTest named_pipe_test ;
+	cutil::unit_tests::FileStreamTest file_stream_test ;
+	cutil::unit_tests::MappedFileTest mapped_file_test ;
+	cutil::unit_tests::AsyncFileIOTest async_file_io_test ;
+	cutil::unit_tests::DirectoryWalkerTest directory_walker_test ;
+	cutil::unit_tests::FilePathTest file_path_test ;
+	cutil::unit_tests::FileStatusTest file_status_test ;
+	cutil::unit_tests::DirectoryWatcherTest directory_watcher_test ;
+	cutil::unit_tests::FileTreeTest file_tree_test ;
+	cutil::unit_tests::PluginManagerTest plugin_manager_test ;
+	cutil::unit_tests::PluginManifestTest plugin_manifest_test ;
+
+#ifdef XMLPP_SUPPORT
+	cutil::unit_tests::XMLStateHandlerTest xml_state_handler_test ;
+	cutil::unit_tests::XMLStreamStateHandlerTest xml_stream_state_handler_test ;
+#endif
 
 	cutil::TestDriver driver ;
 	std::auto_ptr<cutil::AbstractTestReporter> reporter(new cutil::ConsoleReporter()) ;
@@ -0,0 +1,431 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "XMLStateHandlerTest.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/Exception.h>
+#include <cutil/RefCountPtr.h>
+#include <cutil/StateNode.h>
+#include <cutil/XMLStateHandler.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <list>
+#include <sstream>
+#include <string>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+namespace
+{
+	/**
+	 * Writes a data file of the specified root values and window child values
+	 */
+	void writeData(const std::string& path, int count, int width)
+	{
+		std::ofstream out(path.c_str()) ;
+		out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			<< "<" << cutil::XMLStateHandler::ROOT_NODE << ">\n"
+			<< "  <config_param name=\"count\" value=\"" << count << "\"/>\n"
+			<< "  <config_param name=\"name\" value=\"source\"/>\n"
+			<< "  <config_node config_id=\"window\">\n"
+			<< "    <config_param name=\"width\" value=\"" << width << "\"/>\n"
+			<< "  </config_node>\n"
+			<< "</" << cutil::XMLStateHandler::ROOT_NODE << ">\n" ;
+	}
+
+	/**
+	 * Returns the inode of the specified file, 0 if it does not exist
+	 */
+	ino_t getInode(const std::string& path)
+	{
+		struct stat st ;
+		return((::stat(path.c_str(), &st) == 0) ? st.st_ino : 0) ;
+	}
+
+	/**
+	 * Returns true if the specified list contains the specified string
+	 */
+	bool contains(const std::list<std::string>& strings, const std::string& s)
+	{
+		for(std::list<std::string>::const_iterator citer = strings.begin(); citer != strings.end(); ++citer)
+		{
+			if(*citer == s)
+			{
+				return(true) ;
+			}
+		}
+
+		return(false) ;
+	}
+
+	/**
+	 * Reads, or modifies, a StateNode until the iterations complete
+	 */
+	struct NodeAccess
+	{
+		cutil::XMLStateHandler* theHandler ;
+		int theIndex ;
+		int theIterations ;
+		int theMismatches ;
+	} ;
+
+	void* accessNode(void* arg)
+	{
+		NodeAccess* access = static_cast<NodeAccess*>(arg) ;
+		cutil::RefCountPtr<cutil::StateNode> root = access->theHandler->getRootNode() ;
+
+		std::ostringstream name ;
+		name << "value" << access->theIndex ;
+
+		for(int i = 0 ; i < access->theIterations ; ++i)
+		{
+			if(access->theIndex == 0)
+			{
+				// the writer modifies its own value, readers theirs are unchanged
+				root->setInt(name.str(), i) ;
+			}
+			else if(root->getInt(name.str(), -1) != access->theIndex)
+			{
+				access->theMismatches++ ;
+			}
+		}
+		return(NULL) ;
+	}
+}
+
+XMLStateHandlerTest::XMLStateHandlerTest() : cutil::AbstractUnitTest("XMLStateHandler Test", "cutil")
+{
+}
+
+void
+XMLStateHandlerTest::valuesAreCached()
+{
+	TempDirectory dir("XMLStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+
+	for(int cached = 0 ; cached < 2 ; ++cached)
+	{
+		writeData(path, 42, 640) ;
+
+		cutil::XMLStateHandler handler(path) ;
+		handler.setCaching(cached == 1) ;
+		handler.initialize() ;
+		cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+		cutil::Assert::areEqual(42, root->getInt("count", 0)) ;
+		cutil::Assert::areEqual(42, root->getInt("count", 0)) ;
+		cutil::Assert::areEqual(std::string("42"), root->getString("count", "")) ;
+		cutil::Assert::areEqual(-1, root->getInt("missing", -1)) ;
+		cutil::Assert::areEqual(640, root->getChild("window")->getInt("width", 0)) ;
+
+		// a set value replaces each parsed type
+		root->setString("count", "7") ;
+		cutil::Assert::areEqual(7, root->getInt("count", 0)) ;
+		cutil::Assert::isTrue(root->getDouble("count", 0.0) == 7.0) ;
+		root->setBool("missing", true) ;
+		cutil::Assert::isTrue(root->getBool("missing", false)) ;
+
+		root->removeValue("count") ;
+		cutil::Assert::areEqual(-1, root->getInt("count", -1)) ;
+	}
+}
+
+void
+XMLStateHandlerTest::removeChildDiscardsCache()
+{
+	TempDirectory dir("XMLStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+	writeData(path, 42, 640) ;
+
+	cutil::XMLStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+	cutil::Assert::areEqual(640, root->getChild("window")->getInt("width", 0)) ;
+
+	// a child created in place of the removed child does not see its cached values
+	root->removeChild("window") ;
+	cutil::Assert::isFalse(root->hasChild("window")) ;
+	for(int i = 0 ; i < 16 ; ++i)
+	{
+		std::ostringstream name ;
+		name << "child" << i ;
+		cutil::Assert::areEqual(-1, root->getChild(name.str())->getInt("width", -1)) ;
+	}
+	cutil::Assert::areEqual(-1, root->getChild("window")->getInt("width", -1)) ;
+	cutil::Assert::areEqual(42, root->getInt("count", 0)) ;
+}
+
+void
+XMLStateHandlerTest::syncDiscardsCache()
+{
+	TempDirectory dir("XMLStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+	writeData(path, 42, 640) ;
+
+	cutil::XMLStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::Assert::areEqual(42, handler.getRootNode()->getInt("count", 0)) ;
+	cutil::Assert::areEqual(640, handler.getRootNode()->getChild("window")->getInt("width", 0)) ;
+
+	// another writer replaces the data file, unwritten modifications are discarded
+	handler.getRootNode()->setInt("count", 1) ;
+	writeData(path, 43, 800) ;
+	handler.sync() ;
+
+	cutil::Assert::isFalse(handler.isDirty()) ;
+	cutil::Assert::areEqual(43, handler.getRootNode()->getInt("count", 0)) ;
+	cutil::Assert::areEqual(800, handler.getRootNode()->getChild("window")->getInt("width", 0)) ;
+
+	// a data file which no longer parses leaves the defaults
+	std::ofstream(path.c_str()) << "<truncated" ;
+	handler.sync() ;
+	cutil::Assert::areEqual(-1, handler.getRootNode()->getInt("count", -1)) ;
+}
+
+void
+XMLStateHandlerTest::concurrentReadsAreCached()
+{
+	TempDirectory dir("XMLStateHandlerTest") ;
+	cutil::XMLStateHandler handler(dir.getPath("state.xml")) ;
+	handler.initialize() ;
+
+	const int THREADS = 6 ;
+	for(int i = 1 ; i < THREADS ; ++i)
+	{
+		std::ostringstream name ;
+		name << "value" << i ;
+		handler.getRootNode()->setInt(name.str(), i) ;
+	}
+
+	// each reader first fills the shared cache, racing the writer and the other readers
+	pthread_t threads[THREADS] ;
+	NodeAccess access[THREADS] ;
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		access[i].theHandler = &handler ;
+		access[i].theIndex = i ;
+		access[i].theIterations = 20000 ;
+		access[i].theMismatches = 0 ;
+		::pthread_create(&threads[i], NULL, accessNode, &access[i]) ;
+	}
+	for(int i = 0 ; i < THREADS ; ++i)
+	{
+		::pthread_join(threads[i], NULL) ;
+	}
+
+	for(int i = 1 ; i < THREADS ; ++i)
+	{
+		cutil::Assert::areEqual(0, access[i].theMismatches) ;
+	}
+	cutil::Assert::areEqual(19999, handler.getRootNode()->getInt("value0", -1)) ;
+}
+
+void
+XMLStateHandlerTest::unmodifiedStateIsNotWritten()
+{
+	TempDirectory dir("XMLStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+	writeData(path, 42, 640) ;
+	ino_t written = getInode(path) ;
+
+	cutil::XMLStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+	root->getChild("window")->getInt("width", 0) ;
+
+	handler.flush() ;
+	cutil::Assert::isTrue(written == getInode(path)) ;
+
+	// setting a value unchanged, or removing what is not there, is no modification
+	root->setInt("count", 42) ;
+	root->removeValue("missing") ;
+	root->removeChild("missing") ;
+	cutil::Assert::isFalse(handler.isDirty()) ;
+	handler.flush() ;
+	cutil::Assert::isTrue(written == getInode(path)) ;
+
+	root->setInt("count", 43) ;
+	cutil::Assert::isTrue(handler.isDirty()) ;
+	handler.flush() ;
+	cutil::Assert::isFalse(handler.isDirty()) ;
+	cutil::Assert::isTrue(written != getInode(path)) ;
+
+	// nothing further to write
+	written = getInode(path) ;
+	handler.flush() ;
+	cutil::Assert::isTrue(written == getInode(path)) ;
+}
+
+void
+XMLStateHandlerTest::dirtyNodesAreTracked()
+{
+	TempDirectory dir("XMLStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+	writeData(path, 42, 640) ;
+
+	cutil::XMLStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+
+	std::list<std::string> paths ;
+	cutil::Assert::areEqual(0, handler.getDirtyNodes(paths)) ;
+
+	root->getChild("window")->setInt("width", 800) ;
+	root->setString("name", "modified") ;
+	cutil::Assert::areEqual(2, handler.getDirtyNodes(paths)) ;
+	cutil::Assert::isTrue(contains(paths, "/")) ;
+	cutil::Assert::isTrue(contains(paths, "/window")) ;
+
+	handler.flush() ;
+	paths.clear() ;
+	cutil::Assert::areEqual(0, handler.getDirtyNodes(paths)) ;
+
+	// the written document is read back
+	cutil::XMLStateHandler reader(path) ;
+	reader.initialize() ;
+	cutil::Assert::areEqual(800, reader.getRootNode()->getChild("window")->getInt("width", 0)) ;
+	cutil::Assert::areEqual(std::string("modified"), reader.getRootNode()->getString("name", "")) ;
+	cutil::Assert::areEqual(42, reader.getRootNode()->getInt("count", 0)) ;
+}
+
+void
+XMLStateHandlerTest::flushReplacesAtomically()
+{
+	TempDirectory dir("XMLStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+	writeData(path, 42, 640) ;
+	::chmod(path.c_str(), 0640) ;
+
+	cutil::XMLStateHandler handler(path) ;
+	handler.initialize() ;
+	handler.getRootNode()->setInt("count", 43) ;
+	handler.flush() ;
+
+	// the file is replaced, retaining its permissions, and no temporary file remains
+	struct stat st ;
+	cutil::Assert::areEqual(0, ::stat(path.c_str(), &st)) ;
+	cutil::Assert::areEqual(0640, static_cast<int>(st.st_mode & 07777)) ;
+	cutil::Assert::areEqual(1, dir.getEntryCount()) ;
+
+	cutil::XMLStateHandler reader(path) ;
+	reader.initialize() ;
+	cutil::Assert::areEqual(43, reader.getRootNode()->getInt("count", 0)) ;
+}
+
+void
+XMLStateHandlerTest::failedFlushRemainsDirty()
+{
+	TempDirectory dir("XMLStateHandlerTest") ;
+	std::string path = dir.getPath("missing/state.xml") ;
+
+	cutil::XMLStateHandler handler(path) ;
+	handler.initialize() ;
+	handler.getRootNode()->setInt("count", 1) ;
+
+	bool thrown = false ;
+	try
+	{
+		handler.flush() ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown) ;
+	cutil::Assert::isTrue(handler.isDirty()) ;
+
+	// the modifications are written once the file can be
+	::mkdir(dir.getPath("missing").c_str(), 0755) ;
+	handler.flush() ;
+	cutil::Assert::isFalse(handler.isDirty()) ;
+
+	cutil::XMLStateHandler reader(path) ;
+	reader.initialize() ;
+	cutil::Assert::areEqual(1, reader.getRootNode()->getInt("count", 0)) ;
+}
+
+void
+XMLStateHandlerTest::backgroundFlushCoalesces()
+{
+	TempDirectory dir("XMLStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+
+	cutil::XMLStateHandler handler(path) ;
+	handler.initialize() ;
+	handler.setFlushDelay(100) ;
+	cutil::Assert::isTrue(handler.getFlushDelay() == 100) ;
+
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+	root->setInt("first", 1) ;
+	root->setInt("second", 2) ;
+	root->getChild("window")->setInt("width", 640) ;
+	cutil::Assert::isTrue(handler.isDirty()) ;
+
+	// the modifications made within the delay are written together
+	for(int i = 0 ; (i < 300) && (getInode(path) == 0) ; ++i)
+	{
+		::usleep(10000) ;
+	}
+
+	cutil::XMLStateHandler reader(path) ;
+	reader.initialize() ;
+	cutil::Assert::areEqual(1, reader.getRootNode()->getInt("first", 0)) ;
+	cutil::Assert::areEqual(2, reader.getRootNode()->getInt("second", 0)) ;
+	cutil::Assert::areEqual(640, reader.getRootNode()->getChild("window")->getInt("width", 0)) ;
+
+	// disabling the background flush leaves further modifications to flush
+	handler.setFlushDelay(0) ;
+	root->setInt("third", 3) ;
+	::usleep(200000) ;
+	cutil::Assert::isTrue(handler.isDirty()) ;
+	handler.flush() ;
+	cutil::Assert::isFalse(handler.isDirty()) ;
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+XMLStateHandlerTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<XMLStateHandlerTest>(this, &XMLStateHandlerTest::valuesAreCached, "valuesAreCached", "", ""));
+	test_cases.push_back(makeTestCase<XMLStateHandlerTest>(this, &XMLStateHandlerTest::removeChildDiscardsCache, "removeChildDiscardsCache", "", ""));
+	test_cases.push_back(makeTestCase<XMLStateHandlerTest>(this, &XMLStateHandlerTest::syncDiscardsCache, "syncDiscardsCache", "", ""));
+	test_cases.push_back(makeTestCase<XMLStateHandlerTest>(this, &XMLStateHandlerTest::concurrentReadsAreCached, "concurrentReadsAreCached", "", ""));
+	test_cases.push_back(makeTestCase<XMLStateHandlerTest>(this, &XMLStateHandlerTest::unmodifiedStateIsNotWritten, "unmodifiedStateIsNotWritten", "", ""));
+	test_cases.push_back(makeTestCase<XMLStateHandlerTest>(this, &XMLStateHandlerTest::dirtyNodesAreTracked, "dirtyNodesAreTracked", "", ""));
+	test_cases.push_back(makeTestCase<XMLStateHandlerTest>(this, &XMLStateHandlerTest::flushReplacesAtomically, "flushReplacesAtomically", "", ""));
+	test_cases.push_back(makeTestCase<XMLStateHandlerTest>(this, &XMLStateHandlerTest::failedFlushRemainsDirty, "failedFlushRemainsDirty", "", ""));
+	test_cases.push_back(makeTestCase<XMLStateHandlerTest>(this, &XMLStateHandlerTest::backgroundFlushCoalesces, "backgroundFlushCoalesces", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
@@ -0,0 +1,377 @@
+/*
+ * Copyright (C) 2026  Colin Law
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * @author Colin Law [claw@mail.berlios.de]
+ *
+ * $Id$
+ */
+
+#include "XMLStreamStateHandlerTest.h"
+#include "TestUtilities.h"
+
+#include <cutil/AbstractUnitTest.h>
+#include <cutil/Assert.h>
+#include <cutil/Exception.h>
+#include <cutil/MemoryStateHandler.h>
+#include <cutil/RefCountPtr.h>
+#include <cutil/StateNode.h>
+#include <cutil/XMLStateHandler.h>
+#include <cutil/XMLStreamStateHandler.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <list>
+#include <sstream>
+#include <string>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace cutil::unit_tests ;
+
+namespace
+{
+	/**
+	 * Writes the specified content to the specified file
+	 */
+	void writeFile(const std::string& path, const std::string& content)
+	{
+		std::ofstream out(path.c_str()) ;
+		out << content ;
+	}
+
+	/**
+	 * Returns the content of the specified file
+	 */
+	std::string readFile(const std::string& path)
+	{
+		std::ifstream in(path.c_str()) ;
+		std::ostringstream buf ;
+		buf << in.rdbuf() ;
+		return(buf.str()) ;
+	}
+
+	/**
+	 * Returns a data file of the specified root element, holding root values and
+	 * nested window and frame child values
+	 */
+	std::string makeData(const std::string& root)
+	{
+		std::ostringstream buf ;
+		buf << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			<< "<" << root << ">\n"
+			<< "  <config_param name=\"count\" value=\"42\"/>\n"
+			<< "  <config_param name=\"name\" value=\"a &amp; b\"/>\n"
+			<< "  <config_node config_id=\"window\">\n"
+			<< "    <config_param name=\"width\" value=\"640\"/>\n"
+			<< "    <config_node config_id=\"frame\">\n"
+			<< "      <config_param name=\"visible\" value=\"true\"/>\n"
+			<< "    </config_node>\n"
+			<< "  </config_node>\n"
+			<< "</" << root << ">\n" ;
+		return(buf.str()) ;
+	}
+
+	/**
+	 * Returns the number of values and children of the specified StateNode
+	 */
+	int getEntryCount(cutil::StateNode& node)
+	{
+		std::list<std::string> names ;
+		std::list<std::string> children ;
+		return(node.getValueNames(names) + node.getChildren(children)) ;
+	}
+}
+
+XMLStreamStateHandlerTest::XMLStreamStateHandlerTest() : cutil::AbstractUnitTest("XMLStreamStateHandler Test", "cutil")
+{
+}
+
+std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> >
+XMLStreamStateHandlerTest::getTestCases()
+{
+	std::vector<cutil::RefCountPtr<const cutil::AbstractTestCase> > test_cases ;
+
+	test_cases.push_back(makeTestCase<XMLStreamStateHandlerTest>(this, &XMLStreamStateHandlerTest::loadParsesState, "loadParsesState", "", ""));
+	test_cases.push_back(makeTestCase<XMLStreamStateHandlerTest>(this, &XMLStreamStateHandlerTest::loadIgnoresUnknownElements, "loadIgnoresUnknownElements", "", ""));
+	test_cases.push_back(makeTestCase<XMLStreamStateHandlerTest>(this, &XMLStreamStateHandlerTest::wrongRootLoadsEmpty, "wrongRootLoadsEmpty", "", ""));
+	test_cases.push_back(makeTestCase<XMLStreamStateHandlerTest>(this, &XMLStreamStateHandlerTest::malformedFileLoadsEmpty, "malformedFileLoadsEmpty", "", ""));
+	test_cases.push_back(makeTestCase<XMLStreamStateHandlerTest>(this, &XMLStreamStateHandlerTest::writeStateRoundTrips, "writeStateRoundTrips", "", ""));
+	test_cases.push_back(makeTestCase<XMLStreamStateHandlerTest>(this, &XMLStreamStateHandlerTest::writeStateEscapesValues, "writeStateEscapesValues", "", ""));
+	test_cases.push_back(makeTestCase<XMLStreamStateHandlerTest>(this, &XMLStreamStateHandlerTest::writeStateReplacesAtomically, "writeStateReplacesAtomically", "", ""));
+	test_cases.push_back(makeTestCase<XMLStreamStateHandlerTest>(this, &XMLStreamStateHandlerTest::flushWritesModifications, "flushWritesModifications", "", ""));
+
+	// copy on return
+	return(test_cases) ;
+}
+
+void
+XMLStreamStateHandlerTest::loadParsesState()
+{
+	TempDirectory dir("XMLStreamStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+	writeFile(path, makeData(cutil::XMLStateHandler::ROOT_NODE)) ;
+
+	cutil::XMLStreamStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::Assert::isFalse(handler.isDirty()) ;
+
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+	cutil::Assert::areEqual(42, root->getInt("count", 0)) ;
+	cutil::Assert::areEqual(std::string("a & b"), root->getString("name", "")) ;
+	cutil::Assert::areEqual(3, getEntryCount(*root.getPtr())) ;
+
+	cutil::RefCountPtr<cutil::StateNode> window = root->getChild("window") ;
+	cutil::Assert::areEqual(640, window->getInt("width", 0)) ;
+	cutil::Assert::isTrue(window->getChild("frame")->getBool("visible", false)) ;
+
+	// a custom root element name
+	writeFile(path, makeData("custom_root")) ;
+	cutil::XMLStreamStateHandler custom(path, "custom_root") ;
+	custom.initialize() ;
+	cutil::Assert::areEqual(42, custom.getRootNode()->getInt("count", 0)) ;
+}
+
+void
+XMLStreamStateHandlerTest::loadIgnoresUnknownElements()
+{
+	TempDirectory dir("XMLStreamStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+
+	std::ostringstream buf ;
+	buf << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		<< "<" << cutil::XMLStateHandler::ROOT_NODE << ">\n"
+		<< "  <config_param name=\"count\" value=\"1\"/>\n"
+		<< "  <config_param name=\"novalue\"/>\n"
+		<< "  <config_param value=\"noname\"/>\n"
+		<< "  <config_node>\n"
+		<< "    <config_param name=\"noid\" value=\"1\"/>\n"
+		<< "  </config_node>\n"
+		<< "  <unknown>\n"
+		<< "    <config_node config_id=\"hidden\">\n"
+		<< "      <config_param name=\"hidden\" value=\"1\"/>\n"
+		<< "    </config_node>\n"
+		<< "  </unknown>\n"
+		<< "  <config_node config_id=\"window\">\n"
+		<< "    <config_param name=\"width\" value=\"640\"/>\n"
+		<< "  </config_node>\n"
+		<< "</" << cutil::XMLStateHandler::ROOT_NODE << ">\n" ;
+	writeFile(path, buf.str()) ;
+
+	cutil::XMLStreamStateHandler handler(path) ;
+	handler.initialize() ;
+
+	// only the complete config_param and the identified config_node are loaded
+	cutil::RefCountPtr<cutil::StateNode> root = handler.getRootNode() ;
+	cutil::Assert::areEqual(2, getEntryCount(*root.getPtr())) ;
+	cutil::Assert::areEqual(1, root->getInt("count", 0)) ;
+	cutil::Assert::isFalse(root->hasChild("hidden")) ;
+	cutil::Assert::areEqual(640, root->getChild("window")->getInt("width", 0)) ;
+	cutil::Assert::areEqual(1, getEntryCount(*root->getChild("window").getPtr())) ;
+}
+
+void
+XMLStreamStateHandlerTest::wrongRootLoadsEmpty()
+{
+	TempDirectory dir("XMLStreamStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+	writeFile(path, makeData("other_root")) ;
+
+	cutil::XMLStreamStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::Assert::areEqual(0, getEntryCount(*handler.getRootNode().getPtr())) ;
+	cutil::Assert::isFalse(handler.isDirty()) ;
+
+	// a missing file also loads an empty state tree
+	cutil::XMLStreamStateHandler missing(dir.getPath("missing.xml")) ;
+	missing.initialize() ;
+	cutil::Assert::areEqual(0, getEntryCount(*missing.getRootNode().getPtr())) ;
+}
+
+void
+XMLStreamStateHandlerTest::malformedFileLoadsEmpty()
+{
+	TempDirectory dir("XMLStreamStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+
+	// values parsed before the error are discarded
+	std::string data = makeData(cutil::XMLStateHandler::ROOT_NODE) ;
+	writeFile(path, data.substr(0, data.find("<config_node config_id=\"frame\"")).append("<config_param name=")) ;
+
+	cutil::XMLStreamStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::Assert::areEqual(0, getEntryCount(*handler.getRootNode().getPtr())) ;
+	cutil::Assert::isFalse(handler.isDirty()) ;
+
+	// the file is left in place, and replaced once modified
+	cutil::Assert::areEqual(data.substr(0, data.find("<config_node config_id=\"frame\"")).append("<config_param name="), readFile(path)) ;
+	handler.getRootNode()->setInt("count", 1) ;
+	handler.flush() ;
+
+	cutil::XMLStreamStateHandler reader(path) ;
+	reader.initialize() ;
+	cutil::Assert::areEqual(1, reader.getRootNode()->getInt("count", 0)) ;
+}
+
+void
+XMLStreamStateHandlerTest::writeStateRoundTrips()
+{
+	TempDirectory dir("XMLStreamStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+
+	cutil::MemoryStateHandler source ;
+	source.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> root = source.getRootNode() ;
+	root->setInt("count", 42) ;
+	root->setDouble("ratio", 0.5) ;
+	root->setBool("enabled", true) ;
+	root->getChild("window")->setInt("width", 640) ;
+	root->getChild("window")->getChild("frame")->setString("title", "main") ;
+	root->getChild("empty") ;
+
+	cutil::XMLStreamStateHandler::writeState(source, path) ;
+
+	cutil::XMLStreamStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> loaded = handler.getRootNode() ;
+	cutil::Assert::areEqual(5, getEntryCount(*loaded.getPtr())) ;
+	cutil::Assert::areEqual(42, loaded->getInt("count", 0)) ;
+	cutil::Assert::isTrue(loaded->getDouble("ratio", 0.0) == 0.5) ;
+	cutil::Assert::isTrue(loaded->getBool("enabled", false)) ;
+	cutil::Assert::areEqual(640, loaded->getChild("window")->getInt("width", 0)) ;
+	cutil::Assert::areEqual(std::string("main"), loaded->getChild("window")->getChild("frame")->getString("title", "")) ;
+	cutil::Assert::isTrue(loaded->hasChild("empty")) ;
+
+	// the XMLStateHandler reads the same file format
+	cutil::XMLStateHandler dom(path) ;
+	dom.initialize() ;
+	cutil::Assert::areEqual(42, dom.getRootNode()->getInt("count", 0)) ;
+	cutil::Assert::areEqual(std::string("main"), dom.getRootNode()->getChild("window")->getChild("frame")->getString("title", "")) ;
+
+	// with a custom root element name
+	cutil::XMLStreamStateHandler::writeState(source, path, "custom_root") ;
+	cutil::XMLStreamStateHandler custom(path, "custom_root") ;
+	custom.initialize() ;
+	cutil::Assert::areEqual(42, custom.getRootNode()->getInt("count", 0)) ;
+}
+
+void
+XMLStreamStateHandlerTest::writeStateEscapesValues()
+{
+	TempDirectory dir("XMLStreamStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+	const std::string markup("<a href=\"x\">&amp;</a>") ;
+	const std::string whitespace("line\none\ttab\rreturn") ;
+
+	cutil::MemoryStateHandler source ;
+	source.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> root = source.getRootNode() ;
+	root->setString("markup", markup) ;
+	root->setString("whitespace", whitespace) ;
+	root->setString("a<b", "name") ;
+	root->getChild("x&y")->setString("value", markup) ;
+
+	cutil::XMLStreamStateHandler::writeState(source, path) ;
+
+	std::string content = readFile(path) ;
+	cutil::Assert::isTrue(content.find("&lt;a href=&quot;x&quot;&gt;&amp;amp;&lt;/a&gt;") != std::string::npos) ;
+	cutil::Assert::isTrue(content.find("line&#10;one&#9;tab&#13;return") != std::string::npos) ;
+
+	cutil::XMLStreamStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::RefCountPtr<cutil::StateNode> loaded = handler.getRootNode() ;
+	cutil::Assert::areEqual(markup, loaded->getString("markup", "")) ;
+	cutil::Assert::areEqual(whitespace, loaded->getString("whitespace", "")) ;
+	cutil::Assert::areEqual(std::string("name"), loaded->getString("a<b", "")) ;
+	cutil::Assert::areEqual(markup, loaded->getChild("x&y")->getString("value", "")) ;
+}
+
+void
+XMLStreamStateHandlerTest::writeStateReplacesAtomically()
+{
+	TempDirectory dir("XMLStreamStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+	writeFile(path, makeData(cutil::XMLStateHandler::ROOT_NODE)) ;
+	::chmod(path.c_str(), 0640) ;
+
+	// a temporary file left by an earlier writer is neither reused nor removed
+	writeFile(dir.getPath("state.xml.tmp"), "stale") ;
+
+	cutil::MemoryStateHandler source ;
+	source.initialize() ;
+	source.getRootNode()->setInt("count", 43) ;
+	cutil::XMLStreamStateHandler::writeState(source, path) ;
+
+	struct stat st ;
+	cutil::Assert::areEqual(0, ::stat(path.c_str(), &st)) ;
+	cutil::Assert::areEqual(0640, static_cast<int>(st.st_mode & 07777)) ;
+	cutil::Assert::areEqual(2, dir.getEntryCount()) ;
+	cutil::Assert::areEqual(std::string("stale"), readFile(dir.getPath("state.xml.tmp"))) ;
+
+	// a file which cannot be written is left unchanged
+	bool thrown = false ;
+	try
+	{
+		cutil::XMLStreamStateHandler::writeState(source, dir.getPath("missing/state.xml")) ;
+	}
+	catch(cutil::Exception& e)
+	{
+		thrown = true ;
+	}
+	cutil::Assert::isTrue(thrown) ;
+	cutil::Assert::areEqual(2, dir.getEntryCount()) ;
+
+	cutil::XMLStreamStateHandler handler(path) ;
+	handler.initialize() ;
+	cutil::Assert::areEqual(43, handler.getRootNode()->getInt("count", 0)) ;
+}
+
+void
+XMLStreamStateHandlerTest::flushWritesModifications()
+{
+	TempDirectory dir("XMLStreamStateHandlerTest") ;
+	std::string path = dir.getPath("state.xml") ;
+	writeFile(path, makeData(cutil::XMLStateHandler::ROOT_NODE)) ;
+
+	cutil::XMLStreamStateHandler handler(path) ;
+	handler.initialize() ;
+
+	// an unmodified state tree is not written
+	struct stat before ;
+	::stat(path.c_str(), &before) ;
+	handler.flush() ;
+	struct stat after ;
+	::stat(path.c_str(), &after) ;
+	cutil::Assert::isTrue(before.st_ino == after.st_ino) ;
+
+	handler.getRootNode()->getChild("window")->setInt("width", 800) ;
+	cutil::Assert::isTrue(handler.isDirty()) ;
+	handler.flush() ;
+	cutil::Assert::isFalse(handler.isDirty()) ;
+
+	cutil::XMLStreamStateHandler reader(path) ;
+	reader.initialize() ;
+	cutil::Assert::areEqual(800, reader.getRootNode()->getChild("window")->getInt("width", 0)) ;
+	cutil::Assert::areEqual(42, reader.getRootNode()->getInt("count", 0)) ;
+
+	// sync discards unwritten modifications
+	handler.getRootNode()->setInt("count", 1) ;
+	handler.sync() ;
+	cutil::Assert::isFalse(handler.isDirty()) ;
+	cutil::Assert::areEqual(42, handler.getRootNode()->getInt("count", 0)) ;
+}